@@ -87,6 +87,9 @@ endif ()
 if (OGRE_BUILD_TOOLS)
 	set(_programs "${_programs}  + Tools\n")
 endif ()
+if (OGRE_BUILD_BENCHMARKS)
+	set(_programs "${_programs}  + Benchmarks\n")
+endif ()
 
 if (DEFINED _programs)
 	set(_features "${_features}Building executables:\n${_programs}")
@@ -174,6 +177,8 @@ elseif (OGRE_CONFIG_ALLOCATOR EQUAL 1)
 	set(_allocator "standard")
 elseif (OGRE_CONFIG_ALLOCATOR EQUAL 3)
 	set(_allocator "user")
+elseif (OGRE_CONFIG_ALLOCATOR EQUAL 6)
+	set(_allocator "pooled")
 else ()
     set(_allocator "debug allocator tracker")
 endif()
@@ -194,6 +199,7 @@ var_to_string(OGRE_CONFIG_MEMTRACK_RELEASE _memtrack_release)
 var_to_string(OGRE_CONFIG_STRING_USE_CUSTOM_ALLOCATOR _string)
 var_to_string(OGRE_SIMD_SSE2 _simdsse2)
 var_to_string(OGRE_SIMD_NEON _simdneon)
+var_to_string(OGRE_SIMD_AVX _simdavx)
 # threading settings
 if (OGRE_CONFIG_THREADS EQUAL 0)
 	set(_threads "none")
@@ -221,6 +227,7 @@ set(_features "${_features}Memory tracker (debug):          ${_memtrack_debug}\n
 set(_features "${_features}Memory tracker (release):        ${_memtrack_release}\n")
 set(_features "${_features}Use SIMD (SSE2):                 ${_simdsse2}\n")
 set(_features "${_features}Use SIMD (NEON):                 ${_simdneon}\n")
+set(_features "${_features}Use SIMD (AVX2):                 ${_simdavx}\n")
 
 
 set(_features "${_features}\n----------------------------------------------------------------------------\n")
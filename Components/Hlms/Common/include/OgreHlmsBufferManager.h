@@ -125,6 +125,39 @@ namespace Ogre
         /// have many skeletally animated meshes with lots of bones.
         size_t mTextureBufferDefaultSize;
 
+        /// Const and tex. buffer regions owned by one segment of a parallel fill.
+        /// @see reserveParallelFillSlices
+        struct ParallelFillSlice
+        {
+            ConstBufferPacked *constBuffer;
+            uint32            *startMappedConstBuffer;
+            uint32            *currentMappedConstBuffer;
+            /// In uint32
+            size_t constBufferSize;
+
+            ReadOnlyBufferPacked *texBuffer;
+            float                *startMappedTexBuffer;
+            float                *currentMappedTexBuffer;
+            /// In floats
+            size_t texBufferSize;
+            /// In bytes, from the start of texBuffer
+            size_t texBindOffset;
+            /// Index to mParallelFillTexRegions
+            size_t texRegionIdx;
+        };
+
+        /// Mapped region of a tex. buffer, shared by consecutive slices
+        struct ParallelFillTexRegion
+        {
+            ReadOnlyBufferPacked *texBuffer;
+            size_t                offset;
+            size_t                sizeBytes;
+            float                *mappedPtr;
+        };
+
+        FastArray<ParallelFillSlice>     mParallelFillSlices;
+        FastArray<ParallelFillTexRegion> mParallelFillTexRegions;
+
         /// For compatibility reasons with D3D11 and GLES3, Const buffers are mapped.
         /// Once we're done with it (even if we didn't fully use it) we discard it
         /// and get a new one. We will at least have to get a new one on every pass.
@@ -166,6 +199,28 @@ namespace Ogre
         void rebindTexBuffer( CommandBuffer *commandBuffer, bool resetOffset = false,
                               size_t minimumSizeBytes = 1 );
 
+        /// Returns the maximum number of draws a single slice can hold.
+        /// @see reserveParallelFillSlices
+        size_t getParallelFillMaxDrawsPerSlice( size_t texBytesPerDraw ) const;
+
+        /** Maps one const buffer and one region of the tex. buffer for each segment
+            of a parallel fill, so that each one can be written from a different thread.
+        @remarks
+            Each slice reserves 16 bytes of const buffer and texBytesPerDraw bytes
+            of tex. buffer per draw. numDrawsPerSegment[i] must not exceed
+            getParallelFillMaxDrawsPerSlice.
+            The regular const & tex. buffers are left unmapped, and they will
+            be mapped again as usual the next time they're needed.
+        */
+        void reserveParallelFillSlices( CommandBuffer *commandBuffer, const size_t *numDrawsPerSegment,
+                                        size_t numSegments, size_t texBytesPerDraw );
+
+        /// Binds the buffers of the slice to slot 2 (const) & 0 (tex). Call from the main thread.
+        void bindParallelFillSlice( size_t segmentIdx, CommandBuffer *commandBuffer );
+
+        /// Unmaps all the slices. Their buffers are not reused until the next frame.
+        void releaseParallelFillSlices();
+
         virtual void destroyAllBuffers();
 
     public:
@@ -107,6 +107,8 @@ namespace Ogre
 
         void preload() override;
 
+        void _touchTextures( uint32 frameCount, float distanceToCamera ) override;
+
         void saveTextures( const String &folderPath, set<String>::type &savedTextures, bool saveOitd,
                            bool saveOriginal, HlmsTextureExportListener *listener ) override;
 
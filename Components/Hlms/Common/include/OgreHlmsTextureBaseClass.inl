@@ -101,6 +101,15 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void OGRE_HLMS_TEXTURE_BASE_CLASS::preload() { loadAllTextures(); }
     //-----------------------------------------------------------------------------------
+    void OGRE_HLMS_TEXTURE_BASE_CLASS::_touchTextures( uint32 frameCount, float distanceToCamera )
+    {
+        for( int i = 0; i < OGRE_HLMS_TEXTURE_BASE_MAX_TEX; ++i )
+        {
+            if( mTextures[i] )
+                mTextures[i]->_touch( frameCount, distanceToCamera );
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void OGRE_HLMS_TEXTURE_BASE_CLASS::saveTextures( const String &folderPath,
                                                      set<String>::type &savedTextures, bool saveOitd,
                                                      bool saveOriginal,
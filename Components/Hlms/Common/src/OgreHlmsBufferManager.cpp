@@ -273,6 +273,170 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    size_t HlmsBufferManager::getParallelFillMaxDrawsPerSlice( size_t texBytesPerDraw ) const
+    {
+        const size_t constBufferSize = std::min<size_t>( 65536, mVaoManager->getConstBufferMaxSize() );
+        const size_t texBufferSize =
+            std::min<size_t>( mTextureBufferDefaultSize, mVaoManager->getReadOnlyBufferMaxSize() );
+        return std::min( constBufferSize / ( 4u * sizeof( uint32 ) ), texBufferSize / texBytesPerDraw );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsBufferManager::reserveParallelFillSlices( CommandBuffer *commandBuffer,
+                                                       const size_t *numDrawsPerSegment,
+                                                       size_t numSegments, size_t texBytesPerDraw )
+    {
+        unmapConstBuffer();
+        unmapTexBuffer( commandBuffer );
+        mLastTexBufferCmdOffset = std::numeric_limits<size_t>::max();
+
+        mParallelFillSlices.resizePOD( numSegments );
+        mParallelFillTexRegions.clear();
+
+        const size_t texAlignment = mVaoManager->getTexBufferAlignment();
+
+        ReadOnlyBufferPacked *texBuffer = mTexBuffers[mCurrentTexBuffer];
+        size_t texRegionStart = mTexLastOffset;
+        size_t texOffset = mTexLastOffset;
+
+        for( size_t i = 0u; i < numSegments; ++i )
+        {
+            ParallelFillSlice &slice = mParallelFillSlices[i];
+
+            // Each slice gets a whole const buffer, so that drawIds start from 0
+            if( mCurrentConstBuffer >= mConstBuffers.size() )
+            {
+                size_t bufferSize = std::min<size_t>( 65536, mVaoManager->getConstBufferMaxSize() );
+                ConstBufferPacked *newBuffer =
+                    mVaoManager->createConstBuffer( bufferSize, BT_DYNAMIC_PERSISTENT, 0, false );
+                mConstBuffers.push_back( newBuffer );
+            }
+
+            slice.constBuffer = mConstBuffers[mCurrentConstBuffer++];
+            slice.startMappedConstBuffer = reinterpret_cast<uint32 *>(
+                slice.constBuffer->map( 0, slice.constBuffer->getNumElements() ) );
+            slice.currentMappedConstBuffer = slice.startMappedConstBuffer;
+            slice.constBufferSize = slice.constBuffer->getNumElements() >> 2u;
+
+            OGRE_ASSERT_LOW( numDrawsPerSegment[i] * 4u <= slice.constBufferSize );
+
+            // Carve the tex. slices from the current tex. buffer, going to the next
+            // one when it's full (like mapNextTexBuffer does)
+            const size_t texSizeBytes = numDrawsPerSegment[i] * texBytesPerDraw;
+            texOffset = alignToNextMultiple<size_t>( texOffset, texAlignment );
+            if( texOffset + texSizeBytes > texBuffer->getTotalSizeBytes() )
+            {
+                if( texOffset > texRegionStart )
+                {
+                    ParallelFillTexRegion region = { texBuffer, texRegionStart,
+                                                     texOffset - texRegionStart, 0 };
+                    mParallelFillTexRegions.push_back( region );
+                }
+
+                ++mCurrentTexBuffer;
+
+                if( mCurrentTexBuffer >= mTexBuffers.size() )
+                {
+                    size_t bufferSize = std::min<size_t>( mTextureBufferDefaultSize,
+                                                          mVaoManager->getReadOnlyBufferMaxSize() );
+                    ReadOnlyBufferPacked *newBuffer = mVaoManager->createReadOnlyBuffer(
+                        PFG_RGBA32_FLOAT, bufferSize, BT_DYNAMIC_PERSISTENT, 0, false );
+                    mTexBuffers.push_back( newBuffer );
+                }
+
+                texBuffer = mTexBuffers[mCurrentTexBuffer];
+                texRegionStart = 0u;
+                texOffset = 0u;
+
+                OGRE_ASSERT_LOW( texSizeBytes <= texBuffer->getTotalSizeBytes() );
+            }
+
+            slice.texBuffer = texBuffer;
+            slice.texBufferSize = texSizeBytes / sizeof( float );
+            slice.texBindOffset = texOffset;
+            slice.texRegionIdx = mParallelFillTexRegions.size();
+
+            texOffset += texSizeBytes;
+        }
+
+        if( texOffset > texRegionStart )
+        {
+            ParallelFillTexRegion region = { texBuffer, texRegionStart, texOffset - texRegionStart,
+                                             0 };
+            mParallelFillTexRegions.push_back( region );
+        }
+
+        // Each tex. buffer can only be mapped once, thus map whole regions
+        FastArray<ParallelFillTexRegion>::iterator itor = mParallelFillTexRegions.begin();
+        FastArray<ParallelFillTexRegion>::iterator endt = mParallelFillTexRegions.end();
+
+        while( itor != endt )
+        {
+            itor->mappedPtr =
+                reinterpret_cast<float *>( itor->texBuffer->map( itor->offset, itor->sizeBytes, false ) );
+            ++itor;
+        }
+
+        for( size_t i = 0u; i < numSegments; ++i )
+        {
+            ParallelFillSlice &slice = mParallelFillSlices[i];
+            if( slice.texBufferSize )
+            {
+                const ParallelFillTexRegion &region = mParallelFillTexRegions[slice.texRegionIdx];
+                slice.startMappedTexBuffer =
+                    region.mappedPtr + ( slice.texBindOffset - region.offset ) / sizeof( float );
+            }
+            else
+            {
+                slice.startMappedTexBuffer = 0;
+            }
+            slice.currentMappedTexBuffer = slice.startMappedTexBuffer;
+        }
+
+        mTexLastOffset = texOffset;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsBufferManager::bindParallelFillSlice( size_t segmentIdx, CommandBuffer *commandBuffer )
+    {
+        const ParallelFillSlice &slice = mParallelFillSlices[segmentIdx];
+
+        *commandBuffer->addCommand<CbShaderBuffer>() =
+            CbShaderBuffer( VertexShader, 2, slice.constBuffer, 0, 0 );
+        *commandBuffer->addCommand<CbShaderBuffer>() =
+            CbShaderBuffer( PixelShader, 2, slice.constBuffer, 0, 0 );
+
+        // Bind the whole slice. Its size is already known, unlike in mapNextTexBuffer
+        *commandBuffer->addCommand<CbShaderBuffer>() =
+            CbShaderBuffer( VertexShader, 0, slice.texBuffer, (uint32)slice.texBindOffset,
+                            (uint32)( slice.texBufferSize * sizeof( float ) ) );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsBufferManager::releaseParallelFillSlices()
+    {
+        FastArray<ParallelFillSlice>::const_iterator itor = mParallelFillSlices.begin();
+        FastArray<ParallelFillSlice>::const_iterator endt = mParallelFillSlices.end();
+
+        while( itor != endt )
+        {
+            itor->constBuffer->unmap(
+                UO_KEEP_PERSISTENT, 0,
+                static_cast<size_t>( itor->currentMappedConstBuffer - itor->startMappedConstBuffer ) *
+                    sizeof( uint32 ) );
+            ++itor;
+        }
+
+        FastArray<ParallelFillTexRegion>::const_iterator itRegion = mParallelFillTexRegions.begin();
+        FastArray<ParallelFillTexRegion>::const_iterator enRegion = mParallelFillTexRegions.end();
+
+        while( itRegion != enRegion )
+        {
+            itRegion->texBuffer->unmap( UO_KEEP_PERSISTENT, 0, itRegion->sizeBytes );
+            ++itRegion;
+        }
+
+        mParallelFillSlices.clear();
+        mParallelFillTexRegions.clear();
+    }
+    //-----------------------------------------------------------------------------------
     void HlmsBufferManager::destroyAllBuffers()
     {
         mCurrentConstBuffer = 0;
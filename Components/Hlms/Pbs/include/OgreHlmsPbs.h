@@ -163,9 +163,9 @@ namespace Ogre
         HlmsSamplerblock const *mPlanarReflectionsSamplerblock;
         /// Whether the current active pass can use mPlanarReflections (i.e. we can't
         /// use the reflections if they were built for a different camera angle)
-        bool  mHasPlanarReflections;
-        uint8 mLastBoundPlanarReflection;
+        bool mHasPlanarReflections;
 #endif
+        uint8 mLastBoundPlanarReflection;
         TextureGpu             *mAreaLightMasks;
         HlmsSamplerblock const *mAreaLightMasksSamplerblock;
         LightArray              mAreaLights;
@@ -220,6 +220,43 @@ namespace Ogre
         uint16           mEsmK;  ///< K parameter for ESM.
         AmbientLightMode mAmbientLightMode;
 
+        /// @see setStaticInstanceCache
+        struct StaticInstanceSlot
+        {
+            Renderable *owner;  ///< Null if the slot is in mStaticInstanceFreeSlots
+            /// SceneManager::getStaticTransformsVersion() at the time the matrix was
+            /// copied to mStaticInstanceShadow and to mStaticInstanceBuffer. 0 means never.
+            uint32 capturedVersion;
+            uint32 uploadedVersion;
+        };
+
+        bool                  mStaticInstanceCache;
+        uint32                mStaticTransformsVersion;  ///< Cached at preparePassHash
+        /// Most slots mStaticInstanceBuffer may hold. Set by _changeRenderSystem
+        uint32                mStaticInstanceMaxSlots;
+        SceneManager const   *mStaticInstanceSceneManager;
+        ReadOnlyBufferPacked *mStaticInstanceBuffer;
+        /// CPU copy of mStaticInstanceBuffer. 16 floats per slot (mat4x3 + padding)
+        FastArray<float>              mStaticInstanceShadow;
+        FastArray<StaticInstanceSlot> mStaticInstanceSlots;
+        FastArray<uint32>             mStaticInstanceFreeSlots;
+        /// Range of slots [begin; end) captured but not yet uploaded
+        uint32 mStaticInstanceDirtyBegin;
+        uint32 mStaticInstanceDirtyEnd;
+
+        /// Copy of the state fillBuffersFor tracks to skip redundant binds, one per segment.
+        /// @see setParallelFill
+        struct ParallelFillSegmentState
+        {
+            ConstBufferPool::BufferPool const *lastBoundPool;
+            DescriptorSetTexture const        *lastDescTexture;
+            DescriptorSetSampler const        *lastDescSampler;
+            uint8                              lastBoundPlanarReflection;
+        };
+
+        bool                                mParallelFill;
+        FastArray<ParallelFillSegmentState> mParallelFillSegments;
+
         void setupRootLayout( RootLayout &rootLayout ) override;
 
         const HlmsCache *createShaderCacheEntry( uint32 renderableHash, const HlmsCache &passCache,
@@ -245,8 +282,50 @@ namespace Ogre
 
         static bool requiredPropertyByAlphaTest( IdString propertyName );
 
+        /** Returns the static instance slot (+1) the shader should read the world matrix of
+            the given renderable from; or 0 if the matrix must be streamed as usual this time
+            (e.g. the object is not static or its cached copy is not yet on the GPU).
+        */
+        uint32 updateStaticInstanceSlot( Renderable *renderable, const MovableObject *movableObject,
+                                         const Matrix4 &worldMat );
+        void releaseStaticInstanceSlot( Renderable *renderable );
+        /// Uploads the slots captured since the last call, growing the buffer if needed.
+        void uploadStaticInstances( SceneManager *sceneManager );
+        /// Releases all slots and the GPU buffer.
+        void destroyStaticInstanceCache();
+
         void destroyAllBuffers() override;
 
+        /// Binds the pass buffers and the pass textures after a change of Hlms type.
+        /// Returns the first texture unit left free.
+        size_t bindPassResources( bool casterPass, CommandBuffer *commandBuffer );
+
+        /** Writes the uint4 worldMaterialIdx[] entry of a draw.
+        @param worldMaterialIdx
+            Value of .x; the material slot in the lower 9 bits and, depending on the path,
+            the offset to the draw's matrices or its static instance slot in the upper ones.
+        */
+        FORCEINLINE void writeDrawConstants( uint32 *RESTRICT_ALIAS currentMappedConstBuffer,
+                                             uint32 worldMaterialIdx,
+                                             const HlmsPbsDatablock *datablock,
+                                             const QueuedRenderable &queuedRenderable ) const;
+        /// Writes mat4x3 world (padded to 16 floats) and, if requested, mat4 worldView.
+        /// Returns the pointer past the written data.
+        FORCEINLINE float *writeWorldMatrices( float *RESTRICT_ALIAS currentMappedTexBuffer,
+                                               const Matrix4 &worldMat, bool writeWorldView ) const;
+        /// Binds the material buffer of the datablock if it's not the last bound one.
+        FORCEINLINE void bindDatablockBuffers( const HlmsPbsDatablock *datablock, bool casterPass,
+                                               CommandBuffer                      *commandBuffer,
+                                               ConstBufferPool::BufferPool const *&lastBoundPool );
+        /// Binds the textures & samplers of the datablock (and the planar
+        /// reflection the renderable uses) if they're not the last bound ones.
+        FORCEINLINE void bindDatablockTextures( const HlmsPbsDatablock *datablock,
+                                                const Renderable *renderable, bool casterPass,
+                                                CommandBuffer               *commandBuffer,
+                                                DescriptorSetTexture const *&lastDescTexture,
+                                                DescriptorSetSampler const *&lastDescSampler,
+                                                uint8                       &lastBoundPlanarReflection );
+
         FORCEINLINE uint32 fillBuffersFor( const HlmsCache        *cache,
                                            const QueuedRenderable &queuedRenderable, bool casterPass,
                                            uint32 lastCacheHash, CommandBuffer *commandBuffer,
@@ -274,9 +353,28 @@ namespace Ogre
                                  bool casterPass, uint32 lastCacheHash,
                                  CommandBuffer *commandBuffer ) override;
 
+        /// Batches the non-animated path: world-view matrices are computed
+        /// ARRAY_PACKED_REALS at a time and written with streaming stores.
+        size_t fillBuffersForV2Batch( const HlmsCache *cache, const QueuedRenderable *queuedRenderables,
+                                      size_t numRenderables, bool casterPass,
+                                      uint32 *outBaseInstances ) override;
+
+        /// Only the non-animated path is recorded in parallel. @see setParallelFill
+        size_t getParallelFillMaxDraws( bool casterPass ) const override;
+        void   _beginParallelFill( CommandBuffer *commandBuffer, const size_t *numDrawsPerSegment,
+                                   size_t numSegments, bool casterPass ) override;
+        void   _beginParallelFillSegment( size_t segmentIdx, const QueuedRenderable &queuedRenderable,
+                                          bool casterPass, CommandBuffer *commandBuffer ) override;
+        uint32 fillBuffersForV2Parallel( size_t segmentIdx, const HlmsCache *cache,
+                                         const QueuedRenderable &queuedRenderable, bool casterPass,
+                                         CommandBuffer *commandBuffer ) override;
+        void   _endParallelFill( CommandBuffer *const *segmentCommandBuffers ) override;
+
         void postCommandBufferExecution( CommandBuffer *commandBuffer ) override;
         void frameEnded() override;
 
+        void _notifyRenderableUnlinked( Renderable *renderable ) override;
+
         void setStaticBranchingLights( bool staticBranchingLights ) override;
 
         /** By default we see the reflection textures' mipmaps and store the largest one we found.
@@ -345,6 +443,46 @@ namespace Ogre
         void setDebugPssmSplits( bool bDebug );
         bool getDebugPssmSplits() const { return mDebugPssmSplits; }
 
+        /** Keeps the world matrices of static objects (see MovableObject::isStatic) in a
+            persistent GPU buffer instead of streaming them every frame.
+        @remarks
+            Each static Renderable gets a slot in the buffer the first time it is drawn. From
+            then on its matrix is neither written nor uploaded again until
+            SceneManager::notifyStaticDirty is called (which invalidates every slot, static
+            objects are expected to move rarely). The vertex shader picks the cached matrix
+            through a stable per-Renderable slot index instead of the per-draw one.
+        @par
+            While enabled the per-draw worldView matrix is not sent to the GPU, for any object:
+            positions & normals go through world space and the pass' view matrix, as done for
+            skeletal animation. This saves CPU time and bandwidth, but loses a bit of precision
+            in view space when very far away from the origin.
+        @par
+            Objects with poses or skeletal animation are not cached.
+            Should be set before shaders get compiled; toggling it at runtime compiles
+            new shaders.
+        @exception
+            ERR_NOT_IMPLEMENTED when enabling it with the GLSL ES shaders, which don't
+            support it. Switching to a GLSL ES RenderSystem disables it.
+        */
+        void setStaticInstanceCache( bool bEnable );
+        bool getStaticInstanceCache() const { return mStaticInstanceCache; }
+
+        /** When enabled, the RenderQueue splits large render queues into segments and
+            fills the const & tex. buffers of each segment from a different worker thread,
+            recording one command buffer per segment. @see Hlms::getParallelFillMaxDraws
+        @remarks
+            Each segment gets its own const buffer, and thus rebinds the pass resources.
+            This costs a few commands per segment, hence it only pays off with thousands
+            of draws per render queue.
+        @par
+            Disabled by default. The listener's hlmsTypeChanged gets called once per segment
+            and must not depend on the draws that follow it.
+            Objects with poses or skeletal animation are filled on the main thread.
+            Ignored while setStaticInstanceCache is enabled.
+        */
+        void setParallelFill( bool bEnable ) { mParallelFill = bEnable; }
+        bool getParallelFill() const { return mParallelFill; }
+
         /** Toggle whether the roughness value (set via material parameters and via roughness textures)
             is perceptual or raw.
 
@@ -496,6 +634,7 @@ namespace Ogre
         static const IdString HwGammaWrite;
         static const IdString MaterialsPerBuffer;
         static const IdString LowerGpuOverhead;
+        static const IdString StaticInstanceCache;
         static const IdString DebugPssmSplits;
         static const IdString PerceptualRoughness;
         static const IdString HasPlanarReflections;
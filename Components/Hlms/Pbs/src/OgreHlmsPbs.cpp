@@ -47,6 +47,7 @@ THE SOFTWARE.
 #include "Compositor/Pass/PassScene/OgreCompositorPassSceneDef.h"
 #include "Cubemaps/OgreParallaxCorrectedCubemap.h"
 #include "IrradianceField/OgreIrradianceField.h"
+#include "Math/Array/OgreArrayMatrixAf4x3.h"
 #include "OgreAtmosphereComponent.h"
 #include "OgreCamera.h"
 #include "OgreForward3D.h"
@@ -86,6 +87,7 @@ namespace Ogre
     const IdString PbsProperty::HwGammaWrite = IdString( "hw_gamma_write" );
     const IdString PbsProperty::MaterialsPerBuffer = IdString( "materials_per_buffer" );
     const IdString PbsProperty::LowerGpuOverhead = IdString( "lower_gpu_overhead" );
+    const IdString PbsProperty::StaticInstanceCache = IdString( "static_instance_cache" );
     const IdString PbsProperty::DebugPssmSplits = IdString( "debug_pssm_splits" );
     const IdString PbsProperty::PerceptualRoughness = IdString( "perceptual_roughness" );
     const IdString PbsProperty::HasPlanarReflections = IdString( "has_planar_reflections" );
@@ -290,8 +292,8 @@ namespace Ogre
         mPlanarReflections( 0 ),
         mPlanarReflectionsSamplerblock( 0 ),
         mHasPlanarReflections( false ),
-        mLastBoundPlanarReflection( 0u ),
 #endif
+        mLastBoundPlanarReflection( 0u ),
         mAreaLightMasks( 0 ),
         mAreaLightMasksSamplerblock( 0 ),
         mUsingAreaLightMasks( false ),
@@ -325,7 +327,15 @@ namespace Ogre
         mUseLightBuffers( false ),
         mShadowFilter( PCF_3x3 ),
         mEsmK( 600u ),
-        mAmbientLightMode( AmbientAuto )
+        mAmbientLightMode( AmbientAuto ),
+        mStaticInstanceCache( false ),
+        mStaticTransformsVersion( 0u ),
+        mStaticInstanceMaxSlots( 0u ),
+        mStaticInstanceSceneManager( 0 ),
+        mStaticInstanceBuffer( 0 ),
+        mStaticInstanceDirtyBegin( std::numeric_limits<uint32>::max() ),
+        mStaticInstanceDirtyEnd( 0u ),
+        mParallelFill( false )
     {
         memset( mDecalsTextures, 0, sizeof( mDecalsTextures ) );
 
@@ -340,8 +350,24 @@ namespace Ogre
         ConstBufferPool::_changeRenderSystem( newRs );
         HlmsBufferManager::_changeRenderSystem( newRs );
 
+        mStaticInstanceMaxSlots = 0u;
+
         if( newRs )
         {
+            // The slot + 1 must fit in the 23 upper bits of worldMaterialIdx
+            const size_t bytesPerSlot = 16u * sizeof( float );
+            mStaticInstanceMaxSlots = static_cast<uint32>( std::min<size_t>(
+                mVaoManager->getReadOnlyBufferMaxSize() / bytesPerSlot, ( 1u << 23u ) - 1u ) );
+
+            if( mStaticInstanceCache && mShaderProfile == "glsles" )
+            {
+                LogManager::getSingleton().logMessage(
+                    "HlmsPbs: the static instance cache is not supported by the GLSL ES "
+                    "shaders. Disabling it.",
+                    LML_CRITICAL );
+                setStaticInstanceCache( false );
+            }
+
             if( !mSkipRequestSlotInChangeRS )
             {
                 HlmsDatablockMap::const_iterator itor = mDatablocks.begin();
@@ -479,7 +505,8 @@ namespace Ogre
         if( mSetupWorldMatBuf )
         {
             descBindingRanges[DescBindingTypes::ReadOnlyBuffer].start = 0u;
-            descBindingRanges[DescBindingTypes::ReadOnlyBuffer].end = 1u;
+            descBindingRanges[DescBindingTypes::ReadOnlyBuffer].end =
+                getProperty( PbsProperty::StaticInstanceCache ) ? 2u : 1u;
         }
         else
         {
@@ -593,7 +620,11 @@ namespace Ogre
 
         GpuProgramParametersSharedPtr vsParams = retVal->pso.vertexShader->getDefaultParameters();
         if( mSetupWorldMatBuf && mVaoManager->readOnlyIsTexBuffer() )
+        {
             vsParams->setNamedConstant( "worldMatBuf", 0 );
+            if( getProperty( passCache.setProperties, PbsProperty::StaticInstanceCache ) )
+                vsParams->setNamedConstant( "staticWorldMatBuf", 1 );
+        }
 
         mListener->shaderCacheEntryCreated( mShaderProfile, retVal, passCache, mSetProperties,
                                             queuedRenderable );
@@ -1700,6 +1731,9 @@ namespace Ogre
         if( mOptimizationStrategy == LowerGpuOverhead )
             setProperty( PbsProperty::LowerGpuOverhead, 1 );
 
+        if( mStaticInstanceCache )
+            setProperty( PbsProperty::StaticInstanceCache, 1 );
+
         HlmsCache retVal =
             Hlms::preparePassHashBase( shadowNode, casterPass, dualParaboloid, sceneManager );
 
@@ -2926,6 +2960,9 @@ namespace Ogre
 
         uploadDirtyDatablocks();
 
+        if( mStaticInstanceCache )
+            uploadStaticInstances( sceneManager );
+
         return retVal;
     }
     //-----------------------------------------------------------------------------------
@@ -2953,196 +2990,458 @@ namespace Ogre
                                false );
     }
     //-----------------------------------------------------------------------------------
-    uint32 HlmsPbs::fillBuffersFor( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
-                                    bool casterPass, uint32 lastCacheHash, CommandBuffer *commandBuffer,
-                                    bool isV1 )
+    void HlmsPbs::writeDrawConstants( uint32 *RESTRICT_ALIAS currentMappedConstBuffer,
+                                      uint32 worldMaterialIdx, const HlmsPbsDatablock *datablock,
+                                      const QueuedRenderable &queuedRenderable ) const
     {
-        assert( dynamic_cast<const HlmsPbsDatablock *>( queuedRenderable.renderable->getDatablock() ) );
-        const HlmsPbsDatablock *datablock =
-            static_cast<const HlmsPbsDatablock *>( queuedRenderable.renderable->getDatablock() );
+        currentMappedConstBuffer[0] = worldMaterialIdx;
+        *reinterpret_cast<float * RESTRICT_ALIAS>( currentMappedConstBuffer + 1 ) =
+            datablock->mShadowConstantBias * mConstantBiasScale;
+#if !OGRE_NO_FINE_LIGHT_MASK_GRANULARITY
+        currentMappedConstBuffer[2] = queuedRenderable.movableObject->getLightMask();
+#endif
+#ifdef OGRE_BUILD_COMPONENT_PLANAR_REFLECTIONS
+        currentMappedConstBuffer[3] = queuedRenderable.renderable->mCustomParameter & 0x7F;
+#endif
+    }
+    //-----------------------------------------------------------------------------------
+    float *HlmsPbs::writeWorldMatrices( float *RESTRICT_ALIAS currentMappedTexBuffer,
+                                        const Matrix4 &worldMat, bool writeWorldView ) const
+    {
+        // mat4x3 world
+#if !OGRE_DOUBLE_PRECISION
+        memcpy( currentMappedTexBuffer, &worldMat, 4 * 3 * sizeof( float ) );
+        currentMappedTexBuffer += 16;
+#else
+        for( int y = 0; y < 3; ++y )
+        {
+            for( int x = 0; x < 4; ++x )
+            {
+                *currentMappedTexBuffer++ = worldMat[y][x];
+            }
+        }
+        currentMappedTexBuffer += 4;
+#endif
 
-        if( OGRE_EXTRACT_HLMS_TYPE_FROM_CACHE_HASH( lastCacheHash ) != mType )
+        // mat4 worldView
+        Matrix4 tmp = mPreparedPass.viewMatrix.concatenateAffine( worldMat );
+#if !OGRE_DOUBLE_PRECISION
+        memcpy( currentMappedTexBuffer, &tmp, sizeof( Matrix4 ) * writeWorldView );
+        currentMappedTexBuffer += 16 * writeWorldView;
+#else
+        if( writeWorldView )
         {
-            // layout(binding = 0) uniform PassBuffer {} pass
-            ConstBufferPacked *passBuffer = mPassBuffers[mCurrentPassBuffer - 1];
-            *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
-                VertexShader, 0, passBuffer, 0, (uint32)passBuffer->getTotalSizeBytes() );
+            for( int y = 0; y < 4; ++y )
+            {
+                for( int x = 0; x < 4; ++x )
+                {
+                    *currentMappedTexBuffer++ = tmp[y][x];
+                }
+            }
+        }
+#endif
+        return currentMappedTexBuffer;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPbs::bindDatablockBuffers( const HlmsPbsDatablock *datablock, bool casterPass,
+                                        CommandBuffer                      *commandBuffer,
+                                        ConstBufferPool::BufferPool const *&lastBoundPool )
+    {
+        // Don't bind the material buffer on caster passes (important to keep
+        // MDI & auto-instancing running on shadow map passes)
+        if( lastBoundPool != datablock->getAssignedPool() &&
+            ( !casterPass || datablock->getAlphaTest() != CMPF_ALWAYS_PASS ) )
+        {
+            // layout(binding = 1) uniform MaterialBuf {} materialArray
+            const ConstBufferPool::BufferPool *newPool = datablock->getAssignedPool();
             *commandBuffer->addCommand<CbShaderBuffer>() =
-                CbShaderBuffer( PixelShader, 0, passBuffer, 0, (uint32)passBuffer->getTotalSizeBytes() );
+                CbShaderBuffer( VertexShader, 1, newPool->materialBuffer, 0,
+                                (uint32)newPool->materialBuffer->getTotalSizeBytes() );
+            *commandBuffer->addCommand<CbShaderBuffer>() =
+                CbShaderBuffer( PixelShader, 1, newPool->materialBuffer, 0,
+                                (uint32)newPool->materialBuffer->getTotalSizeBytes() );
+            CubemapProbe *manualProbe = datablock->getCubemapProbe();
+            if( manualProbe )
+            {
+                OGRE_ASSERT_HIGH( manualProbe->getCreator() == mParallaxCorrectedCubemap &&
+                                  "Material has manual cubemap probe that does not match the "
+                                  "PCC currently set" );
+                ConstBufferPacked *probeConstBuf = manualProbe->getConstBufferForManualProbes();
+                *commandBuffer->addCommand<CbShaderBuffer>() =
+                    CbShaderBuffer( PixelShader, uint16( mNumPassConstBuffers ), probeConstBuf, 0, 0 );
+            }
+            lastBoundPool = newPool;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPbs::bindDatablockTextures( const HlmsPbsDatablock *datablock,
+                                         const Renderable *renderable, bool casterPass,
+                                         CommandBuffer               *commandBuffer,
+                                         DescriptorSetTexture const *&lastDescTexture,
+                                         DescriptorSetSampler const *&lastDescSampler,
+                                         uint8                       &lastBoundPlanarReflection )
+    {
+        if( !casterPass || datablock->getAlphaTest() != CMPF_ALWAYS_PASS )
+        {
+#ifdef OGRE_BUILD_COMPONENT_PLANAR_REFLECTIONS
+            if( !casterPass && mHasPlanarReflections &&
+                ( renderable->mCustomParameter & 0x80 /* UseActiveActor */ ) &&
+                lastBoundPlanarReflection != renderable->mCustomParameter )
+            {
+                const uint8 activeActorIdx = renderable->mCustomParameter & 0x7F;
+                TextureGpu *planarReflTex = mPlanarReflections->getTexture( activeActorIdx );
+                *commandBuffer->addCommand<CbTexture>() = CbTexture(
+                    uint16( mTexUnitSlotStart - 1u ), planarReflTex, mPlanarReflectionsSamplerblock );
+                lastBoundPlanarReflection = renderable->mCustomParameter;
+            }
+#endif
+            if( datablock->mTexturesDescSet != lastDescTexture )
+            {
+                if( datablock->mTexturesDescSet )
+                {
+                    // Rebind textures
+                    size_t texUnit = mTexUnitSlotStart;
 
-            uint32 constBufferSlot = 3u;
+                    *commandBuffer->addCommand<CbTextures>() = CbTextures(
+                        (uint16)texUnit, datablock->mCubemapIdxInDescSet, datablock->mTexturesDescSet );
 
-            if( mUseLightBuffers )
-            {
-                ConstBufferPacked *light0Buffer = mLight0Buffers[mCurrentPassBuffer - 1];
-                *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
-                    VertexShader, 3, light0Buffer, 0, (uint32)light0Buffer->getTotalSizeBytes() );
-                *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
-                    PixelShader, 3, light0Buffer, 0, (uint32)light0Buffer->getTotalSizeBytes() );
+                    if( !mHasSeparateSamplers )
+                    {
+                        *commandBuffer->addCommand<CbSamplers>() =
+                            CbSamplers( (uint16)texUnit, datablock->mSamplersDescSet );
+                    }
+                    // texUnit += datablock->mTexturesDescSet->mTextures.size();
+                }
 
-                ConstBufferPacked *light1Buffer = mLight1Buffers[mCurrentPassBuffer - 1];
-                *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
-                    VertexShader, 4, light1Buffer, 0, (uint32)light1Buffer->getTotalSizeBytes() );
-                *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
-                    PixelShader, 4, light1Buffer, 0, (uint32)light1Buffer->getTotalSizeBytes() );
+                lastDescTexture = datablock->mTexturesDescSet;
+            }
 
-                ConstBufferPacked *light2Buffer = mLight2Buffers[mCurrentPassBuffer - 1];
-                *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
-                    VertexShader, 5, light2Buffer, 0, (uint32)light2Buffer->getTotalSizeBytes() );
-                *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
-                    PixelShader, 5, light2Buffer, 0, (uint32)light2Buffer->getTotalSizeBytes() );
+            if( datablock->mSamplersDescSet != lastDescSampler && mHasSeparateSamplers )
+            {
+                if( datablock->mSamplersDescSet )
+                {
+                    // Bind samplers
+                    size_t texUnit = mTexUnitSlotStart;
+                    *commandBuffer->addCommand<CbSamplers>() =
+                        CbSamplers( (uint16)texUnit, datablock->mSamplersDescSet );
+                    lastDescSampler = datablock->mSamplersDescSet;
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    size_t HlmsPbs::fillBuffersForV2Batch( const HlmsCache *cache,
+                                           const QueuedRenderable *queuedRenderables,
+                                           size_t numRenderables, bool casterPass,
+                                           uint32 *outBaseInstances )
+    {
+#if OGRE_DOUBLE_PRECISION
+        return 0u;
+#else
+        // The static instance cache needs a per-object slot lookup; keep the regular path.
+        if( mStaticInstanceCache )
+            return 0u;
+
+        OGRE_ASSERT_HIGH( dynamic_cast<const HlmsPbsDatablock *>(
+            queuedRenderables[0].renderable->getDatablock() ) );
+        const HlmsPbsDatablock *datablock =
+            static_cast<const HlmsPbsDatablock *>( queuedRenderables[0].renderable->getDatablock() );
 
-                constBufferSlot = 6u;
+        // Only the non-animated path is batched. Stop at whatever needs
+        // fillBuffersFor (which may need to add commands).
+        size_t numToFill = 0u;
+        while( numToFill < numRenderables )
+        {
+            const Renderable *renderable = queuedRenderables[numToFill].renderable;
+            if( renderable->hasSkeletonAnimation() || renderable->getNumPoses() > 0u )
+                break;
+#    ifdef OGRE_BUILD_COMPONENT_PLANAR_REFLECTIONS
+            if( !casterPass && mHasPlanarReflections &&
+                ( renderable->mCustomParameter & 0x80 /* UseActiveActor */ ) &&
+                mLastBoundPlanarReflection != renderable->mCustomParameter )
+            {
+                break;
             }
+#    endif
+            ++numToFill;
+        }
+
+        // Same space checks as fillBuffersFor, for all of them at once.
+        const size_t texFloatsPerDraw = 16u * ( 1u + !casterPass );
+        const size_t texOffset = static_cast<size_t>( mCurrentMappedTexBuffer - mStartMappedTexBuffer );
+        const size_t constOffset = texOffset >> ( 2u + !casterPass );
+
+        if( texOffset >= mCurrentTexBufferSize || constOffset >= mCurrentConstBufferSize ||
+            texOffset % texFloatsPerDraw )
+        {
+            return 0u;
+        }
+
+        numToFill =
+            std::min( numToFill, ( mCurrentTexBufferSize - texOffset - 1u ) / texFloatsPerDraw );
+        numToFill = std::min( numToFill, ( mCurrentConstBufferSize - constOffset ) >> 2u );
 
-            size_t texUnit = mReservedTexBufferSlots;
+        uint32 *RESTRICT_ALIAS currentMappedConstBuffer = mStartMappedConstBuffer + constOffset;
+        float *RESTRICT_ALIAS currentMappedTexBuffer = mCurrentMappedTexBuffer;
+
+        // uint4 worldMaterialIdx[]
+        const uint32 materialIdx = datablock->getAssignedSlot() & 0x1FF;
+        for( size_t i = 0u; i < numToFill; ++i )
+        {
+            writeDrawConstants( currentMappedConstBuffer, materialIdx, datablock, queuedRenderables[i] );
+            outBaseInstances[i] =
+                static_cast<uint32>( ( currentMappedConstBuffer - mStartMappedConstBuffer ) >> 2u );
+            currentMappedConstBuffer += 4;
+        }
+
+        // mat4x3 world & mat4 worldView, ARRAY_PACKED_REALS objects at a time
+        const ArrayMatrixAf4x3 viewMat =
+            ArrayMatrixAf4x3::createAllFromMatrix4( mPreparedPass.viewMatrix );
+
+        Matrix4 const *RESTRICT_ALIAS worldMats[ARRAY_PACKED_REALS];
+        OGRE_SIMD_ALIGNED_DECL( SimpleMatrixAf4x3, worldViewMats[ARRAY_PACKED_REALS] );
+
+        for( size_t i = 0u; i < numToFill; i += ARRAY_PACKED_REALS )
+        {
+            const size_t numInBlock = std::min<size_t>( numToFill - i, ARRAY_PACKED_REALS );
+            for( size_t j = 0u; j < ARRAY_PACKED_REALS; ++j )
+            {
+                // Repeat the last one to complete the block
+                const size_t idx = i + std::min( j, numInBlock - 1u );
+                worldMats[j] = &queuedRenderables[idx].movableObject->_getParentNodeFullTransform();
+            }
 
             if( !casterPass )
             {
-                constBufferSlot += mAtmosphere->bindConstBuffers( commandBuffer, constBufferSlot );
+                ArrayMatrixAf4x3 worldViewMat;
+                worldViewMat.loadFromAoS( worldMats );
+                worldViewMat = viewMat * worldViewMat;
+                worldViewMat.storeToAoS( worldViewMats );
+            }
+
+            for( size_t j = 0u; j < numInBlock; ++j )
+            {
+                SimpleMatrixAf4x3 worldMat;
+                worldMat.load( *worldMats[j] );
+                worldMat.streamTo4x3( currentMappedTexBuffer );
+                currentMappedTexBuffer += 16;
 
-                if( mGridBuffer )
+                if( !casterPass )
                 {
-                    *commandBuffer->addCommand<CbShaderBuffer>() =
-                        CbShaderBuffer( PixelShader, (uint16)texUnit++, mGlobalLightListBuffer, 0, 0 );
-                    *commandBuffer->addCommand<CbShaderBuffer>() =
-                        CbShaderBuffer( PixelShader, (uint16)texUnit++, mGridBuffer, 0, 0 );
+                    worldViewMats[j].streamTo4x3( currentMappedTexBuffer );
+                    currentMappedTexBuffer[12] = 0.0f;
+                    currentMappedTexBuffer[13] = 0.0f;
+                    currentMappedTexBuffer[14] = 0.0f;
+                    currentMappedTexBuffer[15] = 1.0f;
+                    currentMappedTexBuffer += 16;
                 }
+            }
+        }
 
-                texUnit += mReservedTexSlots;
+        mCurrentMappedConstBuffer = currentMappedConstBuffer;
+        mCurrentMappedTexBuffer = currentMappedTexBuffer;
 
-                if( !mPrePassTextures->empty() )
-                {
-                    *commandBuffer->addCommand<CbTexture>() =
-                        CbTexture( (uint16)texUnit++, ( *mPrePassTextures )[0], 0 );
-                    *commandBuffer->addCommand<CbTexture>() =
-                        CbTexture( (uint16)texUnit++, ( *mPrePassTextures )[1], 0 );
-                }
+        return numToFill;
+#endif
+    }
+    //-----------------------------------------------------------------------------------
+    size_t HlmsPbs::bindPassResources( bool casterPass, CommandBuffer *commandBuffer )
+    {
+        // layout(binding = 0) uniform PassBuffer {} pass
+        ConstBufferPacked *passBuffer = mPassBuffers[mCurrentPassBuffer - 1];
+        *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
+            VertexShader, 0, passBuffer, 0, (uint32)passBuffer->getTotalSizeBytes() );
+        *commandBuffer->addCommand<CbShaderBuffer>() =
+            CbShaderBuffer( PixelShader, 0, passBuffer, 0, (uint32)passBuffer->getTotalSizeBytes() );
 
-                if( mPrePassMsaaDepthTexture )
-                {
-                    *commandBuffer->addCommand<CbTexture>() = CbTexture(
-                        (uint16)texUnit++, mPrePassMsaaDepthTexture, 0,
-                        PixelFormatGpuUtils::isDepth( mPrePassMsaaDepthTexture->getPixelFormat() ) );
-                }
+        uint32 constBufferSlot = 3u;
 
-                if( mDepthTexture )
-                {
-                    *commandBuffer->addCommand<CbTexture>() =
-                        CbTexture( (uint16)texUnit++, mDepthTexture, mDecalsSamplerblock,
-                                   PixelFormatGpuUtils::isDepth( mDepthTexture->getPixelFormat() ) );
-                }
+        if( mUseLightBuffers )
+        {
+            ConstBufferPacked *light0Buffer = mLight0Buffers[mCurrentPassBuffer - 1];
+            *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
+                VertexShader, 3, light0Buffer, 0, (uint32)light0Buffer->getTotalSizeBytes() );
+            *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
+                PixelShader, 3, light0Buffer, 0, (uint32)light0Buffer->getTotalSizeBytes() );
 
-                if( mSsrTexture )
-                {
-                    *commandBuffer->addCommand<CbTexture>() =
-                        CbTexture( (uint16)texUnit++, mSsrTexture, 0 );
-                }
+            ConstBufferPacked *light1Buffer = mLight1Buffers[mCurrentPassBuffer - 1];
+            *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
+                VertexShader, 4, light1Buffer, 0, (uint32)light1Buffer->getTotalSizeBytes() );
+            *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
+                PixelShader, 4, light1Buffer, 0, (uint32)light1Buffer->getTotalSizeBytes() );
 
-                if( mDepthTextureNoMsaa && mDepthTextureNoMsaa != mPrePassMsaaDepthTexture )
-                {
-                    *commandBuffer->addCommand<CbTexture>() = CbTexture(
-                        (uint16)texUnit++, mDepthTextureNoMsaa, mDecalsSamplerblock,
-                        PixelFormatGpuUtils::isDepth( mDepthTextureNoMsaa->getPixelFormat() ) );
-                }
+            ConstBufferPacked *light2Buffer = mLight2Buffers[mCurrentPassBuffer - 1];
+            *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
+                VertexShader, 5, light2Buffer, 0, (uint32)light2Buffer->getTotalSizeBytes() );
+            *commandBuffer->addCommand<CbShaderBuffer>() = CbShaderBuffer(
+                PixelShader, 5, light2Buffer, 0, (uint32)light2Buffer->getTotalSizeBytes() );
 
-                if( mRefractionsTexture )
-                {
-                    *commandBuffer->addCommand<CbTexture>() =
-                        CbTexture( (uint16)texUnit++, mRefractionsTexture, mDecalsSamplerblock );
-                }
+            constBufferSlot = 6u;
+        }
 
-                if( mIrradianceVolume )
-                {
-                    TextureGpu *irradianceTex = mIrradianceVolume->getIrradianceVolumeTexture();
-                    const HlmsSamplerblock *samplerblock = mIrradianceVolume->getIrradSamplerblock();
+        size_t texUnit = mReservedTexBufferSlots;
 
-                    *commandBuffer->addCommand<CbTexture>() =
-                        CbTexture( (uint16)texUnit, irradianceTex, samplerblock );
-                    ++texUnit;
-                }
+        if( !casterPass )
+        {
+            constBufferSlot += mAtmosphere->bindConstBuffers( commandBuffer, constBufferSlot );
 
-                if( mVctLighting )
-                {
-                    const size_t numCascades = mVctLighting->getNumCascades();
-                    const size_t numVctTextures = mVctLighting->getNumVoxelTextures();
-                    const HlmsSamplerblock *samplerblock = mVctLighting->getBindTrilinearSamplerblock();
-                    for( size_t i = 0u; i < numVctTextures; ++i )
-                    {
-                        for( size_t cascadeIdx = 0; cascadeIdx < numCascades; ++cascadeIdx )
-                        {
-                            TextureGpu **lightVoxelTexs =
-                                mVctLighting->getLightVoxelTextures( cascadeIdx );
-                            *commandBuffer->addCommand<CbTexture>() =
-                                CbTexture( (uint16)texUnit, lightVoxelTexs[i], samplerblock );
-                            ++texUnit;
-                        }
-                    }
-                }
+            if( mGridBuffer )
+            {
+                *commandBuffer->addCommand<CbShaderBuffer>() =
+                    CbShaderBuffer( PixelShader, (uint16)texUnit++, mGlobalLightListBuffer, 0, 0 );
+                *commandBuffer->addCommand<CbShaderBuffer>() =
+                    CbShaderBuffer( PixelShader, (uint16)texUnit++, mGridBuffer, 0, 0 );
+            }
 
-                if( mIrradianceField )
-                {
-                    TODO_irradianceField_samplerblock;
-                    const HlmsSamplerblock *samplerblock = mDecalsSamplerblock;
-                    *commandBuffer->addCommand<CbTexture>() = CbTexture(
-                        (uint16)texUnit++, mIrradianceField->getIrradianceTex(), samplerblock );
-                    *commandBuffer->addCommand<CbTexture>() = CbTexture(
-                        (uint16)texUnit++, mIrradianceField->getDepthVarianceTex(), samplerblock );
-                }
+            texUnit += mReservedTexSlots;
 
-                if( mUsingAreaLightMasks )
-                {
-                    *commandBuffer->addCommand<CbTexture>() =
-                        CbTexture( (uint16)texUnit, mAreaLightMasks, mAreaLightMasksSamplerblock );
-                    ++texUnit;
-                }
+            if( !mPrePassTextures->empty() )
+            {
+                *commandBuffer->addCommand<CbTexture>() =
+                    CbTexture( (uint16)texUnit++, ( *mPrePassTextures )[0], 0 );
+                *commandBuffer->addCommand<CbTexture>() =
+                    CbTexture( (uint16)texUnit++, ( *mPrePassTextures )[1], 0 );
+            }
 
-                if( mLightProfilesTexture )
-                {
-                    *commandBuffer->addCommand<CbTexture>() =
-                        CbTexture( (uint16)texUnit, mLightProfilesTexture, mAreaLightMasksSamplerblock );
-                    ++texUnit;
-                }
+            if( mPrePassMsaaDepthTexture )
+            {
+                *commandBuffer->addCommand<CbTexture>() = CbTexture(
+                    (uint16)texUnit++, mPrePassMsaaDepthTexture, 0,
+                    PixelFormatGpuUtils::isDepth( mPrePassMsaaDepthTexture->getPixelFormat() ) );
+            }
 
-                if( mLtcMatrixTexture )
-                {
-                    *commandBuffer->addCommand<CbTexture>() =
-                        CbTexture( (uint16)texUnit, mLtcMatrixTexture, mAreaLightMasksSamplerblock );
-                    ++texUnit;
-                }
+            if( mDepthTexture )
+            {
+                *commandBuffer->addCommand<CbTexture>() =
+                    CbTexture( (uint16)texUnit++, mDepthTexture, mDecalsSamplerblock,
+                               PixelFormatGpuUtils::isDepth( mDepthTexture->getPixelFormat() ) );
+            }
 
-                for( size_t i = 0u; i < 3u; ++i )
+            if( mSsrTexture )
+            {
+                *commandBuffer->addCommand<CbTexture>() =
+                    CbTexture( (uint16)texUnit++, mSsrTexture, 0 );
+            }
+
+            if( mDepthTextureNoMsaa && mDepthTextureNoMsaa != mPrePassMsaaDepthTexture )
+            {
+                *commandBuffer->addCommand<CbTexture>() = CbTexture(
+                    (uint16)texUnit++, mDepthTextureNoMsaa, mDecalsSamplerblock,
+                    PixelFormatGpuUtils::isDepth( mDepthTextureNoMsaa->getPixelFormat() ) );
+            }
+
+            if( mRefractionsTexture )
+            {
+                *commandBuffer->addCommand<CbTexture>() =
+                    CbTexture( (uint16)texUnit++, mRefractionsTexture, mDecalsSamplerblock );
+            }
+
+            if( mIrradianceVolume )
+            {
+                TextureGpu *irradianceTex = mIrradianceVolume->getIrradianceVolumeTexture();
+                const HlmsSamplerblock *samplerblock = mIrradianceVolume->getIrradSamplerblock();
+
+                *commandBuffer->addCommand<CbTexture>() =
+                    CbTexture( (uint16)texUnit, irradianceTex, samplerblock );
+                ++texUnit;
+            }
+
+            if( mVctLighting )
+            {
+                const size_t numCascades = mVctLighting->getNumCascades();
+                const size_t numVctTextures = mVctLighting->getNumVoxelTextures();
+                const HlmsSamplerblock *samplerblock = mVctLighting->getBindTrilinearSamplerblock();
+                for( size_t i = 0u; i < numVctTextures; ++i )
                 {
-                    if( mDecalsTextures[i] && ( i != 2u || !mDecalsDiffuseMergedEmissive ) )
+                    for( size_t cascadeIdx = 0; cascadeIdx < numCascades; ++cascadeIdx )
                     {
+                        TextureGpu **lightVoxelTexs =
+                            mVctLighting->getLightVoxelTextures( cascadeIdx );
                         *commandBuffer->addCommand<CbTexture>() =
-                            CbTexture( (uint16)texUnit, mDecalsTextures[i], mDecalsSamplerblock );
+                            CbTexture( (uint16)texUnit, lightVoxelTexs[i], samplerblock );
                         ++texUnit;
                     }
                 }
+            }
 
-                // We changed HlmsType, rebind the shared textures.
-                FastArray<TextureGpu *>::const_iterator itor = mPreparedPass.shadowMaps.begin();
-                FastArray<TextureGpu *>::const_iterator end = mPreparedPass.shadowMaps.end();
-                while( itor != end )
-                {
-                    *commandBuffer->addCommand<CbTexture>() =
-                        CbTexture( (uint16)texUnit, *itor, mCurrentShadowmapSamplerblock );
-                    ++texUnit;
-                    ++itor;
-                }
+            if( mIrradianceField )
+            {
+                TODO_irradianceField_samplerblock;
+                const HlmsSamplerblock *samplerblock = mDecalsSamplerblock;
+                *commandBuffer->addCommand<CbTexture>() = CbTexture(
+                    (uint16)texUnit++, mIrradianceField->getIrradianceTex(), samplerblock );
+                *commandBuffer->addCommand<CbTexture>() = CbTexture(
+                    (uint16)texUnit++, mIrradianceField->getDepthVarianceTex(), samplerblock );
+            }
+
+            if( mUsingAreaLightMasks )
+            {
+                *commandBuffer->addCommand<CbTexture>() =
+                    CbTexture( (uint16)texUnit, mAreaLightMasks, mAreaLightMasksSamplerblock );
+                ++texUnit;
+            }
+
+            if( mLightProfilesTexture )
+            {
+                *commandBuffer->addCommand<CbTexture>() =
+                    CbTexture( (uint16)texUnit, mLightProfilesTexture, mAreaLightMasksSamplerblock );
+                ++texUnit;
+            }
+
+            if( mLtcMatrixTexture )
+            {
+                *commandBuffer->addCommand<CbTexture>() =
+                    CbTexture( (uint16)texUnit, mLtcMatrixTexture, mAreaLightMasksSamplerblock );
+                ++texUnit;
+            }
 
-                if( mParallaxCorrectedCubemap && !mParallaxCorrectedCubemap->isRendering() )
+            for( size_t i = 0u; i < 3u; ++i )
+            {
+                if( mDecalsTextures[i] && ( i != 2u || !mDecalsDiffuseMergedEmissive ) )
                 {
-                    TextureGpu *pccTexture = mParallaxCorrectedCubemap->getBindTexture();
-                    const HlmsSamplerblock *samplerblock =
-                        mParallaxCorrectedCubemap->getBindTrilinearSamplerblock();
                     *commandBuffer->addCommand<CbTexture>() =
-                        CbTexture( (uint16)texUnit, pccTexture, samplerblock );
+                        CbTexture( (uint16)texUnit, mDecalsTextures[i], mDecalsSamplerblock );
                     ++texUnit;
                 }
             }
 
+            // We changed HlmsType, rebind the shared textures.
+            FastArray<TextureGpu *>::const_iterator itor = mPreparedPass.shadowMaps.begin();
+            FastArray<TextureGpu *>::const_iterator end = mPreparedPass.shadowMaps.end();
+            while( itor != end )
+            {
+                *commandBuffer->addCommand<CbTexture>() =
+                    CbTexture( (uint16)texUnit, *itor, mCurrentShadowmapSamplerblock );
+                ++texUnit;
+                ++itor;
+            }
+
+            if( mParallaxCorrectedCubemap && !mParallaxCorrectedCubemap->isRendering() )
+            {
+                TextureGpu *pccTexture = mParallaxCorrectedCubemap->getBindTexture();
+                const HlmsSamplerblock *samplerblock =
+                    mParallaxCorrectedCubemap->getBindTrilinearSamplerblock();
+                *commandBuffer->addCommand<CbTexture>() =
+                    CbTexture( (uint16)texUnit, pccTexture, samplerblock );
+                ++texUnit;
+            }
+        }
+
+        return texUnit;
+    }
+    //-----------------------------------------------------------------------------------
+    uint32 HlmsPbs::fillBuffersFor( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                    bool casterPass, uint32 lastCacheHash, CommandBuffer *commandBuffer,
+                                    bool isV1 )
+    {
+        assert( dynamic_cast<const HlmsPbsDatablock *>( queuedRenderable.renderable->getDatablock() ) );
+        const HlmsPbsDatablock *datablock =
+            static_cast<const HlmsPbsDatablock *>( queuedRenderable.renderable->getDatablock() );
+
+        if( OGRE_EXTRACT_HLMS_TYPE_FROM_CACHE_HASH( lastCacheHash ) != mType )
+        {
+            const size_t texUnit = bindPassResources( casterPass, commandBuffer );
+
             mLastDescTexture = 0;
             mLastDescSampler = 0;
             mLastBoundPool = 0;
@@ -3160,37 +3459,20 @@ namespace Ogre
 
             rebindTexBuffer( commandBuffer );
 
+            if( mStaticInstanceCache )
+            {
+                // layout(binding = 1) readonly buffer staticWorldMatBuf
+                *commandBuffer->addCommand<CbShaderBuffer>() =
+                    CbShaderBuffer( VertexShader, 1, mStaticInstanceBuffer, 0, 0 );
+            }
+
 #ifdef OGRE_BUILD_COMPONENT_PLANAR_REFLECTIONS
             mLastBoundPlanarReflection = 0u;
 #endif
             mListener->hlmsTypeChanged( casterPass, commandBuffer, datablock, texUnit );
         }
 
-        // Don't bind the material buffer on caster passes (important to keep
-        // MDI & auto-instancing running on shadow map passes)
-        if( mLastBoundPool != datablock->getAssignedPool() &&
-            ( !casterPass || datablock->getAlphaTest() != CMPF_ALWAYS_PASS ) )
-        {
-            // layout(binding = 1) uniform MaterialBuf {} materialArray
-            const ConstBufferPool::BufferPool *newPool = datablock->getAssignedPool();
-            *commandBuffer->addCommand<CbShaderBuffer>() =
-                CbShaderBuffer( VertexShader, 1, newPool->materialBuffer, 0,
-                                (uint32)newPool->materialBuffer->getTotalSizeBytes() );
-            *commandBuffer->addCommand<CbShaderBuffer>() =
-                CbShaderBuffer( PixelShader, 1, newPool->materialBuffer, 0,
-                                (uint32)newPool->materialBuffer->getTotalSizeBytes() );
-            CubemapProbe *manualProbe = datablock->getCubemapProbe();
-            if( manualProbe )
-            {
-                OGRE_ASSERT_HIGH( manualProbe->getCreator() == mParallaxCorrectedCubemap &&
-                                  "Material has manual cubemap probe that does not match the "
-                                  "PCC currently set" );
-                ConstBufferPacked *probeConstBuf = manualProbe->getConstBufferForManualProbes();
-                *commandBuffer->addCommand<CbShaderBuffer>() =
-                    CbShaderBuffer( PixelShader, uint16( mNumPassConstBuffers ), probeConstBuf, 0, 0 );
-            }
-            mLastBoundPool = newPool;
-        }
+        bindDatablockBuffers( datablock, casterPass, commandBuffer, mLastBoundPool );
 
         uint32 *RESTRICT_ALIAS currentMappedConstBuffer = mCurrentMappedConstBuffer;
         float *RESTRICT_ALIAS currentMappedTexBuffer = mCurrentMappedTexBuffer;
@@ -3201,6 +3483,9 @@ namespace Ogre
 
         const Matrix4 &worldMat = queuedRenderable.movableObject->_getParentNodeFullTransform();
 
+        // uint worldMaterialIdx[]
+        uint32 worldMaterialIdx = datablock->getAssignedSlot() & 0x1FF;
+
         //---------------------------------------------------------------------------
         //                          ---- VERTEX SHADER ----
         //---------------------------------------------------------------------------
@@ -3234,41 +3519,29 @@ namespace Ogre
                 currentMappedTexBuffer = mCurrentMappedTexBuffer;
             }
 
-            // uint worldMaterialIdx[]
-            *currentMappedConstBuffer = datablock->getAssignedSlot() & 0x1FF;
-
-            // mat4x3 world
-#if !OGRE_DOUBLE_PRECISION
-            memcpy( currentMappedTexBuffer, &worldMat, 4 * 3 * sizeof( float ) );
-            currentMappedTexBuffer += 16;
-#else
-            for( int y = 0; y < 3; ++y )
+            uint32 staticSlot = 0u;
+            if( mStaticInstanceCache )
             {
-                for( int x = 0; x < 4; ++x )
-                {
-                    *currentMappedTexBuffer++ = worldMat[y][x];
-                }
+                staticSlot = updateStaticInstanceSlot( queuedRenderable.renderable,
+                                                       queuedRenderable.movableObject, worldMat );
             }
-            currentMappedTexBuffer += 4;
-#endif
 
-            // mat4 worldView
-            Matrix4 tmp = mPreparedPass.viewMatrix.concatenateAffine( worldMat );
-#if !OGRE_DOUBLE_PRECISION
-            memcpy( currentMappedTexBuffer, &tmp, sizeof( Matrix4 ) * !casterPass );
-            currentMappedTexBuffer += 16 * !casterPass;
-#else
-            if( !casterPass )
+            worldMaterialIdx |= staticSlot << 9u;
+
+            if( staticSlot )
             {
-                for( int y = 0; y < 4; ++y )
-                {
-                    for( int x = 0; x < 4; ++x )
-                    {
-                        *currentMappedTexBuffer++ = tmp[y][x];
-                    }
-                }
+                // The shader reads the world matrix from staticWorldMatBuf. We still
+                // consume the space so that drawId keeps indexing worldMatBuf correctly.
+                currentMappedTexBuffer += 16u * ( 1u + !casterPass );
+            }
+            else
+            {
+                // With the static instance cache the shader goes through
+                // world space and passBuf.view instead of worldView.
+                currentMappedTexBuffer = writeWorldMatrices( currentMappedTexBuffer, worldMat,
+                                                             !casterPass && !mStaticInstanceCache );
+                currentMappedTexBuffer += 16u * ( mStaticInstanceCache && !casterPass );
             }
-#endif
         }
         else
         {
@@ -3306,8 +3579,7 @@ namespace Ogre
                     size_t distToWorldMatStart =
                         static_cast<size_t>( mCurrentMappedTexBuffer - mStartMappedTexBuffer );
                     distToWorldMatStart >>= 2;
-                    *currentMappedConstBuffer = uint32( ( distToWorldMatStart << 9 ) |
-                                                        ( datablock->getAssignedSlot() & 0x1FF ) );
+                    worldMaterialIdx |= uint32( distToWorldMatStart << 9 );
 
                     // vec4 worldMat[][3]
                     // TODO: Don't rely on a virtual function + make a direct 4x3 copy
@@ -3367,8 +3639,7 @@ namespace Ogre
                     size_t distToWorldMatStart =
                         static_cast<size_t>( mCurrentMappedTexBuffer - mStartMappedTexBuffer );
                     distToWorldMatStart >>= 2;
-                    *currentMappedConstBuffer = uint32( ( distToWorldMatStart << 9 ) |
-                                                        ( datablock->getAssignedSlot() & 0x1FF ) );
+                    worldMaterialIdx |= uint32( distToWorldMatStart << 9 );
 
                     RenderableAnimated::IndexMap::const_iterator itBone = indexMap->begin();
                     RenderableAnimated::IndexMap::const_iterator enBone = indexMap->end();
@@ -3414,8 +3685,7 @@ namespace Ogre
                     size_t distToWorldMatStart =
                         static_cast<size_t>( mCurrentMappedTexBuffer - mStartMappedTexBuffer );
                     distToWorldMatStart >>= 2;
-                    *currentMappedConstBuffer = uint32( ( distToWorldMatStart << 9 ) |
-                                                        ( datablock->getAssignedSlot() & 0x1FF ) );
+                    worldMaterialIdx |= uint32( distToWorldMatStart << 9 );
                 }
 
                 uint8 meshLod = queuedRenderable.movableObject->getCurrentMeshLod();
@@ -3495,72 +3765,117 @@ namespace Ogre
             currentMappedTexBuffer = mStartMappedTexBuffer + currentConstOffset;
         }
 
-        *reinterpret_cast<float * RESTRICT_ALIAS>( currentMappedConstBuffer + 1 ) =
-            datablock->mShadowConstantBias * mConstantBiasScale;
-#if !OGRE_NO_FINE_LIGHT_MASK_GRANULARITY
-        *( currentMappedConstBuffer + 2u ) = queuedRenderable.movableObject->getLightMask();
-#endif
-#ifdef OGRE_BUILD_COMPONENT_PLANAR_REFLECTIONS
-        *( currentMappedConstBuffer + 3u ) = queuedRenderable.renderable->mCustomParameter & 0x7F;
-#endif
+        writeDrawConstants( currentMappedConstBuffer, worldMaterialIdx, datablock, queuedRenderable );
         currentMappedConstBuffer += 4;
 
         //---------------------------------------------------------------------------
         //                          ---- PIXEL SHADER ----
         //---------------------------------------------------------------------------
 
-        if( !casterPass || datablock->getAlphaTest() != CMPF_ALWAYS_PASS )
-        {
-#ifdef OGRE_BUILD_COMPONENT_PLANAR_REFLECTIONS
-            if( !casterPass && mHasPlanarReflections &&
-                ( queuedRenderable.renderable->mCustomParameter & 0x80 /* UseActiveActor */ ) &&
-                mLastBoundPlanarReflection != queuedRenderable.renderable->mCustomParameter )
-            {
-                const uint8 activeActorIdx = queuedRenderable.renderable->mCustomParameter & 0x7F;
-                TextureGpu *planarReflTex = mPlanarReflections->getTexture( activeActorIdx );
-                *commandBuffer->addCommand<CbTexture>() = CbTexture(
-                    uint16( mTexUnitSlotStart - 1u ), planarReflTex, mPlanarReflectionsSamplerblock );
-                mLastBoundPlanarReflection = queuedRenderable.renderable->mCustomParameter;
-            }
-#endif
-            if( datablock->mTexturesDescSet != mLastDescTexture )
-            {
-                if( datablock->mTexturesDescSet )
-                {
-                    // Rebind textures
-                    size_t texUnit = mTexUnitSlotStart;
+        bindDatablockTextures( datablock, queuedRenderable.renderable, casterPass, commandBuffer,
+                               mLastDescTexture, mLastDescSampler, mLastBoundPlanarReflection );
 
-                    *commandBuffer->addCommand<CbTextures>() = CbTextures(
-                        (uint16)texUnit, datablock->mCubemapIdxInDescSet, datablock->mTexturesDescSet );
+        mCurrentMappedConstBuffer = currentMappedConstBuffer;
+        mCurrentMappedTexBuffer = currentMappedTexBuffer;
 
-                    if( !mHasSeparateSamplers )
-                    {
-                        *commandBuffer->addCommand<CbSamplers>() =
-                            CbSamplers( (uint16)texUnit, datablock->mSamplersDescSet );
-                    }
-                    // texUnit += datablock->mTexturesDescSet->mTextures.size();
-                }
+        return uint32( ( ( mCurrentMappedConstBuffer - mStartMappedConstBuffer ) >> 2u ) - 1u );
+    }
+    //-----------------------------------------------------------------------------------
+    size_t HlmsPbs::getParallelFillMaxDraws( bool casterPass ) const
+    {
+#if OGRE_DOUBLE_PRECISION
+        return 0u;
+#else
+        if( !mParallelFill || mStaticInstanceCache )
+            return 0u;
+        return getParallelFillMaxDrawsPerSlice( 16u * ( 1u + !casterPass ) * sizeof( float ) );
+#endif
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPbs::_beginParallelFill( CommandBuffer *commandBuffer, const size_t *numDrawsPerSegment,
+                                      size_t numSegments, bool casterPass )
+    {
+        reserveParallelFillSlices( commandBuffer, numDrawsPerSegment, numSegments,
+                                   16u * ( 1u + !casterPass ) * sizeof( float ) );
+        mParallelFillSegments.resizePOD( numSegments );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPbs::_beginParallelFillSegment( size_t segmentIdx,
+                                             const QueuedRenderable &queuedRenderable, bool casterPass,
+                                             CommandBuffer *commandBuffer )
+    {
+        // Same as the Hlms type change in fillBuffersFor, but binding the slice
+        const size_t texUnit = bindPassResources( casterPass, commandBuffer );
+        bindParallelFillSlice( segmentIdx, commandBuffer );
+
+        ParallelFillSegmentState &state = mParallelFillSegments[segmentIdx];
+        state.lastBoundPool = 0;
+        state.lastDescTexture = 0;
+        state.lastDescSampler = 0;
+        state.lastBoundPlanarReflection = 0u;
+
+        mListener->hlmsTypeChanged( casterPass, commandBuffer,
+                                    queuedRenderable.renderable->getDatablock(), texUnit );
+    }
+    //-----------------------------------------------------------------------------------
+    uint32 HlmsPbs::fillBuffersForV2Parallel( size_t segmentIdx, const HlmsCache *cache,
+                                              const QueuedRenderable &queuedRenderable,
+                                              bool casterPass, CommandBuffer *commandBuffer )
+    {
+#if OGRE_DOUBLE_PRECISION
+        return ParallelFillStop;
+#else
+        const Renderable *renderable = queuedRenderable.renderable;
 
-                mLastDescTexture = datablock->mTexturesDescSet;
-            }
+        // Must be checked before adding any command, the caller resumes serially from this draw
+        if( renderable->hasSkeletonAnimation() || renderable->getNumPoses() > 0u )
+            return ParallelFillStop;
 
-            if( datablock->mSamplersDescSet != mLastDescSampler && mHasSeparateSamplers )
-            {
-                if( datablock->mSamplersDescSet )
-                {
-                    // Bind samplers
-                    size_t texUnit = mTexUnitSlotStart;
-                    *commandBuffer->addCommand<CbSamplers>() =
-                        CbSamplers( (uint16)texUnit, datablock->mSamplersDescSet );
-                    mLastDescSampler = datablock->mSamplersDescSet;
-                }
-            }
+        ParallelFillSlice &slice = mParallelFillSlices[segmentIdx];
+
+        const size_t texFloatsPerDraw = 16u * ( 1u + !casterPass );
+        if( static_cast<size_t>( slice.currentMappedTexBuffer - slice.startMappedTexBuffer ) +
+                texFloatsPerDraw >
+            slice.texBufferSize )
+        {
+            return ParallelFillStop;
         }
 
-        mCurrentMappedConstBuffer = currentMappedConstBuffer;
-        mCurrentMappedTexBuffer = currentMappedTexBuffer;
+        OGRE_ASSERT_HIGH( dynamic_cast<const HlmsPbsDatablock *>( renderable->getDatablock() ) );
+        const HlmsPbsDatablock *datablock =
+            static_cast<const HlmsPbsDatablock *>( renderable->getDatablock() );
 
-        return uint32( ( ( mCurrentMappedConstBuffer - mStartMappedConstBuffer ) >> 2u ) - 1u );
+        ParallelFillSegmentState &state = mParallelFillSegments[segmentIdx];
+
+        bindDatablockBuffers( datablock, casterPass, commandBuffer, state.lastBoundPool );
+
+        // Without animated draws the const & tex. buffers are always in sync
+        uint32 *RESTRICT_ALIAS currentMappedConstBuffer = slice.currentMappedConstBuffer;
+        float *RESTRICT_ALIAS currentMappedTexBuffer = slice.currentMappedTexBuffer;
+
+        const Matrix4 &worldMat = queuedRenderable.movableObject->_getParentNodeFullTransform();
+
+        // uint worldMaterialIdx[]
+        writeDrawConstants( currentMappedConstBuffer, datablock->getAssignedSlot() & 0x1FF, datablock,
+                            queuedRenderable );
+        currentMappedConstBuffer += 4;
+
+        currentMappedTexBuffer = writeWorldMatrices( currentMappedTexBuffer, worldMat, !casterPass );
+
+        bindDatablockTextures( datablock, renderable, casterPass, commandBuffer, state.lastDescTexture,
+                               state.lastDescSampler, state.lastBoundPlanarReflection );
+
+        slice.currentMappedConstBuffer = currentMappedConstBuffer;
+        slice.currentMappedTexBuffer = currentMappedTexBuffer;
+
+        return uint32( ( ( currentMappedConstBuffer - slice.startMappedConstBuffer ) >> 2u ) - 1u );
+#endif
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPbs::_endParallelFill( CommandBuffer *const *segmentCommandBuffers )
+    {
+        releaseParallelFillSlices();
+        mParallelFillSegments.clear();
     }
     //-----------------------------------------------------------------------------------
     void HlmsPbs::destroyAllBuffers()
@@ -3627,6 +3942,13 @@ namespace Ogre
 
             mLight2Buffers.clear();
         }
+
+        if( mStaticInstanceBuffer )
+        {
+            // Keep the slots; everything gets uploaded again when the buffer is recreated.
+            mVaoManager->destroyReadOnlyBuffer( mStaticInstanceBuffer );
+            mStaticInstanceBuffer = 0;
+        }
     }
     //-----------------------------------------------------------------------------------
     void HlmsPbs::postCommandBufferExecution( CommandBuffer *commandBuffer )
@@ -3650,6 +3972,174 @@ namespace Ogre
         mCurrentPassBuffer = 0;
     }
     //-----------------------------------------------------------------------------------
+    void HlmsPbs::_notifyRenderableUnlinked( Renderable *renderable )
+    {
+        HlmsBufferManager::_notifyRenderableUnlinked( renderable );
+        if( renderable->mHlmsStaticInstanceSlot != std::numeric_limits<uint32>::max() )
+            releaseStaticInstanceSlot( renderable );
+    }
+    //-----------------------------------------------------------------------------------
+    uint32 HlmsPbs::updateStaticInstanceSlot( Renderable *renderable,
+                                              const MovableObject *movableObject,
+                                              const Matrix4 &worldMat )
+    {
+        uint32 slotIdx = renderable->mHlmsStaticInstanceSlot;
+
+        if( !movableObject->isStatic() )
+        {
+            // Object became dynamic
+            if( slotIdx != std::numeric_limits<uint32>::max() )
+                releaseStaticInstanceSlot( renderable );
+            return 0u;
+        }
+
+        if( slotIdx == std::numeric_limits<uint32>::max() )
+        {
+            if( !mStaticInstanceFreeSlots.empty() )
+            {
+                slotIdx = mStaticInstanceFreeSlots.back();
+                mStaticInstanceFreeSlots.pop_back();
+            }
+            else
+            {
+                if( mStaticInstanceSlots.size() >= mStaticInstanceMaxSlots )
+                    return 0u;
+
+                slotIdx = static_cast<uint32>( mStaticInstanceSlots.size() );
+                mStaticInstanceSlots.resizePOD( slotIdx + 1u );
+                mStaticInstanceShadow.resizePOD( ( slotIdx + 1u ) * 16u, 0.0f );
+            }
+
+            StaticInstanceSlot &newSlot = mStaticInstanceSlots[slotIdx];
+            newSlot.owner = renderable;
+            newSlot.capturedVersion = 0u;
+            newSlot.uploadedVersion = 0u;
+            renderable->mHlmsStaticInstanceSlot = slotIdx;
+        }
+
+        StaticInstanceSlot &slot = mStaticInstanceSlots[slotIdx];
+
+        // mStaticTransformsVersion is only 0 if preparePassHash hasn't run since enabling the cache
+        if( slot.uploadedVersion == mStaticTransformsVersion && mStaticTransformsVersion != 0u )
+            return slotIdx + 1u;
+
+        if( slot.capturedVersion != mStaticTransformsVersion )
+        {
+            // Stream it this time, and have it uploaded before the next pass.
+            float *RESTRICT_ALIAS dstData = mStaticInstanceShadow.begin() + slotIdx * 16u;
+            for( size_t y = 0; y < 3u; ++y )
+            {
+                for( size_t x = 0; x < 4u; ++x )
+                    *dstData++ = static_cast<float>( worldMat[y][x] );
+            }
+
+            slot.capturedVersion = mStaticTransformsVersion;
+            mStaticInstanceDirtyBegin = std::min( mStaticInstanceDirtyBegin, slotIdx );
+            mStaticInstanceDirtyEnd = std::max( mStaticInstanceDirtyEnd, slotIdx + 1u );
+        }
+
+        return 0u;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPbs::releaseStaticInstanceSlot( Renderable *renderable )
+    {
+        const uint32 slotIdx = renderable->mHlmsStaticInstanceSlot;
+        OGRE_ASSERT_LOW( slotIdx < mStaticInstanceSlots.size() &&
+                         mStaticInstanceSlots[slotIdx].owner == renderable );
+
+        StaticInstanceSlot &slot = mStaticInstanceSlots[slotIdx];
+        slot.owner = 0;
+        slot.capturedVersion = 0u;
+        slot.uploadedVersion = 0u;
+        mStaticInstanceFreeSlots.push_back( slotIdx );
+
+        renderable->mHlmsStaticInstanceSlot = std::numeric_limits<uint32>::max();
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPbs::uploadStaticInstances( SceneManager *sceneManager )
+    {
+        if( mStaticInstanceSceneManager != sceneManager )
+        {
+            // Versions of different SceneManagers can't be compared. Start over.
+            FastArray<StaticInstanceSlot>::iterator itor = mStaticInstanceSlots.begin();
+            FastArray<StaticInstanceSlot>::iterator endt = mStaticInstanceSlots.end();
+            while( itor != endt )
+            {
+                itor->capturedVersion = 0u;
+                itor->uploadedVersion = 0u;
+                ++itor;
+            }
+            mStaticInstanceSceneManager = sceneManager;
+        }
+
+        mStaticTransformsVersion = sceneManager->getStaticTransformsVersion();
+
+        const size_t bytesPerSlot = 16u * sizeof( float );
+        const uint32 numSlots = static_cast<uint32>( mStaticInstanceSlots.size() );
+
+        if( !mStaticInstanceBuffer || mStaticInstanceBuffer->getNumElements() < numSlots * bytesPerSlot )
+        {
+            size_t newNumSlots = 256u;
+            if( mStaticInstanceBuffer )
+            {
+                newNumSlots = std::max<size_t>(
+                    newNumSlots, mStaticInstanceBuffer->getNumElements() / bytesPerSlot );
+                mVaoManager->destroyReadOnlyBuffer( mStaticInstanceBuffer );
+                mStaticInstanceBuffer = 0;
+            }
+            while( newNumSlots < numSlots )
+                newNumSlots += newNumSlots >> 1u;
+            newNumSlots = std::min( newNumSlots,
+                                    mVaoManager->getReadOnlyBufferMaxSize() / bytesPerSlot );
+
+            mStaticInstanceBuffer = mVaoManager->createReadOnlyBuffer(
+                PFG_RGBA32_FLOAT, newNumSlots * bytesPerSlot, BT_DEFAULT, 0, false );
+
+            // Everything that was captured must go to the new buffer
+            mStaticInstanceDirtyBegin = 0u;
+            mStaticInstanceDirtyEnd = numSlots;
+        }
+
+        if( mStaticInstanceDirtyBegin < mStaticInstanceDirtyEnd )
+        {
+            const uint32 numDirtySlots = mStaticInstanceDirtyEnd - mStaticInstanceDirtyBegin;
+            mStaticInstanceBuffer->upload(
+                mStaticInstanceShadow.begin() + mStaticInstanceDirtyBegin * 16u,
+                mStaticInstanceDirtyBegin * bytesPerSlot, numDirtySlots * bytesPerSlot );
+
+            for( uint32 i = mStaticInstanceDirtyBegin; i < mStaticInstanceDirtyEnd; ++i )
+                mStaticInstanceSlots[i].uploadedVersion = mStaticInstanceSlots[i].capturedVersion;
+
+            mStaticInstanceDirtyBegin = std::numeric_limits<uint32>::max();
+            mStaticInstanceDirtyEnd = 0u;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPbs::destroyStaticInstanceCache()
+    {
+        FastArray<StaticInstanceSlot>::const_iterator itor = mStaticInstanceSlots.begin();
+        FastArray<StaticInstanceSlot>::const_iterator endt = mStaticInstanceSlots.end();
+        while( itor != endt )
+        {
+            if( itor->owner )
+                itor->owner->mHlmsStaticInstanceSlot = std::numeric_limits<uint32>::max();
+            ++itor;
+        }
+
+        mStaticInstanceSlots.clear();
+        mStaticInstanceShadow.clear();
+        mStaticInstanceFreeSlots.clear();
+        mStaticInstanceDirtyBegin = std::numeric_limits<uint32>::max();
+        mStaticInstanceDirtyEnd = 0u;
+        mStaticInstanceSceneManager = 0;
+
+        if( mStaticInstanceBuffer )
+        {
+            mVaoManager->destroyReadOnlyBuffer( mStaticInstanceBuffer );
+            mStaticInstanceBuffer = 0;
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void HlmsPbs::setStaticBranchingLights( bool staticBranchingLights )
     {
         if( staticBranchingLights )
@@ -3780,6 +4270,35 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void HlmsPbs::setDebugPssmSplits( bool bDebug ) { mDebugPssmSplits = bDebug; }
     //-----------------------------------------------------------------------------------
+    void HlmsPbs::setStaticInstanceCache( bool bEnable )
+    {
+        OGRE_ASSERT_LOW( ( !bEnable || mSetupWorldMatBuf ) &&
+                         "The static instance cache needs the world matrix buffer" );
+
+        if( bEnable && mShaderProfile == "glsles" )
+        {
+            OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
+                         "The static instance cache is not supported by the GLSL ES Hlms templates",
+                         "HlmsPbs::setStaticInstanceCache" );
+        }
+
+        if( mStaticInstanceCache == bEnable )
+            return;
+
+        mStaticInstanceCache = bEnable;
+
+        // staticWorldMatBuf takes the vertex shader's read-only buffer slot 1
+        if( bEnable )
+        {
+            ++mReservedTexBufferSlots;
+        }
+        else
+        {
+            --mReservedTexBufferSlots;
+            destroyStaticInstanceCache();
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void HlmsPbs::setPerceptualRoughness( bool bPerceptualRoughness )
     {
         mPerceptualRoughness = bPerceptualRoughness;
@@ -65,6 +65,13 @@ namespace Ogre
         */
         FastArray<size_t> threadStarts;
 
+        /** Incremented every time the animations are updated. Instances pass it plus their
+            index in skeletons to SkeletonInstance::_updateWithLod, so that instances with the
+            same animation LOD interval are evaluated in different frames and every range in
+            threadStarts gets a similar share of evaluations each frame.
+        */
+        uint32 animationLodFrame;
+
         BySkeletonDef( const SkeletonDef *skeletonDef, size_t threadCount );
 
         void initializeMemoryManager();
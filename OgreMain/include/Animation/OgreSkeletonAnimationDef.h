@@ -61,6 +61,8 @@ namespace Ogre
         SkeletonDef const *mSkeletonDef;
 
         KfTransformArrayMemoryManager *mKfTransformMemoryManager;
+        /// Holds the data of all compressed mTracks. Null if not compressed.
+        uint8 *mCompressedKeyFrames;
 
         typedef vector<Real>::type              TimestampVec;
         typedef map<size_t, TimestampVec>::type TimestampsPerBlock;
@@ -100,6 +102,16 @@ namespace Ogre
 
         void build( const v1::Skeleton *skeleton, const v1::Animation *animation, Real frameRate );
 
+        /** Compresses all the tracks (see SkeletonCompressionSettings) and releases
+            the memory of the uncompressed keyframes.
+        @remarks
+            Must be called after build and before any SkeletonAnimation is created from
+            this definition. Can only be called once.
+        */
+        void compress( const SkeletonCompressionSettings &settings );
+
+        bool isCompressed() const { return mCompressedKeyFrames != 0; }
+
         /// Dumps all the tracks in CSV format to the output string argument.
         /// Mostly for debugging purposes. (also easy example to show how to
         /// enumerate all the tracks and get the bones back from its block index)
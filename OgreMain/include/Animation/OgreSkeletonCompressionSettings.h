@@ -0,0 +1,66 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef __SkeletonCompressionSettings_H__
+#define __SkeletonCompressionSettings_H__
+
+#include "OgrePrerequisites.h"
+
+namespace Ogre
+{
+    /** Controls how SkeletonAnimationDef::compress turns the full precision keyframes
+        of each SkeletonTrack into quantized ones.
+    @remarks
+        Keyframes that can be rebuilt by interpolating their neighbours within the
+        given tolerances are removed, channels (position, orientation or scale) that
+        never change within a track are stored once, positions and scales are
+        quantized to 16 bits relative to the per-track bounds, and orientations are
+        stored with the smallest-three 48-bit encoding.
+        The tolerances only drive keyframe and constant channel elimination; the
+        quantization error is added on top (for orientations it is below 0.0001 radians).
+    */
+    struct _OgreExport SkeletonCompressionSettings
+    {
+        bool enabled;
+        /// Maximum position error, in the skeleton's units
+        Real positionTolerance;
+        /// Maximum orientation error, in radians
+        Real orientationTolerance;
+        /// Maximum scale error
+        Real scaleTolerance;
+
+        SkeletonCompressionSettings() :
+            enabled( false ),
+            positionTolerance( 0.0001f ),
+            orientationTolerance( 0.0005f ),
+            scaleTolerance( 0.0001f )
+        {
+        }
+    };
+}  // namespace Ogre
+
+#endif
@@ -33,6 +33,8 @@ THE SOFTWARE.
 
 #include "Animation/OgreBone.h"
 
+#include <atomic>
+
 namespace Ogre
 {
 #if defined( __GNUC__ ) && !defined( __clang__ )
@@ -116,6 +118,31 @@ namespace Ogre
 
         uint16 mRefCount;
 
+        /// Animation LOD thresholds, already transformed by the LodStrategy. Sorted ascending.
+        /// @see setAnimationLodLevels
+        FastArray<Real> mAnimationLodValues;
+        /// How many frames between each evaluation, one per entry in mAnimationLodValues
+        FastArray<uint16> mAnimationLodIntervals;
+        /// Smallest LOD value reported by the MovableObjects using us since the last update.
+        /// Atomic because those objects may be culled by different worker threads.
+        std::atomic<Real> mPendingLodValue;
+        uint16            mAnimationUpdateInterval;
+        uint16 mFramesSinceAnimationUpdate;
+        bool   mAnimationLodInterpolation;
+        /// Whether mLodPoses contains poses that can be blended. @see mLodPoses
+        bool mLodPosesValid;
+        /** When animation LOD interpolation is enabled, contains the local bone transforms
+            of the last two evaluations; in the same layout as SkeletonDef::getBindPose:
+                [0; numBoneBlocks)                  Previous evaluation
+                [numBoneBlocks; numBoneBlocks * 2)  Last evaluation
+        */
+        RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> mLodPoses;
+
+        /// Copies the local transforms of all our bones into dst (one KfTransform per block)
+        void saveLocalPose( KfTransform *RESTRICT_ALIAS dst ) const;
+        /// Sets our local bone transforms (except manual ones) to lerp( prev, next, weight )
+        void blendLodPoses( Real weight );
+
     public:
         SkeletonInstance( const SkeletonDef *skeletonDef, BoneMemoryManager *boneMemoryManager );
         ~SkeletonInstance();
@@ -124,6 +151,57 @@ namespace Ogre
 
         void update();
 
+        /** Same as update(), but takes animation LOD into account: depending on the current
+            update interval (see setAnimationLodLevels), the animations may not be evaluated
+            this frame.
+        @param lodFrame
+            Monotonic frame counter, plus a per instance offset so that instances
+            with the same update interval get evaluated in different frames.
+        */
+        void _updateWithLod( uint32 lodFrame );
+
+        /** Sets up animation LOD. When the LOD value (as computed by the default LodStrategy,
+            e.g. the distance to the LOD camera) is at or past userLodValues[i], the animations
+            of this instance are only evaluated once every updateIntervals[i] frames.
+            Bones keep their last evaluated pose in the frames in between, unless
+            interpolation is enabled (see setAnimationLodInterpolation).
+        @remarks
+            Animation time keeps advancing normally (i.e. keep calling
+            SkeletonAnimation::addTime every frame); only the evaluation is skipped.
+            The LOD value is the one computed by SceneManager::updateAllLods in the previous
+            frame; it is the smallest among all the MovableObjects sharing this instance.
+        @param userLodValues
+            Thresholds in user units of the LOD strategy, sorted in ascending order.
+            Pass an empty array to disable animation LOD.
+        @param updateIntervals
+            One per entry in userLodValues. Must be >= 1. 1 means evaluate every frame.
+        */
+        void setAnimationLodLevels( const FastArray<Real>   &userLodValues,
+                                    const FastArray<uint16> &updateIntervals );
+
+        /** When true, frames in which the animation is not evaluated blend between the last
+            two evaluated poses instead of keeping the last one. This looks smoother at the
+            expense of one update interval of latency and some memory per instance.
+        */
+        void setAnimationLodInterpolation( bool bInterpolate );
+        bool getAnimationLodInterpolation() const { return mAnimationLodInterpolation; }
+
+        /// Returns how many frames pass between each animation evaluation (1 = every frame)
+        uint16 getAnimationUpdateInterval() const { return mAnimationUpdateInterval; }
+
+        /// Internal use. Called when updating LODs of a MovableObject using this instance.
+        /// Thread safe: called from SceneManager::updateAllLods' worker threads.
+        void _notifyLodValue( Real lodValue )
+        {
+            Real currentValue = mPendingLodValue.load( std::memory_order_relaxed );
+            while( lodValue < currentValue &&
+                   !mPendingLodValue.compare_exchange_weak( currentValue, lodValue,
+                                                            std::memory_order_relaxed ) )
+            {
+                // currentValue got updated with the value another thread stored
+            }
+        }
+
         /// Resets the transform of all bones to the binding pose. Manual bones are not reset
         void resetToPose();
 
@@ -39,6 +39,7 @@ THE SOFTWARE.
 namespace Ogre
 {
     class KfTransformArrayMemoryManager;
+    struct SkeletonCompressionSettings;
 
     struct KeyFrameRig
     {
@@ -46,9 +47,30 @@ namespace Ogre
         Real mInvNextFrameDistance;  // 1.0f / (KeyFrameRig[1].mFrame - KeyFrameRig[0].mFrame)
 
         // SoA variable. Packs posrotscale posrotscale ...
+        // Null once the track has been compressed. @see SkeletonTrack::getKeyFrameTransform
         KfTransform *RESTRICT_ALIAS mBoneTransform;
     };
 
+    /** Header at the start of the memory of a compressed SkeletonTrack. It is followed by
+        one entry per keyframe; each entry contains, for every animated channel, three
+        arrays of ARRAY_PACKED_REALS uint16 (SoA):
+            Position:       x, y, z quantized between mPositionMin & mPositionMin + mPositionStep * 65535
+            Orientation:    the three smallest components (smallest-three 48-bit encoding). The
+                            index of the omitted (largest) component is stored in the highest bit
+                            of the first two components.
+            Scale:          x, y, z quantized between mScaleMin & mScaleMin + mScaleStep * 65535
+        Constant channels are not stored per keyframe; their value is in the header
+        (mPositionMin, mConstantOrientation or mScaleMin).
+    */
+    struct CompressedKfHeader
+    {
+        ArrayVector3    mPositionMin;
+        ArrayVector3    mPositionStep;
+        ArrayVector3    mScaleMin;
+        ArrayVector3    mScaleStep;
+        ArrayQuaternion mConstantOrientation;
+    };
+
     typedef vector<KeyFrameRig>::type KeyFrameRigVec;
 
     typedef FastArray<BoneTransform> TransformArray;
@@ -81,6 +103,26 @@ namespace Ogre
 
         KfTransformArrayMemoryManager *mLocalMemoryManager;
 
+        enum CompressedChannels
+        {
+            CompressedPosition = 1u << 0u,
+            CompressedOrientation = 1u << 1u,
+            CompressedScale = 1u << 2u
+        };
+
+        /// CompressedKfHeader followed by the quantized keyframes. Null when not compressed.
+        /// The memory is owned by SkeletonAnimationDef.
+        uint8 const *RESTRICT_ALIAS mCompressedData;
+        /// Bitmask of CompressedChannels that are animated (i.e. stored per keyframe)
+        uint8 mCompressedChannels;
+        /// Bytes per keyframe in mCompressedData
+        uint16 mCompressedStride;
+
+        size_t getCompressedSize() const;
+
+        /// Decodes the keyframe keyFrameIdx from mCompressedData
+        inline void decompressKeyFrame( size_t keyFrameIdx, KfTransform &outTransform ) const;
+
     public:
         SkeletonTrack( uint32 boneBlockIdx, KfTransformArrayMemoryManager *kfTransformMemoryManager );
         ~SkeletonTrack();
@@ -127,6 +169,34 @@ namespace Ogre
             mUsedSlots <= (ARRAY_PACKED_REALS >> 1). Otherwise it does nothing.
         */
         void _bakeUnusedSlots();
+
+        /** Retrieves the transforms of the given keyframe, whether the track is compressed or not.
+        @param keyFrameIdx
+            Index to getKeyFrames()
+        */
+        void getKeyFrameTransform( size_t keyFrameIdx, KfTransform &outTransform ) const;
+
+        bool isCompressed() const { return mCompressedData != 0; }
+
+        /** First step of compression: removes the keyframes that can be rebuilt from its
+            neighbours within the given tolerance, and finds out which channels are constant.
+            Must be called after all keyframes have been set and _bakeUnusedSlots.
+        @return
+            The number of bytes _compress will need. It is always a multiple
+            of OGRE_SIMD_ALIGNMENT
+        */
+        size_t _reduceKeyFrames( const SkeletonCompressionSettings &settings );
+
+        /** Second step of compression: quantizes the remaining keyframes into dstData.
+            After this call KeyFrameRig::mBoneTransform are no longer valid and the
+            original KfTransforms can be freed.
+        @param dstData
+            Memory to write to. Must be OGRE_SIMD_ALIGNMENT-aligned and at least
+            the size returned by _reduceKeyFrames. Must outlive this track.
+        @return
+            Bytes written to dstData.
+        */
+        size_t _compress( uint8 *dstData );
     };
 
     typedef vector<SkeletonTrack>::type SkeletonTrackVec;
@@ -109,6 +109,14 @@ namespace Ogre
         /// Executes all the commands in the command buffer. Clears the cmd buffer afterwards
         void execute();
 
+        /** Moves all the commands recorded in 'other' to the end of this command buffer,
+            preserving their order. 'other' is left empty.
+        @remarks
+            Offsets returned by other.getCommandOffset are no longer valid afterwards.
+            Used to stitch command buffers that were recorded in parallel.
+        */
+        void appendCommands( CommandBuffer &other );
+
         /// Creates/Records a command already casted to the typename.
         /// May invalidate returned pointers from previous calls.
         template <typename T>
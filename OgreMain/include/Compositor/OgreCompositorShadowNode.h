@@ -152,6 +152,12 @@ namespace Ogre
         */
         void buildClosestLightList( Camera *newCamera, const Camera *lodCamera );
 
+        /** Culls the shadow casters of all active shadow maps (including each cubemap face
+            of point lights) at once. Called by _update when
+            SceneManager::getShadowCullingBatched is enabled, after the cameras were set up.
+        */
+        void cullShadowCastersBatched( const Camera *lodCamera, SceneManager *sceneManager );
+
         /** Finds the first index to mShadowMapCastingLights[*startIdx] where
             mShadowMapCastingLights[i].light == 0; starting from startIdx (inclusive).
             and the first index to mShadowMapCastingLights[*entryToUse] where
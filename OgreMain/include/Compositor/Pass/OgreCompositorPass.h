@@ -77,9 +77,11 @@ namespace Ogre
     {
         CompositorPassDef const *mDefinition;
 
-    protected:
+    public:
+        /// Orientation applied to the camera (relative to its own) to render each cubemap face
         static const Quaternion CubemapRotations[6];
 
+    protected:
         RenderPassDescriptor *mRenderPassDesc;
         /// Contains the first valid texture in mRenderPassDesc, to be used for reference
         /// (e.g. width, height, etc). Could be colour, depth, stencil, or nullptr.
@@ -165,7 +165,8 @@ namespace Ogre
                                                            const ArrayQuaternion &rkQ )
     {
         //Flip the sign of rkQ when p.dot( q ) < 0 to get the shortest path
-        ArrayReal sign = rkP.Dot( rkQ );
+        ArrayReal sign = MathlibC::Cmov4( MathlibC::NEG_ONE, MathlibC::ONE,
+                                          MathlibC::CompareLess( rkP.Dot( rkQ ), 0.0f ) );
 
         ArrayQuaternion tmpQ = ArrayQuaternion( rkQ.w * sign,
                                                 rkQ.x * sign,
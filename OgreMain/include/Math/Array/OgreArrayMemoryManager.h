@@ -137,6 +137,21 @@ namespace Ogre
             virtual void performCleanup( uint16 level, const MemoryPoolVec &basePtrs,
                                          size_t const *elementsMemSizes, size_t startInstance,
                                          size_t diffInstances ) = 0;
+
+            /** Called by ArrayMemoryManager::defragmentIncremental after the last used slot
+                has been moved into a hole. Unlike performCleanup, only one slot changed place.
+                @remarks
+                    Listeners relying on slots keeping their relative order (i.e. bones, which
+                    are laid out per skeleton) can't support incremental defragmentation and
+                    should not override this function. The default implementation throws.
+                @param level
+                    The hierarchy depth level
+                @param basePtrs
+                    The base ptrs.
+                @param dstSlot
+                    The slot where the moved instance now lives.
+            */
+            virtual void slotMoved( uint16 level, const MemoryPoolVec &basePtrs, size_t dstSlot );
         };
 
     protected:
@@ -156,6 +171,10 @@ namespace Ogre
         SlotsVec                    mAvailableSlots;
         RebaseListener             *mRebaseListener;
 
+        /// When true, destroySlot never triggers a full defragment.
+        /// See defragmentIncremental.
+        bool mIncrementalDefragment;
+
         /// The hierarchy depth level. This value is not used by the manager,
         /// just passed to the listeners so they can know to which level it
         /// belongs
@@ -233,6 +252,27 @@ namespace Ogre
         ///  Prevent defragmentation from ever happening.
         void neverDefragment();
 
+        /** Closes holes left by destroyed slots without moving more than maxSlotsToMove slots,
+            so that the cost can be spread across several frames.
+        @remarks
+            Holes are filled by moving the last used slot into the lowest hole, thus unlike
+            defragment the relative order of slots is not preserved (slots never change
+            hierarchy level though). Holes at the end are released without moving anything.
+            @par
+            Requires a RebaseListener that implements RebaseListener::slotMoved.
+        @param maxSlotsToMove
+            Maximum number of slots to move in this call.
+        @return
+            Number of slots that were moved.
+        */
+        size_t defragmentIncremental( size_t maxSlotsToMove );
+
+        /** When enabled, reaching the cleanup threshold no longer triggers a full defragment;
+            the owner is expected to call defragmentIncremental periodically instead.
+        */
+        void setIncrementalDefragment( bool bIncremental ) { mIncrementalDefragment = bIncremental; }
+        bool getIncrementalDefragment() const { return mIncrementalDefragment; }
+
         /// Defragments memory, then reallocates a smaller pool that tightly fits
         /// the current number of objects. Useful when you know you won't be creating
         /// more slots and you need to reclaim memory.
@@ -252,6 +292,14 @@ namespace Ogre
         /// Gets all memory reserved for this manager
         size_t getAllMemory() const;
 
+        /// Number of destroyed slots that are still below getNumUsedSlotsIncludingFragmented
+        /// (i.e. the holes a defragmentation would close)
+        size_t getNumFragmentedSlots() const { return mAvailableSlots.size(); }
+
+        /// Number of SIMD lanes iterated over by loops that don't hold a live instance:
+        /// the holes plus the unused lanes of the last pack.
+        size_t getNumWastedSimdLanes() const;
+
     protected:
         /** Requests memory for a new slot (could be used for SceneNode, Entities, etc.)
             @remarks
@@ -313,6 +361,7 @@ namespace Ogre
             WorldMat,
             InheritOrientation,
             InheritScale,
+            Dirty,
             NumMemoryTypes
         };
 
@@ -353,6 +402,10 @@ namespace Ogre
             Number of Nodes in this depth level
         */
         size_t getFirstNode( Transform &outTransform );
+
+        /// Resets Transform::mDirty of every used slot. Called once all nodes in
+        /// this depth (and deeper ones) have been updated.
+        void clearDirtyFlags();
     };
 
     /** Implementation to create the ObjectData variables needed by MovableObjects
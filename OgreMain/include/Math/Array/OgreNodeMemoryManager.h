@@ -68,6 +68,9 @@ namespace Ogre
         SceneMemoryMgrTypes mMemoryManagerType;
         NodeMemoryManager  *mTwinMemoryManager;
 
+        /// Applied to every ArrayMemoryManager, including the ones created later
+        bool mIncrementalDefragment;
+
         /** Makes mMemoryManagers big enough to be able to fulfill mMemoryManagers[newDepth]
         @param newDepth
             Hierarchy level depth we wish to grow to.
@@ -197,6 +200,23 @@ namespace Ogre
         /// @copydoc ArrayMemoryManager::shrinkToFit
         void shrinkToFit();
 
+        /** Runs ArrayMemoryManager::defragmentIncremental on every hierarchy depth, lowest first,
+            until maxSlotsToMove slots have been moved.
+        @return
+            Number of slots that were moved.
+        */
+        size_t defragmentIncremental( size_t maxSlotsToMove );
+
+        /// @copydoc ArrayMemoryManager::setIncrementalDefragment
+        void setIncrementalDefragment( bool bIncremental );
+        bool getIncrementalDefragment() const { return mIncrementalDefragment; }
+
+        /// @copydoc ArrayMemoryManager::getNumFragmentedSlots
+        size_t getNumFragmentedSlots( size_t depth ) const;
+
+        /// @copydoc ArrayMemoryManager::getNumWastedSimdLanes
+        size_t getNumWastedSimdLanes( size_t depth ) const;
+
         /** Retrieves the number of depth levels that have been created.
         @remarks
             The return value is equal or below mMemoryManagers.size(), you should cache
@@ -214,6 +234,15 @@ namespace Ogre
         */
         size_t getFirstNode( Transform &outTransform, size_t depth );
 
+        /** Marks every Node from the given depth onwards as up to date.
+        @remarks
+            Must be called after all those depths have gone through Node::updateAllTransforms,
+            as dirty parents are needed to propagate the change to their children.
+        @param firstDepth
+            First hierarchy level to clear. Shallower levels are left untouched.
+        */
+        void _clearDirtyFlags( size_t firstDepth );
+
         // Derived from ArrayMemoryManager::RebaseListener
         void buildDiffList( uint16 level, const MemoryPoolVec &basePtrs,
                             ArrayMemoryManager::PtrdiffVec &outDiffsList ) override;
@@ -221,6 +250,7 @@ namespace Ogre
                           const ArrayMemoryManager::PtrdiffVec &diffsList ) override;
         void performCleanup( uint16 level, const MemoryPoolVec &basePtrs, size_t const *elementsMemSizes,
                              size_t startInstance, size_t diffInstances ) override;
+        void slotMoved( uint16 level, const MemoryPoolVec &basePtrs, size_t dstSlot ) override;
     };
 
     /** @} */
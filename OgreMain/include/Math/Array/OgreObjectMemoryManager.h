@@ -33,6 +33,8 @@ THE SOFTWARE.
 
 #include "Math/Array/OgreTransform.h"
 
+#include <atomic>
+
 namespace Ogre
 {
     enum SceneMemoryMgrTypes;
@@ -59,6 +61,68 @@ namespace Ogre
         /// ArrayMemoryManagers grouped by hierarchy depth
         ArrayMemoryManagerVec mMemoryManagers;
 
+    public:
+        /// Number of ObjectData packs (of ARRAY_PACKED_REALS objects each) grouped in a cluster.
+        static const size_t CullingClusterNumPacks = 16u;
+        /// Number of object slots grouped in a cluster
+        static const size_t CullingClusterSize = CullingClusterNumPacks * ARRAY_PACKED_REALS;
+        /// Number of object slots covered by one ArrayAabb of cluster bounds
+        static const size_t CullingClusterPackSize = CullingClusterSize * ARRAY_PACKED_REALS;
+
+    private:
+        /** Two-level bounding volume hierarchy over the world aabbs of a render queue.
+            Consecutive slots are grouped in clusters of CullingClusterSize objects, and the
+            bounds of ARRAY_PACKED_REALS clusters are stored SoA in a single ArrayAabb so
+            that whole groups of objects can be rejected with one SIMD test.
+        @remarks
+            Clusters follow memory order, not spatial order. Objects created together
+            (e.g. when loading a level) tend to be close to each other, which is what
+            makes the clusters tight in practice.
+        */
+        struct CullingHierarchy
+        {
+            ArrayAabb *clusterAabbs;
+            /// Number of ArrayAabb in clusterAabbs
+            size_t numClusterPacks;
+            size_t capacity;
+            /// Value of getFirstObjectData when the hierarchy was last prepared
+            size_t numObjects;
+            /// True if objects were created, destroyed or moved since the last refit.
+            /// Atomic because MovableObject::getWorldAabbUpdated may set it from the
+            /// worker threads while they're culling.
+            std::atomic<bool> dirty;
+
+            CullingHierarchy() :
+                clusterAabbs( 0 ),
+                numClusterPacks( 0 ),
+                capacity( 0 ),
+                numObjects( 0 ),
+                dirty( true )
+            {
+            }
+            CullingHierarchy( const CullingHierarchy &other ) :
+                clusterAabbs( other.clusterAabbs ),
+                numClusterPacks( other.numClusterPacks ),
+                capacity( other.capacity ),
+                numObjects( other.numObjects ),
+                dirty( other.dirty.load( std::memory_order_relaxed ) )
+            {
+            }
+            CullingHierarchy &operator=( const CullingHierarchy &other )
+            {
+                clusterAabbs = other.clusterAabbs;
+                numClusterPacks = other.numClusterPacks;
+                capacity = other.capacity;
+                numObjects = other.numObjects;
+                dirty.store( other.dirty.load( std::memory_order_relaxed ),
+                             std::memory_order_relaxed );
+                return *this;
+            }
+        };
+        typedef vector<CullingHierarchy>::type CullingHierarchyVec;
+        CullingHierarchyVec mCullingHierarchies;
+        bool                mCullingHierarchyEnabled;
+
         /// Tracks total number of objects in all render queues.
         size_t mTotalObjects;
 
@@ -74,6 +138,9 @@ namespace Ogre
         SceneMemoryMgrTypes  mMemoryManagerType;
         ObjectMemoryManager *mTwinMemoryManager;
 
+        /// Applied to every ArrayMemoryManager, including the ones created later
+        bool mIncrementalDefragment;
+
         /** Makes mMemoryManagers big enough to be able to fulfill mMemoryManagers[newDepth]
         @param newDepth
             Hierarchy level depth we wish to grow to.
@@ -138,6 +205,23 @@ namespace Ogre
         /// @copydoc ArrayMemoryManager::shrinkToFit
         void shrinkToFit();
 
+        /** Runs ArrayMemoryManager::defragmentIncremental on every render queue, lowest first,
+            until maxSlotsToMove slots have been moved.
+        @return
+            Number of slots that were moved.
+        */
+        size_t defragmentIncremental( size_t maxSlotsToMove );
+
+        /// @copydoc ArrayMemoryManager::setIncrementalDefragment
+        void setIncrementalDefragment( bool bIncremental );
+        bool getIncrementalDefragment() const { return mIncrementalDefragment; }
+
+        /// @copydoc ArrayMemoryManager::getNumFragmentedSlots
+        size_t getNumFragmentedSlots( size_t renderQueue ) const;
+
+        /// @copydoc ArrayMemoryManager::getNumWastedSimdLanes
+        size_t getNumWastedSimdLanes( size_t renderQueue ) const;
+
         /** Retrieves the number of render queues that have been created.
         @remarks
             The return value is equal or below mMemoryManagers.size(), you should cache
@@ -165,6 +249,55 @@ namespace Ogre
         */
         size_t getTotalNumObjects() const { return mTotalObjects; }
 
+        /** Enables building a hierarchy of cluster aabbs per render queue, which
+            SceneManager::cullFrustum uses to reject large groups of objects at once.
+        @remarks
+            The hierarchy is refit by SceneManager::updateAllBounds. While it is out of
+            date (e.g. objects were added after the last update) culling falls back to
+            testing every object.
+        */
+        void setCullingHierarchyEnabled( bool bEnabled );
+        bool getCullingHierarchyEnabled() const { return mCullingHierarchyEnabled; }
+
+        /// Flags the hierarchy of the given render queue as out of date.
+        /// Thread safe, as long as no other thread is calling _prepareCullingHierarchy.
+        void _notifyCullingHierarchyDirty( size_t renderQueue );
+
+        /** Grows the cluster containing the given object so that it encloses aabb, which keeps
+            the hierarchy usable (if conservative) instead of flagging it as out of date.
+            Does nothing if the hierarchy is already out of date.
+        @remarks
+            Main thread only. Must not be called while culling.
+        */
+        void _growCullingHierarchy( size_t renderQueue, const ObjectData &objData, const Aabb &aabb );
+
+        /** Resizes the cluster arrays to match the current number of objects and flags
+            them as up to date. Must be called from the main thread before workers call
+            _refitCullingHierarchy.
+        */
+        void _prepareCullingHierarchy();
+
+        /** Recalculates the cluster bounds of the given range from the world aabbs.
+        @remarks
+            Multiple threads may call this function concurrently as long as their
+            ranges don't overlap.
+        @param firstObj
+            First object slot to refit. Must be multiple of CullingClusterPackSize.
+        @param numObjs
+            Number of object slots to refit. Must be multiple of CullingClusterPackSize
+            unless the range ends at the last object.
+        */
+        void _refitCullingHierarchy( size_t renderQueue, size_t firstObj, size_t numObjs );
+
+        /** Retrieves the cluster bounds of a render queue.
+        @param outNumClusterPacks
+            [out] Number of ArrayAabb in the returned array. Each ArrayAabb holds the bounds
+            of ARRAY_PACKED_REALS clusters of CullingClusterSize objects each.
+        @return
+            Null if the hierarchy is disabled or out of date.
+        */
+        const ArrayAabb *_getCullingHierarchy( size_t renderQueue, size_t &outNumClusterPacks ) const;
+
         /// This is the opposite of getTotalNumObjects. This function returns the sum
         /// of the return values of getFirstObjectData
         size_t calculateTotalNumObjectDataIncludingFragmentedSlots() const;
@@ -189,6 +322,7 @@ namespace Ogre
                           const ArrayMemoryManager::PtrdiffVec &diffsList ) override;
         void performCleanup( uint16 level, const MemoryPoolVec &basePtrs, size_t const *elementsMemSizes,
                              size_t startInstance, size_t diffInstances ) override;
+        void slotMoved( uint16 level, const MemoryPoolVec &basePtrs, size_t dstSlot ) override;
     };
 
     /** @} */
@@ -74,6 +74,11 @@ namespace Ogre
         /// Ours is mInheritScale[mIndex]
         bool *RESTRICT_ALIAS mInheritScale;
 
+        /// Set when our local transform changed (or our parent's derived transform was
+        /// recomputed) since the last SceneManager::updateAllTransforms. Packs where no
+        /// node is dirty are skipped. Ours is mDirty[mIndex]
+        bool *RESTRICT_ALIAS mDirty;
+
         Transform() :
             mIndex( 0 ),
             mParents( 0 ),
@@ -86,7 +91,8 @@ namespace Ogre
             mDerivedScale( 0 ),
             mDerivedTransform( 0 ),
             mInheritOrientation( 0 ),
-            mInheritScale( 0 )
+            mInheritScale( 0 ),
+            mDirty( 0 )
         {
         }
 
@@ -100,7 +106,9 @@ namespace Ogre
             those two options should memcpy memory, or rebase the pointers, hence
             explicit functions are much preferred. @see rebasePtrs
 
-            Note that we do NOT copy the mIndex member.
+            Note that we do NOT copy the mIndex member, nor mDirty: a Transform is only copied
+            into a freshly created slot (which always starts dirty) after changing depth or
+            memory manager, so its derived transform must be recomputed anyway.
         */
         void copy( const Transform &inCopy )
         {
@@ -174,6 +182,7 @@ namespace Ogre
                 newBasePtrs[NodeArrayMemoryManager::InheritOrientation] + diff );
             mInheritScale =
                 reinterpret_cast<bool *>( newBasePtrs[NodeArrayMemoryManager::InheritScale] + diff );
+            mDirty = reinterpret_cast<bool *>( newBasePtrs[NodeArrayMemoryManager::Dirty] + diff );
         }
 
         /** Advances all pointers to the next pack, i.e. if we're processing 4 elements at a time, move
@@ -192,6 +201,7 @@ namespace Ogre
             mDerivedTransform += ARRAY_PACKED_REALS;
             mInheritOrientation += ARRAY_PACKED_REALS;
             mInheritScale += ARRAY_PACKED_REALS;
+            mDirty += ARRAY_PACKED_REALS;
         }
 
         void advancePack( size_t numAdvance )
@@ -207,6 +217,7 @@ namespace Ogre
             mDerivedTransform += ARRAY_PACKED_REALS * numAdvance;
             mInheritOrientation += ARRAY_PACKED_REALS * numAdvance;
             mInheritScale += ARRAY_PACKED_REALS * numAdvance;
+            mDirty += ARRAY_PACKED_REALS * numAdvance;
         }
     };
 }  // namespace Ogre
@@ -93,6 +93,7 @@ THE SOFTWARE.
 #define OGRE_MEMORY_ALLOCATOR_STD 1
 #define OGRE_MEMORY_ALLOCATOR_USER 3
 #define OGRE_MEMORY_ALLOCATOR_TRACK 5
+#define OGRE_MEMORY_ALLOCATOR_POOLED 6
 
 // Whether to use the custom memory allocator in STL containers
 #ifndef OGRE_CONTAINERS_USE_CUSTOM_MEMORY_ALLOCATOR
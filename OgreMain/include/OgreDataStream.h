@@ -303,6 +303,17 @@ namespace Ogre
          */
         virtual bool eof() const = 0;
 
+        /** Returns a pointer to the current read position if the rest of the stream is
+            directly addressable in memory (e.g. MemoryDataStream, MmapDataStream), so that
+            callers can consume it in place instead of read()ing it into their own buffer.
+        @remarks
+            The pointer is valid for size() - tell() bytes and for as long as the stream is
+            alive and not closed. Advancing it is up to the caller (i.e. via skip).
+        @return
+            Null if the stream isn't backed by memory; read() must be used instead.
+        */
+        virtual const uchar *getCurrentReadPtr() const { return 0; }
+
         /** Returns the total size of the data to be read from the stream,
             or 0 if this is indeterminate for this stream.
         */
@@ -473,6 +484,10 @@ namespace Ogre
          */
         bool eof() const override;
 
+        /** @copydoc DataStream::getCurrentReadPtr
+         */
+        const uchar *getCurrentReadPtr() const override { return mPos; }
+
         /** @copydoc DataStream::close
          */
         void close() override;
@@ -645,6 +660,88 @@ namespace Ogre
          */
         void close() override;
     };
+
+    /** Read-only DataStream backed by a memory mapped file.
+    @remarks
+        The file isn't copied into a heap buffer when opened; pages are brought in by
+        the OS as they're touched. Thus getCurrentReadPtr lets consumers (e.g. mesh
+        and texture loaders) upload straight from the mapped pages.
+    @par
+        The mapping is private (copy on write), so writes through the returned pointers
+        never reach the file. Don't truncate the file on disk while it's mapped.
+    */
+    class _OgreExport MmapDataStream final : public DataStream
+    {
+    protected:
+        /// Pointer to the start of the mapped view
+        uchar *mData;
+        /// Pointer to the current position in the mapped view
+        uchar *mPos;
+        /// Pointer to the end of the mapped view
+        uchar *mEnd;
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+        /// HANDLE of the file mapping object
+        void *mFileMapping;
+#endif
+
+    public:
+        /** Maps the whole file into memory.
+        @param name
+            The name to give the stream.
+        @param fullPath
+            Path to the file.
+        @exception
+            ERR_FILE_NOT_FOUND if the file couldn't be opened or mapped,
+            ERR_NOT_IMPLEMENTED if !isSupported().
+        */
+        MmapDataStream( const String &name, const String &fullPath );
+        ~MmapDataStream() override;
+
+        /// Returns true if the platform supports memory mapped files.
+        static bool isSupported();
+
+        /** Get a pointer to the start of the mapped file. */
+        const uchar *getPtr() const { return mData; }
+
+        /** Get a pointer to the current position in the mapped file. */
+        const uchar *getCurrentPtr() const { return mPos; }
+
+        /** @copydoc DataStream::read
+         */
+        size_t read( void *buf, size_t count ) override;
+
+        /** @copydoc DataStream::readLine
+         */
+        size_t readLine( char *buf, size_t maxCount, const String &delim = "\n" ) override;
+
+        /** @copydoc DataStream::skipLine
+         */
+        size_t skipLine( const String &delim = "\n" ) override;
+
+        /** @copydoc DataStream::skip
+         */
+        void skip( long count ) override;
+
+        /** @copydoc DataStream::seek
+         */
+        void seek( size_t pos ) override;
+
+        /** @copydoc DataStream::tell
+         */
+        size_t tell() const override;
+
+        /** @copydoc DataStream::eof
+         */
+        bool eof() const override;
+
+        /** @copydoc DataStream::getCurrentReadPtr
+         */
+        const uchar *getCurrentReadPtr() const override { return mPos; }
+
+        /** @copydoc DataStream::close
+         */
+        void close() override;
+    };
     /** @} */
     /** @} */
 }  // namespace Ogre
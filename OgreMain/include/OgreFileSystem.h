@@ -133,7 +133,21 @@ namespace Ogre
         /// Get whether hidden files are ignored during filesystem enumeration.
         static bool getIgnoreHidden() { return msIgnoreHidden; }
 
+        /** Set whether files opened read-only are memory mapped (see MmapDataStream)
+            instead of being streamed through std::ifstream. This avoids copying the whole
+            file into a heap buffer before parsing it, and lets loaders consume the mapped
+            pages in place. Has no effect where MmapDataStream::isSupported is false.
+            The default is false.
+        @remarks
+            Don't modify or truncate files on disk while they're open with this option.
+        */
+        static void setUseMemoryMapping( bool useMmap ) { msUseMemoryMapping = useMmap; }
+
+        /// Get whether read-only files are memory mapped.
+        static bool getUseMemoryMapping() { return msUseMemoryMapping; }
+
         static bool msIgnoreHidden;
+        static bool msUseMemoryMapping;
     };
 
     /** Specialisation of ArchiveFactory for FileSystem files. */
@@ -32,6 +32,7 @@ THE SOFTWARE.
 
 #include "OgreForwardPlusBase.h"
 #include "OgreRawPtr.h"
+#include "Threading/OgreTaskScheduler.h"
 #include "Threading/OgreUniformScalableTask.h"
 
 #include "OgreHeaderPrefix.h"
@@ -46,7 +47,9 @@ namespace Ogre
      */
 
     /** Implementation of Clustered Forward Shading */
-    class _OgreExport ForwardClustered : public ForwardPlusBase, public UniformScalableTask
+    class _OgreExport ForwardClustered : public ForwardPlusBase,
+                                         public UniformScalableTask,
+                                         public RangeTask
     {
         struct ArrayPlane
         {
@@ -59,6 +62,16 @@ namespace Ogre
             ArrayAabb    aabb;
             ArrayVector3 corners[8];
         };
+        /// Conservative range of cells touched by a light. All ranges are inclusive.
+        struct LightCellRange
+        {
+            uint32 minPackX;
+            uint32 maxPackX;
+            uint32 minY;
+            uint32 maxY;
+            uint32 minSlice;
+            uint32 maxSlice;
+        };
 
         uint32 mWidth;
         uint32 mHeight;
@@ -86,6 +99,9 @@ namespace Ogre
         bool                     mDebugWireAabbFrozen;
         vector<WireAabb *>::type mDebugWireAabb;
 
+        bool                      mLightCellRangeBinning;
+        FastArray<LightCellRange> mLightCellRanges;
+
         inline size_t getDecalsOffsetStart() const;
         inline size_t getCubemapProbesOffsetStart() const;
 
@@ -103,6 +119,13 @@ namespace Ogre
         void collectObjsForSlice( const size_t numPackedFrustumsPerSlice, const size_t frustumStartIdx,
                                   uint16 offsetStart, size_t minRq, size_t maxRq, size_t currObjsPerCell,
                                   size_t cellOffsetStart, ObjTypes objType, uint16 numFloat4PerObj );
+        /// Returns the range that covers the whole grid
+        LightCellRange getFullCellRange() const;
+
+        /// Fills mLightCellRanges from mCurrentLightList, projecting the bounding
+        /// sphere of each light as seen from mCurrentCamera
+        void computeLightCellRanges();
+
         void collectLightForSlice( size_t slice, size_t threadId );
 
         void collectObjs( const Camera *camera, size_t &outNumDecals, size_t &outNumCubemapProbes );
@@ -121,7 +144,23 @@ namespace Ogre
         void setFreezeDebugFrustum( bool freezeDebugFrustum );
         bool getFreezeDebugFrustum() const;
 
+        /** When enabled, the bounding sphere of each light is projected once per camera to a
+            conservative range of cells and depth slices, and only those cells are tested
+            against the light. Otherwise every light is tested against every cell.
+        @remarks
+            Only cells the light can't reach are skipped, so shading is unaffected. Much
+            cheaper with lots of small lights.
+            Orthographic, reflected and rotated (see Frustum::setOrientationMode) cameras
+            always test every cell.
+        */
+        void setLightCellRangeBinning( bool bEnable ) { mLightCellRangeBinning = bEnable; }
+        bool getLightCellRangeBinning() const { return mLightCellRangeBinning; }
+
+        /// Kept for users who still run it via SceneManager::executeUserScalableTask.
+        /// collectLights submits the RangeTask version instead.
         void execute( size_t threadId, size_t numThreads ) override;
+        /// Collects the lights of slices [begin; end). Submitted to SceneManager's TaskScheduler
+        void execute( size_t begin, size_t end, size_t threadIdx ) override;
 
         void collectLights( Camera *camera ) override;
 
@@ -151,6 +151,7 @@ namespace Ogre
         bool mEnableVpls;
         bool mDecalsEnabled;
         bool mCubemapProbesEnabled;
+        bool mCompactGrid;
 #if !OGRE_NO_FINE_LIGHT_MASK_GRANULARITY
         bool mFineLightMaskGranularity;
 #endif
@@ -158,11 +159,35 @@ namespace Ogre
         uint16 mDecalFloat4Offset;
         uint16 mCubemapProbeFloat4Offset;
 
+        /// When mCompactGrid is true, the grid is still binned here with its full fixed
+        /// layout (numCells * objsPerCell slots); only the GPU buffer and its upload are
+        /// compacted, by endGridFill. See setCompactGrid
+        FastArray<uint16> mUncompactedGrid;
+
         static size_t calculateBytesNeeded( size_t numLights, size_t numDecals,
                                             size_t numCubemapProbes );
 
         void fillGlobalLightListBuffer( Camera *camera, TexBufferPacked *globalLightListBuffer );
 
+        /** Returns where to write the grid with its fixed layout of objsPerCell slots per cell.
+            When not compacting, this is the mapped gridBuffer (created if needed).
+            Must be followed by endGridFill.
+        @param numGridElements
+            Number of uint16 slots in the grid, i.e. numCells * objsPerCell.
+        */
+        uint16 *beginGridFill( CachedGridBuffer &gridBuffers, size_t numGridElements );
+
+        /** Finishes what beginGridFill started. When compacting, gridBuffer is (re)created
+            as needed and mUncompactedGrid is packed into it via compactGrid.
+        @param decalsSlotOffset
+            Where the decal count is in the fixed layout. Ignored if decals are disabled.
+        @param cubemapSlotOffset
+            Where the cubemap probe count is in the fixed layout.
+            Ignored if cubemap probes are disabled.
+        */
+        void endGridFill( CachedGridBuffer &gridBuffers, size_t objsPerCell, size_t decalsSlotOffset,
+                          size_t cubemapSlotOffset );
+
         /** Finds a grid already cached in mCachedGrid that can be used for the given camera.
             If the cache does not exist, we create a new entry.
         @param camera
@@ -242,6 +267,55 @@ namespace Ogre
 
         bool getDecalsEnabled() const { return mDecalsEnabled; }
 
+        /** When enabled, each cell only stores the lights, decals and cubemap probes it
+            actually contains instead of reserving the maximum slots per cell.
+        @remarks
+            The compaction only applies to the GPU buffer and its upload. The CPU still bins
+            into a scratch grid with the full fixed layout, which is then counted,
+            prefix-summed and packed into the GPU buffer together with a table of per-cell
+            offsets (see compactGrid). CPU memory and binning cost are thus unchanged,
+            plus an extra pass over the grid.
+            @par
+            Greatly reduces the grid's GPU memory and upload bandwidth when the per-cell
+            limits are high but most cells are sparse. The shader pays a few extra
+            fetches per pixel to locate the cell's lists.
+            Disabled by default. Toggling it destroys all cached grids.
+            @par
+            Not available on OpenGL ES, as the GLSLES templates only read the fixed layout.
+            Throws if enabled there.
+        */
+        void setCompactGrid( bool bCompactGrid );
+        bool getCompactGrid() const { return mCompactGrid; }
+
+        /// Returns how many uint16 compactGrid will write for the given fixed layout grid,
+        /// including the offset table. See compactGrid for the parameters.
+        static size_t getCompactGridNumElements( const uint16 *srcGrid, size_t numCells,
+                                                 size_t objsPerCell, size_t decalsSlotOffset,
+                                                 size_t cubemapSlotOffset, bool decalsEnabled,
+                                                 bool cubemapProbesEnabled );
+
+        /** Packs a grid with the fixed layout of objsPerCell slots per cell into the
+            compact layout read by the shaders when setCompactGrid is enabled:
+            a table of 32-bit offsets (two uint16 per cell: high, low) followed by the
+            variable-length list of each cell:
+                numLights[3], lights, numDecals, decals, numCubemapProbes, cubemapProbes
+            The decal count is present if either decals or cubemap probes are enabled.
+            The cubemap probe count is present if cubemap probes are enabled.
+        @param dstGrid
+            Where to write. Must hold getCompactGridNumElements() uint16.
+        @param srcGrid
+            The grid with the fixed layout. Must hold numCells * objsPerCell uint16.
+        @param decalsSlotOffset
+            Where the decal count is in the fixed layout. Ignored if decals are disabled.
+        @param cubemapSlotOffset
+            Where the cubemap probe count is in the fixed layout.
+            Ignored if cubemap probes are disabled.
+        */
+        static void compactGrid( uint16 *RESTRICT_ALIAS dstGrid, const uint16 *RESTRICT_ALIAS srcGrid,
+                                 size_t numCells, size_t objsPerCell, size_t decalsSlotOffset,
+                                 size_t cubemapSlotOffset, bool decalsEnabled,
+                                 bool cubemapProbesEnabled );
+
 #if !OGRE_NO_FINE_LIGHT_MASK_GRANULARITY
         /// Toggles whether light masks will be obeyed per object & per light by doing:
         /// if( movableObject->getLightMask() & light->getLightMask() )
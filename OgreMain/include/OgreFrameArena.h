@@ -0,0 +1,203 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreFrameArena_H_
+#define _OgreFrameArena_H_
+
+#include "OgrePrerequisites.h"
+
+#include "Threading/OgreLightweightMutex.h"
+#include "ogrestd/vector.h"
+
+#include <limits>
+#include <vector>
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Memory
+     *  @{
+     */
+
+    /** Linear (bump) allocator for data which only lives for a few frames.
+    @remarks
+        Allocating is just advancing an offset, and deallocating does nothing: all the
+        memory handed out during a frame is reclaimed at once when the arena cycles back
+        to that frame. There are numFrames frames in flight (3 by default), so memory
+        allocated in frame N stays valid until frame N + numFrames begins.
+    @par
+        Memory is kept between frames. If a frame needed more than one block, its blocks
+        are merged into a single bigger one the next time it's reset, thus in steady state
+        each frame is served from one contiguous block without touching the heap.
+    @par
+        It is thread safe, though allocations take a lightweight lock; so prefer few
+        coarse allocations (e.g. a whole container's buffer) over many tiny ones.
+        Use FrameArenaAllocator to back STL containers with it.
+    @see
+        Root::getFrameArena
+    */
+    class _OgreExport FrameArena : public OgreAllocatedObj
+    {
+    protected:
+        struct Block
+        {
+            uint8 *data;
+            size_t capacity;
+        };
+
+        typedef vector<Block>::type BlockVec;
+
+        struct Frame
+        {
+            /// The last block is the one we're allocating from
+            BlockVec blocks;
+            size_t   offset;
+            size_t   bytesUsed;
+        };
+
+        typedef vector<Frame>::type FrameVec;
+
+        mutable LightweightMutex mMutex;
+        FrameVec                 mFrames;
+        size_t                   mCurrentFrame;
+        size_t                   mBlockSize;
+
+        void addBlock( Frame &frame, size_t minCapacity );
+
+    public:
+        /**
+        @param numFrames
+            Number of frames in flight. Must be at least 1.
+        @param blockSize
+            Minimum size in bytes of the blocks requested to the system.
+        */
+        FrameArena( size_t numFrames = 3u, size_t blockSize = 256u * 1024u );
+        ~FrameArena();
+
+        /** Allocates memory valid until this frame gets recycled, i.e. numFrames
+            calls to _advanceFrame from now.
+        @param alignment
+            Must be a power of two.
+        */
+        void *allocate( size_t bytes, size_t alignment = OGRE_SIMD_ALIGNMENT );
+
+        /// Allocates space for count elements of type T, without constructing them.
+        template <typename T>
+        T *allocate( size_t count )
+        {
+            return static_cast<T *>( allocate( count * sizeof( T ), alignof( T ) ) );
+        }
+
+        /** Moves on to the next frame, recycling all the memory allocated in it.
+        @remarks
+            Root calls this after the frameEnded listeners. Containers backed by the
+            arena must not outlive it.
+        */
+        void _advanceFrame();
+
+        /// Releases all the memory back to the system. All frames must be unused.
+        void releaseMemory();
+
+        size_t getNumFrames() const { return mFrames.size(); }
+        size_t getBlockSize() const { return mBlockSize; }
+
+        /// Bytes allocated so far in the current frame, including alignment padding.
+        size_t getBytesUsed() const;
+
+        /// Bytes obtained from the system, across all frames.
+        size_t getBytesReserved() const;
+    };
+
+    /** STL-compatible allocator adapter for FrameArena. Deallocation is a no-op,
+        so growing a container leaves its old buffer behind until the frame is recycled.
+        Reserve in advance when the final size can be estimated.
+    @code
+        FrameArenaVector<MyType>::type myVec( FrameArenaAllocator<MyType>( &frameArena ) );
+    @endcode
+    */
+    template <typename T>
+    class FrameArenaAllocator
+    {
+    public:
+        typedef T              value_type;
+        typedef T             *pointer;
+        typedef const T       *const_pointer;
+        typedef T             &reference;
+        typedef const T       &const_reference;
+        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        template <typename U>
+        struct rebind
+        {
+            typedef FrameArenaAllocator<U> other;
+        };
+
+        FrameArena *mArena;
+
+        explicit FrameArenaAllocator( FrameArena *arena ) : mArena( arena ) {}
+
+        template <typename U>
+        FrameArenaAllocator( const FrameArenaAllocator<U> &other ) : mArena( other.mArena )
+        {
+        }
+
+        T *allocate( size_t count, const void * = 0 ) { return mArena->allocate<T>( count ); }
+        void deallocate( T *, size_t ) {}
+
+        size_t max_size() const { return std::numeric_limits<size_t>::max() / sizeof( T ); }
+    };
+
+    template <typename T, typename U>
+    inline bool operator==( const FrameArenaAllocator<T> &a, const FrameArenaAllocator<U> &b )
+    {
+        return a.mArena == b.mArena;
+    }
+    template <typename T, typename U>
+    inline bool operator!=( const FrameArenaAllocator<T> &a, const FrameArenaAllocator<U> &b )
+    {
+        return a.mArena != b.mArena;
+    }
+
+    /// std::vector backed by a FrameArena.
+    template <typename T>
+    struct FrameArenaVector
+    {
+        typedef std::vector<T, FrameArenaAllocator<T> > type;
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
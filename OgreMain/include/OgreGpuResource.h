@@ -137,6 +137,8 @@ namespace Ogre
         /// may be paged out and replaced with 64x64 mips.
         uint32 mLastFrameUsed;
         float  mLowestDistanceToCamera;
+        /// Whether _touch has ever been called. See hasBeenTouched
+        bool mTouched;
 
         VaoManager *mVaoManager;
 
@@ -195,6 +197,43 @@ namespace Ogre
         */
         uint32 getPendingResidencyChanges() const;
 
+        /// Sets the rank. See GpuResource::mRank.
+        /// The texture streaming budget never pages out resources with rank 0.
+        /// See TextureGpuManager::setResidencyBudget
+        void  setRank( int32 rank );
+        int32 getRank() const;
+
+        /** Flags this resource as used in the given frame. Only the first touch in a frame
+            resets the distance to camera; subsequent touches keep the lowest distance.
+            Called by the RenderQueue when TextureGpuManager::setResidencyBudget is enabled.
+        @param frameCount
+            VaoManager::getFrameCount()
+        @param distanceToCamera
+            Distance from the camera to the object that is using this resource.
+        */
+        void _touch( uint32 frameCount, float distanceToCamera )
+        {
+            if( mLastFrameUsed != frameCount || !mTouched )
+            {
+                mLastFrameUsed = frameCount;
+                mLowestDistanceToCamera = distanceToCamera;
+            }
+            else
+            {
+                mLowestDistanceToCamera = std::min( mLowestDistanceToCamera, distanceToCamera );
+            }
+            mTouched = true;
+        }
+
+        /// Returns true if _touch was called at least once. Resources nobody touches
+        /// (e.g. only used by compositor passes) have an unknown age.
+        bool hasBeenTouched() const { return mTouched; }
+
+        /// Returns the last frame this resource was touched. See GpuResource::_touch
+        uint32 getLastFrameUsed() const { return mLastFrameUsed; }
+        /// Returns the lowest distance to camera while being used during getLastFrameUsed
+        float getLowestDistanceToCamera() const { return mLowestDistanceToCamera; }
+
         IdString getName() const;
         /// Retrieves a user-friendly name. May involve a look up.
         /// NOT THREAD SAFE. ONLY CALL FROM MAIN THREAD.
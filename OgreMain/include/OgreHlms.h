@@ -221,6 +221,28 @@ namespace Ogre
         HlmsPropertyVec mSetProperties;
         PiecesMap       mPieces;
 
+        /// A shader cache entry whose creation was postponed. @see setDeferredShaderCacheCreation
+        struct PendingShaderCacheEntry
+        {
+            uint32               renderableHash;
+            uint32               finalHash;
+            HlmsCache            passCache;
+            Renderable          *renderable;
+            MovableObject const *movableObject;
+        };
+
+        typedef vector<PendingShaderCacheEntry>::type PendingShaderCacheEntryVec;
+
+        /// In the order they were requested
+        PendingShaderCacheEntryVec mPendingShaderCacheEntries;
+        /// finalHash of every entry in mPendingShaderCacheEntries
+        set<uint32>::type          mPendingShaderCacheHashes;
+        uint32                     mMaxDeferredCreationsPerFrame;
+        uint32                     mDeferredCreationsThisFrame;
+        unsigned long              mDeferredCreationFrame;
+        size_t                     mNumDeferredCreations;
+        bool                       mDeferredShaderCacheCreation;
+
     public:
         struct Library
         {
@@ -231,9 +253,49 @@ namespace Ogre
         typedef vector<Library>::type LibraryVec;
 
     protected:
+        /// Bitmask of the directive families found in a template file. The match is
+        /// conservative (i.e. a raw substring search), so a set bit may be a false positive
+        /// but an unset bit guarantees the corresponding parser pass would be a no-op.
+        enum TemplateDirectives
+        {
+            TemplateMath = 1u << 0u,         ///< \@pset, \@padd, etc
+            TemplateForEach = 1u << 1u,      ///< \@foreach
+            TemplateProperty = 1u << 2u,     ///< \@property
+            TemplateUndefPiece = 1u << 3u,   ///< \@undefpiece
+            TemplatePiece = 1u << 4u,        ///< \@piece
+            TemplateInsertPiece = 1u << 5u,  ///< \@insertpiece
+            TemplateCounter = 1u << 6u       ///< \@counter, \@value, \@set, etc
+        };
+
+        /// A template or piece file loaded from its Archive & scanned for directives once,
+        /// rather than every time a new shader variant is generated. The contents are still
+        /// parsed as text for every variant; only passes with nothing to do are skipped.
+        struct TemplateSource
+        {
+            String contents;
+            /// See TemplateDirectives
+            uint32 directives;
+            /// False if the Archive doesn't have this file
+            bool exists;
+
+            TemplateSource() : directives( 0u ), exists( false ) {}
+        };
+
+        typedef vector<TemplateSource>::type TemplateSourceVec;
+
         LibraryVec   mLibrary;
         Archive     *mDataFolder;
         StringVector mPieceFiles[NumShaderTypes];
+
+        /// Main template of each shader stage
+        TemplateSource mTemplateSources[NumShaderTypes];
+        /// Piece files of each shader stage matching mShaderFileExt.
+        /// Library pieces come first, then those from mDataFolder.
+        TemplateSourceVec mPieceSources[NumShaderTypes];
+        /// Whether mTemplateSources & mPieceSources are up to date. They're loaded
+        /// lazily on the first compileShaderCode and discarded by clearShaderCache
+        bool mTemplateSourcesLoaded;
+
         HlmsManager *mHlmsManager;
 
         LightGatheringMode mLightGatheringMode;
@@ -390,7 +452,31 @@ namespace Ogre
         const HlmsCache *getShaderCache( uint32 hash ) const;
         virtual void     clearShaderCache();
 
-        void processPieces( Archive *archive, const StringVector &pieceFiles );
+        /// Returns a mask of TemplateDirectives present in the given template contents.
+        /// This is a substring search, not a tokenizer: nothing else is cached.
+        static uint32 scanTemplateDirectives( const String &contents );
+        /// Populates mTemplateSources & mPieceSources from the archives if they aren't yet.
+        void loadTemplateSources();
+        void loadPieceSources( Archive *archive, const StringVector &pieceFiles,
+                               TemplateSourceVec &outSources ) const;
+
+        /** Runs the \@pset & co., \@foreach, \@property & \@undefpiece passes over source,
+            skipping those the source has no directives for.
+        @param tmpBuffer
+            Scratch buffer.
+        @param outBuffer [out]
+            Processed template.
+        @return
+            True if there were syntax errors.
+        */
+        bool parseTemplateSource( const TemplateSource &source, String &tmpBuffer,
+                                  String &outBuffer );
+
+        /** Runs each piece file through parseTemplateSource, collectPieces & parseCounter,
+            for their side effects (pieces defined, properties set). The text is reprocessed
+            for every shader variant; files without directives are skipped.
+        */
+        void processPieces( const TemplateSourceVec &pieceSources );
         void hashPieceFiles( Archive *archive, const StringVector &pieceFiles,
                              FastArray<uint8> &fileContents ) const;
 
@@ -532,6 +618,37 @@ namespace Ogre
         /// Returns true if shaders are being compiled with Fast Shader Build Hack (D3D11 only)
         bool getFastShaderBuildHack() const;
 
+        /** When enabled, RenderQueue won't wait for shaders & PSOs to be created the first time
+            a material & mesh combination is rendered. Instead the Renderable is skipped and its
+            shader cache entry is created later, spreading the creation across frames to
+            avoid stalls.
+        @remarks
+            Pending entries are created after the current pass has been executed, at most
+            maxCreationsPerFrame per frame. The Renderable won't be rendered until then.
+        @par
+            This only defers the work: shaders are still generated, compiled and turned into
+            PSOs on the render thread. Template parsing relies on the Hlms' state, and not all
+            APIs can compile in other threads.
+        @par
+            Objects rendered individually (i.e. RenderQueue::renderSingleObject) always
+            create the entry immediately.
+        @param bDeferred
+            True to postpone creating the entries. False to create them immediately.
+            Entries still pending are created the next time a pass is rendered.
+        @param maxCreationsPerFrame
+            Maximum number of entries that are created per frame. Must be > 0.
+        */
+        void setDeferredShaderCacheCreation( bool bDeferred, uint32 maxCreationsPerFrame = 1u );
+        bool getDeferredShaderCacheCreation() const { return mDeferredShaderCacheCreation; }
+
+        /// Returns the number of shader cache entries waiting to be created.
+        /// @see setDeferredShaderCacheCreation
+        size_t getNumPendingShaderCacheEntries() const { return mPendingShaderCacheEntries.size(); }
+
+        /// Returns the number of shader cache entries that were postponed and have been created.
+        /// @see setDeferredShaderCacheCreation
+        size_t getNumDeferredShaderCacheEntries() const { return mNumDeferredCreations; }
+
         /** Non-caster directional lights are hardcoded into shaders. This means that if you
             have 6 directional lights and then you add a 7th one, a whole new set of shaders
             will be created.
@@ -802,11 +919,37 @@ namespace Ogre
             should cast shadows)
         @param casterPass
             True if this pass is the shadow mapping caster pass, false otherwise
+        @param bAllowDeferred
+            When true and deferred creation is enabled (see setDeferredShaderCacheCreation)
+            a missing entry is postponed and a null pointer is returned.
         @return
-            Structure containing all necessary shaders
+            Structure containing all necessary shaders.
+            Null if bAllowDeferred is true and the entry isn't ready yet.
         */
         const HlmsCache *getMaterial( HlmsCache const *lastReturnedValue, const HlmsCache &passCache,
-                                      const QueuedRenderable &queuedRenderable, bool casterPass );
+                                      const QueuedRenderable &queuedRenderable, bool casterPass,
+                                      bool bAllowDeferred = false );
+
+        /** Same as getMaterial, but never creates the entry: returns null if it doesn't exist.
+            Can be called from multiple threads, as long as no entry is being created.
+        */
+        const HlmsCache *getMaterialIfCached( HlmsCache const *lastReturnedValue,
+                                              const HlmsCache &passCache,
+                                              const QueuedRenderable &queuedRenderable,
+                                              bool casterPass ) const;
+
+        /** Creates the shader cache entries that were postponed by getMaterial, within the limits
+            set by setDeferredShaderCacheCreation. Called by RenderQueue after executing a pass.
+        */
+        void _createPendingShaderCacheEntries();
+
+        /** Called when a Renderable is unlinked from one of our datablocks. Forgets about any
+            postponed shader cache entry that still references it.
+        @remarks
+            Derived classes that keep per-Renderable state (e.g. persistent instance slots)
+            can release it here. Overrides must call the base implementation.
+        */
+        virtual void _notifyRenderableUnlinked( Renderable *renderable );
 
         /** Fills the constant buffers. Gets executed right before drawing the mesh.
         @param cache
@@ -834,6 +977,82 @@ namespace Ogre
                                          const QueuedRenderable &queuedRenderable, bool casterPass,
                                          uint32 lastCacheHash, CommandBuffer *commandBuffer ) = 0;
 
+        /** Fills the buffers of a run of Renderables that share the HlmsCache and datablock
+            of the Renderable passed to the last fillBuffersForV2 call, which must have been
+            the one right before them.
+        @remarks
+            Implementations may fill as many as they can without adding commands to the
+            command buffer (e.g. they stop when the buffers are full, or when a Renderable
+            needs something only fillBuffersForV2 handles). The ones that were filled must not
+            be passed to fillBuffersForV2. The default implementation fills none.
+        @param outBaseInstances [out]
+            Array with room for numRenderables values. Receives what fillBuffersForV2 would
+            have returned for each of the filled Renderables.
+        @return
+            Number of Renderables filled, starting from the first one.
+        */
+        virtual size_t fillBuffersForV2Batch( const HlmsCache        *cache,
+                                              const QueuedRenderable *queuedRenderables,
+                                              size_t numRenderables, bool casterPass,
+                                              uint32 *outBaseInstances );
+
+        /// Returned by fillBuffersForV2Parallel when it can't fill the Renderable
+        static const uint32 ParallelFillStop;
+
+        /** Returns the max number of Renderables fillBuffersForV2Parallel can fill per segment,
+            or 0 if this Hlms can't fill in parallel, which is what the default does.
+        @remarks
+            When non-zero, RenderQueue may split large RQs whose Renderables all belong to this
+            Hlms into contiguous segments. Each segment is recorded into its own CommandBuffer by
+            one of the SceneManager's worker threads, and these get appended in order to the main
+            CommandBuffer afterwards. The calls happen in this order:
+                1. _beginParallelFill (main thread)
+                2. _beginParallelFillSegment for each segment (main thread)
+                3. fillBuffersForV2Parallel for the Renderables of each segment (worker threads)
+                4. _endParallelFill (main thread)
+        @par
+            Implementations that derive from one which supports it, but override
+            fillBuffersForV2, must override this function too.
+        */
+        virtual size_t getParallelFillMaxDraws( bool casterPass ) const;
+
+        /** Reserves a slice of the buffers fillBuffersForV2Parallel writes to, for each segment.
+        @param commandBuffer
+            The main CommandBuffer. Whatever fillBuffersForV2 left pending in it must be finished,
+            as the segments will be appended after it. Afterwards, fillBuffersForV2 must behave
+            as if the Hlms type had changed.
+        @param numDrawsPerSegment
+            Array with numSegments entries. None is greater than getParallelFillMaxDraws.
+        */
+        virtual void _beginParallelFill( CommandBuffer *commandBuffer, const size_t *numDrawsPerSegment,
+                                         size_t numSegments, bool casterPass );
+
+        /** Adds to the segment's CommandBuffer the commands fillBuffersForV2 adds when the
+            Hlms type changes, and binds the segment's slice.
+        @param queuedRenderable
+            First Renderable of the segment.
+        */
+        virtual void _beginParallelFillSegment( size_t segmentIdx,
+                                                const QueuedRenderable &queuedRenderable,
+                                                bool casterPass, CommandBuffer *commandBuffer );
+
+        /** Same as fillBuffersForV2, but writes to the slice of the given segment and only
+            tracks the state of that segment. Called from worker threads; a segment is always
+            filled by one thread at a time, and in order.
+        @return
+            What fillBuffersForV2 would return. ParallelFillStop if the Renderable can't be
+            filled (e.g. it doesn't fit in the slice), in which case nothing must have been
+            added to the CommandBuffer, and the rest of the segment will be filled by
+            fillBuffersForV2 after appending the segment to the main CommandBuffer.
+        */
+        virtual uint32 fillBuffersForV2Parallel( size_t segmentIdx, const HlmsCache *cache,
+                                                 const QueuedRenderable &queuedRenderable,
+                                                 bool casterPass, CommandBuffer *commandBuffer );
+
+        /// Finishes the commands of each segment's CommandBuffer and releases the slices.
+        /// Called before appending the segments to the main CommandBuffer.
+        virtual void _endParallelFill( CommandBuffer *const *segmentCommandBuffers );
+
         /// This gets called right before executing the command buffer.
         virtual void preCommandBufferExecution( CommandBuffer *commandBuffer ) {}
         /// This gets called after executing the command buffer.
@@ -985,6 +1204,7 @@ namespace Ogre
         static const IdString ForwardPlusFadeAttenRange;
         static const IdString ForwardPlusFineLightMask;
         static const IdString ForwardPlusCoversEntireTarget;
+        static const IdString ForwardPlusCompactGrid;
         static const IdString Forward3DNumSlices;
         static const IdString FwdClusteredWidthxHeight;
         static const IdString FwdClusteredWidth;
@@ -471,6 +471,11 @@ namespace Ogre
         /// Do not call this function aggressively (e.g. for lots of material every frame)
         virtual void preload();
 
+        /// Calls GpuResource::_touch on all of its textures, so that
+        /// TextureGpuManager's residency budget knows they're being used.
+        /// See TextureGpuManager::setResidencyBudget
+        virtual void _touchTextures( uint32 frameCount, float distanceToCamera );
+
         virtual bool hasCustomShadowMacroblock() const;
 
         /// Returns the closest match for a diffuse colour,
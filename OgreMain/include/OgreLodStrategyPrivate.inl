@@ -43,6 +43,10 @@ namespace Ogre
                     static_cast<uint8>( std::max<ptrdiff_t>( it - owner->mLodMesh->begin() - 1, 0 ) );
             }
 
+            // Drives the animation update rate. @see SkeletonInstance::setAnimationLodLevels
+            if( owner->mSkeletonInstance )
+                owner->mSkeletonInstance->_notifyLodValue( lodValues[j] );
+
             RenderableArray::iterator itor = owner->mRenderables.begin();
             RenderableArray::iterator end = owner->mRenderables.end();
 
@@ -76,6 +76,11 @@ namespace Ogre
         /// The default log to which output is done
         Log *mDefaultLog;
 
+        /// Protects mLogs and mDefaultLog. Unlike OGRE_AUTO_MUTEX it is never compiled out,
+        /// as worker threads log even when OGRE_CONFIG_THREADS is 0 (e.g. every Exception
+        /// thrown while ResourceGroupManager prepares scripts in parallel logs itself).
+        LightweightMutex mLogsMutex;
+
     public:
         OGRE_AUTO_MUTEX;  // public to allow external locking
 
@@ -252,12 +252,36 @@ namespace Ogre
     };
 }  // namespace Ogre
 
+#elif OGRE_MEMORY_ALLOCATOR == OGRE_MEMORY_ALLOCATOR_POOLED
+
+#    include "OgreMemoryPooledAlloc.h"
+namespace Ogre
+{
+    // Pooled allocator with per-thread caches. Categories aren't ignored here:
+    // the OGRE_MALLOC family of macros forwards them for statistics.
+    typedef PooledAllocPolicy AllocPolicy;
+
+    typedef AllocatedObject<PooledAllocPolicy> OgreAllocatedObj;
+
+    template <size_t align = 0>
+    class AlignAllocPolicy : public PooledAlignedAllocPolicy<align>
+    {
+    };
+}  // namespace Ogre
+
 #else
 
 // your allocators here?
 
 #endif
 
+#if OGRE_MEMORY_ALLOCATOR == OGRE_MEMORY_ALLOCATOR_POOLED
+/// Forwards the category given to the macros below to policies which make use of it
+#    define OGRE_ALLOC_CATEGORY( category ) , category
+#else
+#    define OGRE_ALLOC_CATEGORY( category )
+#endif
+
 #if OGRE_MEMORY_ALLOCATOR == OGRE_MEMORY_ALLOCATOR_NONE
 
 #    define OGRE_ALLOC_DEBUG_METADATA
@@ -324,7 +348,8 @@ namespace Ogre
 // PAIR 0
 /// Allocate space for one primitive type, external type or non-virtual type with constructor parameters
 #    define OGRE_NEW_T( T, category ) \
-        new( ::Ogre::AllocPolicy::allocateBytes( sizeof( T ) OGRE_ALLOC_DEBUG_METADATA ) ) T
+        new( ::Ogre::AllocPolicy::allocateBytes( sizeof( T ) OGRE_ALLOC_CATEGORY( category ) \
+                                                      OGRE_ALLOC_DEBUG_METADATA ) ) T
 
 #    define OGRE_DELETE_T( ptr, T, category ) \
         if( ptr ) \
@@ -336,7 +361,8 @@ namespace Ogre
 // PAIR 1
 #    define OGRE_NEW_ARRAY_T( T, count, category ) \
         ::Ogre::constructN( static_cast<T *>( ::Ogre::AllocPolicy::allocateBytes( \
-                                sizeof( T ) * (count)OGRE_ALLOC_DEBUG_METADATA ) ), \
+                                sizeof( T ) * ( count ) OGRE_ALLOC_CATEGORY( category ) \
+                                    OGRE_ALLOC_DEBUG_METADATA ) ), \
                             count )
 
 #    define OGRE_DELETE_ARRAY_T( ptr, T, count, category ) \
@@ -351,10 +377,12 @@ namespace Ogre
 
 // PAIR 2
 #    define OGRE_MALLOC( bytes, category ) \
-        ::Ogre::AllocPolicy::allocateBytes( bytes OGRE_ALLOC_DEBUG_METADATA )
+        ::Ogre::AllocPolicy::allocateBytes( bytes OGRE_ALLOC_CATEGORY( category ) \
+                                                OGRE_ALLOC_DEBUG_METADATA )
 
 #    define OGRE_ALLOC_T( T, count, category ) \
-        static_cast<T *>( ::Ogre::AllocPolicy::allocateBytes( sizeof( T ) * ( count ) ) )
+        static_cast<T *>( ::Ogre::AllocPolicy::allocateBytes( \
+            sizeof( T ) * ( count ) OGRE_ALLOC_CATEGORY( category ) ) )
 
 #    define OGRE_FREE( ptr, category ) ::Ogre::AllocPolicy::deallocateBytes( (void *)ptr )
 
@@ -372,11 +400,12 @@ namespace Ogre
 // PAIR SIMD
 /// Allocate a block of raw memory aligned to SIMD boundaries, and indicate the category of usage
 #define OGRE_MALLOC_SIMD( bytes, category ) \
-    ::Ogre::AlignAllocPolicy<>::allocateBytes( bytes OGRE_ALLOC_DEBUG_METADATA )
+    ::Ogre::AlignAllocPolicy<>::allocateBytes( bytes OGRE_ALLOC_CATEGORY( category ) \
+                                                   OGRE_ALLOC_DEBUG_METADATA )
 
 #define OGRE_ALLOC_T_SIMD( T, count, category ) \
-    static_cast<T *>( \
-        ::Ogre::AlignAllocPolicy<>::allocateBytes( sizeof( T ) * (count)OGRE_ALLOC_DEBUG_METADATA ) )
+    static_cast<T *>( ::Ogre::AlignAllocPolicy<>::allocateBytes( \
+        sizeof( T ) * ( count ) OGRE_ALLOC_CATEGORY( category ) OGRE_ALLOC_DEBUG_METADATA ) )
 
 /// Free the memory allocated with either OGRE_MALLOC_SIMD or OGRE_ALLOC_T_SIMD. Category is required to
 /// be restated to ensure the matching policy is used
@@ -385,7 +414,8 @@ namespace Ogre
 // PAIR Aligned
 /// Allocate a block of raw memory aligned to user defined boundaries, and indicate the category of usage
 #define OGRE_MALLOC_ALIGN( bytes, category, align ) \
-    ::Ogre::AlignAllocPolicy<align>::allocateBytes( bytes OGRE_ALLOC_DEBUG_METADATA )
+    ::Ogre::AlignAllocPolicy<align>::allocateBytes( bytes OGRE_ALLOC_CATEGORY( category ) \
+                                                        OGRE_ALLOC_DEBUG_METADATA )
 
 /// Free the memory allocated with either OGRE_MALLOC_ALIGN or OGRE_ALLOC_T_ALIGN. Category is required
 /// to be restated to ensure the matching policy is used
@@ -0,0 +1,219 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreMemoryPooledAlloc_H_
+#define _OgreMemoryPooledAlloc_H_
+
+#if OGRE_MEMORY_ALLOCATOR == OGRE_MEMORY_ALLOCATOR_POOLED
+
+#    include <limits>
+#    include <memory>
+
+#    include "OgreMemoryTracker.h"
+
+#    include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Memory
+     *  @{
+     */
+
+    /// Statistics of a single MemoryCategory. See PooledAllocPolicy::getCategoryStats
+    struct PooledAllocCategoryStats
+    {
+        /// Bytes requested by the application which haven't been freed yet
+        size_t liveBytes;
+        /// Highest value liveBytes reached since startup or the last call to resetPeakStats
+        size_t peakBytes;
+        /// Number of allocations which haven't been freed yet
+        size_t liveAllocations;
+        /// Number of allocations made since startup
+        size_t totalAllocations;
+    };
+
+    /** An allocation policy aimed at the many small, short lived allocations Ogre makes
+        every frame (FastArray, STL containers, light lists, render queues...) from
+        multiple worker threads.
+    @par
+        Requests of up to 32kb are rounded up to one of 44 size classes (16 byte steps up
+        to 256 bytes, then 4 steps per power of two). Each thread keeps its own free list
+        per size class, so allocating and freeing doesn't need any synchronization in the
+        common case. Blocks move between the thread caches and a shared pool in batches;
+        the shared pool carves new blocks out of 64kb chunks which are never returned to
+        the system. Larger requests go straight to the system allocator.
+    @par
+        Every allocation remembers its MemoryCategory, and live/peak byte counts are kept
+        per category. Threads publish their counters to the shared totals lazily (once
+        they drift by more than 64kb), thus the numbers returned by getCategoryStats may
+        lag slightly behind when multiple threads are allocating.
+    @remarks
+        Allocations coming from AllocatedObject and STLAllocator don't carry a category
+        and are accounted as MEMCATEGORY_GENERAL. The OGRE_MALLOC family of macros
+        forwards the category they were given.
+    */
+    class _OgreExport PooledAllocPolicy
+    {
+    public:
+        static DECL_MALLOC void *allocateBytes( size_t count, MemoryCategory category,
+#    if OGRE_MEMORY_TRACKER
+                                                const char *file = 0, int line = 0, const char *func = 0
+#    else
+                                                const char * = 0, int = 0, const char * = 0
+#    endif
+        );
+
+        static inline DECL_MALLOC void *allocateBytes( size_t count, const char *file = 0,
+                                                       int line = 0, const char *func = 0 )
+        {
+            return allocateBytes( count, MEMCATEGORY_GENERAL, file, line, func );
+        }
+
+        static void deallocateBytes( void *ptr );
+
+        /// Get the maximum size of a single allocation
+        static inline size_t getMaxAllocationSize() { return std::numeric_limits<size_t>::max(); }
+
+        /** Returns the live/peak statistics of the given category.
+        @remarks
+            Counters from the calling thread are always up to date. Other threads
+            may have up to 64kb per category which hasn't been published yet.
+        */
+        static PooledAllocCategoryStats getCategoryStats( MemoryCategory category );
+
+        /// Sets the peak of every category to its current live bytes
+        static void resetPeakStats();
+
+        /// Returns how many bytes the pool has obtained from the system for small blocks.
+        static size_t getReservedBytes();
+
+        /** Returns all the blocks cached by the calling thread to the shared pool, and
+            publishes its statistics.
+        @remarks
+            This happens automatically when a thread exits. Call it from worker threads
+            which are going to stay idle for a long time, so other threads can reuse
+            their blocks.
+        */
+        static void flushThreadCache();
+
+    private:
+        // no instantiation
+        PooledAllocPolicy() {}
+    };
+
+    /** @see PooledAllocPolicy
+    @note
+        Pooled blocks are already 16-byte aligned; larger alignments are achieved by
+        over-allocating.
+    */
+    template <size_t Alignment = 0>
+    class PooledAlignedAllocPolicy
+    {
+    public:
+        // compile-time check alignment is available.
+        typedef int
+            IsValidAlignment[Alignment <= 128 && ( ( Alignment & ( Alignment - 1 ) ) == 0 ) ? +1 : -1];
+
+        static inline DECL_MALLOC void *allocateBytes( size_t count, MemoryCategory category,
+#    if OGRE_MEMORY_TRACKER
+                                                       const char *file = 0, int line = 0,
+                                                       const char *func = 0
+#    else
+                                                       const char * = 0, int = 0, const char * = 0
+#    endif
+        )
+        {
+            const size_t alignment = Alignment ? Alignment : OGRE_SIMD_ALIGNMENT;
+            if( alignment <= 16u )
+            {
+                return PooledAllocPolicy::allocateBytes( count, category
+#    if OGRE_MEMORY_TRACKER
+                                                         ,
+                                                         file, line, func
+#    endif
+                );
+            }
+
+            uint8 *tmp = (uint8 *)PooledAllocPolicy::allocateBytes( count + alignment, category
+#    if OGRE_MEMORY_TRACKER
+                                                                    ,
+                                                                    file, line, func
+#    endif
+            );
+
+            // Align... The pool always returns 16-byte aligned memory, so
+            // there's always at least 16 bytes left to store the offset
+            uint8 *mem_block =
+                (uint8 *)( (size_t)( tmp + alignment - 1 ) & (size_t)( ~( alignment - 1 ) ) );
+            if( mem_block == tmp )
+                mem_block += alignment;
+
+            // How far are from the real start of our memory block?
+            *( mem_block - 1 ) = (uint8)( mem_block - tmp );
+
+            return (void *)mem_block;
+        }
+
+        static inline DECL_MALLOC void *allocateBytes( size_t count, const char *file = 0,
+                                                       int line = 0, const char *func = 0 )
+        {
+            return allocateBytes( count, MEMCATEGORY_GENERAL, file, line, func );
+        }
+
+        static inline void deallocateBytes( void *ptr )
+        {
+            const size_t alignment = Alignment ? Alignment : OGRE_SIMD_ALIGNMENT;
+            if( ptr && alignment > 16u )
+            {
+                uint8 *realAddress = (uint8 *)ptr;
+                realAddress -= *( realAddress - 1 );
+                ptr = realAddress;
+            }
+
+            PooledAllocPolicy::deallocateBytes( ptr );
+        }
+
+        /// Get the maximum size of a single allocation
+        static inline size_t getMaxAllocationSize() { return std::numeric_limits<size_t>::max(); }
+
+    private:
+        // No instantiation
+        PooledAlignedAllocPolicy() {}
+    };
+    /** @} */
+    /** @} */
+
+}  // namespace Ogre
+
+#    include "OgreHeaderSuffix.h"
+
+#endif
+
+#endif  // _OgreMemoryPooledAlloc_H_
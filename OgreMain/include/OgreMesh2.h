@@ -157,6 +157,10 @@ namespace Ogre
               VaoManager *vaoManager, bool isManual = false, ManualResourceLoader *loader = 0 );
         ~Mesh() override;
 
+        /// Sets the data prepareImpl would've read from disk. Used by MeshManager::loadAsync,
+        /// which reads the file from a worker thread.
+        void _setFreshFromDisk( const DataStreamPtr &stream ) { mFreshFromDisk = stream; }
+
         // NB All methods below are non-virtual since they will be
         // called in the rendering loop - speed is of the essence.
 
@@ -94,6 +94,9 @@ namespace Ogre
             uint32               numVertices;
             VertexElement2VecVec vertexDeclarations;
             Uint8Vec             vertexBuffers;
+            /// When true, vertexBuffers point directly into the DataStream's memory
+            /// (see DataStream::getCurrentReadPtr) and must not be freed.
+            bool                 vertexBuffersInStream;
             uint8                lodSource;
             bool                 index32Bit;
             uint32               numIndices;
@@ -33,8 +33,13 @@ THE SOFTWARE.
 #include "OgreResourceManager.h"
 #include "OgreSingleton.h"
 #include "OgreVector3.h"
+#include "Threading/OgreLightweightMutex.h"
+#include "Threading/OgreThreads.h"
+#include "Threading/OgreWaitableEvent.h"
 #include "Vao/OgreBufferPacked.h"
 
+#include <atomic>
+
 #include "OgreHeaderPrefix.h"
 
 namespace Ogre
@@ -67,6 +72,37 @@ namespace Ogre
         // the factor by which the bounding box of an entity is padded
         Real mBoundsPaddingFactor;
 
+        struct AsyncMeshLoad
+        {
+            MeshPtr mesh;
+            /// Resolved from the main thread, the worker only opens the file.
+            Archive *archive;
+            /// Filled by the worker thread
+            DataStreamPtr data;
+            /// Filled by the worker thread if reading failed
+            String errorDescription;
+        };
+        typedef vector<AsyncMeshLoad>::type AsyncMeshLoadVec;
+
+        /// Meshes waiting for the worker thread to read them. Protected by mAsyncLoadMutex
+        AsyncMeshLoadVec mAsyncLoadRequests;
+        /// Meshes read by the worker, waiting to be loaded from the main thread.
+        /// Protected by mAsyncLoadMutex
+        AsyncMeshLoadVec mAsyncLoadsReady;
+        LightweightMutex mAsyncLoadMutex;
+        WaitableEvent    mAsyncWorkerWaitableEvent;
+        ThreadHandlePtr   mAsyncWorkerThread;
+        std::atomic<bool> mAsyncWorkerShuttingDown;
+        /// Requested via loadAsync, not yet loaded. Only accessed from the main thread
+        size_t mNumAsyncLoadsPending;
+        /// See setAsyncUploadBudget
+        size_t mAsyncUploadBudget;
+
+        void stopAsyncWorker();
+
+        /// Removes the request for the given mesh, if any. Caller must hold mAsyncLoadMutex
+        static bool removeAsyncLoad( AsyncMeshLoadVec &asyncLoads, const Mesh *mesh );
+
     public:
         MeshManager();
         ~MeshManager() override;
@@ -161,6 +197,58 @@ namespace Ogre
                       BufferType indexBufferType = BT_IMMUTABLE, bool vertexBufferShadowed = true,
                       bool indexBufferShadowed = true );
 
+        /** Same as load, but returns immediately. The file is read from a worker thread, and
+            the mesh is loaded (i.e. its GPU buffers created & uploaded) from the main thread
+            during the following frames, honouring setAsyncUploadBudget.
+        @remarks
+            Items can be created from the returned mesh right away. They'll stay empty
+            (nothing to render) and become visible once the mesh is loaded.
+        @par
+            While loading, the mesh is marked as background loaded. Calling Mesh::load won't
+            load it; use isAsyncLoadPending / waitForAsyncLoads if you need it right now.
+        @par
+            If the mesh was already created (prepared or loaded), or is being loaded
+            asynchronously already, the existing instance is returned.
+        */
+        MeshPtr loadAsync( const String &filename, const String &groupName,
+                           BufferType vertexBufferType = BT_IMMUTABLE,
+                           BufferType indexBufferType = BT_IMMUTABLE, bool vertexBufferShadowed = true,
+                           bool indexBufferShadowed = true );
+
+        /// Returns true if there are meshes requested via loadAsync that haven't been loaded yet.
+        bool isAsyncLoadPending() const { return mNumAsyncLoadsPending != 0u; }
+
+        /// Blocks until all meshes requested via loadAsync are loaded, ignoring the upload budget.
+        void waitForAsyncLoads();
+
+        /** Cancels a load requested via loadAsync. The mesh is left unloaded, and can be
+            loaded again (synchronously or not).
+        @remarks
+            If the worker thread is reading the file right now, blocks until it's done.
+        @return
+            False if the mesh had no async load pending (e.g. it finished loading already).
+        */
+        bool cancelAsyncLoad( Mesh *mesh );
+
+        /** Sets how many bytes worth of mesh data may be loaded per frame by _updateAsyncLoads.
+            At least one mesh is always loaded per frame (if one is ready), even if it's
+            bigger than the budget.
+        @param bytesPerFrame
+            0 for no limit. Default is 16MB.
+        */
+        void   setAsyncUploadBudget( size_t bytesPerFrame ) { mAsyncUploadBudget = bytesPerFrame; }
+        size_t getAsyncUploadBudget() const { return mAsyncUploadBudget; }
+
+        /** Loads the meshes that finished reading in the worker thread, notifying their
+            listeners (e.g. Items). Called by Root once per frame.
+        @param bytesBudget
+            See setAsyncUploadBudget. 0 for no limit.
+        */
+        void _updateAsyncLoads( size_t bytesBudget );
+
+        /// Worker thread entry point. Do not call directly.
+        unsigned long _updateAsyncWorkerThread( ThreadHandle *threadHandle );
+
 #if OGRE_COMPILER == OGRE_COMPILER_CLANG
 #    pragma clang diagnostic pop
 #endif
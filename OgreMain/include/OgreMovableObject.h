@@ -134,7 +134,9 @@ namespace Ogre
         static uint32 msDefaultLightMask;
 
     protected:
-        Aabb  updateSingleWorldAabb();
+        /// @param bGrowCullingHierarchy
+        ///     See _getWorldAabbUpdatedGrowHierarchy
+        Aabb  updateSingleWorldAabb( bool bGrowCullingHierarchy = false );
         float updateSingleWorldRadius();
 
     public:
@@ -284,6 +286,27 @@ namespace Ogre
                                  uint32 sceneVisibilityFlags, MovableObjectArray &outCulledObjects,
                                  const Camera *lodCamera );
 
+        /** Same as cullFrustum, but tests each object against multiple frustums at once,
+            i.e. loading its AABB only once. Used to cull all the shadow maps of a
+            CompositorShadowNode in a single pass. See SceneManager::_cullShadowCastersBatched
+        @remarks
+            Only shadow casters are considered. Unlike cullFrustum, scene & viewport visibility
+            flags are not tested, and distance to camera is not calculated. The caller must
+            do it when consuming the results (see _updateCachedDistanceToCamera).
+        @param frustumPlanes
+            Array of numFrustums * 6 planes to clip against, as in Frustum::getFrustumPlanes.
+        @param outCulledObjects
+            Array of numFrustums lists. Objects visible by the i-th frustum are pushed
+            to outCulledObjects[i].
+        */
+        static void cullFrustumBatched( const size_t numNodes, ObjectData t, const Plane *frustumPlanes,
+                                        size_t numFrustums, MovableObjectArray *const *outCulledObjects,
+                                        const Camera *lodCamera );
+
+        /// Calculates the distance to the camera the same way cullFrustum does, for this object only.
+        /// See getCachedDistanceToCamera
+        void _updateCachedDistanceToCamera( const Camera *camera );
+
         /// @see InstancingTheadedCullingMethod, @see InstanceBatch::instanceBatchCullFrustumThreaded
         virtual void instanceBatchCullFrustumThreaded( const Frustum *frustum, const Camera *lodCamera,
                                                        uint32 combinedVisibilityFlags )
@@ -455,6 +478,13 @@ namespace Ogre
         */
         Aabb getWorldAabbUpdated();
 
+        /** Same as getWorldAabbUpdated, but instead of flagging the culling hierarchy as out of
+            date, grows the cluster this object belongs to so it can still be used for culling.
+            Main thread only, and never while culling.
+            @see ObjectMemoryManager::_growCullingHierarchy
+        */
+        Aabb _getWorldAabbUpdatedGrowHierarchy();
+
         /// See getLocalAabb and getWorldRadius
         float getLocalRadius() const;
 
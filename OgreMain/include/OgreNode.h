@@ -254,6 +254,12 @@ namespace Ogre
         /// Returns a direct access to the Transform state
         Transform &_getTransform() { return mTransform; }
 
+        /** Flags our derived transform (and our children's) for recalculation in the next
+            SceneManager::updateAllTransforms. All setters already do this; only needed
+            when modifying the data returned by _getTransform directly.
+        */
+        void _markTransformDirty() { mTransform.mDirty[mTransform.mIndex] = true; }
+
         /// Called by SceneManager when it is telling we're a static node being dirty
         /// Don't call this directly. @see SceneManager::notifyStaticDirty
         virtual void _notifyStaticDirty() const;
@@ -708,6 +714,10 @@ namespace Ogre
         /** @see SceneManager::updateAllTransforms()
         @remarks
             We don't pass by reference on purpose (avoid implicit aliasing)
+        @par
+            Packs where neither the nodes nor their parents are dirty are skipped.
+            Updated nodes stay dirty so their children get updated in the next depth;
+            the caller must clear the flags afterwards (NodeMemoryManager::_clearDirtyFlags).
         */
         static void updateAllTransforms( const size_t numNodes, Transform t );
 
@@ -487,7 +487,10 @@ THE SOFTWARE.
 #endif
 
 // Find perfect alignment (should supports SIMD alignment if SIMD available)
-#if OGRE_CPU == OGRE_CPU_X86
+#if OGRE_CPU == OGRE_CPU_X86 && OGRE_USE_SIMD == 1 && OGRE_USE_SIMD_AVX == 1 && \
+    OGRE_DOUBLE_PRECISION == 0
+#    define OGRE_SIMD_ALIGNMENT 32
+#elif OGRE_CPU == OGRE_CPU_X86
 #    define OGRE_SIMD_ALIGNMENT 16
 #else
 #    define OGRE_SIMD_ALIGNMENT 16
@@ -500,6 +503,10 @@ THE SOFTWARE.
 // Define whether or not Ogre compiled with SSE support.
 #    if OGRE_DOUBLE_PRECISION == 0 && OGRE_CPU == OGRE_CPU_X86
 #        define __OGRE_HAVE_SSE 1
+// Define whether or not Ogre compiled with AVX2 + FMA support (8-wide Math/Array).
+#        if OGRE_USE_SIMD_AVX == 1
+#            define __OGRE_HAVE_AVX 1
+#        endif
 #    endif
 
 // Define whether or not Ogre compiled with NEON support.
@@ -514,6 +521,10 @@ THE SOFTWARE.
 #    define __OGRE_HAVE_SSE 0
 #endif
 
+#ifndef __OGRE_HAVE_AVX
+#    define __OGRE_HAVE_AVX 0
+#endif
+
 #if OGRE_USE_SIMD == 0 || !defined( __OGRE_HAVE_NEON )
 #    define __OGRE_HAVE_NEON 0
 #endif
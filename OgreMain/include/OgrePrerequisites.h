@@ -178,6 +178,7 @@ namespace Ogre
     class Forward3D;
     class ForwardClustered;
     class ForwardPlusBase;
+    class FrameArena;
     struct FrameEvent;
     class FrameListener;
     class Frustum;
@@ -32,6 +32,7 @@ THE SOFTWARE.
 
 #include "OgreHlmsCommon.h"
 #include "OgreIteratorWrappers.h"
+#include "OgreRadixSort.h"
 #include "OgreSharedPtr.h"
 
 #include "OgreHeaderPrefix.h"
@@ -40,6 +41,9 @@ namespace Ogre
 {
     class Camera;
     class MovableObject;
+    class VertexArrayObject;
+    struct CbDrawCall;
+    struct CbSharedDraw;
 
     /** \addtogroup Core
      *  @{
@@ -65,6 +69,92 @@ namespace Ogre
         bool operator<( const QueuedRenderable &_r ) const { return this->hash < _r.hash; }
     };
 
+    /** Order-insensitive fingerprint of a set of QueuedRenderables.
+    @remarks
+        Two sets holding the same QueuedRenderables (same Renderable, MovableObject and hash)
+        have the same fingerprint regardless of the order they were added in, or of how they
+        were split across threads. Used by RenderQueue::setSortTemporalCoherence.
+    @par
+        Each QueuedRenderable is mixed into a 64-bit value; the fingerprint keeps two
+        differently mixed sums of those plus the count. Sums are commutative, thus
+        the order doesn't matter.
+    @par
+        Different sets may collide. Matching fingerprints must be confirmed with a
+        QueuedRenderableSet before relying on them.
+    */
+    struct _OgreExport QueuedRenderableFingerprint
+    {
+        size_t numRenderables;
+        uint64 sum0;
+        uint64 sum1;
+
+        QueuedRenderableFingerprint() : numRenderables( 0 ), sum0( 0 ), sum1( 0 ) {}
+
+        void add( const QueuedRenderable *begin, const QueuedRenderable *end );
+
+        bool operator==( const QueuedRenderableFingerprint &other ) const
+        {
+            return numRenderables == other.numRenderables && sum0 == other.sum0 &&
+                   sum1 == other.sum1;
+        }
+        bool operator!=( const QueuedRenderableFingerprint &other ) const
+        {
+            return !( *this == other );
+        }
+    };
+
+    /** Exact, order-insensitive copy of a set of QueuedRenderables (a multiset, actually:
+        the same entry may be added more than once).
+    @remarks
+        Entries are kept in an open addressing hash table, so checking whether another
+        set has the same contents costs O(n) regardless of the order either was added in.
+        Used by RenderQueue::setSortTemporalCoherence to confirm that a matching
+        QueuedRenderableFingerprint isn't a collision.
+    */
+    class _OgreExport QueuedRenderableSet
+    {
+        struct Slot
+        {
+            QueuedRenderable key;
+            /// Times key was added. 0 if the slot is empty
+            uint32 count;
+            /// Times key was found by match since the last call to resetMatches
+            uint32 matched;
+        };
+
+        typedef vector<Slot>::type SlotVec;
+
+        SlotVec mSlots;
+        size_t  mNumRenderables;
+        size_t  mNumMatched;
+
+        Slot *findSlot( const QueuedRenderable &queuedRenderable );
+
+    public:
+        QueuedRenderableSet() : mNumRenderables( 0 ), mNumMatched( 0 ) {}
+
+        /// Empties the set, making room for numRenderables entries
+        void reset( size_t numRenderables );
+
+        /// Adds entries to the set. No more than the number passed to reset may be added.
+        void add( const QueuedRenderable *begin, const QueuedRenderable *end );
+
+        /// Forgets about the entries found by previous calls to match
+        void resetMatches();
+
+        /** Finds each entry in [begin; end) in the set. Each entry of the set can only
+            be found once per call to resetMatches (or as many times as it was added).
+        @return
+            False if an entry isn't in the set, or it was already found.
+        */
+        bool match( const QueuedRenderable *begin, const QueuedRenderable *end );
+
+        /// Returns true if every entry of the set was found by match since resetMatches
+        bool allMatched() const { return mNumMatched == mNumRenderables; }
+
+        size_t size() const { return mNumRenderables; }
+    };
+
     /** Class to manage the scene object rendering queue.
         @remarks
             Objects are grouped by material to minimise rendering state changes. The map from
@@ -125,11 +215,23 @@ namespace Ogre
             DisableSort,
             NormalSort,
             StableSort,
+            /// Radix sorts the Renderables added by each thread in parallel using the
+            /// SceneManager's worker threads, then merges the results.
+            /// Renderables with the same hash keep the order they were added in each thread.
+            /// Recommended for RQs with thousands of Renderables.
+            ParallelRadixSort,
         };
 
     private:
         typedef FastArray<QueuedRenderable> QueuedRenderableArray;
 
+        struct QueuedRenderableHash
+        {
+            uint64 operator()( const QueuedRenderable &qr ) const { return qr.hash; }
+        };
+
+        typedef RadixSort<QueuedRenderableArray, QueuedRenderable, uint64> QueuedRenderableRadixSort;
+
         struct ThreadRenderQueue
         {
             QueuedRenderableArray q;
@@ -139,17 +241,117 @@ namespace Ogre
 
         typedef FastArray<ThreadRenderQueue> QueuedRenderableArrayPerThread;
 
+        /// Sorting results of a RQ from the last frame a camera was rendered.
+        /// @see setSortTemporalCoherence
+        struct SortCache
+        {
+            Camera const               *camera;
+            unsigned long               lastFrame;
+            QueuedRenderableFingerprint input;
+            /// Confirms that matching fingerprints really have the same contents
+            QueuedRenderableSet inputSet;
+            /// std::vector rather than QueuedRenderableArray, so that
+            /// SortCacheVec moves SortCaches instead of copying them.
+            vector<QueuedRenderable>::type sorted;
+
+            SortCache() : camera( 0 ), lastFrame( 0 ) {}
+        };
+
+        typedef vector<SortCache>::type SortCacheVec;
+
         struct RenderQueueGroup
         {
             QueuedRenderableArrayPerThread mQueuedRenderablesPerThread;
             QueuedRenderableArray          mQueuedRenderables;
             RqSortMode                     mSortMode;
             bool                           mSorted;
+            bool                           mSortTemporalCoherence;
             Modes                          mMode;
+            SortCacheVec                   mSortCaches;
+
+            RenderQueueGroup() :
+                mSortMode( NormalSort ),
+                mSorted( false ),
+                mSortTemporalCoherence( false ),
+                mMode( FAST )
+            {
+            }
+        };
+
+        typedef vector<QueuedRenderableRadixSort>::type QueuedRenderableRadixSortVec;
+
+        /// Data of a QueuedRenderable needed by renderGL3 that doesn't depend on the
+        /// previous draws, thus can be gathered by multiple threads. @see prepareDraws
+        struct PreparedDraw
+        {
+            VertexArrayObject   *vao;
+            HlmsDatablock const *datablock;
+            /// Renderable's Hlms hash for the pass (caster or regular). Draws sharing it and
+            /// the datablock share the HlmsCache. @see Hlms::fillBuffersForV2Batch
+            uint32 hlmsHash;
+            /// Only filled when mPrepareResolveCaches is set. Null if the shader cache entry
+            /// didn't exist yet. @see Hlms::getMaterialIfCached
+            HlmsCache const *hlmsCache;
+        };
+
+        typedef FastArray<PreparedDraw> PreparedDrawArray;
+
+        struct ThreadPrepareMetrics
+        {
+            size_t faceCount;
+            size_t vertexCount;
+            /// Bit N is set if a datablock of HlmsTypes N was found
+            uint32 hlmsTypeMask;
+            /// Number of PreparedDraw::hlmsCache left null
+            size_t numCacheMisses;
+            /// The padding prevents false cache sharing when multithreading.
+            uint8 padding[128];
+        };
+
+        typedef FastArray<ThreadPrepareMetrics> ThreadPrepareMetricsArray;
+
+        /// State of the draw commands being recorded by renderGL3. @see addDrawCommand
+        struct DrawCommandState
+        {
+            CommandBuffer        *commandBuffer;
+            IndirectBufferPacked *indirectBuffer;
+            unsigned char const  *startIndirectDraw;
+            unsigned char        *indirectDraw;
+
+            int    baseInstanceAndIndirectBuffers;
+            uint32 instancesPerDraw;
+            uint32 baseInstanceShift;
+
+            CbDrawCall        *drawCmd;
+            CbSharedDraw      *drawCountPtr;
+            VertexArrayObject *lastVao;
+            uint32             lastVaoName;
+            uint32             instanceCount;
+
+            /// Added to RenderingMetrics::mDrawCount & mInstanceCount
+            size_t numDraws;
+            size_t numInstances;
+        };
+
+        /// Range of the RQ whose commands are recorded by a worker thread into its own
+        /// CommandBuffer. @see Hlms::getParallelFillMaxDraws
+        struct ParallelFillSegment
+        {
+            size_t begin;
+            size_t end;
+            /// The Hlms stopped at this draw. [parallelEnd; end) is recorded by the main thread
+            size_t parallelEnd;
+            /// First draw with a valid HlmsCache. Its PSO is set by the main thread.
+            size_t firstDraw;
 
-            RenderQueueGroup() : mSortMode( NormalSort ), mSorted( false ), mMode( FAST ) {}
+            DrawCommandState state;
+
+            /// The padding prevents false cache sharing when multithreading.
+            uint8 padding[64];
         };
 
+        typedef FastArray<ParallelFillSegment> ParallelFillSegmentArray;
+
         typedef vector<IndirectBufferPacked *>::type IndirectBufferPackedVec;
 
         RenderQueueGroup mRenderQueues[256];
@@ -173,6 +375,81 @@ namespace Ogre
 
         uint32 mRenderingStarted;
 
+        /// One per worker thread. @see ParallelRadixSort
+        QueuedRenderableRadixSortVec mRadixSorters;
+        /// Per-thread arrays to be sorted by the worker threads. @see ParallelRadixSort
+        FastArray<QueuedRenderableArray *> mPendingRadixSorts;
+
+        /// One per QueuedRenderable of the RQ being rendered by renderGL3
+        PreparedDrawArray         mPreparedDraws;
+        ThreadPrepareMetricsArray mPrepareMetricsPerThread;
+        QueuedRenderable const   *mPrepareSrc;
+        HlmsCache const          *mPreparePassCache;
+        bool                      mPrepareCasterPass;
+        bool                      mPrepareResolveCaches;
+        uint32                    mPrepareInstancesPerDraw;
+
+        ParallelFillSegmentArray   mParallelFillSegments;
+        FastArray<CommandBuffer *> mParallelFillCommandBuffers;
+        Hlms                      *mParallelFillHlms;
+
+        /// Output of Hlms::fillBuffersForV2Batch, consumed by renderGL3
+        FastArray<uint32> mBatchedBaseInstances;
+
+        /** Fills mPreparedDraws for all the Renderables in the RQ, using the worker threads
+            when there are enough of them. This takes the pointer chasing across Renderables,
+            MovableObjects and Vaos out of the main thread, leaving it the work that must be
+            serialized (Hlms::getMaterial, Hlms::fillBuffersForV2 and the draw commands).
+        @param outStats
+            Face and vertex counts are added to it.
+        */
+        void prepareDraws( const QueuedRenderableArray &queuedRenderables, bool casterPass,
+                           uint32 instancesPerDraw, RenderingMetrics &outStats );
+
+        /// Adds the draw to the indirect buffer, and a new draw command if it can't be
+        /// merged with the previous one.
+        FORCEINLINE static void addDrawCommand( DrawCommandState &state, VertexArrayObject *vao,
+                                                uint32 baseInstance );
+
+        /// Records [begin; end) of the RQ on the calling thread
+        void renderGL3Serial( DrawCommandState &state, bool casterPass, HlmsCache passCache[],
+                              const QueuedRenderableArray &queuedRenderables, size_t begin,
+                              size_t end );
+
+        /** Records the RQ splitting it in segments, each one recorded by a worker thread
+            into its own CommandBuffer; then appends them in order to mCommandBuffer.
+            The Hlms fills its own slice of the const & tex. buffers for each segment.
+            @see Hlms::getParallelFillMaxDraws
+        @param state
+            Must have been initialized for mCommandBuffer.
+        */
+        void renderGL3Parallel( DrawCommandState &state, bool casterPass, HlmsCache passCache[],
+                                const QueuedRenderableArray &queuedRenderables );
+
+        /// Sorts the RQ if it hasn't been sorted yet. Returns false if this can't be done until
+        /// the per-thread arrays in mPendingRadixSorts are sorted. @see mergeSortedPerThread
+        bool sortRenderQueue( uint8 rqId );
+        /// Sorts all the RQs in [firstRq; lastRq)
+        void sortRenderQueues( uint8 firstRq, uint8 lastRq );
+        /// Calls HlmsDatablock::_touchTextures for all the Renderables in [firstRq; lastRq)
+        /// Must be called after sorting. See TextureGpuManager::setResidencyBudget
+        void touchTextures( uint8 firstRq, uint8 lastRq );
+        /// Merges the sorted per-thread arrays into mQueuedRenderables
+        void mergeSortedPerThread( RenderQueueGroup &renderQueueGroup );
+        /// Returns the sorting results of the camera being rendered, and forgets about
+        /// cameras that haven't been rendered in a while. @see setSortTemporalCoherence
+        SortCache *findSortCache( RenderQueueGroup &renderQueueGroup, bool bCreate );
+        /// Looks for the sorting results of the camera being rendered from the last frame.
+        /// Returns true if the RQ has the same contents (in any order, added by any thread),
+        /// in which case those are reused.
+        bool reuseLastSort( RenderQueueGroup &renderQueueGroup,
+                            const QueuedRenderableFingerprint &fingerprint, size_t numRenderables );
+        /// Saves the fingerprint and a copy of the contents of the RQ. @see reuseLastSort
+        void saveLastSortInput( RenderQueueGroup &renderQueueGroup,
+                                const QueuedRenderableFingerprint &fingerprint, size_t numRenderables );
+        /// Saves the sorted contents of the RQ. @see saveLastSortInput
+        void saveLastSortResults( RenderQueueGroup &renderQueueGroup );
+
         /** Returns a new (or an existing) indirect buffer that can hold the requested number of draws.
         @param numDraws
             Number of draws the indirect buffer is expected to hold. It must be an upper limit.
@@ -205,6 +482,17 @@ namespace Ogre
         /// Empty the queue - should only be called by SceneManagers.
         void clear();
 
+        /// Radix sorts the per-thread arrays [begin; end) of mPendingRadixSorts.
+        /// Called from worker threads. @see ParallelRadixSort
+        void _radixSortPending( size_t begin, size_t end, size_t threadIdx );
+
+        /// Fills [begin; end) of mPreparedDraws. Called from worker threads. @see prepareDraws
+        void _prepareDraws( size_t begin, size_t end, size_t threadIdx );
+
+        /// Records the segments [begin; end) of mParallelFillSegments.
+        /// Called from worker threads. @see renderGL3Parallel
+        void _recordParallelFillSegments( size_t begin, size_t end, size_t threadIdx );
+
         /** The RenderQueue keeps track of API state to avoid redundant state change passes
             Calling this function forces the RenderQueue to re-set the Macro- & Blendblocks,
             shaders, and any other API dependendant calls on the next render.
@@ -294,6 +582,26 @@ namespace Ogre
         */
         void       setSortRenderQueue( uint8 rqId, RqSortMode sortMode );
         RqSortMode getSortRenderQueue( uint8 rqId ) const;
+
+        /** Exploits temporal coherence across frames when sorting the render queue ID.
+        @remarks
+            The contents and sorting results of the RQ are remembered per camera. If the
+            next frame the same camera adds the same Renderables with the same hashes, the
+            last sorting results are reused instead of sorting again. The order in which
+            they were added (and by which worker thread) doesn't matter.
+            This is common for cameras looking at static geometry (e.g. static shadow maps).
+        @par
+            The hash includes the distance to the camera, so a camera that moves (or looks
+            at moving objects) will rarely benefit from this.
+        @par
+            It costs memory proportional to the number of Renderables per camera, and a copy
+            of the input and of the sorted RQ when the contents changed. A hit costs O(n):
+            the contents are compared entry by entry (in any order) before reusing the
+            results. Ignored if the sort mode is DisableSort.
+            @see QueuedRenderableFingerprint, QueuedRenderableSet
+        */
+        void setSortTemporalCoherence( uint8 rqId, bool bTemporalCoherence );
+        bool getSortTemporalCoherence( uint8 rqId ) const;
     };
 
 #define OGRE_RQ_MAKE_MASK( x ) ( ( 1 << ( x ) ) - 1 )
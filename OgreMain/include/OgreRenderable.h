@@ -480,6 +480,13 @@ namespace Ogre
     public:
         uint32 mHlmsGlobalIndex;
 
+        /** Slot in the Hlms implementation's persistent instance buffer for static objects
+            (see HlmsPbs::setStaticInstanceCache). std::numeric_limits<uint32>::max() if none.
+        @remarks
+            Despite being public, Do NOT modify it manually.
+        */
+        uint32 mHlmsStaticInstanceSlot;
+
     public:
         /** Control visibility at Renderable (e.g. SubMesh) level
 
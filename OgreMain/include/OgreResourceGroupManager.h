@@ -291,6 +291,18 @@ namespace Ogre
         /// List of possible file locations
         typedef list<ResourceLocation *>::type LocationList;
 
+        /// How long it took to parse a script. See getScriptTimings
+        struct ScriptTiming
+        {
+            String scriptName;
+            /// Time spent in ScriptLoader::prepareScript, in microseconds.
+            /// It may have been spent in a worker thread.
+            uint64 prepareTime;
+            /// Time spent in ScriptLoader::parseScript or parsePreparedScript, in microseconds.
+            uint64 parseTime;
+        };
+        typedef vector<ScriptTiming>::type ScriptTimingVec;
+
     protected:
         /// Map of resource types (strings) to ResourceManagers, used to notify them to load / unload
         /// group contents
@@ -305,6 +317,12 @@ namespace Ogre
 
         ResourceLoadingListener *mLoadingListener;
 
+        /// See setNumScriptParsingThreads
+        size_t mNumScriptParsingThreads;
+        /// In microseconds. See setSlowScriptThreshold
+        uint64          mSlowScriptThreshold;
+        ScriptTimingVec mScriptTimings;
+
         /// Resource index entry, resourcename->location
         typedef map<String, Archive *>::type ResourceLocationIndex;
 
@@ -360,6 +378,14 @@ namespace Ogre
             Called as part of initialiseResourceGroup
         */
         void parseResourceGroupScripts( ResourceGroup *grp );
+        /** Opens a script and notifies the loading listener.
+        @param bMemoryCopy
+            When true, the whole script is read into a MemoryDataStream.
+            Always true for small scripts in FileSystem archives.
+        */
+        DataStreamPtr openScript( const FileInfo &fileInfo, ResourceGroup *grp, bool bMemoryCopy );
+        /// Records how long parsing a script took, logging it if it exceeds mSlowScriptThreshold
+        void addScriptTiming( const String &scriptName, uint64 prepareTime, uint64 parseTime );
         /** Create all the pre-declared resources.
         @remarks
             Called as part of initialiseResourceGroup
@@ -1019,6 +1045,37 @@ namespace Ogre
         /// Returns the current loading listener
         ResourceLoadingListener *getLoadingListener();
 
+        /** Sets the number of threads used to prepare scripts (e.g. lex & parse them) in
+            initialiseResourceGroup. Translating the scripts into resources is always done
+            from the calling thread, in the usual order.
+        @remarks
+            Only ScriptLoaders that return true in supportsPreparedScripts benefit from it.
+        @par
+            When using more than one thread, ResourceGroupListener::scriptParseStarted is fired
+            for all the scripts in the group before any of them is opened, so that skipped
+            scripts are neither opened nor prepared. Then the remaining scripts are opened
+            (firing ResourceLoadingListener::resourceStreamOpened) and prepared, and finally
+            parsed one by one, firing ResourceGroupListener::scriptParseEnded after each.
+            With a single thread each scriptParseStarted is immediately followed by
+            parsing that script and its scriptParseEnded.
+        @param numThreads
+            Total number of threads, including the calling one.
+            0 or 1 means scripts are parsed one by one, from the calling thread (default).
+        */
+        void   setNumScriptParsingThreads( size_t numThreads ) { mNumScriptParsingThreads = numThreads; }
+        size_t getNumScriptParsingThreads() const { return mNumScriptParsingThreads; }
+
+        /** Scripts that take longer than the given threshold to parse get logged.
+        @param microseconds
+            0 to disable (default).
+        */
+        void   setSlowScriptThreshold( uint64 microseconds ) { mSlowScriptThreshold = microseconds; }
+        uint64 getSlowScriptThreshold() const { return mSlowScriptThreshold; }
+
+        /// Returns how long it took to parse each script in the last call to initialiseResourceGroup
+        /// (or initialiseAllResourceGroups), in the order they were parsed.
+        const ScriptTimingVec &getScriptTimings() const { return mScriptTimings; }
+
         /** Override standard Singleton retrieval.
         @remarks
         Why do we do this? Well, it's because the Singleton
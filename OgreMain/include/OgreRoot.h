@@ -113,6 +113,7 @@ namespace Ogre
         LodStrategyManager              *mLodStrategyManager;
 
         FrameStats                   *mFrameStats;
+        FrameArena                   *mFrameArena;
         Timer                        *mTimer;
         Window                       *mAutoWindow;
         Profiler                     *mProfiler;
@@ -529,6 +530,12 @@ namespace Ogre
 
         const FrameStats *getFrameStats() const { return mFrameStats; }
 
+        /** Arena for transient allocations which only need to live for a few frames.
+            It cycles to the next frame at the end of _fireFrameEnded.
+        @see FrameArena
+        */
+        FrameArena *getFrameArena() const { return mFrameArena; }
+
         /** Starts / restarts the automatic rendering cycle.
             @remarks
                 This method begins the automatic rendering of the scene. It
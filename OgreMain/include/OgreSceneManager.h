@@ -47,7 +47,7 @@ Torus Knot Software Ltd.
 #include "OgreRenderSystem.h"
 #include "OgreResourceGroupManager.h"
 #include "OgreSceneQuery.h"
-#include "Threading/OgreThreads.h"
+#include "Threading/OgreTaskScheduler.h"
 
 #include "OgreHeaderPrefix.h"
 
@@ -156,16 +156,14 @@ namespace Ogre
 
     struct UpdateTransformRequest
     {
+        /// First node of the depth level to update
         Transform t;
-        /// Number of nodes to process for each thread. Must be multiple of ARRAY_PACKED_REALS
-        size_t numNodesPerThread;
-        size_t numTotalNodes;
+        size_t    numTotalNodes;
 
-        UpdateTransformRequest() : numNodesPerThread( 0 ), numTotalNodes( 0 ) {}
+        UpdateTransformRequest() : numTotalNodes( 0 ) {}
 
-        UpdateTransformRequest( const Transform &_t, size_t _numNodesPerThread, size_t _numTotalNodes ) :
+        UpdateTransformRequest( const Transform &_t, size_t _numTotalNodes ) :
             t( _t ),
-            numNodesPerThread( _numNodesPerThread ),
             numTotalNodes( _numTotalNodes )
         {
         }
@@ -431,6 +429,14 @@ namespace Ogre
         */
         bool mStaticEntitiesDirty;
 
+        /// Incremented by every notifyStaticDirty call. Starts at 1.
+        /// @see getStaticTransformsVersion
+        uint32 mStaticTransformsVersion;
+
+        /// Max number of slots defragmentMemoryPoolsIncremental moves per frame.
+        /// 0 if incremental defragmentation is disabled.
+        size_t mDefragmentSlotsPerFrame;
+
         PrePassMode   mPrePassMode;
         TextureGpuVec mPrePassTextures;
         TextureGpu   *mPrePassDepthTexture;
@@ -822,6 +828,9 @@ namespace Ogre
         enum RequestType
         {
             CULL_FRUSTUM,
+            CULL_FRUSTUM_BATCHED,
+            CULL_SHADOW_FRUSTUM,
+            GATHER_BATCHED_CULL,
             UPDATE_ALL_ANIMATIONS,
             UPDATE_ALL_TRANSFORMS,
             UPDATE_ALL_BONE_TO_TAG_TRANSFORMS,
@@ -835,17 +844,70 @@ namespace Ogre
             NUM_REQUESTS
         };
 
+        /** Adapts the worker thread stages (@see RequestType) to the TaskScheduler.
+            Stages that work on objects are split in ranges of objects (@see countStageItems),
+            while the rest are split in mNumWorkerThreads slices.
+        */
+        class StageTask final : public RangeTask
+        {
+        public:
+            SceneManager *sceneManager;
+            RequestType   requestType;
+            /// Stage items are always split at multiples of this value
+            size_t granularity;
+            /// Only used by the UPDATE_ALL_*_TRANSFORMS stages
+            UpdateTransformRequest transformRequest;
+            /// Only used by the CULL_SHADOW_FRUSTUM stage. Index to mBatchedShadowCulls
+            size_t batchedShadowCullIdx;
+
+            StageTask() :
+                sceneManager( 0 ),
+                requestType( NUM_REQUESTS ),
+                granularity( 1u ),
+                batchedShadowCullIdx( 0 )
+            {
+            }
+
+            void execute( size_t begin, size_t end, size_t threadIdx ) override;
+        };
+
+        typedef vector<StageTask>::type StageTaskVec;
+
         size_t mNumWorkerThreads;
-        bool   mForceMainThread;
 
         CullFrustumRequest            mCurrentCullFrustumRequest;
         UpdateLodRequest              mUpdateLodRequest;
-        UpdateTransformRequest        mUpdateTransformRequest;
         ObjectMemoryManagerVec const *mUpdateBoundsRequest;
         UniformScalableTask          *mUserTask;
         RequestType                   mRequestType;
-        Barrier                      *mWorkerThreadsBarrier;
-        ThreadHandleVec               mWorkerThreads;
+        TaskScheduler                *mTaskScheduler;
+        StageTask                     mStageTask;
+        /// Kept apart from mStageTask: a non-blocking user task may still be
+        /// pending while the SceneManager runs its own stages
+        StageTask                     mUserStageTask;
+        TaskScheduler::TaskId         mUserTaskId;
+        /// Owned by Root. @see getFrameArena
+        FrameArena *mFrameArena;
+        /// One per node depth level, which depend on their parent level. @see updateAllTransforms
+        StageTaskVec mTransformStageTasks;
+        /// One per shadow map frustum, which don't depend on each other.
+        /// @see _cullShadowCastersBatched
+        StageTaskVec mShadowCullStageTasks;
+
+        struct CullingHierarchyView
+        {
+            /// Null if the hierarchy can't be used. @see ObjectMemoryManager::_getCullingHierarchy
+            ArrayAabb const *clusterAabbs;
+            size_t           numClusterPacks;
+        };
+        typedef vector<CullingHierarchyView>::type CullingHierarchyViewVec;
+        /** Whether each render queue of each ObjectMemoryManager being culled can use its
+            culling hierarchy. Decided once by latchCullingHierarchies on the main thread so
+            that all worker threads agree during the same cull, even if a hierarchy gets
+            flagged as dirty in the middle of it.
+            Entries of each ObjectMemoryManager are contiguous, getNumRenderQueues() each.
+        */
+        CullingHierarchyViewVec mCullingHierarchyViews;
 
         /** Contains MovableObjects to be visited and rendered.
         @rermarks
@@ -863,6 +925,30 @@ namespace Ogre
         */
         VisibleObjectsPerThreadArray mTmpVisibleObjects;
 
+        /// Results of _cullShadowCastersBatched for one shadow map frustum
+        struct BatchedShadowCull
+        {
+            Camera const *camera;
+            /// Frustum planes at the time of culling, to tell apart
+            /// cubemap faces rendered with the same camera.
+            Plane planes[6];
+            /// Same layout as mVisibleObjects
+            VisibleObjectsPerThreadArray visibleObjects;
+        };
+        typedef vector<BatchedShadowCull>::type BatchedShadowCullVec;
+
+        bool mShadowCullingBatched;
+        /// Only the first mNumBatchedShadowCulls entries are valid.
+        /// We keep the rest to avoid reallocations.
+        BatchedShadowCullVec mBatchedShadowCulls;
+        size_t               mNumBatchedShadowCulls;
+        /// All the planes in mBatchedShadowCulls, contiguous.
+        /// See MovableObject::cullFrustumBatched
+        vector<Plane>::type mBatchedShadowCullPlanes;
+        Camera const       *mBatchedShadowCullLodCamera;
+        /// Entry being gathered by GATHER_BATCHED_CULL
+        BatchedShadowCull const *mCurrentBatchedShadowCull;
+
         /// Suppress render state changes?
         bool mSuppressRenderStateChanges;
 
@@ -910,7 +996,7 @@ namespace Ogre
 
         /** Updates the Animations from the given request inside a thread. @see updateAllAnimations
         @param threadIdx
-            Thread index so we know at which point we should start at.
+            Slice index so we know at which point we should start at.
             Must be unique for each worker thread
         */
         void updateAllAnimationsThread( size_t threadIdx );
@@ -919,44 +1005,125 @@ namespace Ogre
         /** Updates the Nodes from the given request inside a thread. @see updateAllTransforms
         @param request
             Fully setup request. @see UpdateTransformRequest.
-        @param threadIdx
-            Thread index so we know at which point we should start at.
-            Must be unique for each worker thread
+        @param begin
+            First node to update, relative to request.t. Multiple of ARRAY_PACKED_REALS.
+        @param end
+            One past the last node to update.
         */
-        void updateAllTransformsThread( const UpdateTransformRequest &request, size_t threadIdx );
+        void updateAllTransformsThread( const UpdateTransformRequest &request, size_t begin,
+                                        size_t end );
 
         /// @see TagPoint::updateAllTransformsBoneToTag
-        void updateAllTransformsBoneToTagThread( const UpdateTransformRequest &request,
-                                                 size_t                        threadIdx );
+        void updateAllTransformsBoneToTagThread( const UpdateTransformRequest &request, size_t begin,
+                                                 size_t end );
 
         /// @see TagPoint::updateAllTransformsTagOnTag
-        void updateAllTransformsTagOnTagThread( const UpdateTransformRequest &request,
-                                                size_t                        threadIdx );
+        void updateAllTransformsTagOnTagThread( const UpdateTransformRequest &request, size_t begin,
+                                                size_t end );
 
-        /** Updates the world aabbs from the given request inside a thread. @see updateAllTransforms
-        @param threadIdx
-            Thread index so we know at which point we should start at.
-            Must be unique for each worker thread
+        /** Submits one task per depth level of the given node memory manager, each depending
+            on its parent level. @see updateAllTransforms
+        @param tagPoints
+            True to update TagPoints (@see updateAllTagPoints) instead of regular Nodes.
+        @param inOutTaskIdx
+            Next free StageTask in mTransformStageTasks. Incremented for every task submitted.
         */
-        void updateAllBoundsThread( const ObjectMemoryManagerVec &objectMemManager, size_t threadIdx );
+        void addTransformStageTasks( NodeMemoryManager *nodeMemoryManager, size_t firstDepth,
+                                     bool tagPoints, size_t &inOutTaskIdx );
 
-        /**
-        @param threadIdx
-            Thread index so we know at which point we should start at.
-            Must be unique for each worker thread
+        /** Counts the items of a stage that works on objects: the objects of every render queue
+            in [firstRq; lastRq) of every memory manager, laid out back to back, with each
+            render queue padded to a multiple of granularity. Worker threads receive ranges
+            of this layout. @see getStageRange
+        */
+        static size_t countStageItems( const ObjectMemoryManagerVec &objectMemManager, size_t firstRq,
+                                       size_t lastRq, size_t granularity );
+
+        /// Stages refitting or traversing the culling hierarchy must not split cluster packs.
+        static size_t getStageGranularity( const ObjectMemoryManagerVec &objectMemManager );
+
+        /** Updates the world aabbs from the given request inside a thread. @see updateAllTransforms
+        @param begin
+            First stage item to process. @see countStageItems
+        @param end
+            One past the last stage item to process.
+        @param granularity
+            Granularity the stage items were laid out with.
         */
-        void updateAllLodsThread( const UpdateLodRequest &request, size_t threadIdx );
+        void updateAllBoundsThread( const ObjectMemoryManagerVec &objectMemManager, size_t begin,
+                                    size_t end, size_t granularity );
+
+        /// @copydoc updateAllBoundsThread
+        void updateAllLodsThread( const UpdateLodRequest &request, size_t begin, size_t end,
+                                  size_t granularity );
 
         /** Low level culling, culls all objects against the given frustum active cameras. This
             includes checking visibility flags (both scene and viewport's)
             @see MovableObject::cullFrustum
         @param request
             Fully setup request. @see CullFrustumRequest.
+        @param begin
+            First stage item to process. @see countStageItems
+        @param end
+            One past the last stage item to process.
+        @param granularity
+            Granularity the stage items were laid out with.
         @param threadIdx
-            Index to mVisibleObjects so we know which array we should start at.
+            Index to mVisibleObjects so we know which array we should store our results.
             Must be unique for each worker thread
         */
-        void cullFrustum( const CullFrustumRequest &request, size_t threadIdx );
+        void cullFrustum( const CullFrustumRequest &request, size_t begin, size_t end,
+                          size_t granularity, size_t threadIdx );
+
+        /// Same as cullFrustum, but culls all frustums in mBatchedShadowCulls at once.
+        /// See _cullShadowCastersBatched
+        void cullFrustumBatched( size_t begin, size_t end, size_t granularity, size_t threadIdx );
+
+        /// Same as cullFrustumBatched, but culls a single entry of mBatchedShadowCulls using
+        /// the culling hierarchy. See _cullShadowCastersBatched
+        void cullShadowFrustum( size_t batchedShadowCullIdx, size_t begin, size_t end,
+                                size_t granularity, size_t threadIdx );
+
+        /** Fills mVisibleObjects (and the RenderQueue) from mCurrentBatchedShadowCull, applying
+            the visibility flags that cullFrustum would've applied.
+        @param begin
+            First thread whose results to gather from.
+        @param end
+            One past the last thread whose results to gather from.
+        @param threadIdx
+            Index to mVisibleObjects so we know which array we should store our results.
+        */
+        void gatherBatchedCull( const CullFrustumRequest &request, size_t begin, size_t end,
+                                size_t threadIdx );
+
+        /// Returns the entry in mBatchedShadowCulls whose results can be used instead
+        /// of culling again. Null if there's none.
+        const BatchedShadowCull *findBatchedShadowCull( const Camera *camera,
+                                                        const Camera *lodCamera ) const;
+
+        /// Fills mCullingHierarchyViews. Must be called from the main thread before culling.
+        void latchCullingHierarchies( const ObjectMemoryManagerVec &objectMemManager );
+
+        /** Culls the objects from a render queue using the cluster bounds built by
+            ObjectMemoryManager::_refitCullingHierarchy. Clusters fully outside the
+            frustum are skipped, the rest are handed to MovableObject::cullFrustum.
+        @param clusterAabbs
+            Cluster bounds. @see mCullingHierarchyViews
+        @param firstPack
+            First ArrayAabb in clusterAabbs to test
+        @param lastPack
+            One past the last ArrayAabb in clusterAabbs to test
+        @param frustumPlanes
+            The 6 planes to clip against.
+        @param camera
+            When null, the remaining objects are handed to MovableObject::cullFrustumBatched
+            instead, using frustumPlanes (i.e. only shadow casters are considered).
+        */
+        void cullFrustumHierarchy( const ArrayAabb *clusterAabbs, size_t firstPack, size_t lastPack,
+                                   size_t totalObjs, ObjectData objData, const Plane *frustumPlanes,
+                                   const Camera *camera, uint32 visibilityMask,
+                                   MovableObject::MovableObjectArray &outVisible,
+                                   const Camera *lodCamera );
 
         /** Builds a list of all lights that are visible by all queued cameras (this should be fed by
             Compositor). Then calls MovableObject::buildLightList with that list so that each
@@ -968,7 +1135,8 @@ namespace Ogre
 
         void buildLightListThread01( const BuildLightListRequest &buildLightListRequest,
                                      size_t                       threadIdx );
-        void buildLightListThread02( size_t threadIdx );
+        /// @copydoc updateAllBoundsThread
+        void buildLightListThread02( size_t begin, size_t end, size_t granularity );
 
     public:
         /** Constructor.
@@ -1293,6 +1461,18 @@ namespace Ogre
         */
         void setBuildLegacyLightList( bool bEnable );
 
+        /** Enables or disables the culling hierarchy for Items & Entities (both dynamic
+            and static). When enabled, the world aabbs of each render queue are grouped in
+            clusters whose bounds are refit during updateAllBounds, and cullFrustum rejects
+            entire clusters that are outside the frustum before testing individual objects.
+        @remarks
+            Recommended for scenes with a very large number of objects where most of them
+            are outside the frustum. For small scenes, or when most objects are visible, the
+            extra refit may cost more than it saves.
+        */
+        void setCullingHierarchyEnabled( bool bEnable );
+        bool getCullingHierarchyEnabled() const;
+
         ForwardPlusBase *getForwardPlus() { return mForwardPlusSystem; }
         ForwardPlusBase *_getActivePassForwardPlus() { return mForwardPlusImpl; }
 
@@ -1380,6 +1560,24 @@ namespace Ogre
         /// @copydoc ArrayMemoryManager::shrinkToFit
         void shrinkToFitMemoryPools();
 
+        /** Spreads the defragmentation of the node and object memory pools across frames.
+        @remarks
+            By default a pool is fully defragmented as soon as too many slots were released
+            in non-LIFO order, which can cause a frame spike when lots of objects need to be
+            shifted. When enabled, that no longer happens; instead updateSceneGraph moves at
+            most slotsPerFrame slots every frame. See ArrayMemoryManager::defragmentIncremental.
+            @par
+            Skeletons are not affected, as bones must keep their order.
+        @param slotsPerFrame
+            Maximum number of slots to move per frame, across all pools.
+            0 to restore the default behaviour.
+        */
+        void setIncrementalDefragmentation( size_t slotsPerFrame );
+        size_t getIncrementalDefragmentation() const { return mDefragmentSlotsPerFrame; }
+
+        /// Moves up to getIncrementalDefragmentation slots. Called by updateSceneGraph.
+        void defragmentMemoryPoolsIncremental();
+
         /** Create an Item (instance of a discrete mesh).
             @param
                 meshName The name of the Mesh it is to be based on (e.g. 'knot.oof'). The
@@ -1825,6 +2023,14 @@ namespace Ogre
         */
         void notifyStaticDirty( Node *node );
 
+        /** Returns a counter that changes every time notifyStaticDirty is called.
+        @remarks
+            Systems that cache data derived from static transforms (e.g. the static instance
+            cache in HlmsPbs) compare against it to know when their copies may be stale.
+            It never returns 0, so 0 can be used as "never captured".
+        */
+        uint32 getStaticTransformsVersion() const { return mStaticTransformsVersion; }
+
         /** Updates all skeletal animations in the scene. This is typically called once
             per frame during render, but the user might want to manually call this function.
         @remarks
@@ -2510,6 +2716,38 @@ namespace Ogre
         */
         virtual bool getFindVisibleObjects() { return mFindVisibleObjects; }
 
+        /** When enabled, CompositorShadowNode culls all of its shadow maps (every PSSM split,
+            every point light cubemap face, etc) in a single pass over the objects, instead of
+            one pass (and one sync point with the worker threads) per shadow map.
+        @remarks
+            Shadow map passes fall back to regular culling when their camera changed after the
+            shadow node was set up (e.g. a listener moved it) or if they include non-casters.
+            Changes made to the scene by listeners while the shadow node is being rendered
+            (i.e. between passes) won't be seen by the shadow maps.
+        @par
+            Default is false.
+        */
+        void setShadowCullingBatched( bool bBatched ) { mShadowCullingBatched = bBatched; }
+        bool getShadowCullingBatched() const { return mShadowCullingBatched; }
+
+        /** Adds the current frustum of the camera to the next _cullShadowCastersBatched call.
+            Does nothing if getShadowCullingBatched is false.
+        */
+        void _addBatchedShadowCullCamera( const Camera *camera );
+
+        /** Culls the shadow casters against all the frustums added via _addBatchedShadowCullCamera
+            at once. Subsequent _cullPhase01 calls from caster passes will use these results
+            when culling from one of those frustums, until _clearBatchedShadowCull is called.
+        @remarks
+            Without the culling hierarchy all frustums are tested in a single sweep over the
+            objects. With it, each frustum is culled as an independent task so that it can
+            skip whole clusters; these tasks run concurrently on the TaskScheduler.
+        @param lodCamera
+            LOD camera the shadow map passes will be using.
+        */
+        void _cullShadowCastersBatched( const Camera *lodCamera );
+        void _clearBatchedShadowCull();
+
         /** Set whether to automatically flip the culling mode on objects whenever they
             are negatively scaled.
         @remarks
@@ -2652,13 +2890,18 @@ namespace Ogre
         IlluminationRenderStage _getCurrentRenderStage() const { return mIlluminationStage; }
 
     protected:
+        /// Runs the current mRequestType split in mNumWorkerThreads slices
         void fireWorkerThreadsAndWait();
+        /// Runs the current mRequestType split in ranges of numItems stage items
+        void fireWorkerThreadsAndWait( size_t numItems, size_t granularity );
 
         /** Launches cullFrustum on all worker threads with the requested parameters
         @remarks
             Will block until all threads are done.
         */
         void fireCullFrustumThreads( const CullFrustumRequest &request );
+        /// Sets visibleObjects to have one empty list per worker thread per RenderQueue.
+        void resetVisibleObjects( VisibleObjectsPerThreadArray &visibleObjects );
         void startWorkerThreads();
         void stopWorkerThreads();
 
@@ -2669,6 +2912,12 @@ namespace Ogre
             If 'bBlock' is false, it is user responsibility to call
             waitForPendingUserScalableTask before the next call to either
             processUserScalableTask or renderOneFrame.
+        @par
+            The calling thread is worker thread 0 and only works on the task while
+            waiting for it. Thus with a single worker thread a non-blocking task does
+            not start until waitForPendingUserScalableTask is called (or until the
+            SceneManager waits for its own work); with more threads, the rest of the
+            workers start right away.
         @param task
             Task to perform. Pointer must be valid at least until the task is finished
         @param bBlock
@@ -2684,13 +2933,23 @@ namespace Ogre
         */
         void waitForPendingUserScalableTask();
 
-        /** Called from the worker thread, polls to process frustum culling
-            requests when a sync is performed
+        /** Returns the scheduler that runs the work of the worker threads.
+        @remarks
+            Users may submit their own tasks. They run alongside the SceneManager's own work,
+            which waits for every submitted task to finish; so tasks must be waited for
+            before calling renderOneFrame or updateSceneGraph.
+        */
+        TaskScheduler *getTaskScheduler() const { return mTaskScheduler; }
+
+        /** Returns the arena for per-frame transient allocations, which may be used
+            from worker threads. Same as Root::getFrameArena.
         */
-        unsigned long _updateWorkerThread( ThreadHandle *threadHandle );
+        FrameArena *getFrameArena() const { return mFrameArena; }
 
     protected:
-        inline bool updateWorkerThreadImpl( size_t threadIdx );
+        /// Executes [begin; end) of a stage. @see StageTask
+        void executeStageRange( const StageTask &stageTask, size_t begin, size_t end,
+                                size_t threadIdx );
     };
 
     /** Default implementation of IntersectionSceneQuery. */
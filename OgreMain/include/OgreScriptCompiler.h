@@ -34,6 +34,7 @@ THE SOFTWARE.
 #include "OgreScriptLoader.h"
 #include "OgreSharedPtr.h"
 #include "OgreSingleton.h"
+#include "Threading/OgreLightweightMutex.h"
 #include "Threading/OgreThreadHeaders.h"
 
 #include "ogrestd/list.h"
@@ -442,6 +443,29 @@ namespace Ogre
         // A pointer to the specific compiler instance used
         OGRE_THREAD_POINTER( ScriptCompiler, mScriptCompiler );
 
+        /// Parsed (concrete) tree of a script, serialized. See saveScriptCache
+        struct CachedScript
+        {
+            /// Hash of the script's source code
+            uint64              hash[2];
+            vector<uint8>::type data;
+        };
+        typedef map<String, CachedScript>::type ScriptCacheMap;
+
+        /// Keyed by script name. Protected by mScriptCacheMutex, as scripts may be
+        /// prepared from multiple threads (see prepareScript)
+        ScriptCacheMap           mScriptCache;
+        mutable LightweightMutex mScriptCacheMutex;
+        bool                     mSaveScriptsToCache;
+        bool                     mScriptCacheDirty;
+
+        /// Returns the parsed tree of the script. Uses the cache when possible,
+        /// and adds the results to it when parsing if getSaveScriptsToCache is enabled.
+        ConcreteNodeListPtr parseWithCache( const String &str, const String &source );
+
+        /// Returns the compiler for the current thread, with our listener set
+        ScriptCompiler *getThreadCompiler();
+
     public:
         ScriptCompilerManager();
         ~ScriptCompilerManager() override;
@@ -479,9 +503,51 @@ namespace Ogre
         const StringVector &getScriptPatterns() const override;
         /// @copydoc ScriptLoader::parseScript
         void parseScript( DataStreamPtr &stream, const String &groupName ) override;
+        /// @copydoc ScriptLoader::supportsPreparedScripts
+        bool supportsPreparedScripts() const override;
+        /** Lexes and parses the script (or fetches it from the script cache).
+            @copydoc ScriptLoader::prepareScript
+        @remarks
+            ScriptCompilerListener::importFile and preConversion are still called from
+            parsePreparedScript.
+        */
+        Any prepareScript( DataStreamPtr &stream ) override;
+        /// @copydoc ScriptLoader::parsePreparedScript
+        void parsePreparedScript( const Any &preparedScript, DataStreamPtr &stream,
+                                  const String &groupName ) override;
         /// @copydoc ScriptLoader::getLoadingOrder
         Real getLoadingOrder() const override;
 
+        /** When enabled, the parsed trees of the scripts going through parseScript are kept
+            so they can be saved with saveScriptCache. On subsequent runs, scripts whose
+            source code didn't change skip lexing and parsing entirely.
+        @remarks
+            Only lexing & parsing is cached. Scripts are still translated into resources
+            every time (which is also where imports & variables get resolved), thus a
+            cached script still picks up changes made to the scripts it imports.
+        @par
+            Default is false.
+        */
+        void setSaveScriptsToCache( bool bSave ) { mSaveScriptsToCache = bSave; }
+        bool getSaveScriptsToCache() const { return mSaveScriptsToCache; }
+
+        /// Returns true if the script cache changed since it was last loaded or cleared.
+        bool isScriptCacheDirty() const { return mScriptCacheDirty; }
+
+        /** Saves the script cache to the given stream. Does nothing if isScriptCacheDirty
+            returns false.
+        */
+        void saveScriptCache( DataStreamPtr stream ) const;
+
+        /** Loads a script cache previously saved with saveScriptCache.
+            Replaces the current cache. The cache is discarded if it was saved with
+            a different version of Ogre.
+        */
+        void loadScriptCache( DataStreamPtr stream );
+
+        /// Deletes all the entries in the script cache
+        void clearScriptCache();
+
         /** Override standard Singleton retrieval.
         @remarks
         Why do we do this? Well, it's because the Singleton
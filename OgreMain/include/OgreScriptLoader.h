@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 #include "OgrePrerequisites.h"
 
+#include "OgreAny.h"
 #include "OgreDataStream.h"
 #include "OgreStringVector.h"
 
@@ -79,6 +80,34 @@ namespace Ogre
         */
         virtual void parseScript( DataStreamPtr &stream, const String &groupName ) = 0;
 
+        /** Returns true if this loader implements prepareScript & parsePreparedScript,
+            so that ResourceGroupManager can prepare several scripts in parallel.
+            See ResourceGroupManager::setNumScriptParsingThreads
+        */
+        virtual bool supportsPreparedScripts() const { return false; }
+
+        /** Performs the part of parseScript that doesn't depend on anything else
+            but the script itself (e.g. lexing & parsing).
+        @remarks
+            May be called from any thread, and concurrently with other calls to prepareScript.
+            Must not create resources nor touch any other manager.
+        @param stream
+            The source of the script. Always a MemoryDataStream.
+        @return
+            Whatever parsePreparedScript needs to finish the job.
+        */
+        virtual Any prepareScript( DataStreamPtr &stream ) { return Any(); }
+
+        /** Finishes parsing a script prepared with prepareScript. Always called from the
+            thread that initialises the resource group, in the same order parseScript
+            would've been called.
+        */
+        virtual void parsePreparedScript( const Any &preparedScript, DataStreamPtr &stream,
+                                          const String &groupName )
+        {
+            parseScript( stream, groupName );
+        }
+
         /** Gets the relative loading order of scripts of this type.
         @remarks
             There are dependencies between some kinds of scripts, and to enforce
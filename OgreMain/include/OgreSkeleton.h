@@ -31,6 +31,7 @@ THE SOFTWARE.
 
 #include "OgrePrerequisites.h"
 
+#include "Animation/OgreSkeletonCompressionSettings.h"
 #include "OgreAnimation.h"
 #include "OgreResource.h"
 #include "OgreSharedPtr.h"
@@ -296,6 +297,16 @@ namespace Ogre
             /** Sets the animation blending mode this skeleton will use. */
             virtual void setBlendMode( SkeletonAnimationBlendMode state );
 
+            /** Sets how the animations will be compressed when this skeleton is converted
+                to a v2 SkeletonDef. It is saved to and loaded from the .skeleton file.
+            @see SkeletonCompressionSettings
+            */
+            void setCompressionSettings( const SkeletonCompressionSettings &settings );
+            const SkeletonCompressionSettings &getCompressionSettings() const
+            {
+                return mCompressionSettings;
+            }
+
             /// Updates all the derived transforms in the skeleton
             virtual void _updateTransforms();
 
@@ -414,6 +425,7 @@ namespace Ogre
 
         protected:
             SkeletonAnimationBlendMode mBlendState;
+            SkeletonCompressionSettings mCompressionSettings;
             /// Storage of bones, indexed by bone handle
             BoneList mBoneList;
             /// Lookup by bone name
@@ -58,6 +58,10 @@ namespace Ogre
             // char* version           : Version number check
             SKELETON_BLENDMODE         = 0x1010, // optional
                 // unsigned short blendmode     : SkeletonAnimationBlendMode
+            SKELETON_ANIMATION_COMPRESSION = 0x1020, // optional
+                // float positionTolerance      : See SkeletonCompressionSettings
+                // float orientationTolerance   : In radians
+                // float scaleTolerance
         
         SKELETON_BONE              = 0x2000,
         // Repeating section defining each bone in the system. 
@@ -43,6 +43,8 @@ THE SOFTWARE.
 #include "ogrestd/map.h"
 #include "ogrestd/set.h"
 
+#include <exception>
+
 #include "OgreHeaderPrefix.h"
 
 namespace Ogre
@@ -55,6 +57,7 @@ namespace Ogre
      */
 
     typedef vector<TextureGpu *>::type TextureGpuVec;
+    class Exception;
     class ObjCmdBuffer;
     class ResourceLoadingListener;
     class TextureGpuManagerListener;
@@ -261,6 +264,63 @@ namespace Ogre
 
         typedef vector<BudgetEntry>::type BudgetEntryVec;
 
+        /// See TextureGpuManager::getDecodeStats
+        struct DecodeWorkerStats
+        {
+            /// Number of images opened & decoded by this worker
+            uint64 numImages;
+            /// Size in bytes of the decoded images (i.e. Image2::getSizeBytes)
+            uint64 bytesDecoded;
+            /// Time spent opening & decoding images
+            uint64 busyMicroseconds;
+            /// Time spent waiting for work, i.e. starved by the streaming worker thread
+            uint64 stallMicroseconds;
+
+            DecodeWorkerStats() :
+                numImages( 0u ),
+                bytesDecoded( 0u ),
+                busyMicroseconds( 0u ),
+                stallMicroseconds( 0u )
+            {
+            }
+
+            /// Decoding throughput while busy
+            double getBytesPerSecond() const
+            {
+                return busyMicroseconds ? double( bytesDecoded ) * 1000000.0 / double( busyMicroseconds )
+                                        : 0.0;
+            }
+        };
+
+        typedef vector<DecodeWorkerStats>::type DecodeWorkerStatsVec;
+
+        struct DecodeStats
+        {
+            /// LoadRequests scheduled for decoding but not yet picked by any worker
+            size_t queueDepth;
+            /// One per decode worker. See setNumDecodeWorkers
+            DecodeWorkerStatsVec workers;
+
+            DecodeStats() : queueDepth( 0u ) {}
+        };
+
+        /// See TextureGpuManager::setResidencyBudget
+        struct ResidencyCandidate
+        {
+            TextureGpu *texture;
+            /// Frames since it was last used, multiplied by its rank
+            uint32 weightedAge;
+            float  distanceToCamera;
+
+            ResidencyCandidate( TextureGpu *_texture, uint32 _weightedAge, float _distanceToCamera ) :
+                texture( _texture ),
+                weightedAge( _weightedAge ),
+                distanceToCamera( _distanceToCamera )
+            {
+            }
+        };
+        typedef vector<ResidencyCandidate>::type ResidencyCandidateVec;
+
         struct MetadataCacheEntry
         {
             String                     aliasName;
@@ -300,6 +360,8 @@ namespace Ogre
         typedef map<IdString, ResourceEntry>::type ResourceEntryMap;
 
     protected:
+        struct DecodeTask;
+
         struct LoadRequest
         {
             String                   name;
@@ -317,6 +379,9 @@ namespace Ogre
             bool autoDeleteImage;
             /// Indicates we're going to GpuResidency::OnSystemRam instead of Resident
             bool toSysRam;
+            /// Non-null if the file is being (or has been) opened & decoded by the decode pool.
+            /// Owned by the worker thread. See setNumDecodeWorkers
+            DecodeTask *decodeTask;
 
             LoadRequest( const String &_name, Archive *_archive,
                          ResourceLoadingListener *_loadingListener, Image2 *_image, TextureGpu *_texture,
@@ -329,11 +394,53 @@ namespace Ogre
                 sliceOrDepth( _sliceOrDepth ),
                 filters( _filters ),
                 autoDeleteImage( _autoDeleteImage ),
-                toSysRam( _toSysRam )
+                toSysRam( _toSysRam ),
+                decodeTask( 0 )
             {
             }
         };
 
+        enum DecodeTaskState
+        {
+            DecodeQueued,
+            DecodeInProgress,
+            DecodeDone,
+            /// The LoadRequest was aborted while a decode worker was processing it.
+            /// The worker will delete the task when it's done.
+            DecodeAbandoned
+        };
+
+        /// Opening & decoding of a LoadRequest's file, performed by the decode pool ahead
+        /// of the streaming worker thread, which then picks up the Image2 in order.
+        struct DecodeTask
+        {
+            String     name;
+            Archive   *archive;
+            Image2     image;
+            /// Non-null if opening or decoding the file failed
+            std::exception_ptr exception;
+            /// Protected by mDecodeMutex
+            DecodeTaskState state;
+
+            DecodeTask( const String &_name, Archive *_archive ) :
+                name( _name ),
+                archive( _archive ),
+                state( DecodeQueued )
+            {
+            }
+        };
+
+        typedef vector<DecodeTask *>::type DecodeTaskVec;
+
+        struct DecodeWorker
+        {
+            ThreadHandlePtr   threadHandle;
+            WaitableEvent     waitableEvent;
+            DecodeWorkerStats stats;
+        };
+
+        typedef vector<DecodeWorker *>::type DecodeWorkerVec;
+
         typedef vector<LoadRequest>::type LoadRequestVec;
 
         struct UsageStats
@@ -531,6 +638,14 @@ namespace Ogre
         ThreadData    mThreadData[2];
         StreamingData mStreamingData;
 
+        /// Decode pool. Empty if disabled. See setNumDecodeWorkers
+        DecodeWorkerVec mDecodeWorkers;
+        /// FIFO of tasks not yet picked by a decode worker. Protected by mDecodeMutex
+        DecodeTaskVec mDecodeQueue;
+        /// Protects mDecodeQueue, DecodeTask::state & DecodeWorker::stats
+        mutable LightweightMutex mDecodeMutex;
+        bool                     mDecodeWorkersShuttingDown;
+
         TexturePoolList  mTexturePool;
         ResourceEntryMap mEntries;
         /// Protects mEntries
@@ -584,6 +699,21 @@ namespace Ogre
         bool                   mDelayListenerCalls;
         bool                   mIgnoreScheduledTasks;
 
+        /// See setResidencyBudget. 0 if disabled.
+        size_t                     mResidencyBudget;
+        GpuResidency::GpuResidency mResidencyEvictTo;
+        uint32                     mResidencyEvictionDelay;
+        uint32                     mResidencyMaxStreamInsPerFrame;
+        uint32                     mLastResidencyBudgetFrame;
+        /// Textures we paged out that will be paged back in once they're used again.
+        set<TextureGpu *>::type mResidencyEvicted;
+        ResidencyCandidateVec   mTmpEvictionCandidates;
+        ResidencyCandidateVec   mTmpStreamInCandidates;
+
+        /// Evicts least recently used textures and pages back in the ones that were
+        /// evicted and are being used again, nearest first. See setResidencyBudget
+        void updateResidencyBudget();
+
     public:
         /** While true, calls to createTexture & createOrRetrieveTexture will ignore
             and unset the TextureFlags::PrefersLoadingFromFileAsSRGB flag.
@@ -734,8 +864,24 @@ namespace Ogre
         void _releaseSlotFromTexture( TextureGpu *texture );
 
         unsigned long _updateStreamingWorkerThread( ThreadHandle *threadHandle );
+        unsigned long _updateDecodeWorkerThread( ThreadHandle *threadHandle );
 
     protected:
+        void startDecodeWorkers( size_t numWorkers );
+        /// Must be called from main thread, while holding mMutex.
+        /// LoadRequests whose decoding didn't start are given back to the worker thread.
+        void stopDecodeWorkers();
+        /// Deletes or abandons all DecodeTasks. Assumes we're protected by mMutex!
+        void abortAllDecodeTasks();
+
+        /// Hands the first LoadRequests in workerData.loadRequests to the decode pool.
+        /// Must be called from worker thread, while holding mMutex.
+        void scheduleDecodeTasks( ThreadData &workerData );
+
+        /// Returns true if loadRequest can be processed, i.e. it doesn't
+        /// use the decode pool or its DecodeTask is done.
+        bool isDecodeTaskReady( const LoadRequest &loadRequest ) const;
+
         /// This function processes a load request coming from main thread. It basically
         /// gets called once per Image to load. Usually that means once per texture,
         /// but in the case of Cubemaps being made up from multiple separate images,
@@ -1139,6 +1285,77 @@ namespace Ogre
         */
         void setWorkerThreadMaxPreloadBytes( size_t maxPreloadBytes );
 
+        /** Sets a budget for the VRAM consumed by textures, and enables automatic
+            residency management to stay within it.
+        @remarks
+            Every frame the RenderQueue touches the textures of the datablocks it renders,
+            saving the frame and the lowest distance to camera (see GpuResource::_touch).
+        @par
+            When textures that are Resident (or about to be) exceed the budget, textures
+            that haven't been used in the last getResidencyEvictionDelay frames are paged
+            out; least recently used first (their age is multiplied by their rank).
+        @par
+            Textures paged out this way are paged back in as soon as they're used again,
+            nearest to camera first, as long as they fit in the budget (evicting more
+            textures if needed). They're not used for rendering until all their mips
+            have been uploaded again.
+        @par
+            Only textures loaded from file or a listener (i.e. !isManualTexture) with
+            a GpuResource::getRank greater than 0 that have been touched at least once
+            (see GpuResource::hasBeenTouched) are ever paged out.
+            Only the textures of datablocks derived from HlmsTextureBaseClass are touched.
+            Textures that are also used elsewhere (e.g. set directly to a compositor pass,
+            as IBL or in a low level material) must be given rank 0 or they could be
+            evicted while still in use.
+        @param budgetBytes
+            Budget in bytes. 0 to disable (default).
+        @param evictTo
+            Residency to page out to. GpuResidency::OnSystemRam makes paging back in
+            faster at the cost of RAM. Textures using GpuPageOutStrategy::Discard
+            always go to GpuResidency::OnStorage.
+        */
+        void setResidencyBudget( size_t budgetBytes,
+                                 GpuResidency::GpuResidency evictTo = GpuResidency::OnStorage );
+        size_t getResidencyBudget() const { return mResidencyBudget; }
+
+        /// Number of frames a texture must go unused before it can be paged out
+        /// due to exceeding the residency budget. Default is 60.
+        /// See setResidencyBudget
+        void   setResidencyEvictionDelay( uint32 numFrames );
+        uint32 getResidencyEvictionDelay() const { return mResidencyEvictionDelay; }
+
+        /// Maximum number of evicted textures that can be scheduled to be
+        /// paged back in per frame. Default is 16. See setResidencyBudget
+        void   setResidencyMaxStreamInsPerFrame( uint32 maxStreamIns );
+        uint32 getResidencyMaxStreamInsPerFrame() const { return mResidencyMaxStreamInsPerFrame; }
+
+        /** Sets the number of threads that open & decode image files (e.g. PNG, JPG)
+            in parallel on behalf of the worker thread.
+        @remarks
+            By default there are none, and the worker thread opens, decodes, runs the
+            filters & copies to StagingTextures every image by itself, serially.
+            Which makes it the bottleneck when loading thousands of textures.
+        @par
+            With decode workers, the worker thread hands them the next LoadRequests
+            and consumes the decoded images in the same order they were requested,
+            then continues as usual (filters, StagingTextures, handshake with main thread).
+        @par
+            Only LoadRequests from a "FileSystem" Archive without a ResourceLoadingListener
+            are decoded in the pool, since the listener may not be thread safe and other
+            Archives (e.g. Zip) share state between the streams they open.
+            Codecs must be safe to use from multiple threads.
+        @par
+            Must be called from main thread. Ignored on platforms without threads.
+        @param numWorkers
+            Number of decode threads. 0 to disable.
+        */
+        void setNumDecodeWorkers( size_t numWorkers );
+        size_t getNumDecodeWorkers() const { return mDecodeWorkers.size(); }
+
+        /// Retrieves the queue depth and per worker statistics of the decode pool.
+        /// Can be called from any thread.
+        void getDecodeStats( DecodeStats &outStats ) const;
+
         /** The worker thread tracks how many data it is loading so the Main thread can request
             additional StagingTextures if necessary.
 
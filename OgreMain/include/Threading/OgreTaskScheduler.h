@@ -0,0 +1,211 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _OgreTaskScheduler_H_
+#define _OgreTaskScheduler_H_
+
+#include "OgrePrerequisites.h"
+
+#include "Threading/OgreLightweightMutex.h"
+#include "Threading/OgreThreads.h"
+#include "Threading/OgreWaitableEvent.h"
+#include "ogrestd/deque.h"
+#include "ogrestd/vector.h"
+
+#include <atomic>
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup General
+     *  @{
+     */
+
+    /** A task that can be split into contiguous, independent ranges of items.
+        @see TaskScheduler::addTask
+    */
+    class _OgreExport RangeTask
+    {
+    public:
+        virtual ~RangeTask();
+
+        /** Overload this function to process the items in range [begin; end).
+            It may be called from any of the TaskScheduler threads, possibly at the
+            same time as other ranges of the same task.
+        @param begin
+            First item to process. Always a multiple of the granularity the task
+            was submitted with.
+        @param end
+            One past the last item to process. A multiple of the granularity,
+            except for the last range which ends at the total number of items.
+        @param threadIdx
+            Index of the thread executing the range, in range [0; numThreads).
+            No two ranges will ever be executed at the same time with the same
+            threadIdx, so it can be used to index per-thread storage.
+        */
+        virtual void execute( size_t begin, size_t end, size_t threadIdx ) = 0;
+    };
+
+    /** Work-stealing scheduler for RangeTasks.
+    @remarks
+        Each task is split into chunks which are spread across per-thread queues. Threads
+        pop chunks from their own queue and, once it runs dry, steal from the others;
+        so a thread that got an unlucky (i.e. expensive) range of items doesn't stall
+        everyone else the way a static split followed by a barrier does.
+    @par
+        Tasks may depend on other tasks. A task won't start until all of its dependencies
+        have finished, while independent tasks may run concurrently.
+    @par
+        The scheduler spawns numThreads - 1 worker threads. The thread that created the
+        scheduler (the owner) is thread 0 and helps executing chunks while it waits, thus
+        only the owner may call waitFor and waitForAll.
+    */
+    class _OgreExport TaskScheduler
+    {
+    public:
+        typedef uint32 TaskId;
+
+        /// Returned by addTask when the task has no work. Waiting on it returns immediately.
+        static const TaskId INVALID_TASK_ID;
+
+        /// The scheduler aims for this many chunks per thread, for each task.
+        static const size_t CHUNKS_PER_THREAD;
+
+    protected:
+        struct Chunk
+        {
+            RangeTask *task;
+            TaskId     taskId;
+            size_t     begin;
+            size_t     end;
+        };
+
+        typedef deque<Chunk>::type ChunkDeque;
+
+        struct Task
+        {
+            RangeTask *task;
+            size_t     numItems;
+            size_t     chunkSize;
+            size_t     numPendingChunks;
+            size_t     numPendingDependencies;
+            bool       done;
+
+            /// std::vector rather than FastArray, so that growing mTasks
+            /// moves the Tasks instead of copying them.
+            vector<TaskId>::type dependents;
+        };
+
+        typedef vector<Task>::type TaskVec;
+
+        struct ThreadQueue
+        {
+            LightweightMutex mutex;
+            ChunkDeque       chunks;
+            /// Used by worker threads to sleep when there's nothing to do,
+            /// and by the owner thread to sleep while waiting for tasks.
+            WaitableEvent wakeEvent;
+        };
+
+        size_t       mNumThreads;
+        ThreadQueue *mThreadQueues;
+        size_t       mNextQueue;
+
+        /// Protects mTasks, mNumPendingTasks & mNextQueue
+        LightweightMutex mTasksMutex;
+        TaskVec          mTasks;
+        size_t           mNumPendingTasks;
+
+        ThreadHandleVec mWorkerThreads;
+        std::atomic<bool> mExitThreads;
+
+        /// Splits the task in chunks and pushes them to the thread queues.
+        /// mTasksMutex must be held.
+        void scheduleTask( TaskId taskId );
+        /// Marks the task as done and schedules the dependents that became ready.
+        /// mTasksMutex must be held.
+        void completeTask( TaskId taskId );
+
+        void wakeAllThreads();
+
+        /// Pops a chunk from our own queue or, if empty, steals one from another thread.
+        bool acquireChunk( size_t threadIdx, Chunk &outChunk );
+        void executeChunk( const Chunk &chunk, size_t threadIdx );
+
+    public:
+        /**
+        @param numThreads
+            Total number of threads, including the owner thread.
+            A value of 0 or 1 means every task is executed by the owner while waiting.
+        */
+        TaskScheduler( size_t numThreads );
+        ~TaskScheduler();
+
+        size_t getNumThreads() const { return mNumThreads; }
+
+        /** Submits a task.
+        @param task
+            Task to execute. Must stay alive until the task is done.
+        @param numItems
+            Number of items. The task will be called with ranges covering [0; numItems).
+        @param granularity
+            Ranges are always split at multiples of this value, e.g. use ARRAY_PACKED_REALS
+            so that no SIMD pack is shared between two threads. Must be > 0.
+        @param dependencies
+            Array of tasks that must finish before this one starts. Can be null.
+            INVALID_TASK_ID entries are ignored.
+        @param numDependencies
+            Number of entries in dependencies.
+        @return
+            Handle to the task. INVALID_TASK_ID if there were no items and no dependencies.
+        */
+        TaskId addTask( RangeTask *task, size_t numItems, size_t granularity,
+                        const TaskId *dependencies = 0, size_t numDependencies = 0 );
+
+        /** Blocks until the given task is done. The calling thread executes pending
+            chunks (of any task) while it waits. Must be called from the owner thread.
+        */
+        void waitFor( TaskId taskId );
+
+        /** Blocks until all submitted tasks are done. Must be called from the owner thread.
+        @remarks
+            TaskIds returned by addTask are invalidated after this call.
+        */
+        void waitForAll();
+
+        /// Main loop of the worker threads. For internal use.
+        unsigned long _workerThread( size_t threadIdx );
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#endif
@@ -38,7 +38,8 @@ namespace Ogre
 {
     BySkeletonDef::BySkeletonDef( const SkeletonDef *_skeletonDef, size_t threadCount ) :
         skeletonDef( _skeletonDef ),
-        skeletonDefName( _skeletonDef->getNameStr() )
+        skeletonDefName( _skeletonDef->getNameStr() ),
+        animationLodFrame( 0u )
     {
         threadStarts.resize( threadCount + 1, 0 );
     }
@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 #include "Animation/OgreSkeletonAnimationDef.h"
 
+#include "Animation/OgreSkeletonCompressionSettings.h"
 #include "Animation/OgreSkeletonDef.h"
 #include "Math/Array/OgreKfTransform.h"
 #include "Math/Array/OgreKfTransformArrayMemoryManager.h"
@@ -47,7 +48,8 @@ namespace Ogre
         mNumFrames( 0 ),
         mOriginalFrameRate( 25.0f ),
         mSkeletonDef( 0 ),
-        mKfTransformMemoryManager( 0 )
+        mKfTransformMemoryManager( 0 ),
+        mCompressedKeyFrames( 0 )
     {
     }
     //-----------------------------------------------------------------------------------
@@ -61,6 +63,12 @@ namespace Ogre
             delete mKfTransformMemoryManager;
             mKfTransformMemoryManager = 0;
         }
+
+        if( mCompressedKeyFrames )
+        {
+            OGRE_FREE_SIMD( mCompressedKeyFrames, MEMCATEGORY_ANIMATION );
+            mCompressedKeyFrames = 0;
+        }
     }
     //-----------------------------------------------------------------------------------
     void SkeletonAnimationDef::build( const v1::Skeleton *skeleton, const v1::Animation *animation,
@@ -221,6 +229,38 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void SkeletonAnimationDef::compress( const SkeletonCompressionSettings &settings )
+    {
+        OGRE_ASSERT_LOW( !mCompressedKeyFrames && "Animation already compressed!" );
+
+        if( !mKfTransformMemoryManager || mTracks.empty() )
+            return;
+
+        size_t totalBytes = 0;
+        SkeletonTrackVec::iterator itor = mTracks.begin();
+        SkeletonTrackVec::iterator endt = mTracks.end();
+        while( itor != endt )
+        {
+            totalBytes += itor->_reduceKeyFrames( settings );
+            ++itor;
+        }
+
+        mCompressedKeyFrames =
+            reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD( totalBytes, MEMCATEGORY_ANIMATION ) );
+
+        uint8 *dstData = mCompressedKeyFrames;
+        itor = mTracks.begin();
+        while( itor != endt )
+        {
+            dstData += itor->_compress( dstData );
+            ++itor;
+        }
+
+        mKfTransformMemoryManager->destroy();
+        delete mKfTransformMemoryManager;
+        mKfTransformMemoryManager = 0;
+    }
+    //-----------------------------------------------------------------------------------
     void SkeletonAnimationDef::getInterpolatedUnnormalizedKeyFrame( v1::OldNodeAnimationTrack *oldTrack,
                                                                     const v1::TimeIndex &timeIndex,
                                                                     v1::TransformKeyFrame *kf )
@@ -413,22 +453,20 @@ namespace Ogre
                     outText += boneDef.name;
                     outText += ",";
 
-                    KeyFrameRigVec::const_iterator itKeyFrames = keyFrames.begin();
-                    KeyFrameRigVec::const_iterator enKeyFrames = keyFrames.end();
-
-                    while( itKeyFrames != enKeyFrames )
+                    for( size_t j = 0; j < keyFrames.size(); ++j )
                     {
-                        outText += StringConverter::toString( itKeyFrames->mFrame );
+                        outText += StringConverter::toString( keyFrames[j].mFrame );
                         outText += ",";
 
-                        const KfTransform *RESTRICT_ALIAS boneTransform = itKeyFrames->mBoneTransform;
+                        KfTransform boneTransform;
+                        track.getKeyFrameTransform( j, boneTransform );
 
                         Vector3 vPos, vScale;
                         Quaternion qRot;
 
-                        boneTransform->mPosition.getAsVector3( vPos, i );
-                        boneTransform->mOrientation.getAsQuaternion( qRot, i );
-                        boneTransform->mScale.getAsVector3( vScale, i );
+                        boneTransform.mPosition.getAsVector3( vPos, i );
+                        boneTransform.mOrientation.getAsQuaternion( qRot, i );
+                        boneTransform.mScale.getAsVector3( vScale, i );
 
                         outText += StringConverter::toString( vPos.x ) + ",";
                         outText += StringConverter::toString( vPos.y ) + ",";
@@ -440,7 +478,6 @@ namespace Ogre
                         outText += StringConverter::toString( vScale.x ) + ",";
                         outText += StringConverter::toString( vScale.y ) + ",";
                         outText += StringConverter::toString( vScale.z ) + ",";
-                        ++itKeyFrames;
                     }
 
                     outText += "\n";
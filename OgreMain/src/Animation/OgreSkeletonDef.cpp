@@ -129,6 +129,19 @@ namespace Ogre
                                      frameRate );
         }
 
+        const SkeletonCompressionSettings &compressionSettings =
+            originalSkeleton->getCompressionSettings();
+        if( compressionSettings.enabled )
+        {
+            SkeletonAnimationDefVec::iterator itAnimDef = mAnimationDefs.begin();
+            SkeletonAnimationDefVec::iterator enAnimDef = mAnimationDefs.end();
+            while( itAnimDef != enAnimDef )
+            {
+                itAnimDef->compress( compressionSettings );
+                ++itAnimDef;
+            }
+        }
+
         // Create the bones (just like we would for SkeletonInstance)so we can
         // get derived position/rotation/scale and then calculate its inverse
         BoneMemoryManager boneMemoryManager;
@@ -34,6 +34,8 @@ THE SOFTWARE.
 #include "Animation/OgreSkeletonDef.h"
 #include "Animation/OgreSkeletonManager.h"
 #include "OgreId.h"
+#include "OgreLodStrategy.h"
+#include "OgreLodStrategyManager.h"
 #include "OgreOldBone.h"
 #include "OgreSceneNode.h"
 #include "OgreSkeleton.h"
@@ -49,7 +51,12 @@ namespace Ogre
                                         BoneMemoryManager *boneMemoryManager ) :
         mDefinition( skeletonDef ),
         mParentNode( 0 ),
-        mRefCount( 1 )
+        mRefCount( 1 ),
+        mPendingLodValue( std::numeric_limits<Real>::max() ),
+        mAnimationUpdateInterval( 1u ),
+        mFramesSinceAnimationUpdate( 0u ),
+        mAnimationLodInterpolation( false ),
+        mLodPosesValid( false )
     {
         mBones.resize( mDefinition->getBones().size(), Bone() );
 
@@ -253,6 +260,193 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void SkeletonInstance::_updateWithLod( uint32 lodFrame )
+    {
+        if( mAnimationLodValues.empty() )
+        {
+            update();
+            return;
+        }
+
+        // updateAllLods already finished, thus relaxed loads & stores are enough
+        const Real pendingLodValue = mPendingLodValue.load( std::memory_order_relaxed );
+        if( pendingLodValue != std::numeric_limits<Real>::max() )
+        {
+            // Pick the interval of the last threshold we're at or past
+            FastArray<Real>::const_iterator it = std::upper_bound(
+                mAnimationLodValues.begin(), mAnimationLodValues.end(), pendingLodValue );
+            const size_t lodIdx = static_cast<size_t>( it - mAnimationLodValues.begin() );
+            mAnimationUpdateInterval = lodIdx ? mAnimationLodIntervals[lodIdx - 1u] : 1u;
+            mPendingLodValue.store( std::numeric_limits<Real>::max(), std::memory_order_relaxed );
+        }
+
+        const bool interpolate = mAnimationLodInterpolation && mAnimationUpdateInterval > 1u &&
+                                 !mActiveAnimations.empty();
+        if( !interpolate )
+            mLodPosesValid = false;
+
+        if( mAnimationUpdateInterval <= 1u || !( lodFrame % mAnimationUpdateInterval ) ||
+            mFramesSinceAnimationUpdate >= mAnimationUpdateInterval )
+        {
+            mFramesSinceAnimationUpdate = 0u;
+
+            if( interpolate )
+            {
+                const size_t numBoneBlocks =
+                    mDefinition->getNumberOfBoneBlocks( mDefinition->getDepthLevelInfo().size() );
+                KfTransform *RESTRICT_ALIAS prevPose = mLodPoses.get();
+                KfTransform *RESTRICT_ALIAS lastPose = mLodPoses.get() + numBoneBlocks;
+
+                if( mLodPosesValid )
+                    memcpy( prevPose, lastPose, numBoneBlocks * sizeof( KfTransform ) );
+
+                update();
+                saveLocalPose( lastPose );
+
+                if( mLodPosesValid )
+                {
+                    // Show the previous evaluation, and blend towards the new one
+                    // during the next frames
+                    blendLodPoses( 0.0f );
+                }
+                else
+                {
+                    memcpy( prevPose, lastPose, numBoneBlocks * sizeof( KfTransform ) );
+                    mLodPosesValid = true;
+                }
+            }
+            else
+            {
+                update();
+            }
+        }
+        else
+        {
+            ++mFramesSinceAnimationUpdate;
+            if( interpolate && mLodPosesValid )
+            {
+                blendLodPoses( Real( mFramesSinceAnimationUpdate ) /
+                               Real( mAnimationUpdateInterval ) );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::saveLocalPose( KfTransform *RESTRICT_ALIAS dst ) const
+    {
+        SkeletonDef::DepthLevelInfoVec::const_iterator itDepthLevelInfo =
+            mDefinition->getDepthLevelInfo().begin();
+
+        TransformArray::const_iterator itor = mBoneStartTransforms.begin();
+        TransformArray::const_iterator endt = mBoneStartTransforms.end();
+
+        while( itor != endt )
+        {
+            BoneTransform t = *itor;
+            for( size_t i = 0; i < itDepthLevelInfo->numBonesInLevel; i += ARRAY_PACKED_REALS )
+            {
+                dst->mPosition = *t.mPosition;
+                dst->mOrientation = *t.mOrientation;
+                dst->mScale = *t.mScale;
+                t.advancePack();
+                ++dst;
+            }
+
+            ++itor;
+            ++itDepthLevelInfo;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::blendLodPoses( Real weight )
+    {
+        const size_t numBoneBlocks =
+            mDefinition->getNumberOfBoneBlocks( mDefinition->getDepthLevelInfo().size() );
+        const KfTransform *RESTRICT_ALIAS prevPose = mLodPoses.get();
+        const KfTransform *RESTRICT_ALIAS lastPose = mLodPoses.get() + numBoneBlocks;
+        // Zero for manual bones and slots that belong to other instances
+        ArrayReal const *RESTRICT_ALIAS ownedBones = mManualBones.get();
+
+        const ArrayReal w = Mathlib::SetAll( weight );
+
+        SkeletonDef::DepthLevelInfoVec::const_iterator itDepthLevelInfo =
+            mDefinition->getDepthLevelInfo().begin();
+
+        TransformArray::iterator itor = mBoneStartTransforms.begin();
+        TransformArray::iterator endt = mBoneStartTransforms.end();
+
+        while( itor != endt )
+        {
+            BoneTransform t = *itor;
+            for( size_t i = 0; i < itDepthLevelInfo->numBonesInLevel; i += ARRAY_PACKED_REALS )
+            {
+                const ArrayVector3 vPos = Math::lerp( prevPose->mPosition, lastPose->mPosition, w );
+                const ArrayQuaternion qRot =
+                    ArrayQuaternion::nlerpShortest( w, prevPose->mOrientation, lastPose->mOrientation );
+                const ArrayVector3 vScale = Math::lerp( prevPose->mScale, lastPose->mScale, w );
+
+                *t.mPosition = Math::lerp( *t.mPosition, vPos, *ownedBones );
+                *t.mOrientation = Math::lerp( *t.mOrientation, qRot, *ownedBones );
+                *t.mScale = Math::lerp( *t.mScale, vScale, *ownedBones );
+                t.advancePack();
+
+                ++prevPose;
+                ++lastPose;
+                ++ownedBones;
+            }
+
+            ++itor;
+            ++itDepthLevelInfo;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::setAnimationLodLevels( const FastArray<Real> &userLodValues,
+                                                  const FastArray<uint16> &updateIntervals )
+    {
+        if( userLodValues.size() != updateIntervals.size() )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                         "userLodValues and updateIntervals must have the same size",
+                         "SkeletonInstance::setAnimationLodLevels" );
+        }
+
+        const LodStrategy *lodStrategy = LodStrategyManager::getSingleton().getDefaultStrategy();
+
+        mAnimationLodValues.clear();
+        mAnimationLodIntervals.clear();
+        mAnimationLodValues.reserve( userLodValues.size() );
+        mAnimationLodIntervals.reserve( updateIntervals.size() );
+
+        for( size_t i = 0; i < userLodValues.size(); ++i )
+        {
+            OGRE_ASSERT_LOW( updateIntervals[i] >= 1u && "Update interval must be at least 1" );
+            OGRE_ASSERT_LOW( ( i == 0u || userLodValues[i - 1u] <= userLodValues[i] ) &&
+                             "LOD values must be sorted in ascending order" );
+            mAnimationLodValues.push_back( lodStrategy->transformUserValue( userLodValues[i] ) );
+            mAnimationLodIntervals.push_back( std::max<uint16>( updateIntervals[i], 1u ) );
+        }
+
+        mAnimationUpdateInterval = 1u;
+        mFramesSinceAnimationUpdate = 0u;
+        mLodPosesValid = false;
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::setAnimationLodInterpolation( bool bInterpolate )
+    {
+        mAnimationLodInterpolation = bInterpolate;
+        mLodPosesValid = false;
+
+        if( bInterpolate && !mLodPoses.get() )
+        {
+            const size_t numBoneBlocks =
+                mDefinition->getNumberOfBoneBlocks( mDefinition->getDepthLevelInfo().size() );
+            mLodPoses = RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION>( numBoneBlocks * 2u );
+        }
+        else if( !bInterpolate )
+        {
+            RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> emptyPtr;
+            mLodPoses.swap( emptyPtr );
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void SkeletonInstance::resetToPose()
     {
         KfTransform const *RESTRICT_ALIAS bindPose = mDefinition->getBindPose();
@@ -513,6 +707,9 @@ namespace Ogre
 
         assert( mBoneStartTransforms.size() == depthLevelInfo.size() );
 
+        // The slots we own inside each SIMD block may have changed
+        mLodPosesValid = false;
+
         TransformArray::iterator itBoneStartTr = mBoneStartTransforms.begin();
         FastArray<size_t> oldSlotStarts = mSlotStarts;
         mSlotStarts.clear();
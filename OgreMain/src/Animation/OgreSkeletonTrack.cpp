@@ -30,20 +30,87 @@ THE SOFTWARE.
 
 #include "Animation/OgreSkeletonTrack.h"
 
+#include "Animation/OgreSkeletonCompressionSettings.h"
 #include "Math/Array/OgreBoneTransform.h"
 #include "Math/Array/OgreKfTransformArrayMemoryManager.h"
 #include "Math/Array/OgreMathlib.h"
+#include "OgreCommon.h"
 #include "OgreException.h"
 
 namespace Ogre
 {
+    static const Real c_smallestThreeScale = Real( 1.41421356237309504880 / 32767.0 );
+    static const Real c_smallestThreeBias = Real( -0.70710678118654752440 );
+
+    /// Converts numChunks * ARRAY_PACKED_REALS consecutive uint16 into ArrayReals
+    static inline void uint16ToArrayReal( const uint16 *RESTRICT_ALIAS src,
+                                          ArrayReal *RESTRICT_ALIAS dst, size_t numChunks )
+    {
+        Real *RESTRICT_ALIAS aliasedReal = reinterpret_cast<Real *>( dst );
+        for( size_t i = 0u; i < numChunks * ARRAY_PACKED_REALS; ++i )
+            aliasedReal[i] = static_cast<Real>( src[i] );
+    }
+    //-----------------------------------------------------------------------------------
+    static inline uint16 quantizeUnorm16( Real value, Real minValue, Real step )
+    {
+        if( step <= Real( 0.0 ) )
+            return 0u;
+        const Real q = ( value - minValue ) / step + Real( 0.5 );
+        return static_cast<uint16>( Math::Clamp( q, Real( 0.0 ), Real( 65535.0 ) ) );
+    }
+    //-----------------------------------------------------------------------------------
+    /// Writes the lane 'slot' of the smallest-three encoding of q into dst
+    static void encodeSmallestThree( Quaternion q, uint16 *RESTRICT_ALIAS dst, size_t slot )
+    {
+        q.normalise();
+
+        Real *components = q.ptr();  // w, x, y, z
+        size_t largestIdx = 0u;
+        for( size_t i = 1u; i < 4u; ++i )
+        {
+            if( Math::Abs( components[i] ) > Math::Abs( components[largestIdx] ) )
+                largestIdx = i;
+        }
+
+        // q and -q are the same rotation, and the largest component is rebuilt as positive
+        const Real sign = components[largestIdx] < Real( 0.0 ) ? Real( -1.0 ) : Real( 1.0 );
+
+        size_t dstIdx = 0u;
+        for( size_t i = 0u; i < 4u; ++i )
+        {
+            if( i != largestIdx )
+            {
+                // The 3 smallest components are in range [-1 / sqrt( 2 ); 1 / sqrt( 2 )]
+                const Real q15 =
+                    ( components[i] * sign - c_smallestThreeBias ) / c_smallestThreeScale + Real( 0.5 );
+                dst[dstIdx * ARRAY_PACKED_REALS + slot] =
+                    static_cast<uint16>( Math::Clamp( q15, Real( 0.0 ), Real( 32767.0 ) ) );
+                ++dstIdx;
+            }
+        }
+
+        dst[slot] |= static_cast<uint16>( ( largestIdx >> 1u ) << 15u );
+        dst[ARRAY_PACKED_REALS + slot] |= static_cast<uint16>( ( largestIdx & 0x01u ) << 15u );
+    }
+    //-----------------------------------------------------------------------------------
+    static Real orientationError( Quaternion a, Quaternion b )
+    {
+        a.normalise();
+        b.normalise();
+        const Real cosHalfAngle = std::min( Math::Abs( a.Dot( b ) ), Real( 1.0 ) );
+        return Real( 2.0 ) * std::acos( cosHalfAngle );
+    }
+    //-----------------------------------------------------------------------------------
     SkeletonTrack::SkeletonTrack( uint32 boneBlockIdx,
                                   KfTransformArrayMemoryManager *kfTransformMemoryManager ) :
         mKeyFrameRigs( 0 ),
         mNumFrames( 0 ),
         mBoneBlockIdx( boneBlockIdx ),
         mUsedSlots( 0 ),
-        mLocalMemoryManager( kfTransformMemoryManager )
+        mLocalMemoryManager( kfTransformMemoryManager ),
+        mCompressedData( 0 ),
+        mCompressedChannels( 0 ),
+        mCompressedStride( 0 )
     {
     }
     //-----------------------------------------------------------------------------------
@@ -131,8 +198,19 @@ namespace Ogre
         ArrayVector3 *RESTRICT_ALIAS finalScale = boneTransforms[level].mScale + offset;
         ArrayQuaternion *RESTRICT_ALIAS finalRot = boneTransforms[level].mOrientation + offset;
 
-        KfTransform *RESTRICT_ALIAS prevTransf = prevFrame->mBoneTransform;
-        KfTransform *RESTRICT_ALIAS nextTransf = nextFrame->mBoneTransform;
+        const KfTransform *RESTRICT_ALIAS prevTransf = prevFrame->mBoneTransform;
+        const KfTransform *RESTRICT_ALIAS nextTransf = nextFrame->mBoneTransform;
+
+        KfTransform decompressed[2];
+        if( mCompressedData )
+        {
+            decompressKeyFrame( static_cast<size_t>( prevFrame - mKeyFrameRigs.begin() ),
+                                decompressed[0] );
+            decompressKeyFrame( static_cast<size_t>( nextFrame - mKeyFrameRigs.begin() ),
+                                decompressed[1] );
+            prevTransf = &decompressed[0];
+            nextTransf = &decompressed[1];
+        }
 
         ArrayVector3 interpPos, interpScale;
         ArrayQuaternion interpRot;
@@ -156,6 +234,90 @@ namespace Ogre
         inOutLastKnownKeyFrameRig = prevFrame;
     }
     //-----------------------------------------------------------------------------------
+    inline void SkeletonTrack::decompressKeyFrame( size_t keyFrameIdx, KfTransform &outTransform ) const
+    {
+        const CompressedKfHeader *RESTRICT_ALIAS header =
+            reinterpret_cast<const CompressedKfHeader *>( mCompressedData );
+        const uint16 *RESTRICT_ALIAS src = reinterpret_cast<const uint16 *>(
+            mCompressedData + sizeof( CompressedKfHeader ) + keyFrameIdx * mCompressedStride );
+
+        if( mCompressedChannels & CompressedPosition )
+        {
+            uint16ToArrayReal( src, outTransform.mPosition.mChunkBase, 3u );
+            outTransform.mPosition =
+                header->mPositionMin + outTransform.mPosition * header->mPositionStep;
+            src += 3u * ARRAY_PACKED_REALS;
+        }
+        else
+        {
+            outTransform.mPosition = header->mPositionMin;
+        }
+
+        if( mCompressedChannels & CompressedOrientation )
+        {
+            ArrayReal smallest[3];
+            ArrayReal largestIdx;
+            Real *RESTRICT_ALIAS aliasedSmallest = reinterpret_cast<Real *>( smallest );
+            Real *RESTRICT_ALIAS aliasedLargestIdx = reinterpret_cast<Real *>( &largestIdx );
+            for( size_t i = 0u; i < ARRAY_PACKED_REALS; ++i )
+            {
+                const uint16 w0 = src[i];
+                const uint16 w1 = src[ARRAY_PACKED_REALS + i];
+                const uint16 w2 = src[ARRAY_PACKED_REALS * 2u + i];
+                aliasedSmallest[i] = static_cast<Real>( w0 & 0x7FFFu );
+                aliasedSmallest[ARRAY_PACKED_REALS + i] = static_cast<Real>( w1 & 0x7FFFu );
+                aliasedSmallest[ARRAY_PACKED_REALS * 2u + i] = static_cast<Real>( w2 & 0x7FFFu );
+                aliasedLargestIdx[i] = static_cast<Real>( ( ( w0 >> 15u ) << 1u ) | ( w1 >> 15u ) );
+            }
+            src += 3u * ARRAY_PACKED_REALS;
+
+            const ArrayReal scale = Mathlib::SetAll( c_smallestThreeScale );
+            const ArrayReal bias = Mathlib::SetAll( c_smallestThreeBias );
+            const ArrayReal a = smallest[0] * scale + bias;
+            const ArrayReal b = smallest[1] * scale + bias;
+            const ArrayReal c = smallest[2] * scale + bias;
+
+            // Rebuild the largest component from the unit length constraint
+            ArrayReal d = Mathlib::ONE - a * a - b * b - c * c;
+            d = Mathlib::Max( d, Mathlib::fSqEpsilon );
+            d = d * Mathlib::InvSqrtNonZero4( d );
+
+            // Put the components back in place (w, x, y, z) depending on which one was omitted
+            const ArrayMaskR isW = Mathlib::CompareLess( largestIdx, Mathlib::SetAll( Real( 0.5 ) ) );
+            const ArrayMaskR isWorX = Mathlib::CompareLess( largestIdx, Mathlib::SetAll( Real( 1.5 ) ) );
+            const ArrayMaskR isNotZ = Mathlib::CompareLess( largestIdx, Mathlib::SetAll( Real( 2.5 ) ) );
+
+            outTransform.mOrientation =
+                ArrayQuaternion( Mathlib::Cmov4( d, a, isW ),                            //
+                                 Mathlib::Cmov4( a, Mathlib::Cmov4( d, b, isWorX ), isW ),  //
+                                 Mathlib::Cmov4( b, Mathlib::Cmov4( d, c, isNotZ ), isWorX ),
+                                 Mathlib::Cmov4( c, d, isNotZ ) );
+        }
+        else
+        {
+            outTransform.mOrientation = header->mConstantOrientation;
+        }
+
+        if( mCompressedChannels & CompressedScale )
+        {
+            uint16ToArrayReal( src, outTransform.mScale.mChunkBase, 3u );
+            outTransform.mScale = header->mScaleMin + outTransform.mScale * header->mScaleStep;
+        }
+        else
+        {
+            outTransform.mScale = header->mScaleMin;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonTrack::getKeyFrameTransform( size_t keyFrameIdx, KfTransform &outTransform ) const
+    {
+        assert( keyFrameIdx < mKeyFrameRigs.size() );
+        if( mCompressedData )
+            decompressKeyFrame( keyFrameIdx, outTransform );
+        else
+            outTransform = *mKeyFrameRigs[keyFrameIdx].mBoneTransform;
+    }
+    //-----------------------------------------------------------------------------------
     void SkeletonTrack::_bakeUnusedSlots()
     {
         assert( mUsedSlots <= ARRAY_PACKED_REALS );
@@ -185,4 +347,236 @@ namespace Ogre
             }
         }
     }
+    //-----------------------------------------------------------------------------------
+    size_t SkeletonTrack::getCompressedSize() const
+    {
+        return alignToNextMultiple<size_t>(
+            sizeof( CompressedKfHeader ) + mKeyFrameRigs.size() * mCompressedStride,
+            OGRE_SIMD_ALIGNMENT );
+    }
+    //-----------------------------------------------------------------------------------
+    size_t SkeletonTrack::_reduceKeyFrames( const SkeletonCompressionSettings &settings )
+    {
+        OGRE_ASSERT_LOW( !mCompressedData && "Track already compressed!" );
+        OGRE_ASSERT_LOW( !mKeyFrameRigs.empty() );
+
+        const size_t numKeyFrames = mKeyFrameRigs.size();
+        const KfTransform &firstTransf = *mKeyFrameRigs.front().mBoneTransform;
+
+        // Find out which channels never move away from the first keyframe
+        mCompressedChannels = 0u;
+        for( size_t i = 1u; i < numKeyFrames; ++i )
+        {
+            const KfTransform &transf = *mKeyFrameRigs[i].mBoneTransform;
+            for( size_t j = 0u; j < mUsedSlots; ++j )
+            {
+                Vector3 vA, vB;
+                Quaternion qA, qB;
+                firstTransf.mPosition.getAsVector3( vA, j );
+                transf.mPosition.getAsVector3( vB, j );
+                if( vA.distance( vB ) > settings.positionTolerance )
+                    mCompressedChannels |= CompressedPosition;
+                firstTransf.mOrientation.getAsQuaternion( qA, j );
+                transf.mOrientation.getAsQuaternion( qB, j );
+                if( orientationError( qA, qB ) > settings.orientationTolerance )
+                    mCompressedChannels |= CompressedOrientation;
+                firstTransf.mScale.getAsVector3( vA, j );
+                transf.mScale.getAsVector3( vB, j );
+                if( vA.distance( vB ) > settings.scaleTolerance )
+                    mCompressedChannels |= CompressedScale;
+            }
+        }
+
+        if( numKeyFrames > 2u )
+        {
+            // Greedily remove every keyframe for which all keyframes between the last kept
+            // one and the next one can still be rebuilt by interpolation
+            KeyFrameRigVec keptKeyFrames;
+            keptKeyFrames.reserve( numKeyFrames );
+            keptKeyFrames.push_back( mKeyFrameRigs.front() );
+
+            size_t prevIdx = 0u;
+            for( size_t i = 1u; i < numKeyFrames - 1u; ++i )
+            {
+                const KeyFrameRig &prevKf = mKeyFrameRigs[prevIdx];
+                const KeyFrameRig &nextKf = mKeyFrameRigs[i + 1u];
+
+                bool canRemove = true;
+                for( size_t j = prevIdx + 1u; j <= i && canRemove; ++j )
+                {
+                    const KeyFrameRig &keyFrame = mKeyFrameRigs[j];
+                    const Real w =
+                        ( keyFrame.mFrame - prevKf.mFrame ) / ( nextKf.mFrame - prevKf.mFrame );
+
+                    for( size_t k = 0u; k < mUsedSlots && canRemove; ++k )
+                    {
+                        Vector3 vA, vB, vRef;
+                        Quaternion qA, qB, qRef;
+
+                        if( mCompressedChannels & CompressedPosition )
+                        {
+                            prevKf.mBoneTransform->mPosition.getAsVector3( vA, k );
+                            nextKf.mBoneTransform->mPosition.getAsVector3( vB, k );
+                            keyFrame.mBoneTransform->mPosition.getAsVector3( vRef, k );
+                            canRemove &= vRef.distance( Math::lerp( vA, vB, w ) ) <=
+                                         settings.positionTolerance;
+                        }
+                        if( mCompressedChannels & CompressedOrientation )
+                        {
+                            prevKf.mBoneTransform->mOrientation.getAsQuaternion( qA, k );
+                            nextKf.mBoneTransform->mOrientation.getAsQuaternion( qB, k );
+                            keyFrame.mBoneTransform->mOrientation.getAsQuaternion( qRef, k );
+                            const Quaternion qInterp = Quaternion::nlerp( w, qA, qB, true );
+                            canRemove &=
+                                orientationError( qRef, qInterp ) <= settings.orientationTolerance;
+                        }
+                        if( mCompressedChannels & CompressedScale )
+                        {
+                            prevKf.mBoneTransform->mScale.getAsVector3( vA, k );
+                            nextKf.mBoneTransform->mScale.getAsVector3( vB, k );
+                            keyFrame.mBoneTransform->mScale.getAsVector3( vRef, k );
+                            canRemove &=
+                                vRef.distance( Math::lerp( vA, vB, w ) ) <= settings.scaleTolerance;
+                        }
+                    }
+                }
+
+                if( !canRemove )
+                {
+                    keptKeyFrames.push_back( mKeyFrameRigs[i] );
+                    prevIdx = i;
+                }
+            }
+
+            keptKeyFrames.push_back( mKeyFrameRigs.back() );
+
+            for( size_t i = 0u; i < keptKeyFrames.size() - 1u; ++i )
+            {
+                keptKeyFrames[i].mInvNextFrameDistance =
+                    1.0f / ( keptKeyFrames[i + 1u].mFrame - keptKeyFrames[i].mFrame );
+            }
+
+            mKeyFrameRigs.swap( keptKeyFrames );
+        }
+
+        size_t numAnimatedChannels = 0u;
+        for( uint8 channels = mCompressedChannels; channels; channels &= uint8( channels - 1u ) )
+            ++numAnimatedChannels;
+
+        mCompressedStride =
+            static_cast<uint16>( numAnimatedChannels * 3u * ARRAY_PACKED_REALS * sizeof( uint16 ) );
+
+        return getCompressedSize();
+    }
+    //-----------------------------------------------------------------------------------
+    size_t SkeletonTrack::_compress( uint8 *dstData )
+    {
+        OGRE_ASSERT_LOW( !mCompressedData && "Track already compressed!" );
+        OGRE_ASSERT_LOW( !( reinterpret_cast<uintptr_t>( dstData ) % OGRE_SIMD_ALIGNMENT ) );
+
+        CompressedKfHeader *RESTRICT_ALIAS header = reinterpret_cast<CompressedKfHeader *>( dstData );
+        const KfTransform &firstTransf = *mKeyFrameRigs.front().mBoneTransform;
+
+        // Calculate the per slot bounds. Unused slots were baked by _bakeUnusedSlots
+        // and must be decoded too, so we go through all of them
+        for( size_t i = 0u; i < ARRAY_PACKED_REALS; ++i )
+        {
+            Vector3 posMin, posMax, scaleMin, scaleMax;
+            Quaternion qRot;
+            firstTransf.mPosition.getAsVector3( posMin, i );
+            firstTransf.mScale.getAsVector3( scaleMin, i );
+            firstTransf.mOrientation.getAsQuaternion( qRot, i );
+            posMax = posMin;
+            scaleMax = scaleMin;
+
+            KeyFrameRigVec::const_iterator itor = mKeyFrameRigs.begin();
+            KeyFrameRigVec::const_iterator endt = mKeyFrameRigs.end();
+            while( itor != endt )
+            {
+                Vector3 vTmp;
+                if( mCompressedChannels & CompressedPosition )
+                {
+                    itor->mBoneTransform->mPosition.getAsVector3( vTmp, i );
+                    posMin.makeFloor( vTmp );
+                    posMax.makeCeil( vTmp );
+                }
+                if( mCompressedChannels & CompressedScale )
+                {
+                    itor->mBoneTransform->mScale.getAsVector3( vTmp, i );
+                    scaleMin.makeFloor( vTmp );
+                    scaleMax.makeCeil( vTmp );
+                }
+                ++itor;
+            }
+
+            header->mPositionMin.setFromVector3( posMin, i );
+            header->mPositionStep.setFromVector3( ( posMax - posMin ) / Real( 65535.0 ), i );
+            header->mScaleMin.setFromVector3( scaleMin, i );
+            header->mScaleStep.setFromVector3( ( scaleMax - scaleMin ) / Real( 65535.0 ), i );
+            header->mConstantOrientation.setFromQuaternion( qRot, i );
+        }
+
+        uint8 *keyFrameData = dstData + sizeof( CompressedKfHeader );
+
+        KeyFrameRigVec::iterator itor = mKeyFrameRigs.begin();
+        KeyFrameRigVec::iterator endt = mKeyFrameRigs.end();
+        while( itor != endt )
+        {
+            uint16 *RESTRICT_ALIAS dst = reinterpret_cast<uint16 *>( keyFrameData );
+            const KfTransform &transf = *itor->mBoneTransform;
+
+            for( size_t i = 0u; i < ARRAY_PACKED_REALS; ++i )
+            {
+                Vector3 vTmp, vMin, vStep;
+                Quaternion qTmp;
+                uint16 *RESTRICT_ALIAS channelDst = dst;
+
+                if( mCompressedChannels & CompressedPosition )
+                {
+                    transf.mPosition.getAsVector3( vTmp, i );
+                    header->mPositionMin.getAsVector3( vMin, i );
+                    header->mPositionStep.getAsVector3( vStep, i );
+                    for( size_t j = 0u; j < 3u; ++j )
+                    {
+                        channelDst[j * ARRAY_PACKED_REALS + i] =
+                            quantizeUnorm16( vTmp[j], vMin[j], vStep[j] );
+                    }
+                    channelDst += 3u * ARRAY_PACKED_REALS;
+                }
+                if( mCompressedChannels & CompressedOrientation )
+                {
+                    transf.mOrientation.getAsQuaternion( qTmp, i );
+                    encodeSmallestThree( qTmp, channelDst, i );
+                    channelDst += 3u * ARRAY_PACKED_REALS;
+                }
+                if( mCompressedChannels & CompressedScale )
+                {
+                    transf.mScale.getAsVector3( vTmp, i );
+                    header->mScaleMin.getAsVector3( vMin, i );
+                    header->mScaleStep.getAsVector3( vStep, i );
+                    for( size_t j = 0u; j < 3u; ++j )
+                    {
+                        channelDst[j * ARRAY_PACKED_REALS + i] =
+                            quantizeUnorm16( vTmp[j], vMin[j], vStep[j] );
+                    }
+                }
+            }
+
+            keyFrameData += mCompressedStride;
+            ++itor;
+        }
+
+        // The original KfTransforms are no longer needed
+        itor = mKeyFrameRigs.begin();
+        while( itor != endt )
+        {
+            itor->mBoneTransform = 0;
+            ++itor;
+        }
+
+        mCompressedData = dstData;
+        mLocalMemoryManager = 0;
+
+        return getCompressedSize();
+    }
 }  // namespace Ogre
@@ -112,6 +112,16 @@ namespace Ogre
         mCommandBuffer.clear();
     }
     //-----------------------------------------------------------------------------------
+    void CommandBuffer::appendCommands( CommandBuffer &other )
+    {
+        if( mCommandBuffer.empty() )
+            mCommandBuffer.swap( other.mCommandBuffer );
+        else
+            mCommandBuffer.appendPOD( other.mCommandBuffer.begin(), other.mCommandBuffer.end() );
+
+        other.mCommandBuffer.clear();
+    }
+    //-----------------------------------------------------------------------------------
     CbBase *CommandBuffer::getLastCommand()
     {
         return reinterpret_cast<CbBase *>( mCommandBuffer.end() - COMMAND_FIXED_SIZE );
@@ -639,6 +639,9 @@ namespace Ogre
             ++itor;
         }
 
+        if( sceneManager->getShadowCullingBatched() )
+            cullShadowCastersBatched( lodCamera, sceneManager );
+
         SceneManager::IlluminationRenderStage previous = sceneManager->_getCurrentRenderStage();
         sceneManager->_setCurrentRenderStage( SceneManager::IRS_RENDER_TO_TEXTURE );
 
@@ -647,6 +650,8 @@ namespace Ogre
 
         sceneManager->_setCurrentRenderStage( previous );
 
+        sceneManager->_clearBatchedShadowCull();
+
         {
             LightClosestArray::iterator it = mShadowMapCastingLights.begin();
             LightClosestArray::iterator en = mShadowMapCastingLights.end();
@@ -659,6 +664,49 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void CompositorShadowNode::cullShadowCastersBatched( const Camera *lodCamera,
+                                                         SceneManager *sceneManager )
+    {
+        ShadowMapCameraVec::const_iterator itShadowCamera = mShadowMapCameras.begin();
+
+        CompositorShadowNodeDef::ShadowMapTexDefVec::const_iterator itor =
+            mDefinition->mShadowMapTexDefinitions.begin();
+        CompositorShadowNodeDef::ShadowMapTexDefVec::const_iterator endt =
+            mDefinition->mShadowMapTexDefinitions.end();
+
+        while( itor != endt )
+        {
+            Light const *light = mShadowMapCastingLights[itor->light].light;
+
+            if( light )
+            {
+                Camera *texCamera = itShadowCamera->camera;
+                if( light->getType() != Light::LT_POINT )
+                {
+                    sceneManager->_addBatchedShadowCullCamera( texCamera );
+                }
+                else
+                {
+                    // Point lights are rendered as cubemaps, one face at a time.
+                    // See CompositorPassScene::execute
+                    const Quaternion oldCameraOrientation( texCamera->getOrientation() );
+                    for( size_t i = 0; i < 6u; ++i )
+                    {
+                        texCamera->setOrientation( oldCameraOrientation *
+                                                   CompositorPass::CubemapRotations[i] );
+                        sceneManager->_addBatchedShadowCullCamera( texCamera );
+                    }
+                    texCamera->setOrientation( oldCameraOrientation );
+                }
+            }
+
+            ++itShadowCamera;
+            ++itor;
+        }
+
+        sceneManager->_cullShadowCastersBatched( lodCamera );
+    }
+    //-----------------------------------------------------------------------------------
     void CompositorShadowNode::postInitializePass( CompositorPass *pass )
     {
         const CompositorPassDef *passDef = pass->getDefinition();
@@ -59,6 +59,7 @@ namespace Ogre
         mMaxHardLimit( maxHardLimit ),
         mCleanupThreshold( cleanupThreshold ),
         mRebaseListener( rebaseListener ),
+        mIncrementalDefragment( false ),
         mLevel( depthLevel )
     {
         // If the assert triggers, their values will overflow to 0 when
@@ -151,6 +152,12 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     size_t ArrayMemoryManager::getAllMemory() const { return mMaxMemory * mTotalMemoryMultiplier; }
     //-----------------------------------------------------------------------------------
+    size_t ArrayMemoryManager::getNumWastedSimdLanes() const
+    {
+        return alignToNextMultiple<size_t>( mUsedMemory, ARRAY_PACKED_REALS ) -
+               ( mUsedMemory - mAvailableSlots.size() );
+    }
+    //-----------------------------------------------------------------------------------
     size_t ArrayMemoryManager::createNewSlot()
     {
         size_t usedMemory = mUsedMemory;
@@ -245,7 +252,7 @@ namespace Ogre
 
             // The pool is getting to big? Do some cleanup (depending
             // on fragmentation, may take a performance hit)
-            if( mAvailableSlots.size() > mCleanupThreshold )
+            if( mAvailableSlots.size() > mCleanupThreshold && !mIncrementalDefragment )
                 defragment();
         }
     }
@@ -306,6 +313,66 @@ namespace Ogre
         mAvailableSlots.clear();
     }
     //-----------------------------------------------------------------------------------
+    size_t ArrayMemoryManager::defragmentIncremental( size_t maxSlotsToMove )
+    {
+        if( mAvailableSlots.empty() )
+            return 0;
+
+        // Highest holes first, so that trailing holes are found at the front
+        // and the lowest hole (the next one to fill) can be popped from the back.
+        std::sort( mAvailableSlots.begin(), mAvailableSlots.end(), std::greater<size_t>() );
+
+        const size_t prevUsedMemory = mUsedMemory;
+        size_t numMoved = 0;
+        size_t numTrailing = 0;
+
+        while( numTrailing < mAvailableSlots.size() )
+        {
+            if( mAvailableSlots[numTrailing] + 1u == mUsedMemory )
+            {
+                // The hole is at the end. Nothing to move.
+                --mUsedMemory;
+                ++numTrailing;
+            }
+            else if( numMoved < maxSlotsToMove )
+            {
+                const size_t dstSlot = mAvailableSlots.back();
+                const size_t srcSlot = mUsedMemory - 1u;
+                const size_t indexDst = dstSlot % ARRAY_PACKED_REALS;
+                const size_t indexSrc = srcSlot % ARRAY_PACKED_REALS;
+
+                for( size_t i = 0; i < mMemoryPools.size(); ++i )
+                {
+                    char *dstPtr = mMemoryPools[i] + dstSlot * mElementsMemSizes[i];
+                    char *srcPtr = mMemoryPools[i] + srcSlot * mElementsMemSizes[i];
+                    mCleanupRoutines[i]( dstPtr, indexDst, srcPtr, indexSrc, 1u, 0u,
+                                         mElementsMemSizes[i] );
+                    // Default-initialize the slot we've just emptied
+                    mCleanupRoutines[i]( srcPtr, indexSrc, srcPtr, indexSrc, 0u, 1u,
+                                         mElementsMemSizes[i] );
+                }
+
+                mAvailableSlots.pop_back();
+                --mUsedMemory;
+                ++numMoved;
+
+                mRebaseListener->slotMoved( mLevel, mMemoryPools, dstSlot );
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        mAvailableSlots.erase( mAvailableSlots.begin(),
+                               mAvailableSlots.begin() + static_cast<ptrdiff_t>( numTrailing ) );
+
+        if( mUsedMemory != prevUsedMemory )
+            initializeEmptySlots( mUsedMemory );
+
+        return numMoved;
+    }
+    //-----------------------------------------------------------------------------------
     void ArrayMemoryManager::shrinkToFit()
     {
         if( !mAvailableSlots.empty() )
@@ -364,6 +431,15 @@ namespace Ogre
         mRebaseListener->applyRebase( mLevel, mMemoryPools, diffsList );
     }
     //-----------------------------------------------------------------------------------
+    void ArrayMemoryManager::RebaseListener::slotMoved( uint16 level, const MemoryPoolVec &basePtrs,
+                                                        size_t dstSlot )
+    {
+        OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
+                     "This memory manager requires slots to keep their order and can't be "
+                     "defragmented incrementally",
+                     "ArrayMemoryManager::RebaseListener::slotMoved" );
+    }
+    //-----------------------------------------------------------------------------------
     void cleanerFlat( char *dstPtr, size_t indexDst, char *srcPtr, size_t indexSrc, size_t numSlots,
                       size_t numFreeSlots, size_t elementsMemSize )
     {
@@ -37,7 +37,8 @@ namespace Ogre
     NodeMemoryManager::NodeMemoryManager() :
         mDummyNode( 0 ),
         mMemoryManagerType( SCENE_DYNAMIC ),
-        mTwinMemoryManager( 0 )
+        mTwinMemoryManager( 0 ),
+        mIncrementalDefragment( false )
     {
         // Manually allocate the memory for the dummy scene nodes (since we can't pass ourselves
         // or yet another object) We only allocate what's needed to prevent access violations.
@@ -56,6 +57,8 @@ namespace Ogre
             OGRE_MALLOC_SIMD( sizeof( ArrayVector3 ), MEMCATEGORY_SCENE_OBJECTS ) );
         mDummyTransformPtrs.mDerivedTransform = reinterpret_cast<Matrix4 *>(
             OGRE_MALLOC_SIMD( sizeof( Matrix4 ) * ARRAY_PACKED_REALS, MEMCATEGORY_SCENE_OBJECTS ) );
+        mDummyTransformPtrs.mDirty = reinterpret_cast<bool *>(
+            OGRE_MALLOC_SIMD( sizeof( bool ) * ARRAY_PACKED_REALS, MEMCATEGORY_SCENE_OBJECTS ) );
 
         /*mDummyTransformPtrs.mDerivedTransform = reinterpret_cast<ArrayMatrix4*>( OGRE_MALLOC_SIMD(
                                                 sizeof( ArrayMatrix4 ), MEMCATEGORY_SCENE_OBJECTS ) );
@@ -69,6 +72,8 @@ namespace Ogre
         *mDummyTransformPtrs.mDerivedScale = ArrayVector3::UNIT_SCALE;
         for( int i = 0; i < ARRAY_PACKED_REALS; ++i )
             mDummyTransformPtrs.mDerivedTransform[i] = Matrix4::IDENTITY;
+        // The dummy never changes, so it never forces its "children" to update
+        memset( mDummyTransformPtrs.mDirty, 0, sizeof( bool ) * ARRAY_PACKED_REALS );
 
         mDummyNode = new SceneNode( mDummyTransformPtrs );
     }
@@ -98,6 +103,7 @@ namespace Ogre
         OGRE_FREE_SIMD( mDummyTransformPtrs.mDerivedScale, MEMCATEGORY_SCENE_OBJECTS );
 
         OGRE_FREE_SIMD( mDummyTransformPtrs.mDerivedTransform, MEMCATEGORY_SCENE_OBJECTS );
+        OGRE_FREE_SIMD( mDummyTransformPtrs.mDirty, MEMCATEGORY_SCENE_OBJECTS );
         /*OGRE_FREE_SIMD( mDummyTransformPtrs.mInheritOrientation, MEMCATEGORY_SCENE_OBJECTS );
         OGRE_FREE_SIMD( mDummyTransformPtrs.mInheritScale, MEMCATEGORY_SCENE_OBJECTS );*/
         mDummyTransformPtrs = Transform();
@@ -119,6 +125,7 @@ namespace Ogre
                 NodeArrayMemoryManager( (uint16)mMemoryManagers.size(), 100, mDummyNode, 100,
                                         ArrayMemoryManager::MAX_MEMORY_SLOTS, this ) );
             mMemoryManagers.back().initialize();
+            mMemoryManagers.back().setIncrementalDefragment( mIncrementalDefragment );
         }
     }
     //-----------------------------------------------------------------------------------
@@ -206,6 +213,46 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    size_t NodeMemoryManager::defragmentIncremental( size_t maxSlotsToMove )
+    {
+        size_t numMoved = 0;
+
+        ArrayMemoryManagerVec::iterator itor = mMemoryManagers.begin();
+        ArrayMemoryManagerVec::iterator endt = mMemoryManagers.end();
+
+        while( itor != endt && numMoved < maxSlotsToMove )
+        {
+            numMoved += itor->defragmentIncremental( maxSlotsToMove - numMoved );
+            ++itor;
+        }
+
+        return numMoved;
+    }
+    //-----------------------------------------------------------------------------------
+    void NodeMemoryManager::setIncrementalDefragment( bool bIncremental )
+    {
+        mIncrementalDefragment = bIncremental;
+
+        ArrayMemoryManagerVec::iterator itor = mMemoryManagers.begin();
+        ArrayMemoryManagerVec::iterator endt = mMemoryManagers.end();
+
+        while( itor != endt )
+        {
+            itor->setIncrementalDefragment( bIncremental );
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    size_t NodeMemoryManager::getNumFragmentedSlots( size_t depth ) const
+    {
+        return mMemoryManagers[depth].getNumFragmentedSlots();
+    }
+    //-----------------------------------------------------------------------------------
+    size_t NodeMemoryManager::getNumWastedSimdLanes( size_t depth ) const
+    {
+        return mMemoryManagers[depth].getNumWastedSimdLanes();
+    }
+    //-----------------------------------------------------------------------------------
     void NodeMemoryManager::migrateTo( Transform &inOutTransform, size_t depth,
                                        NodeMemoryManager *dstNodeMemoryManager )
     {
@@ -270,6 +317,13 @@ namespace Ogre
         return mMemoryManagers[depth].getFirstNode( outTransform );
     }
     //-----------------------------------------------------------------------------------
+    void NodeMemoryManager::_clearDirtyFlags( size_t firstDepth )
+    {
+        const size_t numDepths = mMemoryManagers.size();
+        for( size_t i = firstDepth; i < numDepths; ++i )
+            mMemoryManagers[i].clearDirtyFlags();
+    }
+    //-----------------------------------------------------------------------------------
     void NodeMemoryManager::buildDiffList( uint16 level, const MemoryPoolVec &basePtrs,
                                            ArrayMemoryManager::PtrdiffVec &outDiffsList )
     {
@@ -340,4 +394,16 @@ namespace Ogre
             transform.advancePack();
         }
     }
+    //---------------------------------------------------------------------
+    void NodeMemoryManager::slotMoved( uint16 level, const MemoryPoolVec &basePtrs, size_t dstSlot )
+    {
+        Transform transform;
+        this->getFirstNode( transform, level );
+        transform.advancePack( dstSlot / ARRAY_PACKED_REALS );
+        transform.mIndex = static_cast<uint8>( dstSlot % ARRAY_PACKED_REALS );
+
+        Node *owner = transform.mOwner[transform.mIndex];
+        owner->_getTransform() = transform;
+        owner->_callMemoryChangeListeners();
+    }
 }  // namespace Ogre
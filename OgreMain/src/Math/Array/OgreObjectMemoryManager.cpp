@@ -34,12 +34,18 @@ THE SOFTWARE.
 
 namespace Ogre
 {
+    const size_t ObjectMemoryManager::CullingClusterNumPacks;
+    const size_t ObjectMemoryManager::CullingClusterSize;
+    const size_t ObjectMemoryManager::CullingClusterPackSize;
+    //-----------------------------------------------------------------------------------
     ObjectMemoryManager::ObjectMemoryManager() :
+        mCullingHierarchyEnabled( false ),
         mTotalObjects( 0 ),
         mDummyNode( 0 ),
         mDummyObject( 0 ),
         mMemoryManagerType( SCENE_DYNAMIC ),
-        mTwinMemoryManager( 0 )
+        mTwinMemoryManager( 0 ),
+        mIncrementalDefragment( false )
     {
         // Manually allocate the memory for the dummy scene nodes (since we can't pass ourselves
         // or yet another object) We only allocate what's needed to prevent access violations.
@@ -87,6 +93,8 @@ namespace Ogre
 
         mMemoryManagers.clear();
 
+        setCullingHierarchyEnabled( false );
+
         delete mDummyNode;
         mDummyNode = 0;
 
@@ -123,6 +131,7 @@ namespace Ogre
                 (uint16)mMemoryManagers.size(), 100, mDummyNode, mDummyObject, 100,
                 ArrayMemoryManager::MAX_MEMORY_SLOTS, this ) );
             mMemoryManagers.back().initialize();
+            mMemoryManagers.back().setIncrementalDefragment( mIncrementalDefragment );
         }
     }
     //-----------------------------------------------------------------------------------
@@ -132,6 +141,7 @@ namespace Ogre
 
         ObjectDataArrayMemoryManager &mgr = mMemoryManagers[renderQueue];
         mgr.createNewNode( outObjectData );
+        _notifyCullingHierarchyDirty( renderQueue );
 
         ++mTotalObjects;
     }
@@ -149,6 +159,9 @@ namespace Ogre
         ObjectDataArrayMemoryManager &mgr = mMemoryManagers[oldRenderQueue];
         mgr.destroyNode( inOutObjectData );
 
+        _notifyCullingHierarchyDirty( oldRenderQueue );
+        _notifyCullingHierarchyDirty( newRenderQueue );
+
         inOutObjectData = tmp;
     }
     //-----------------------------------------------------------------------------------
@@ -156,6 +169,7 @@ namespace Ogre
     {
         ObjectDataArrayMemoryManager &mgr = mMemoryManagers[renderQueue];
         mgr.destroyNode( outObjectData );
+        _notifyCullingHierarchyDirty( renderQueue );
 
         --mTotalObjects;
     }
@@ -194,6 +208,208 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    size_t ObjectMemoryManager::defragmentIncremental( size_t maxSlotsToMove )
+    {
+        size_t numMoved = 0;
+
+        ArrayMemoryManagerVec::iterator itor = mMemoryManagers.begin();
+        ArrayMemoryManagerVec::iterator endt = mMemoryManagers.end();
+
+        while( itor != endt && numMoved < maxSlotsToMove )
+        {
+            numMoved += itor->defragmentIncremental( maxSlotsToMove - numMoved );
+            ++itor;
+        }
+
+        return numMoved;
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::setIncrementalDefragment( bool bIncremental )
+    {
+        mIncrementalDefragment = bIncremental;
+
+        ArrayMemoryManagerVec::iterator itor = mMemoryManagers.begin();
+        ArrayMemoryManagerVec::iterator endt = mMemoryManagers.end();
+
+        while( itor != endt )
+        {
+            itor->setIncrementalDefragment( bIncremental );
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    size_t ObjectMemoryManager::getNumFragmentedSlots( size_t renderQueue ) const
+    {
+        return mMemoryManagers[renderQueue].getNumFragmentedSlots();
+    }
+    //-----------------------------------------------------------------------------------
+    size_t ObjectMemoryManager::getNumWastedSimdLanes( size_t renderQueue ) const
+    {
+        return mMemoryManagers[renderQueue].getNumWastedSimdLanes();
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::setCullingHierarchyEnabled( bool bEnabled )
+    {
+        mCullingHierarchyEnabled = bEnabled;
+
+        if( !bEnabled )
+        {
+            CullingHierarchyVec::iterator itor = mCullingHierarchies.begin();
+            CullingHierarchyVec::iterator endt = mCullingHierarchies.end();
+
+            while( itor != endt )
+            {
+                OGRE_FREE_SIMD( itor->clusterAabbs, MEMCATEGORY_SCENE_CONTROL );
+                ++itor;
+            }
+
+            mCullingHierarchies.clear();
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::_notifyCullingHierarchyDirty( size_t renderQueue )
+    {
+        if( renderQueue < mCullingHierarchies.size() )
+            mCullingHierarchies[renderQueue].dirty.store( true, std::memory_order_relaxed );
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::_growCullingHierarchy( size_t renderQueue, const ObjectData &objData,
+                                                     const Aabb &aabb )
+    {
+        size_t numClusterPacks;
+        if( !_getCullingHierarchy( renderQueue, numClusterPacks ) )
+            return;
+
+        CullingHierarchy &hierarchy = mCullingHierarchies[renderQueue];
+
+        ObjectData firstObjData;
+        getFirstObjectData( firstObjData, renderQueue );
+        const size_t slot =
+            static_cast<size_t>( objData.mParents - firstObjData.mParents ) + objData.mIndex;
+        const size_t cluster = slot / CullingClusterSize;
+
+        assert( cluster / ARRAY_PACKED_REALS < numClusterPacks );
+
+        ArrayAabb &clusterAabbs = hierarchy.clusterAabbs[cluster / ARRAY_PACKED_REALS];
+        const size_t lane = cluster % ARRAY_PACKED_REALS;
+
+        Aabb clusterAabb;
+        clusterAabbs.getAsAabb( clusterAabb, lane );
+        clusterAabb.merge( aabb );
+        clusterAabbs.setFromAabb( clusterAabb, lane );
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::_prepareCullingHierarchy()
+    {
+        if( !mCullingHierarchyEnabled )
+            return;
+
+        const size_t numRenderQueues = mMemoryManagers.size();
+        if( mCullingHierarchies.size() < numRenderQueues )
+            mCullingHierarchies.resize( numRenderQueues );
+
+        for( size_t i = 0; i < numRenderQueues; ++i )
+        {
+            CullingHierarchy &hierarchy = mCullingHierarchies[i];
+
+            const size_t numObjects = mMemoryManagers[i].getNumUsedSlotsIncludingFragmented();
+            const size_t numClusterPacks =
+                ( numObjects + CullingClusterPackSize - 1u ) / CullingClusterPackSize;
+
+            if( numClusterPacks > hierarchy.capacity )
+            {
+                OGRE_FREE_SIMD( hierarchy.clusterAabbs, MEMCATEGORY_SCENE_CONTROL );
+                hierarchy.clusterAabbs = OGRE_ALLOC_T_SIMD( ArrayAabb, numClusterPacks,
+                                                            MEMCATEGORY_SCENE_CONTROL );
+                hierarchy.capacity = numClusterPacks;
+            }
+
+            hierarchy.numClusterPacks = numClusterPacks;
+            hierarchy.numObjects = numObjects;
+            hierarchy.dirty.store( false, std::memory_order_relaxed );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::_refitCullingHierarchy( size_t renderQueue, size_t firstObj,
+                                                      size_t numObjs )
+    {
+        assert( firstObj % CullingClusterPackSize == 0u );
+
+        CullingHierarchy &hierarchy = mCullingHierarchies[renderQueue];
+
+        ObjectData objData;
+        const size_t totalObjs = getFirstObjectData( objData, renderQueue );
+        assert( totalObjs == hierarchy.numObjects &&
+                "_prepareCullingHierarchy must be called before refitting" );
+
+        const size_t lastObj = std::min( firstObj + numObjs, totalObjs );
+        objData.advancePack( firstObj / ARRAY_PACKED_REALS );
+
+        const Real infinity = std::numeric_limits<Real>::infinity();
+        ArrayAabb *RESTRICT_ALIAS clusterAabbs =
+            hierarchy.clusterAabbs + firstObj / CullingClusterPackSize;
+
+        for( size_t i = firstObj; i < lastObj; i += CullingClusterPackSize )
+        {
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+            {
+                const size_t clusterStart = i + j * CullingClusterSize;
+                const size_t clusterEnd = std::min( clusterStart + CullingClusterSize, lastObj );
+
+                if( clusterStart >= clusterEnd )
+                {
+                    // Unused cluster. The cull pass never looks at objects past the end.
+                    clusterAabbs->setFromAabb( Aabb::BOX_ZERO, j );
+                    continue;
+                }
+
+                // Merge the packs in the cluster, SIMD-wide, in min/max form so that
+                // infinite boxes don't produce NaNs. Then collapse the lanes.
+                ArrayVector3 vMin( objData.mWorldAabb->getMinimum() );
+                ArrayVector3 vMax( objData.mWorldAabb->getMaximum() );
+                objData.advanceBoundsPack();
+
+                for( size_t k = clusterStart + ARRAY_PACKED_REALS; k < clusterEnd;
+                     k += ARRAY_PACKED_REALS )
+                {
+                    vMin.makeFloor( objData.mWorldAabb->getMinimum() );
+                    vMax.makeCeil( objData.mWorldAabb->getMaximum() );
+                    objData.advanceBoundsPack();
+                }
+
+                const Vector3 minimum = vMin.collapseMin();
+                const Vector3 maximum = vMax.collapseMax();
+                const Vector3 halfSize = ( maximum - minimum ) * 0.5f;
+
+                if( halfSize.x == infinity || halfSize.y == infinity || halfSize.z == infinity )
+                    clusterAabbs->setFromAabb( Aabb::BOX_INFINITE, j );
+                else
+                    clusterAabbs->setFromAabb( Aabb( ( maximum + minimum ) * 0.5f, halfSize ), j );
+            }
+
+            ++clusterAabbs;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    const ArrayAabb *ObjectMemoryManager::_getCullingHierarchy( size_t renderQueue,
+                                                               size_t &outNumClusterPacks ) const
+    {
+        outNumClusterPacks = 0;
+
+        if( renderQueue >= mCullingHierarchies.size() )
+            return 0;
+
+        const CullingHierarchy &hierarchy = mCullingHierarchies[renderQueue];
+        if( hierarchy.dirty.load( std::memory_order_relaxed ) ||
+            hierarchy.numObjects != mMemoryManagers[renderQueue].getNumUsedSlotsIncludingFragmented() )
+        {
+            return 0;
+        }
+
+        outNumClusterPacks = hierarchy.numClusterPacks;
+        return hierarchy.clusterAabbs;
+    }
+    //-----------------------------------------------------------------------------------
     size_t ObjectMemoryManager::getNumRenderQueues() const
     {
         size_t retVal = std::numeric_limits<size_t>::max();
@@ -257,6 +473,8 @@ namespace Ogre
     void ObjectMemoryManager::applyRebase( uint16 level, const MemoryPoolVec &newBasePtrs,
                                            const ArrayMemoryManager::PtrdiffVec &diffsList )
     {
+        _notifyCullingHierarchyDirty( level );
+
         ObjectData objectData;
         const size_t numObjs = this->getFirstObjectData( objectData, level );
 
@@ -279,6 +497,8 @@ namespace Ogre
                                               size_t const *elementsMemSizes, size_t startInstance,
                                               size_t diffInstances )
     {
+        _notifyCullingHierarchyDirty( level );
+
         ObjectData objectData;
         const size_t numObjs = this->getFirstObjectData( objectData, level );
 
@@ -300,4 +520,16 @@ namespace Ogre
             objectData.advancePack();
         }
     }
+    //---------------------------------------------------------------------
+    void ObjectMemoryManager::slotMoved( uint16 level, const MemoryPoolVec &basePtrs, size_t dstSlot )
+    {
+        _notifyCullingHierarchyDirty( level );
+
+        ObjectData objectData;
+        this->getFirstObjectData( objectData, level );
+        objectData.advancePack( dstSlot / ARRAY_PACKED_REALS );
+        objectData.mIndex = static_cast<uint8>( dstSlot % ARRAY_PACKED_REALS );
+
+        objectData.mOwner[objectData.mIndex]->_getObjectData() = objectData;
+    }
 }  // namespace Ogre
@@ -35,6 +35,27 @@ THE SOFTWARE.
 
 #include <fstream>
 
+// clang-format off
+#if OGRE_PLATFORM == OGRE_PLATFORM_LINUX || \
+    OGRE_PLATFORM == OGRE_PLATFORM_APPLE || \
+    OGRE_PLATFORM == OGRE_PLATFORM_APPLE_IOS || \
+    OGRE_PLATFORM == OGRE_PLATFORM_ANDROID || \
+    OGRE_PLATFORM == OGRE_PLATFORM_FREEBSD
+#   define OGRE_DATASTREAM_MMAP_POSIX
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#elif OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+#   define OGRE_DATASTREAM_MMAP_WIN32
+#   define WIN32_LEAN_AND_MEAN
+#   if !defined( NOMINMAX ) && defined( _MSC_VER )
+#       define NOMINMAX  // required to stop windows.h messing up std::min
+#   endif
+#   include <windows.h>
+#endif
+// clang-format on
+
 namespace Ogre
 {
     //-----------------------------------------------------------------------
@@ -765,5 +786,204 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    MmapDataStream::MmapDataStream( const String &name, const String &fullPath ) :
+        DataStream( name ),
+        mData( 0 ),
+        mPos( 0 ),
+        mEnd( 0 )
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+        ,
+        mFileMapping( 0 )
+#endif
+    {
+#if defined( OGRE_DATASTREAM_MMAP_POSIX )
+        const int fd = ::open( fullPath.c_str(), O_RDONLY );
+        if( fd == -1 )
+        {
+            OGRE_EXCEPT( Exception::ERR_FILE_NOT_FOUND, "Cannot open file: " + fullPath,
+                         "MmapDataStream::MmapDataStream" );
+        }
+
+        struct stat tagStat;
+        if( fstat( fd, &tagStat ) != 0 )
+        {
+            ::close( fd );
+            OGRE_EXCEPT( Exception::ERR_FILE_NOT_FOUND, "Cannot stat file: " + fullPath,
+                         "MmapDataStream::MmapDataStream" );
+        }
+
+        mSize = static_cast<size_t>( tagStat.st_size );
+
+        // mmap rejects empty ranges. An empty stream is still a valid stream
+        if( mSize > 0u )
+        {
+            void *data = mmap( 0, mSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+            if( data == MAP_FAILED )
+            {
+                ::close( fd );
+                OGRE_EXCEPT( Exception::ERR_FILE_NOT_FOUND, "Cannot map file: " + fullPath,
+                             "MmapDataStream::MmapDataStream" );
+            }
+            mData = static_cast<uchar *>( data );
+        }
+
+        // The mapping keeps its own reference to the file
+        ::close( fd );
+#elif defined( OGRE_DATASTREAM_MMAP_WIN32 )
+        HANDLE fileHandle = CreateFileA( fullPath.c_str(), GENERIC_READ, FILE_SHARE_READ, 0,
+                                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+        if( fileHandle == INVALID_HANDLE_VALUE )
+        {
+            OGRE_EXCEPT( Exception::ERR_FILE_NOT_FOUND, "Cannot open file: " + fullPath,
+                         "MmapDataStream::MmapDataStream" );
+        }
+
+        LARGE_INTEGER fileSize;
+        if( !GetFileSizeEx( fileHandle, &fileSize ) )
+        {
+            CloseHandle( fileHandle );
+            OGRE_EXCEPT( Exception::ERR_FILE_NOT_FOUND, "Cannot get size of file: " + fullPath,
+                         "MmapDataStream::MmapDataStream" );
+        }
+
+        mSize = static_cast<size_t>( fileSize.QuadPart );
+
+        if( mSize > 0u )
+        {
+            mFileMapping = CreateFileMappingA( fileHandle, 0, PAGE_WRITECOPY, 0, 0, 0 );
+            if( mFileMapping )
+                mData = static_cast<uchar *>( MapViewOfFile( mFileMapping, FILE_MAP_COPY, 0, 0, 0 ) );
+
+            if( !mData )
+            {
+                if( mFileMapping )
+                    CloseHandle( mFileMapping );
+                mFileMapping = 0;
+                CloseHandle( fileHandle );
+                OGRE_EXCEPT( Exception::ERR_FILE_NOT_FOUND, "Cannot map file: " + fullPath,
+                             "MmapDataStream::MmapDataStream" );
+            }
+        }
+
+        // The view keeps its own reference to the file
+        CloseHandle( fileHandle );
+#else
+        OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
+                     "Memory mapped files aren't supported on this platform. File: " + fullPath,
+                     "MmapDataStream::MmapDataStream" );
+#endif
+        mPos = mData;
+        mEnd = mData + mSize;
+    }
+    //-----------------------------------------------------------------------
+    MmapDataStream::~MmapDataStream() { close(); }
+    //-----------------------------------------------------------------------
+    bool MmapDataStream::isSupported()
+    {
+#if defined( OGRE_DATASTREAM_MMAP_POSIX ) || defined( OGRE_DATASTREAM_MMAP_WIN32 )
+        return true;
+#else
+        return false;
+#endif
+    }
+    //-----------------------------------------------------------------------
+    size_t MmapDataStream::read( void *buf, size_t count )
+    {
+        size_t cnt = count;
+        // Read over end of memory?
+        if( mPos + cnt > mEnd )
+            cnt = static_cast<size_t>( mEnd - mPos );
+        if( cnt == 0 )
+            return 0;
+
+        memcpy( buf, mPos, cnt );
+        mPos += cnt;
+        return cnt;
+    }
+    //-----------------------------------------------------------------------
+    size_t MmapDataStream::readLine( char *buf, size_t maxCount, const String &delim )
+    {
+        // Deal with both Unix & Windows LFs
+        const bool trimCR = delim.find_first_of( '\n' ) != String::npos;
+
+        size_t pos = 0;
+
+        // Make sure pos can never go past the end of the data
+        while( pos < maxCount && mPos < mEnd )
+        {
+            if( delim.find( static_cast<char>( *mPos ) ) != String::npos )
+            {
+                // Trim off trailing CR if this was a CR/LF entry
+                if( trimCR && pos && buf[pos - 1] == '\r' )
+                    --pos;
+
+                // Found terminator, skip and break out
+                ++mPos;
+                break;
+            }
+
+            buf[pos++] = static_cast<char>( *mPos++ );
+        }
+
+        buf[pos] = '\0';
+
+        return pos;
+    }
+    //-----------------------------------------------------------------------
+    size_t MmapDataStream::skipLine( const String &delim )
+    {
+        size_t pos = 0;
+
+        while( mPos < mEnd )
+        {
+            ++pos;
+            if( delim.find( static_cast<char>( *mPos++ ) ) != String::npos )
+                break;
+        }
+
+        return pos;
+    }
+    //-----------------------------------------------------------------------
+    void MmapDataStream::skip( long count )
+    {
+        const size_t newpos = (size_t)( ( mPos - mData ) + count );
+        assert( mData + newpos <= mEnd );
+        mPos = mData + newpos;
+    }
+    //-----------------------------------------------------------------------
+    void MmapDataStream::seek( size_t pos )
+    {
+        assert( mData + pos <= mEnd );
+        mPos = mData + pos;
+    }
+    //-----------------------------------------------------------------------
+    size_t MmapDataStream::tell() const { return static_cast<size_t>( mPos - mData ); }
+    //-----------------------------------------------------------------------
+    bool MmapDataStream::eof() const { return mPos >= mEnd; }
+    //-----------------------------------------------------------------------
+    void MmapDataStream::close()
+    {
+        mAccess = 0;
+        if( mData )
+        {
+#if defined( OGRE_DATASTREAM_MMAP_POSIX )
+            munmap( mData, mSize );
+#elif defined( OGRE_DATASTREAM_MMAP_WIN32 )
+            UnmapViewOfFile( mData );
+#endif
+            mData = 0;
+            mPos = 0;
+            mEnd = 0;
+        }
+#if defined( OGRE_DATASTREAM_MMAP_WIN32 )
+        if( mFileMapping )
+        {
+            CloseHandle( mFileMapping );
+            mFileMapping = 0;
+        }
+#endif
+    }
+    //-----------------------------------------------------------------------
 
 }  // namespace Ogre
@@ -29,6 +29,7 @@ THE SOFTWARE.
 
 #include "OgreFileSystem.h"
 
+#include "OgreDataStream.h"
 #include "OgreException.h"
 #include "OgreString.h"
 #include "OgreStringVector.h"
@@ -64,6 +65,7 @@ THE SOFTWARE.
 namespace Ogre
 {
     bool FileSystemArchive::msIgnoreHidden = true;
+    bool FileSystemArchive::msUseMemoryMapping = false;
 
     //-----------------------------------------------------------------------
     FileSystemArchive::FileSystemArchive( const String &name, const String &archType, bool readOnly ) :
@@ -327,6 +329,11 @@ namespace Ogre
                          "FileSystemArchive::open" );
         }
 
+#ifndef _OGRE_FILESYSTEM_ARCHIVE_UNICODE
+        if( readOnly && msUseMemoryMapping && MmapDataStream::isSupported() )
+            return DataStreamPtr( OGRE_NEW MmapDataStream( filename, full_path ) );
+#endif
+
         if( !readOnly )
         {
             mode |= std::ios::out;
@@ -186,14 +186,8 @@ namespace Ogre
         // Sort by distance to camera
         std::sort( mCurrentLightList.begin(), mCurrentLightList.end(), OrderLightByDistanceToCamera3D );
 
-        // Allocate the buffers if not already.
+        // Allocate the buffers if not already. The grid buffer is handled by beginGridFill.
         CachedGridBuffer &gridBuffers = cachedGrid->gridBuffers[cachedGrid->currentBufIdx];
-        if( !gridBuffers.gridBuffer )
-        {
-            const size_t p = -( ( 1 - ( 1 << ( mNumSlices << 1 ) ) ) / 3 );
-            gridBuffers.gridBuffer = mVaoManager->createTexBuffer(
-                PFG_R16_UINT, p * mTableSize * sizeof( uint16 ), BT_DYNAMIC_PERSISTENT, 0, false );
-        }
 
         const size_t bufferBytesNeeded =
             calculateBytesNeeded( std::max<size_t>( numLights, 96u ), 0u, 0u );
@@ -216,8 +210,8 @@ namespace Ogre
         fillGlobalLightListBuffer( camera, gridBuffers.globalLightListBuffer );
 
         // Fill the indexes buffer
-        uint16 *RESTRICT_ALIAS gridBuffer = reinterpret_cast<uint16 * RESTRICT_ALIAS>(
-            gridBuffers.gridBuffer->map( 0, gridBuffers.gridBuffer->getNumElements() ) );
+        const size_t numTables = -( ( 1 - ( 1 << ( mNumSlices << 1 ) ) ) / 3 );
+        uint16 *RESTRICT_ALIAS gridBuffer = beginGridFill( gridBuffers, numTables * mTableSize );
 
         silent_memset( mLightCountInCell.begin(), 0, mLightCountInCell.size() * sizeof( LightCount ) );
 
@@ -408,7 +402,8 @@ namespace Ogre
             }
         }
 
-        gridBuffers.gridBuffer->unmap( UO_KEEP_PERSISTENT );
+        // Forward3D has no decals nor cubemap probes
+        endGridFill( gridBuffers, mLightsPerCell, 0u, 0u );
 
         deleteOldGridBuffers();
     }
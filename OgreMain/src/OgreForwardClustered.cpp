@@ -74,7 +74,8 @@ namespace Ogre
         mMaxDistance( maxDistance ),
         mObjectMemoryManager( 0 ),
         mNodeMemoryManager( 0 ),
-        mDebugWireAabbFrozen( false )
+        mDebugWireAabbFrozen( false ),
+        mLightCellRangeBinning( false )
     {
         // SIMD optimization restriction.
         assert( ( width % ARRAY_PACKED_REALS ) == 0 && "Width must be multiple of ARRAY_PACKED_REALS!" );
@@ -132,6 +133,114 @@ namespace Ogre
             floorf( Math::Log2( std::max( -depth - mMinDistance, Real( 1 ) ) ) * mInvExponentK ) );
     }
     //-----------------------------------------------------------------------------------
+    ForwardClustered::LightCellRange ForwardClustered::getFullCellRange() const
+    {
+        LightCellRange range;
+        range.minPackX = 0u;
+        range.maxPackX = mWidth / ARRAY_PACKED_REALS - 1u;
+        range.minY = 0u;
+        range.maxY = mHeight - 1u;
+        range.minSlice = 0u;
+        range.maxSlice = mNumSlices - 1u;
+        return range;
+    }
+    //-----------------------------------------------------------------------------------
+    void ForwardClustered::computeLightCellRanges()
+    {
+        const size_t numLights = mCurrentLightList.size();
+        mLightCellRanges.resizePOD( numLights );
+
+        const LightCellRange fullRange = getFullCellRange();
+
+        bool canProject = mCurrentCamera->getProjectionType() == PT_PERSPECTIVE &&
+                          !mCurrentCamera->isReflected();
+#if OGRE_NO_VIEWPORT_ORIENTATIONMODE == 0
+        canProject &= mCurrentCamera->getOrientationMode() == OR_DEGREE_0;
+#endif
+        if( !canProject )
+        {
+            for( size_t i = 0; i < numLights; ++i )
+                mLightCellRanges[i] = fullRange;
+            return;
+        }
+
+        const Matrix4 &viewMatrix = mCurrentCamera->getViewMatrix( true );
+        const Real nearDistance = mCurrentCamera->getNearClipDistance();
+
+        // Same extents collectLightForSlice subdivides into cells
+        Real frustumLeft, frustumRight, frustumTop, frustumBottom;
+        mCurrentCamera->getFrustumExtents( frustumLeft, frustumRight, frustumTop, frustumBottom,
+                                           FET_TAN_HALF_ANGLES );
+        const Real cellsPerUnitX = Real( mWidth ) / ( frustumRight - frustumLeft );
+        const Real cellsPerUnitY = Real( mHeight ) / ( frustumTop - frustumBottom );
+        const Real maxCellX = Real( mWidth - 1u );
+        const Real maxCellY = Real( mHeight - 1u );
+
+        LightArray::const_iterator itLight = mCurrentLightList.begin();
+
+        for( size_t i = 0; i < numLights; ++i )
+        {
+            const Light *light = *itLight;
+            const Node *lightNode = light->getParentNode();
+            const Real lightRange = light->getAttenuationRange();
+
+            // Bounding sphere of the light's volume (the pyramid enclosing the cone for spot lights)
+            Vector3 sphereCenter = lightNode->_getDerivedPosition();
+            Real sphereRadius = lightRange;
+            const Light::LightTypes lightType = light->getType();
+            if( lightType != Light::LT_POINT && lightType != Light::LT_VPL )
+            {
+                const Real halfRange = lightRange * 0.5f;
+                const Real lenOpposite = light->getSpotlightTanHalfAngle() * lightRange;
+                sphereCenter += light->getDerivedDirection() * halfRange;
+                sphereRadius = Math::Sqrt( halfRange * halfRange + 2.0f * lenOpposite * lenOpposite );
+            }
+
+            const Vector3 vsCenter = viewMatrix.transformAffine( sphereCenter );
+            const Real minDepth = -vsCenter.z - sphereRadius;
+            const Real maxDepth = -vsCenter.z + sphereRadius;
+
+            LightCellRange range = fullRange;
+            range.minSlice = std::min( getSliceAtDepth( -minDepth ), fullRange.maxSlice );
+            range.maxSlice = std::min( getSliceAtDepth( -maxDepth ), fullRange.maxSlice );
+
+            if( minDepth > nearDistance )
+            {
+                // Whole sphere is in front of the camera. Project its bounding box: the
+                // extremes of x / depth are found at either the nearest or farthest depth.
+                const Real invMinDepth = 1.0f / minDepth;
+                const Real invMaxDepth = 1.0f / maxDepth;
+
+                const Real minX = vsCenter.x - sphereRadius;
+                const Real maxX = vsCenter.x + sphereRadius;
+                const Real minY = vsCenter.y - sphereRadius;
+                const Real maxY = vsCenter.y + sphereRadius;
+
+                Real cellMinX = ( std::min( minX * invMinDepth, minX * invMaxDepth ) - frustumLeft ) *
+                                cellsPerUnitX;
+                Real cellMaxX = ( std::max( maxX * invMinDepth, maxX * invMaxDepth ) - frustumLeft ) *
+                                cellsPerUnitX;
+                Real cellMinY = ( std::min( minY * invMinDepth, minY * invMaxDepth ) - frustumBottom ) *
+                                cellsPerUnitY;
+                Real cellMaxY = ( std::max( maxY * invMinDepth, maxY * invMaxDepth ) - frustumBottom ) *
+                                cellsPerUnitY;
+
+                cellMinX = Math::Clamp( Math::Floor( cellMinX ), Real( 0 ), maxCellX );
+                cellMaxX = Math::Clamp( Math::Floor( cellMaxX ), Real( 0 ), maxCellX );
+                cellMinY = Math::Clamp( Math::Floor( cellMinY ), Real( 0 ), maxCellY );
+                cellMaxY = Math::Clamp( Math::Floor( cellMaxY ), Real( 0 ), maxCellY );
+
+                range.minPackX = static_cast<uint32>( cellMinX ) / ARRAY_PACKED_REALS;
+                range.maxPackX = static_cast<uint32>( cellMaxX ) / ARRAY_PACKED_REALS;
+                range.minY = static_cast<uint32>( cellMinY );
+                range.maxY = static_cast<uint32>( cellMaxY );
+            }
+
+            mLightCellRanges[i] = range;
+            ++itLight;
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void ForwardClustered::execute( size_t threadId, size_t numThreads )
     {
         const size_t slicesPerThread = mNumSlices / numThreads;
@@ -144,6 +253,12 @@ namespace Ogre
             collectLightForSlice( threadId + numThreads * slicesPerThread, threadId );
     }
     //-----------------------------------------------------------------------------------
+    void ForwardClustered::execute( size_t begin, size_t end, size_t threadIdx )
+    {
+        for( size_t i = begin; i < end; ++i )
+            collectLightForSlice( i, threadIdx );
+    }
+    //-----------------------------------------------------------------------------------
     inline size_t ForwardClustered::getDecalsOffsetStart() const
     {
         return mLightsPerCell + c_reservedLightSlotsPerCell;
@@ -394,11 +509,22 @@ namespace Ogre
         const size_t numLights = mCurrentLightList.size();
         LightArray::const_iterator itLight = mCurrentLightList.begin();
 
-        // Test all lights against every frustum in this slice.
+        const size_t numPacksPerRow = mWidth / ARRAY_PACKED_REALS;
+        const LightCellRange fullRange = getFullCellRange();
+
+        // Test all lights against every frustum in this slice they may touch.
         for( size_t i = 0; i < numLights; ++i )
         {
             const Light::LightTypes lightType = ( *itLight )->getType();
 
+            const LightCellRange &cellRange =
+                mLightCellRangeBinning ? mLightCellRanges[i] : fullRange;
+            if( slice < cellRange.minSlice || slice > cellRange.maxSlice )
+            {
+                ++itLight;
+                continue;
+            }
+
             if( lightType == Light::LT_POINT || lightType == Light::LT_VPL )
             {
                 // Perform 6 planes vs sphere intersection then frustum's AABB vs sphere.
@@ -414,66 +540,72 @@ namespace Ogre
 
                 ArraySphere sphere( lightRadius, lightPos );
 
-                for( size_t j = 0; j < numPackedFrustumsPerSlice; ++j )
+                for( size_t y = cellRange.minY; y <= cellRange.maxY; ++y )
                 {
-                    const FrustumRegion *RESTRICT_ALIAS frustumRegion =
-                        mFrustumRegions.get() + frustumStartIdx + j;
+                    const size_t rowStart = y * numPacksPerRow;
+                    const size_t rowEnd = rowStart + cellRange.maxPackX;
+                    for( size_t j = rowStart + cellRange.minPackX; j <= rowEnd; ++j )
+                    {
+                        const FrustumRegion *RESTRICT_ALIAS frustumRegion =
+                            mFrustumRegions.get() + frustumStartIdx + j;
 
-                    // Test all 6 planes and AND the dot product. If one is false, then we're not visible
-                    // We perform (both lines are equivalent):
-                    //  plane[i].normal.dotProduct( lightPos ) + plane[i].d > -radius;
-                    //  plane[i].normal.dotProduct( lightPos ) + radius > -plane[i].d;
-                    ArrayReal dotResult;
-                    ArrayMaskR mask;
+                        // Test all 6 planes and AND the dot product. If one is false, then we're
+                        // not visible. We perform (both lines are equivalent):
+                        //  plane[i].normal.dotProduct( lightPos ) + plane[i].d > -radius;
+                        //  plane[i].normal.dotProduct( lightPos ) + radius > -plane[i].d;
+                        ArrayReal dotResult;
+                        ArrayMaskR mask;
 
-                    dotResult = frustumRegion->plane[0].normal.dotProduct( lightPos ) + lightRadius;
-                    mask = Mathlib::CompareGreater( dotResult, frustumRegion->plane[0].negD );
+                        dotResult = frustumRegion->plane[0].normal.dotProduct( lightPos ) + lightRadius;
+                        mask = Mathlib::CompareGreater( dotResult, frustumRegion->plane[0].negD );
 
-                    dotResult = frustumRegion->plane[1].normal.dotProduct( lightPos ) + lightRadius;
-                    mask = Mathlib::And(
-                        mask, Mathlib::CompareGreater( dotResult, frustumRegion->plane[1].negD ) );
+                        dotResult = frustumRegion->plane[1].normal.dotProduct( lightPos ) + lightRadius;
+                        mask = Mathlib::And(
+                            mask, Mathlib::CompareGreater( dotResult, frustumRegion->plane[1].negD ) );
 
-                    dotResult = frustumRegion->plane[2].normal.dotProduct( lightPos ) + lightRadius;
-                    mask = Mathlib::And(
-                        mask, Mathlib::CompareGreater( dotResult, frustumRegion->plane[2].negD ) );
+                        dotResult = frustumRegion->plane[2].normal.dotProduct( lightPos ) + lightRadius;
+                        mask = Mathlib::And(
+                            mask, Mathlib::CompareGreater( dotResult, frustumRegion->plane[2].negD ) );
 
-                    dotResult = frustumRegion->plane[3].normal.dotProduct( lightPos ) + lightRadius;
-                    mask = Mathlib::And(
-                        mask, Mathlib::CompareGreater( dotResult, frustumRegion->plane[3].negD ) );
+                        dotResult = frustumRegion->plane[3].normal.dotProduct( lightPos ) + lightRadius;
+                        mask = Mathlib::And(
+                            mask, Mathlib::CompareGreater( dotResult, frustumRegion->plane[3].negD ) );
 
-                    dotResult = frustumRegion->plane[4].normal.dotProduct( lightPos ) + lightRadius;
-                    mask = Mathlib::And(
-                        mask, Mathlib::CompareGreater( dotResult, frustumRegion->plane[4].negD ) );
+                        dotResult = frustumRegion->plane[4].normal.dotProduct( lightPos ) + lightRadius;
+                        mask = Mathlib::And(
+                            mask, Mathlib::CompareGreater( dotResult, frustumRegion->plane[4].negD ) );
 
-                    dotResult = frustumRegion->plane[5].normal.dotProduct( lightPos ) + lightRadius;
-                    mask = Mathlib::And(
-                        mask, Mathlib::CompareGreater( dotResult, frustumRegion->plane[5].negD ) );
+                        dotResult = frustumRegion->plane[5].normal.dotProduct( lightPos ) + lightRadius;
+                        mask = Mathlib::And(
+                            mask, Mathlib::CompareGreater( dotResult, frustumRegion->plane[5].negD ) );
 
-                    // Test the frustum's AABB vs sphere. If they don't intersect, we're not visible.
-                    ArrayMaskR aabbVsSphere = sphere.intersects( frustumRegion->aabb );
+                        // Test the frustum's AABB vs sphere. If they don't intersect, we're not visible.
+                        ArrayMaskR aabbVsSphere = sphere.intersects( frustumRegion->aabb );
 
-                    mask = Mathlib::And( mask, aabbVsSphere );
+                        mask = Mathlib::And( mask, aabbVsSphere );
 
-                    const uint32 scalarMask = BooleanMask4::getScalarMask( mask );
+                        const uint32 scalarMask = BooleanMask4::getScalarMask( mask );
 
-                    for( size_t k = 0; k < ARRAY_PACKED_REALS; ++k )
-                    {
-                        if( IS_BIT_SET( k, scalarMask ) )
+                        for( size_t k = 0; k < ARRAY_PACKED_REALS; ++k )
                         {
-                            const size_t idx = ( frustumStartIdx + j ) * ARRAY_PACKED_REALS + k;
-                            FastArray<LightCount>::iterator numLightsInCell =
-                                mLightCountInCell.begin() + idx;
-
-                            // assert( numLightsInCell < mLightCountInCell.end() );
-
-                            if( numLightsInCell->lightCount[0] < mLightsPerCell )
+                            if( IS_BIT_SET( k, scalarMask ) )
                             {
-                                uint16 *RESTRICT_ALIAS cellElem =
-                                    mGridBuffer + idx * mObjsPerCell +
-                                    ( numLightsInCell->lightCount[0] + c_reservedLightSlotsPerCell );
-                                *cellElem = static_cast<uint16>( i * c_ForwardPlusNumFloat4PerLight );
-                                ++numLightsInCell->lightCount[0];
-                                ++numLightsInCell->lightCount[lightType];
+                                const size_t idx = ( frustumStartIdx + j ) * ARRAY_PACKED_REALS + k;
+                                FastArray<LightCount>::iterator numLightsInCell =
+                                    mLightCountInCell.begin() + idx;
+
+                                // assert( numLightsInCell < mLightCountInCell.end() );
+
+                                if( numLightsInCell->lightCount[0] < mLightsPerCell )
+                                {
+                                    uint16 *RESTRICT_ALIAS cellElem =
+                                        mGridBuffer + idx * mObjsPerCell +
+                                        ( numLightsInCell->lightCount[0] + c_reservedLightSlotsPerCell );
+                                    *cellElem =
+                                        static_cast<uint16>( i * c_ForwardPlusNumFloat4PerLight );
+                                    ++numLightsInCell->lightCount[0];
+                                    ++numLightsInCell->lightCount[lightType];
+                                }
                             }
                         }
                     }
@@ -544,75 +676,83 @@ namespace Ogre
                 pyramidVertex[3].setAll( scalarLightPos + scalarLightDir - leftCorner );
                 pyramidVertex[4].setAll( scalarLightPos + scalarLightDir - rightCorner );
 
-                for( size_t j = 0; j < numPackedFrustumsPerSlice; ++j )
+                for( size_t y = cellRange.minY; y <= cellRange.maxY; ++y )
                 {
-                    const FrustumRegion *RESTRICT_ALIAS frustumRegion =
-                        mFrustumRegions.get() + frustumStartIdx + j;
-
-                    ArrayReal dotResult;
-                    ArrayMaskR mask;
-
-                    mask = BooleanMask4::getAllSetMask();
-
-                    // There is no intersection if for at least one of the 12 planes
-                    //(6+6) all the vertices (5+8 verts.) are on the negative side.
-
-                    // Test all 5 pyramid vertices against each of the 6 frustum planes.
-                    for( int k = 0; k < 6; ++k )
+                    const size_t rowStart = y * numPacksPerRow;
+                    const size_t rowEnd = rowStart + cellRange.maxPackX;
+                    for( size_t j = rowStart + cellRange.minPackX; j <= rowEnd; ++j )
                     {
-                        ArrayMaskR vertexMask = ARRAY_MASK_ZERO;
+                        const FrustumRegion *RESTRICT_ALIAS frustumRegion =
+                            mFrustumRegions.get() + frustumStartIdx + j;
 
-                        for( int l = 0; l < 5; ++l )
-                        {
-                            dotResult = frustumRegion->plane[k].normal.dotProduct( pyramidVertex[l] ) -
-                                        frustumRegion->plane[k].negD;
-                            vertexMask = Mathlib::Or(
-                                vertexMask, Mathlib::CompareGreater( dotResult, ARRAY_REAL_ZERO ) );
-                        }
+                        ArrayReal dotResult;
+                        ArrayMaskR mask;
 
-                        mask = Mathlib::And( mask, vertexMask );
-                    }
+                        mask = BooleanMask4::getAllSetMask();
 
-                    if( BooleanMask4::getScalarMask( mask ) != 0 )
-                    {
-                        // Test all 8 frustum corners against each of the 6 pyramid planes.
+                        // There is no intersection if for at least one of the 12 planes
+                        //(6+6) all the vertices (5+8 verts.) are on the negative side.
+
+                        // Test all 5 pyramid vertices against each of the 6 frustum planes.
                         for( int k = 0; k < 6; ++k )
                         {
                             ArrayMaskR vertexMask = ARRAY_MASK_ZERO;
 
-                            for( int l = 0; l < 8; ++l )
+                            for( int l = 0; l < 5; ++l )
                             {
                                 dotResult =
-                                    pyramidPlane[k].normal.dotProduct( frustumRegion->corners[l] ) -
-                                    pyramidPlane[k].negD;
+                                    frustumRegion->plane[k].normal.dotProduct( pyramidVertex[l] ) -
+                                    frustumRegion->plane[k].negD;
                                 vertexMask = Mathlib::Or(
                                     vertexMask, Mathlib::CompareGreater( dotResult, ARRAY_REAL_ZERO ) );
                             }
 
                             mask = Mathlib::And( mask, vertexMask );
                         }
-                    }
-
-                    const uint32 scalarMask = BooleanMask4::getScalarMask( mask );
 
-                    for( size_t k = 0; k < ARRAY_PACKED_REALS; ++k )
-                    {
-                        if( IS_BIT_SET( k, scalarMask ) )
+                        if( BooleanMask4::getScalarMask( mask ) != 0 )
                         {
-                            const size_t idx = ( frustumStartIdx + j ) * ARRAY_PACKED_REALS + k;
-                            FastArray<LightCount>::iterator numLightsInCell =
-                                mLightCountInCell.begin() + idx;
+                            // Test all 8 frustum corners against each of the 6 pyramid planes.
+                            for( int k = 0; k < 6; ++k )
+                            {
+                                ArrayMaskR vertexMask = ARRAY_MASK_ZERO;
+
+                                for( int l = 0; l < 8; ++l )
+                                {
+                                    dotResult =
+                                        pyramidPlane[k].normal.dotProduct( frustumRegion->corners[l] ) -
+                                        pyramidPlane[k].negD;
+                                    vertexMask = Mathlib::Or(
+                                        vertexMask,
+                                        Mathlib::CompareGreater( dotResult, ARRAY_REAL_ZERO ) );
+                                }
+
+                                mask = Mathlib::And( mask, vertexMask );
+                            }
+                        }
 
-                            // assert( numLightsInCell < mLightCountInCell.end() );
+                        const uint32 scalarMask = BooleanMask4::getScalarMask( mask );
 
-                            if( numLightsInCell->lightCount[0] < mLightsPerCell )
+                        for( size_t k = 0; k < ARRAY_PACKED_REALS; ++k )
+                        {
+                            if( IS_BIT_SET( k, scalarMask ) )
                             {
-                                uint16 *RESTRICT_ALIAS cellElem =
-                                    mGridBuffer + idx * mObjsPerCell +
-                                    ( numLightsInCell->lightCount[0] + c_reservedLightSlotsPerCell );
-                                *cellElem = static_cast<uint16>( i * c_ForwardPlusNumFloat4PerLight );
-                                ++numLightsInCell->lightCount[0];
-                                ++numLightsInCell->lightCount[lightType];
+                                const size_t idx = ( frustumStartIdx + j ) * ARRAY_PACKED_REALS + k;
+                                FastArray<LightCount>::iterator numLightsInCell =
+                                    mLightCountInCell.begin() + idx;
+
+                                // assert( numLightsInCell < mLightCountInCell.end() );
+
+                                if( numLightsInCell->lightCount[0] < mLightsPerCell )
+                                {
+                                    uint16 *RESTRICT_ALIAS cellElem =
+                                        mGridBuffer + idx * mObjsPerCell +
+                                        ( numLightsInCell->lightCount[0] + c_reservedLightSlotsPerCell );
+                                    *cellElem =
+                                        static_cast<uint16>( i * c_ForwardPlusNumFloat4PerLight );
+                                    ++numLightsInCell->lightCount[0];
+                                    ++numLightsInCell->lightCount[lightType];
+                                }
                             }
                         }
                     }
@@ -817,14 +957,8 @@ namespace Ogre
         // Sort by distance to camera
         std::sort( mCurrentLightList.begin(), mCurrentLightList.end(), OrderLightByDistanceToCamera );
 
-        // Allocate the buffers if not already.
+        // Allocate the buffers if not already. The grid buffer is handled by beginGridFill.
         CachedGridBuffer &gridBuffers = cachedGrid->gridBuffers[cachedGrid->currentBufIdx];
-        if( !gridBuffers.gridBuffer )
-        {
-            gridBuffers.gridBuffer = mVaoManager->createTexBuffer(
-                PFG_R16_UINT, mWidth * mHeight * mNumSlices * mObjsPerCell * sizeof( uint16 ),
-                BT_DYNAMIC_PERSISTENT, 0, false );
-        }
 
         const size_t bufferBytesNeeded =
             calculateBytesNeeded( std::max<size_t>( numLights, 96u ), std::max<size_t>( numDecals, 16u ),
@@ -847,8 +981,7 @@ namespace Ogre
         fillGlobalLightListBuffer( camera, gridBuffers.globalLightListBuffer );
 
         // Fill the indexes buffer
-        mGridBuffer = reinterpret_cast<uint16 * RESTRICT_ALIAS>(
-            gridBuffers.gridBuffer->map( 0, gridBuffers.gridBuffer->getNumElements() ) );
+        mGridBuffer = beginGridFill( gridBuffers, mWidth * mHeight * mNumSlices * mObjsPerCell );
 
         // memset( mLightCountInCell.begin(), 0, mLightCountInCell.size() * sizeof(LightCount) );
 
@@ -857,7 +990,15 @@ namespace Ogre
         mCurrentCamera->getDerivedPosition();
         mCurrentCamera->getWorldSpaceCorners();
 
-        mSceneManager->executeUserScalableTask( this, true );
+        if( mLightCellRangeBinning )
+            computeLightCellRanges();
+
+        // Slices vary a lot in cost (near slices are small, far ones contain most lights),
+        // so let the scheduler balance them one at a time instead of in uniform blocks
+        TaskScheduler *taskScheduler = mSceneManager->getTaskScheduler();
+        const TaskScheduler::TaskId taskId =
+            taskScheduler->addTask( static_cast<RangeTask *>( this ), mNumSlices, 1u );
+        taskScheduler->waitFor( taskId );
 
         if( !mDebugWireAabb.empty() && !mDebugWireAabbFrozen )
         {
@@ -878,7 +1019,7 @@ namespace Ogre
             }
         }
 
-        gridBuffers.gridBuffer->unmap( UO_KEEP_PERSISTENT );
+        endGridFill( gridBuffers, mObjsPerCell, getDecalsOffsetStart(), getCubemapProbesOffsetStart() );
         mGridBuffer = 0;
 
         deleteOldGridBuffers();
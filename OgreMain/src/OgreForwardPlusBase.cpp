@@ -34,6 +34,7 @@ THE SOFTWARE.
 #include "OgreDecal.h"
 #include "OgreHlms.h"
 #include "OgreInternalCubemapProbe.h"
+#include "OgreRenderSystem.h"
 #include "OgreRoot.h"
 #include "OgreSceneManager.h"
 #include "OgreViewport.h"
@@ -61,6 +62,7 @@ namespace Ogre
         mEnableVpls( false ),
         mDecalsEnabled( decalsEnabled ),
         mCubemapProbesEnabled( cubemapProbesEnabled ),
+        mCompactGrid( false ),
 #if !OGRE_NO_FINE_LIGHT_MASK_GRANULARITY
         mFineLightMaskGranularity( true ),
 #endif
@@ -372,6 +374,141 @@ namespace Ogre
         globalLightListBuffer->unmap( UO_KEEP_PERSISTENT );
     }
     //-----------------------------------------------------------------------------------
+    uint16 *ForwardPlusBase::beginGridFill( CachedGridBuffer &gridBuffers, size_t numGridElements )
+    {
+        if( mCompactGrid )
+        {
+            mUncompactedGrid.resizePOD( numGridElements );
+            return mUncompactedGrid.begin();
+        }
+
+        if( !gridBuffers.gridBuffer )
+        {
+            gridBuffers.gridBuffer =
+                mVaoManager->createTexBuffer( PFG_R16_UINT, numGridElements * sizeof( uint16 ),
+                                              BT_DYNAMIC_PERSISTENT, 0, false );
+        }
+
+        return reinterpret_cast<uint16 *>(
+            gridBuffers.gridBuffer->map( 0, gridBuffers.gridBuffer->getNumElements() ) );
+    }
+    //-----------------------------------------------------------------------------------
+    void ForwardPlusBase::endGridFill( CachedGridBuffer &gridBuffers, size_t objsPerCell,
+                                       size_t decalsSlotOffset, size_t cubemapSlotOffset )
+    {
+        if( !mCompactGrid )
+        {
+            gridBuffers.gridBuffer->unmap( UO_KEEP_PERSISTENT );
+            return;
+        }
+
+        const size_t numCells = mUncompactedGrid.size() / objsPerCell;
+        const size_t totalElements =
+            getCompactGridNumElements( mUncompactedGrid.begin(), numCells, objsPerCell,
+                                       decalsSlotOffset, cubemapSlotOffset, mDecalsEnabled,
+                                       mCubemapProbesEnabled );
+
+        const size_t bytesNeeded = totalElements * sizeof( uint16 );
+        if( !gridBuffers.gridBuffer || gridBuffers.gridBuffer->getNumElements() < bytesNeeded )
+        {
+            if( gridBuffers.gridBuffer )
+            {
+                if( gridBuffers.gridBuffer->getMappingState() != MS_UNMAPPED )
+                    gridBuffers.gridBuffer->unmap( UO_UNMAP_ALL );
+                mVaoManager->destroyTexBuffer( gridBuffers.gridBuffer );
+            }
+
+            // Leave some headroom so that slightly busier frames don't reallocate,
+            // but never go above what the fixed layout would use.
+            const size_t maxElements = numCells * 2u + mUncompactedGrid.size();
+            const size_t capacity = std::min( totalElements + ( totalElements >> 1u ), maxElements );
+            gridBuffers.gridBuffer = mVaoManager->createTexBuffer(
+                PFG_R16_UINT, capacity * sizeof( uint16 ), BT_DYNAMIC_PERSISTENT, 0, false );
+        }
+
+        uint16 *dstGrid =
+            reinterpret_cast<uint16 *>( gridBuffers.gridBuffer->map( 0, bytesNeeded ) );
+
+        compactGrid( dstGrid, mUncompactedGrid.begin(), numCells, objsPerCell, decalsSlotOffset,
+                     cubemapSlotOffset, mDecalsEnabled, mCubemapProbesEnabled );
+
+        gridBuffers.gridBuffer->unmap( UO_KEEP_PERSISTENT );
+    }
+    //-----------------------------------------------------------------------------------
+    size_t ForwardPlusBase::getCompactGridNumElements( const uint16 *srcGrid, size_t numCells,
+                                                       size_t objsPerCell, size_t decalsSlotOffset,
+                                                       size_t cubemapSlotOffset, bool decalsEnabled,
+                                                       bool cubemapProbesEnabled )
+    {
+        // Cubemap probes are located by skipping the decals, hence the decal count
+        // must be present if either of them is enabled.
+        const bool hasDecalCount = decalsEnabled || cubemapProbesEnabled;
+
+        size_t totalElements = numCells * 2u;
+        for( size_t i = 0u; i < numCells; ++i )
+        {
+            const uint16 *RESTRICT_ALIAS cell = srcGrid + i * objsPerCell;
+            // Slot 2 holds the total number of lights (see collectLights)
+            totalElements += 3u + cell[2];
+            if( hasDecalCount )
+                totalElements += 1u + ( decalsEnabled ? cell[decalsSlotOffset] : 0u );
+            if( cubemapProbesEnabled )
+                totalElements += 1u + cell[cubemapSlotOffset];
+        }
+
+        return totalElements;
+    }
+    //-----------------------------------------------------------------------------------
+    void ForwardPlusBase::compactGrid( uint16 *RESTRICT_ALIAS dstGrid,
+                                       const uint16 *RESTRICT_ALIAS srcGrid, size_t numCells,
+                                       size_t objsPerCell, size_t decalsSlotOffset,
+                                       size_t cubemapSlotOffset, bool decalsEnabled,
+                                       bool cubemapProbesEnabled )
+    {
+        const bool hasDecalCount = decalsEnabled || cubemapProbesEnabled;
+
+        // Prefix sum the cell sizes into the offset table and pack the lists
+        size_t offset = numCells * 2u;
+        for( size_t i = 0u; i < numCells; ++i )
+        {
+            const uint16 *RESTRICT_ALIAS cell = srcGrid + i * objsPerCell;
+
+            dstGrid[i * 2u + 0u] = static_cast<uint16>( offset >> 16u );
+            dstGrid[i * 2u + 1u] = static_cast<uint16>( offset & 0xFFFF );
+
+            const size_t numLightSlots = 3u + cell[2];
+            memcpy( dstGrid + offset, cell, numLightSlots * sizeof( uint16 ) );
+            offset += numLightSlots;
+
+            if( hasDecalCount )
+            {
+                if( decalsEnabled )
+                {
+                    const size_t numDecalSlots = 1u + cell[decalsSlotOffset];
+                    memcpy( dstGrid + offset, cell + decalsSlotOffset,
+                            numDecalSlots * sizeof( uint16 ) );
+                    offset += numDecalSlots;
+                }
+                else
+                {
+                    dstGrid[offset++] = 0u;
+                }
+            }
+
+            if( cubemapProbesEnabled )
+            {
+                const size_t numCubemapSlots = 1u + cell[cubemapSlotOffset];
+                memcpy( dstGrid + offset, cell + cubemapSlotOffset,
+                        numCubemapSlots * sizeof( uint16 ) );
+                offset += numCubemapSlots;
+            }
+        }
+
+        OGRE_ASSERT_LOW( offset == getCompactGridNumElements( srcGrid, numCells, objsPerCell,
+                                                              decalsSlotOffset, cubemapSlotOffset,
+                                                              decalsEnabled, cubemapProbesEnabled ) );
+    }
+    //-----------------------------------------------------------------------------------
     bool ForwardPlusBase::getCachedGridFor( Camera *camera, CachedGrid **outCachedGrid )
     {
         const CompositorShadowNode *shadowNode = mSceneManager->getCurrentShadowNode();
@@ -523,6 +660,30 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void ForwardPlusBase::setCompactGrid( bool bCompactGrid )
+    {
+        if( bCompactGrid )
+        {
+            // Hlms prefers glsles over glsl when available. Those legacy templates
+            // only understand the fixed layout.
+            RenderSystem *renderSystem = mSceneManager->getDestinationRenderSystem();
+            if( renderSystem && renderSystem->getCapabilities()->isShaderProfileSupported( "glsles" ) )
+            {
+                OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
+                             "Compact Forward+ grids are not supported by the GLSLES Hlms templates",
+                             "ForwardPlusBase::setCompactGrid" );
+            }
+        }
+
+        if( mCompactGrid != bCompactGrid )
+        {
+            // The existing grid buffers have the wrong layout (and size)
+            _releaseManualHardwareResources();
+            mCachedGrid.clear();
+            mCompactGrid = bCompactGrid;
+        }
+    }
+    //-----------------------------------------------------------------------------------
     bool ForwardPlusBase::isCacheDirty( const Camera *camera ) const
     {
         CachedGrid const *outCachedGrid = 0;
@@ -577,6 +738,9 @@ namespace Ogre
         if( viewport->coversEntireTarget() && !hlms->_getProperty( HlmsBaseProp::InstancedStereo ) )
             hlms->_setProperty( HlmsBaseProp::ForwardPlusCoversEntireTarget, 1 );
 
+        if( mCompactGrid )
+            hlms->_setProperty( HlmsBaseProp::ForwardPlusCompactGrid, 1 );
+
 #if !OGRE_NO_FINE_LIGHT_MASK_GRANULARITY
         if( mFineLightMaskGranularity )
             hlms->_setProperty( HlmsBaseProp::ForwardPlusFineLightMask, 1 );
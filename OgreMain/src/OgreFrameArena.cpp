@@ -0,0 +1,177 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+
+#include "OgreFrameArena.h"
+
+#include "OgreCommon.h"
+
+namespace Ogre
+{
+    FrameArena::FrameArena( size_t numFrames, size_t blockSize ) :
+        mFrames( std::max<size_t>( numFrames, 1u ) ),
+        mCurrentFrame( 0u ),
+        mBlockSize( blockSize )
+    {
+        FrameVec::iterator itor = mFrames.begin();
+        FrameVec::iterator endt = mFrames.end();
+        while( itor != endt )
+        {
+            itor->offset = 0u;
+            itor->bytesUsed = 0u;
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    FrameArena::~FrameArena() { releaseMemory(); }
+    //-----------------------------------------------------------------------------------
+    void FrameArena::addBlock( Frame &frame, size_t minCapacity )
+    {
+        Block block;
+        block.capacity = std::max( minCapacity, mBlockSize );
+        block.data = reinterpret_cast<uint8 *>(
+            OGRE_MALLOC_SIMD( block.capacity, MEMCATEGORY_GENERAL ) );
+        frame.blocks.push_back( block );
+        frame.offset = 0u;
+    }
+    //-----------------------------------------------------------------------------------
+    void *FrameArena::allocate( size_t bytes, size_t alignment )
+    {
+        OGRE_ASSERT_LOW( alignment && ( alignment & ( alignment - 1u ) ) == 0u &&
+                         "Alignment must be a power of two" );
+
+        ScopedLock lock( mMutex );
+
+        Frame &frame = mFrames[mCurrentFrame];
+
+        // Blocks are SIMD-aligned; only bigger alignments need padding
+        const size_t padding = alignment > OGRE_SIMD_ALIGNMENT ? alignment : 0u;
+
+        size_t alignedOffset = 0u;
+        if( !frame.blocks.empty() )
+            alignedOffset = alignToNextMultiple( frame.offset, alignment );
+
+        if( frame.blocks.empty() ||
+            alignedOffset + bytes + padding > frame.blocks.back().capacity )
+        {
+            addBlock( frame, bytes + padding );
+            alignedOffset = 0u;
+        }
+
+        Block &block = frame.blocks.back();
+        uint8 *retVal = block.data + alignedOffset;
+        if( padding )
+        {
+            retVal = reinterpret_cast<uint8 *>(
+                alignToNextMultiple( reinterpret_cast<size_t>( retVal ), alignment ) );
+        }
+
+        const size_t newOffset = static_cast<size_t>( retVal - block.data ) + bytes;
+        frame.bytesUsed += newOffset - frame.offset;
+        frame.offset = newOffset;
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    void FrameArena::_advanceFrame()
+    {
+        ScopedLock lock( mMutex );
+
+        mCurrentFrame = ( mCurrentFrame + 1u ) % mFrames.size();
+
+        Frame &frame = mFrames[mCurrentFrame];
+        if( frame.blocks.size() > 1u )
+        {
+            // Last time this frame didn't fit in a single block. Merge them all
+            // into one big enough, so we don't keep jumping between blocks.
+            size_t totalCapacity = 0u;
+            BlockVec::const_iterator itor = frame.blocks.begin();
+            BlockVec::const_iterator endt = frame.blocks.end();
+            while( itor != endt )
+            {
+                totalCapacity += itor->capacity;
+                OGRE_FREE_SIMD( itor->data, MEMCATEGORY_GENERAL );
+                ++itor;
+            }
+            frame.blocks.clear();
+            addBlock( frame, totalCapacity );
+        }
+
+        frame.offset = 0u;
+        frame.bytesUsed = 0u;
+    }
+    //-----------------------------------------------------------------------------------
+    void FrameArena::releaseMemory()
+    {
+        ScopedLock lock( mMutex );
+
+        FrameVec::iterator itFrame = mFrames.begin();
+        FrameVec::iterator enFrame = mFrames.end();
+        while( itFrame != enFrame )
+        {
+            BlockVec::const_iterator itor = itFrame->blocks.begin();
+            BlockVec::const_iterator endt = itFrame->blocks.end();
+            while( itor != endt )
+            {
+                OGRE_FREE_SIMD( itor->data, MEMCATEGORY_GENERAL );
+                ++itor;
+            }
+            itFrame->blocks.clear();
+            itFrame->offset = 0u;
+            itFrame->bytesUsed = 0u;
+            ++itFrame;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    size_t FrameArena::getBytesUsed() const
+    {
+        ScopedLock lock( mMutex );
+        return mFrames[mCurrentFrame].bytesUsed;
+    }
+    //-----------------------------------------------------------------------------------
+    size_t FrameArena::getBytesReserved() const
+    {
+        ScopedLock lock( mMutex );
+
+        size_t retVal = 0u;
+        FrameVec::const_iterator itFrame = mFrames.begin();
+        FrameVec::const_iterator enFrame = mFrames.end();
+        while( itFrame != enFrame )
+        {
+            BlockVec::const_iterator itor = itFrame->blocks.begin();
+            BlockVec::const_iterator endt = itFrame->blocks.end();
+            while( itor != endt )
+            {
+                retVal += itor->capacity;
+                ++itor;
+            }
+            ++itFrame;
+        }
+        return retVal;
+    }
+}  // namespace Ogre
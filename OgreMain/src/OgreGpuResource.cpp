@@ -57,6 +57,7 @@ namespace Ogre
         mRank( 1 ),
         mLastFrameUsed( vaoManager->getFrameCount() ),
         mLowestDistanceToCamera( 0 ),
+        mTouched( false ),
         mVaoManager( vaoManager ),
         mName( name )
     {
@@ -85,6 +86,10 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     uint32 GpuResource::getPendingResidencyChanges() const { return mPendingResidencyChanges; }
     //-----------------------------------------------------------------------------------
+    void GpuResource::setRank( int32 rank ) { mRank = rank; }
+    //-----------------------------------------------------------------------------------
+    int32 GpuResource::getRank() const { return mRank; }
+    //-----------------------------------------------------------------------------------
     IdString GpuResource::getName() const { return mName; }
     //-----------------------------------------------------------------------------------
     String GpuResource::getNameStr() const
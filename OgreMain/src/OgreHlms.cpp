@@ -47,6 +47,7 @@ THE SOFTWARE.
 #include "OgrePixelFormatGpuUtils.h"
 #include "OgreProfiler.h"
 #include "OgreRenderQueue.h"
+#include "OgreRoot.h"
 #include "OgreRootLayout.h"
 #include "OgreSceneManager.h"
 #include "OgreViewport.h"
@@ -63,6 +64,7 @@ THE SOFTWARE.
 #include "Hash/MurmurHash3.h"
 
 #include <fstream>
+#include <limits>
 
 #if OGRE_ARCH_TYPE == OGRE_ARCHITECTURE_32
 #    define OGRE_HASH128_FUNC MurmurHash3_x86_128
@@ -163,6 +165,7 @@ namespace Ogre
         IdString( "hlms_forwardplus_fine_light_mask" );
     const IdString HlmsBaseProp::ForwardPlusCoversEntireTarget =
         IdString( "hlms_forwardplus_covers_entire_target" );
+    const IdString HlmsBaseProp::ForwardPlusCompactGrid = IdString( "hlms_forwardplus_compact" );
     const IdString HlmsBaseProp::Forward3DNumSlices = IdString( "forward3d_num_slices" );
     const IdString HlmsBaseProp::FwdClusteredWidthxHeight = IdString( "fwd_clustered_width_x_height" );
     const IdString HlmsBaseProp::FwdClusteredWidth = IdString( "fwd_clustered_width" );
@@ -248,9 +251,17 @@ namespace Ogre
 
     static HlmsListener c_defaultListener;
 
+    const uint32 Hlms::ParallelFillStop = std::numeric_limits<uint32>::max();
+
     Hlms::Hlms( HlmsTypes type, const String &typeName, Archive *dataFolder,
                 ArchiveVec *libraryFolders ) :
+        mMaxDeferredCreationsPerFrame( 1u ),
+        mDeferredCreationsThisFrame( 0u ),
+        mDeferredCreationFrame( 0u ),
+        mNumDeferredCreations( 0u ),
+        mDeferredShaderCacheCreation( false ),
         mDataFolder( dataFolder ),
+        mTemplateSourcesLoaded( false ),
         mHlmsManager( 0 ),
         mLightGatheringMode( LightGatherForward ),
         mStaticBranchingLights( false ),
@@ -2032,6 +2043,8 @@ namespace Ogre
     void Hlms::clearShaderCache()
     {
         mPassCache.clear();
+        mPendingShaderCacheEntries.clear();
+        mPendingShaderCacheHashes.clear();
 
         // Empty mShaderCache so that mHlmsManager->destroyMacroblock would
         // be harmless even if _notifyMacroblockDestroyed gets called.
@@ -2053,9 +2066,53 @@ namespace Ogre
         shaderCache.clear();
 
         mShaderCodeCache.clear();
+
+        // Templates may have changed on disk (or mShaderFileExt may be about to change)
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            mTemplateSources[i] = TemplateSource();
+            mPieceSources[i].clear();
+        }
+        mTemplateSourcesLoaded = false;
     }
     //-----------------------------------------------------------------------------------
-    void Hlms::processPieces( Archive *archive, const StringVector &pieceFiles )
+    uint32 Hlms::scanTemplateDirectives( const String &contents )
+    {
+        uint32 directives = 0u;
+
+        if( contents.find( '@' ) == String::npos )
+            return directives;
+
+        for( size_t i = 0; i < sizeof( c_operations ) / sizeof( c_operations[0] ); ++i )
+        {
+            const String opName = String( "@" ) + c_operations[i].opName;
+            if( contents.find( opName ) != String::npos )
+                directives |= TemplateMath;
+        }
+
+        for( size_t i = 0; i < sizeof( c_counterOperations ) / sizeof( c_counterOperations[0] ); ++i )
+        {
+            const String opName = String( "@" ) + c_counterOperations[i].opName;
+            if( contents.find( opName ) != String::npos )
+                directives |= TemplateCounter;
+        }
+
+        if( contents.find( "@foreach" ) != String::npos )
+            directives |= TemplateForEach;
+        if( contents.find( "@property" ) != String::npos )
+            directives |= TemplateProperty;
+        if( contents.find( "@undefpiece" ) != String::npos )
+            directives |= TemplateUndefPiece;
+        if( contents.find( "@piece" ) != String::npos )
+            directives |= TemplatePiece;
+        if( contents.find( "@insertpiece" ) != String::npos )
+            directives |= TemplateInsertPiece;
+
+        return directives;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::loadPieceSources( Archive *archive, const StringVector &pieceFiles,
+                                 TemplateSourceVec &outSources ) const
     {
         StringVector::const_iterator itor = pieceFiles.begin();
         StringVector::const_iterator endt = pieceFiles.end();
@@ -2069,22 +2126,116 @@ namespace Ogre
             {
                 DataStreamPtr inFile = archive->open( *itor );
 
-                String inString;
-                String outString;
+                outSources.push_back( TemplateSource() );
+                TemplateSource &source = outSources.back();
+                source.contents.resize( inFile->size() );
+                if( !source.contents.empty() )
+                    inFile->read( &source.contents[0], inFile->size() );
+                source.directives = scanTemplateDirectives( source.contents );
+                source.exists = true;
+            }
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::loadTemplateSources()
+    {
+        if( mTemplateSourcesLoaded )
+            return;
+
+        OgreProfileExhaustive( "Hlms::loadTemplateSources" );
+
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            mTemplateSources[i] = TemplateSource();
+            mPieceSources[i].clear();
+
+            const String filename = ShaderFiles[i] + mShaderFileExt;
+            if( mDataFolder->exists( filename ) )
+            {
+                TemplateSource &source = mTemplateSources[i];
+
+                DataStreamPtr inFile = mDataFolder->open( filename );
+                source.contents.resize( inFile->size() );
+                if( !source.contents.empty() )
+                    inFile->read( &source.contents[0], inFile->size() );
+                source.directives = scanTemplateDirectives( source.contents );
+                source.exists = true;
+
+                // Library piece files first
+                LibraryVec::const_iterator itor = mLibrary.begin();
+                LibraryVec::const_iterator endt = mLibrary.end();
+
+                while( itor != endt )
+                {
+                    loadPieceSources( itor->dataFolder, itor->pieceFiles[i], mPieceSources[i] );
+                    ++itor;
+                }
 
-                inString.resize( inFile->size() );
-                inFile->read( &inString[0], inFile->size() );
+                // Main piece files
+                loadPieceSources( mDataFolder, mPieceFiles[i], mPieceSources[i] );
+            }
+        }
 
-                this->parseMath( inString, outString );
-                while( outString.find( "@foreach" ) != String::npos )
+        mTemplateSourcesLoaded = true;
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::parseTemplateSource( const TemplateSource &source, String &tmpBuffer,
+                                    String &outBuffer )
+    {
+        bool syntaxError = false;
+
+        if( source.directives & TemplateMath )
+            syntaxError |= this->parseMath( source.contents, outBuffer );
+        else
+            outBuffer = source.contents;
+
+        if( source.directives & TemplateForEach )
+        {
+            while( !syntaxError && outBuffer.find( "@foreach" ) != String::npos )
+            {
+                syntaxError |= this->parseForEach( outBuffer, tmpBuffer );
+                tmpBuffer.swap( outBuffer );
+            }
+        }
+
+        if( source.directives & TemplateProperty )
+        {
+            syntaxError |= this->parseProperties( outBuffer, tmpBuffer );
+            tmpBuffer.swap( outBuffer );
+        }
+
+        if( source.directives & TemplateUndefPiece )
+        {
+            syntaxError |= this->parseUndefPieces( outBuffer, tmpBuffer );
+            tmpBuffer.swap( outBuffer );
+        }
+
+        return syntaxError;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::processPieces( const TemplateSourceVec &pieceSources )
+    {
+        String inString;
+        String outString;
+
+        TemplateSourceVec::const_iterator itor = pieceSources.begin();
+        TemplateSourceVec::const_iterator endt = pieceSources.end();
+
+        while( itor != endt )
+        {
+            // A file without directives can't define pieces nor modify properties.
+            // Only the side effects matter here; the processed text gets discarded.
+            if( itor->directives )
+            {
+                this->parseTemplateSource( *itor, inString, outString );
+                if( itor->directives & TemplatePiece )
                 {
-                    this->parseForEach( outString, inString );
+                    this->collectPieces( outString, inString );
                     inString.swap( outString );
                 }
-                this->parseProperties( outString, inString );
-                this->parseUndefPieces( inString, outString );
-                this->collectPieces( outString, inString );
-                this->parseCounter( inString, outString );
+                if( itor->directives & TemplateCounter )
+                    this->parseCounter( outString, inString );
             }
             ++itor;
         }
@@ -2276,14 +2427,16 @@ namespace Ogre
 
         mSetProperties = codeCache.mergedCache.setProperties;
 
+        loadTemplateSources();
+
         // Generate the shaders
         for( size_t i = 0; i < NumShaderTypes; ++i )
         {
             // Collect pieces
             mPieces = codeCache.mergedCache.pieces[i];
 
-            const String filename = ShaderFiles[i] + mShaderFileExt;
-            if( mDataFolder->exists( filename ) )
+            const TemplateSource &templateSource = mTemplateSources[i];
+            if( templateSource.exists )
             {
                 if( mShaderProfile == "glsl" || mShaderProfile == "glslvk" )  // TODO: String comparision
                 {
@@ -2333,38 +2486,14 @@ namespace Ogre
                         dumpProperties( debugDumpFile );
                 }
 
-                // Library piece files first
-                LibraryVec::const_iterator itor = mLibrary.begin();
-                LibraryVec::const_iterator endt = mLibrary.end();
-
-                while( itor != endt )
-                {
-                    processPieces( itor->dataFolder, itor->pieceFiles[i] );
-                    ++itor;
-                }
-
-                // Main piece files
-                processPieces( mDataFolder, mPieceFiles[i] );
+                // Library piece files first, then main piece files
+                processPieces( mPieceSources[i] );
 
                 // Generate the shader file.
-                DataStreamPtr inFile = mDataFolder->open( filename );
-
                 String inString;
                 String outString;
 
-                inString.resize( inFile->size() );
-                inFile->read( &inString[0], inFile->size() );
-
-                bool syntaxError = false;
-
-                syntaxError |= this->parseMath( inString, outString );
-                while( !syntaxError && outString.find( "@foreach" ) != String::npos )
-                {
-                    syntaxError |= this->parseForEach( outString, inString );
-                    inString.swap( outString );
-                }
-                syntaxError |= this->parseProperties( outString, inString );
-                syntaxError |= this->parseUndefPieces( inString, outString );
+                bool syntaxError = parseTemplateSource( templateSource, inString, outString );
                 while( !syntaxError && ( outString.find( "@piece" ) != String::npos ||
                                          outString.find( "@insertpiece" ) != String::npos ) )
                 {
@@ -3421,13 +3550,11 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
-    const HlmsCache *Hlms::getMaterial( HlmsCache const *lastReturnedValue,        //
-                                        const HlmsCache &passCache,                //
-                                        const QueuedRenderable &queuedRenderable,  //
-                                        bool casterPass )
+    /// Fills hash[0] with the Renderable's hash and returns the final hash of the shader cache entry
+    static uint32 calculateMaterialHash( const HlmsCache &passCache,
+                                         const QueuedRenderable &queuedRenderable, bool casterPass,
+                                         uint32 hash[2] )
     {
-        uint32 finalHash;
-        uint32 hash[2];
         hash[0] = casterPass ? queuedRenderable.renderable->getHlmsCasterHash()
                              : queuedRenderable.renderable->getHlmsHash();
         hash[1] = passCache.hash;
@@ -3440,7 +3567,16 @@ namespace Ogre
         assert( ( hash[1] >> HlmsBits::PassShift ) <= HlmsBits::PassMask &&
                 "Should never happen (we assert in preparePassHash)" );
 
-        finalHash = hash[0] | hash[1];
+        return hash[0] | hash[1];
+    }
+    //-----------------------------------------------------------------------------------
+    const HlmsCache *Hlms::getMaterial( HlmsCache const *lastReturnedValue,        //
+                                        const HlmsCache &passCache,                //
+                                        const QueuedRenderable &queuedRenderable,  //
+                                        bool casterPass, bool bAllowDeferred )
+    {
+        uint32 hash[2];
+        const uint32 finalHash = calculateMaterialHash( passCache, queuedRenderable, casterPass, hash );
 
         if( lastReturnedValue->hash != finalHash )
         {
@@ -3448,6 +3584,23 @@ namespace Ogre
 
             if( !lastReturnedValue )
             {
+                if( bAllowDeferred && mDeferredShaderCacheCreation )
+                {
+                    // Don't queue it twice (other Renderables may share the entry)
+                    if( mPendingShaderCacheHashes.insert( finalHash ).second )
+                    {
+                        PendingShaderCacheEntry pendingEntry;
+                        pendingEntry.renderableHash = hash[0];
+                        pendingEntry.finalHash = finalHash;
+                        pendingEntry.passCache = passCache;
+                        pendingEntry.renderable = queuedRenderable.renderable;
+                        pendingEntry.movableObject = queuedRenderable.movableObject;
+                        mPendingShaderCacheEntries.push_back( pendingEntry );
+                    }
+
+                    return 0;
+                }
+
                 lastReturnedValue =
                     createShaderCacheEntry( hash[0], passCache, finalHash, queuedRenderable );
             }
@@ -3456,6 +3609,113 @@ namespace Ogre
         return lastReturnedValue;
     }
     //-----------------------------------------------------------------------------------
+    const HlmsCache *Hlms::getMaterialIfCached( HlmsCache const *lastReturnedValue,
+                                                const HlmsCache &passCache,
+                                                const QueuedRenderable &queuedRenderable,
+                                                bool casterPass ) const
+    {
+        uint32 hash[2];
+        const uint32 finalHash = calculateMaterialHash( passCache, queuedRenderable, casterPass, hash );
+
+        if( lastReturnedValue->hash != finalHash )
+            lastReturnedValue = this->getShaderCache( finalHash );
+
+        return lastReturnedValue;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::_createPendingShaderCacheEntries()
+    {
+        if( mPendingShaderCacheEntries.empty() )
+            return;
+
+        const unsigned long currentFrame = Root::getSingleton().getNextFrameNumber();
+        if( mDeferredCreationFrame != currentFrame )
+        {
+            mDeferredCreationFrame = currentFrame;
+            mDeferredCreationsThisFrame = 0u;
+        }
+
+        // When deferred creation is disabled, whatever is left gets created at once
+        const uint32 maxCreations = mDeferredShaderCacheCreation ? mMaxDeferredCreationsPerFrame
+                                                                 : std::numeric_limits<uint32>::max();
+
+        size_t numProcessed = 0u;
+        const size_t numPending = mPendingShaderCacheEntries.size();
+        while( numProcessed < numPending && mDeferredCreationsThisFrame < maxCreations )
+        {
+            const PendingShaderCacheEntry pendingEntry = mPendingShaderCacheEntries[numProcessed];
+            ++numProcessed;
+            mPendingShaderCacheHashes.erase( pendingEntry.finalHash );
+
+            // The entry may have been created synchronously in the meantime
+            // (e.g. by RenderQueue::renderSingleObject)
+            if( !getShaderCache( pendingEntry.finalHash ) )
+            {
+                const QueuedRenderable queuedRenderable( 0u, pendingEntry.renderable,
+                                                         pendingEntry.movableObject );
+                createShaderCacheEntry( pendingEntry.renderableHash, pendingEntry.passCache,
+                                        pendingEntry.finalHash, queuedRenderable );
+                ++mDeferredCreationsThisFrame;
+                ++mNumDeferredCreations;
+            }
+        }
+
+        mPendingShaderCacheEntries.erase( mPendingShaderCacheEntries.begin(),
+                                          mPendingShaderCacheEntries.begin() +
+                                              static_cast<ptrdiff_t>( numProcessed ) );
+    }
+    //-----------------------------------------------------------------------------------
+    size_t Hlms::fillBuffersForV2Batch( const HlmsCache *cache,
+                                        const QueuedRenderable *queuedRenderables,
+                                        size_t numRenderables, bool casterPass,
+                                        uint32 *outBaseInstances )
+    {
+        return 0u;
+    }
+    //-----------------------------------------------------------------------------------
+    size_t Hlms::getParallelFillMaxDraws( bool casterPass ) const { return 0u; }
+    //-----------------------------------------------------------------------------------
+    void Hlms::_beginParallelFill( CommandBuffer *commandBuffer, const size_t *numDrawsPerSegment,
+                                   size_t numSegments, bool casterPass )
+    {
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::_beginParallelFillSegment( size_t segmentIdx, const QueuedRenderable &queuedRenderable,
+                                          bool casterPass, CommandBuffer *commandBuffer )
+    {
+    }
+    //-----------------------------------------------------------------------------------
+    uint32 Hlms::fillBuffersForV2Parallel( size_t segmentIdx, const HlmsCache *cache,
+                                           const QueuedRenderable &queuedRenderable, bool casterPass,
+                                           CommandBuffer *commandBuffer )
+    {
+        return ParallelFillStop;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::_endParallelFill( CommandBuffer *const *segmentCommandBuffers ) {}
+    //-----------------------------------------------------------------------------------
+    void Hlms::_notifyRenderableUnlinked( Renderable *renderable )
+    {
+        PendingShaderCacheEntryVec::iterator itor = mPendingShaderCacheEntries.begin();
+        while( itor != mPendingShaderCacheEntries.end() )
+        {
+            if( itor->renderable == renderable )
+            {
+                mPendingShaderCacheHashes.erase( itor->finalHash );
+                itor = mPendingShaderCacheEntries.erase( itor );
+            }
+            else
+                ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::setDeferredShaderCacheCreation( bool bDeferred, uint32 maxCreationsPerFrame )
+    {
+        OGRE_ASSERT_LOW( maxCreationsPerFrame > 0u );
+        mDeferredShaderCacheCreation = bDeferred;
+        mMaxDeferredCreationsPerFrame = maxCreationsPerFrame;
+    }
+    //-----------------------------------------------------------------------------------
     void Hlms::setDebugOutputPath( bool enableDebugOutput, bool outputProperties, const String &path )
     {
         mDebugOutput = enableDebugOutput;
@@ -428,6 +428,8 @@ namespace Ogre
             ( *itor )->mHlmsGlobalIndex = static_cast<uint32>( itor - mLinkedRenderables.begin() );
 
         renderable->mHlmsGlobalIndex = std::numeric_limits<uint32>::max();
+
+        mCreator->_notifyRenderableUnlinked( renderable );
     }
     //-----------------------------------------------------------------------------------
     void HlmsDatablock::updateMacroblockHash( bool casterPass )
@@ -496,6 +498,8 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void HlmsDatablock::preload() {}
     //-----------------------------------------------------------------------------------
+    void HlmsDatablock::_touchTextures( uint32 frameCount, float distanceToCamera ) {}
+    //-----------------------------------------------------------------------------------
     bool HlmsDatablock::hasCustomShadowMacroblock() const
     {
         const HlmsMacroblock *macroblock0 = mMacroblock[0];
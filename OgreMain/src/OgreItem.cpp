@@ -67,9 +67,11 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void Item::loadingComplete( Resource *res )
     {
-        if( res == mMesh.get() && mInitialised )
+        if( res == mMesh.get() )
         {
-            _initialise( true );
+            // If we're not initialised, the mesh was being loaded in the
+            // background when we were created (see MeshManager::loadAsync)
+            _initialise( mInitialised );
         }
     }
     //-----------------------------------------------------------------------
@@ -49,6 +49,7 @@ namespace Ogre
     LogManager::~LogManager()
     {
         OGRE_LOCK_AUTO_MUTEX;
+        ScopedLock scopedLock( mLogsMutex );
         // Destroy all logs
         LogList::iterator i;
         for( i = mLogs.begin(); i != mLogs.end(); ++i )
@@ -64,6 +65,8 @@ namespace Ogre
 
         Log *newLog = OGRE_NEW Log( name, debuggerOutput, suppressFileOutput );
 
+        ScopedLock scopedLock( mLogsMutex );
+
         if( !mDefaultLog || defaultLog )
         {
             mDefaultLog = newLog;
@@ -77,12 +80,14 @@ namespace Ogre
     Log *LogManager::getDefaultLog()
     {
         OGRE_LOCK_AUTO_MUTEX;
+        ScopedLock scopedLock( mLogsMutex );
         return mDefaultLog;
     }
     //-----------------------------------------------------------------------
     Log *LogManager::setDefaultLog( Log *newLog )
     {
         OGRE_LOCK_AUTO_MUTEX;
+        ScopedLock scopedLock( mLogsMutex );
         Log *oldLog = mDefaultLog;
         mDefaultLog = newLog;
         return oldLog;
@@ -91,15 +96,25 @@ namespace Ogre
     Log *LogManager::getLog( const String &name )
     {
         OGRE_LOCK_AUTO_MUTEX;
-        LogList::iterator i = mLogs.find( name );
-        if( i != mLogs.end() )
-            return i->second;
-        else
+        Log *log = 0;
+        {
+            ScopedLock scopedLock( mLogsMutex );
+            LogList::iterator i = mLogs.find( name );
+            if( i != mLogs.end() )
+                log = i->second;
+        }
+
+        // Exceptions log themselves, hence throw without holding mLogsMutex
+        if( !log )
             OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, "Log not found. ", "LogManager::getLog" );
+
+        return log;
     }
     //-----------------------------------------------------------------------
     void LogManager::destroyLog( const String &name )
     {
+        ScopedLock scopedLock( mLogsMutex );
+
         LogList::iterator i = mLogs.find( name );
         if( i != mLogs.end() )
         {
@@ -130,6 +145,7 @@ namespace Ogre
     void LogManager::logMessage( const String &message, LogMessageLevel lml, bool maskDebug )
     {
         OGRE_LOCK_AUTO_MUTEX;
+        ScopedLock scopedLock( mLogsMutex );
         if( mDefaultLog )
         {
             mDefaultLog->logMessage( message, lml, maskDebug );
@@ -139,6 +155,7 @@ namespace Ogre
     void LogManager::setLogDetail( LoggingLevel ll )
     {
         OGRE_LOCK_AUTO_MUTEX;
+        ScopedLock scopedLock( mLogsMutex );
         if( mDefaultLog )
         {
             mDefaultLog->setLogDetail( ll );
@@ -148,9 +165,12 @@ namespace Ogre
     Log::Stream LogManager::stream( LogMessageLevel lml, bool maskDebug )
     {
         OGRE_LOCK_AUTO_MUTEX;
-        if( mDefaultLog )
-            return mDefaultLog->stream( lml, maskDebug );
-        else
-            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, "Default log not found. ", "LogManager::stream" );
+        {
+            ScopedLock scopedLock( mLogsMutex );
+            if( mDefaultLog )
+                return mDefaultLog->stream( lml, maskDebug );
+        }
+
+        OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, "Default log not found. ", "LogManager::stream" );
     }
 }  // namespace Ogre
@@ -0,0 +1,511 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+
+#include "OgrePrerequisites.h"
+#if OGRE_MEMORY_ALLOCATOR == OGRE_MEMORY_ALLOCATOR_POOLED
+
+#    include "OgreMemoryPooledAlloc.h"
+
+#    include "OgreAlignedAllocator.h"
+#    include "OgreBitwise.h"
+#    include "Threading/OgreLightweightMutex.h"
+
+#    include <atomic>
+
+namespace Ogre
+{
+    namespace
+    {
+        /// Prefixes every block. Being 16 bytes long keeps the payload 16-byte aligned.
+        struct BlockHeader
+        {
+            uint32 sizeClass;
+            uint32 category;
+            uint64 bytes;
+        };
+
+        /// Free blocks reuse their header to link to the next free block.
+        struct FreeBlock
+        {
+            FreeBlock *next;
+        };
+
+        const uint32 c_numSizeClasses = 44u;
+        const uint32 c_largeSizeClass = 0xFFFFFFFF;
+        const size_t c_maxPooledBytes = 32768u;
+        const size_t c_chunkBytes = 64u * 1024u;
+        /// How many bytes worth of blocks move between a thread and the shared pool at once
+        const size_t c_batchBytes = 16u * 1024u;
+        /// Threads publish their statistics once they drift by more than this amount
+        const ptrdiff_t c_statsPublishThreshold = 64 * 1024;
+
+        /** Size classes are 16 byte steps up to 256 bytes, then 4 steps per power of two
+            up to c_maxPooledBytes, i.e. 320, 384, 448, 512, 640, 768, ... 32768.
+        */
+        inline uint32 getSizeClass( size_t bytes )
+        {
+            if( bytes <= 256u )
+                return bytes ? static_cast<uint32>( ( bytes - 1u ) >> 4u ) : 0u;
+
+            const uint32 v = static_cast<uint32>( bytes - 1u );
+            const uint32 msb = 31u - Bitwise::clz32( v );
+            return 16u + ( msb - 8u ) * 4u + ( ( v >> ( msb - 2u ) ) & 0x03u );
+        }
+
+        inline size_t getSizeClassBytes( uint32 sizeClass )
+        {
+            if( sizeClass < 16u )
+                return ( sizeClass + 1u ) << 4u;
+
+            const uint32 msb = 8u + ( sizeClass - 16u ) / 4u;
+            return size_t( 5u + ( ( sizeClass - 16u ) & 0x03u ) ) << ( msb - 2u );
+        }
+
+        inline size_t getBlockBytes( uint32 sizeClass )
+        {
+            return getSizeClassBytes( sizeClass ) + sizeof( BlockHeader );
+        }
+
+        inline uint32 getBatchSize( uint32 sizeClass )
+        {
+            const size_t batchSize = c_batchBytes / getBlockBytes( sizeClass );
+            return static_cast<uint32>( std::min<size_t>( std::max<size_t>( batchSize, 4u ), 64u ) );
+        }
+
+        struct SharedSizeClass
+        {
+            LightweightMutex mutex;
+            FreeBlock *freeList;
+            size_t numFree;
+        };
+
+        struct SharedCategoryStats
+        {
+            std::atomic<ptrdiff_t> liveBytes;
+            std::atomic<ptrdiff_t> peakBytes;
+            std::atomic<ptrdiff_t> liveAllocations;
+            std::atomic<size_t> totalAllocations;
+        };
+
+        struct SharedPool
+        {
+            SharedSizeClass sizeClasses[c_numSizeClasses];
+            SharedCategoryStats stats[MEMCATEGORY_COUNT];
+            std::atomic<size_t> reservedBytes;
+
+            SharedPool()
+            {
+                for( size_t i = 0u; i < c_numSizeClasses; ++i )
+                {
+                    sizeClasses[i].freeList = 0;
+                    sizeClasses[i].numFree = 0u;
+                }
+                for( size_t i = 0u; i < MEMCATEGORY_COUNT; ++i )
+                {
+                    stats[i].liveBytes.store( 0 );
+                    stats[i].peakBytes.store( 0 );
+                    stats[i].liveAllocations.store( 0 );
+                    stats[i].totalAllocations.store( 0u );
+                }
+                reservedBytes.store( 0u );
+            }
+        };
+
+        /// The pool is never destroyed: static destructors which run after ours, and
+        /// threads outliving main(), may still free memory.
+        SharedPool &getSharedPool()
+        {
+            static SharedPool *sharedPool =
+                new( AlignedMemory::allocate( sizeof( SharedPool ) ) ) SharedPool();
+            return *sharedPool;
+        }
+
+        struct ThreadSizeClass
+        {
+            FreeBlock *freeList;
+            uint32 numFree;
+            uint32 batchSize;
+        };
+
+        struct ThreadCache
+        {
+            ThreadSizeClass sizeClasses[c_numSizeClasses];
+            ptrdiff_t liveBytes[MEMCATEGORY_COUNT];
+            ptrdiff_t liveAllocations[MEMCATEGORY_COUNT];
+            size_t totalAllocations[MEMCATEGORY_COUNT];
+
+            ThreadCache()
+            {
+                for( uint32 i = 0u; i < c_numSizeClasses; ++i )
+                {
+                    sizeClasses[i].freeList = 0;
+                    sizeClasses[i].numFree = 0u;
+                    sizeClasses[i].batchSize = getBatchSize( i );
+                }
+                for( size_t i = 0u; i < MEMCATEGORY_COUNT; ++i )
+                {
+                    liveBytes[i] = 0;
+                    liveAllocations[i] = 0;
+                    totalAllocations[i] = 0u;
+                }
+            }
+        };
+
+        // Kept as plain pointers/flags (trivially destructible) so they can still be
+        // queried while the thread is shutting down.
+        thread_local ThreadCache *tCache = 0;
+        thread_local bool tCacheRetired = false;
+
+        void publishStats( ThreadCache *cache, size_t category )
+        {
+            SharedCategoryStats &stats = getSharedPool().stats[category];
+
+            stats.totalAllocations.fetch_add( cache->totalAllocations[category],
+                                              std::memory_order_relaxed );
+            stats.liveAllocations.fetch_add( cache->liveAllocations[category],
+                                             std::memory_order_relaxed );
+            const ptrdiff_t liveBytes =
+                stats.liveBytes.fetch_add( cache->liveBytes[category], std::memory_order_relaxed ) +
+                cache->liveBytes[category];
+
+            ptrdiff_t peakBytes = stats.peakBytes.load( std::memory_order_relaxed );
+            while( liveBytes > peakBytes &&
+                   !stats.peakBytes.compare_exchange_weak( peakBytes, liveBytes,
+                                                           std::memory_order_relaxed ) )
+            {
+            }
+
+            cache->totalAllocations[category] = 0u;
+            cache->liveAllocations[category] = 0;
+            cache->liveBytes[category] = 0;
+        }
+
+        /// Detaches the first numBlocks blocks of the thread's list into the shared pool.
+        void returnToSharedPool( ThreadSizeClass &local, uint32 sizeClass, uint32 numBlocks )
+        {
+            FreeBlock *first = local.freeList;
+            FreeBlock *last = first;
+            for( uint32 i = 1u; i < numBlocks; ++i )
+                last = last->next;
+            local.freeList = last->next;
+            local.numFree -= numBlocks;
+
+            SharedSizeClass &shared = getSharedPool().sizeClasses[sizeClass];
+            ScopedLock lock( shared.mutex );
+            last->next = shared.freeList;
+            shared.freeList = first;
+            shared.numFree += numBlocks;
+        }
+
+        void releaseThreadCache( ThreadCache *cache )
+        {
+            for( uint32 i = 0u; i < c_numSizeClasses; ++i )
+            {
+                if( cache->sizeClasses[i].numFree )
+                    returnToSharedPool( cache->sizeClasses[i], i, cache->sizeClasses[i].numFree );
+            }
+            for( size_t i = 0u; i < MEMCATEGORY_COUNT; ++i )
+                publishStats( cache, i );
+        }
+
+        struct ThreadCacheReaper
+        {
+            void registerThread() {}
+            ~ThreadCacheReaper()
+            {
+                ThreadCache *cache = tCache;
+                tCache = 0;
+                tCacheRetired = true;
+                if( cache )
+                {
+                    releaseThreadCache( cache );
+                    cache->~ThreadCache();
+                    AlignedMemory::deallocate( cache );
+                }
+            }
+        };
+        thread_local ThreadCacheReaper tCacheReaper;
+
+        /// Returns null if the thread is exiting, in which case
+        /// the shared pool must be used directly.
+        inline ThreadCache *getThreadCache()
+        {
+            ThreadCache *cache = tCache;
+            if( !cache && !tCacheRetired )
+            {
+                cache = new( AlignedMemory::allocate( sizeof( ThreadCache ) ) ) ThreadCache();
+                tCache = cache;
+                // Odr-using the reaper is what makes it get destroyed on thread exit
+                tCacheReaper.registerThread();
+            }
+            return cache;
+        }
+
+        /// Carves a new chunk. The first numBlocks blocks are returned,
+        /// the rest are given to the shared pool.
+        FreeBlock *carveChunk( uint32 sizeClass, uint32 numBlocks )
+        {
+            const size_t blockBytes = getBlockBytes( sizeClass );
+            const size_t numChunkBlocks =
+                std::max<size_t>( c_chunkBytes / blockBytes, numBlocks );
+
+            uint8 *chunk =
+                reinterpret_cast<uint8 *>( AlignedMemory::allocate( numChunkBlocks * blockBytes, 16u ) );
+            SharedPool &sharedPool = getSharedPool();
+            sharedPool.reservedBytes.fetch_add( numChunkBlocks * blockBytes,
+                                                std::memory_order_relaxed );
+
+            for( size_t i = 0u; i < numChunkBlocks - 1u; ++i )
+            {
+                reinterpret_cast<FreeBlock *>( chunk + i * blockBytes )->next =
+                    reinterpret_cast<FreeBlock *>( chunk + ( i + 1u ) * blockBytes );
+            }
+            reinterpret_cast<FreeBlock *>( chunk + ( numChunkBlocks - 1u ) * blockBytes )->next = 0;
+
+            FreeBlock *first = reinterpret_cast<FreeBlock *>( chunk );
+            if( numChunkBlocks > numBlocks )
+            {
+                FreeBlock *last =
+                    reinterpret_cast<FreeBlock *>( chunk + ( numBlocks - 1u ) * blockBytes );
+                FreeBlock *remaining = last->next;
+                last->next = 0;
+
+                SharedSizeClass &shared = sharedPool.sizeClasses[sizeClass];
+                FreeBlock *remainingLast = reinterpret_cast<FreeBlock *>(
+                    chunk + ( numChunkBlocks - 1u ) * blockBytes );
+
+                ScopedLock lock( shared.mutex );
+                remainingLast->next = shared.freeList;
+                shared.freeList = remaining;
+                shared.numFree += numChunkBlocks - numBlocks;
+            }
+
+            return first;
+        }
+
+        /// Returns a null-terminated list of exactly numBlocks blocks.
+        FreeBlock *takeFromSharedPool( uint32 sizeClass, uint32 numBlocks )
+        {
+            SharedSizeClass &shared = getSharedPool().sizeClasses[sizeClass];
+            {
+                ScopedLock lock( shared.mutex );
+                if( shared.numFree >= numBlocks )
+                {
+                    FreeBlock *first = shared.freeList;
+                    FreeBlock *last = first;
+                    for( uint32 i = 1u; i < numBlocks; ++i )
+                        last = last->next;
+                    shared.freeList = last->next;
+                    shared.numFree -= numBlocks;
+                    last->next = 0;
+                    return first;
+                }
+            }
+
+            // The shared pool ran dry. Don't hold the lock while asking the system for memory.
+            return carveChunk( sizeClass, numBlocks );
+        }
+
+        inline BlockHeader *allocateBlock( ThreadCache *cache, uint32 sizeClass )
+        {
+            if( !cache )
+                return reinterpret_cast<BlockHeader *>( takeFromSharedPool( sizeClass, 1u ) );
+
+            ThreadSizeClass &local = cache->sizeClasses[sizeClass];
+            if( !local.freeList )
+            {
+                local.freeList = takeFromSharedPool( sizeClass, local.batchSize );
+                local.numFree = local.batchSize;
+            }
+
+            FreeBlock *block = local.freeList;
+            local.freeList = block->next;
+            --local.numFree;
+            return reinterpret_cast<BlockHeader *>( block );
+        }
+
+        inline void deallocateBlock( ThreadCache *cache, BlockHeader *header, uint32 sizeClass )
+        {
+            FreeBlock *block = reinterpret_cast<FreeBlock *>( header );
+            if( !cache )
+            {
+                SharedSizeClass &shared = getSharedPool().sizeClasses[sizeClass];
+                ScopedLock lock( shared.mutex );
+                block->next = shared.freeList;
+                shared.freeList = block;
+                ++shared.numFree;
+                return;
+            }
+
+            ThreadSizeClass &local = cache->sizeClasses[sizeClass];
+            block->next = local.freeList;
+            local.freeList = block;
+            ++local.numFree;
+
+            // Don't let a thread which frees what others allocated hoard blocks forever
+            if( local.numFree > local.batchSize * 2u )
+                returnToSharedPool( local, sizeClass, local.batchSize );
+        }
+
+        inline void recordStats( ThreadCache *cache, uint32 category, ptrdiff_t bytes,
+                                 ptrdiff_t numAllocations )
+        {
+            if( cache )
+            {
+                cache->liveBytes[category] += bytes;
+                cache->liveAllocations[category] += numAllocations;
+                if( numAllocations > 0 )
+                    ++cache->totalAllocations[category];
+
+                if( cache->liveBytes[category] > c_statsPublishThreshold ||
+                    cache->liveBytes[category] < -c_statsPublishThreshold )
+                {
+                    publishStats( cache, category );
+                }
+            }
+            else
+            {
+                SharedCategoryStats &stats = getSharedPool().stats[category];
+                stats.liveBytes.fetch_add( bytes, std::memory_order_relaxed );
+                stats.liveAllocations.fetch_add( numAllocations, std::memory_order_relaxed );
+                if( numAllocations > 0 )
+                    stats.totalAllocations.fetch_add( 1u, std::memory_order_relaxed );
+            }
+        }
+    }  // namespace
+
+    //-----------------------------------------------------------------------------------
+    DECL_MALLOC void *PooledAllocPolicy::allocateBytes( size_t count, MemoryCategory category,
+#    if OGRE_MEMORY_TRACKER
+                                                        const char *file, int line, const char *func
+#    else
+                                                        const char *, int, const char *
+#    endif
+    )
+    {
+        ThreadCache *cache = getThreadCache();
+
+        BlockHeader *header;
+        uint32 sizeClass;
+        if( count <= c_maxPooledBytes )
+        {
+            sizeClass = getSizeClass( count );
+            header = allocateBlock( cache, sizeClass );
+        }
+        else
+        {
+            sizeClass = c_largeSizeClass;
+            header = reinterpret_cast<BlockHeader *>(
+                AlignedMemory::allocate( count + sizeof( BlockHeader ), 16u ) );
+        }
+
+        header->sizeClass = sizeClass;
+        header->category = static_cast<uint32>( category );
+        header->bytes = count;
+
+        recordStats( cache, header->category, static_cast<ptrdiff_t>( count ), 1 );
+
+        void *ptr = header + 1;
+#    if OGRE_MEMORY_TRACKER
+        MemoryTracker::get()._recordAlloc( ptr, count, static_cast<unsigned int>( category ), file,
+                                           line, func );
+#    endif
+        return ptr;
+    }
+    //-----------------------------------------------------------------------------------
+    void PooledAllocPolicy::deallocateBytes( void *ptr )
+    {
+        if( !ptr )
+            return;
+
+#    if OGRE_MEMORY_TRACKER
+        MemoryTracker::get()._recordDealloc( ptr );
+#    endif
+
+        BlockHeader *header = reinterpret_cast<BlockHeader *>( ptr ) - 1;
+        OGRE_ASSERT_MEDIUM( header->category < MEMCATEGORY_COUNT &&
+                            ( header->sizeClass < c_numSizeClasses ||
+                              header->sizeClass == c_largeSizeClass ) &&
+                            "Memory corruption or pointer not allocated by PooledAllocPolicy" );
+
+        ThreadCache *cache = getThreadCache();
+        recordStats( cache, header->category, -static_cast<ptrdiff_t>( header->bytes ), -1 );
+
+        if( header->sizeClass == c_largeSizeClass )
+            AlignedMemory::deallocate( header );
+        else
+            deallocateBlock( cache, header, header->sizeClass );
+    }
+    //-----------------------------------------------------------------------------------
+    PooledAllocCategoryStats PooledAllocPolicy::getCategoryStats( MemoryCategory category )
+    {
+        ThreadCache *cache = getThreadCache();
+        if( cache )
+            publishStats( cache, category );
+
+        const SharedCategoryStats &stats = getSharedPool().stats[category];
+
+        // Counters may be transiently negative if this thread freed memory
+        // whose allocation another thread hasn't published yet
+        PooledAllocCategoryStats retVal;
+        retVal.liveBytes = static_cast<size_t>(
+            std::max<ptrdiff_t>( stats.liveBytes.load( std::memory_order_relaxed ), 0 ) );
+        retVal.peakBytes = static_cast<size_t>(
+            std::max<ptrdiff_t>( stats.peakBytes.load( std::memory_order_relaxed ), 0 ) );
+        retVal.liveAllocations = static_cast<size_t>(
+            std::max<ptrdiff_t>( stats.liveAllocations.load( std::memory_order_relaxed ), 0 ) );
+        retVal.totalAllocations = stats.totalAllocations.load( std::memory_order_relaxed );
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    void PooledAllocPolicy::resetPeakStats()
+    {
+        SharedPool &sharedPool = getSharedPool();
+        for( size_t i = 0u; i < MEMCATEGORY_COUNT; ++i )
+        {
+            sharedPool.stats[i].peakBytes.store(
+                sharedPool.stats[i].liveBytes.load( std::memory_order_relaxed ),
+                std::memory_order_relaxed );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    size_t PooledAllocPolicy::getReservedBytes()
+    {
+        return getSharedPool().reservedBytes.load( std::memory_order_relaxed );
+    }
+    //-----------------------------------------------------------------------------------
+    void PooledAllocPolicy::flushThreadCache()
+    {
+        ThreadCache *cache = tCache;
+        if( cache )
+            releaseThreadCache( cache );
+    }
+}  // namespace Ogre
+
+#endif
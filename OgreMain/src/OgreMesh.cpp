@@ -269,8 +269,9 @@ namespace Ogre
             mFreshFromDisk =
                 ResourceGroupManager::getSingleton().openResource( mName, mGroup, true, this );
 
-            // fully prebuffer into host RAM
-            mFreshFromDisk = DataStreamPtr( OGRE_NEW MemoryDataStream( mName, mFreshFromDisk ) );
+            // fully prebuffer into host RAM, unless it already is (e.g. memory mapped)
+            if( !mFreshFromDisk->getCurrentReadPtr() )
+                mFreshFromDisk = DataStreamPtr( OGRE_NEW MemoryDataStream( mName, mFreshFromDisk ) );
         }
         //-----------------------------------------------------------------------
         void Mesh::unprepareImpl() { mFreshFromDisk.reset(); }
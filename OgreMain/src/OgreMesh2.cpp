@@ -143,14 +143,19 @@ namespace Ogre
     {
         OgreProfileExhaustive( "Mesh2::prepareImpl" );
 
+        // Already read by MeshManager's async loading worker
+        if( mFreshFromDisk )
+            return;
+
         // Load from specified 'name'
         if( getCreator()->getVerbose() )
             LogManager::getSingleton().logMessage( "Mesh: Loading " + mName + "." );
 
         mFreshFromDisk = ResourceGroupManager::getSingleton().openResource( mName, mGroup, true, this );
 
-        // fully prebuffer into host RAM
-        mFreshFromDisk = DataStreamPtr( OGRE_NEW MemoryDataStream( mName, mFreshFromDisk ) );
+        // fully prebuffer into host RAM, unless it already is (e.g. memory mapped)
+        if( !mFreshFromDisk->getCurrentReadPtr() )
+            mFreshFromDisk = DataStreamPtr( OGRE_NEW MemoryDataStream( mName, mFreshFromDisk ) );
     }
     //-----------------------------------------------------------------------
     void Mesh::unprepareImpl() { mFreshFromDisk.reset(); }
@@ -900,7 +900,7 @@ namespace Ogre
                 Uint8Vec::iterator it = itor->vertexBuffers.begin();
                 Uint8Vec::iterator en = itor->vertexBuffers.end();
 
-                while( it != en )
+                while( it != en && !itor->vertexBuffersInStream )
                     OGRE_FREE_SIMD( *it++, MEMCATEGORY_GEOMETRY );
 
                 itor->vertexBuffers.clear();
@@ -941,14 +941,28 @@ namespace Ogre
             {
                 if( subMeshLod.vertexDeclarations.size() == 1 )
                 {
+                    const bool keepAsShadow = sm->mParent->isVertexBufferShadowed();
+
+                    uint8 *vertexData = subMeshLod.vertexBuffers[0];
+                    if( subMeshLod.vertexBuffersInStream && keepAsShadow )
+                    {
+                        // The shadow copy is owned by the buffer; it can't live in the stream
+                        const size_t bufferSize =
+                            VaoManager::calculateVertexSize( subMeshLod.vertexDeclarations[0] ) *
+                            subMeshLod.numVertices;
+                        vertexData = reinterpret_cast<uint8 *>(
+                            OGRE_MALLOC_SIMD( bufferSize, MEMCATEGORY_GEOMETRY ) );
+                        memcpy( vertexData, subMeshLod.vertexBuffers[0], bufferSize );
+                    }
+
                     VertexBufferPacked *vertexBuffer = mVaoManager->createVertexBuffer(
                         subMeshLod.vertexDeclarations[0], subMeshLod.numVertices,
-                        sm->mParent->getVertexBufferDefaultType(), subMeshLod.vertexBuffers[0],
-                        sm->mParent->isVertexBufferShadowed() );
+                        sm->mParent->getVertexBufferDefaultType(), vertexData, keepAsShadow );
 
-                    if( !sm->mParent->isVertexBufferShadowed() )
+                    if( !keepAsShadow )
                     {
-                        OGRE_FREE_SIMD( submeshLods[i].vertexBuffers[0], MEMCATEGORY_GEOMETRY );
+                        if( !subMeshLod.vertexBuffersInStream )
+                            OGRE_FREE_SIMD( submeshLods[i].vertexBuffers[0], MEMCATEGORY_GEOMETRY );
                         submeshLods[i].vertexBuffers.erase( submeshLods[i].vertexBuffers.begin() );
                     }
 
@@ -1106,6 +1120,10 @@ namespace Ogre
         subLod->vertexDeclarations.resize( numSources );
         subLod->vertexBuffers.resize( numSources );
 
+        // If the whole file is already in memory (e.g. memory mapped), upload
+        // the vertex data straight from it instead of copying it first.
+        subLod->vertexBuffersInStream = !mFlipEndian && stream->getCurrentReadPtr() != 0;
+
         pushInnerChunk( stream );
 
         uint16 streamID = readChunk( stream );
@@ -1187,11 +1205,27 @@ namespace Ogre
                          "MeshSerializerImpl::readVertexBuffer" );
         }
 
-        uint8 *vertexData = reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD(
-            sizeof( uint8 ) * bytesPerVertex * subLod->numVertices, MEMCATEGORY_GEOMETRY ) );
+        const size_t bufferSize = sizeof( uint8 ) * bytesPerVertex * subLod->numVertices;
+
+        if( subLod->vertexBuffersInStream )
+        {
+            if( stream->size() - stream->tell() < bufferSize )
+            {
+                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, "Vertex buffer goes past the end of file.",
+                             "MeshSerializerImpl::readVertexBuffer" );
+            }
+
+            // Not written to unless flipping endianness, which disables this path
+            subLod->vertexBuffers[source] = const_cast<uint8 *>( stream->getCurrentReadPtr() );
+            stream->skip( static_cast<long>( bufferSize ) );
+            return;
+        }
+
+        uint8 *vertexData =
+            reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD( bufferSize, MEMCATEGORY_GEOMETRY ) );
         subLod->vertexBuffers[source] = vertexData;
 
-        stream->read( vertexData, bytesPerVertex * subLod->numVertices );
+        stream->read( vertexData, bufferSize );
 
         // Endian conversion
         flipLittleEndian( vertexData, subLod->numVertices, bytesPerVertex, vertexElements );
@@ -2284,6 +2318,7 @@ edgeData->triangleFaceNormals.begin(); for ( ; t != edgeData->triangles.end(); +
     //---------------------------------------------------------------------
     MeshSerializerImpl::SubMeshLod::SubMeshLod() :
         numVertices( 0 ),
+        vertexBuffersInStream( false ),
         lodSource( 0 ),
         index32Bit( false ),
         numIndices( 0 ),
@@ -2359,7 +2394,7 @@ edgeData->triangleFaceNormals.begin(); for ( ; t != edgeData->triangles.end(); +
                 Uint8Vec::iterator it = itor->vertexBuffers.begin();
                 Uint8Vec::iterator en = itor->vertexBuffers.end();
 
-                while( it != en )
+                while( it != en && !itor->vertexBuffersInStream )
                     OGRE_FREE_SIMD( *it++, MEMCATEGORY_GEOMETRY );
 
                 itor->vertexBuffers.clear();
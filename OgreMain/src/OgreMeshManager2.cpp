@@ -29,12 +29,15 @@ THE SOFTWARE.
 
 #include "OgreMeshManager2.h"
 
+#include "OgreArchive.h"
 #include "OgreException.h"
+#include "OgreLogManager.h"
 #include "OgreMatrix4.h"
 #include "OgreMesh2.h"
 #include "OgreMeshManager.h"
 #include "OgrePatchMesh.h"
 #include "OgrePrefabFactory.h"
+#include "OgreProfiler.h"
 #include "OgreSubMesh2.h"
 
 namespace Ogre
@@ -49,7 +52,15 @@ namespace Ogre
         return ( *msSingleton );
     }
     //-----------------------------------------------------------------------
-    MeshManager::MeshManager() : mVaoManager( 0 ), mBoundsPaddingFactor( Real( 0.01 ) )
+    unsigned long updateMeshAsyncWorkerThread( ThreadHandle *threadHandle );
+    THREAD_DECLARE( updateMeshAsyncWorkerThread );
+    //-----------------------------------------------------------------------
+    MeshManager::MeshManager() :
+        mVaoManager( 0 ),
+        mBoundsPaddingFactor( Real( 0.01 ) ),
+        mAsyncWorkerShuttingDown( false ),
+        mNumAsyncLoadsPending( 0 ),
+        mAsyncUploadBudget( 16u * 1024u * 1024u )
     {
         mLoadOrder = 300.0f;
         mResourceType = "Mesh2";
@@ -59,6 +70,10 @@ namespace Ogre
     //-----------------------------------------------------------------------
     MeshManager::~MeshManager()
     {
+        stopAsyncWorker();
+        mAsyncLoadRequests.clear();
+        mAsyncLoadsReady.clear();
+
         ResourceGroupManager::getSingleton()._unregisterResourceManager( mResourceType );
     }
     //-----------------------------------------------------------------------
@@ -112,6 +127,210 @@ namespace Ogre
         return pMesh;
     }
     //-----------------------------------------------------------------------
+    MeshPtr MeshManager::loadAsync( const String &filename, const String &groupName,
+                                    BufferType vertexBufferType, BufferType indexBufferType,
+                                    bool vertexBufferShadowed, bool indexBufferShadowed )
+    {
+        MeshPtr pMesh = std::static_pointer_cast<Mesh>(
+            createOrRetrieve( filename, groupName, false, 0, 0, vertexBufferType, indexBufferType,
+                              vertexBufferShadowed, indexBufferShadowed )
+                .first );
+
+        if( pMesh->isBackgroundLoaded() || pMesh->getLoadingState() != Resource::LOADSTATE_UNLOADED )
+            return pMesh;  // Already loaded, or being loaded
+
+        ResourceGroupManager &resourceGroupManager = ResourceGroupManager::getSingleton();
+        if( pMesh->getGroup() == ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME )
+        {
+            pMesh->changeGroupOwnership(
+                resourceGroupManager.findGroupContainingResource( pMesh->getName() ) );
+        }
+
+        AsyncMeshLoad asyncLoad;
+        asyncLoad.mesh = pMesh;
+        asyncLoad.archive =
+            resourceGroupManager._getArchiveToResource( pMesh->getName(), pMesh->getGroup() );
+
+        // Prevents Mesh::load (e.g. from Item's constructor) from loading it synchronously
+        pMesh->setBackgroundLoaded( true );
+
+        if( !mAsyncWorkerThread )
+        {
+            mAsyncWorkerShuttingDown.store( false, std::memory_order_relaxed );
+            mAsyncWorkerThread =
+                Threads::CreateThread( THREAD_GET( updateMeshAsyncWorkerThread ), 0, this );
+        }
+
+        mAsyncLoadMutex.lock();
+        mAsyncLoadRequests.push_back( asyncLoad );
+        mAsyncLoadMutex.unlock();
+        mAsyncWorkerWaitableEvent.wake();
+        ++mNumAsyncLoadsPending;
+
+        return pMesh;
+    }
+    //-----------------------------------------------------------------------
+    void MeshManager::waitForAsyncLoads()
+    {
+        while( isAsyncLoadPending() )
+        {
+            _updateAsyncLoads( 0u );
+            Threads::Sleep( 1 );
+        }
+    }
+    //-----------------------------------------------------------------------
+    bool MeshManager::removeAsyncLoad( AsyncMeshLoadVec &asyncLoads, const Mesh *mesh )
+    {
+        AsyncMeshLoadVec::iterator itor = asyncLoads.begin();
+        AsyncMeshLoadVec::iterator endt = asyncLoads.end();
+
+        while( itor != endt && itor->mesh.get() != mesh )
+            ++itor;
+
+        if( itor == endt )
+            return false;
+
+        asyncLoads.erase( itor );
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    bool MeshManager::cancelAsyncLoad( Mesh *mesh )
+    {
+        if( !mesh->isBackgroundLoaded() )
+            return false;
+
+        bool found = false;
+        while( !found )
+        {
+            {
+                ScopedLock lock( mAsyncLoadMutex );
+                found = removeAsyncLoad( mAsyncLoadRequests, mesh ) ||
+                        removeAsyncLoad( mAsyncLoadsReady, mesh );
+            }
+
+            // Not in either queue means the worker thread is reading it right now
+            if( !found )
+                Threads::Sleep( 1 );
+        }
+
+        mesh->setBackgroundLoaded( false );
+        --mNumAsyncLoadsPending;
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    void MeshManager::_updateAsyncLoads( size_t bytesBudget )
+    {
+        size_t bytesLoaded = 0u;
+
+        while( !bytesBudget || bytesLoaded < bytesBudget )
+        {
+            AsyncMeshLoad asyncLoad;
+            {
+                ScopedLock lock( mAsyncLoadMutex );
+                if( mAsyncLoadsReady.empty() )
+                    break;
+                asyncLoad = mAsyncLoadsReady.front();
+                mAsyncLoadsReady.erase( mAsyncLoadsReady.begin() );
+            }
+
+            OgreProfileExhaustive( "MeshManager::_updateAsyncLoads" );
+
+            Mesh *mesh = asyncLoad.mesh.get();
+            mesh->setBackgroundLoaded( false );
+            --mNumAsyncLoadsPending;
+
+            if( !asyncLoad.data )
+            {
+                LogManager::getSingleton().logMessage( "Async loading of Mesh " + mesh->getName() +
+                                                           " failed: " + asyncLoad.errorDescription,
+                                                       LML_CRITICAL );
+                continue;
+            }
+
+            bytesLoaded += asyncLoad.data->size();
+
+            try
+            {
+                if( mesh->getLoadingState() == Resource::LOADSTATE_UNLOADED )
+                {
+                    mesh->_setFreshFromDisk( asyncLoad.data );
+                    asyncLoad.data.reset();
+                    mesh->load( true );
+                    mesh->_fireLoadingComplete( true );
+                }
+            }
+            catch( Exception &e )
+            {
+                mesh->_setFreshFromDisk( DataStreamPtr() );
+                LogManager::getSingleton().logMessage( "Async loading of Mesh " + mesh->getName() +
+                                                           " failed: " + e.getFullDescription(),
+                                                       LML_CRITICAL );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    unsigned long updateMeshAsyncWorkerThread( ThreadHandle *threadHandle )
+    {
+        MeshManager *meshManager = reinterpret_cast<MeshManager *>( threadHandle->getUserParam() );
+        return meshManager->_updateAsyncWorkerThread( threadHandle );
+    }
+    //-----------------------------------------------------------------------
+    unsigned long MeshManager::_updateAsyncWorkerThread( ThreadHandle * )
+    {
+        while( !mAsyncWorkerShuttingDown.load( std::memory_order_acquire ) )
+        {
+            mAsyncLoadMutex.lock();
+            if( mAsyncLoadRequests.empty() )
+            {
+                mAsyncLoadMutex.unlock();
+                mAsyncWorkerWaitableEvent.wait();
+                continue;
+            }
+
+            AsyncMeshLoad asyncLoad = mAsyncLoadRequests.front();
+            mAsyncLoadRequests.erase( mAsyncLoadRequests.begin() );
+            mAsyncLoadMutex.unlock();
+
+            try
+            {
+                DataStreamPtr data = asyncLoad.archive->open( asyncLoad.mesh->getName() );
+                if( !data )
+                {
+                    OGRE_EXCEPT( Exception::ERR_FILE_NOT_FOUND,
+                                 "Cannot open " + asyncLoad.mesh->getName(),
+                                 "MeshManager::_updateAsyncWorkerThread" );
+                }
+
+                // Same as Mesh::prepareImpl: fully prebuffer into host RAM,
+                // unless it already is (e.g. memory mapped)
+                if( !data->getCurrentReadPtr() )
+                    data = DataStreamPtr( OGRE_NEW MemoryDataStream( data->getName(), data ) );
+                asyncLoad.data = data;
+            }
+            catch( Exception &e )
+            {
+                asyncLoad.errorDescription = e.getFullDescription();
+            }
+
+            mAsyncLoadMutex.lock();
+            mAsyncLoadsReady.push_back( asyncLoad );
+            mAsyncLoadMutex.unlock();
+        }
+
+        return 0;
+    }
+    //-----------------------------------------------------------------------
+    void MeshManager::stopAsyncWorker()
+    {
+        if( !mAsyncWorkerThread )
+            return;
+
+        mAsyncWorkerShuttingDown.store( true, std::memory_order_release );
+        mAsyncWorkerWaitableEvent.wake();
+        Threads::WaitForThreads( 1u, &mAsyncWorkerThread );
+        mAsyncWorkerThread.reset();
+    }
+    //-----------------------------------------------------------------------
     MeshPtr MeshManager::create( const String &name, const String &group, bool isManual,
                                  ManualResourceLoader *loader, const NameValuePairList *createParams )
     {
@@ -313,6 +313,8 @@ namespace Ogre
     //-----------------------------------------------------------------------
     Aabb MovableObject::getWorldAabbUpdated() { return updateSingleWorldAabb(); }
     //-----------------------------------------------------------------------
+    Aabb MovableObject::_getWorldAabbUpdatedGrowHierarchy() { return updateSingleWorldAabb( true ); }
+    //-----------------------------------------------------------------------
     float MovableObject::getLocalRadius() const { return mObjectData.mLocalRadius[mObjectData.mIndex]; }
     //-----------------------------------------------------------------------
     float MovableObject::getWorldRadius() const
@@ -325,7 +327,7 @@ namespace Ogre
     //-----------------------------------------------------------------------
     float MovableObject::getWorldRadiusUpdated() { return updateSingleWorldRadius(); }
     //-----------------------------------------------------------------------
-    Aabb MovableObject::updateSingleWorldAabb()
+    Aabb MovableObject::updateSingleWorldAabb( bool bGrowCullingHierarchy )
     {
         Matrix4 derivedTransform = mParentNode->_getFullTransformUpdated();
 
@@ -335,6 +337,15 @@ namespace Ogre
 
         mObjectData.mWorldAabb->setFromAabb( retVal, mObjectData.mIndex );
 
+        // The new aabb may lie outside the bounds of the cluster we belong to
+        if( mObjectMemoryManager )
+        {
+            if( bGrowCullingHierarchy )
+                mObjectMemoryManager->_growCullingHierarchy( mRenderQueueID, mObjectData, retVal );
+            else
+                mObjectMemoryManager->_notifyCullingHierarchyDirty( mRenderQueueID );
+        }
+
 #if OGRE_DEBUG_MODE
         mCachedAabbOutOfDate = false;
 #endif
@@ -602,6 +613,139 @@ namespace Ogre
         culledObjects.swap( outCulledObjects );
     }
     //-----------------------------------------------------------------------
+    void MovableObject::cullFrustumBatched( const size_t numNodes, ObjectData objData,
+                                            const Plane *frustumPlanes, size_t numFrustums,
+                                            MovableObjectArray *const *outCulledObjects,
+                                            const Camera *lodCamera )
+    {
+        // See cullFrustum
+        struct ArrayPlane
+        {
+            ArrayVector3 planeNormal;
+            ArrayVector3 signFlip;
+            ArrayReal planeNegD;
+        };
+        struct ArraySixPlanes
+        {
+            ArrayPlane planes[6];
+        };
+
+        RawSimdUniquePtr<ArraySixPlanes, MEMCATEGORY_SCENE_CONTROL> planesPtr =
+            RawSimdUniquePtr<ArraySixPlanes, MEMCATEGORY_SCENE_CONTROL>( numFrustums );
+        ArraySixPlanes *RESTRICT_ALIAS planes = planesPtr.get();
+
+        for( size_t j = 0; j < numFrustums; ++j )
+        {
+            for( size_t i = 0; i < 6; ++i )
+            {
+                const Plane &plane = frustumPlanes[j * 6u + i];
+                planes[j].planes[i].planeNormal.setAll( plane.normal );
+                planes[j].planes[i].signFlip.setAll( plane.normal );
+                planes[j].planes[i].signFlip.setToSign();
+                planes[j].planes[i].planeNegD = Mathlib::SetAll( -plane.d );
+            }
+        }
+
+        ArrayVector3 lodCameraPos;
+        lodCameraPos.setAll( lodCamera->_getCachedDerivedPosition() );
+
+        const ArrayMaskR ignoreRenderingDistance =
+            CastIntToReal( Mathlib::SetAll( lodCamera->getUseRenderingDistance() ? 0 : 0xffffffff ) );
+
+        for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
+        {
+            ArrayInt *RESTRICT_ALIAS visibilityFlags =
+                reinterpret_cast<ArrayInt * RESTRICT_ALIAS>( objData.mVisibilityFlags );
+            ArrayReal *RESTRICT_ALIAS worldRadius =
+                reinterpret_cast<ArrayReal * RESTRICT_ALIAS>( objData.mWorldRadius );
+            ArrayReal *RESTRICT_ALIAS upperDistance =
+                reinterpret_cast<ArrayReal * RESTRICT_ALIAS>( objData.mUpperDistance[1] );
+
+            // Everything that doesn't depend on the frustum
+            ArrayMaskI isVisible = Mathlib::And(
+                Mathlib::TestFlags4( *visibilityFlags, Mathlib::SetAll( LAYER_VISIBILITY ) ),
+                Mathlib::TestFlags4( *visibilityFlags, Mathlib::SetAll( LAYER_SHADOW_CASTER ) ) );
+
+            ArrayReal distance = lodCameraPos.distance( objData.mWorldAabb->mCenter );
+            ArrayMaskR isCloseEnough =
+                Mathlib::CompareLessEqual( distance, *worldRadius + *upperDistance );
+            isCloseEnough = Mathlib::Or( ignoreRenderingDistance, isCloseEnough );
+
+            isVisible = Mathlib::And( isVisible, CastRealToInt( isCloseEnough ) );
+
+            if( BooleanMask4::getScalarMask( isVisible ) )
+            {
+                const ArrayVector3 center = objData.mWorldAabb->mCenter;
+                const ArrayVector3 halfSize = objData.mWorldAabb->mHalfSize;
+
+                // Always pass the test if any of the components were
+                // Infinity (dot product could've caused nans)
+                const ArrayMaskR isInfinite =
+                    Mathlib::Or( Mathlib::Or( Mathlib::isInfinity( halfSize.mChunkBase[0] ),
+                                              Mathlib::isInfinity( halfSize.mChunkBase[1] ) ),
+                                 Mathlib::isInfinity( halfSize.mChunkBase[2] ) );
+
+                for( size_t j = 0; j < numFrustums; ++j )
+                {
+                    const ArrayPlane *RESTRICT_ALIAS p = planes[j].planes;
+
+                    ArrayMaskR mask = Mathlib::CompareGreater(
+                        p[0].planeNormal.dotProduct( center + halfSize * p[0].signFlip ),
+                        p[0].planeNegD );
+                    for( size_t k = 1u; k < 6u; ++k )
+                    {
+                        mask = Mathlib::And(
+                            mask, Mathlib::CompareGreater(
+                                      p[k].planeNormal.dotProduct( center + halfSize * p[k].signFlip ),
+                                      p[k].planeNegD ) );
+                    }
+
+                    mask = Mathlib::Or( mask, isInfinite );
+
+                    const uint32 scalarMask =
+                        BooleanMask4::getScalarMask( Mathlib::And( CastRealToInt( mask ), isVisible ) );
+
+                    for( size_t k = 0; k < ARRAY_PACKED_REALS; ++k )
+                    {
+                        if( IS_BIT_SET( k, scalarMask ) )
+                            outCulledObjects[j]->push_back( objData.mOwner[k] );
+                    }
+                }
+            }
+
+            objData.advanceFrustumPack();
+        }
+    }
+    //-----------------------------------------------------------------------
+    void MovableObject::_updateCachedDistanceToCamera( const Camera *camera )
+    {
+        const Aabb worldAabb = mObjectData.mWorldAabb->getAsAabb( mObjectData.mIndex );
+        const Real worldRadius = mObjectData.mWorldRadius[mObjectData.mIndex];
+        const Vector3 cameraPos = camera->_getCachedDerivedPosition();
+        const Vector3 cameraDir = -camera->_getCachedDerivedOrientation().zAxis();
+
+        Real distance;
+        switch( camera->mSortMode )
+        {
+        case Camera::SortModeDistance:
+            distance = cameraPos.distance( worldAabb.mCenter ) - worldRadius;
+            break;
+        case Camera::SortModeDistanceRadiusIgnoring:
+            distance = cameraPos.distance( worldAabb.mCenter );
+            break;
+        case Camera::SortModeDepthRadiusIgnoring:
+            distance = cameraDir.dotProduct( worldAabb.mCenter - cameraPos );
+            break;
+        case Camera::SortModeDepth:
+        default:
+            distance = cameraDir.dotProduct( worldAabb.mCenter - cameraPos ) - worldRadius;
+            break;
+        }
+
+        reinterpret_cast<Real * RESTRICT_ALIAS>( mObjectData.mDistanceToCamera )[mObjectData.mIndex] =
+            distance;
+    }
+    //-----------------------------------------------------------------------
     void MovableObject::cullLights( const size_t numNodes, ObjectData objData, uint32 sceneLightMask,
                                     LightListInfo &outGlobalLightList, const FrustumVec &frustums,
                                     const FrustumVec &cubemapFrustums )
@@ -429,6 +429,23 @@ namespace Ogre
         ArrayMatrix4 derivedTransform;
         for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
         {
+            // Nodes whose parent got updated must be updated too, and stay dirty
+            // so that the change keeps propagating down to their own children.
+            bool anyDirty = false;
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+            {
+                const Transform &parentTransform = t.mParents[j]->mTransform;
+                t.mDirty[j] = t.mDirty[j] || parentTransform.mDirty[parentTransform.mIndex];
+                anyDirty |= t.mDirty[j];
+            }
+
+            if( !anyDirty )
+            {
+                // Nothing changed in this pack since the last update
+                t.advancePack();
+                continue;
+            }
+
 #if OGRE_NODE_INHERIT_TRANSFORM
             // determine our transform, without parent part
             ArrayMatrix4 trSoA;
@@ -607,6 +624,7 @@ namespace Ogre
         assert( !q.isNaN() && "Invalid orientation supplied as parameter" );
         q.normalise();
         mTransform.mOrientation->setFromQuaternion( q, mTransform.mIndex );
+        _markTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -618,6 +636,7 @@ namespace Ogre
     void Node::resetOrientation()
     {
         mTransform.mOrientation->setFromQuaternion( Quaternion::IDENTITY, mTransform.mIndex );
+        _markTransformDirty();
     }
 
     //-----------------------------------------------------------------------
@@ -625,6 +644,7 @@ namespace Ogre
     {
         assert( !pos.isNaN() && "Invalid vector supplied as parameter" );
         mTransform.mPosition->setFromVector3( pos, mTransform.mIndex );
+        _markTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -681,6 +701,7 @@ namespace Ogre
         }
 
         mTransform.mPosition->setFromVector3( position, mTransform.mIndex );
+        _markTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -751,6 +772,7 @@ namespace Ogre
         orientation.normalise();
 
         mTransform.mOrientation->setFromQuaternion( orientation, mTransform.mIndex );
+        _markTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
 
@@ -890,6 +912,7 @@ namespace Ogre
     {
         assert( !inScale.isNaN() && "Invalid vector supplied as parameter" );
         mTransform.mScale->setFromVector3( inScale, mTransform.mIndex );
+        _markTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -900,6 +923,7 @@ namespace Ogre
     void Node::setInheritOrientation( bool inherit )
     {
         mTransform.mInheritOrientation[mTransform.mIndex] = inherit;
+        _markTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -911,6 +935,7 @@ namespace Ogre
     void Node::setInheritScale( bool inherit )
     {
         mTransform.mInheritScale[mTransform.mIndex] = inherit;
+        _markTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -920,6 +945,7 @@ namespace Ogre
     {
         mTransform.mScale->setFromVector3(
             mTransform.mScale->getAsVector3( mTransform.mIndex ) * inScale, mTransform.mIndex );
+        _markTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -33,6 +33,8 @@ THE SOFTWARE.
 #include "CommandBuffer/OgreCbPipelineStateObject.h"
 #include "CommandBuffer/OgreCbShaderBuffer.h"
 #include "CommandBuffer/OgreCommandBuffer.h"
+#include "OgreCamera.h"
+#include "OgreFrameArena.h"
 #include "OgreHardwareBufferManager.h"
 #include "OgreHlms.h"
 #include "OgreHlmsDatablock.h"
@@ -46,6 +48,8 @@ THE SOFTWARE.
 #include "OgreSceneManager.h"
 #include "OgreSceneManagerEnumerator.h"
 #include "OgreTechnique.h"
+#include "OgreTextureGpuManager.h"
+#include "Threading/OgreTaskScheduler.h"
 #include "Vao/OgreIndexBufferPacked.h"
 #include "Vao/OgreIndirectBufferPacked.h"
 #include "Vao/OgreVaoManager.h"
@@ -93,13 +97,22 @@ namespace Ogre
         mLastIndexData( 0 ),
         mLastTextureHash( 0 ),
         mCommandBuffer( 0 ),
-        mRenderingStarted( 0u )
+        mRenderingStarted( 0u ),
+        mPrepareSrc( 0 ),
+        mPreparePassCache( 0 ),
+        mPrepareCasterPass( false ),
+        mPrepareResolveCaches( false ),
+        mPrepareInstancesPerDraw( 1u ),
+        mParallelFillHlms( 0 )
     {
         mCommandBuffer = new CommandBuffer();
 
         for( size_t i = 0; i < 256; ++i )
             mRenderQueues[i].mQueuedRenderablesPerThread.resize( sceneManager->getNumWorkerThreads() );
 
+        mRadixSorters.resize( sceneManager->getNumWorkerThreads() );
+        mPrepareMetricsPerThread.resize( sceneManager->getNumWorkerThreads() );
+
         // Set some defaults:
         // RQs [0; 100)   and [200; 225) are for v2 objects
         // RQs [100; 200) and [225; 256) are for v1 objects
@@ -113,6 +126,11 @@ namespace Ogre
     {
         delete mCommandBuffer;
 
+        FastArray<CommandBuffer *>::const_iterator itCmd = mParallelFillCommandBuffers.begin();
+        FastArray<CommandBuffer *>::const_iterator enCmd = mParallelFillCommandBuffers.end();
+        while( itCmd != enCmd )
+            delete *itCmd++;
+
         assert( mUsedIndirectBuffers.empty() );
 
         IndirectBufferPackedVec::const_iterator itor = mFreeIndirectBuffers.begin();
@@ -318,6 +336,598 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    /// Cameras that haven't rendered a RQ for longer than this lose their sorting results.
+    /// @see RenderQueue::setSortTemporalCoherence
+    static const unsigned long c_sortCacheMaxFrames = 60u;
+    //-----------------------------------------------------------------------
+    /// RQs with less Renderables than this are prepared by the main thread alone,
+    /// since waking up the worker threads would cost more. @see RenderQueue::prepareDraws
+    static const size_t c_minRenderablesForParallelPrepare = 1024u;
+    //-----------------------------------------------------------------------
+    /// RQs with less Renderables than this are recorded by the main thread alone.
+    /// @see RenderQueue::renderGL3Parallel
+    static const size_t c_minRenderablesForParallelFill = 2048u;
+    /// Each segment binds the pass resources again; don't make them smaller than this.
+    static const size_t c_minDrawsPerParallelFillSegment = 512u;
+    //-----------------------------------------------------------------------
+    /// Sorts the per-thread arrays of the RQs using ParallelRadixSort
+    class RenderQueueRadixSortTask final : public RangeTask
+    {
+        RenderQueue *mRenderQueue;
+
+    public:
+        RenderQueueRadixSortTask( RenderQueue *renderQueue ) : mRenderQueue( renderQueue ) {}
+
+        void execute( size_t begin, size_t end, size_t threadIdx ) override
+        {
+            mRenderQueue->_radixSortPending( begin, end, threadIdx );
+        }
+    };
+    //-----------------------------------------------------------------------
+    /// Gathers the data needed by renderGL3 using multiple threads
+    class RenderQueuePrepareTask final : public RangeTask
+    {
+        RenderQueue *mRenderQueue;
+
+    public:
+        RenderQueuePrepareTask( RenderQueue *renderQueue ) : mRenderQueue( renderQueue ) {}
+
+        void execute( size_t begin, size_t end, size_t threadIdx ) override
+        {
+            mRenderQueue->_prepareDraws( begin, end, threadIdx );
+        }
+    };
+    //-----------------------------------------------------------------------
+    /// Records the commands of the RQ using multiple threads
+    class RenderQueueParallelFillTask final : public RangeTask
+    {
+        RenderQueue *mRenderQueue;
+
+    public:
+        RenderQueueParallelFillTask( RenderQueue *renderQueue ) : mRenderQueue( renderQueue ) {}
+
+        void execute( size_t begin, size_t end, size_t threadIdx ) override
+        {
+            mRenderQueue->_recordParallelFillSegments( begin, end, threadIdx );
+        }
+    };
+    //-----------------------------------------------------------------------
+    void RenderQueue::_radixSortPending( size_t begin, size_t end, size_t threadIdx )
+    {
+        QueuedRenderableRadixSort &radixSort = mRadixSorters[threadIdx];
+        for( size_t i = begin; i < end; ++i )
+            radixSort.sort( *mPendingRadixSorts[i], QueuedRenderableHash() );
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::_prepareDraws( size_t begin, size_t end, size_t threadIdx )
+    {
+        const VertexPass vertexPass = static_cast<VertexPass>( mPrepareCasterPass );
+        const size_t instancesPerDraw = mPrepareInstancesPerDraw;
+
+        size_t faceCount = 0;
+        size_t vertexCount = 0;
+        uint32 hlmsTypeMask = 0;
+        size_t numCacheMisses = 0;
+        HlmsCache const *lastHlmsCache = &c_dummyCache;
+
+        for( size_t i = begin; i < end; ++i )
+        {
+            const QueuedRenderable &queuedRenderable = mPrepareSrc[i];
+            const uint8 meshLod = queuedRenderable.movableObject->getCurrentMeshLod();
+            const VertexArrayObjectArray &vaos = queuedRenderable.renderable->getVaos( vertexPass );
+
+            VertexArrayObject *vao = vaos[meshLod];
+
+            PreparedDraw &preparedDraw = mPreparedDraws[i];
+            preparedDraw.vao = vao;
+            preparedDraw.datablock = queuedRenderable.renderable->getDatablock();
+            preparedDraw.hlmsHash = mPrepareCasterPass
+                                        ? queuedRenderable.renderable->getHlmsCasterHash()
+                                        : queuedRenderable.renderable->getHlmsHash();
+            preparedDraw.hlmsCache = 0;
+
+            const uint8 hlmsType = preparedDraw.datablock->mType;
+            hlmsTypeMask |= 1u << hlmsType;
+
+            if( mPrepareResolveCaches )
+            {
+                // Read only. The missing entries are created later by the main thread
+                const Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( hlmsType ) );
+                preparedDraw.hlmsCache = hlms->getMaterialIfCached(
+                    lastHlmsCache, mPreparePassCache[hlmsType], queuedRenderable, mPrepareCasterPass );
+                if( preparedDraw.hlmsCache )
+                    lastHlmsCache = preparedDraw.hlmsCache;
+                else
+                    ++numCacheMisses;
+            }
+
+            switch( vao->getOperationType() )
+            {
+            case OT_TRIANGLE_LIST:
+                faceCount += ( vao->mPrimCount / 3u ) * instancesPerDraw;
+                break;
+            case OT_TRIANGLE_STRIP:
+            case OT_TRIANGLE_FAN:
+                faceCount += ( vao->mPrimCount - 2u ) * instancesPerDraw;
+                break;
+            default:
+                break;
+            }
+
+            vertexCount += vao->mPrimCount * instancesPerDraw;
+        }
+
+        // A thread may execute several ranges
+        mPrepareMetricsPerThread[threadIdx].faceCount += faceCount;
+        mPrepareMetricsPerThread[threadIdx].vertexCount += vertexCount;
+        mPrepareMetricsPerThread[threadIdx].hlmsTypeMask |= hlmsTypeMask;
+        mPrepareMetricsPerThread[threadIdx].numCacheMisses += numCacheMisses;
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::prepareDraws( const QueuedRenderableArray &queuedRenderables, bool casterPass,
+                                    uint32 instancesPerDraw, RenderingMetrics &outStats )
+    {
+        const size_t numRenderables = queuedRenderables.size();
+
+        mPreparedDraws.resizePOD( numRenderables );
+        mPrepareSrc = queuedRenderables.begin();
+        mPrepareCasterPass = casterPass;
+        mPrepareInstancesPerDraw = instancesPerDraw;
+
+        ThreadPrepareMetricsArray::iterator itor = mPrepareMetricsPerThread.begin();
+        ThreadPrepareMetricsArray::iterator endt = mPrepareMetricsPerThread.end();
+        while( itor != endt )
+        {
+            itor->faceCount = 0;
+            itor->vertexCount = 0;
+            itor->hlmsTypeMask = 0;
+            itor->numCacheMisses = 0;
+            ++itor;
+        }
+
+        if( numRenderables >= c_minRenderablesForParallelPrepare &&
+            mSceneManager->getNumWorkerThreads() > 1u )
+        {
+            RenderQueuePrepareTask prepareTask( this );
+            TaskScheduler *taskScheduler = mSceneManager->getTaskScheduler();
+            const TaskScheduler::TaskId taskId =
+                taskScheduler->addTask( &prepareTask, numRenderables, 64u );
+            taskScheduler->waitFor( taskId );
+        }
+        else
+        {
+            _prepareDraws( 0u, numRenderables, 0u );
+        }
+
+        itor = mPrepareMetricsPerThread.begin();
+        while( itor != endt )
+        {
+            outStats.mFaceCount += itor->faceCount;
+            outStats.mVertexCount += itor->vertexCount;
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------
+    /// splitmix64's finalizer
+    static inline uint64 mixFingerprintBits( uint64 x )
+    {
+        x ^= x >> 30u;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27u;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31u;
+        return x;
+    }
+    //-----------------------------------------------------------------------
+    static inline uint64 mixQueuedRenderable( const QueuedRenderable &queuedRenderable )
+    {
+        uint64 bits =
+            mixFingerprintBits( reinterpret_cast<uintptr_t>( queuedRenderable.movableObject ) );
+        bits = mixFingerprintBits( bits ^ reinterpret_cast<uintptr_t>( queuedRenderable.renderable ) );
+        return mixFingerprintBits( bits ^ queuedRenderable.hash );
+    }
+    //-----------------------------------------------------------------------
+    void QueuedRenderableFingerprint::add( const QueuedRenderable *begin,
+                                           const QueuedRenderable *end )
+    {
+        numRenderables += static_cast<size_t>( end - begin );
+
+        for( const QueuedRenderable *itor = begin; itor != end; ++itor )
+        {
+            const uint64 bits = mixQueuedRenderable( *itor );
+            sum0 += bits;
+            sum1 += mixFingerprintBits( bits ^ 0x9e3779b97f4a7c15ULL );
+        }
+    }
+    //-----------------------------------------------------------------------
+    QueuedRenderableSet::Slot *QueuedRenderableSet::findSlot( const QueuedRenderable &queuedRenderable )
+    {
+        // mSlots.size() is a power of 2 and is never full, so this always ends
+        const size_t mask = mSlots.size() - 1u;
+        size_t idx = static_cast<size_t>( mixQueuedRenderable( queuedRenderable ) ) & mask;
+        while( mSlots[idx].count )
+        {
+            const QueuedRenderable &key = mSlots[idx].key;
+            if( key.hash == queuedRenderable.hash && key.renderable == queuedRenderable.renderable &&
+                key.movableObject == queuedRenderable.movableObject )
+            {
+                break;
+            }
+            idx = ( idx + 1u ) & mask;
+        }
+        return &mSlots[idx];
+    }
+    //-----------------------------------------------------------------------
+    void QueuedRenderableSet::reset( size_t numRenderables )
+    {
+        // Keep the load factor at or below 50%
+        size_t numSlots = 16u;
+        while( numSlots < numRenderables * 2u )
+            numSlots <<= 1u;
+
+        Slot emptySlot;
+        emptySlot.count = 0u;
+        emptySlot.matched = 0u;
+        mSlots.assign( numSlots, emptySlot );
+        mNumRenderables = 0u;
+        mNumMatched = 0u;
+    }
+    //-----------------------------------------------------------------------
+    void QueuedRenderableSet::add( const QueuedRenderable *begin, const QueuedRenderable *end )
+    {
+        OGRE_ASSERT_LOW( ( mNumRenderables + size_t( end - begin ) ) * 2u <= mSlots.size() &&
+                         "Added more entries than were reserved with reset()" );
+
+        for( const QueuedRenderable *itor = begin; itor != end; ++itor )
+        {
+            Slot *slot = findSlot( *itor );
+            slot->key = *itor;
+            ++slot->count;
+        }
+        mNumRenderables += static_cast<size_t>( end - begin );
+    }
+    //-----------------------------------------------------------------------
+    void QueuedRenderableSet::resetMatches()
+    {
+        SlotVec::iterator itor = mSlots.begin();
+        SlotVec::iterator endt = mSlots.end();
+        while( itor != endt )
+        {
+            itor->matched = 0u;
+            ++itor;
+        }
+        mNumMatched = 0u;
+    }
+    //-----------------------------------------------------------------------
+    bool QueuedRenderableSet::match( const QueuedRenderable *begin, const QueuedRenderable *end )
+    {
+        if( mSlots.empty() )
+            return begin == end;
+
+        for( const QueuedRenderable *itor = begin; itor != end; ++itor )
+        {
+            Slot *slot = findSlot( *itor );
+            if( slot->matched == slot->count )
+                return false;  // Not in the set (count = 0), or found more times than added
+            ++slot->matched;
+        }
+        mNumMatched += static_cast<size_t>( end - begin );
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    RenderQueue::SortCache *RenderQueue::findSortCache( RenderQueueGroup &renderQueueGroup,
+                                                        bool bCreate )
+    {
+        const Camera *camera = mSceneManager->getCamerasInProgress().renderingCamera;
+        const unsigned long currentFrame = mRoot ? mRoot->getNextFrameNumber() : 0u;
+
+        SortCacheVec &sortCaches = renderQueueGroup.mSortCaches;
+
+        // Forget about cameras that haven't rendered this RQ in a while
+        SortCacheVec::iterator itor = sortCaches.begin();
+        while( itor != sortCaches.end() )
+        {
+            if( itor->camera != camera && itor->lastFrame + c_sortCacheMaxFrames < currentFrame )
+                itor = efficientVectorRemove( sortCaches, itor );
+            else
+                ++itor;
+        }
+
+        itor = sortCaches.begin();
+        while( itor != sortCaches.end() && itor->camera != camera )
+            ++itor;
+
+        if( itor == sortCaches.end() )
+        {
+            if( !bCreate )
+                return 0;
+
+            sortCaches.push_back( SortCache() );
+            itor = sortCaches.end() - 1u;
+            itor->camera = camera;
+        }
+
+        itor->lastFrame = currentFrame;
+        return &( *itor );
+    }
+    //-----------------------------------------------------------------------
+    bool RenderQueue::reuseLastSort( RenderQueueGroup &renderQueueGroup,
+                                     const QueuedRenderableFingerprint &fingerprint,
+                                     size_t numRenderables )
+    {
+        SortCache *sortCache = findSortCache( renderQueueGroup, false );
+        if( !sortCache || sortCache->input != fingerprint ||
+            sortCache->inputSet.size() != numRenderables )
+        {
+            return false;
+        }
+
+        // The fingerprint may collide (e.g. a freed object whose memory got reused).
+        // Replaying 'sorted' in that case would render the wrong or dangling objects
+        QueuedRenderableSet &inputSet = sortCache->inputSet;
+        inputSet.resetMatches();
+
+        QueuedRenderableArrayPerThread::const_iterator itor =
+            renderQueueGroup.mQueuedRenderablesPerThread.begin();
+        QueuedRenderableArrayPerThread::const_iterator endt =
+            renderQueueGroup.mQueuedRenderablesPerThread.end();
+        while( itor != endt )
+        {
+            if( !inputSet.match( itor->q.begin(), itor->q.end() ) )
+                return false;
+            ++itor;
+        }
+
+        if( !inputSet.allMatched() )
+            return false;
+
+        if( !sortCache->sorted.empty() )
+        {
+            renderQueueGroup.mQueuedRenderables.appendPOD(
+                &sortCache->sorted.front(), &sortCache->sorted.front() + sortCache->sorted.size() );
+        }
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::saveLastSortInput( RenderQueueGroup &renderQueueGroup,
+                                         const QueuedRenderableFingerprint &fingerprint,
+                                         size_t numRenderables )
+    {
+        SortCache *sortCache = findSortCache( renderQueueGroup, true );
+        sortCache->input = fingerprint;
+
+        sortCache->inputSet.reset( numRenderables );
+        QueuedRenderableArrayPerThread::const_iterator itor =
+            renderQueueGroup.mQueuedRenderablesPerThread.begin();
+        QueuedRenderableArrayPerThread::const_iterator endt =
+            renderQueueGroup.mQueuedRenderablesPerThread.end();
+        while( itor != endt )
+        {
+            sortCache->inputSet.add( itor->q.begin(), itor->q.end() );
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::saveLastSortResults( RenderQueueGroup &renderQueueGroup )
+    {
+        SortCache *sortCache = findSortCache( renderQueueGroup, true );
+
+        sortCache->sorted.assign( renderQueueGroup.mQueuedRenderables.begin(),
+                                  renderQueueGroup.mQueuedRenderables.end() );
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::mergeSortedPerThread( RenderQueueGroup &renderQueueGroup )
+    {
+        QueuedRenderableArray &queuedRenderables = renderQueueGroup.mQueuedRenderables;
+        const QueuedRenderableArrayPerThread &perThreadQueue =
+            renderQueueGroup.mQueuedRenderablesPerThread;
+
+        typedef FrameArenaVector<const QueuedRenderable *>::type CursorVec;
+        FrameArenaAllocator<const QueuedRenderable *> allocator( mSceneManager->getFrameArena() );
+        CursorVec cursors( allocator );
+        CursorVec cursorsEnd( allocator );
+        cursors.reserve( perThreadQueue.size() );
+        cursorsEnd.reserve( perThreadQueue.size() );
+
+        QueuedRenderableArrayPerThread::const_iterator itThread = perThreadQueue.begin();
+        QueuedRenderableArrayPerThread::const_iterator enThread = perThreadQueue.end();
+        while( itThread != enThread )
+        {
+            if( !itThread->q.empty() )
+            {
+                cursors.push_back( itThread->q.begin() );
+                cursorsEnd.push_back( itThread->q.end() );
+            }
+            ++itThread;
+        }
+
+        // k-way merge. There are as many arrays as threads, so finding the smallest
+        // linearly is faster than keeping a heap. Ties go to the lowest thread.
+        while( cursors.size() > 1u )
+        {
+            size_t smallest = 0;
+            for( size_t i = 1u; i < cursors.size(); ++i )
+            {
+                if( cursors[i]->hash < cursors[smallest]->hash )
+                    smallest = i;
+            }
+
+            queuedRenderables.push_back( *cursors[smallest]++ );
+
+            if( cursors[smallest] == cursorsEnd[smallest] )
+            {
+                cursors.erase( cursors.begin() + smallest );
+                cursorsEnd.erase( cursorsEnd.begin() + smallest );
+            }
+        }
+
+        if( !cursors.empty() )
+            queuedRenderables.appendPOD( cursors[0], cursorsEnd[0] );
+    }
+    //-----------------------------------------------------------------------
+    bool RenderQueue::sortRenderQueue( uint8 rqId )
+    {
+        RenderQueueGroup &renderQueueGroup = mRenderQueues[rqId];
+        QueuedRenderableArray &queuedRenderables = renderQueueGroup.mQueuedRenderables;
+        QueuedRenderableArrayPerThread &perThreadQueue = renderQueueGroup.mQueuedRenderablesPerThread;
+
+        const bool temporalCoherence =
+            renderQueueGroup.mSortTemporalCoherence && renderQueueGroup.mSortMode != DisableSort;
+
+        size_t numRenderables = 0;
+        QueuedRenderableFingerprint fingerprint;
+        QueuedRenderableArrayPerThread::iterator itor = perThreadQueue.begin();
+        QueuedRenderableArrayPerThread::iterator endt = perThreadQueue.end();
+
+        while( itor != endt )
+        {
+            numRenderables += itor->q.size();
+            if( temporalCoherence )
+                fingerprint.add( itor->q.begin(), itor->q.end() );
+            ++itor;
+        }
+
+        if( temporalCoherence )
+        {
+            if( reuseLastSort( renderQueueGroup, fingerprint, numRenderables ) )
+            {
+                renderQueueGroup.mSorted = true;
+                return true;
+            }
+
+            saveLastSortInput( renderQueueGroup, fingerprint, numRenderables );
+        }
+
+        queuedRenderables.reserve( numRenderables );
+
+        if( renderQueueGroup.mSortMode == ParallelRadixSort )
+        {
+            itor = perThreadQueue.begin();
+            while( itor != endt )
+            {
+                if( itor->q.size() > 1u )
+                    mPendingRadixSorts.push_back( &itor->q );
+                ++itor;
+            }
+
+            // mergeSortedPerThread will be called once the worker threads are done
+            return false;
+        }
+
+        itor = perThreadQueue.begin();
+        while( itor != endt )
+        {
+            queuedRenderables.appendPOD( itor->q.begin(), itor->q.end() );
+            ++itor;
+        }
+
+        // Temporal coherence across frames is exploited by reuseLastSort, although it only
+        // helps when the contents are exactly the same. Using insertion sorts seeded with the
+        // order of the previous frame, as explained by L. Spiro in
+        // http://www.gamedev.net/topic/661114-temporal-coherence-and-render-queue-sorting/?view=findpost&p=5181408
+        // would require a stable way to identify the same Renderable across frames.
+        if( renderQueueGroup.mSortMode == NormalSort )
+        {
+            std::sort( queuedRenderables.begin(), queuedRenderables.end() );
+            renderQueueGroup.mSorted = true;
+        }
+        else if( renderQueueGroup.mSortMode == StableSort )
+        {
+            std::stable_sort( queuedRenderables.begin(), queuedRenderables.end() );
+            renderQueueGroup.mSorted = true;
+        }
+
+        if( temporalCoherence )
+            saveLastSortResults( renderQueueGroup );
+
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::sortRenderQueues( uint8 firstRq, uint8 lastRq )
+    {
+        OgreProfileGroupAggregate( "Sorting", OGREPROF_RENDERING );
+
+        bool needsMerging = false;
+
+        for( size_t i = firstRq; i < lastRq; ++i )
+        {
+            if( !mRenderQueues[i].mSorted )
+                needsMerging |= !sortRenderQueue( static_cast<uint8>( i ) );
+        }
+
+        if( !mPendingRadixSorts.empty() )
+        {
+            RenderQueueRadixSortTask radixSortTask( this );
+            TaskScheduler *taskScheduler = mSceneManager->getTaskScheduler();
+            const TaskScheduler::TaskId taskId =
+                taskScheduler->addTask( &radixSortTask, mPendingRadixSorts.size(), 1u );
+            taskScheduler->waitFor( taskId );
+            mPendingRadixSorts.clear();
+        }
+
+        if( needsMerging )
+        {
+            for( size_t i = firstRq; i < lastRq; ++i )
+            {
+                RenderQueueGroup &renderQueueGroup = mRenderQueues[i];
+                if( !renderQueueGroup.mSorted && renderQueueGroup.mSortMode == ParallelRadixSort )
+                {
+                    mergeSortedPerThread( renderQueueGroup );
+                    renderQueueGroup.mSorted = true;
+
+                    if( renderQueueGroup.mSortTemporalCoherence )
+                        saveLastSortResults( renderQueueGroup );
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::touchTextures( uint8 firstRq, uint8 lastRq )
+    {
+        OgreProfileExhaustive( "RenderQueue::touchTextures" );
+
+        const CamerasInProgress cameras = mSceneManager->getCamerasInProgress();
+        const Camera *camera = cameras.lodCamera ? cameras.lodCamera : cameras.renderingCamera;
+        if( !camera )
+            return;
+
+        const Vector3 cameraPos = camera->getDerivedPosition();
+        const uint32 frameCount = mVaoManager->getFrameCount();
+
+        for( size_t i = firstRq; i < lastRq; ++i )
+        {
+            // Renderables are sorted, thus those sharing the same datablock tend to be
+            // together. Only touch the textures once per run, with the lowest distance.
+            HlmsDatablock *lastDatablock = 0;
+            float lowestDistance = std::numeric_limits<float>::max();
+
+            const QueuedRenderableArray &queuedRenderables = mRenderQueues[i].mQueuedRenderables;
+            QueuedRenderableArray::const_iterator itor = queuedRenderables.begin();
+            QueuedRenderableArray::const_iterator endt = queuedRenderables.end();
+
+            while( itor != endt )
+            {
+                HlmsDatablock *datablock = itor->renderable->getDatablock();
+                if( datablock != lastDatablock )
+                {
+                    if( lastDatablock )
+                        lastDatablock->_touchTextures( frameCount, lowestDistance );
+                    lastDatablock = datablock;
+                    lowestDistance = std::numeric_limits<float>::max();
+                }
+
+                const Aabb aabb = itor->movableObject->getWorldAabb();
+                const float distance = aabb.mCenter.distance( cameraPos ) - aabb.mHalfSize.length();
+                lowestDistance = std::min( lowestDistance, std::max( distance, 0.0f ) );
+
+                ++itor;
+            }
+
+            if( lastDatablock )
+                lastDatablock->_touchTextures( frameCount, lowestDistance );
+        }
+    }
+    //-----------------------------------------------------------------------
     void RenderQueue::render( RenderSystem *rs, uint8 firstRq, uint8 lastRq, bool casterPass,
                               bool dualParaboloid )
     {
@@ -374,58 +984,13 @@ namespace Ogre
             startIndirectDraw = indirectDraw;
         }
 
-        for( size_t i = firstRq; i < lastRq; ++i )
-        {
-            QueuedRenderableArray &queuedRenderables = mRenderQueues[i].mQueuedRenderables;
-            QueuedRenderableArrayPerThread &perThreadQueue =
-                mRenderQueues[i].mQueuedRenderablesPerThread;
+        sortRenderQueues( firstRq, lastRq );
 
-            if( !mRenderQueues[i].mSorted )
-            {
-                OgreProfileGroupAggregate( "Sorting", OGREPROF_RENDERING );
-
-                size_t numRenderables = 0;
-                QueuedRenderableArrayPerThread::const_iterator itor = perThreadQueue.begin();
-                QueuedRenderableArrayPerThread::const_iterator endt = perThreadQueue.end();
-
-                while( itor != endt )
-                {
-                    numRenderables += itor->q.size();
-                    ++itor;
-                }
-
-                queuedRenderables.reserve( numRenderables );
-
-                itor = perThreadQueue.begin();
-                while( itor != endt )
-                {
-                    queuedRenderables.appendPOD( itor->q.begin(), itor->q.end() );
-                    ++itor;
-                }
-
-                // TODO: Exploit temporal coherence across frames then use insertion sorts.
-                // As explained by L. Spiro in
-                // http://www.gamedev.net/topic/661114-temporal-coherence-and-render-queue-sorting/?view=findpost&p=5181408
-                // Keep a list of sorted indices from the previous frame (one per camera).
-                // If we have the sorted list "5, 1, 4, 3, 2, 0":
-                //  * If it grew from last frame, append: 5, 1, 4, 3, 2, 0, 6, 7 and use insertion sort.
-                //  * If it's the same, leave it as is, and use insertion sort just in case.
-                //  * If it's shorter, reset the indices 0, 1, 2, 3, 4; probably use quicksort or other
-                //  generic sort
-                //
-                // TODO2: Explore sorting first on multiple threads, then merge sort into one.
-                if( mRenderQueues[i].mSortMode == NormalSort )
-                {
-                    std::sort( queuedRenderables.begin(), queuedRenderables.end() );
-                    mRenderQueues[i].mSorted = true;
-                }
-                else if( mRenderQueues[i].mSortMode == StableSort )
-                {
-                    std::stable_sort( queuedRenderables.begin(), queuedRenderables.end() );
-                    mRenderQueues[i].mSorted = true;
-                }
-            }
+        if( rs->getTextureGpuManager()->getResidencyBudget() )
+            touchTextures( firstRq, lastRq );
 
+        for( size_t i = firstRq; i < lastRq; ++i )
+        {
             if( mRenderQueues[i].mMode == V1_LEGACY )
             {
                 if( mLastVaoName )
@@ -473,7 +1038,10 @@ namespace Ogre
         {
             Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( i ) );
             if( hlms )
+            {
                 hlms->postCommandBufferExecution( mCommandBuffer );
+                hlms->_createPendingShaderCacheEntries();
+            }
         }
 
         --mRenderingStarted;
@@ -544,178 +1112,446 @@ namespace Ogre
         mLastTextureHash = lastTextureHash;
     }
     //-----------------------------------------------------------------------
-    unsigned char *RenderQueue::renderGL3( RenderSystem *rs, bool casterPass, bool dualParaboloid,
-                                           HlmsCache passCache[],
-                                           const RenderQueueGroup &renderQueueGroup,
-                                           IndirectBufferPacked *indirectBuffer,
-                                           unsigned char *indirectDraw,
-                                           unsigned char *startIndirectDraw )
+    void RenderQueue::addDrawCommand( DrawCommandState &state, VertexArrayObject *vao,
+                                      uint32 baseInstance )
     {
-        VertexArrayObject *lastVao = 0;
-        uint32 lastVaoName = mLastVaoName;
-        HlmsCache const *lastHlmsCache = &c_dummyCache;
-        uint32 lastHlmsCacheHash = 0;
+        if( state.drawCmd != state.commandBuffer->getLastCommand() ||
+            state.lastVaoName != vao->getVaoName() )
+        {
+            // Different mesh, vertex buffers or layout. Make a new draw call.
+            //(or also the the Hlms made a batch-breaking command)
 
-        int baseInstanceAndIndirectBuffers = 0;
-        if( mVaoManager->supportsIndirectBuffers() )
-            baseInstanceAndIndirectBuffers = 2;
-        else if( mVaoManager->supportsBaseInstance() )
-            baseInstanceAndIndirectBuffers = 1;
+            OGRE_ASSERT_MEDIUM( vao->getVaoName() != 0u &&
+                                "Invalid Vao name! This can happen if a BT_IMMUTABLE buffer was "
+                                "recently created and VaoManager::_beginFrame() wasn't called" );
 
-        const bool isUsingInstancedStereo = mSceneManager->isUsingInstancedStereo();
-        const uint32 instancesPerDraw = isUsingInstancedStereo ? 2u : 1u;
-        const uint32 baseInstanceShift = isUsingInstancedStereo ? 1u : 0u;
-        uint32 instanceCount = instancesPerDraw;
+            if( state.lastVaoName != vao->getVaoName() )
+            {
+                *state.commandBuffer->addCommand<CbVao>() = CbVao( vao );
+                *state.commandBuffer->addCommand<CbIndirectBuffer>() =
+                    CbIndirectBuffer( state.indirectBuffer );
+                state.lastVaoName = vao->getVaoName();
+            }
 
-        CbDrawCall *drawCmd = 0;
-        CbSharedDraw *drawCountPtr = 0;
+            void *offset = reinterpret_cast<void *>(
+                static_cast<ptrdiff_t>( state.indirectBuffer->_getFinalBufferStart() ) +
+                ( state.indirectDraw - state.startIndirectDraw ) );
 
-        RenderingMetrics stats;
+            if( vao->getIndexBuffer() )
+            {
+                CbDrawCallIndexed *drawCall = state.commandBuffer->addCommand<CbDrawCallIndexed>();
+                *drawCall = CbDrawCallIndexed( state.baseInstanceAndIndirectBuffers, vao, offset );
+                state.drawCmd = drawCall;
+            }
+            else
+            {
+                CbDrawCallStrip *drawCall = state.commandBuffer->addCommand<CbDrawCallStrip>();
+                *drawCall = CbDrawCallStrip( state.baseInstanceAndIndirectBuffers, vao, offset );
+                state.drawCmd = drawCall;
+            }
 
-        const QueuedRenderableArray &queuedRenderables = renderQueueGroup.mQueuedRenderables;
+            state.lastVao = 0;
+            state.numDraws += 1u;
+        }
 
-        QueuedRenderableArray::const_iterator itor = queuedRenderables.begin();
-        QueuedRenderableArray::const_iterator endt = queuedRenderables.end();
+        if( state.lastVao != vao )
+        {
+            // Different mesh, but same vertex buffers & layouts. Advance indirection buffer.
+            ++state.drawCmd->numDraws;
+
+            if( vao->mIndexBuffer )
+            {
+                CbDrawIndexed *drawIndexedPtr = reinterpret_cast<CbDrawIndexed *>( state.indirectDraw );
+                state.indirectDraw += sizeof( CbDrawIndexed );
+
+                state.drawCountPtr = drawIndexedPtr;
+                drawIndexedPtr->primCount = vao->mPrimCount;
+                drawIndexedPtr->instanceCount = state.instancesPerDraw;
+                drawIndexedPtr->firstVertexIndex =
+                    uint32( vao->mIndexBuffer->_getFinalBufferStart() + vao->mPrimStart );
+                drawIndexedPtr->baseVertex = uint32( vao->mBaseVertexBuffer->_getFinalBufferStart() );
+                drawIndexedPtr->baseInstance = baseInstance << state.baseInstanceShift;
+            }
+            else
+            {
+                CbDrawStrip *drawStripPtr = reinterpret_cast<CbDrawStrip *>( state.indirectDraw );
+                state.indirectDraw += sizeof( CbDrawStrip );
+
+                state.drawCountPtr = drawStripPtr;
+                drawStripPtr->primCount = vao->mPrimCount;
+                drawStripPtr->instanceCount = state.instancesPerDraw;
+                drawStripPtr->firstVertexIndex =
+                    uint32( vao->mBaseVertexBuffer->_getFinalBufferStart() + vao->mPrimStart );
+                drawStripPtr->baseInstance = baseInstance << state.baseInstanceShift;
+            }
+
+            state.instanceCount = state.instancesPerDraw;
+            state.lastVao = vao;
+            state.numInstances += state.instancesPerDraw;
+        }
+        else
+        {
+            // Same mesh. Just go with instancing. Keep the counter in
+            // an external variable, as the region can be write-combined
+            state.instanceCount += state.instancesPerDraw;
+            state.drawCountPtr->instanceCount = state.instanceCount;
+            state.numInstances += state.instancesPerDraw;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::renderGL3Serial( DrawCommandState &state, bool casterPass,
+                                       HlmsCache passCache[],
+                                       const QueuedRenderableArray &queuedRenderables, size_t begin,
+                                       size_t end )
+    {
+        HlmsCache const *lastHlmsCache = &c_dummyCache;
+        uint32 lastHlmsCacheHash = 0;
+
+        QueuedRenderableArray::const_iterator itor = queuedRenderables.begin() + begin;
+        QueuedRenderableArray::const_iterator endt = queuedRenderables.begin() + end;
+        PreparedDrawArray::const_iterator itPrepared = mPreparedDraws.begin() + begin;
+
+        mBatchedBaseInstances.resizePOD( end - begin );
+        uint32 const *batchedBaseInstance = 0;
+        size_t numBatchedLeft = 0u;
+        PreparedDrawArray::const_iterator itRunEnd = itPrepared;
+        PreparedDrawArray::const_iterator enPrepared = mPreparedDraws.begin() + end;
 
         while( itor != endt )
         {
             const QueuedRenderable &queuedRenderable = *itor;
-            uint8 meshLod = queuedRenderable.movableObject->getCurrentMeshLod();
-            const VertexArrayObjectArray &vaos =
-                queuedRenderable.renderable->getVaos( static_cast<VertexPass>( casterPass ) );
-
-            VertexArrayObject *vao = vaos[meshLod];
-            const HlmsDatablock *datablock = queuedRenderable.renderable->getDatablock();
+            VertexArrayObject *vao = itPrepared->vao;
+            const HlmsDatablock *datablock = itPrepared->datablock;
 
-            Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( datablock->mType ) );
+            uint32 baseInstance;
 
-            lastHlmsCacheHash = lastHlmsCache->hash;
-            const HlmsCache *hlmsCache = hlms->getMaterial( lastHlmsCache, passCache[datablock->mType],
-                                                            queuedRenderable, casterPass );
-            if( lastHlmsCacheHash != hlmsCache->hash )
+            if( numBatchedLeft )
             {
-                CbPipelineStateObject *psoCmd = mCommandBuffer->addCommand<CbPipelineStateObject>();
-                *psoCmd = CbPipelineStateObject( &hlmsCache->pso );
-                lastHlmsCache = hlmsCache;
-
-                // Flush the Vao when changing shaders. Needed by D3D11/12 & possibly Vulkan
-                lastVaoName = 0;
+                // Already filled by fillBuffersForV2Batch. Same PSO, no commands were added.
+                baseInstance = *batchedBaseInstance++;
+                --numBatchedLeft;
             }
-
-            uint32 baseInstance = hlms->fillBuffersForV2( hlmsCache, queuedRenderable, casterPass,
-                                                          lastHlmsCacheHash, mCommandBuffer );
-
-            if( drawCmd != mCommandBuffer->getLastCommand() || lastVaoName != vao->getVaoName() )
+            else
             {
-                // Different mesh, vertex buffers or layout. Make a new draw call.
-                //(or also the the Hlms made a batch-breaking command)
+                Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( datablock->mType ) );
 
-                OGRE_ASSERT_MEDIUM( vao->getVaoName() != 0u &&
-                                    "Invalid Vao name! This can happen if a BT_IMMUTABLE buffer was "
-                                    "recently created and VaoManager::_beginFrame() wasn't called" );
+                lastHlmsCacheHash = lastHlmsCache->hash;
+                const HlmsCache *hlmsCache = hlms->getMaterial(
+                    lastHlmsCache, passCache[datablock->mType], queuedRenderable, casterPass, true );
+                if( !hlmsCache )
+                {
+                    // Shaders are still being created. See Hlms::setDeferredShaderCacheCreation
+                    ++itor;
+                    ++itPrepared;
+                    continue;
+                }
 
-                if( lastVaoName != vao->getVaoName() )
+                if( lastHlmsCacheHash != hlmsCache->hash )
                 {
-                    *mCommandBuffer->addCommand<CbVao>() = CbVao( vao );
-                    *mCommandBuffer->addCommand<CbIndirectBuffer>() = CbIndirectBuffer( indirectBuffer );
-                    lastVaoName = vao->getVaoName();
+                    CbPipelineStateObject *psoCmd =
+                        state.commandBuffer->addCommand<CbPipelineStateObject>();
+                    *psoCmd = CbPipelineStateObject( &hlmsCache->pso );
+                    lastHlmsCache = hlmsCache;
+
+                    // Flush the Vao when changing shaders. Needed by D3D11/12 & possibly Vulkan
+                    state.lastVaoName = 0;
                 }
 
-                void *offset = reinterpret_cast<void *>(
-                    static_cast<ptrdiff_t>( indirectBuffer->_getFinalBufferStart() ) +
-                    ( indirectDraw - startIndirectDraw ) );
+                baseInstance = hlms->fillBuffersForV2( hlmsCache, queuedRenderable, casterPass,
+                                                       lastHlmsCacheHash, state.commandBuffer );
 
-                if( vao->getIndexBuffer() )
+                // Find the run of Renderables that share the HlmsCache and datablock
+                // with this one, and let the Hlms fill them in one go. If the Hlms
+                // stopped early, the rest of the run is still the same run.
+                if( itRunEnd <= itPrepared )
                 {
-                    CbDrawCallIndexed *drawCall = mCommandBuffer->addCommand<CbDrawCallIndexed>();
-                    *drawCall = CbDrawCallIndexed( baseInstanceAndIndirectBuffers, vao, offset );
-                    drawCmd = drawCall;
+                    itRunEnd = itPrepared + 1;
+                    while( itRunEnd != enPrepared && itRunEnd->datablock == datablock &&
+                           itRunEnd->hlmsHash == itPrepared->hlmsHash )
+                    {
+                        ++itRunEnd;
+                    }
                 }
-                else
+
+                const size_t runLength = static_cast<size_t>( itRunEnd - itPrepared ) - 1u;
+                if( runLength )
                 {
-                    CbDrawCallStrip *drawCall = mCommandBuffer->addCommand<CbDrawCallStrip>();
-                    *drawCall = CbDrawCallStrip( baseInstanceAndIndirectBuffers, vao, offset );
-                    drawCmd = drawCall;
+                    numBatchedLeft = hlms->fillBuffersForV2Batch( hlmsCache, itor + 1, runLength,
+                                                                  casterPass,
+                                                                  mBatchedBaseInstances.begin() );
+                    batchedBaseInstance = mBatchedBaseInstances.begin();
                 }
+            }
 
-                lastVao = 0;
-                stats.mDrawCount += 1u;
+            addDrawCommand( state, vao, baseInstance );
+
+            ++itor;
+            ++itPrepared;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::_recordParallelFillSegments( size_t begin, size_t end, size_t threadIdx )
+    {
+        Hlms *hlms = mParallelFillHlms;
+        const bool casterPass = mPrepareCasterPass;
+
+        for( size_t segmentIdx = begin; segmentIdx < end; ++segmentIdx )
+        {
+            ParallelFillSegment &segment = mParallelFillSegments[segmentIdx];
+            DrawCommandState &state = segment.state;
+
+            if( segment.firstDraw == segment.end )
+            {
+                segment.parallelEnd = segment.end;
+                continue;
             }
 
-            if( lastVao != vao )
+            // The main thread already set the PSO of the first draw
+            HlmsCache const *lastHlmsCache = mPreparedDraws[segment.firstDraw].hlmsCache;
+
+            size_t i = segment.firstDraw;
+            for( ; i < segment.end; ++i )
             {
-                // Different mesh, but same vertex buffers & layouts. Advance indirection buffer.
-                ++drawCmd->numDraws;
+                const PreparedDraw &preparedDraw = mPreparedDraws[i];
+                const HlmsCache *hlmsCache = preparedDraw.hlmsCache;
+                if( !hlmsCache )
+                    continue;  // Shaders are still being created
 
-                if( vao->mIndexBuffer )
+                if( lastHlmsCache != hlmsCache )
                 {
-                    CbDrawIndexed *drawIndexedPtr = reinterpret_cast<CbDrawIndexed *>( indirectDraw );
-                    indirectDraw += sizeof( CbDrawIndexed );
-
-                    drawCountPtr = drawIndexedPtr;
-                    drawIndexedPtr->primCount = vao->mPrimCount;
-                    drawIndexedPtr->instanceCount = instancesPerDraw;
-                    drawIndexedPtr->firstVertexIndex =
-                        uint32( vao->mIndexBuffer->_getFinalBufferStart() + vao->mPrimStart );
-                    drawIndexedPtr->baseVertex =
-                        uint32( vao->mBaseVertexBuffer->_getFinalBufferStart() );
-                    drawIndexedPtr->baseInstance = baseInstance << baseInstanceShift;
-
-                    instanceCount = instancesPerDraw;
+                    // If the Hlms stops at this draw, this PSO is harmless: the main
+                    // thread sets it again when it resumes
+                    *state.commandBuffer->addCommand<CbPipelineStateObject>() =
+                        CbPipelineStateObject( &hlmsCache->pso );
+                    lastHlmsCache = hlmsCache;
+
+                    // Flush the Vao when changing shaders. Needed by D3D11/12 & possibly Vulkan
+                    state.lastVaoName = 0;
                 }
-                else
-                {
-                    CbDrawStrip *drawStripPtr = reinterpret_cast<CbDrawStrip *>( indirectDraw );
-                    indirectDraw += sizeof( CbDrawStrip );
 
-                    drawCountPtr = drawStripPtr;
-                    drawStripPtr->primCount = vao->mPrimCount;
-                    drawStripPtr->instanceCount = instancesPerDraw;
-                    drawStripPtr->firstVertexIndex =
-                        uint32( vao->mBaseVertexBuffer->_getFinalBufferStart() + vao->mPrimStart );
-                    drawStripPtr->baseInstance = baseInstance << baseInstanceShift;
+                const uint32 baseInstance = hlms->fillBuffersForV2Parallel(
+                    segmentIdx, hlmsCache, mPrepareSrc[i], casterPass, state.commandBuffer );
+                if( baseInstance == Hlms::ParallelFillStop )
+                    break;
 
-                    instanceCount = instancesPerDraw;
-                }
+                addDrawCommand( state, preparedDraw.vao, baseInstance );
+            }
 
-                lastVao = vao;
-                stats.mInstanceCount += instancesPerDraw;
+            segment.parallelEnd = i;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::renderGL3Parallel( DrawCommandState &state, bool casterPass,
+                                         HlmsCache passCache[],
+                                         const QueuedRenderableArray &queuedRenderables )
+    {
+        const size_t numRenderables = queuedRenderables.size();
+        Hlms *hlms = mParallelFillHlms;
+
+        // Create the entries the worker threads couldn't find. Null means async creation
+        {
+            HlmsCache const *lastHlmsCache = &c_dummyCache;
+            PreparedDrawArray::iterator itor = mPreparedDraws.begin();
+            PreparedDrawArray::iterator endt = mPreparedDraws.end();
+            QueuedRenderableArray::const_iterator itQueued = queuedRenderables.begin();
+
+            while( itor != endt )
+            {
+                if( !itor->hlmsCache )
+                {
+                    itor->hlmsCache = hlms->getMaterial(
+                        lastHlmsCache, passCache[hlms->getType()], *itQueued, casterPass, true );
+                    if( itor->hlmsCache )
+                        lastHlmsCache = itor->hlmsCache;
+                }
+                ++itor;
+                ++itQueued;
             }
-            else
+        }
+
+        const size_t maxDrawsPerSegment = hlms->getParallelFillMaxDraws( casterPass );
+        const size_t numThreads = mSceneManager->getNumWorkerThreads();
+
+        size_t numSegments =
+            std::min( numThreads, std::max<size_t>( numRenderables / c_minDrawsPerParallelFillSegment,
+                                                    1u ) );
+        numSegments = std::max( numSegments,
+                                ( numRenderables + maxDrawsPerSegment - 1u ) / maxDrawsPerSegment );
+
+        if( mParallelFillCommandBuffers.size() < numSegments )
+        {
+            const size_t oldSize = mParallelFillCommandBuffers.size();
+            mParallelFillCommandBuffers.resize( numSegments );
+            for( size_t i = oldSize; i < numSegments; ++i )
+                mParallelFillCommandBuffers[i] = new CommandBuffer();
+        }
+
+        // Each segment gets the indirect buffer space of its worst case
+        mParallelFillSegments.resizePOD( numSegments );
+        size_t *numDrawsPerSegment = mSceneManager->getFrameArena()->allocate<size_t>( numSegments );
+        for( size_t i = 0u; i < numSegments; ++i )
+        {
+            ParallelFillSegment &segment = mParallelFillSegments[i];
+            segment.begin = numRenderables * i / numSegments;
+            segment.end = numRenderables * ( i + 1u ) / numSegments;
+            segment.firstDraw = segment.begin;
+            while( segment.firstDraw < segment.end && !mPreparedDraws[segment.firstDraw].hlmsCache )
+                ++segment.firstDraw;
+            segment.parallelEnd = segment.firstDraw;
+
+            segment.state = state;
+            segment.state.commandBuffer = mParallelFillCommandBuffers[i];
+            segment.state.indirectDraw = state.indirectDraw + segment.begin * sizeof( CbDrawIndexed );
+            segment.state.drawCmd = 0;
+            segment.state.drawCountPtr = 0;
+            segment.state.lastVao = 0;
+            segment.state.lastVaoName = 0;
+            segment.state.numDraws = 0;
+            segment.state.numInstances = 0;
+
+            numDrawsPerSegment[i] = segment.end - segment.begin;
+        }
+
+        hlms->_beginParallelFill( state.commandBuffer, numDrawsPerSegment, numSegments, casterPass );
+
+        for( size_t i = 0u; i < numSegments; ++i )
+        {
+            ParallelFillSegment &segment = mParallelFillSegments[i];
+            if( segment.firstDraw != segment.end )
             {
-                // Same mesh. Just go with instancing. Keep the counter in
-                // an external variable, as the region can be write-combined
-                instanceCount += instancesPerDraw;
-                drawCountPtr->instanceCount = instanceCount;
-                stats.mInstanceCount += instancesPerDraw;
+                CommandBuffer *commandBuffer = segment.state.commandBuffer;
+                *commandBuffer->addCommand<CbPipelineStateObject>() =
+                    CbPipelineStateObject( &mPreparedDraws[segment.firstDraw].hlmsCache->pso );
+                hlms->_beginParallelFillSegment( i, queuedRenderables[segment.firstDraw],
+                                                 casterPass, commandBuffer );
             }
+        }
 
-            switch( vao->getOperationType() )
+        RenderQueueParallelFillTask fillTask( this );
+        TaskScheduler *taskScheduler = mSceneManager->getTaskScheduler();
+        const TaskScheduler::TaskId taskId = taskScheduler->addTask( &fillTask, numSegments, 1u );
+        taskScheduler->waitFor( taskId );
+
+        hlms->_endParallelFill( mParallelFillCommandBuffers.begin() );
+
+        // Stitch the segments in order. Whatever the Hlms couldn't fill in parallel
+        // (i.e. animated objects) gets recorded right after the segment it belongs to.
+        for( size_t i = 0u; i < numSegments; ++i )
+        {
+            ParallelFillSegment &segment = mParallelFillSegments[i];
+
+            state.commandBuffer->appendCommands( *segment.state.commandBuffer );
+            state.numDraws += segment.state.numDraws;
+            state.numInstances += segment.state.numInstances;
+            state.lastVaoName = segment.state.lastVaoName;
+
+            if( segment.parallelEnd != segment.end )
             {
-            case OT_TRIANGLE_LIST:
-                stats.mFaceCount += ( vao->mPrimCount / 3u ) * instancesPerDraw;
-                break;
-            case OT_TRIANGLE_STRIP:
-            case OT_TRIANGLE_FAN:
-                stats.mFaceCount += ( vao->mPrimCount - 2u ) * instancesPerDraw;
-                break;
-            default:
-                break;
+                DrawCommandState serialState = segment.state;
+                serialState.commandBuffer = state.commandBuffer;
+                serialState.drawCmd = 0;
+                serialState.drawCountPtr = 0;
+                serialState.lastVao = 0;
+                serialState.lastVaoName = 0;
+                serialState.numDraws = 0;
+                serialState.numInstances = 0;
+
+                renderGL3Serial( serialState, casterPass, passCache, queuedRenderables,
+                                 segment.parallelEnd, segment.end );
+
+                state.numDraws += serialState.numDraws;
+                state.numInstances += serialState.numInstances;
+                state.lastVaoName = serialState.lastVaoName;
             }
+        }
 
-            stats.mVertexCount += vao->mPrimCount * instancesPerDraw;
+        state.indirectDraw += numRenderables * sizeof( CbDrawIndexed );
+        state.drawCmd = 0;
+        state.drawCountPtr = 0;
+        state.lastVao = 0;
+    }
+    //-----------------------------------------------------------------------
+    unsigned char *RenderQueue::renderGL3( RenderSystem *rs, bool casterPass, bool dualParaboloid,
+                                           HlmsCache passCache[],
+                                           const RenderQueueGroup &renderQueueGroup,
+                                           IndirectBufferPacked *indirectBuffer,
+                                           unsigned char *indirectDraw,
+                                           unsigned char *startIndirectDraw )
+    {
+        const bool isUsingInstancedStereo = mSceneManager->isUsingInstancedStereo();
 
-            ++itor;
+        DrawCommandState state;
+        state.commandBuffer = mCommandBuffer;
+        state.indirectBuffer = indirectBuffer;
+        state.startIndirectDraw = startIndirectDraw;
+        state.indirectDraw = indirectDraw;
+        state.baseInstanceAndIndirectBuffers = 0;
+        if( mVaoManager->supportsIndirectBuffers() )
+            state.baseInstanceAndIndirectBuffers = 2;
+        else if( mVaoManager->supportsBaseInstance() )
+            state.baseInstanceAndIndirectBuffers = 1;
+        state.instancesPerDraw = isUsingInstancedStereo ? 2u : 1u;
+        state.baseInstanceShift = isUsingInstancedStereo ? 1u : 0u;
+        state.drawCmd = 0;
+        state.drawCountPtr = 0;
+        state.lastVao = 0;
+        state.lastVaoName = mLastVaoName;
+        state.instanceCount = state.instancesPerDraw;
+        state.numDraws = 0;
+        state.numInstances = 0;
+
+        RenderingMetrics stats;
+
+        const QueuedRenderableArray &queuedRenderables = renderQueueGroup.mQueuedRenderables;
+        const size_t numRenderables = queuedRenderables.size();
+
+        // Only an Hlms that opted in can fill its buffers from multiple threads,
+        // and only if it renders the whole RQ. @see Hlms::getParallelFillMaxDraws
+        mParallelFillHlms = 0;
+        if( numRenderables >= c_minRenderablesForParallelFill &&
+            mSceneManager->getNumWorkerThreads() > 1u )
+        {
+            Hlms *hlms = mHlmsManager->getHlms(
+                static_cast<HlmsTypes>( queuedRenderables[0].renderable->getDatablock()->mType ) );
+            if( hlms->getParallelFillMaxDraws( casterPass ) > 0u )
+                mParallelFillHlms = hlms;
+        }
+
+        mPrepareResolveCaches = mParallelFillHlms != 0;
+        mPreparePassCache = passCache;
+
+        prepareDraws( queuedRenderables, casterPass, state.instancesPerDraw, stats );
+
+        if( mParallelFillHlms )
+        {
+            uint32 hlmsTypeMask = 0u;
+            ThreadPrepareMetricsArray::const_iterator itor = mPrepareMetricsPerThread.begin();
+            ThreadPrepareMetricsArray::const_iterator endt = mPrepareMetricsPerThread.end();
+            while( itor != endt )
+                hlmsTypeMask |= ( itor++ )->hlmsTypeMask;
+
+            if( hlmsTypeMask != ( 1u << mParallelFillHlms->getType() ) )
+                mParallelFillHlms = 0;
         }
 
+        if( mParallelFillHlms )
+            renderGL3Parallel( state, casterPass, passCache, queuedRenderables );
+        else
+            renderGL3Serial( state, casterPass, passCache, queuedRenderables, 0u, numRenderables );
+
+        mPrepareResolveCaches = false;
+        mParallelFillHlms = 0;
+
+        stats.mDrawCount += state.numDraws;
+        stats.mInstanceCount += state.numInstances;
         rs->_addMetrics( stats );
 
-        mLastVaoName = lastVaoName;
+        mLastVaoName = state.lastVaoName;
         mLastVertexData = 0;
         mLastIndexData = 0;
         mLastTextureHash = 0;
 
-        return indirectDraw;
+        return state.indirectDraw;
     }
     //-----------------------------------------------------------------------
     void RenderQueue::renderGL3V1( RenderSystem *rs, bool casterPass, bool dualParaboloid,
@@ -756,7 +1592,14 @@ namespace Ogre
 
             lastHlmsCacheHash = lastHlmsCache->hash;
             const HlmsCache *hlmsCache = hlms->getMaterial( lastHlmsCache, passCache[datablock->mType],
-                                                            queuedRenderable, casterPass );
+                                                            queuedRenderable, casterPass, true );
+            if( !hlmsCache )
+            {
+                // Shaders are still being created. See Hlms::setDeferredShaderCacheCreation
+                ++itor;
+                continue;
+            }
+
             if( lastHlmsCache != hlmsCache )
             {
                 CbPipelineStateObject *psoCmd = mCommandBuffer->addCommand<CbPipelineStateObject>();
@@ -954,4 +1797,16 @@ namespace Ogre
     {
         return mRenderQueues[rqId].mSortMode;
     }
+    //-----------------------------------------------------------------------
+    void RenderQueue::setSortTemporalCoherence( uint8 rqId, bool bTemporalCoherence )
+    {
+        mRenderQueues[rqId].mSortTemporalCoherence = bTemporalCoherence;
+        if( !bTemporalCoherence )
+            mRenderQueues[rqId].mSortCaches.clear();
+    }
+    //-----------------------------------------------------------------------
+    bool RenderQueue::getSortTemporalCoherence( uint8 rqId ) const
+    {
+        return mRenderQueues[rqId].mSortTemporalCoherence;
+    }
 }  // namespace Ogre
@@ -52,6 +52,7 @@ namespace Ogre
         mCurrentMaterialLod( 0 ),
         mLodMaterial( &MovableObject::c_DefaultLodMesh ),
         mHlmsGlobalIndex( std::numeric_limits<uint32>::max() ),
+        mHlmsStaticInstanceSlot( std::numeric_limits<uint32>::max() ),
         mRenderableVisible( true ),
         mPolygonModeOverrideable( true ),
         mUseIdentityProjection( false ),
@@ -37,7 +37,10 @@ THE SOFTWARE.
 #include "OgreSceneManager.h"
 #include "OgreScriptLoader.h"
 #include "OgreString.h"
+#include "OgreTimer.h"
+#include "Threading/OgreTaskScheduler.h"
 
+#include <exception>
 #include <sstream>
 
 namespace Ogre
@@ -59,7 +62,11 @@ namespace Ogre
     long ResourceGroupManager::RESOURCE_SYSTEM_NUM_REFERENCE_COUNTS = 3;
     //-----------------------------------------------------------------------
     //-----------------------------------------------------------------------
-    ResourceGroupManager::ResourceGroupManager() : mLoadingListener( 0 ), mCurrentGroup( 0 )
+    ResourceGroupManager::ResourceGroupManager() :
+        mLoadingListener( 0 ),
+        mNumScriptParsingThreads( 0 ),
+        mSlowScriptThreshold( 0 ),
+        mCurrentGroup( 0 )
     {
         // Create the 'General' group
         createResourceGroup( DEFAULT_RESOURCE_GROUP_NAME );
@@ -143,6 +150,8 @@ namespace Ogre
         }
         OGRE_LOCK_MUTEX( grp->OGRE_AUTO_MUTEX_NAME );  // lock group mutex;
 
+        mScriptTimings.clear();
+
         if( grp->groupStatus == ResourceGroup::UNINITIALSED )
         {
             // in the process of initialising
@@ -165,6 +174,8 @@ namespace Ogre
 
         ScopedCLocale scopedCLocale( changeLocaleTemporarily );
 
+        mScriptTimings.clear();
+
         // Intialise all declared resource groups
         ResourceGroupMap::iterator i, iend;
         iend = mResourceGroupMap.end();
@@ -1067,6 +1078,59 @@ namespace Ogre
         return 0;  // No loader was found
     }
     //-----------------------------------------------------------------------
+    namespace
+    {
+        /// A script being parsed by parseResourceGroupScripts with mNumScriptParsingThreads > 1
+        struct PreparedScript
+        {
+            ScriptLoader   *loader;
+            const FileInfo *fileInfo;
+            /// Null if the loader doesn't support prepared scripts or the script is skipped
+            DataStreamPtr stream;
+            Any           prepared;
+            uint64        prepareTime;
+            /// Thrown by prepareScript. Rethrown from the main thread
+            std::exception_ptr exception;
+            /// Set by ResourceGroupListener::scriptParseStarted
+            bool skip;
+        };
+        typedef vector<PreparedScript>::type PreparedScriptVec;
+
+        class PrepareScriptsTask : public RangeTask
+        {
+            PreparedScriptVec &mPreparedScripts;
+
+        public:
+            PrepareScriptsTask( PreparedScriptVec &preparedScripts ) :
+                mPreparedScripts( preparedScripts )
+            {
+            }
+
+            void execute( size_t begin, size_t end, size_t threadIdx ) override
+            {
+                for( size_t i = begin; i < end; ++i )
+                {
+                    PreparedScript &preparedScript = mPreparedScripts[i];
+                    if( !preparedScript.stream )
+                        continue;
+
+                    Timer timer;
+                    try
+                    {
+                        preparedScript.prepared =
+                            preparedScript.loader->prepareScript( preparedScript.stream );
+                    }
+                    catch( Exception & )
+                    {
+                        preparedScript.exception = std::current_exception();
+                    }
+                    preparedScript.prepareTime = timer.getMicroseconds();
+                    preparedScript.stream->seek( 0 );
+                }
+            }
+        };
+    }  // namespace
+    //-----------------------------------------------------------------------
     void ResourceGroupManager::parseResourceGroupScripts( ResourceGroup *grp )
     {
         LogManager::getSingleton().logMessage( "Parsing scripts for resource group " + grp->name );
@@ -1100,48 +1164,122 @@ namespace Ogre
         // Fire scripting event
         fireResourceGroupScriptingStarted( grp->name, scriptCount );
 
-        // Iterate over scripts and parse
-        // Note we respect original ordering
-        for( ScriptLoaderFileList::iterator slfli = scriptLoaderFileList.begin();
-             slfli != scriptLoaderFileList.end(); ++slfli )
+        if( mNumScriptParsingThreads > 1u )
         {
-            ScriptLoader *su = slfli->first;
-            // Iterate over each list
-            for( FileListList::iterator flli = slfli->second->begin(); flli != slfli->second->end();
-                 ++flli )
+            // Prepare the scripts in parallel, then parse them in order
+            PreparedScriptVec preparedScripts;
+            preparedScripts.reserve( scriptCount );
+
+            for( ScriptLoaderFileList::iterator slfli = scriptLoaderFileList.begin();
+                 slfli != scriptLoaderFileList.end(); ++slfli )
             {
-                // Iterate over each item in the list
-                for( FileInfoList::iterator fii = ( *flli )->begin(); fii != ( *flli )->end(); ++fii )
+                ScriptLoader *su = slfli->first;
+                const bool supportsPreparedScripts = su->supportsPreparedScripts();
+                for( FileListList::iterator flli = slfli->second->begin();
+                     flli != slfli->second->end(); ++flli )
                 {
-                    bool skipScript = false;
-                    fireScriptStarted( fii->filename, skipScript );
-                    if( skipScript )
+                    for( FileInfoList::iterator fii = ( *flli )->begin(); fii != ( *flli )->end();
+                         ++fii )
                     {
-                        LogManager::getSingleton().logMessage( "Skipping script " + fii->filename );
+                        PreparedScript preparedScript;
+                        preparedScript.loader = su;
+                        preparedScript.fileInfo = &( *fii );
+                        preparedScript.prepareTime = 0;
+                        // Ask now so that skipped scripts aren't opened nor prepared
+                        preparedScript.skip = false;
+                        fireScriptStarted( fii->filename, preparedScript.skip );
+                        // Workers must not touch the archives (e.g. zip archives aren't thread
+                        // safe), so read the whole script now.
+                        if( supportsPreparedScripts && !preparedScript.skip )
+                            preparedScript.stream = openScript( *fii, grp, true );
+                        preparedScripts.push_back( preparedScript );
                     }
-                    else
+                }
+            }
+
+            {
+                PrepareScriptsTask prepareScriptsTask( preparedScripts );
+                TaskScheduler taskScheduler( mNumScriptParsingThreads );
+                taskScheduler.addTask( &prepareScriptsTask, preparedScripts.size(), 1u );
+                taskScheduler.waitForAll();
+            }
+
+            PreparedScriptVec::iterator itor = preparedScripts.begin();
+            PreparedScriptVec::iterator endt = preparedScripts.end();
+
+            while( itor != endt )
+            {
+                const String &filename = itor->fileInfo->filename;
+                if( itor->skip )
+                {
+                    LogManager::getSingleton().logMessage( "Skipping script " + filename );
+                }
+                else
+                {
+                    LogManager::getSingleton().logMessage( "Parsing script " + filename );
+
+                    if( itor->exception )
+                        std::rethrow_exception( itor->exception );
+
+                    DataStreamPtr stream = itor->stream;
+                    if( !itor->loader->supportsPreparedScripts() )
+                        stream = openScript( *itor->fileInfo, grp, false );
+
+                    if( stream )
                     {
-                        LogManager::getSingleton().logMessage( "Parsing script " + fii->filename );
-                        DataStreamPtr stream = fii->archive->open( fii->filename );
-                        if( stream )
-                        {
-                            if( mLoadingListener )
-                                mLoadingListener->resourceStreamOpened( fii->filename, grp->name, 0,
-                                                                        stream );
+                        Timer timer;
+                        if( itor->stream )
+                            itor->loader->parsePreparedScript( itor->prepared, stream, grp->name );
+                        else
+                            itor->loader->parseScript( stream, grp->name );
+                        addScriptTiming( filename, itor->prepareTime, timer.getMicroseconds() );
+                    }
+                }
+                fireScriptEnded( filename, itor->skip );
 
-                            if( fii->archive->getType() == "FileSystem" &&
-                                stream->size() <= 1024 * 1024 )
+                // Release the memory as we go
+                itor->stream.reset();
+                itor->prepared = Any();
+                ++itor;
+            }
+        }
+        else
+        {
+            // Iterate over scripts and parse
+            // Note we respect original ordering
+            for( ScriptLoaderFileList::iterator slfli = scriptLoaderFileList.begin();
+                 slfli != scriptLoaderFileList.end(); ++slfli )
+            {
+                ScriptLoader *su = slfli->first;
+                // Iterate over each list
+                for( FileListList::iterator flli = slfli->second->begin();
+                     flli != slfli->second->end(); ++flli )
+                {
+                    // Iterate over each item in the list
+                    for( FileInfoList::iterator fii = ( *flli )->begin(); fii != ( *flli )->end();
+                         ++fii )
+                    {
+                        bool skipScript = false;
+                        fireScriptStarted( fii->filename, skipScript );
+                        if( skipScript )
+                        {
+                            LogManager::getSingleton().logMessage( "Skipping script " +
+                                                                   fii->filename );
+                        }
+                        else
+                        {
+                            LogManager::getSingleton().logMessage( "Parsing script " +
+                                                                   fii->filename );
+                            DataStreamPtr stream = openScript( *fii, grp, false );
+                            if( stream )
                             {
-                                DataStreamPtr cachedCopy;
-                                cachedCopy.reset(
-                                    OGRE_NEW MemoryDataStream( stream->getName(), stream ) );
-                                su->parseScript( cachedCopy, grp->name );
-                            }
-                            else
+                                Timer timer;
                                 su->parseScript( stream, grp->name );
+                                addScriptTiming( fii->filename, 0, timer.getMicroseconds() );
+                            }
                         }
+                        fireScriptEnded( fii->filename, skipScript );
                     }
-                    fireScriptEnded( fii->filename, skipScript );
                 }
             }
         }
@@ -1151,6 +1289,43 @@ namespace Ogre
                                                grp->name );
     }
     //-----------------------------------------------------------------------
+    DataStreamPtr ResourceGroupManager::openScript( const FileInfo &fileInfo, ResourceGroup *grp,
+                                                    bool bMemoryCopy )
+    {
+        DataStreamPtr stream = fileInfo.archive->open( fileInfo.filename );
+        if( stream )
+        {
+            if( mLoadingListener )
+                mLoadingListener->resourceStreamOpened( fileInfo.filename, grp->name, 0, stream );
+
+            if( bMemoryCopy ||
+                ( fileInfo.archive->getType() == "FileSystem" && stream->size() <= 1024 * 1024 ) )
+            {
+                DataStreamPtr cachedCopy;
+                cachedCopy.reset( OGRE_NEW MemoryDataStream( stream->getName(), stream ) );
+                stream = cachedCopy;
+            }
+        }
+        return stream;
+    }
+    //-----------------------------------------------------------------------
+    void ResourceGroupManager::addScriptTiming( const String &scriptName, uint64 prepareTime,
+                                                uint64 parseTime )
+    {
+        ScriptTiming scriptTiming;
+        scriptTiming.scriptName = scriptName;
+        scriptTiming.prepareTime = prepareTime;
+        scriptTiming.parseTime = parseTime;
+        mScriptTimings.push_back( scriptTiming );
+
+        if( mSlowScriptThreshold && prepareTime + parseTime >= mSlowScriptThreshold )
+        {
+            LogManager::getSingleton().logMessage(
+                "Slow script " + scriptName + ": " + StringConverter::toString( prepareTime ) +
+                " us preparing, " + StringConverter::toString( parseTime ) + " us parsing" );
+        }
+    }
+    //-----------------------------------------------------------------------
     void ResourceGroupManager::createDeclaredResources( ResourceGroup *grp )
     {
         for( ResourceDeclarationList::iterator i = grp->resourceDeclarations.begin();
@@ -47,6 +47,7 @@ THE SOFTWARE.
 #include "OgreException.h"
 #include "OgreExternalTextureSourceManager.h"
 #include "OgreFileSystem.h"
+#include "OgreFrameArena.h"
 #include "OgreFrameListener.h"
 #include "OgreFrameStats.h"
 #include "OgreHardwareBufferManager.h"
@@ -138,6 +139,7 @@ namespace Ogre
         mLogManager( 0 ),
         mRenderSystemCapabilitiesManager( 0 ),
         mFrameStats( 0 ),
+        mFrameArena( 0 ),
         mCompositorManager2( 0 ),
         mNextFrame( 0 ),
         mFrameSmoothingTime( 0.0f ),
@@ -227,6 +229,7 @@ namespace Ogre
         mParticleManager = OGRE_NEW ParticleSystemManager();
 
         mFrameStats = OGRE_NEW FrameStats();
+        mFrameArena = OGRE_NEW FrameArena();
 
         mTimer = OGRE_NEW Timer();
 
@@ -412,6 +415,7 @@ namespace Ogre
 
         OGRE_DELETE mWorkQueue;
 
+        OGRE_DELETE mFrameArena;
         OGRE_DELETE mFrameStats;
 
         OGRE_DELETE mTimer;
@@ -981,6 +985,9 @@ namespace Ogre
         // Tell the queue to process responses
         mWorkQueue->processResponses();
 
+        // Everything allocated from the arena numFrames ago is now free to reuse
+        mFrameArena->_advanceFrame();
+
 #if OGRE_PROFILING
         if( OgreProfilerUseStableMarkers )
         {
@@ -1092,6 +1099,10 @@ namespace Ogre
         if( !_fireFrameStarted() )
             return false;
 
+        // Meshes loaded asynchronously must be ready before updating the scene,
+        // so that the Items using them are updated and rendered this frame
+        mMeshManager->_updateAsyncLoads( mMeshManager->getAsyncUploadBudget() );
+
         SceneManagerEnumerator::SceneManagerIterator itor = mSceneManagerEnum->getSceneManagerIterator();
         while( itor.hasMoreElements() )
         {
@@ -1125,6 +1136,10 @@ namespace Ogre
         if( !_fireFrameStarted( evt ) )
             return false;
 
+        // Meshes loaded asynchronously must be ready before updating the scene,
+        // so that the Items using them are updated and rendered this frame
+        mMeshManager->_updateAsyncLoads( mMeshManager->getAsyncUploadBudget() );
+
         SceneManagerEnumerator::SceneManagerIterator itor = mSceneManagerEnum->getSceneManagerIterator();
         while( itor.hasMoreElements() )
         {
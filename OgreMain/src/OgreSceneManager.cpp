@@ -34,6 +34,7 @@ THE SOFTWARE.
 #include "Animation/OgreTagPoint.h"
 #include "Compositor/OgreCompositorShadowNode.h"
 #include "Compositor/Pass/PassScene/OgreCompositorPassSceneDef.h"
+#include "Math/Array/OgreBooleanMask.h"
 #include "OgreAnimation.h"
 #include "OgreAtmosphereComponent.h"
 #include "OgreBillboardChain.h"
@@ -45,6 +46,7 @@ THE SOFTWARE.
 #include "OgreEntity.h"
 #include "OgreForward3D.h"
 #include "OgreForwardClustered.h"
+#include "OgreFrameArena.h"
 #include "OgreGpuProgram.h"
 #include "OgreGpuProgramManager.h"
 #include "OgreHlmsManager.h"
@@ -75,7 +77,6 @@ THE SOFTWARE.
 #include "OgreTextureGpuManager.h"
 #include "OgreViewport.h"
 #include "OgreWireAabb.h"
-#include "Threading/OgreBarrier.h"
 #include "Threading/OgreUniformScalableTask.h"
 
 // This class implements the most basic scene manager
@@ -117,6 +118,8 @@ namespace Ogre
         mNumCubemapProbes( 0 ),
         mStaticMinDepthLevelDirty( 0 ),
         mStaticEntitiesDirty( true ),
+        mStaticTransformsVersion( 1u ),
+        mDefragmentSlotsPerFrame( 0 ),
         mPrePassMode( PrePassNone ),
         mSsrTexture( 0 ),
         mRefractionsTexture( 0 ),
@@ -166,11 +169,16 @@ namespace Ogre
         mLightMask( 0xFFFFFFFF ),
         mFindVisibleObjects( true ),
         mNumWorkerThreads( std::max<size_t>( numWorkerThreads, 1u ) ),
-        mForceMainThread( numWorkerThreads == 0u ? true : false ),
         mUpdateBoundsRequest( 0 ),
         mUserTask( 0 ),
         mRequestType( NUM_REQUESTS ),
-        mWorkerThreadsBarrier( 0 ),
+        mTaskScheduler( 0 ),
+        mUserTaskId( TaskScheduler::INVALID_TASK_ID ),
+        mFrameArena( 0 ),
+        mShadowCullingBatched( false ),
+        mNumBatchedShadowCulls( 0 ),
+        mBatchedShadowCullLodCamera( 0 ),
+        mCurrentBatchedShadowCull( 0 ),
         mSuppressRenderStateChanges( false ),
         mLastLightHash( 0 ),
         mLastLightLimit( 0 ),
@@ -202,6 +210,7 @@ namespace Ogre
 
         mRenderQueue =
             OGRE_NEW RenderQueue( root->getHlmsManager(), this, mDestRenderSystem->getVaoManager() );
+        mFrameArena = root->getFrameArena();
 
         // create the auto param data source instance
         mAutoParamDataSource = createAutoParamDataSource();
@@ -521,6 +530,46 @@ namespace Ogre
         mTagPointNodeMemoryManager.shrinkToFit();
     }
     //-----------------------------------------------------------------------
+    void SceneManager::setIncrementalDefragmentation( size_t slotsPerFrame )
+    {
+        mDefragmentSlotsPerFrame = slotsPerFrame;
+
+        const bool bIncremental = slotsPerFrame != 0u;
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            mNodeMemoryManager[i].setIncrementalDefragment( bIncremental );
+            mEntityMemoryManager[i].setIncrementalDefragment( bIncremental );
+            mForwardPlusMemoryManager[i].setIncrementalDefragment( bIncremental );
+        }
+
+        mLightMemoryManager.setIncrementalDefragment( bIncremental );
+        mTagPointNodeMemoryManager.setIncrementalDefragment( bIncremental );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::defragmentMemoryPoolsIncremental()
+    {
+        size_t budget = mDefragmentSlotsPerFrame;
+
+        // Dynamic pools first, they're the ones that fragment the most
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES && budget; ++i )
+        {
+            budget -= mNodeMemoryManager[i].defragmentIncremental( budget );
+
+            size_t numMoved = mEntityMemoryManager[i].defragmentIncremental( budget );
+            numMoved += mForwardPlusMemoryManager[i].defragmentIncremental( budget - numMoved );
+            budget -= numMoved;
+
+            // Moved objects keep their bounds, but the culling hierarchy needs a refit
+            if( i == SCENE_STATIC && numMoved )
+                mStaticEntitiesDirty = true;
+        }
+
+        if( budget )
+            budget -= mLightMemoryManager.defragmentIncremental( budget );
+        if( budget )
+            mTagPointNodeMemoryManager.defragmentIncremental( budget );
+    }
+    //-----------------------------------------------------------------------
     Item *SceneManager::createItem(
         const String &meshName,
         const String &groupName,       /*= ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME*/
@@ -1182,6 +1231,19 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void SceneManager::setBuildLegacyLightList( bool bEnable ) { mBuildLegacyLightList = bEnable; }
     //-----------------------------------------------------------------------
+    void SceneManager::setCullingHierarchyEnabled( bool bEnable )
+    {
+        mEntityMemoryManager[SCENE_DYNAMIC].setCullingHierarchyEnabled( bEnable );
+        mEntityMemoryManager[SCENE_STATIC].setCullingHierarchyEnabled( bEnable );
+        // Static objects must be refit at least once
+        mStaticEntitiesDirty = true;
+    }
+    //-----------------------------------------------------------------------
+    bool SceneManager::getCullingHierarchyEnabled() const
+    {
+        return mEntityMemoryManager[SCENE_DYNAMIC].getCullingHierarchyEnabled();
+    }
+    //-----------------------------------------------------------------------
     void SceneManager::_setPrePassMode( PrePassMode mode, const TextureGpuVec &prepassTextures,
                                         TextureGpu *prepassDepthTexture, TextureGpu *ssrTexture )
     {
@@ -1339,7 +1401,29 @@ namespace Ogre
                 CullFrustumRequest cullRequest(
                     realFirstRq, realLastRq, mIlluminationStage == IRS_RENDER_TO_TEXTURE, true, false,
                     &mEntitiesMemoryManagerCulledList, cullCamera, lodCamera );
-                fireCullFrustumThreads( cullRequest );
+
+                const BatchedShadowCull *batchedCull = 0;
+                if( mIlluminationStage == IRS_RENDER_TO_TEXTURE && mNumBatchedShadowCulls &&
+                    ( cullCamera->getLastViewport()->getVisibilityMask() &
+                      VisibilityFlags::LAYER_SHADOW_CASTER ) )
+                {
+                    batchedCull = findBatchedShadowCull( cullCamera, lodCamera );
+                }
+
+                if( batchedCull )
+                {
+                    // Already culled by _cullShadowCastersBatched. Just collect the results.
+                    mCurrentCullFrustumRequest = cullRequest;
+                    mCurrentBatchedShadowCull = batchedCull;
+                    mRequestType = GATHER_BATCHED_CULL;
+                    resetVisibleObjects( mVisibleObjects );
+                    fireWorkerThreadsAndWait( mNumWorkerThreads, 1u );
+                    mCurrentBatchedShadowCull = 0;
+                }
+                else
+                {
+                    fireCullFrustumThreads( cullRequest );
+                }
             }
         }  // end lock on scene graph mutex
         else
@@ -1604,6 +1688,10 @@ namespace Ogre
 
         mStaticMinDepthLevelDirty = std::min<uint16>( mStaticMinDepthLevelDirty, node->getDepthLevel() );
         node->_notifyStaticDirty();
+
+        ++mStaticTransformsVersion;
+        if( mStaticTransformsVersion == 0u )
+            mStaticTransformsVersion = 1u;
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllAnimationsThread( size_t threadIdx )
@@ -1622,9 +1710,11 @@ namespace Ogre
                     itByDef->skeletons.begin() + itByDef->threadStarts[threadIdx];
                 FastArray<SkeletonInstance *>::iterator endt =
                     itByDef->skeletons.begin() + itByDef->threadStarts[threadIdx + 1];
+                uint32 lodFrame =
+                    itByDef->animationLodFrame + static_cast<uint32>( itByDef->threadStarts[threadIdx] );
                 while( itor != endt )
                 {
-                    ( *itor )->update();
+                    ( *itor )->_updateWithLod( lodFrame++ );
                     ++itor;
                 }
 
@@ -1691,61 +1781,110 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void SceneManager::updateAllAnimations()
     {
+        OgreProfile( "updateAllAnimations" );
+
         mRequestType = UPDATE_ALL_ANIMATIONS;
         fireWorkerThreadsAndWait();
+
+        SkeletonAnimManagerVec::const_iterator it = mSkeletonAnimManagerCulledList.begin();
+        SkeletonAnimManagerVec::const_iterator en = mSkeletonAnimManagerCulledList.end();
+        while( it != en )
+        {
+            SkeletonAnimManager::BySkeletonDefList::iterator itByDef = ( *it )->bySkeletonDefs.begin();
+            SkeletonAnimManager::BySkeletonDefList::iterator enByDef = ( *it )->bySkeletonDefs.end();
+            while( itByDef != enByDef )
+            {
+                ++itByDef->animationLodFrame;
+                ++itByDef;
+            }
+            ++it;
+        }
     }
     //-----------------------------------------------------------------------
-    void SceneManager::updateAllTransformsThread( const UpdateTransformRequest &request,
-                                                  size_t threadIdx )
+    void SceneManager::updateAllTransformsThread( const UpdateTransformRequest &request, size_t begin,
+                                                  size_t end )
     {
         Transform t( request.t );
-        const size_t toAdvance =
-            std::min( threadIdx * request.numNodesPerThread, request.numTotalNodes );
+        t.advancePack( begin / ARRAY_PACKED_REALS );
+        Node::updateAllTransforms( end - begin, t );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::addTransformStageTasks( NodeMemoryManager *nodeMemoryManager, size_t firstDepth,
+                                               bool tagPoints, size_t &inOutTaskIdx )
+    {
+        TaskScheduler::TaskId parentTaskId = TaskScheduler::INVALID_TASK_ID;
+
+        const size_t numDepths = nodeMemoryManager->getNumDepths();
+        for( size_t i = firstDepth; i < numDepths; ++i )
+        {
+            Transform t;
+            const size_t numNodes = nodeMemoryManager->getFirstNode( t, i );
 
-        // Prevent going out of bounds (usually in the last threadIdx, or
-        // when there are less nodes than ARRAY_PACKED_REALS
-        const size_t numNodes = std::min( request.numNodesPerThread, request.numTotalNodes - toAdvance );
-        t.advancePack( toAdvance / ARRAY_PACKED_REALS );
+            if( numNodes )
+            {
+                // We need to go depth by depth because we may depend on parents which could
+                // be processed by different threads. Depths from other managers may overlap.
+                StageTask &stageTask = mTransformStageTasks[inOutTaskIdx++];
+                stageTask.sceneManager = this;
+                stageTask.granularity = ARRAY_PACKED_REALS;
+                stageTask.transformRequest = UpdateTransformRequest( t, numNodes );
+                if( !tagPoints )
+                    stageTask.requestType = UPDATE_ALL_TRANSFORMS;
+                else
+                {
+                    stageTask.requestType =
+                        i == 0 ? UPDATE_ALL_BONE_TO_TAG_TRANSFORMS : UPDATE_ALL_TAG_ON_TAG_TRANSFORMS;
+                }
 
-        Node::updateAllTransforms( numNodes, t );
+                parentTaskId = mTaskScheduler->addTask( &stageTask, numNodes, ARRAY_PACKED_REALS,
+                                                        &parentTaskId, 1u );
+            }
+        }
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllTransforms()
     {
-        mRequestType = UPDATE_ALL_TRANSFORMS;
+        OgreProfile( "updateAllTransforms" );
+
         NodeMemoryManagerVec::const_iterator it = mNodeMemoryManagerUpdateList.begin();
         NodeMemoryManagerVec::const_iterator en = mNodeMemoryManagerUpdateList.end();
 
+        // The StageTasks can't be reallocated once they've been submitted
+        size_t numStageTasks = 0;
+        while( it != en )
+        {
+            numStageTasks += ( *it )->getNumDepths();
+            ++it;
+        }
+        mTransformStageTasks.resize( numStageTasks );
+
+        size_t taskIdx = 0;
+        it = mNodeMemoryManagerUpdateList.begin();
         while( it != en )
         {
             NodeMemoryManager *nodeMemoryManager = *it;
-            const size_t numDepths = nodeMemoryManager->getNumDepths();
 
             size_t start = nodeMemoryManager->getMemoryManagerType() == SCENE_STATIC
                                ? mStaticMinDepthLevelDirty
                                : 0;
 
             // Start from the zeroth level (root) unless static (start from first dirty)
-            for( size_t i = start; i < numDepths; ++i )
-            {
-                Transform t;
-                const size_t numNodes = nodeMemoryManager->getFirstNode( t, i );
+            addTransformStageTasks( nodeMemoryManager, start, false, taskIdx );
 
-                // nodesPerThread must be multiple of ARRAY_PACKED_REALS
-                size_t nodesPerThread = ( numNodes + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                nodesPerThread = ( ( nodesPerThread + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) *
-                                 ARRAY_PACKED_REALS;
+            ++it;
+        }
 
-                if( numNodes )
-                {
-                    // Send them to worker threads. We need to go depth by depth because
-                    // we may depend on parents which could be processed by different threads.
-                    mUpdateTransformRequest = UpdateTransformRequest( t, nodesPerThread, numNodes );
-                    fireWorkerThreadsAndWait();
-                    // Node::updateAllTransforms( numNodes, t );
-                }
-            }
+        mTaskScheduler->waitForAll();
 
+        // Every changed node has been propagated to its children; start clean next frame.
+        // Tag points are never cleared as their bone parents change every frame.
+        it = mNodeMemoryManagerUpdateList.begin();
+        while( it != en )
+        {
+            NodeMemoryManager *nodeMemoryManager = *it;
+            nodeMemoryManager->_clearDirtyFlags(
+                nodeMemoryManager->getMemoryManagerType() == SCENE_STATIC ? mStaticMinDepthLevelDirty
+                                                                          : 0u );
             ++it;
         }
 
@@ -1762,74 +1901,78 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void SceneManager::updateAllTagPoints()
     {
+        OgreProfile( "updateAllTagPoints" );
+
         NodeMemoryManagerVec::const_iterator it = mTagPointNodeMemoryManagerUpdateList.begin();
         NodeMemoryManagerVec::const_iterator en = mTagPointNodeMemoryManagerUpdateList.end();
 
+        // The StageTasks can't be reallocated once they've been submitted
+        size_t numStageTasks = 0;
         while( it != en )
         {
-            NodeMemoryManager *nodeMemoryManager = *it;
-            const size_t numDepths = nodeMemoryManager->getNumDepths();
-
-            // Start from the first level (not root) unless static (start from first dirty)
-            for( size_t i = 0; i < numDepths; ++i )
-            {
-                mRequestType =
-                    i == 0 ? UPDATE_ALL_BONE_TO_TAG_TRANSFORMS : UPDATE_ALL_TAG_ON_TAG_TRANSFORMS;
-
-                Transform t;
-                const size_t numNodes = nodeMemoryManager->getFirstNode( t, i );
-
-                // nodesPerThread must be multiple of ARRAY_PACKED_REALS
-                size_t nodesPerThread = ( numNodes + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                nodesPerThread = ( ( nodesPerThread + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) *
-                                 ARRAY_PACKED_REALS;
-
-                if( numNodes )
-                {
-                    // Send them to worker threads. We need to go depth by depth because
-                    // we may depend on parents which could be processed by different threads.
-                    mUpdateTransformRequest = UpdateTransformRequest( t, nodesPerThread, numNodes );
-                    fireWorkerThreadsAndWait();
-                }
-            }
+            numStageTasks += ( *it )->getNumDepths();
+            ++it;
+        }
+        mTransformStageTasks.resize( numStageTasks );
 
+        size_t taskIdx = 0;
+        it = mTagPointNodeMemoryManagerUpdateList.begin();
+        while( it != en )
+        {
+            // The first level is bone to tag, the rest are tag on tag
+            addTransformStageTasks( *it, 0u, true, taskIdx );
             ++it;
         }
+
+        mTaskScheduler->waitForAll();
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllTransformsBoneToTagThread( const UpdateTransformRequest &request,
-                                                           size_t threadIdx )
+                                                           size_t begin, size_t end )
     {
         Transform t( request.t );
-        const size_t toAdvance =
-            std::min( threadIdx * request.numNodesPerThread, request.numTotalNodes );
-
-        // Prevent going out of bounds (usually in the last threadIdx, or
-        // when there are less nodes than ARRAY_PACKED_REALS
-        const size_t numNodes = std::min( request.numNodesPerThread, request.numTotalNodes - toAdvance );
-        t.advancePack( toAdvance / ARRAY_PACKED_REALS );
-
-        TagPoint::updateAllTransformsBoneToTag( numNodes, t );
+        t.advancePack( begin / ARRAY_PACKED_REALS );
+        TagPoint::updateAllTransformsBoneToTag( end - begin, t );
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllTransformsTagOnTagThread( const UpdateTransformRequest &request,
-                                                          size_t threadIdx )
+                                                          size_t begin, size_t end )
     {
         Transform t( request.t );
-        const size_t toAdvance =
-            std::min( threadIdx * request.numNodesPerThread, request.numTotalNodes );
+        t.advancePack( begin / ARRAY_PACKED_REALS );
+        TagPoint::updateAllTransformsTagOnTag( end - begin, t );
+    }
+    //-----------------------------------------------------------------------
+    /** Intersects the stage range [begin; end) with the render queue that starts at
+        inOutStageOffset in the stage layout (@see SceneManager::countStageItems), then
+        moves inOutStageOffset to the start of the next render queue.
+    @param outToAdvance
+        First object of the render queue inside the range. Multiple of granularity.
+    @return
+        Number of objects of the render queue inside the range.
+    */
+    static inline size_t getStageRange( size_t begin, size_t end, size_t granularity, size_t totalObjs,
+                                        size_t &inOutStageOffset, size_t &outToAdvance )
+    {
+        const size_t rqStart = inOutStageOffset;
+        inOutStageOffset += alignToNextMultiple( totalObjs, granularity );
+
+        const size_t firstObj = std::max( begin, rqStart );
+        const size_t lastObj = std::min( end, rqStart + totalObjs );
 
-        // Prevent going out of bounds (usually in the last threadIdx, or
-        // when there are less nodes than ARRAY_PACKED_REALS
-        const size_t numNodes = std::min( request.numNodesPerThread, request.numTotalNodes - toAdvance );
-        t.advancePack( toAdvance / ARRAY_PACKED_REALS );
+        outToAdvance = 0;
+        if( firstObj >= lastObj )
+            return 0;
 
-        TagPoint::updateAllTransformsTagOnTag( numNodes, t );
+        outToAdvance = firstObj - rqStart;
+        return lastObj - firstObj;
     }
     //-----------------------------------------------------------------------
-    void SceneManager::updateAllBoundsThread( const ObjectMemoryManagerVec &objectMemManager,
-                                              size_t threadIdx )
+    size_t SceneManager::countStageItems( const ObjectMemoryManagerVec &objectMemManager,
+                                          size_t firstRq, size_t lastRq, size_t granularity )
     {
+        size_t numItems = 0;
+
         ObjectMemoryManagerVec::const_iterator it = objectMemManager.begin();
         ObjectMemoryManagerVec::const_iterator en = objectMemManager.end();
 
@@ -1838,25 +1981,72 @@ namespace Ogre
             ObjectMemoryManager *memoryManager = *it;
             const size_t numRenderQueues = memoryManager->getNumRenderQueues();
 
-            for( size_t i = 0; i < numRenderQueues; ++i )
+            const size_t clampedFirstRq = std::min( firstRq, numRenderQueues );
+            const size_t clampedLastRq = std::min( lastRq, numRenderQueues );
+
+            for( size_t i = clampedFirstRq; i < clampedLastRq; ++i )
             {
                 ObjectData objData;
                 const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
+                numItems += alignToNextMultiple( totalObjs, granularity );
+            }
 
-                // Distribute the work evenly across all threads (not perfect), taking into
-                // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                numObjs =
-                    ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
+            ++it;
+        }
 
-                const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
+        return numItems;
+    }
+    //-----------------------------------------------------------------------
+    size_t SceneManager::getStageGranularity( const ObjectMemoryManagerVec &objectMemManager )
+    {
+        ObjectMemoryManagerVec::const_iterator it = objectMemManager.begin();
+        ObjectMemoryManagerVec::const_iterator en = objectMemManager.end();
 
-                // Prevent going out of bounds (usually in the last threadIdx, or
-                // when there are less entities than ARRAY_PACKED_REALS
-                numObjs = std::min( numObjs, totalObjs - toAdvance );
-                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+        while( it != en )
+        {
+            if( ( *it )->getCullingHierarchyEnabled() )
+                return ObjectMemoryManager::CullingClusterPackSize;
+            ++it;
+        }
+
+        return ARRAY_PACKED_REALS;
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::updateAllBoundsThread( const ObjectMemoryManagerVec &objectMemManager,
+                                              size_t begin, size_t end, size_t granularity )
+    {
+        size_t stageOffset = 0;
+
+        ObjectMemoryManagerVec::const_iterator it = objectMemManager.begin();
+        ObjectMemoryManagerVec::const_iterator en = objectMemManager.end();
 
-                MovableObject::updateAllBounds( numObjs, objData );
+        while( it != en && stageOffset < end )
+        {
+            ObjectMemoryManager *memoryManager = *it;
+            const size_t numRenderQueues = memoryManager->getNumRenderQueues();
+
+            // When refitting the culling hierarchy each thread must own whole cluster packs,
+            // so that the clusters it refits only contain objects whose bounds it updated.
+            // That's guaranteed by getStageGranularity.
+            const bool refitHierarchy = memoryManager->getCullingHierarchyEnabled();
+
+            for( size_t i = 0; i < numRenderQueues; ++i )
+            {
+                ObjectData objData;
+                const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
+
+                size_t toAdvance;
+                const size_t numObjs =
+                    getStageRange( begin, end, granularity, totalObjs, stageOffset, toAdvance );
+
+                if( numObjs )
+                {
+                    objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+                    MovableObject::updateAllBounds( numObjs, objData );
+
+                    if( refitHierarchy )
+                        memoryManager->_refitCullingHierarchy( i, toAdvance, numObjs );
+                }
             }
 
             ++it;
@@ -1865,20 +2055,37 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void SceneManager::updateAllBounds( const ObjectMemoryManagerVec &objectMemManager )
     {
+        OgreProfile( "updateAllBounds" );
+
+        ObjectMemoryManagerVec::const_iterator itor = objectMemManager.begin();
+        ObjectMemoryManagerVec::const_iterator endt = objectMemManager.end();
+
+        while( itor != endt )
+        {
+            ( *itor )->_prepareCullingHierarchy();
+            ++itor;
+        }
+
+        const size_t granularity = getStageGranularity( objectMemManager );
         mUpdateBoundsRequest = &objectMemManager;
         mRequestType = UPDATE_ALL_BOUNDS;
-        fireWorkerThreadsAndWait();
+        const size_t numItems = countStageItems( objectMemManager, 0u,
+                                                 std::numeric_limits<size_t>::max(), granularity );
+        fireWorkerThreadsAndWait( numItems, granularity );
     }
     //-----------------------------------------------------------------------
-    void SceneManager::updateAllLodsThread( const UpdateLodRequest &request, size_t threadIdx )
+    void SceneManager::updateAllLodsThread( const UpdateLodRequest &request, size_t begin, size_t end,
+                                            size_t granularity )
     {
         LodStrategy *lodStrategy = LodStrategyManager::getSingleton().getDefaultStrategy();
 
+        size_t stageOffset = 0;
+
         const Camera *lodCamera = request.lodCamera;
         ObjectMemoryManagerVec::const_iterator it = request.objectMemManager->begin();
         ObjectMemoryManagerVec::const_iterator en = request.objectMemManager->end();
 
-        while( it != en )
+        while( it != en && stageOffset < end )
         {
             ObjectMemoryManager *memoryManager = *it;
             const size_t numRenderQueues = memoryManager->getNumRenderQueues();
@@ -1891,20 +2098,15 @@ namespace Ogre
                 ObjectData objData;
                 const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
 
-                // Distribute the work evenly across all threads (not perfect), taking into
-                // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                numObjs =
-                    ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
-
-                const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
-
-                // Prevent going out of bounds (usually in the last threadIdx, or
-                // when there are less entities than ARRAY_PACKED_REALS
-                numObjs = std::min( numObjs, totalObjs - toAdvance );
-                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+                size_t toAdvance;
+                const size_t numObjs =
+                    getStageRange( begin, end, granularity, totalObjs, stageOffset, toAdvance );
 
-                lodStrategy->lodUpdateImpl( numObjs, objData, lodCamera, request.lodBias );
+                if( numObjs )
+                {
+                    objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+                    lodStrategy->lodUpdateImpl( numObjs, objData, lodCamera, request.lodBias );
+                }
             }
 
             ++it;
@@ -1921,23 +2123,18 @@ namespace Ogre
         mUpdateLodRequest.camera->getFrustumPlanes();
         mUpdateLodRequest.lodCamera->getFrustumPlanes();
 
-        fireWorkerThreadsAndWait();
+        fireWorkerThreadsAndWait( countStageItems( mEntitiesMemoryManagerCulledList, firstRq, lastRq,
+                                                   ARRAY_PACKED_REALS ),
+                                  ARRAY_PACKED_REALS );
     }
     //-----------------------------------------------------------------------
-    void SceneManager::cullFrustum( const CullFrustumRequest &request, size_t threadIdx )
+    void SceneManager::cullFrustum( const CullFrustumRequest &request, size_t begin, size_t end,
+                                    size_t granularity, size_t threadIdx )
     {
+        // Cleared by fireCullFrustumThreads, as a thread may process several ranges
         VisibleObjectsPerRq &visibleObjectsPerRq = *( mVisibleObjects.begin() + threadIdx );
-        {
-            visibleObjectsPerRq.resize( 255 );
-            VisibleObjectsPerRq::iterator itor = visibleObjectsPerRq.begin();
-            VisibleObjectsPerRq::iterator endt = visibleObjectsPerRq.end();
 
-            while( itor != endt )
-            {
-                itor->clear();
-                ++itor;
-            }
-        }
+        size_t stageOffset = 0;
 
         const Camera *camera = request.camera;
         const Camera *lodCamera = request.lodCamera;
@@ -1949,10 +2146,13 @@ namespace Ogre
                     ( camera->getLastViewport()->getVisibilityMask() &
                       ~VisibilityFlags::RESERVED_VISIBILITY_FLAGS ) );
 
+        // Decided by fireCullFrustumThreads
+        CullingHierarchyViewVec::const_iterator hierarchyViews = mCullingHierarchyViews.begin();
+
         ObjectMemoryManagerVec::const_iterator it = request.objectMemManager->begin();
         ObjectMemoryManagerVec::const_iterator en = request.objectMemManager->end();
 
-        while( it != en )
+        while( it != en && stageOffset < end )
         {
             ObjectMemoryManager *memoryManager = *it;
             const size_t numRenderQueues = memoryManager->getNumRenderQueues();
@@ -1968,21 +2168,33 @@ namespace Ogre
                 ObjectData objData;
                 const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
 
-                // Distribute the work evenly across all threads (not perfect), taking into
-                // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                numObjs =
-                    ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
+                size_t toAdvance;
+                const size_t numObjs =
+                    getStageRange( begin, end, granularity, totalObjs, stageOffset, toAdvance );
 
-                const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
+                if( !numObjs )
+                    continue;
 
-                // Prevent going out of bounds (usually in the last threadIdx, or
-                // when there are less entities than ARRAY_PACKED_REALS
-                numObjs = std::min( numObjs, totalObjs - toAdvance );
-                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+                const size_t numClusterPacks = hierarchyViews[i].numClusterPacks;
+                const ArrayAabb *clusterAabbs = hierarchyViews[i].clusterAabbs;
 
-                MovableObject::cullFrustum( numObjs, objData, camera, visibilityMask, outVisibleObjects,
-                                            lodCamera );
+                if( clusterAabbs )
+                {
+                    // getStageGranularity guarantees we own whole cluster packs
+                    const size_t packSize = ObjectMemoryManager::CullingClusterPackSize;
+                    const size_t firstPack = toAdvance / packSize;
+                    const size_t lastPack =
+                        std::min( ( toAdvance + numObjs + packSize - 1u ) / packSize, numClusterPacks );
+                    cullFrustumHierarchy( clusterAabbs, firstPack, lastPack, totalObjs, objData,
+                                          camera->_getCachedFrustumPlanes(), camera, visibilityMask,
+                                          outVisibleObjects, lodCamera );
+                }
+                else
+                {
+                    objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+                    MovableObject::cullFrustum( numObjs, objData, camera, visibilityMask,
+                                                outVisibleObjects, lodCamera );
+                }
 
                 const uint8 currRqId = static_cast<uint8>( i );
 
@@ -2015,10 +2227,417 @@ namespace Ogre
                 }
             }
 
+            hierarchyViews += static_cast<ptrdiff_t>( numRenderQueues );
             ++it;
         }
     }
     //-----------------------------------------------------------------------
+    void SceneManager::cullFrustumBatched( size_t begin, size_t end, size_t granularity,
+                                           size_t threadIdx )
+    {
+        const size_t numFrustums = mNumBatchedShadowCulls;
+
+        // Where each frustum stores its results for the current RQ
+        MovableObject::MovableObjectArray **outCulledObjects =
+            mFrameArena->allocate<MovableObject::MovableObjectArray *>( numFrustums );
+
+        size_t stageOffset = 0;
+
+        ObjectMemoryManagerVec::const_iterator it = mEntitiesMemoryManagerCulledList.begin();
+        ObjectMemoryManagerVec::const_iterator en = mEntitiesMemoryManagerCulledList.end();
+
+        while( it != en && stageOffset < end )
+        {
+            ObjectMemoryManager *memoryManager = *it;
+            const size_t numRenderQueues = memoryManager->getNumRenderQueues();
+
+            for( size_t i = 0; i < numRenderQueues; ++i )
+            {
+                ObjectData objData;
+                const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
+
+                size_t toAdvance;
+                const size_t numObjs =
+                    getStageRange( begin, end, granularity, totalObjs, stageOffset, toAdvance );
+
+                if( !numObjs )
+                    continue;
+
+                for( size_t j = 0; j < numFrustums; ++j )
+                    outCulledObjects[j] = &mBatchedShadowCulls[j].visibleObjects[threadIdx][i];
+
+                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+                MovableObject::cullFrustumBatched( numObjs, objData, &mBatchedShadowCullPlanes[0],
+                                                   numFrustums, outCulledObjects,
+                                                   mBatchedShadowCullLodCamera );
+            }
+
+            ++it;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::cullShadowFrustum( size_t batchedShadowCullIdx, size_t begin, size_t end,
+                                          size_t granularity, size_t threadIdx )
+    {
+        BatchedShadowCull &batchedCull = mBatchedShadowCulls[batchedShadowCullIdx];
+
+        size_t stageOffset = 0;
+
+        // Decided by _cullShadowCastersBatched
+        CullingHierarchyViewVec::const_iterator hierarchyViews = mCullingHierarchyViews.begin();
+
+        ObjectMemoryManagerVec::const_iterator it = mEntitiesMemoryManagerCulledList.begin();
+        ObjectMemoryManagerVec::const_iterator en = mEntitiesMemoryManagerCulledList.end();
+
+        while( it != en && stageOffset < end )
+        {
+            ObjectMemoryManager *memoryManager = *it;
+            const size_t numRenderQueues = memoryManager->getNumRenderQueues();
+
+            for( size_t i = 0; i < numRenderQueues; ++i )
+            {
+                MovableObject::MovableObjectArray &outCulledObjects =
+                    batchedCull.visibleObjects[threadIdx][i];
+
+                ObjectData objData;
+                const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
+
+                size_t toAdvance;
+                const size_t numObjs =
+                    getStageRange( begin, end, granularity, totalObjs, stageOffset, toAdvance );
+
+                if( !numObjs )
+                    continue;
+
+                const size_t numClusterPacks = hierarchyViews[i].numClusterPacks;
+                const ArrayAabb *clusterAabbs = hierarchyViews[i].clusterAabbs;
+
+                if( clusterAabbs )
+                {
+                    const size_t packSize = ObjectMemoryManager::CullingClusterPackSize;
+                    const size_t firstPack = toAdvance / packSize;
+                    const size_t lastPack =
+                        std::min( ( toAdvance + numObjs + packSize - 1u ) / packSize, numClusterPacks );
+                    cullFrustumHierarchy( clusterAabbs, firstPack, lastPack, totalObjs, objData,
+                                          batchedCull.planes, 0, 0u, outCulledObjects,
+                                          mBatchedShadowCullLodCamera );
+                }
+                else
+                {
+                    MovableObject::MovableObjectArray *outCulledObjectsPtr = &outCulledObjects;
+                    objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+                    MovableObject::cullFrustumBatched( numObjs, objData, batchedCull.planes, 1u,
+                                                       &outCulledObjectsPtr,
+                                                       mBatchedShadowCullLodCamera );
+                }
+            }
+
+            hierarchyViews += static_cast<ptrdiff_t>( numRenderQueues );
+            ++it;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::gatherBatchedCull( const CullFrustumRequest &request, size_t begin,
+                                          size_t end, size_t threadIdx )
+    {
+        VisibleObjectsPerRq &visibleObjectsPerRq = *( mVisibleObjects.begin() + threadIdx );
+
+        const Camera *camera = request.camera;
+
+        // Same as cullFrustum
+        const uint32 visibilityMask =
+            ( camera->getLastViewport()->getVisibilityMask() & this->getVisibilityMask() ) |
+            ( camera->getLastViewport()->getVisibilityMask() &
+              ~VisibilityFlags::RESERVED_VISIBILITY_FLAGS );
+
+        const size_t lastRq = std::min<size_t>( request.lastRq, 255u );
+
+        for( size_t i = request.firstRq; i < lastRq; ++i )
+        {
+            MovableObject::MovableObjectArray &outVisibleObjects = *( visibleObjectsPerRq.begin() + i );
+
+            const uint8 currRqId = static_cast<uint8>( i );
+            const bool addToRenderQueue =
+                mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::FAST &&
+                request.addToRenderQueue;
+
+            for( size_t srcThread = begin; srcThread < end; ++srcThread )
+            {
+                const MovableObject::MovableObjectArray &culledObjects =
+                    mCurrentBatchedShadowCull->visibleObjects[srcThread][i];
+
+                MovableObject::MovableObjectArray::const_iterator itor = culledObjects.begin();
+                MovableObject::MovableObjectArray::const_iterator endt = culledObjects.end();
+
+                while( itor != endt )
+                {
+                    MovableObject *movableObject = *itor;
+                    if( movableObject->getVisibilityFlags() & visibilityMask )
+                    {
+                        movableObject->_updateCachedDistanceToCamera( camera );
+
+                        if( addToRenderQueue )
+                        {
+                            RenderableArray::const_iterator itRend =
+                                movableObject->mRenderables.begin();
+                            RenderableArray::const_iterator enRend = movableObject->mRenderables.end();
+
+                            while( itRend != enRend )
+                            {
+                                if( ( *itRend )->mRenderableVisible )
+                                {
+                                    mRenderQueue->addRenderableV2( threadIdx, currRqId,
+                                                                   request.casterPass, *itRend,
+                                                                   movableObject );
+                                }
+                                ++itRend;
+                            }
+                        }
+                        else
+                        {
+                            outVisibleObjects.push_back( movableObject );
+                        }
+                    }
+                    ++itor;
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    const SceneManager::BatchedShadowCull *SceneManager::findBatchedShadowCull(
+        const Camera *camera, const Camera *lodCamera ) const
+    {
+        if( lodCamera != mBatchedShadowCullLodCamera )
+            return 0;
+
+        const Plane *frustumPlanes = camera->getFrustumPlanes();
+
+        BatchedShadowCullVec::const_iterator itor = mBatchedShadowCulls.begin();
+        BatchedShadowCullVec::const_iterator endt = mBatchedShadowCulls.begin() +
+                                                    static_cast<ptrdiff_t>( mNumBatchedShadowCulls );
+
+        while( itor != endt )
+        {
+            if( itor->camera == camera && std::equal( frustumPlanes, frustumPlanes + 6, itor->planes ) )
+                return &( *itor );
+            ++itor;
+        }
+
+        return 0;
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::_addBatchedShadowCullCamera( const Camera *camera )
+    {
+        if( !mShadowCullingBatched )
+            return;
+
+        if( mNumBatchedShadowCulls >= mBatchedShadowCulls.size() )
+            mBatchedShadowCulls.push_back( BatchedShadowCull() );
+
+        BatchedShadowCull &batchedCull = mBatchedShadowCulls[mNumBatchedShadowCulls++];
+        batchedCull.camera = camera;
+        const Plane *frustumPlanes = camera->getFrustumPlanes();
+        std::copy( frustumPlanes, frustumPlanes + 6, batchedCull.planes );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::_cullShadowCastersBatched( const Camera *lodCamera )
+    {
+        // Culling a single frustum this way has no advantage
+        if( mNumBatchedShadowCulls < 2u || !mFindVisibleObjects )
+        {
+            _clearBatchedShadowCull();
+            return;
+        }
+
+        OgreProfileGroup( "Batched Shadow Culling", OGREPROF_CULLING );
+
+        OGRE_LOCK_MUTEX( sceneGraphMutex );
+
+        // See fireCullFrustumThreads
+        lodCamera->getFrustumPlanes();
+        mBatchedShadowCullLodCamera = lodCamera;
+
+        for( size_t i = 0; i < mNumBatchedShadowCulls; ++i )
+            resetVisibleObjects( mBatchedShadowCulls[i].visibleObjects );
+
+        const size_t granularity = getStageGranularity( mEntitiesMemoryManagerCulledList );
+
+        if( granularity == ARRAY_PACKED_REALS )
+        {
+            mBatchedShadowCullPlanes.clear();
+            mBatchedShadowCullPlanes.reserve( mNumBatchedShadowCulls * 6u );
+            for( size_t i = 0; i < mNumBatchedShadowCulls; ++i )
+            {
+                const BatchedShadowCull &batchedCull = mBatchedShadowCulls[i];
+                mBatchedShadowCullPlanes.insert( mBatchedShadowCullPlanes.end(), batchedCull.planes,
+                                                 batchedCull.planes + 6 );
+            }
+
+            mRequestType = CULL_FRUSTUM_BATCHED;
+
+            const size_t numItems =
+                countStageItems( mEntitiesMemoryManagerCulledList, 0u, 255u, granularity );
+            fireWorkerThreadsAndWait( numItems, granularity );
+        }
+        else
+        {
+            // The culling hierarchy is enabled. Clusters can only be rejected one frustum at
+            // a time, so each frustum gets its own task. They don't depend on each other, thus
+            // the scheduler overlaps them and steals work from whichever is the most expensive.
+            mShadowCullStageTasks.resize( mNumBatchedShadowCulls );
+            latchCullingHierarchies( mEntitiesMemoryManagerCulledList );
+
+            const size_t numItems =
+                countStageItems( mEntitiesMemoryManagerCulledList, 0u, 255u, granularity );
+
+            for( size_t i = 0; i < mNumBatchedShadowCulls; ++i )
+            {
+                StageTask &stageTask = mShadowCullStageTasks[i];
+                stageTask.sceneManager = this;
+                stageTask.requestType = CULL_SHADOW_FRUSTUM;
+                stageTask.granularity = granularity;
+                stageTask.batchedShadowCullIdx = i;
+                mTaskScheduler->addTask( &stageTask, numItems, granularity );
+            }
+
+            mTaskScheduler->waitForAll();
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::_clearBatchedShadowCull()
+    {
+        mNumBatchedShadowCulls = 0;
+        mBatchedShadowCullLodCamera = 0;
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::latchCullingHierarchies( const ObjectMemoryManagerVec &objectMemManager )
+    {
+        mCullingHierarchyViews.clear();
+
+        ObjectMemoryManagerVec::const_iterator itor = objectMemManager.begin();
+        ObjectMemoryManagerVec::const_iterator endt = objectMemManager.end();
+
+        while( itor != endt )
+        {
+            const size_t numRenderQueues = ( *itor )->getNumRenderQueues();
+            for( size_t i = 0; i < numRenderQueues; ++i )
+            {
+                CullingHierarchyView view;
+                view.clusterAabbs = ( *itor )->_getCullingHierarchy( i, view.numClusterPacks );
+                mCullingHierarchyViews.push_back( view );
+            }
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------
+    /// Culls the objects of the clusters that passed the test in cullFrustumHierarchy
+    static void cullClusterRun( size_t numObjs, const ObjectData &objData, const Plane *frustumPlanes,
+                                const Camera *camera, uint32 visibilityMask,
+                                MovableObject::MovableObjectArray &outVisible,
+                                const Camera *lodCamera )
+    {
+        if( camera )
+        {
+            MovableObject::cullFrustum( numObjs, objData, camera, visibilityMask, outVisible,
+                                        lodCamera );
+        }
+        else
+        {
+            MovableObject::MovableObjectArray *outVisiblePtr = &outVisible;
+            MovableObject::cullFrustumBatched( numObjs, objData, frustumPlanes, 1u, &outVisiblePtr,
+                                               lodCamera );
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::cullFrustumHierarchy( const ArrayAabb *clusterAabbs, size_t firstPack,
+                                             size_t lastPack, size_t totalObjs, ObjectData objData,
+                                             const Plane *frustumPlanes, const Camera *camera,
+                                             uint32 visibilityMask,
+                                             MovableObject::MovableObjectArray &outVisible,
+                                             const Camera *lodCamera )
+    {
+        // Same plane test as MovableObject::cullFrustum, but against
+        // ARRAY_PACKED_REALS clusters at a time instead of objects.
+        struct ArrayPlane
+        {
+            ArrayVector3 planeNormal;
+            ArrayVector3 signFlip;
+            ArrayReal planeNegD;
+        };
+
+        ArrayPlane planes[6];
+
+        for( size_t i = 0; i < 6; ++i )
+        {
+            planes[i].planeNormal.setAll( frustumPlanes[i].normal );
+            planes[i].signFlip.setAll( frustumPlanes[i].normal );
+            planes[i].signFlip.setToSign();
+            planes[i].planeNegD = Mathlib::SetAll( -frustumPlanes[i].d );
+        }
+
+        // Consecutive visible clusters are merged into a single run of objects
+        size_t runStart = 0;
+        size_t runEnd = 0;
+
+        for( size_t i = firstPack; i < lastPack; ++i )
+        {
+            const ArrayAabb &clusters = clusterAabbs[i];
+
+            ArrayMaskR mask = BooleanMask4::getAllSetMask();
+            for( size_t j = 0; j < 6; ++j )
+            {
+                ArrayVector3 centerPlusFlippedHS =
+                    clusters.mCenter + clusters.mHalfSize * planes[j].signFlip;
+                ArrayReal dotResult = planes[j].planeNormal.dotProduct( centerPlusFlippedHS );
+                mask = Mathlib::And( mask, Mathlib::CompareGreater( dotResult, planes[j].planeNegD ) );
+            }
+
+            // Always pass the test if any of the components were
+            // Infinity (dot product above could've caused nans)
+            ArrayMaskR tmpMask =
+                Mathlib::Or( Mathlib::isInfinity( clusters.mHalfSize.mChunkBase[0] ),
+                             Mathlib::isInfinity( clusters.mHalfSize.mChunkBase[1] ) );
+            tmpMask = Mathlib::Or( Mathlib::isInfinity( clusters.mHalfSize.mChunkBase[2] ), tmpMask );
+            mask = Mathlib::Or( mask, tmpMask );
+
+            const uint32 scalarMask = BooleanMask4::getScalarMask( mask );
+
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+            {
+                if( IS_BIT_SET( j, scalarMask ) )
+                {
+                    const size_t clusterStart = i * ObjectMemoryManager::CullingClusterPackSize +
+                                                j * ObjectMemoryManager::CullingClusterSize;
+                    const size_t clusterEnd = std::min(
+                        clusterStart + ObjectMemoryManager::CullingClusterSize, totalObjs );
+
+                    if( clusterStart < clusterEnd )
+                    {
+                        if( clusterStart != runEnd )
+                        {
+                            if( runStart != runEnd )
+                            {
+                                ObjectData runObjData( objData );
+                                runObjData.advancePack( runStart / ARRAY_PACKED_REALS );
+                                cullClusterRun( runEnd - runStart, runObjData, frustumPlanes, camera,
+                                                visibilityMask, outVisible, lodCamera );
+                            }
+                            runStart = clusterStart;
+                        }
+                        runEnd = clusterEnd;
+                    }
+                }
+            }
+        }
+
+        if( runStart != runEnd )
+        {
+            objData.advancePack( runStart / ARRAY_PACKED_REALS );
+            cullClusterRun( runEnd - runStart, objData, frustumPlanes, camera, visibilityMask,
+                            outVisible, lodCamera );
+        }
+    }
+    //-----------------------------------------------------------------------
     inline bool OrderLightByShadowCastThenId( const Light *_l, const Light *_r )
     {
         if( _l->getCastShadows() && !_r->getCastShadows() )
@@ -2069,6 +2688,8 @@ namespace Ogre
 
     void SceneManager::buildLightList()
     {
+        OgreProfile( "buildLightList" );
+
         mGlobalLightList.lights.clear();
 
         {
@@ -2197,13 +2818,7 @@ namespace Ogre
             }
         }
 
-        if( mForceMainThread )
-            updateWorkerThreadImpl( 0 );
-        else
-        {
-            mWorkerThreadsBarrier->sync();  // Fire threads
-            mWorkerThreadsBarrier->sync();  // Wait them to complete
-        }
+        fireWorkerThreadsAndWait();
 
         // Now merge the results into a single list.
 
@@ -2235,13 +2850,10 @@ namespace Ogre
         {
             // Now fire the threads again, to build the per-MovableObject lists
             mRequestType = BUILD_LIGHT_LIST02;
-            if( mForceMainThread )
-                updateWorkerThreadImpl( 0 );
-            else
-            {
-                mWorkerThreadsBarrier->sync();  // Fire threads
-                mWorkerThreadsBarrier->sync();  // Wait them to complete
-            }
+            fireWorkerThreadsAndWait(
+                countStageItems( mEntitiesMemoryManagerCulledList, 0u,
+                                 std::numeric_limits<size_t>::max(), ARRAY_PACKED_REALS ),
+                ARRAY_PACKED_REALS );
         }
     }
     //-----------------------------------------------------------------------
@@ -2298,12 +2910,14 @@ namespace Ogre
         threadLocalLightList.boundingSphere = 0;
     }
     //-----------------------------------------------------------------------
-    void SceneManager::buildLightListThread02( size_t threadIdx )
+    void SceneManager::buildLightListThread02( size_t begin, size_t end, size_t granularity )
     {
+        size_t stageOffset = 0;
+
         // Global light list built. Now build a per-movable object light list
         ObjectMemoryManagerVec::const_iterator it = mEntitiesMemoryManagerCulledList.begin();
         ObjectMemoryManagerVec::const_iterator en = mEntitiesMemoryManagerCulledList.end();
-        while( it != en )
+        while( it != en && stageOffset < end )
         {
             ObjectMemoryManager *objMemoryManager = *it;
             const size_t numRenderQueues = objMemoryManager->getNumRenderQueues();
@@ -2313,20 +2927,15 @@ namespace Ogre
                 ObjectData objData;
                 const size_t totalObjs = objMemoryManager->getFirstObjectData( objData, i );
 
-                // Distribute the work evenly across all threads (not perfect), taking into
-                // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                numObjs =
-                    ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
-
-                const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
-
-                // Prevent going out of bounds (usually in the last threadIdx, or
-                // when there are less entities than ARRAY_PACKED_REALS
-                numObjs = std::min( numObjs, totalObjs - toAdvance );
-                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+                size_t toAdvance;
+                const size_t numObjs =
+                    getStageRange( begin, end, granularity, totalObjs, stageOffset, toAdvance );
 
-                MovableObject::buildLightList( numObjs, objData, mGlobalLightList );
+                if( numObjs )
+                {
+                    objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+                    MovableObject::buildLightList( numObjs, objData, mGlobalLightList );
+                }
             }
 
             ++it;
@@ -2390,6 +2999,9 @@ namespace Ogre
         // Update controllers
         ControllerManager::getSingleton().updateAllControllers();
 
+        if( mDefragmentSlotsPerFrame )
+            defragmentMemoryPoolsIncremental();
+
         highLevelCull();
         _applySceneAnimations();
         updateAllTransforms();
@@ -2431,7 +3043,8 @@ namespace Ogre
             {
                 ( *itor )->_updateTracking();
                 ( *itor )->getParentNode()->_getFullTransformUpdated();
-                ( *itor )->getWorldAabbUpdated();
+                // Don't throw away the culling hierarchy every frame because of a debug aabb
+                ( *itor )->_getWorldAabbUpdatedGrowHierarchy();
                 ++itor;
             }
         }
@@ -4507,15 +5120,21 @@ namespace Ogre
     }
     void SceneManager::fireWorkerThreadsAndWait()
     {
-        if( mForceMainThread )
-            updateWorkerThreadImpl( 0 );
-        else
-        {
-            mWorkerThreadsBarrier->sync();  // Fire threads
-            mWorkerThreadsBarrier->sync();  // Wait them to complete
-        }
+        mStageTask.sceneManager = this;
+        mStageTask.requestType = mRequestType;
+        mStageTask.granularity = 1u;
+        mTaskScheduler->addTask( &mStageTask, mNumWorkerThreads, 1u );
+        mTaskScheduler->waitForAll();
     }
     //---------------------------------------------------------------------
+    void SceneManager::fireWorkerThreadsAndWait( size_t numItems, size_t granularity )
+    {
+        mStageTask.sceneManager = this;
+        mStageTask.requestType = mRequestType;
+        mStageTask.granularity = granularity;
+        mTaskScheduler->addTask( &mStageTask, numItems, granularity );
+        mTaskScheduler->waitForAll();
+    }
     //---------------------------------------------------------------------
     void SceneManager::fireCullFrustumThreads( const CullFrustumRequest &request )
     {
@@ -4526,126 +5145,135 @@ namespace Ogre
         // in case they weren't up to date.
         mCurrentCullFrustumRequest.camera->getFrustumPlanes();
         mCurrentCullFrustumRequest.lodCamera->getFrustumPlanes();
-        fireWorkerThreadsAndWait();
+
+        // A thread may execute several ranges, so the lists can't be cleared by cullFrustum
+        resetVisibleObjects( mVisibleObjects );
+
+        latchCullingHierarchies( *request.objectMemManager );
+
+        const size_t granularity = getStageGranularity( *request.objectMemManager );
+        const size_t numItems =
+            countStageItems( *request.objectMemManager, request.firstRq, request.lastRq, granularity );
+        fireWorkerThreadsAndWait( numItems, granularity );
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::resetVisibleObjects( VisibleObjectsPerThreadArray &visibleObjects )
+    {
+        visibleObjects.resize( mNumWorkerThreads );
+
+        VisibleObjectsPerThreadArray::iterator itor = visibleObjects.begin();
+        VisibleObjectsPerThreadArray::iterator endt = visibleObjects.end();
+        while( itor != endt )
+        {
+            itor->resize( 255 );
+            VisibleObjectsPerRq::iterator itRq = itor->begin();
+            VisibleObjectsPerRq::iterator enRq = itor->end();
+            while( itRq != enRq )
+            {
+                itRq->clear();
+                ++itRq;
+            }
+            ++itor;
+        }
     }
     //---------------------------------------------------------------------
     void SceneManager::executeUserScalableTask( UniformScalableTask *task, bool bBlock )
     {
-        mRequestType = USER_UNIFORM_SCALABLE_TASK;
+        assert( mUserTaskId == TaskScheduler::INVALID_TASK_ID &&
+                "waitForPendingUserScalableTask wasn't called for the previous task!" );
+
         mUserTask = task;
 
-        if( mForceMainThread )
-            updateWorkerThreadImpl( 0 );
+        mUserStageTask.sceneManager = this;
+        mUserStageTask.requestType = USER_UNIFORM_SCALABLE_TASK;
+        mUserStageTask.granularity = 1u;
+        const TaskScheduler::TaskId taskId =
+            mTaskScheduler->addTask( &mUserStageTask, mNumWorkerThreads, 1u );
+
+        if( bBlock )
+            mTaskScheduler->waitFor( taskId );
         else
-        {
-            mWorkerThreadsBarrier->sync();  // Fire threads
-            if( bBlock )
-                mWorkerThreadsBarrier->sync();  // Wait them to complete
-        }
+            mUserTaskId = taskId;
     }
     //---------------------------------------------------------------------
     void SceneManager::waitForPendingUserScalableTask()
     {
-        if( !mForceMainThread )
+        if( mUserTaskId != TaskScheduler::INVALID_TASK_ID )
         {
-            assert( mRequestType == USER_UNIFORM_SCALABLE_TASK );
-            mWorkerThreadsBarrier->sync();  // Wait them to complete
+            mTaskScheduler->waitFor( mUserTaskId );
+            mUserTaskId = TaskScheduler::INVALID_TASK_ID;
         }
     }
     //---------------------------------------------------------------------
-    unsigned long updateWorkerThread( ThreadHandle *threadHandle )
-    {
-        SceneManager *sceneManager = reinterpret_cast<SceneManager *>( threadHandle->getUserParam() );
-        return sceneManager->_updateWorkerThread( threadHandle );
-    }
-    THREAD_DECLARE( updateWorkerThread );
-    //---------------------------------------------------------------------
     void SceneManager::startWorkerThreads()
     {
-        if( !mForceMainThread )
-        {
-            mWorkerThreadsBarrier = new Barrier( mNumWorkerThreads + 1 );
-            mWorkerThreads.reserve( mNumWorkerThreads );
-            for( size_t i = 0; i < mNumWorkerThreads; ++i )
-            {
-                ThreadHandlePtr th = Threads::CreateThread( THREAD_GET( updateWorkerThread ), i, this );
-                mWorkerThreads.push_back( th );
-            }
-        }
+        // The thread calling renderOneFrame always acts as worker thread 0
+        mTaskScheduler = new TaskScheduler( mNumWorkerThreads );
     }
     //---------------------------------------------------------------------
     void SceneManager::stopWorkerThreads()
     {
-        if( !mForceMainThread )
-        {
-            mRequestType = STOP_THREADS;
-            fireWorkerThreadsAndWait();
-
-            Threads::WaitForThreads( mWorkerThreads );
-
-            delete mWorkerThreadsBarrier;
-            mWorkerThreadsBarrier = 0;
-        }
+        delete mTaskScheduler;
+        mTaskScheduler = 0;
     }
     //---------------------------------------------------------------------
-    unsigned long SceneManager::_updateWorkerThread( ThreadHandle *threadHandle )
+    void SceneManager::StageTask::execute( size_t begin, size_t end, size_t threadIdx )
     {
-        bool exitThread = false;
-        size_t threadIdx = threadHandle->getThreadIdx();
-        while( !exitThread )
-        {
-            mWorkerThreadsBarrier->sync();
-            exitThread = updateWorkerThreadImpl( threadIdx );
-            mWorkerThreadsBarrier->sync();
-        }
-
-        return 0;
+        sceneManager->executeStageRange( *this, begin, end, threadIdx );
     }
     //---------------------------------------------------------------------
-    inline bool SceneManager::updateWorkerThreadImpl( size_t threadIdx )
+    void SceneManager::executeStageRange( const StageTask &stageTask, size_t begin, size_t end,
+                                          size_t threadIdx )
     {
-        bool exitThread = false;
-
-        switch( mRequestType )
+        switch( stageTask.requestType )
         {
         case CULL_FRUSTUM:
-            cullFrustum( mCurrentCullFrustumRequest, threadIdx );
+            cullFrustum( mCurrentCullFrustumRequest, begin, end, stageTask.granularity, threadIdx );
+            break;
+        case CULL_FRUSTUM_BATCHED:
+            cullFrustumBatched( begin, end, stageTask.granularity, threadIdx );
+            break;
+        case CULL_SHADOW_FRUSTUM:
+            cullShadowFrustum( stageTask.batchedShadowCullIdx, begin, end, stageTask.granularity,
+                               threadIdx );
+            break;
+        case GATHER_BATCHED_CULL:
+            gatherBatchedCull( mCurrentCullFrustumRequest, begin, end, threadIdx );
             break;
         case UPDATE_ALL_ANIMATIONS:
-            updateAllAnimationsThread( threadIdx );
+            for( size_t i = begin; i < end; ++i )
+                updateAllAnimationsThread( i );
             break;
         case UPDATE_ALL_TRANSFORMS:
-            updateAllTransformsThread( mUpdateTransformRequest, threadIdx );
+            updateAllTransformsThread( stageTask.transformRequest, begin, end );
             break;
         case UPDATE_ALL_BONE_TO_TAG_TRANSFORMS:
-            updateAllTransformsBoneToTagThread( mUpdateTransformRequest, threadIdx );
+            updateAllTransformsBoneToTagThread( stageTask.transformRequest, begin, end );
             break;
         case UPDATE_ALL_TAG_ON_TAG_TRANSFORMS:
-            updateAllTransformsTagOnTagThread( mUpdateTransformRequest, threadIdx );
+            updateAllTransformsTagOnTagThread( stageTask.transformRequest, begin, end );
             break;
         case UPDATE_ALL_BOUNDS:
-            updateAllBoundsThread( *mUpdateBoundsRequest, threadIdx );
+            updateAllBoundsThread( *mUpdateBoundsRequest, begin, end, stageTask.granularity );
             break;
         case UPDATE_ALL_LODS:
-            updateAllLodsThread( mUpdateLodRequest, threadIdx );
+            updateAllLodsThread( mUpdateLodRequest, begin, end, stageTask.granularity );
             break;
         case BUILD_LIGHT_LIST01:
-            buildLightListThread01( mBuildLightListRequestPerThread[threadIdx], threadIdx );
+            // Slices write to mGlobalLightListPerThread[i], not to the executing thread
+            for( size_t i = begin; i < end; ++i )
+                buildLightListThread01( mBuildLightListRequestPerThread[i], i );
             break;
         case BUILD_LIGHT_LIST02:
-            buildLightListThread02( threadIdx );
+            buildLightListThread02( begin, end, stageTask.granularity );
             break;
         case USER_UNIFORM_SCALABLE_TASK:
-            mUserTask->execute( threadIdx, mNumWorkerThreads );
-            break;
-        case STOP_THREADS:
-            exitThread = true;
+            for( size_t i = begin; i < end; ++i )
+                mUserTask->execute( i, mNumWorkerThreads );
             break;
         default:
             break;
         }
-
-        return exitThread;
     }
     SceneManagerFactory::~SceneManagerFactory() {}
 }  // namespace Ogre
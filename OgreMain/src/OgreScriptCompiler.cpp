@@ -37,6 +37,14 @@ THE SOFTWARE.
 #include "OgreString.h"
 #include "OgreStringConverter.h"
 
+#include "Hash/MurmurHash3.h"
+
+#if OGRE_ARCH_TYPE == OGRE_ARCHITECTURE_32
+#    define OGRE_HASH128_FUNC MurmurHash3_x86_128
+#else
+#    define OGRE_HASH128_FUNC MurmurHash3_x64_128
+#endif
+
 namespace Ogre
 {
     // AbstractNode
@@ -1701,7 +1709,9 @@ namespace Ogre
     //-----------------------------------------------------------------------
     ScriptCompilerManager::ScriptCompilerManager() :
         mListener( 0 ),
-        OGRE_THREAD_POINTER_INIT( mScriptCompiler )
+        OGRE_THREAD_POINTER_INIT( mScriptCompiler ),
+        mSaveScriptsToCache( false ),
+        mScriptCacheDirty( false )
     {
         OGRE_LOCK_AUTO_MUTEX;
         mScriptPatterns.push_back( "*.program" );
@@ -1790,7 +1800,7 @@ namespace Ogre
         return 90.0f;
     }
     //-----------------------------------------------------------------------
-    void ScriptCompilerManager::parseScript( DataStreamPtr &stream, const String &groupName )
+    ScriptCompiler *ScriptCompilerManager::getThreadCompiler()
     {
 #if OGRE_THREAD_SUPPORT
         // check we have an instance for this thread (should always have one for main thread)
@@ -1806,8 +1816,245 @@ namespace Ogre
             OGRE_LOCK_AUTO_MUTEX;
             OGRE_THREAD_POINTER_GET( mScriptCompiler )->setListener( mListener );
         }
-        OGRE_THREAD_POINTER_GET( mScriptCompiler )
-            ->compile( stream->getAsString(), stream->getName(), groupName );
+        return OGRE_THREAD_POINTER_GET( mScriptCompiler );
+    }
+    //-------------------------------------------------------------------------
+    void ScriptCompilerManager::parseScript( DataStreamPtr &stream, const String &groupName )
+    {
+        ScriptCompiler *compiler = getThreadCompiler();
+        const String str = stream->getAsString();
+        ConcreteNodeListPtr nodes = parseWithCache( str, stream->getName() );
+        compiler->compile( nodes, groupName );
+    }
+    //-------------------------------------------------------------------------
+    bool ScriptCompilerManager::supportsPreparedScripts() const { return true; }
+    //-------------------------------------------------------------------------
+    Any ScriptCompilerManager::prepareScript( DataStreamPtr &stream )
+    {
+        const String str = stream->getAsString();
+        return Any( parseWithCache( str, stream->getName() ) );
+    }
+    //-------------------------------------------------------------------------
+    void ScriptCompilerManager::parsePreparedScript( const Any &preparedScript, DataStreamPtr &stream,
+                                                     const String &groupName )
+    {
+        ConcreteNodeListPtr nodes = any_cast<ConcreteNodeListPtr>( preparedScript );
+        getThreadCompiler()->compile( nodes, groupName );
+    }
+    //-------------------------------------------------------------------------
+    // Script cache serialization. Format of each node:
+    //  uint8 type, uint32 line, uint32 token length, token, uint32 num children, children...
+    // All nodes share the same file, which is not stored.
+    static void writeCacheValue( vector<uint8>::type &outData, const void *value, size_t bytes )
+    {
+        const uint8 *src = reinterpret_cast<const uint8 *>( value );
+        outData.insert( outData.end(), src, src + bytes );
+    }
+    //-------------------------------------------------------------------------
+    static void writeConcreteNodes( const ConcreteNodeList &nodes, vector<uint8>::type &outData )
+    {
+        const uint32 numNodes = static_cast<uint32>( nodes.size() );
+        writeCacheValue( outData, &numNodes, sizeof( numNodes ) );
+
+        ConcreteNodeList::const_iterator itor = nodes.begin();
+        ConcreteNodeList::const_iterator endt = nodes.end();
+
+        while( itor != endt )
+        {
+            const ConcreteNode *node = itor->get();
+            const uint8 type = static_cast<uint8>( node->type );
+            const uint32 line = static_cast<uint32>( node->line );
+            const uint32 tokenLength = static_cast<uint32>( node->token.size() );
+            writeCacheValue( outData, &type, sizeof( type ) );
+            writeCacheValue( outData, &line, sizeof( line ) );
+            writeCacheValue( outData, &tokenLength, sizeof( tokenLength ) );
+            writeCacheValue( outData, node->token.c_str(), tokenLength );
+            writeConcreteNodes( node->children, outData );
+            ++itor;
+        }
+    }
+    //-------------------------------------------------------------------------
+    static bool readCacheValue( const uint8 *&data, const uint8 *dataEnd, void *outValue,
+                                size_t bytes )
+    {
+        if( static_cast<size_t>( dataEnd - data ) < bytes )
+            return false;
+        memcpy( outValue, data, bytes );
+        data += bytes;
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    /// Returns false if the data is corrupt
+    static bool readConcreteNodes( const uint8 *&data, const uint8 *dataEnd, const String &file,
+                                   ConcreteNode *parent, ConcreteNodeList &outNodes )
+    {
+        uint32 numNodes = 0;
+        if( !readCacheValue( data, dataEnd, &numNodes, sizeof( numNodes ) ) )
+            return false;
+
+        for( uint32 i = 0; i < numNodes; ++i )
+        {
+            uint8 type = 0;
+            uint32 line = 0;
+            uint32 tokenLength = 0;
+            if( !readCacheValue( data, dataEnd, &type, sizeof( type ) ) ||
+                !readCacheValue( data, dataEnd, &line, sizeof( line ) ) ||
+                !readCacheValue( data, dataEnd, &tokenLength, sizeof( tokenLength ) ) ||
+                type > CNT_COLON || static_cast<size_t>( dataEnd - data ) < tokenLength )
+            {
+                return false;
+            }
+
+            ConcreteNodePtr node( OGRE_NEW ConcreteNode() );
+            node->token.assign( reinterpret_cast<const char *>( data ), tokenLength );
+            node->file = file;
+            node->line = line;
+            node->type = static_cast<ConcreteNodeType>( type );
+            node->parent = parent;
+            data += tokenLength;
+
+            if( !readConcreteNodes( data, dataEnd, file, node.get(), node->children ) )
+                return false;
+
+            outNodes.push_back( node );
+        }
+
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    ConcreteNodeListPtr ScriptCompilerManager::parseWithCache( const String &str,
+                                                               const String &source )
+    {
+        uint64 hash[2];
+        OGRE_HASH128_FUNC( str.c_str(), static_cast<int>( str.size() ), OGRE_VERSION, hash );
+
+        // MEMCATEGORY_GENERAL because SharedPtr can only free using that category
+        ConcreteNodeListPtr nodes( OGRE_NEW_T( ConcreteNodeList, MEMCATEGORY_GENERAL )(),
+                                   SPFM_DELETE_T );
+
+        {
+            ScopedLock lock( mScriptCacheMutex );
+            ScriptCacheMap::const_iterator itor = mScriptCache.find( source );
+            if( itor != mScriptCache.end() && itor->second.hash[0] == hash[0] &&
+                itor->second.hash[1] == hash[1] )
+            {
+                const uint8 *data = itor->second.data.data();
+                const uint8 *dataEnd = data + itor->second.data.size();
+                if( readConcreteNodes( data, dataEnd, source, 0, *nodes ) && data == dataEnd )
+                    return nodes;
+
+                LogManager::getSingleton().logMessage(
+                    "Script cache entry for " + source + " is corrupt. Parsing it again." );
+                nodes->clear();
+            }
+        }
+
+        ScriptLexer lexer;
+        ScriptParser parser;
+        nodes = parser.parse( lexer.tokenize( str ), source );
+
+        if( mSaveScriptsToCache )
+        {
+            vector<uint8>::type data;
+            writeConcreteNodes( *nodes, data );
+
+            ScopedLock lock( mScriptCacheMutex );
+            CachedScript &cachedScript = mScriptCache[source];
+            cachedScript.hash[0] = hash[0];
+            cachedScript.hash[1] = hash[1];
+            cachedScript.data.swap( data );
+            mScriptCacheDirty = true;
+        }
+
+        return nodes;
+    }
+    //-------------------------------------------------------------------------
+    static const uint32 c_scriptCacheMagic = 0x4F534343;  // 'OSCC'
+    static const uint32 c_scriptCacheFormatVersion = 1u;
+    //-------------------------------------------------------------------------
+    void ScriptCompilerManager::saveScriptCache( DataStreamPtr stream ) const
+    {
+        if( !mScriptCacheDirty )
+            return;
+
+        if( !stream->isWriteable() )
+        {
+            OGRE_EXCEPT( Exception::ERR_CANNOT_WRITE_TO_FILE,
+                         "Unable to write to stream " + stream->getName(),
+                         "ScriptCompilerManager::saveScriptCache" );
+        }
+
+        ScopedLock lock( mScriptCacheMutex );
+
+        const uint32 header[4] = { c_scriptCacheMagic, c_scriptCacheFormatVersion, OGRE_VERSION,
+                                   static_cast<uint32>( mScriptCache.size() ) };
+        stream->write( header, sizeof( header ) );
+
+        ScriptCacheMap::const_iterator itor = mScriptCache.begin();
+        ScriptCacheMap::const_iterator endt = mScriptCache.end();
+
+        while( itor != endt )
+        {
+            const uint32 nameLength = static_cast<uint32>( itor->first.size() );
+            stream->write( &nameLength, sizeof( nameLength ) );
+            stream->write( itor->first.c_str(), nameLength );
+            stream->write( itor->second.hash, sizeof( itor->second.hash ) );
+
+            const uint32 dataLength = static_cast<uint32>( itor->second.data.size() );
+            stream->write( &dataLength, sizeof( dataLength ) );
+            stream->write( itor->second.data.data(), dataLength );
+            ++itor;
+        }
+    }
+    //-------------------------------------------------------------------------
+    void ScriptCompilerManager::loadScriptCache( DataStreamPtr stream )
+    {
+        ScopedLock lock( mScriptCacheMutex );
+
+        mScriptCache.clear();
+        mScriptCacheDirty = false;
+
+        uint32 header[4] = { 0, 0, 0, 0 };
+        stream->read( header, sizeof( header ) );
+
+        if( header[0] != c_scriptCacheMagic || header[1] != c_scriptCacheFormatVersion ||
+            header[2] != OGRE_VERSION )
+        {
+            LogManager::getSingleton().logMessage(
+                "Script cache " + stream->getName() +
+                " is invalid or from a different version of Ogre. Ignoring it." );
+            return;
+        }
+
+        const uint32 numScripts = header[3];
+        for( uint32 i = 0; i < numScripts && !stream->eof(); ++i )
+        {
+            uint32 nameLength = 0;
+            stream->read( &nameLength, sizeof( nameLength ) );
+            String name( nameLength, '\0' );
+            if( nameLength )
+                stream->read( &name[0], nameLength );
+
+            CachedScript &cachedScript = mScriptCache[name];
+            stream->read( cachedScript.hash, sizeof( cachedScript.hash ) );
+
+            uint32 dataLength = 0;
+            stream->read( &dataLength, sizeof( dataLength ) );
+            cachedScript.data.resize( dataLength );
+            if( dataLength && stream->read( cachedScript.data.data(), dataLength ) != dataLength )
+            {
+                // Truncated file. Whatever got corrupted will be parsed again
+                mScriptCache.erase( name );
+                break;
+            }
+        }
+    }
+    //-------------------------------------------------------------------------
+    void ScriptCompilerManager::clearScriptCache()
+    {
+        ScopedLock lock( mScriptCacheMutex );
+        mScriptCache.clear();
+        mScriptCacheDirty = false;
     }
 
     //-------------------------------------------------------------------------
@@ -1829,3 +2076,5 @@ namespace Ogre
     //-------------------------------------------------------------------------
     String CreateCompositorScriptCompilerEvent::eventType = "createCompositor";
 }  // namespace Ogre
+
+#undef OGRE_HASH128_FUNC
@@ -605,6 +605,11 @@ namespace Ogre
         //---------------------------------------------------------------------
         void Skeleton::setBlendMode( SkeletonAnimationBlendMode state ) { mBlendState = state; }
         //---------------------------------------------------------------------
+        void Skeleton::setCompressionSettings( const SkeletonCompressionSettings &settings )
+        {
+            mCompressionSettings = settings;
+        }
+        //---------------------------------------------------------------------
         Skeleton::BoneIterator Skeleton::getRootBoneIterator()
         {
             if( mRootBones.empty() )
@@ -1012,6 +1017,7 @@ namespace Ogre
         {
             size_t memSize = 0;
             memSize += sizeof( SkeletonAnimationBlendMode );
+            memSize += sizeof( SkeletonCompressionSettings );
             memSize += mBoneList.size() * sizeof( OldBone );
             memSize += mRootBones.size() * sizeof( OldBone );
             memSize += mBoneListByName.size() * ( sizeof( String ) + sizeof( OldBone * ) );
@@ -138,6 +138,19 @@ namespace Ogre
                     pSkel->setBlendMode( static_cast<SkeletonAnimationBlendMode>( blendMode ) );
                     break;
                 }
+                case SKELETON_ANIMATION_COMPRESSION:
+                {
+                    // Optional compression of the v2 animations
+                    float tolerances[3];
+                    readFloats( stream, tolerances, 3 );
+                    SkeletonCompressionSettings settings;
+                    settings.enabled = true;
+                    settings.positionTolerance = tolerances[0];
+                    settings.orientationTolerance = tolerances[1];
+                    settings.scaleTolerance = tolerances[2];
+                    pSkel->setCompressionSettings( settings );
+                    break;
+                }
                 case SKELETON_BONE:
                     readBone( stream, pSkel );
                     break;
@@ -180,6 +193,18 @@ namespace Ogre
                 writeShorts( &blendMode, 1 );
             }
 
+            // Write animation compression settings
+            const SkeletonCompressionSettings &compression = pSkel->getCompressionSettings();
+            if( (int)ver > (int)SKELETON_VERSION_1_0 && compression.enabled )
+            {
+                writeChunkHeader( SKELETON_ANIMATION_COMPRESSION,
+                                  SSTREAM_OVERHEAD_SIZE + sizeof( float ) * 3u );
+                const float tolerances[3] = { static_cast<float>( compression.positionTolerance ),
+                                              static_cast<float>( compression.orientationTolerance ),
+                                              static_cast<float>( compression.scaleTolerance ) };
+                writeFloats( tolerances, 3 );
+            }
+
             // Write each bone
             unsigned short numBones = pSkel->getNumBones();
             unsigned short i;
@@ -50,6 +50,7 @@ THE SOFTWARE.
 #include "OgreTextureFilters.h"
 #include "OgreTextureGpu.h"
 #include "OgreTextureGpuManagerListener.h"
+#include "OgreTimer.h"
 #include "Threading/OgreThreads.h"
 #include "Vao/OgreVaoManager.h"
 
@@ -91,6 +92,8 @@ namespace Ogre
 
     unsigned long updateStreamingWorkerThread( ThreadHandle *threadHandle );
     THREAD_DECLARE( updateStreamingWorkerThread );
+    unsigned long updateDecodeWorkerThread( ThreadHandle *threadHandle );
+    THREAD_DECLARE( updateDecodeWorkerThread );
 
     TextureGpuManager::TextureGpuManager( VaoManager *vaoManager, RenderSystem *renderSystem ) :
         mDefaultMipmapGen( DefaultMipmapGen::HwMode ),
@@ -101,6 +104,7 @@ namespace Ogre
         mLoadRequestsCounter( 0u ),
         mLastUpdateIsStreamingDone( true ),
         mAddedNewLoadRequests( false ),
+        mDecodeWorkersShuttingDown( false ),
         mEntriesToProcessPerIteration( 3u ),
         mMaxPreloadBytes( 256u * 1024u * 1024u ),  // A value of 512MB begins to shake driver bugs.
         mTextureGpuManagerListener( &sDefaultTextureGpuManagerListener ),
@@ -112,6 +116,11 @@ namespace Ogre
 #endif
         mDelayListenerCalls( false ),
         mIgnoreScheduledTasks( false ),
+        mResidencyBudget( 0u ),
+        mResidencyEvictTo( GpuResidency::OnStorage ),
+        mResidencyEvictionDelay( 60u ),
+        mResidencyMaxStreamInsPerFrame( 16u ),
+        mLastResidencyBudgetFrame( std::numeric_limits<uint32>::max() ),
         mIgnoreSRgbPreference( false ),
         mVaoManager( vaoManager ),
         mRenderSystem( renderSystem )
@@ -203,6 +212,10 @@ namespace Ogre
             mWorkerWaitableEvent.wake();
             Threads::WaitForThreads( 1u, &mWorkerThread );
 #endif
+            mMutex.lock();
+            stopDecodeWorkers();
+            abortAllDecodeTasks();
+            mMutex.unlock();
         }
     }
     //-----------------------------------------------------------------------------------
@@ -219,6 +232,8 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::abortAllRequests()
     {
+        abortAllDecodeTasks();
+
         ThreadData &workerData = mThreadData[c_workerThread];
         ThreadData &mainData = mThreadData[c_mainThread];
         mLoadRequestsMutex.lock();
@@ -531,6 +546,8 @@ namespace Ogre
 
         texture->notifyAllListenersTextureChanged( TextureGpuListener::Deleted );
 
+        mResidencyEvicted.erase( texture );
+
         BarrierSolver &barrierSolver = mRenderSystem->getBarrierSolver();
         barrierSolver.textureDeleted( texture );
 
@@ -1345,6 +1362,184 @@ namespace Ogre
         mMaxPreloadBytes = std::max<size_t>( 1u, maxPreloadBytes );
     }
     //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setResidencyBudget( size_t budgetBytes,
+                                                GpuResidency::GpuResidency evictTo )
+    {
+        OGRE_ASSERT_LOW( evictTo != GpuResidency::Resident );
+        mResidencyBudget = budgetBytes;
+        mResidencyEvictTo = evictTo;
+        if( !budgetBytes )
+            mResidencyEvicted.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setResidencyEvictionDelay( uint32 numFrames )
+    {
+        mResidencyEvictionDelay = numFrames;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setResidencyMaxStreamInsPerFrame( uint32 maxStreamIns )
+    {
+        mResidencyMaxStreamInsPerFrame = maxStreamIns;
+    }
+    //-----------------------------------------------------------------------------------
+    inline bool OrderResidencyCandidateByEviction( const TextureGpuManager::ResidencyCandidate &_l,
+                                                   const TextureGpuManager::ResidencyCandidate &_r )
+    {
+        if( _l.weightedAge != _r.weightedAge )
+            return _l.weightedAge > _r.weightedAge;
+        return _l.distanceToCamera > _r.distanceToCamera;
+    }
+    //-----------------------------------------------------------------------------------
+    inline bool OrderResidencyCandidateByStreamIn( const TextureGpuManager::ResidencyCandidate &_l,
+                                                   const TextureGpuManager::ResidencyCandidate &_r )
+    {
+        if( _l.distanceToCamera != _r.distanceToCamera )
+            return _l.distanceToCamera < _r.distanceToCamera;
+        return _l.weightedAge < _r.weightedAge;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::updateResidencyBudget()
+    {
+        const uint32 frameCount = mVaoManager->getFrameCount();
+        if( mLastResidencyBudgetFrame == frameCount )
+            return;  // We're being called from waitForStreamingCompletion
+        mLastResidencyBudgetFrame = frameCount;
+
+        OgreProfileExhaustive( "TextureGpuManager::updateResidencyBudget" );
+
+        mTmpEvictionCandidates.clear();
+        mTmpStreamInCandidates.clear();
+
+        size_t residentBytes = 0;
+
+        ResourceEntryMap::const_iterator itor = mEntries.begin();
+        ResourceEntryMap::const_iterator endt = mEntries.end();
+
+        while( itor != endt )
+        {
+            TextureGpu *texture = itor->second.texture;
+            const uint32 age = frameCount - texture->getLastFrameUsed();
+
+            if( texture->getNextResidencyStatus() == GpuResidency::Resident )
+            {
+                residentBytes += texture->getSizeBytes();
+
+                // Textures that were never touched are used by something that doesn't
+                // report it (e.g. compositor passes, IBL, low level materials). Leave them be.
+                if( age > mResidencyEvictionDelay && texture->hasBeenTouched() &&
+                    texture->getRank() > 0 &&
+                    texture->getResidencyStatus() == GpuResidency::Resident &&
+                    !texture->getPendingResidencyChanges() && texture->isDataReady() &&
+                    !texture->isManualTexture() )
+                {
+                    mTmpEvictionCandidates.push_back( ResidencyCandidate(
+                        texture, age * static_cast<uint32>( texture->getRank() ),
+                        texture->getLowestDistanceToCamera() ) );
+                }
+            }
+            else if( age <= 1u && !texture->getPendingResidencyChanges() &&
+                     !mResidencyEvicted.empty() &&
+                     mResidencyEvicted.find( texture ) != mResidencyEvicted.end() )
+            {
+                mTmpStreamInCandidates.push_back( ResidencyCandidate(
+                    texture, age * static_cast<uint32>( std::max( texture->getRank(), 1 ) ),
+                    texture->getLowestDistanceToCamera() ) );
+            }
+
+            ++itor;
+        }
+
+        std::sort( mTmpStreamInCandidates.begin(), mTmpStreamInCandidates.end(),
+                   OrderResidencyCandidateByStreamIn );
+        if( mTmpStreamInCandidates.size() > mResidencyMaxStreamInsPerFrame )
+        {
+            mTmpStreamInCandidates.erase(
+                mTmpStreamInCandidates.begin() + mResidencyMaxStreamInsPerFrame,
+                mTmpStreamInCandidates.end() );
+        }
+
+        size_t neededBytes = residentBytes;
+        ResidencyCandidateVec::const_iterator itCandidate = mTmpStreamInCandidates.begin();
+        ResidencyCandidateVec::const_iterator enCandidate = mTmpStreamInCandidates.end();
+        while( itCandidate != enCandidate )
+        {
+            neededBytes += itCandidate->texture->getSizeBytes();
+            ++itCandidate;
+        }
+
+        if( neededBytes > mResidencyBudget )
+        {
+            // Page out least recently used textures to make room
+            std::sort( mTmpEvictionCandidates.begin(), mTmpEvictionCandidates.end(),
+                       OrderResidencyCandidateByEviction );
+
+            itCandidate = mTmpEvictionCandidates.begin();
+            enCandidate = mTmpEvictionCandidates.end();
+            while( itCandidate != enCandidate && neededBytes > mResidencyBudget )
+            {
+                TextureGpu *texture = itCandidate->texture;
+                const size_t sizeBytes = texture->getSizeBytes();
+
+                GpuResidency::GpuResidency evictTo = mResidencyEvictTo;
+                if( texture->getGpuPageOutStrategy() == GpuPageOutStrategy::Discard )
+                    evictTo = GpuResidency::OnStorage;
+                texture->scheduleTransitionTo( evictTo );
+                mResidencyEvicted.insert( texture );
+
+                neededBytes -= sizeBytes;
+                residentBytes -= sizeBytes;
+                ++itCandidate;
+            }
+        }
+
+        // Page back in the evicted textures being used, nearest first
+        itCandidate = mTmpStreamInCandidates.begin();
+        enCandidate = mTmpStreamInCandidates.end();
+        while( itCandidate != enCandidate )
+        {
+            TextureGpu *texture = itCandidate->texture;
+            const size_t sizeBytes = texture->getSizeBytes();
+            if( residentBytes + sizeBytes <= mResidencyBudget )
+            {
+                texture->scheduleTransitionTo( GpuResidency::Resident );
+                mResidencyEvicted.erase( texture );
+                residentBytes += sizeBytes;
+            }
+            ++itCandidate;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setNumDecodeWorkers( size_t numWorkers )
+    {
+#if OGRE_PLATFORM != OGRE_PLATFORM_EMSCRIPTEN
+        if( numWorkers == mDecodeWorkers.size() )
+            return;
+
+        mMutex.lock();
+        stopDecodeWorkers();
+        startDecodeWorkers( numWorkers );
+        mMutex.unlock();
+
+        mWorkerWaitableEvent.wake();
+#endif
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::getDecodeStats( DecodeStats &outStats ) const
+    {
+        mDecodeMutex.lock();
+        outStats.queueDepth = mDecodeQueue.size();
+        outStats.workers.clear();
+        outStats.workers.reserve( mDecodeWorkers.size() );
+        DecodeWorkerVec::const_iterator itor = mDecodeWorkers.begin();
+        DecodeWorkerVec::const_iterator endt = mDecodeWorkers.end();
+        while( itor != endt )
+        {
+            outStats.workers.push_back( ( *itor )->stats );
+            ++itor;
+        }
+        mDecodeMutex.unlock();
+    }
+    //-----------------------------------------------------------------------------------
     void TextureGpuManager::setWorkerThreadMaxPerStagingTextureRequestBytes(
         size_t maxPerStagingTextureRequestBytes )
     {
@@ -2447,7 +2642,9 @@ namespace Ogre
         const uint8 firstMip = queuedImage.getMinMipLevel();
         const uint8 numMips = queuedImage.getMaxMipLevelPlusOne();
 
-        for( uint8 i = firstMip; i < numMips; ++i )
+        // Smallest mips first. If we run out of StagingTextures,
+        // the mip tail will be in place while the biggest mips wait.
+        for( uint8 i = numMips; i-- > firstMip; )
         {
             TextureBox srcBox = img.getData( i );
             const uint32 imgDepthOrSlices = srcBox.getDepthOrSlices();
@@ -2562,6 +2759,209 @@ namespace Ogre
         return 0;
     }
     //-----------------------------------------------------------------------------------
+    unsigned long updateDecodeWorkerThread( ThreadHandle *threadHandle )
+    {
+        TextureGpuManager *textureManager =
+            reinterpret_cast<TextureGpuManager *>( threadHandle->getUserParam() );
+        return textureManager->_updateDecodeWorkerThread( threadHandle );
+    }
+    //-----------------------------------------------------------------------------------
+    unsigned long TextureGpuManager::_updateDecodeWorkerThread( ThreadHandle *threadHandle )
+    {
+        mDecodeMutex.lock();
+        DecodeWorker *worker = mDecodeWorkers[threadHandle->getThreadIdx()];
+        mDecodeMutex.unlock();
+
+        Timer timer;
+
+        while( !mDecodeWorkersShuttingDown )
+        {
+            mDecodeMutex.lock();
+            if( mDecodeQueue.empty() )
+            {
+                mDecodeMutex.unlock();
+
+                const uint64 stallStart = timer.getMicroseconds();
+                worker->waitableEvent.wait();
+                const uint64 stallTime = timer.getMicroseconds() - stallStart;
+
+                mDecodeMutex.lock();
+                worker->stats.stallMicroseconds += stallTime;
+                mDecodeMutex.unlock();
+                continue;
+            }
+
+            DecodeTask *task = mDecodeQueue.front();
+            mDecodeQueue.erase( mDecodeQueue.begin() );
+            task->state = DecodeInProgress;
+            mDecodeMutex.unlock();
+
+            OgreProfileExhaustive( "TextureGpuManager::_updateDecodeWorkerThread decode" );
+
+            const uint64 busyStart = timer.getMicroseconds();
+
+            try
+            {
+                DataStreamPtr data = task->archive->open( task->name );
+                task->image.load2( data, task->name );
+            }
+            catch( Exception &e )
+            {
+                LogManager::getSingleton().logMessage( e.getFullDescription() );
+                task->exception = std::current_exception();
+            }
+
+            const uint64 busyTime = timer.getMicroseconds() - busyStart;
+
+            mDecodeMutex.lock();
+            ++worker->stats.numImages;
+            if( !task->exception )
+                worker->stats.bytesDecoded += task->image.getSizeBytes();
+            worker->stats.busyMicroseconds += busyTime;
+            if( task->state == DecodeAbandoned )
+                delete task;
+            else
+                task->state = DecodeDone;
+            mDecodeMutex.unlock();
+
+            // The worker thread may be waiting for this very image
+            mWorkerWaitableEvent.wake();
+        }
+
+        return 0;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::startDecodeWorkers( size_t numWorkers )
+    {
+        OGRE_ASSERT_LOW( mDecodeWorkers.empty() );
+
+        mDecodeWorkersShuttingDown = false;
+
+        mDecodeMutex.lock();
+        mDecodeWorkers.reserve( numWorkers );
+        for( size_t i = 0u; i < numWorkers; ++i )
+            mDecodeWorkers.push_back( new DecodeWorker() );
+        mDecodeMutex.unlock();
+
+        for( size_t i = 0u; i < numWorkers; ++i )
+        {
+            mDecodeWorkers[i]->threadHandle =
+                Threads::CreateThread( THREAD_GET( updateDecodeWorkerThread ), i, this );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::stopDecodeWorkers()
+    {
+        if( mDecodeWorkers.empty() )
+            return;
+
+        mDecodeWorkersShuttingDown = true;
+
+        DecodeWorkerVec::const_iterator itor = mDecodeWorkers.begin();
+        DecodeWorkerVec::const_iterator endt = mDecodeWorkers.end();
+        while( itor != endt )
+        {
+            ( *itor )->waitableEvent.wake();
+            Threads::WaitForThreads( 1u, &( *itor )->threadHandle );
+            delete *itor;
+            ++itor;
+        }
+
+        mDecodeMutex.lock();
+        mDecodeWorkers.clear();
+        mDecodeMutex.unlock();
+
+        // Nobody will pick the tasks that were still queued. Let the
+        // worker thread open & decode those files by itself instead.
+        LoadRequestVec &loadRequests = mThreadData[c_workerThread].loadRequests;
+        LoadRequestVec::iterator itLoad = loadRequests.begin();
+        LoadRequestVec::iterator enLoad = loadRequests.end();
+        while( itLoad != enLoad )
+        {
+            if( itLoad->decodeTask && itLoad->decodeTask->state == DecodeQueued )
+            {
+                delete itLoad->decodeTask;
+                itLoad->decodeTask = 0;
+            }
+            ++itLoad;
+        }
+        mDecodeQueue.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::abortAllDecodeTasks()
+    {
+        mDecodeMutex.lock();
+        LoadRequestVec &loadRequests = mThreadData[c_workerThread].loadRequests;
+        LoadRequestVec::iterator itor = loadRequests.begin();
+        LoadRequestVec::iterator endt = loadRequests.end();
+        while( itor != endt )
+        {
+            if( itor->decodeTask )
+            {
+                if( itor->decodeTask->state == DecodeInProgress )
+                    itor->decodeTask->state = DecodeAbandoned;
+                else
+                    delete itor->decodeTask;
+                itor->decodeTask = 0;
+            }
+            ++itor;
+        }
+        mDecodeQueue.clear();
+        mDecodeMutex.unlock();
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::scheduleDecodeTasks( ThreadData &workerData )
+    {
+        if( mDecodeWorkers.empty() )
+            return;
+
+        // Don't decode too far ahead of what we can consume,
+        // or else memory consumption would skyrocket
+        const size_t maxDecodeAhead =
+            std::max( mEntriesToProcessPerIteration, mDecodeWorkers.size() * 2u );
+
+        bool addedTasks = false;
+
+        mDecodeMutex.lock();
+        const size_t numRequests = std::min( workerData.loadRequests.size(), maxDecodeAhead );
+        for( size_t i = 0u; i < numRequests; ++i )
+        {
+            LoadRequest &loadRequest = workerData.loadRequests[i];
+            // ZipArchive & co. aren't safe to open files from multiple threads
+            if( !loadRequest.decodeTask && !loadRequest.image && loadRequest.archive &&
+                !loadRequest.loadingListener && loadRequest.archive->getType() == "FileSystem" )
+            {
+                loadRequest.decodeTask = new DecodeTask( loadRequest.name, loadRequest.archive );
+                mDecodeQueue.push_back( loadRequest.decodeTask );
+                addedTasks = true;
+            }
+        }
+        mDecodeMutex.unlock();
+
+        if( addedTasks )
+        {
+            DecodeWorkerVec::const_iterator itor = mDecodeWorkers.begin();
+            DecodeWorkerVec::const_iterator endt = mDecodeWorkers.end();
+            while( itor != endt )
+            {
+                ( *itor )->waitableEvent.wake();
+                ++itor;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    bool TextureGpuManager::isDecodeTaskReady( const LoadRequest &loadRequest ) const
+    {
+        if( !loadRequest.decodeTask )
+            return true;
+
+        mDecodeMutex.lock();
+        const bool isReady = loadRequest.decodeTask->state == DecodeDone;
+        mDecodeMutex.unlock();
+
+        return isReady;
+    }
+    //-----------------------------------------------------------------------------------
     void TextureGpuManager::processLoadRequest( ObjCmdBuffer *commandBuffer, ThreadData &workerData,
                                                 const LoadRequest &loadRequest )
     {
@@ -2603,8 +3003,14 @@ namespace Ogre
                 LML_CRITICAL );
         }
 
+        DecodeTask *decodeTask = loadRequest.decodeTask;
+
         DataStreamPtr data;
-        if( !loadRequest.archive && !loadRequest.image )
+        if( decodeTask )
+        {
+            // Already opened & decoded by the decode pool
+        }
+        else if( !loadRequest.archive && !loadRequest.image )
             data = loadRequest.loadingListener->grouplessResourceLoading( loadRequest.name );
         else if( !loadRequest.image )
         {
@@ -2639,24 +3045,48 @@ namespace Ogre
             img = &imgStack;
             if( !wasRescheduled )
             {
-                try
+                if( decodeTask )
                 {
-                    if( data )
-                        img->load2( data, loadRequest.name );
+                    if( decodeTask->exception )
+                    {
+                        try
+                        {
+                            std::rethrow_exception( decodeTask->exception );
+                        }
+                        catch( Exception &e )
+                        {
+                            // Already logged by the decode worker. Tell the main thread this happened
+                            ObjCmdBuffer::ExceptionThrown *exceptionCmd =
+                                commandBuffer->addCommand<ObjCmdBuffer::ExceptionThrown>();
+                            new( exceptionCmd ) ObjCmdBuffer::ExceptionThrown( loadRequest.texture, e );
+                        }
+                    }
+                    else
+                    {
+                        img = &decodeTask->image;
+                    }
                 }
-                catch( Exception &e )
+                else
                 {
-                    // Log the exception
-                    LogManager::getSingleton().logMessage( e.getFullDescription() );
-                    // Tell the main thread this happened
-                    ObjCmdBuffer::ExceptionThrown *exceptionCmd =
-                        commandBuffer->addCommand<ObjCmdBuffer::ExceptionThrown>();
-                    new( exceptionCmd ) ObjCmdBuffer::ExceptionThrown( loadRequest.texture, e );
-
-                    data.reset();
+                    try
+                    {
+                        if( data )
+                            img->load2( data, loadRequest.name );
+                    }
+                    catch( Exception &e )
+                    {
+                        // Log the exception
+                        LogManager::getSingleton().logMessage( e.getFullDescription() );
+                        // Tell the main thread this happened
+                        ObjCmdBuffer::ExceptionThrown *exceptionCmd =
+                            commandBuffer->addCommand<ObjCmdBuffer::ExceptionThrown>();
+                        new( exceptionCmd ) ObjCmdBuffer::ExceptionThrown( loadRequest.texture, e );
+
+                        data.reset();
+                    }
                 }
 
-                if( !data )
+                if( img == &imgStack && !data )
                 {
                     PixelFormatGpu fallbackFormat = PFG_RGBA8_UNORM_SRGB;
 
@@ -2955,6 +3385,8 @@ namespace Ogre
         }
         mLoadRequestsMutex.unlock();
 
+        scheduleDecodeTasks( workerData );
+
         ObjCmdBuffer *commandBuffer = workerData.objCmdBuffer;
 
         const bool processedAnyImage =
@@ -2980,14 +3412,19 @@ namespace Ogre
 
         const size_t entriesToProcessPerIteration = mEntriesToProcessPerIteration;
         size_t entriesProcessed = 0;
-        // Now process new requests from main thread
-        LoadRequestVec::const_iterator itor = workerData.loadRequests.begin();
-        LoadRequestVec::const_iterator endt = workerData.loadRequests.end();
+        // Now process new requests from main thread. Those handed to the decode
+        // pool must still be processed in order (e.g. cubemap faces depend on the
+        // first one) so stop at the first one that isn't decoded yet. A decode worker
+        // will wake us up once it's done.
+        LoadRequestVec::iterator itor = workerData.loadRequests.begin();
+        LoadRequestVec::iterator endt = workerData.loadRequests.end();
 
         while( itor != endt && entriesProcessed < entriesToProcessPerIteration &&
-               mStreamingData.bytesPreloaded < mMaxPreloadBytes )
+               mStreamingData.bytesPreloaded < mMaxPreloadBytes && isDecodeTaskReady( *itor ) )
         {
             processLoadRequest( commandBuffer, workerData, *itor );
+            delete itor->decodeTask;
+            itor->decodeTask = 0;
             ++entriesProcessed;
             ++itor;
         }
@@ -3009,6 +3446,9 @@ namespace Ogre
         workerData.loadRequests.erase(
             workerData.loadRequests.begin(),
             workerData.loadRequests.begin() + static_cast<ptrdiff_t>( entriesProcessed ) );
+        // Keep the decode pool busy with what comes next
+        if( entriesProcessed )
+            scheduleDecodeTasks( workerData );
         mergeUsageStatsIntoPrevStats();
         mMutex.unlock();
 
@@ -3203,6 +3643,9 @@ namespace Ogre
 
         mAddedNewLoadRequests = false;
 
+        if( mResidencyBudget )
+            updateResidencyBudget();
+
 #if OGRE_PLATFORM == OGRE_PLATFORM_EMSCRIPTEN || OGRE_FORCE_TEXTURE_STREAMING_ON_MAIN_THREAD
         _updateStreaming();
 #endif
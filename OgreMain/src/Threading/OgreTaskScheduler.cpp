@@ -0,0 +1,292 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "Threading/OgreTaskScheduler.h"
+
+namespace Ogre
+{
+    RangeTask::~RangeTask() {}
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    const TaskScheduler::TaskId TaskScheduler::INVALID_TASK_ID = 0xFFFFFFFF;
+    const size_t TaskScheduler::CHUNKS_PER_THREAD = 4u;
+    //-----------------------------------------------------------------------------------
+    unsigned long taskSchedulerWorkerThread( ThreadHandle *threadHandle )
+    {
+        TaskScheduler *taskScheduler = reinterpret_cast<TaskScheduler *>( threadHandle->getUserParam() );
+        return taskScheduler->_workerThread( threadHandle->getThreadIdx() );
+    }
+    THREAD_DECLARE( taskSchedulerWorkerThread );
+    //-----------------------------------------------------------------------------------
+    TaskScheduler::TaskScheduler( size_t numThreads ) :
+        mNumThreads( std::max<size_t>( numThreads, 1u ) ),
+        mThreadQueues( 0 ),
+        mNextQueue( 0 ),
+        mNumPendingTasks( 0 ),
+        mExitThreads( false )
+    {
+        mThreadQueues = new ThreadQueue[mNumThreads];
+
+        // Thread 0 is the owner; it doesn't need a thread of its own
+        mWorkerThreads.reserve( mNumThreads - 1u );
+        for( size_t i = 1u; i < mNumThreads; ++i )
+        {
+            ThreadHandlePtr th =
+                Threads::CreateThread( THREAD_GET( taskSchedulerWorkerThread ), i, this );
+            mWorkerThreads.push_back( th );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    TaskScheduler::~TaskScheduler()
+    {
+        waitForAll();
+
+        mExitThreads.store( true );
+        wakeAllThreads();
+        Threads::WaitForThreads( mWorkerThreads );
+        mWorkerThreads.clear();
+
+        delete[] mThreadQueues;
+        mThreadQueues = 0;
+    }
+    //-----------------------------------------------------------------------------------
+    void TaskScheduler::scheduleTask( TaskId taskId )
+    {
+        Task &task = mTasks[taskId];
+
+        if( !task.numItems )
+        {
+            // Nothing to do. Just release whoever depends on us.
+            completeTask( taskId );
+            return;
+        }
+
+        const size_t numChunks = ( task.numItems + task.chunkSize - 1u ) / task.chunkSize;
+        task.numPendingChunks = numChunks;
+
+        for( size_t i = 0; i < numChunks; ++i )
+        {
+            Chunk chunk;
+            chunk.task = task.task;
+            chunk.taskId = taskId;
+            chunk.begin = i * task.chunkSize;
+            chunk.end = std::min( chunk.begin + task.chunkSize, task.numItems );
+
+            // Spread the chunks round robin; idle threads will steal the rest
+            ThreadQueue &threadQueue = mThreadQueues[mNextQueue];
+            mNextQueue = ( mNextQueue + 1u ) % mNumThreads;
+
+            ScopedLock lock( threadQueue.mutex );
+            threadQueue.chunks.push_back( chunk );
+        }
+
+        wakeAllThreads();
+    }
+    //-----------------------------------------------------------------------------------
+    void TaskScheduler::completeTask( TaskId taskId )
+    {
+        mTasks[taskId].done = true;
+        --mNumPendingTasks;
+
+        // scheduleTask never adds tasks, thus mTasks won't be reallocated while we iterate
+        const size_t numDependents = mTasks[taskId].dependents.size();
+        for( size_t i = 0; i < numDependents; ++i )
+        {
+            const TaskId dependentId = mTasks[taskId].dependents[i];
+            Task &dependent = mTasks[dependentId];
+            assert( dependent.numPendingDependencies > 0u );
+            --dependent.numPendingDependencies;
+            if( !dependent.numPendingDependencies )
+                scheduleTask( dependentId );
+        }
+
+        // The owner may be waiting for this task
+        mThreadQueues[0].wakeEvent.wake();
+    }
+    //-----------------------------------------------------------------------------------
+    void TaskScheduler::wakeAllThreads()
+    {
+        for( size_t i = 0; i < mNumThreads; ++i )
+            mThreadQueues[i].wakeEvent.wake();
+    }
+    //-----------------------------------------------------------------------------------
+    bool TaskScheduler::acquireChunk( size_t threadIdx, Chunk &outChunk )
+    {
+        {
+            // Take from the front of our own queue, so we walk memory forward
+            ThreadQueue &threadQueue = mThreadQueues[threadIdx];
+            ScopedLock lock( threadQueue.mutex );
+            if( !threadQueue.chunks.empty() )
+            {
+                outChunk = threadQueue.chunks.front();
+                threadQueue.chunks.pop_front();
+                return true;
+            }
+        }
+
+        // Steal from the back of the other queues, away from where their owners are working
+        for( size_t i = 1u; i < mNumThreads; ++i )
+        {
+            ThreadQueue &threadQueue = mThreadQueues[( threadIdx + i ) % mNumThreads];
+            ScopedLock lock( threadQueue.mutex );
+            if( !threadQueue.chunks.empty() )
+            {
+                outChunk = threadQueue.chunks.back();
+                threadQueue.chunks.pop_back();
+                return true;
+            }
+        }
+
+        return false;
+    }
+    //-----------------------------------------------------------------------------------
+    void TaskScheduler::executeChunk( const Chunk &chunk, size_t threadIdx )
+    {
+        chunk.task->execute( chunk.begin, chunk.end, threadIdx );
+
+        ScopedLock lock( mTasksMutex );
+        Task &task = mTasks[chunk.taskId];
+        assert( task.numPendingChunks > 0u );
+        --task.numPendingChunks;
+        if( !task.numPendingChunks )
+            completeTask( chunk.taskId );
+    }
+    //-----------------------------------------------------------------------------------
+    TaskScheduler::TaskId TaskScheduler::addTask( RangeTask *task, size_t numItems,
+                                                  size_t granularity, const TaskId *dependencies,
+                                                  size_t numDependencies )
+    {
+        assert( granularity > 0u );
+
+        bool hasDependencies = false;
+        for( size_t i = 0; i < numDependencies; ++i )
+            hasDependencies |= dependencies[i] != INVALID_TASK_ID;
+
+        if( !numItems && !hasDependencies )
+            return INVALID_TASK_ID;
+
+        // Aim for CHUNKS_PER_THREAD chunks per thread so there is something left to steal,
+        // but never split in the middle of a granule.
+        const size_t numTargetChunks = mNumThreads * CHUNKS_PER_THREAD;
+        size_t chunkSize = ( numItems + numTargetChunks - 1u ) / numTargetChunks;
+        chunkSize = ( ( chunkSize + granularity - 1u ) / granularity ) * granularity;
+        chunkSize = std::max( chunkSize, granularity );
+
+        ScopedLock lock( mTasksMutex );
+
+        const TaskId taskId = static_cast<TaskId>( mTasks.size() );
+        mTasks.push_back( Task() );
+        {
+            Task &newTask = mTasks.back();
+            newTask.task = task;
+            newTask.numItems = numItems;
+            newTask.chunkSize = chunkSize;
+            newTask.numPendingChunks = 0;
+            newTask.numPendingDependencies = 0;
+            newTask.done = false;
+        }
+        ++mNumPendingTasks;
+
+        for( size_t i = 0; i < numDependencies; ++i )
+        {
+            const TaskId dependencyId = dependencies[i];
+            if( dependencyId != INVALID_TASK_ID )
+            {
+                assert( dependencyId < taskId && "Invalid or stale TaskId" );
+                if( !mTasks[dependencyId].done )
+                {
+                    mTasks[dependencyId].dependents.push_back( taskId );
+                    ++mTasks[taskId].numPendingDependencies;
+                }
+            }
+        }
+
+        if( !mTasks[taskId].numPendingDependencies )
+            scheduleTask( taskId );
+
+        return taskId;
+    }
+    //-----------------------------------------------------------------------------------
+    void TaskScheduler::waitFor( TaskId taskId )
+    {
+        if( taskId == INVALID_TASK_ID )
+            return;
+
+        Chunk chunk;
+        while( true )
+        {
+            {
+                ScopedLock lock( mTasksMutex );
+                if( taskId >= mTasks.size() || mTasks[taskId].done )
+                    break;
+            }
+
+            if( acquireChunk( 0u, chunk ) )
+                executeChunk( chunk, 0u );
+            else
+                mThreadQueues[0].wakeEvent.wait();
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void TaskScheduler::waitForAll()
+    {
+        Chunk chunk;
+        while( true )
+        {
+            {
+                ScopedLock lock( mTasksMutex );
+                if( !mNumPendingTasks )
+                {
+                    mTasks.clear();
+                    break;
+                }
+            }
+
+            if( acquireChunk( 0u, chunk ) )
+                executeChunk( chunk, 0u );
+            else
+                mThreadQueues[0].wakeEvent.wait();
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    unsigned long TaskScheduler::_workerThread( size_t threadIdx )
+    {
+        Chunk chunk;
+        while( !mExitThreads.load() )
+        {
+            if( acquireChunk( threadIdx, chunk ) )
+                executeChunk( chunk, threadIdx );
+            else
+                mThreadQueues[threadIdx].wakeEvent.wait();
+        }
+
+        return 0;
+    }
+}  // namespace Ogre
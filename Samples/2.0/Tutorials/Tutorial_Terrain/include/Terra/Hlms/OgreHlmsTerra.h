@@ -108,6 +108,15 @@ namespace Ogre
         uint32 fillBuffersForV2( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
                                  bool casterPass, uint32 lastCacheHash,
                                  CommandBuffer *commandBuffer ) override;
+        /// HlmsPbs' batched path doesn't know about terrain cells. Fills none.
+        size_t fillBuffersForV2Batch( const HlmsCache *cache, const QueuedRenderable *queuedRenderables,
+                                      size_t numRenderables, bool casterPass,
+                                      uint32 *outBaseInstances ) override
+        {
+            return 0u;
+        }
+        /// Same as above, terrain cells are always filled by the main thread.
+        size_t getParallelFillMaxDraws( bool casterPass ) const override { return 0u; }
 
         static void getDefaultPaths( String &outDataFolderPath, StringVector &outLibraryFoldersPaths );
 
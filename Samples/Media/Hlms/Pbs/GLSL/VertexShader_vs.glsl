@@ -48,6 +48,9 @@ vulkan_layout( OGRE_POSITION ) in vec4 vertex;
 
 // START UNIFORM GL DECLARATION
 ReadOnlyBufferF( 0, float4, worldMatBuf );
+@property( static_instance_cache )
+	ReadOnlyBufferF( 1, float4, staticWorldMatBuf );
+@end
 
 @property( !GL_ARB_base_instance )uniform uint baseInstance;@end
 @property( hlms_pose )
@@ -54,6 +54,9 @@ struct PS_INPUT
 
 // START UNIFORM D3D DECLARATION
 ReadOnlyBuffer( 0, float4, worldMatBuf );
+@property( static_instance_cache )
+	ReadOnlyBuffer( 1, float4, staticWorldMatBuf );
+@end
 @property( hlms_pose )
 	Buffer<float4> poseBuf : register(t@value(poseBuf));
 @end
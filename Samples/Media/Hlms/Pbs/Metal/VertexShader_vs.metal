@@ -55,6 +55,9 @@ vertex PS_INPUT main_metal
 	@insertpiece( InstanceDecl )
 	@insertpiece( AtmosphereNprSkyDecl )
 	, device const float4 *worldMatBuf [[buffer(TEX_SLOT_START+0)]]
+	@property( static_instance_cache )
+		, device const float4 *staticWorldMatBuf [[buffer(TEX_SLOT_START+1)]]
+	@end
 	@property( hlms_pose )
 		@property( !hlms_pose_half )
 			, device const float4 *poseBuf	[[buffer(TEX_SLOT_START+@value(poseBuf))]]
@@ -6,7 +6,7 @@ export CXX=/usr/bin/clang++
 
 echo "--- Installing System Dependencies ---"
 sudo apt-get update
-sudo apt-get install -y ninja-build libxrandr-dev libxaw7-dev libxcb-randr0-dev libx11-xcb-dev libsdl2-dev
+sudo apt-get install -y ninja-build libxrandr-dev libxaw7-dev libxcb-randr0-dev libx11-xcb-dev libsdl2-dev libcppunit-dev
 
 echo "--- Fetching prebuilt Dependencies ---"
 wget https://github.com/OGRECave/ogre-next-deps/releases/download/bin-releases/Dependencies_Release_Ubuntu.20.04.LTS.Clang-12_a3f61e782f3effbd58a15727885cbd85cd1b342b.7z
@@ -31,4 +31,42 @@ cmake \
 ninja || exit $?
 ninja install || exit $?
 
+# The Debug build above uses the 4-wide SSE2 backend. Build and run the unit tests
+# again with the 8-wide AVX2 + FMA backend (OGRE_SIMD_AVX)
+cd ../..
+mkdir -p build/ReleaseAVX
+cd build/ReleaseAVX
+echo "--- Building Ogre unit tests (Release, AVX2) ---"
+cmake \
+-DOGRE_CONFIG_THREAD_PROVIDER=0 \
+-DOGRE_CONFIG_THREADS=0 \
+-DOGRE_SIMD_AVX=1 \
+-DOGRE_BUILD_SAMPLES2=0 \
+-DOGRE_BUILD_TESTS=1 \
+-DCMAKE_BUILD_TYPE="Release" \
+-DCMAKE_CXX_STANDARD=11 \
+-G Ninja ../.. || exit $?
+ninja Test_Ogre || exit $?
+echo "--- Running Ogre unit tests (Release, AVX2) ---"
+./bin/Test_Ogre || exit $?
+
+# Build and run the unit tests once more with the pooled allocator (OGRE_CONFIG_ALLOCATOR=6),
+# which is the only configuration where PooledAllocTests get compiled
+cd ../..
+mkdir -p build/ReleasePooled
+cd build/ReleasePooled
+echo "--- Building Ogre unit tests (Release, pooled allocator) ---"
+cmake \
+-DOGRE_CONFIG_THREAD_PROVIDER=0 \
+-DOGRE_CONFIG_THREADS=0 \
+-DOGRE_CONFIG_ALLOCATOR=6 \
+-DOGRE_BUILD_SAMPLES2=0 \
+-DOGRE_BUILD_TESTS=1 \
+-DCMAKE_BUILD_TYPE="Release" \
+-DCMAKE_CXX_STANDARD=11 \
+-G Ninja ../.. || exit $?
+ninja Test_Ogre || exit $?
+echo "--- Running Ogre unit tests (Release, pooled allocator) ---"
+./bin/Test_Ogre || exit $?
+
 echo "Done!"
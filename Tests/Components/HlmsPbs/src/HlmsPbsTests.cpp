@@ -0,0 +1,595 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "HlmsPbsTests.h"
+
+#include "CommandBuffer/OgreCommandBuffer.h"
+#include "OgreHlmsManager.h"
+#include "OgreHlmsPbs.h"
+#include "OgreHlmsPbsDatablock.h"
+#include "OgreMovableObject.h"
+#include "OgreNULLRenderSystem.h"
+#include "OgreRenderQueue.h"
+#include "OgreRenderable.h"
+#include "OgreRoot.h"
+#include "OgreSceneNode.h"
+#include "Math/Array/OgreNodeMemoryManager.h"
+#include "Math/Array/OgreObjectMemoryManager.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(HlmsPbsTests);
+
+namespace
+{
+    class TestMovableObject : public MovableObject
+    {
+    public:
+        TestMovableObject(ObjectMemoryManager *objectMemoryManager) :
+            MovableObject(Id::generateNewId<MovableObject>(), objectMemoryManager, 0, 10u)
+        {
+        }
+
+        const String &getMovableType() const override
+        {
+            static const String movableType("TestMovableObject");
+            return movableType;
+        }
+    };
+
+    class TestRenderable : public Renderable
+    {
+        LightList mLights;
+
+    public:
+        void getRenderOperation(v1::RenderOperation &op, bool casterPass) override {}
+        void getWorldTransforms(Matrix4 *xform) const override { *xform = Matrix4::IDENTITY; }
+        const LightList &getLights() const override { return mLights; }
+
+        /// Same as setDatablock, minus calculateHashFor (which needs Vaos). The hash is not
+        /// needed to fill the buffers
+        void setTestDatablock(HlmsDatablock *datablock)
+        {
+            if (mHlmsDatablock)
+                mHlmsDatablock->_unlinkRenderable(this);
+            mHlmsDatablock = datablock;
+            if (mHlmsDatablock)
+                mHlmsDatablock->_linkRenderable(this);
+        }
+
+        void setSkeletonAnimation(bool hasSkeletonAnimation)
+        {
+            mHasSkeletonAnimation = hasSkeletonAnimation;
+        }
+    };
+
+    /// Exposes the static instance cache. There is no RenderSystem, thus no GPU buffer:
+    /// uploads are emulated with markUploaded
+    class StaticInstanceTestHlmsPbs : public HlmsPbs
+    {
+    public:
+        StaticInstanceTestHlmsPbs() : HlmsPbs(0, 0)
+        {
+            mStaticInstanceMaxSlots = 16u;
+            // Set by preparePassHash from SceneManager::getStaticTransformsVersion
+            mStaticTransformsVersion = 1u;
+        }
+
+        using HlmsPbs::updateStaticInstanceSlot;
+        using HlmsPbs::releaseStaticInstanceSlot;
+
+        void setShaderProfile(const String &shaderProfile) { mShaderProfile = shaderProfile; }
+        void setMaxSlots(uint32 maxSlots) { mStaticInstanceMaxSlots = maxSlots; }
+
+        /// Emulates SceneManager::notifyStaticDirty followed by the next preparePassHash
+        void notifyStaticDirty() { ++mStaticTransformsVersion; }
+
+        bool hasDirtySlots() const { return mStaticInstanceDirtyBegin < mStaticInstanceDirtyEnd; }
+        bool isSlotDirty(uint32 slotIdx) const
+        {
+            return slotIdx >= mStaticInstanceDirtyBegin && slotIdx < mStaticInstanceDirtyEnd;
+        }
+
+        /// Same bookkeeping as uploadStaticInstances
+        void markUploaded()
+        {
+            for (uint32 i = mStaticInstanceDirtyBegin; i < mStaticInstanceDirtyEnd; ++i)
+                mStaticInstanceSlots[i].uploadedVersion = mStaticInstanceSlots[i].capturedVersion;
+            mStaticInstanceDirtyBegin = std::numeric_limits<uint32>::max();
+            mStaticInstanceDirtyEnd = 0u;
+        }
+
+        size_t getNumSlots() const { return mStaticInstanceSlots.size(); }
+        const Renderable *getSlotOwner(uint32 slotIdx) const
+        {
+            return mStaticInstanceSlots[slotIdx].owner;
+        }
+        /// Returns the 3x4 matrix captured in the slot
+        const float *getSlotMatrix(uint32 slotIdx) const
+        {
+            return mStaticInstanceShadow.begin() + slotIdx * 16u;
+        }
+    };
+
+    /// Points the mapped const & tex buffers to CPU memory, so that what
+    /// fillBuffersForV2 and fillBuffersForV2Batch write can be compared
+    class BatchTestHlmsPbs : public HlmsPbs
+    {
+    public:
+        BatchTestHlmsPbs() : HlmsPbs(0, 0) {}
+
+        void mapTestBuffers(uint32 *constBuffer, size_t constBufferSize, float *texBuffer,
+                            size_t texBufferSize)
+        {
+            mStartMappedConstBuffer = constBuffer;
+            mCurrentMappedConstBuffer = constBuffer;
+            mCurrentConstBufferSize = constBufferSize;
+            mStartMappedTexBuffer = texBuffer;
+            mCurrentMappedTexBuffer = texBuffer;
+            mCurrentTexBufferSize = texBufferSize;
+        }
+
+        /// Must be called before unregistering: there's no real buffer to unmap
+        void unmapTestBuffers() { mapTestBuffers(0, 0u, 0, 0u); }
+
+        void setViewMatrix(const Matrix4 &viewMatrix) { mPreparedPass.viewMatrix = viewMatrix; }
+
+        size_t getConstBufferOffset() const
+        {
+            return static_cast<size_t>(mCurrentMappedConstBuffer - mStartMappedConstBuffer);
+        }
+        size_t getTexBufferOffset() const
+        {
+            return static_cast<size_t>(mCurrentMappedTexBuffer - mStartMappedTexBuffer);
+        }
+    };
+
+    /// Renderables sharing a datablock, each on its own node with a different transform.
+    /// The NULL RenderSystem is needed for the datablock's const buffer pool
+    class BatchFillScene
+    {
+    public:
+        static const size_t NumRenderables = 11u;
+
+        NULLRenderSystem *renderSystem;
+        Root *root;
+        BatchTestHlmsPbs *hlms;
+        NodeMemoryManager nodeMemoryManager;
+        ObjectMemoryManager objectMemoryManager;
+        SceneNode *nodes[NumRenderables];
+        TestMovableObject *movableObjects[NumRenderables];
+        TestRenderable renderables[NumRenderables];
+        QueuedRenderable queuedRenderables[NumRenderables];
+        CommandBuffer commandBuffer;
+        HlmsCache cache;
+        /// Same Hlms type: fillBuffersForV2 won't bind the pass resources
+        uint32 lastCacheHash;
+
+        BatchFillScene() : cache(0u, HLMS_PBS, HlmsPso()), lastCacheHash(uint32(HLMS_PBS) << 29u)
+        {
+            root = OGRE_NEW Root(0, "", "", "HlmsPbsTests.log");
+            renderSystem = new NULLRenderSystem();
+            root->addRenderSystem(renderSystem);
+            root->setRenderSystem(renderSystem);
+            root->initialise(false);
+            // Creates the VaoManager
+            root->createRenderWindow("HlmsPbsTests", 320u, 180u, false);
+
+            hlms = OGRE_NEW BatchTestHlmsPbs();
+            root->getHlmsManager()->registerHlms(hlms, false);
+            HlmsDatablock *datablock = hlms->createDatablock(
+                "BatchFill", "BatchFill", HlmsMacroblock(), HlmsBlendblock(), HlmsParamVec());
+            static_cast<HlmsPbsDatablock *>(datablock)->mShadowConstantBias = 0.25f;
+
+            Matrix4 viewMatrix;
+            viewMatrix.makeInverseTransform(Vector3(5.0f, -3.0f, 10.0f), Vector3::UNIT_SCALE,
+                                            Quaternion(Degree(30.0f), Vector3::UNIT_Y));
+            hlms->setViewMatrix(viewMatrix);
+
+            for (size_t i = 0; i < NumRenderables; ++i)
+            {
+                const Real x = Real(i);
+                nodes[i] = new SceneNode(i + 1u, 0, &nodeMemoryManager, 0);
+                nodes[i]->setPosition(Vector3(x, -2.0f * x, 0.5f * x));
+                nodes[i]->setOrientation(Quaternion(Degree(15.0f * x), Vector3(0.6f, 0.8f, 0.0f)));
+                nodes[i]->setScale(Vector3(1.0f + x, 1.0f, 0.5f));
+                nodes[i]->_getFullTransformUpdated();
+
+                movableObjects[i] = new TestMovableObject(&objectMemoryManager);
+                movableObjects[i]->setLightMask(0x100u + i);
+                nodes[i]->attachObject(movableObjects[i]);
+
+                renderables[i].setTestDatablock(datablock);
+                renderables[i].mCustomParameter = static_cast<uint8>(i);
+                queuedRenderables[i] = QueuedRenderable(0u, &renderables[i], movableObjects[i]);
+            }
+        }
+
+        ~BatchFillScene()
+        {
+            for (size_t i = 0; i < NumRenderables; ++i)
+            {
+                nodes[i]->detachAllObjects();
+                delete movableObjects[i];
+                delete nodes[i];
+                renderables[i].setTestDatablock(0);
+            }
+
+            hlms->unmapTestBuffers();
+            root->getHlmsManager()->unregisterHlms(HLMS_PBS);
+            OGRE_DELETE hlms;
+            OGRE_DELETE root;
+            delete renderSystem;
+        }
+    };
+
+    /// Fills the buffers of all the renderables with fillBuffersForV2, then again with
+    /// fillBuffersForV2 for the first one and fillBuffersForV2Batch for the rest (as
+    /// RenderQueue does), and checks both wrote the same
+    void checkBatchMatchesPerRenderable(BatchFillScene &scene, bool casterPass)
+    {
+        const size_t numRenderables = BatchFillScene::NumRenderables;
+        const size_t texFloatsPerDraw = 16u * (1u + !casterPass);
+        // Bigger than needed. What's past the last draw must be left untouched
+        const size_t constBufferSize = 4u * 64u;
+        const size_t texBufferSize = texFloatsPerDraw * 64u;
+
+        std::vector<uint32> expectedConst(constBufferSize, 0xDEADBEEF);
+        std::vector<float> expectedTex(texBufferSize, -7.0f);
+        uint32 expectedBaseInstances[numRenderables];
+
+        scene.hlms->mapTestBuffers(&expectedConst[0], constBufferSize, &expectedTex[0], texBufferSize);
+        for (size_t i = 0; i < numRenderables; ++i)
+        {
+            expectedBaseInstances[i] =
+                scene.hlms->fillBuffersForV2(&scene.cache, scene.queuedRenderables[i], casterPass,
+                                             scene.lastCacheHash, &scene.commandBuffer);
+        }
+        const size_t expectedConstOffset = scene.hlms->getConstBufferOffset();
+        const size_t expectedTexOffset = scene.hlms->getTexBufferOffset();
+
+        std::vector<uint32> batchConst(constBufferSize, 0xDEADBEEF);
+        std::vector<float> batchTex(texBufferSize, -7.0f);
+        uint32 baseInstances[numRenderables];
+
+        scene.hlms->mapTestBuffers(&batchConst[0], constBufferSize, &batchTex[0], texBufferSize);
+        baseInstances[0] = scene.hlms->fillBuffersForV2(&scene.cache, scene.queuedRenderables[0],
+                                                        casterPass, scene.lastCacheHash,
+                                                        &scene.commandBuffer);
+        const size_t numFilled =
+            scene.hlms->fillBuffersForV2Batch(&scene.cache, scene.queuedRenderables + 1,
+                                              numRenderables - 1u, casterPass, baseInstances + 1);
+        CPPUNIT_ASSERT_EQUAL(numRenderables - 1u, numFilled);
+        CPPUNIT_ASSERT_EQUAL(expectedConstOffset, scene.hlms->getConstBufferOffset());
+        CPPUNIT_ASSERT_EQUAL(expectedTexOffset, scene.hlms->getTexBufferOffset());
+
+        for (size_t i = 0; i < numRenderables; ++i)
+        {
+            CPPUNIT_ASSERT_EQUAL(expectedBaseInstances[i], baseInstances[i]);
+
+            // worldMaterialIdx, shadow constant bias, light mask & planar reflection idx
+            for (size_t j = 0; j < 4u; ++j)
+                CPPUNIT_ASSERT_EQUAL(expectedConst[i * 4u + j], batchConst[i * 4u + j]);
+
+            // mat4x3 world (+ padding) is copied as is
+            const float *expected = &expectedTex[i * texFloatsPerDraw];
+            const float *batch = &batchTex[i * texFloatsPerDraw];
+            for (size_t j = 0; j < 16u; ++j)
+                CPPUNIT_ASSERT_EQUAL(expected[j], batch[j]);
+
+            // mat4 worldView is calculated with SIMD instead of concatenateAffine, which
+            // may round differently
+            for (size_t j = 16u; j < texFloatsPerDraw; ++j)
+            {
+                const float tolerance = 1e-5f * std::max(1.0f, std::abs(expected[j]));
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[j], batch[j], tolerance);
+            }
+        }
+
+        for (size_t i = numRenderables * 4u; i < constBufferSize; ++i)
+            CPPUNIT_ASSERT_EQUAL(0xDEADBEEF, batchConst[i]);
+        for (size_t i = numRenderables * texFloatsPerDraw; i < texBufferSize; ++i)
+            CPPUNIT_ASSERT_EQUAL(-7.0f, batchTex[i]);
+
+        scene.hlms->unmapTestBuffers();
+    }
+
+    const uint32 c_noSlot = std::numeric_limits<uint32>::max();
+
+    Matrix4 makeWorldMatrix(Real x)
+    {
+        Matrix4 worldMat;
+        worldMat.makeTransform(Vector3(x, 2.0f * x, 3.0f * x), Vector3::UNIT_SCALE,
+                               Quaternion::IDENTITY);
+        return worldMat;
+    }
+
+    bool matchesSlotMatrix(const StaticInstanceTestHlmsPbs &hlms, uint32 slotIdx,
+                           const Matrix4 &worldMat)
+    {
+        const float *slotData = hlms.getSlotMatrix(slotIdx);
+        for (size_t y = 0; y < 3u; ++y)
+        {
+            for (size_t x = 0; x < 4u; ++x)
+            {
+                if (slotData[y * 4u + x] != static_cast<float>(worldMat[y][x]))
+                    return false;
+            }
+        }
+        return true;
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void HlmsPbsTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void HlmsPbsTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void HlmsPbsTests::testStaticInstanceSlotAllocation()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    ObjectMemoryManager dynamicMemoryManager;
+    ObjectMemoryManager staticMemoryManager;
+    staticMemoryManager._setTwin(SCENE_STATIC, &dynamicMemoryManager);
+    dynamicMemoryManager._setTwin(SCENE_DYNAMIC, &staticMemoryManager);
+
+    TestMovableObject staticObject(&staticMemoryManager);
+    TestMovableObject dynamicObject(&dynamicMemoryManager);
+    TestRenderable renderables[3];
+
+    StaticInstanceTestHlmsPbs hlms;
+    hlms.setStaticInstanceCache(true);
+
+    // The first time the matrix is captured, but must be streamed as it's not on the GPU yet
+    const Matrix4 worldMat0 = makeWorldMatrix(1.0f);
+    const Matrix4 worldMat1 = makeWorldMatrix(2.0f);
+    CPPUNIT_ASSERT_EQUAL(0u, hlms.updateStaticInstanceSlot(&renderables[0], &staticObject, worldMat0));
+    CPPUNIT_ASSERT_EQUAL(0u, hlms.updateStaticInstanceSlot(&renderables[1], &staticObject, worldMat1));
+    CPPUNIT_ASSERT_EQUAL(0u, renderables[0].mHlmsStaticInstanceSlot);
+    CPPUNIT_ASSERT_EQUAL(1u, renderables[1].mHlmsStaticInstanceSlot);
+    CPPUNIT_ASSERT(hlms.isSlotDirty(0u) && hlms.isSlotDirty(1u));
+    CPPUNIT_ASSERT(matchesSlotMatrix(hlms, 0u, worldMat0));
+    CPPUNIT_ASSERT(matchesSlotMatrix(hlms, 1u, worldMat1));
+
+    // Captured again in the same frame (e.g. another pass) before the upload: still streamed
+    CPPUNIT_ASSERT_EQUAL(0u, hlms.updateStaticInstanceSlot(&renderables[0], &staticObject, worldMat0));
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, hlms.getNumSlots());
+
+    // Once uploaded, the slot index + 1 is returned and nothing gets captured again,
+    // even if the matrix passed in changed (static objects need notifyStaticDirty)
+    hlms.markUploaded();
+    CPPUNIT_ASSERT_EQUAL(1u, hlms.updateStaticInstanceSlot(&renderables[0], &staticObject, worldMat1));
+    CPPUNIT_ASSERT_EQUAL(2u, hlms.updateStaticInstanceSlot(&renderables[1], &staticObject, worldMat1));
+    CPPUNIT_ASSERT(!hlms.hasDirtySlots());
+    CPPUNIT_ASSERT(matchesSlotMatrix(hlms, 0u, worldMat0));
+
+    // Dynamic objects never get a slot
+    CPPUNIT_ASSERT_EQUAL(0u, hlms.updateStaticInstanceSlot(&renderables[2], &dynamicObject, worldMat0));
+    CPPUNIT_ASSERT_EQUAL(c_noSlot, renderables[2].mHlmsStaticInstanceSlot);
+
+    // Out of slots: streamed as usual
+    hlms.setMaxSlots(2u);
+    CPPUNIT_ASSERT_EQUAL(0u, hlms.updateStaticInstanceSlot(&renderables[2], &staticObject, worldMat0));
+    CPPUNIT_ASSERT_EQUAL(c_noSlot, renderables[2].mHlmsStaticInstanceSlot);
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, hlms.getNumSlots());
+
+    // Disabling the cache releases every slot
+    hlms.setStaticInstanceCache(false);
+    CPPUNIT_ASSERT_EQUAL(c_noSlot, renderables[0].mHlmsStaticInstanceSlot);
+    CPPUNIT_ASSERT_EQUAL(c_noSlot, renderables[1].mHlmsStaticInstanceSlot);
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, hlms.getNumSlots());
+}
+//--------------------------------------------------------------------------
+void HlmsPbsTests::testStaticInstanceSlotReuse()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    ObjectMemoryManager dynamicMemoryManager;
+    ObjectMemoryManager staticMemoryManager;
+    staticMemoryManager._setTwin(SCENE_STATIC, &dynamicMemoryManager);
+    dynamicMemoryManager._setTwin(SCENE_DYNAMIC, &staticMemoryManager);
+
+    TestMovableObject staticObject(&staticMemoryManager);
+    TestMovableObject dynamicObject(&dynamicMemoryManager);
+    TestRenderable renderables[4];
+
+    StaticInstanceTestHlmsPbs hlms;
+    hlms.setStaticInstanceCache(true);
+
+    const Matrix4 worldMat = makeWorldMatrix(1.0f);
+    for (size_t i = 0; i < 3u; ++i)
+        hlms.updateStaticInstanceSlot(&renderables[i], &staticObject, worldMat);
+    hlms.markUploaded();
+
+    // Released slots go to the free list, and get reused before growing
+    hlms.releaseStaticInstanceSlot(&renderables[1]);
+    CPPUNIT_ASSERT_EQUAL(c_noSlot, renderables[1].mHlmsStaticInstanceSlot);
+    CPPUNIT_ASSERT(!hlms.getSlotOwner(1u));
+
+    const Matrix4 newWorldMat = makeWorldMatrix(5.0f);
+    CPPUNIT_ASSERT_EQUAL(0u, hlms.updateStaticInstanceSlot(&renderables[3], &staticObject, newWorldMat));
+    CPPUNIT_ASSERT_EQUAL(1u, renderables[3].mHlmsStaticInstanceSlot);
+    CPPUNIT_ASSERT(hlms.getSlotOwner(1u) == &renderables[3]);
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, hlms.getNumSlots());
+
+    // The reused slot must not be considered uploaded: it holds the old owner's matrix
+    CPPUNIT_ASSERT(hlms.isSlotDirty(1u));
+    CPPUNIT_ASSERT(matchesSlotMatrix(hlms, 1u, newWorldMat));
+    hlms.markUploaded();
+    CPPUNIT_ASSERT_EQUAL(2u, hlms.updateStaticInstanceSlot(&renderables[3], &staticObject, newWorldMat));
+
+    // An object that became dynamic releases its slot
+    CPPUNIT_ASSERT_EQUAL(0u, hlms.updateStaticInstanceSlot(&renderables[0], &dynamicObject, worldMat));
+    CPPUNIT_ASSERT_EQUAL(c_noSlot, renderables[0].mHlmsStaticInstanceSlot);
+    CPPUNIT_ASSERT(!hlms.getSlotOwner(0u));
+
+    // Unlinking the Renderable from the Hlms releases its slot too
+    hlms._notifyRenderableUnlinked(&renderables[2]);
+    CPPUNIT_ASSERT_EQUAL(c_noSlot, renderables[2].mHlmsStaticInstanceSlot);
+    CPPUNIT_ASSERT(!hlms.getSlotOwner(2u));
+
+    // Last released, first reused
+    CPPUNIT_ASSERT_EQUAL(0u, hlms.updateStaticInstanceSlot(&renderables[1], &staticObject, worldMat));
+    CPPUNIT_ASSERT_EQUAL(2u, renderables[1].mHlmsStaticInstanceSlot);
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, hlms.getNumSlots());
+}
+//--------------------------------------------------------------------------
+void HlmsPbsTests::testStaticInstanceVersionInvalidation()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    ObjectMemoryManager dynamicMemoryManager;
+    ObjectMemoryManager staticMemoryManager;
+    staticMemoryManager._setTwin(SCENE_STATIC, &dynamicMemoryManager);
+    dynamicMemoryManager._setTwin(SCENE_DYNAMIC, &staticMemoryManager);
+
+    TestMovableObject staticObject(&staticMemoryManager);
+    TestRenderable renderables[2];
+
+    StaticInstanceTestHlmsPbs hlms;
+    hlms.setStaticInstanceCache(true);
+
+    const Matrix4 worldMat0 = makeWorldMatrix(1.0f);
+    const Matrix4 worldMat1 = makeWorldMatrix(2.0f);
+    hlms.updateStaticInstanceSlot(&renderables[0], &staticObject, worldMat0);
+    hlms.updateStaticInstanceSlot(&renderables[1], &staticObject, worldMat0);
+    hlms.markUploaded();
+    CPPUNIT_ASSERT_EQUAL(1u, hlms.updateStaticInstanceSlot(&renderables[0], &staticObject, worldMat0));
+
+    // A static object moved. Every slot is stale and must be captured again
+    hlms.notifyStaticDirty();
+    CPPUNIT_ASSERT_EQUAL(0u, hlms.updateStaticInstanceSlot(&renderables[0], &staticObject, worldMat1));
+    CPPUNIT_ASSERT(hlms.isSlotDirty(0u));
+    CPPUNIT_ASSERT(matchesSlotMatrix(hlms, 0u, worldMat1));
+
+    // Slots keep their index across versions
+    CPPUNIT_ASSERT_EQUAL(0u, renderables[0].mHlmsStaticInstanceSlot);
+
+    // Only captured once per version
+    const Matrix4 worldMat2 = makeWorldMatrix(3.0f);
+    CPPUNIT_ASSERT_EQUAL(0u, hlms.updateStaticInstanceSlot(&renderables[0], &staticObject, worldMat2));
+    CPPUNIT_ASSERT(matchesSlotMatrix(hlms, 0u, worldMat1));
+
+    // Slots not drawn since the invalidation are not uploaded, nor considered valid
+    hlms.markUploaded();
+    CPPUNIT_ASSERT_EQUAL(1u, hlms.updateStaticInstanceSlot(&renderables[0], &staticObject, worldMat1));
+    CPPUNIT_ASSERT_EQUAL(0u, hlms.updateStaticInstanceSlot(&renderables[1], &staticObject, worldMat1));
+    CPPUNIT_ASSERT(hlms.isSlotDirty(1u));
+    CPPUNIT_ASSERT(matchesSlotMatrix(hlms, 1u, worldMat1));
+    hlms.markUploaded();
+    CPPUNIT_ASSERT_EQUAL(2u, hlms.updateStaticInstanceSlot(&renderables[1], &staticObject, worldMat1));
+}
+//--------------------------------------------------------------------------
+void HlmsPbsTests::testStaticInstanceCacheGlsles()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    StaticInstanceTestHlmsPbs hlms;
+    hlms.setShaderProfile("glsles");
+
+    bool exceptionThrown = false;
+    try
+    {
+        hlms.setStaticInstanceCache(true);
+    }
+    catch (Exception &e)
+    {
+        exceptionThrown = e.getNumber() == Exception::ERR_NOT_IMPLEMENTED;
+    }
+    CPPUNIT_ASSERT(exceptionThrown);
+    CPPUNIT_ASSERT(!hlms.getStaticInstanceCache());
+
+    // Disabling is always fine
+    hlms.setStaticInstanceCache(false);
+
+    hlms.setShaderProfile("glsl");
+    hlms.setStaticInstanceCache(true);
+    CPPUNIT_ASSERT(hlms.getStaticInstanceCache());
+    hlms.setStaticInstanceCache(false);
+}
+//--------------------------------------------------------------------------
+void HlmsPbsTests::testBatchedFillMatchesPerRenderable()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    BatchFillScene scene;
+    checkBatchMatchesPerRenderable(scene, false);
+    checkBatchMatchesPerRenderable(scene, true);
+}
+//--------------------------------------------------------------------------
+void HlmsPbsTests::testBatchedFillStops()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    BatchFillScene scene;
+    const size_t numRenderables = BatchFillScene::NumRenderables;
+    const size_t texFloatsPerDraw = 32u;
+    std::vector<uint32> constBuffer(4u * 64u);
+    std::vector<float> texBuffer(texFloatsPerDraw * 64u);
+    uint32 baseInstances[numRenderables];
+
+    // Skeletal animation needs fillBuffersForV2
+    scene.renderables[6].setSkeletonAnimation(true);
+    scene.hlms->mapTestBuffers(&constBuffer[0], constBuffer.size(), &texBuffer[0], texBuffer.size());
+    scene.hlms->fillBuffersForV2(&scene.cache, scene.queuedRenderables[0], false,
+                                 scene.lastCacheHash, &scene.commandBuffer);
+    CPPUNIT_ASSERT_EQUAL((size_t)5u,
+                         scene.hlms->fillBuffersForV2Batch(&scene.cache, scene.queuedRenderables + 1,
+                                                           numRenderables - 1u, false, baseInstances));
+    CPPUNIT_ASSERT_EQUAL(5u, baseInstances[4]);
+    scene.renderables[6].setSkeletonAnimation(false);
+
+    // Room for 3 draws in the tex buffer: fillBuffersForV2 would map the next one for the 4th
+    scene.hlms->mapTestBuffers(&constBuffer[0], constBuffer.size(), &texBuffer[0],
+                               texFloatsPerDraw * 4u);
+    scene.hlms->fillBuffersForV2(&scene.cache, scene.queuedRenderables[0], false,
+                                 scene.lastCacheHash, &scene.commandBuffer);
+    CPPUNIT_ASSERT_EQUAL((size_t)2u,
+                         scene.hlms->fillBuffersForV2Batch(&scene.cache, scene.queuedRenderables + 1,
+                                                           numRenderables - 1u, false, baseInstances));
+
+    // Room for 3 draws in the const buffer
+    scene.hlms->mapTestBuffers(&constBuffer[0], 4u * 3u, &texBuffer[0], texBuffer.size());
+    scene.hlms->fillBuffersForV2(&scene.cache, scene.queuedRenderables[0], false,
+                                 scene.lastCacheHash, &scene.commandBuffer);
+    CPPUNIT_ASSERT_EQUAL((size_t)2u,
+                         scene.hlms->fillBuffersForV2Batch(&scene.cache, scene.queuedRenderables + 1,
+                                                           numRenderables - 1u, false, baseInstances));
+    CPPUNIT_ASSERT_EQUAL(2u, baseInstances[1]);
+
+    scene.hlms->unmapTestBuffers();
+}
@@ -49,6 +49,7 @@ class FileSystemArchiveTests : public CppUnit::TestFixture
     CPPUNIT_TEST(testFindFileInfoRecursive);
     CPPUNIT_TEST(testFileRead);
     CPPUNIT_TEST(testReadInterleave);
+    CPPUNIT_TEST(testMemoryMappedRead);
     CPPUNIT_TEST(testCreateAndRemoveFile);
     CPPUNIT_TEST_SUITE_END();
 
@@ -71,6 +72,7 @@ public:
     void testFindFileInfoRecursive();
     void testFileRead();
     void testReadInterleave();
+    void testMemoryMappedRead();
     void testCreateAndRemoveFile();
 };
 
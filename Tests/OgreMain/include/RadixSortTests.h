@@ -42,6 +42,7 @@ class RadixSortTests : public CppUnit::TestFixture
     CPPUNIT_TEST(testIntList);
     CPPUNIT_TEST(testUnsignedIntVector);
     CPPUNIT_TEST(testIntVector);
+    CPPUNIT_TEST(testUint64Vector);
     CPPUNIT_TEST_SUITE_END();
 
 protected:
@@ -56,6 +57,7 @@ public:
     void testIntList();
     void testUnsignedIntVector();
     void testIntVector();
+    void testUint64Vector();
 };
 
 #endif
\ No newline at end of file
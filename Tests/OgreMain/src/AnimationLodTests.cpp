@@ -0,0 +1,363 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "AnimationLodTests.h"
+
+#include "Animation/OgreBone.h"
+#include "Animation/OgreSkeletonAnimation.h"
+#include "Animation/OgreSkeletonDef.h"
+#include "Animation/OgreSkeletonInstance.h"
+#include "OgreAnimation.h"
+#include "OgreAnimationTrack.h"
+#include "OgreKeyFrame.h"
+#include "OgreLodStrategy.h"
+#include "OgreLodStrategyManager.h"
+#include "OgreOldBone.h"
+#include "OgreSkeleton.h"
+#include "Threading/OgreTaskScheduler.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(AnimationLodTests);
+
+// SkeletonAnimationDef::build samples the v1 tracks at mFrame * frameRate, which only
+// lands inside the v1 animation's length when the frame rate is 1
+static const Real c_frameRate = 1;
+static const Real c_timeStep = Real(1.0) / Real(60.0);
+
+/// Converts a value in user units (i.e. distance) to what updateAllLods would notify
+static Real toLodValue(Real userValue)
+{
+    return LodStrategyManager::getSingleton().getDefaultStrategy()->transformUserValue(userValue);
+}
+
+/// Sets up the LOD levels used by most tests: evaluate every 2 frames from
+/// distance 10 onwards, every 4 frames from distance 20 onwards
+static void setDefaultLodLevels(SkeletonInstance *instance)
+{
+    FastArray<Real> lodValues;
+    FastArray<uint16> intervals;
+    lodValues.push_back(10);
+    lodValues.push_back(20);
+    intervals.push_back(2u);
+    intervals.push_back(4u);
+    instance->setAnimationLodLevels(lodValues, intervals);
+}
+
+/// Notifies the same LOD value many times from worker threads, except for
+/// one item which notifies a closer (smaller) value
+class NotifyLodTask : public RangeTask
+{
+    SkeletonInstance *mInstance;
+    size_t mClosestIdx;
+    Real mFarValue;
+    Real mClosestValue;
+
+public:
+    NotifyLodTask(SkeletonInstance *instance, size_t closestIdx, Real farValue, Real closestValue) :
+        mInstance(instance),
+        mClosestIdx(closestIdx),
+        mFarValue(farValue),
+        mClosestValue(closestValue)
+    {
+    }
+
+    void execute(size_t begin, size_t end, size_t threadIdx) override
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            // Vary the far values so that every thread keeps racing to store its own
+            mInstance->_notifyLodValue(i == mClosestIdx ? mClosestValue
+                                                        : mFarValue + Real(i % 64u));
+        }
+    }
+};
+
+//--------------------------------------------------------------------------
+void AnimationLodTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    mLodStrategyManager = 0;
+    if (!LodStrategyManager::getSingletonPtr())
+        mLodStrategyManager = OGRE_NEW LodStrategyManager();
+
+    // One bone moving along X, from 0 to 10 units in one second
+    mOldSkeleton = OGRE_NEW v1::Skeleton(0, "AnimationLodTests", 0, "General");
+    v1::OldBone *oldBone = mOldSkeleton->createBone("Root", 0u);
+    v1::Animation *oldAnimation = mOldSkeleton->createAnimation("Move", Real(1.0));
+    v1::OldNodeAnimationTrack *track = oldAnimation->createOldNodeTrack(0u, oldBone);
+    track->createNodeKeyFrame(0)->setTranslate(Vector3::ZERO);
+    track->createNodeKeyFrame(1)->setTranslate(Vector3(10, 0, 0));
+
+    mSkeletonDef = OGRE_NEW SkeletonDef(mOldSkeleton, c_frameRate);
+}
+//--------------------------------------------------------------------------
+void AnimationLodTests::tearDown()
+{
+    OGRE_DELETE mSkeletonDef;
+    mSkeletonDef = 0;
+    OGRE_DELETE mOldSkeleton;
+    mOldSkeleton = 0;
+    OGRE_DELETE mLodStrategyManager;
+    mLodStrategyManager = 0;
+}
+//--------------------------------------------------------------------------
+SkeletonInstance *AnimationLodTests::createInstance()
+{
+    SkeletonInstance *instance = mSkeletonAnimManager.createSkeletonInstance(mSkeletonDef, 1u);
+    SkeletonAnimation *animation = instance->getAnimation("Move");
+    animation->setEnabled(true);
+    animation->setLoop(false);
+    return instance;
+}
+//--------------------------------------------------------------------------
+void AnimationLodTests::destroyInstance(SkeletonInstance *instance)
+{
+    mSkeletonAnimManager.destroySkeletonInstance(instance);
+}
+//--------------------------------------------------------------------------
+void AnimationLodTests::testIntervalSelection()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    SkeletonInstance *instance = createInstance();
+    setDefaultLodLevels(instance);
+    CPPUNIT_ASSERT_EQUAL((uint16)1u, instance->getAnimationUpdateInterval());
+
+    uint32 lodFrame = 0u;
+
+    // Closer than the first threshold
+    instance->_notifyLodValue(toLodValue(5));
+    instance->_updateWithLod(lodFrame++);
+    CPPUNIT_ASSERT_EQUAL((uint16)1u, instance->getAnimationUpdateInterval());
+
+    // Exactly at a threshold counts as past it
+    instance->_notifyLodValue(toLodValue(10));
+    instance->_updateWithLod(lodFrame++);
+    CPPUNIT_ASSERT_EQUAL((uint16)2u, instance->getAnimationUpdateInterval());
+
+    instance->_notifyLodValue(toLodValue(15));
+    instance->_updateWithLod(lodFrame++);
+    CPPUNIT_ASSERT_EQUAL((uint16)2u, instance->getAnimationUpdateInterval());
+
+    instance->_notifyLodValue(toLodValue(20));
+    instance->_updateWithLod(lodFrame++);
+    CPPUNIT_ASSERT_EQUAL((uint16)4u, instance->getAnimationUpdateInterval());
+
+    instance->_notifyLodValue(toLodValue(1000));
+    instance->_updateWithLod(lodFrame++);
+    CPPUNIT_ASSERT_EQUAL((uint16)4u, instance->getAnimationUpdateInterval());
+
+    // Nothing notified (e.g. all owners got culled): keep the last interval
+    instance->_updateWithLod(lodFrame++);
+    CPPUNIT_ASSERT_EQUAL((uint16)4u, instance->getAnimationUpdateInterval());
+
+    // Coming back closer
+    instance->_notifyLodValue(toLodValue(0));
+    instance->_updateWithLod(lodFrame++);
+    CPPUNIT_ASSERT_EQUAL((uint16)1u, instance->getAnimationUpdateInterval());
+
+    // Changing the levels resets the interval
+    instance->_notifyLodValue(toLodValue(1000));
+    instance->_updateWithLod(lodFrame++);
+    CPPUNIT_ASSERT_EQUAL((uint16)4u, instance->getAnimationUpdateInterval());
+    instance->setAnimationLodLevels(FastArray<Real>(), FastArray<uint16>());
+    CPPUNIT_ASSERT_EQUAL((uint16)1u, instance->getAnimationUpdateInterval());
+    instance->_notifyLodValue(toLodValue(1000));
+    instance->_updateWithLod(lodFrame++);
+    CPPUNIT_ASSERT_EQUAL((uint16)1u, instance->getAnimationUpdateInterval());
+
+    // Mismatched sizes are rejected
+    bool exceptionThrown = false;
+    FastArray<Real> lodValues;
+    lodValues.push_back(10);
+    try
+    {
+        instance->setAnimationLodLevels(lodValues, FastArray<uint16>());
+    }
+    catch (Exception &)
+    {
+        exceptionThrown = true;
+    }
+    CPPUNIT_ASSERT(exceptionThrown);
+
+    destroyInstance(instance);
+}
+//--------------------------------------------------------------------------
+void AnimationLodTests::testSharedInstanceUsesClosest()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    SkeletonInstance *instance = createInstance();
+    setDefaultLodLevels(instance);
+
+    uint32 lodFrame = 0u;
+
+    // Several MovableObjects sharing the instance: the closest one wins,
+    // regardless of the order in which they get notified
+    instance->_notifyLodValue(toLodValue(25));
+    instance->_notifyLodValue(toLodValue(5));
+    instance->_notifyLodValue(toLodValue(15));
+    instance->_updateWithLod(lodFrame++);
+    CPPUNIT_ASSERT_EQUAL((uint16)1u, instance->getAnimationUpdateInterval());
+
+    instance->_notifyLodValue(toLodValue(15));
+    instance->_notifyLodValue(toLodValue(25));
+    instance->_updateWithLod(lodFrame++);
+    CPPUNIT_ASSERT_EQUAL((uint16)2u, instance->getAnimationUpdateInterval());
+
+    // The pending value must not leak into the next frame
+    instance->_notifyLodValue(toLodValue(25));
+    instance->_updateWithLod(lodFrame++);
+    CPPUNIT_ASSERT_EQUAL((uint16)4u, instance->getAnimationUpdateInterval());
+
+    destroyInstance(instance);
+}
+//--------------------------------------------------------------------------
+void AnimationLodTests::testNotifyLodValueMultithreaded()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    SkeletonInstance *instance = createInstance();
+    setDefaultLodLevels(instance);
+
+    TaskScheduler taskScheduler(4u);
+
+    const size_t numItems = 20000u;
+    uint32 lodFrame = 0u;
+
+    for (size_t i = 0u; i < 16u; ++i)
+    {
+        // Alternate between the closest value landing in the first interval and in
+        // the second one; a lost update would leave the interval at 4
+        const Real closestValue = toLodValue((i & 0x01u) ? Real(15) : Real(5));
+        const uint16 expectedInterval = (i & 0x01u) ? 2u : 1u;
+
+        NotifyLodTask task(instance, (i * 7919u) % numItems, toLodValue(1000), closestValue);
+        taskScheduler.addTask(&task, numItems, 16u);
+        taskScheduler.waitForAll();
+
+        instance->_updateWithLod(lodFrame++);
+        CPPUNIT_ASSERT_EQUAL(expectedInterval, instance->getAnimationUpdateInterval());
+    }
+
+    destroyInstance(instance);
+}
+//--------------------------------------------------------------------------
+void AnimationLodTests::testEvaluationFrequency()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    SkeletonInstance *instance = createInstance();
+    setDefaultLodLevels(instance);
+    SkeletonAnimation *animation = instance->getAnimation("Move");
+    Bone *bone = instance->getBone((size_t)0u);
+
+    Real lastX = 0;
+    for (uint32 lodFrame = 0u; lodFrame < 16u; ++lodFrame)
+    {
+        animation->addTime(c_timeStep);
+        instance->_notifyLodValue(toLodValue(25));
+        instance->_updateWithLod(lodFrame);
+
+        const Real x = bone->getPosition().x;
+        if (lodFrame % 4u)
+        {
+            // Not evaluated: the bone keeps the last pose
+            CPPUNIT_ASSERT_EQUAL(lastX, x);
+        }
+        else if (lodFrame)
+        {
+            CPPUNIT_ASSERT(x > lastX);
+        }
+        lastX = x;
+    }
+
+    // Animation time kept advancing while evaluations were skipped
+    CPPUNIT_ASSERT(Math::RealEqual(Real(16) * c_timeStep * c_frameRate,
+                                   animation->getCurrentFrame(), Real(1e-3)));
+
+    destroyInstance(instance);
+}
+//--------------------------------------------------------------------------
+void AnimationLodTests::testBlendLodPoses()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // The reference gets evaluated every frame
+    SkeletonInstance *reference = createInstance();
+    SkeletonInstance *instance = createInstance();
+    setDefaultLodLevels(instance);
+    instance->setAnimationLodInterpolation(true);
+    CPPUNIT_ASSERT(instance->getAnimationLodInterpolation());
+
+    SkeletonAnimation *refAnimation = reference->getAnimation("Move");
+    SkeletonAnimation *animation = instance->getAnimation("Move");
+    Bone *refBone = reference->getBone((size_t)0u);
+    Bone *bone = instance->getBone((size_t)0u);
+
+    const uint32 numFrames = 16u;
+    Vector3 refPositions[numFrames];
+
+    for (uint32 lodFrame = 0u; lodFrame < numFrames; ++lodFrame)
+    {
+        refAnimation->addTime(c_timeStep);
+        animation->addTime(c_timeStep);
+        reference->update();
+        instance->_notifyLodValue(toLodValue(25));
+        instance->_updateWithLod(lodFrame);
+        CPPUNIT_ASSERT_EQUAL((uint16)4u, instance->getAnimationUpdateInterval());
+
+        refPositions[lodFrame] = refBone->getPosition();
+        const Vector3 position = bone->getPosition();
+
+        // Interpolation lags one interval behind: it blends from the second to last
+        // evaluated pose towards the last one
+        const uint32 lastEval = lodFrame - lodFrame % 4u;
+        Vector3 expected;
+        if (lastEval == 0u)
+        {
+            expected = refPositions[0];
+        }
+        else
+        {
+            const Real w = Real(lodFrame - lastEval) / Real(4);
+            expected = Math::lerp(refPositions[lastEval - 4u], refPositions[lastEval], w);
+        }
+
+        CPPUNIT_ASSERT(expected.positionEquals(position, Real(1e-4)));
+    }
+
+    destroyInstance(instance);
+    destroyInstance(reference);
+}
+//--------------------------------------------------------------------------
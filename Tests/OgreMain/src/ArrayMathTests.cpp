@@ -0,0 +1,367 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "ArrayMathTests.h"
+
+#include "Math/Array/OgreArrayAabb.h"
+#include "Math/Array/OgreArrayMatrix4.h"
+#include "Math/Array/OgreArrayMatrixAf4x3.h"
+#include "Math/Array/OgreArrayQuaternion.h"
+#include "Math/Array/OgreArrayVector3.h"
+#include "Math/Array/OgreBooleanMask.h"
+#include "Math/Array/OgreMathlib.h"
+#include "Math/Simple/OgreAabb.h"
+#include "OgreMatrix4.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ArrayMathTests);
+
+static const Real c_epsilon = 1e-4f;
+static const size_t c_numIterations = 64u;
+
+//--------------------------------------------------------------------------
+static Real randomReal(Real minVal, Real maxVal)
+{
+    return minVal + (maxVal - minVal) * (Real(rand()) / Real(RAND_MAX));
+}
+//--------------------------------------------------------------------------
+static Vector3 randomVector3(Real minVal, Real maxVal)
+{
+    return Vector3(randomReal(minVal, maxVal), randomReal(minVal, maxVal),
+                   randomReal(minVal, maxVal));
+}
+//--------------------------------------------------------------------------
+static Quaternion randomQuaternion()
+{
+    Vector3 axis = randomVector3(-1.0f, 1.0f);
+    if (axis.isZeroLength())
+        axis = Vector3::UNIT_Y;
+    axis.normalise();
+    return Quaternion(Radian(randomReal(-Math::PI, Math::PI)), axis);
+}
+//--------------------------------------------------------------------------
+static Matrix4 randomAffineMatrix()
+{
+    Matrix4 retVal;
+    retVal.makeTransform(randomVector3(-100.0f, 100.0f), randomVector3(0.25f, 4.0f),
+                         randomQuaternion());
+    return retVal;
+}
+//--------------------------------------------------------------------------
+/// Relative tolerance so that large values (e.g. translations) don't fail due to precision
+static void assertRealEqual(Real expected, Real actual)
+{
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(expected, actual,
+                                 c_epsilon * std::max(Real(1.0f), Math::Abs(expected)));
+}
+//--------------------------------------------------------------------------
+static void assertMatrixEqual(const Matrix4 &expected, const Matrix4 &actual)
+{
+    for (size_t row = 0; row < 4u; ++row)
+    {
+        for (size_t col = 0; col < 4u; ++col)
+            assertRealEqual(expected[row][col], actual[row][col]);
+    }
+}
+//--------------------------------------------------------------------------
+static void assertVectorEqual(const Vector3 &expected, const Vector3 &actual)
+{
+    assertRealEqual(expected.x, actual.x);
+    assertRealEqual(expected.y, actual.y);
+    assertRealEqual(expected.z, actual.z);
+}
+//--------------------------------------------------------------------------
+static void assertQuaternionEqual(const Quaternion &expected, const Quaternion &actual)
+{
+    assertRealEqual(expected.w, actual.w);
+    assertRealEqual(expected.x, actual.x);
+    assertRealEqual(expected.y, actual.y);
+    assertRealEqual(expected.z, actual.z);
+}
+//--------------------------------------------------------------------------
+static void assertAabbEqual(const Aabb &expected, const Aabb &actual)
+{
+    assertVectorEqual(expected.mCenter, actual.mCenter);
+    assertVectorEqual(expected.mHalfSize, actual.mHalfSize);
+}
+//--------------------------------------------------------------------------
+void ArrayMathTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+}
+//--------------------------------------------------------------------------
+void ArrayMathTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void ArrayMathTests::testArrayMatrix4()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    for (size_t iteration = 0; iteration < c_numIterations; ++iteration)
+    {
+        Matrix4 lhs[ARRAY_PACKED_REALS];
+        Matrix4 rhs[ARRAY_PACKED_REALS];
+        Vector3 position[ARRAY_PACKED_REALS];
+        Vector3 scale[ARRAY_PACKED_REALS];
+        Quaternion orientation[ARRAY_PACKED_REALS];
+        Vector3 point[ARRAY_PACKED_REALS];
+
+        ArrayMatrix4 aLhs, aRhs;
+        ArrayVector3 aPosition, aScale, aPoint;
+        ArrayQuaternion aOrientation;
+
+        for (size_t i = 0; i < ARRAY_PACKED_REALS; ++i)
+        {
+            lhs[i] = randomAffineMatrix();
+            rhs[i] = randomAffineMatrix();
+            position[i] = randomVector3(-100.0f, 100.0f);
+            scale[i] = randomVector3(0.25f, 4.0f);
+            orientation[i] = randomQuaternion();
+            point[i] = randomVector3(-10.0f, 10.0f);
+
+            aLhs.setFromMatrix4(lhs[i], i);
+            aRhs.setFromMatrix4(rhs[i], i);
+            aPosition.setFromVector3(position[i], i);
+            aScale.setFromVector3(scale[i], i);
+            aOrientation.setFromQuaternion(orientation[i], i);
+            aPoint.setFromVector3(point[i], i);
+        }
+
+        const ArrayMatrix4 aProduct = aLhs * aRhs;
+        const ArrayVector3 aTransformed = aLhs * aPoint;
+        ArrayMatrix4 aTransform;
+        aTransform.makeTransform(aPosition, aScale, aOrientation);
+
+        // Round trip through the AoS conversions
+        OGRE_SIMD_ALIGNED_DECL(Matrix4, aos[ARRAY_PACKED_REALS]);
+        aLhs.storeToAoS(aos);
+        ArrayMatrix4 aRoundTrip;
+        aRoundTrip.loadFromAoS(aos);
+
+        for (size_t i = 0; i < ARRAY_PACKED_REALS; ++i)
+        {
+            Matrix4 result;
+
+            aProduct.getAsMatrix4(result, i);
+            assertMatrixEqual(lhs[i] * rhs[i], result);
+
+            assertVectorEqual(lhs[i] * point[i], aTransformed.getAsVector3(i));
+
+            Matrix4 transform;
+            transform.makeTransform(position[i], scale[i], orientation[i]);
+            aTransform.getAsMatrix4(result, i);
+            assertMatrixEqual(transform, result);
+
+            assertMatrixEqual(lhs[i], aos[i]);
+            aRoundTrip.getAsMatrix4(result, i);
+            assertMatrixEqual(lhs[i], result);
+        }
+    }
+}
+//--------------------------------------------------------------------------
+void ArrayMathTests::testArrayMatrixAf4x3()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    for (size_t iteration = 0; iteration < c_numIterations; ++iteration)
+    {
+        OGRE_SIMD_ALIGNED_DECL(Matrix4, lhs[ARRAY_PACKED_REALS]);
+        OGRE_SIMD_ALIGNED_DECL(Matrix4, rhs[ARRAY_PACKED_REALS]);
+        Vector3 point[ARRAY_PACKED_REALS];
+        ArrayVector3 aPoint;
+
+        for (size_t i = 0; i < ARRAY_PACKED_REALS; ++i)
+        {
+            lhs[i] = randomAffineMatrix();
+            rhs[i] = randomAffineMatrix();
+            point[i] = randomVector3(-10.0f, 10.0f);
+            aPoint.setFromVector3(point[i], i);
+        }
+
+        ArrayMatrixAf4x3 aLhs, aRhs;
+        aLhs.loadFromAoS(lhs);
+        aRhs.loadFromAoS(rhs);
+
+        const ArrayVector3 aTransformed = aLhs * aPoint;
+        ArrayMatrixAf4x3 aProduct = aLhs;
+        aProduct *= aRhs;
+        ArrayMatrixAf4x3 aInverse = aLhs;
+        aInverse.setToInverse();
+
+        OGRE_SIMD_ALIGNED_DECL(Matrix4, product[ARRAY_PACKED_REALS]);
+        OGRE_SIMD_ALIGNED_DECL(Matrix4, inverse[ARRAY_PACKED_REALS]);
+        aProduct.streamToAoS(product);
+        aInverse.streamToAoS(inverse);
+
+        for (size_t i = 0; i < ARRAY_PACKED_REALS; ++i)
+        {
+            assertVectorEqual(lhs[i].transformAffine(point[i]), aTransformed.getAsVector3(i));
+            assertMatrixEqual(lhs[i].concatenateAffine(rhs[i]), product[i]);
+            assertMatrixEqual(lhs[i].inverseAffine(), inverse[i]);
+        }
+    }
+}
+//--------------------------------------------------------------------------
+void ArrayMathTests::testArrayQuaternion()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const Real t = 0.3f;
+    const ArrayReal aT = Mathlib::SetAll(t);
+
+    for (size_t iteration = 0; iteration < c_numIterations; ++iteration)
+    {
+        Quaternion p[ARRAY_PACKED_REALS];
+        Quaternion q[ARRAY_PACKED_REALS];
+        Vector3 v[ARRAY_PACKED_REALS];
+
+        ArrayQuaternion aP, aQ;
+        ArrayVector3 aV;
+
+        for (size_t i = 0; i < ARRAY_PACKED_REALS; ++i)
+        {
+            p[i] = randomQuaternion();
+            q[i] = randomQuaternion();
+            v[i] = randomVector3(-10.0f, 10.0f);
+
+            // ArrayQuaternion::Slerp flips rkQ for the shortest path but keeps using the
+            // unflipped angle, so it only matches the scalar version when Dot >= 0
+            if (p[i].Dot(q[i]) < 0.0f)
+                q[i] = -q[i];
+
+            aP.setFromQuaternion(p[i], i);
+            aQ.setFromQuaternion(q[i], i);
+            aV.setFromVector3(v[i], i);
+        }
+
+        const ArrayQuaternion aProduct = aP * aQ;
+        const ArrayVector3 aRotated = aP * aV;
+        const ArrayQuaternion aSlerp = ArrayQuaternion::Slerp(aT, aP, aQ);
+        const ArrayQuaternion aNlerp = ArrayQuaternion::nlerp(aT, aP, aQ);
+        const ArrayQuaternion aNlerpShortest = ArrayQuaternion::nlerpShortest(aT, aP, aQ);
+        const ArrayQuaternion aInverse = aP.Inverse();
+
+        for (size_t i = 0; i < ARRAY_PACKED_REALS; ++i)
+        {
+            Quaternion result;
+
+            aProduct.getAsQuaternion(result, i);
+            assertQuaternionEqual(p[i] * q[i], result);
+
+            assertVectorEqual(p[i] * v[i], aRotated.getAsVector3(i));
+
+            aSlerp.getAsQuaternion(result, i);
+            assertQuaternionEqual(Quaternion::Slerp(t, p[i], q[i], true), result);
+
+            aNlerp.getAsQuaternion(result, i);
+            assertQuaternionEqual(Quaternion::nlerp(t, p[i], q[i], false), result);
+
+            aNlerpShortest.getAsQuaternion(result, i);
+            assertQuaternionEqual(Quaternion::nlerp(t, p[i], q[i], true), result);
+
+            aInverse.getAsQuaternion(result, i);
+            assertQuaternionEqual(p[i].Inverse(), result);
+        }
+    }
+}
+//--------------------------------------------------------------------------
+void ArrayMathTests::testArrayAabb()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    for (size_t iteration = 0; iteration < c_numIterations; ++iteration)
+    {
+        Aabb a[ARRAY_PACKED_REALS];
+        Aabb b[ARRAY_PACKED_REALS];
+        Vector3 point[ARRAY_PACKED_REALS];
+        Matrix4 transform[ARRAY_PACKED_REALS];
+
+        ArrayAabb aA, aB;
+        ArrayVector3 aPoint;
+        ArrayMatrix4 aTransform;
+
+        for (size_t i = 0; i < ARRAY_PACKED_REALS; ++i)
+        {
+            a[i] = Aabb(randomVector3(-10.0f, 10.0f), randomVector3(0.5f, 5.0f));
+            b[i] = Aabb(randomVector3(-10.0f, 10.0f), randomVector3(0.5f, 5.0f));
+            point[i] = randomVector3(-10.0f, 10.0f);
+            transform[i] = randomAffineMatrix();
+
+            aA.setFromAabb(a[i], i);
+            aB.setFromAabb(b[i], i);
+            aPoint.setFromVector3(point[i], i);
+            aTransform.setFromMatrix4(transform[i], i);
+        }
+
+        const uint32 intersects = BooleanMask4::getScalarMask(aA.intersects(aB));
+        const uint32 containsAabb = BooleanMask4::getScalarMask(aA.contains(aB));
+        const uint32 containsPoint = BooleanMask4::getScalarMask(aA.contains(aPoint));
+        const ArrayReal aDistance = aA.distance(aPoint);
+
+        ArrayAabb aMerged = aA;
+        aMerged.merge(aB);
+        ArrayAabb aTransformed = aA;
+        aTransformed.transformAffine(aTransform);
+
+        OGRE_ALIGNED_DECL(Real, distance[ARRAY_PACKED_REALS], OGRE_SIMD_ALIGNMENT);
+        CastArrayToReal(distance, aDistance);
+
+        for (size_t i = 0; i < ARRAY_PACKED_REALS; ++i)
+        {
+            const uint32 laneBit = 1u << i;
+            CPPUNIT_ASSERT_EQUAL(a[i].intersects(b[i]), (intersects & laneBit) != 0);
+            CPPUNIT_ASSERT_EQUAL(a[i].contains(b[i]), (containsAabb & laneBit) != 0);
+            CPPUNIT_ASSERT_EQUAL(a[i].contains(point[i]), (containsPoint & laneBit) != 0);
+            assertRealEqual(a[i].distance(point[i]), distance[i]);
+
+            Aabb result;
+
+            Aabb merged = a[i];
+            merged.merge(b[i]);
+            aMerged.getAsAabb(result, i);
+            assertAabbEqual(merged, result);
+
+            Aabb transformed = a[i];
+            transformed.transformAffine(transform[i]);
+            aTransformed.getAsAabb(result, i);
+            assertAabbEqual(transformed, result);
+        }
+    }
+
+#if OGRE_CPU == OGRE_CPU_X86 && OGRE_USE_SIMD == 1 && OGRE_USE_SIMD_AVX == 1 && \
+    OGRE_DOUBLE_PRECISION == 0
+    // One bit per lane, as returned by getScalarMask
+    CPPUNIT_ASSERT_EQUAL((uint32)MASK_ALL_BITS_SET,
+                         BooleanMask4::getScalarMask(BooleanMask4::getAllSetMask()));
+#endif
+}
@@ -0,0 +1,331 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "ArrayMemoryManagerTests.h"
+
+#include "Math/Array/OgreArrayMemoryManager.h"
+#include "Math/Array/OgreNodeMemoryManager.h"
+#include "OgreCommon.h"
+#include "OgreException.h"
+#include "OgreSceneNode.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ArrayMemoryManagerTests);
+
+namespace
+{
+    /// Listener that doesn't support incremental defragmentation (like bones)
+    class OrderedListener : public ArrayMemoryManager::RebaseListener
+    {
+    public:
+        size_t numCleanups;
+
+        OrderedListener() : numCleanups(0) {}
+
+        void buildDiffList(uint16, const MemoryPoolVec &, ArrayMemoryManager::PtrdiffVec &) override
+        {
+        }
+        void applyRebase(uint16, const MemoryPoolVec &, const ArrayMemoryManager::PtrdiffVec &) override
+        {
+        }
+        void performCleanup(uint16, const MemoryPoolVec &, size_t const *, size_t, size_t) override
+        {
+            ++numCleanups;
+        }
+    };
+
+    class SlotMovedListener : public OrderedListener
+    {
+    public:
+        std::vector<size_t> movedSlots;
+
+        void slotMoved(uint16, const MemoryPoolVec &, size_t dstSlot) override
+        {
+            movedSlots.push_back(dstSlot);
+        }
+    };
+
+    /// Manager with a single flat uint32 per slot, so we can follow where each slot went
+    class IdArrayMemoryManager : public ArrayMemoryManager
+    {
+        static const size_t          ElementsMemSize[1];
+        static const CleanupRoutines IdCleanupRoutines[1];
+
+    public:
+        IdArrayMemoryManager(size_t cleanupThreshold, RebaseListener *rebaseListener) :
+            ArrayMemoryManager(ElementsMemSize, 0, IdCleanupRoutines, 1u, 0u, 64u, cleanupThreshold,
+                               MAX_MEMORY_SLOTS, rebaseListener)
+        {
+        }
+
+        uint32 *getIds() { return reinterpret_cast<uint32 *>(mMemoryPools[0]); }
+
+        size_t createSlot(uint32 id)
+        {
+            const size_t slot = createNewSlot();
+            getIds()[slot] = id;
+            return slot;
+        }
+
+        void destroySlotIdx(size_t slot)
+        {
+            // Same as the other managers: pointer to the first element in the pack, plus the index
+            const size_t packStart = slot - slot % ARRAY_PACKED_REALS;
+            destroySlot(mMemoryPools[0] + packStart * ElementsMemSize[0],
+                        static_cast<uint8>(slot % ARRAY_PACKED_REALS));
+        }
+    };
+
+    const size_t IdArrayMemoryManager::ElementsMemSize[1] = { sizeof(uint32) };
+    const CleanupRoutines IdArrayMemoryManager::IdCleanupRoutines[1] = { cleanerFlat };
+}  // namespace
+
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::testFragmentationMetrics()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    SlotMovedListener listener;
+    IdArrayMemoryManager mgr(100u, &listener);
+    mgr.initialize();
+
+    for (uint32 i = 0; i < 10u; ++i)
+        mgr.createSlot(i);
+
+    const size_t numLanes = alignToNextMultiple<size_t>(10u, ARRAY_PACKED_REALS);
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, mgr.getNumFragmentedSlots());
+    CPPUNIT_ASSERT_EQUAL(numLanes - 10u, mgr.getNumWastedSimdLanes());
+
+    // Holes in the middle
+    mgr.destroySlotIdx(2u);
+    mgr.destroySlotIdx(5u);
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, mgr.getNumFragmentedSlots());
+    CPPUNIT_ASSERT_EQUAL(numLanes - 8u, mgr.getNumWastedSimdLanes());
+    CPPUNIT_ASSERT_EQUAL((size_t)10u, mgr.getNumUsedSlotsIncludingFragmented());
+
+    // LIFO removal doesn't leave a hole
+    mgr.destroySlotIdx(9u);
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, mgr.getNumFragmentedSlots());
+    CPPUNIT_ASSERT_EQUAL((size_t)9u, mgr.getNumUsedSlotsIncludingFragmented());
+    CPPUNIT_ASSERT_EQUAL(alignToNextMultiple<size_t>(9u, ARRAY_PACKED_REALS) - 7u,
+                         mgr.getNumWastedSimdLanes());
+
+    // Holes get reused first
+    const size_t reused = mgr.createSlot(100u);
+    CPPUNIT_ASSERT(reused == 2u || reused == 5u);
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, mgr.getNumFragmentedSlots());
+
+    mgr.destroy();
+}
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::testDefragmentIncremental()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    SlotMovedListener listener;
+    IdArrayMemoryManager mgr(100u, &listener);
+    mgr.initialize();
+    mgr.setIncrementalDefragment(true);
+
+    for (uint32 i = 0; i < 10u; ++i)
+        mgr.createSlot(100u + i);
+
+    mgr.destroySlotIdx(1u);
+    mgr.destroySlotIdx(3u);
+    mgr.destroySlotIdx(4u);
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, mgr.getNumFragmentedSlots());
+
+    // The budget is respected: the last slot goes into the lowest hole
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, mgr.defragmentIncremental(1u));
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, listener.movedSlots.size());
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, listener.movedSlots[0]);
+    CPPUNIT_ASSERT_EQUAL((uint32)109u, mgr.getIds()[1]);
+    CPPUNIT_ASSERT_EQUAL((uint32)0u, mgr.getIds()[9]);
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, mgr.getNumFragmentedSlots());
+    CPPUNIT_ASSERT_EQUAL((size_t)9u, mgr.getNumUsedSlotsIncludingFragmented());
+
+    // Finish the job with a bigger budget
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, mgr.defragmentIncremental(10u));
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, listener.movedSlots.size());
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, listener.movedSlots[1]);
+    CPPUNIT_ASSERT_EQUAL((size_t)4u, listener.movedSlots[2]);
+
+    const uint32 expectedIds[7] = { 100u, 109u, 102u, 108u, 107u, 105u, 106u };
+    for (size_t i = 0; i < 7u; ++i)
+        CPPUNIT_ASSERT_EQUAL(expectedIds[i], mgr.getIds()[i]);
+
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, mgr.getNumFragmentedSlots());
+    CPPUNIT_ASSERT_EQUAL((size_t)7u, mgr.getNumUsedSlotsIncludingFragmented());
+    CPPUNIT_ASSERT_EQUAL(alignToNextMultiple<size_t>(7u, ARRAY_PACKED_REALS) - 7u,
+                         mgr.getNumWastedSimdLanes());
+
+    // Nothing left to do
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, mgr.defragmentIncremental(10u));
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, listener.numCleanups);
+
+    mgr.destroy();
+}
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::testTrailingHolesAreFree()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    SlotMovedListener listener;
+    IdArrayMemoryManager mgr(100u, &listener);
+    mgr.initialize();
+
+    for (uint32 i = 0; i < 8u; ++i)
+        mgr.createSlot(i);
+
+    mgr.destroySlotIdx(5u);
+    mgr.destroySlotIdx(6u);
+    mgr.destroySlotIdx(7u);
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, mgr.getNumFragmentedSlots());
+    CPPUNIT_ASSERT_EQUAL((size_t)7u, mgr.getNumUsedSlotsIncludingFragmented());
+
+    // Holes at the end are released even with no budget at all
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, mgr.defragmentIncremental(0u));
+    CPPUNIT_ASSERT(listener.movedSlots.empty());
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, mgr.getNumFragmentedSlots());
+    CPPUNIT_ASSERT_EQUAL((size_t)5u, mgr.getNumUsedSlotsIncludingFragmented());
+
+    mgr.destroy();
+}
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::testIncrementalModeSkipsFullDefragment()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    SlotMovedListener listener;
+    IdArrayMemoryManager mgr(2u, &listener);
+    mgr.initialize();
+    mgr.setIncrementalDefragment(true);
+
+    for (uint32 i = 0; i < 10u; ++i)
+        mgr.createSlot(i);
+
+    // Going past the cleanup threshold must not defragment everything at once
+    mgr.destroySlotIdx(0u);
+    mgr.destroySlotIdx(2u);
+    mgr.destroySlotIdx(4u);
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, listener.numCleanups);
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, mgr.getNumFragmentedSlots());
+
+    // Back to the regular behaviour
+    mgr.setIncrementalDefragment(false);
+    mgr.destroySlotIdx(6u);
+    CPPUNIT_ASSERT(listener.numCleanups > 0u);
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, mgr.getNumFragmentedSlots());
+    CPPUNIT_ASSERT(listener.movedSlots.empty());
+
+    mgr.destroy();
+}
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::testDefaultSlotMovedThrows()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Listeners that need slots to keep their order (i.e. bones) don't
+    // override slotMoved; they can't be defragmented incrementally
+    OrderedListener listener;
+    IdArrayMemoryManager mgr(100u, &listener);
+    mgr.initialize();
+
+    for (uint32 i = 0; i < 4u; ++i)
+        mgr.createSlot(i);
+    mgr.destroySlotIdx(0u);
+
+    bool exceptionThrown = false;
+    try
+    {
+        mgr.defragmentIncremental(1u);
+    }
+    catch (Exception &e)
+    {
+        exceptionThrown = e.getNumber() == Exception::ERR_NOT_IMPLEMENTED;
+    }
+    CPPUNIT_ASSERT(exceptionThrown);
+
+    mgr.destroy();
+}
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::testNodeSlotMoved()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    NodeMemoryManager nodeMemoryManager;
+    nodeMemoryManager.setIncrementalDefragment(true);
+
+    const size_t numNodes = 6u;
+    SceneNode *nodes[numNodes];
+    for (size_t i = 0; i < numNodes; ++i)
+    {
+        nodes[i] = new SceneNode(i + 1u, 0, &nodeMemoryManager, 0);
+        nodes[i]->setPosition(Vector3(Real(i), 0, 0));
+    }
+
+    delete nodes[1];
+    nodes[1] = 0;
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, nodeMemoryManager.getNumFragmentedSlots(0u));
+
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, nodeMemoryManager.defragmentIncremental(10u));
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, nodeMemoryManager.getNumFragmentedSlots(0u));
+
+    // The last node now lives in the hole, and knows about it
+    Transform firstTransform;
+    nodeMemoryManager.getFirstNode(firstTransform, 0u);
+    const Transform &movedTransform = nodes[5]->_getTransform();
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, (size_t)movedTransform.mIndex);
+    CPPUNIT_ASSERT(movedTransform.mPosition == firstTransform.mPosition);
+    CPPUNIT_ASSERT(movedTransform.mOwner[movedTransform.mIndex] == nodes[5]);
+    CPPUNIT_ASSERT_EQUAL(Vector3(5, 0, 0), nodes[5]->getPosition());
+
+    // Every other node is untouched
+    for (size_t i = 0; i < numNodes - 1u; ++i)
+    {
+        if (nodes[i])
+            CPPUNIT_ASSERT_EQUAL(Vector3(Real(i), 0, 0), nodes[i]->getPosition());
+    }
+
+    for (size_t i = 0; i < numNodes; ++i)
+        delete nodes[i];
+}
+//--------------------------------------------------------------------------
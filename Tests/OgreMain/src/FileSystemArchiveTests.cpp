@@ -332,6 +332,56 @@ void FileSystemArchiveTests::testReadInterleave()
     CPPUNIT_ASSERT(stream2->eof());
 }
 //--------------------------------------------------------------------------
+void FileSystemArchiveTests::testMemoryMappedRead()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    if (!MmapDataStream::isSupported())
+        return;
+
+    FileSystemArchive arch(mTestPath, "FileSystem", true);
+    arch.load();
+
+    DataStreamPtr fileStream = arch.open("rootfile.txt");
+    FileSystemArchive::setUseMemoryMapping(true);
+    DataStreamPtr stream = arch.open("rootfile.txt");
+    FileSystemArchive::setUseMemoryMapping(false);
+
+    MmapDataStream *mmapStream = dynamic_cast<MmapDataStream*>(stream.get());
+    CPPUNIT_ASSERT(mmapStream != 0);
+    CPPUNIT_ASSERT(dynamic_cast<MmapDataStream*>(fileStream.get()) == 0);
+    CPPUNIT_ASSERT_EQUAL(fileStream->size(), stream->size());
+
+    // Same contents, readable in place
+    const String contents = fileStream->getAsString();
+    CPPUNIT_ASSERT(stream->getCurrentReadPtr() == mmapStream->getPtr());
+    CPPUNIT_ASSERT(memcmp(mmapStream->getPtr(), contents.c_str(), contents.size()) == 0);
+
+    CPPUNIT_ASSERT_EQUAL(String("this is line 1 in file 1"), stream->getLine());
+    CPPUNIT_ASSERT_EQUAL(String("this is line 2 in file 1"), stream->getLine());
+    stream->skipLine();
+    CPPUNIT_ASSERT_EQUAL(String("this is line 4 in file 1"), stream->getLine());
+
+    // Seeking and skipping move the read pointer within the mapping
+    char buf[8];
+    stream->seek(5);
+    CPPUNIT_ASSERT_EQUAL((size_t)2, stream->read(buf, 2));
+    CPPUNIT_ASSERT(memcmp(buf, "is", 2) == 0);
+    CPPUNIT_ASSERT_EQUAL((size_t)7, stream->tell());
+    stream->skip(-2);
+    CPPUNIT_ASSERT_EQUAL((size_t)5, stream->tell());
+    CPPUNIT_ASSERT(stream->getCurrentReadPtr() == mmapStream->getPtr() + 5);
+
+    // Reads are clamped to the end of the file
+    stream->seek(stream->size() - 3);
+    CPPUNIT_ASSERT_EQUAL((size_t)3, stream->read(buf, sizeof(buf)));
+    CPPUNIT_ASSERT(memcmp(buf, contents.c_str() + contents.size() - 3, 3) == 0);
+    CPPUNIT_ASSERT(stream->eof());
+
+    stream->close();
+    CPPUNIT_ASSERT(mmapStream->getPtr() == 0);
+}
+//--------------------------------------------------------------------------
 void FileSystemArchiveTests::testCreateAndRemoveFile()
 {
     UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
@@ -0,0 +1,243 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "ForwardClusteredBinningTests.h"
+
+#include "OgreCamera.h"
+#include "OgreForwardClustered.h"
+#include "OgreLight.h"
+#include "OgreNULLRenderSystem.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreViewport.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ForwardClusteredBinningTests);
+
+namespace
+{
+    const uint32 c_gridWidth = 16u;
+    const uint32 c_gridHeight = 8u;
+    const uint32 c_gridSlices = 24u;
+    const uint32 c_lightsPerCell = 96u;
+    /// 3 light counts + the lights. No decals nor cubemap probes
+    const size_t c_objsPerCell = 3u + c_lightsPerCell;
+
+    /// Keeps the CPU grid around (ForwardPlusBase builds it there when compacting)
+    class TestForwardClustered : public ForwardClustered
+    {
+    public:
+        TestForwardClustered(SceneManager *sceneManager, bool lightCellRangeBinning) :
+            ForwardClustered(c_gridWidth, c_gridHeight, c_gridSlices, c_lightsPerCell, 0u, 0u,
+                             3.0f, 200.0f, sceneManager)
+        {
+            setCompactGrid(true);
+            setLightCellRangeBinning(lightCellRangeBinning);
+        }
+
+        const FastArray<uint16> &getFixedLayoutGrid() const { return mUncompactedGrid; }
+    };
+
+    Real randomReal(Real minVal, Real maxVal)
+    {
+        return minVal + (maxVal - minVal) * (Real(rand()) / Real(RAND_MAX));
+    }
+
+    Vector3 randomDirection()
+    {
+        Vector3 dir(randomReal(-1.0f, 1.0f), randomReal(-1.0f, 1.0f), randomReal(-1.0f, 1.0f));
+        while (dir.squaredLength() < 1e-4f)
+            dir = Vector3(randomReal(-1.0f, 1.0f), randomReal(-1.0f, 1.0f), randomReal(-1.0f, 1.0f));
+        return dir.normalisedCopy();
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void ForwardClusteredBinningTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    srand(0x5EED);
+
+    mRoot = OGRE_NEW Root(0, "", "", "ForwardClusteredBinningTests.log");
+    mRenderSystem = new NULLRenderSystem();
+    mRoot->addRenderSystem(mRenderSystem);
+    mRoot->setRenderSystem(mRenderSystem);
+    mRoot->initialise(false);
+    // Creates the VaoManager
+    mRoot->createRenderWindow("ForwardClusteredBinningTests", 320u, 180u, false);
+
+    mSceneManager = mRoot->createSceneManager(ST_GENERIC, 1u, "ForwardClusteredBinningTests");
+
+    mCamera = mSceneManager->createCamera("ForwardClusteredBinningTests");
+    mCamera->setNearClipDistance(0.5f);
+    mCamera->setFarClipDistance(300.0f);
+    mCamera->setAspectRatio(16.0f / 9.0f);
+}
+//--------------------------------------------------------------------------
+void ForwardClusteredBinningTests::tearDown()
+{
+    mRoot->destroySceneManager(mSceneManager);
+    OGRE_DELETE mRoot;
+    delete mRenderSystem;
+}
+//--------------------------------------------------------------------------
+void ForwardClusteredBinningTests::createLights(size_t numLights, bool spotLights, Real minRadius,
+                                                Real maxRadius, Real maxDistance)
+{
+    SceneNode *rootNode = mSceneManager->getRootSceneNode();
+    for (size_t i = 0; i < numLights; ++i)
+    {
+        Light *light = mSceneManager->createLight();
+        SceneNode *lightNode = rootNode->createChildSceneNode();
+        lightNode->attachObject(light);
+        lightNode->setPosition(randomDirection() * randomReal(0.0f, maxDistance));
+
+        light->setAttenuationBasedOnRadius(randomReal(minRadius, maxRadius), 0.00192f);
+        if (spotLights)
+        {
+            light->setType(Light::LT_SPOTLIGHT);
+            light->setDirection(randomDirection());
+            const Degree outerAngle(randomReal(10.0f, 120.0f));
+            light->setSpotlightRange(outerAngle * 0.5f, outerAngle);
+        }
+        else
+        {
+            light->setType(Light::LT_POINT);
+        }
+    }
+}
+//--------------------------------------------------------------------------
+size_t ForwardClusteredBinningTests::checkSameGrid()
+{
+    // The Viewport constructor leaves the light visibility mask uninitialized
+    Viewport viewport;
+    viewport._setVisibilityMask(0xFFFFFFFF, 0xFFFFFFFF);
+    mCamera->_notifyViewport(&viewport);
+    mSceneManager->updateSceneGraph();
+
+    TestForwardClustered bruteForce(mSceneManager, false);
+    TestForwardClustered cellRange(mSceneManager, true);
+    bruteForce._changeRenderSystem(mRenderSystem);
+    cellRange._changeRenderSystem(mRenderSystem);
+
+    bruteForce.collectLights(mCamera);
+    cellRange.collectLights(mCamera);
+
+    const FastArray<uint16> &expected = bruteForce.getFixedLayoutGrid();
+    const FastArray<uint16> &actual = cellRange.getFixedLayoutGrid();
+
+    const size_t numCells = size_t(c_gridWidth) * c_gridHeight * c_gridSlices;
+    CPPUNIT_ASSERT_EQUAL(numCells * c_objsPerCell, expected.size());
+    CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+
+    size_t numBinned = 0;
+    for (size_t i = 0; i < numCells; ++i)
+    {
+        const uint16 *expectedCell = expected.begin() + i * c_objsPerCell;
+        const uint16 *actualCell = actual.begin() + i * c_objsPerCell;
+
+        // Same light counts, then the same lights in the same order
+        for (size_t j = 0; j < 3u + expectedCell[2]; ++j)
+            CPPUNIT_ASSERT_EQUAL(expectedCell[j], actualCell[j]);
+
+        numBinned += expectedCell[2];
+    }
+
+    return numBinned;
+}
+//--------------------------------------------------------------------------
+void ForwardClusteredBinningTests::testPointLights()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    createLights(400u, false, 0.5f, 20.0f, 150.0f);
+
+    for (size_t i = 0; i < 8u; ++i)
+    {
+        mCamera->setPosition(randomDirection() * randomReal(0.0f, 20.0f));
+        mCamera->setDirection(randomDirection());
+        CPPUNIT_ASSERT(checkSameGrid() > 0u);
+    }
+}
+//--------------------------------------------------------------------------
+void ForwardClusteredBinningTests::testSpotLights()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    createLights(400u, true, 0.5f, 25.0f, 150.0f);
+
+    for (size_t i = 0; i < 8u; ++i)
+    {
+        mCamera->setPosition(randomDirection() * randomReal(0.0f, 20.0f));
+        mCamera->setDirection(randomDirection());
+        CPPUNIT_ASSERT(checkSameGrid() > 0u);
+    }
+}
+//--------------------------------------------------------------------------
+void ForwardClusteredBinningTests::testLightsCrossingNearPlane()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Lights around the camera, many of them containing it or behind it
+    createLights(100u, false, 0.5f, 5.0f, 6.0f);
+    createLights(100u, true, 0.5f, 5.0f, 6.0f);
+
+    mCamera->setPosition(Vector3::ZERO);
+    for (size_t i = 0; i < 8u; ++i)
+    {
+        mCamera->setDirection(randomDirection());
+        CPPUNIT_ASSERT(checkSameGrid() > 0u);
+    }
+}
+//--------------------------------------------------------------------------
+void ForwardClusteredBinningTests::testUnprojectableCameras()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    createLights(200u, false, 0.5f, 20.0f, 100.0f);
+    createLights(200u, true, 0.5f, 20.0f, 100.0f);
+
+    mCamera->setPosition(Vector3(0, 0, 50.0f));
+    mCamera->lookAt(Vector3::ZERO);
+
+    // These fall back to testing every cell
+    mCamera->enableReflection(Plane(Vector3::UNIT_Y, 0.0f));
+    CPPUNIT_ASSERT(checkSameGrid() > 0u);
+    mCamera->disableReflection();
+
+    mCamera->setProjectionType(PT_ORTHOGRAPHIC);
+    mCamera->setOrthoWindow(200.0f, 112.5f);
+    CPPUNIT_ASSERT(checkSameGrid() > 0u);
+}
+//--------------------------------------------------------------------------
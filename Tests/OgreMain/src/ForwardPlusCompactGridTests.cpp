@@ -0,0 +1,182 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "ForwardPlusCompactGridTests.h"
+
+#include "OgreForwardPlusBase.h"
+
+#include "UnitTestSuite.h"
+
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ForwardPlusCompactGridTests);
+
+//--------------------------------------------------------------------------
+void ForwardPlusCompactGridTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0x1234);
+}
+//--------------------------------------------------------------------------
+void ForwardPlusCompactGridTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+/// Fills a grid with the same fixed layout ForwardClustered uses (3 light counts, lights,
+/// decal count, decals, cubemap probe count, cubemap probes) with random sparse lists,
+/// packs it with ForwardPlusBase::compactGrid and checks that decoding every cell the way
+/// the shaders do yields exactly the same lists.
+void ForwardPlusCompactGridTests::checkDecodesToFixedLayout(size_t numCells, size_t lightsPerCell,
+                                                            size_t decalsPerCell,
+                                                            size_t cubemapProbesPerCell,
+                                                            bool decalsEnabled,
+                                                            bool cubemapProbesEnabled)
+{
+    const size_t decalsSlotOffset = 3u + lightsPerCell;
+    const size_t cubemapSlotOffset =
+        decalsSlotOffset + (decalsEnabled ? (1u + decalsPerCell) : 0u);
+    const size_t objsPerCell =
+        cubemapSlotOffset + (cubemapProbesEnabled ? (1u + cubemapProbesPerCell) : 0u);
+
+    // Unused slots are filled with garbage, which must never reach the compact grid
+    std::vector<uint16> fixedGrid(numCells * objsPerCell, 0xDEAD);
+    for (size_t i = 0; i < numCells; ++i)
+    {
+        uint16 *cell = &fixedGrid[i * objsPerCell];
+
+        // Most cells are sparse, a few are full
+        const size_t numLights =
+            (rand() % 8) == 0 ? lightsPerCell : rand() % (lightsPerCell / 4u + 1u);
+        const size_t numPointLights = numLights ? rand() % (numLights + 1u) : 0u;
+        cell[0] = static_cast<uint16>(numPointLights);
+        cell[1] = static_cast<uint16>(numLights);
+        cell[2] = static_cast<uint16>(numLights);
+        for (size_t j = 0; j < numLights; ++j)
+            cell[3u + j] = static_cast<uint16>(rand() % 0xFFFF);
+
+        if (decalsEnabled)
+        {
+            const size_t numDecals = rand() % (decalsPerCell + 1u);
+            cell[decalsSlotOffset] = static_cast<uint16>(numDecals);
+            for (size_t j = 0; j < numDecals; ++j)
+                cell[decalsSlotOffset + 1u + j] = static_cast<uint16>(rand() % 0xFFFF);
+        }
+
+        if (cubemapProbesEnabled)
+        {
+            const size_t numProbes = rand() % (cubemapProbesPerCell + 1u);
+            cell[cubemapSlotOffset] = static_cast<uint16>(numProbes);
+            for (size_t j = 0; j < numProbes; ++j)
+                cell[cubemapSlotOffset + 1u + j] = static_cast<uint16>(rand() % 0xFFFF);
+        }
+    }
+
+    const size_t numElements = ForwardPlusBase::getCompactGridNumElements(
+        &fixedGrid[0], numCells, objsPerCell, decalsSlotOffset, cubemapSlotOffset, decalsEnabled,
+        cubemapProbesEnabled);
+    CPPUNIT_ASSERT(numElements <= numCells * 2u + fixedGrid.size());
+
+    // One extra sentinel slot to catch writes past the reported size
+    std::vector<uint16> compactGrid(numElements + 1u, 0xBEEF);
+    ForwardPlusBase::compactGrid(&compactGrid[0], &fixedGrid[0], numCells, objsPerCell,
+                                 decalsSlotOffset, cubemapSlotOffset, decalsEnabled,
+                                 cubemapProbesEnabled);
+    CPPUNIT_ASSERT_EQUAL((uint16)0xBEEF, compactGrid[numElements]);
+
+    const bool hasDecalCount = decalsEnabled || cubemapProbesEnabled;
+
+    size_t expectedOffset = numCells * 2u;
+    for (size_t i = 0; i < numCells; ++i)
+    {
+        const uint16 *cell = &fixedGrid[i * objsPerCell];
+
+        const size_t offset =
+            (size_t(compactGrid[i * 2u + 0u]) << 16u) | size_t(compactGrid[i * 2u + 1u]);
+        // Lists are tightly packed in cell order
+        CPPUNIT_ASSERT_EQUAL(expectedOffset, offset);
+
+        const uint16 *compactCell = &compactGrid[offset];
+        for (size_t j = 0; j < 3u + cell[2]; ++j)
+            CPPUNIT_ASSERT_EQUAL(cell[j], compactCell[j]);
+        compactCell += 3u + cell[2];
+
+        if (hasDecalCount)
+        {
+            const uint16 numDecals = decalsEnabled ? cell[decalsSlotOffset] : 0u;
+            CPPUNIT_ASSERT_EQUAL(numDecals, compactCell[0]);
+            for (size_t j = 0; j < numDecals; ++j)
+                CPPUNIT_ASSERT_EQUAL(cell[decalsSlotOffset + 1u + j], compactCell[1u + j]);
+            compactCell += 1u + numDecals;
+        }
+
+        if (cubemapProbesEnabled)
+        {
+            const uint16 numProbes = cell[cubemapSlotOffset];
+            CPPUNIT_ASSERT_EQUAL(numProbes, compactCell[0]);
+            for (size_t j = 0; j < numProbes; ++j)
+                CPPUNIT_ASSERT_EQUAL(cell[cubemapSlotOffset + 1u + j], compactCell[1u + j]);
+            compactCell += 1u + numProbes;
+        }
+
+        expectedOffset = static_cast<size_t>(compactCell - &compactGrid[0]);
+    }
+
+    CPPUNIT_ASSERT_EQUAL(numElements, expectedOffset);
+}
+//--------------------------------------------------------------------------
+void ForwardPlusCompactGridTests::testLightsOnly()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+    checkDecodesToFixedLayout(16u * 8u * 24u, 64u, 0u, 0u, false, false);
+}
+//--------------------------------------------------------------------------
+void ForwardPlusCompactGridTests::testDecalsAndCubemapProbes()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+    checkDecodesToFixedLayout(16u * 8u * 24u, 64u, 16u, 8u, true, true);
+    checkDecodesToFixedLayout(16u * 8u * 24u, 64u, 16u, 0u, true, false);
+}
+//--------------------------------------------------------------------------
+void ForwardPlusCompactGridTests::testCubemapProbesWithoutDecals()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+    // The shaders skip the (empty) decal list to find the probes, so its count must be there
+    checkDecodesToFixedLayout(16u * 8u * 24u, 64u, 0u, 8u, false, true);
+}
+//--------------------------------------------------------------------------
+void ForwardPlusCompactGridTests::testLargeOffsets()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+    // Enough cells for offsets to need the high 16 bits
+    checkDecodesToFixedLayout(64u * 32u * 32u, 32u, 8u, 4u, true, true);
+}
+//--------------------------------------------------------------------------
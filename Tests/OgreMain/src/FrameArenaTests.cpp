@@ -0,0 +1,200 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "FrameArenaTests.h"
+
+#include "OgreFrameArena.h"
+
+#include "UnitTestSuite.h"
+
+#include <cstring>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(FrameArenaTests);
+
+static const size_t c_blockSize = 1024u;
+
+//--------------------------------------------------------------------------
+void FrameArenaTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void FrameArenaTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void FrameArenaTests::testAllocation()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    FrameArena arena(3u, c_blockSize);
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, arena.getNumFrames());
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, arena.getBytesUsed());
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, arena.getBytesReserved());
+
+    uint8 *a = static_cast<uint8 *>(arena.allocate(100u, 1u));
+    uint8 *b = static_cast<uint8 *>(arena.allocate(100u, 1u));
+    CPPUNIT_ASSERT(a && b);
+    // Bump allocation: consecutive and not overlapping
+    CPPUNIT_ASSERT(b == a + 100u);
+    CPPUNIT_ASSERT_EQUAL((size_t)200u, arena.getBytesUsed());
+    CPPUNIT_ASSERT_EQUAL(c_blockSize, arena.getBytesReserved());
+
+    memset(a, 0xAA, 100u);
+    memset(b, 0x55, 100u);
+    for (size_t i = 0u; i < 100u; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL((uint8)0xAA, a[i]);
+        CPPUNIT_ASSERT_EQUAL((uint8)0x55, b[i]);
+    }
+}
+//--------------------------------------------------------------------------
+void FrameArenaTests::testAlignment()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    FrameArena arena(1u, c_blockSize);
+
+    // Misalign the offset on purpose before each request
+    const size_t alignments[] = { 1u, 2u, 4u, 8u, 16u, 32u, 64u, 256u };
+    for (size_t i = 0u; i < sizeof(alignments) / sizeof(alignments[0]); ++i)
+    {
+        arena.allocate(3u, 1u);
+        const size_t ptr = reinterpret_cast<size_t>(arena.allocate(24u, alignments[i]));
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, ptr % alignments[i]);
+    }
+
+    // The default alignment is OGRE_SIMD_ALIGNMENT
+    arena.allocate(3u, 1u);
+    const size_t ptr = reinterpret_cast<size_t>(arena.allocate(16u));
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, ptr % OGRE_SIMD_ALIGNMENT);
+
+    // Typed allocations use the alignment of the type
+    arena.allocate(1u, 1u);
+    const size_t ptr64 = reinterpret_cast<size_t>(arena.allocate<uint64>(4u));
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, ptr64 % alignof(uint64));
+
+    // An over-aligned request that doesn't fit goes to a new block, still aligned
+    const size_t bigPtr = reinterpret_cast<size_t>(arena.allocate(c_blockSize, 512u));
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, bigPtr % 512u);
+}
+//--------------------------------------------------------------------------
+void FrameArenaTests::testFrameReset()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numFrames = 3u;
+    FrameArena arena(numFrames, c_blockSize);
+
+    void *firstFrameAlloc = arena.allocate(64u);
+    CPPUNIT_ASSERT_EQUAL((size_t)64u, arena.getBytesUsed());
+
+    // Memory from a frame stays valid (not handed out again)
+    // while the other frames in flight are being used
+    void *otherFramesAllocs[numFrames - 1u];
+    for (size_t i = 0u; i < numFrames - 1u; ++i)
+    {
+        arena._advanceFrame();
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, arena.getBytesUsed());
+        otherFramesAllocs[i] = arena.allocate(64u);
+        CPPUNIT_ASSERT(otherFramesAllocs[i] != firstFrameAlloc);
+    }
+    CPPUNIT_ASSERT(otherFramesAllocs[0] != otherFramesAllocs[1]);
+
+    // Back to the first frame: everything it allocated was reclaimed at once
+    arena._advanceFrame();
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, arena.getBytesUsed());
+    CPPUNIT_ASSERT(arena.allocate(64u) == firstFrameAlloc);
+
+    // No new memory was needed for any of it
+    CPPUNIT_ASSERT_EQUAL(numFrames * c_blockSize, arena.getBytesReserved());
+
+    arena.releaseMemory();
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, arena.getBytesReserved());
+}
+//--------------------------------------------------------------------------
+void FrameArenaTests::testGrowth()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    FrameArena arena(1u, c_blockSize);
+
+    // Spill over several blocks, including one bigger than the block size
+    void *allocs[4];
+    allocs[0] = arena.allocate(c_blockSize - 16u, 16u);
+    allocs[1] = arena.allocate(c_blockSize - 16u, 16u);
+    allocs[2] = arena.allocate(c_blockSize * 3u, 16u);
+    allocs[3] = arena.allocate(64u, 16u);
+    for (size_t i = 0u; i < 4u; ++i)
+        CPPUNIT_ASSERT(allocs[i] != 0);
+
+    const size_t reservedBeforeReset = arena.getBytesReserved();
+    CPPUNIT_ASSERT(reservedBeforeReset >= c_blockSize * 5u);
+    CPPUNIT_ASSERT(arena.getBytesUsed() >= (c_blockSize - 16u) * 2u + c_blockSize * 3u + 64u);
+
+    // The next time this frame begins, its blocks are merged into a single
+    // one, so the same workload fits without asking the system for more
+    arena._advanceFrame();
+    CPPUNIT_ASSERT_EQUAL(reservedBeforeReset, arena.getBytesReserved());
+
+    uint8 *first = static_cast<uint8 *>(arena.allocate(c_blockSize - 16u, 16u));
+    uint8 *second = static_cast<uint8 *>(arena.allocate(c_blockSize - 16u, 16u));
+    uint8 *third = static_cast<uint8 *>(arena.allocate(c_blockSize * 3u, 16u));
+    arena.allocate(64u, 16u);
+    CPPUNIT_ASSERT_EQUAL(reservedBeforeReset, arena.getBytesReserved());
+    // Contiguous, i.e. from the same block
+    CPPUNIT_ASSERT(second == first + (c_blockSize - 16u));
+    CPPUNIT_ASSERT(third == second + (c_blockSize - 16u));
+}
+//--------------------------------------------------------------------------
+void FrameArenaTests::testStlAllocator()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    FrameArena arena(2u, c_blockSize);
+
+    typedef FrameArenaVector<uint32>::type Uint32Vec;
+    Uint32Vec values((FrameArenaAllocator<uint32>(&arena)));
+    values.reserve(16u);
+    for (uint32 i = 0u; i < 16u; ++i)
+        values.push_back(i * 3u);
+
+    CPPUNIT_ASSERT_EQUAL((size_t)16u, values.size());
+    for (uint32 i = 0u; i < 16u; ++i)
+        CPPUNIT_ASSERT_EQUAL(i * 3u, values[i]);
+    CPPUNIT_ASSERT(arena.getBytesUsed() >= 16u * sizeof(uint32));
+
+    // Allocators of different types compare equal if they share the arena
+    CPPUNIT_ASSERT(FrameArenaAllocator<uint32>(&arena) == FrameArenaAllocator<float>(&arena));
+    FrameArena otherArena(1u, c_blockSize);
+    CPPUNIT_ASSERT(FrameArenaAllocator<uint32>(&arena) != FrameArenaAllocator<uint32>(&otherArena));
+}
+//--------------------------------------------------------------------------
@@ -0,0 +1,173 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "GpuResourceTests.h"
+
+#include "OgreGpuResource.h"
+#include "OgreSharedPtr.h"
+#include "Vao/OgreVaoManager.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(GpuResourceTests);
+
+/// GpuResource only needs VaoManager::getFrameCount
+class FrameCountVaoManager : public VaoManager
+{
+protected:
+    VertexBufferPacked *createVertexBufferImpl(size_t, uint32, BufferType, void *, bool,
+                                               const VertexElement2Vec &) override
+    {
+        return 0;
+    }
+    void destroyVertexBufferImpl(VertexBufferPacked *) override {}
+#ifdef _OGRE_MULTISOURCE_VBO
+    MultiSourceVertexBufferPool *createMultiSourceVertexBufferPoolImpl(const VertexElement2VecVec &,
+                                                                       size_t, size_t,
+                                                                       BufferType) override
+    {
+        return 0;
+    }
+#endif
+    IndexBufferPacked *createIndexBufferImpl(size_t, uint32, BufferType, void *, bool) override
+    {
+        return 0;
+    }
+    void destroyIndexBufferImpl(IndexBufferPacked *) override {}
+    ConstBufferPacked *createConstBufferImpl(size_t, BufferType, void *, bool) override { return 0; }
+    void destroyConstBufferImpl(ConstBufferPacked *) override {}
+    TexBufferPacked *createTexBufferImpl(PixelFormatGpu, size_t, BufferType, void *, bool) override
+    {
+        return 0;
+    }
+    void destroyTexBufferImpl(TexBufferPacked *) override {}
+    ReadOnlyBufferPacked *createReadOnlyBufferImpl(PixelFormatGpu, size_t, BufferType, void *,
+                                                   bool) override
+    {
+        return 0;
+    }
+    void destroyReadOnlyBufferImpl(ReadOnlyBufferPacked *) override {}
+    UavBufferPacked *createUavBufferImpl(size_t, uint32, uint32, void *, bool) override { return 0; }
+    void destroyUavBufferImpl(UavBufferPacked *) override {}
+    IndirectBufferPacked *createIndirectBufferImpl(size_t, BufferType, void *, bool) override
+    {
+        return 0;
+    }
+    void destroyIndirectBufferImpl(IndirectBufferPacked *) override {}
+    VertexArrayObject *createVertexArrayObjectImpl(const VertexBufferPackedVec &, IndexBufferPacked *,
+                                                   OperationType) override
+    {
+        return 0;
+    }
+    void destroyVertexArrayObjectImpl(VertexArrayObject *) override {}
+    void switchVboPoolIndexImpl(unsigned, size_t, size_t, BufferPacked *) override {}
+
+public:
+    FrameCountVaoManager() : VaoManager(0) {}
+
+    void setFrameCount(uint32 frameCount) { mFrameCount = frameCount; }
+
+    void getMemoryStats(MemoryStatsEntryVec &, size_t &outCapacityBytes, size_t &outFreeBytes, Log *,
+                        bool &outIncludesTextures) const override
+    {
+        outCapacityBytes = 0u;
+        outFreeBytes = 0u;
+        outIncludesTextures = false;
+    }
+    void cleanupEmptyPools() override {}
+    StagingBuffer *createStagingBuffer(size_t, bool) override { return 0; }
+    AsyncTicketPtr createAsyncTicket(BufferPacked *, StagingBuffer *, size_t, size_t) override
+    {
+        return AsyncTicketPtr();
+    }
+    uint8 waitForTailFrameToFinish() override { return 0u; }
+    void waitForSpecificFrameToFinish(uint32) override {}
+    bool isFrameFinished(uint32) override { return true; }
+};
+
+static FrameCountVaoManager *gVaoManager = 0;
+
+//--------------------------------------------------------------------------
+void GpuResourceTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    gVaoManager = new FrameCountVaoManager();
+}
+//--------------------------------------------------------------------------
+void GpuResourceTests::tearDown()
+{
+    delete gVaoManager;
+    gVaoManager = 0;
+}
+//--------------------------------------------------------------------------
+void GpuResourceTests::testNotTouchedByDefault()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // TextureGpuManager::setResidencyBudget never pages out untouched resources:
+    // whatever uses them doesn't report it, so their age is meaningless.
+    gVaoManager->setFrameCount(10u);
+    GpuResource resource(GpuPageOutStrategy::Discard, gVaoManager, "Untouched");
+    CPPUNIT_ASSERT(!resource.hasBeenTouched());
+    CPPUNIT_ASSERT_EQUAL(10u, resource.getLastFrameUsed());
+
+    gVaoManager->setFrameCount(1000u);
+    CPPUNIT_ASSERT(!resource.hasBeenTouched());
+
+    resource._touch(1000u, 5.0f);
+    CPPUNIT_ASSERT(resource.hasBeenTouched());
+    CPPUNIT_ASSERT_EQUAL(1000u, resource.getLastFrameUsed());
+}
+//--------------------------------------------------------------------------
+void GpuResourceTests::testTouchKeepsLowestDistancePerFrame()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    gVaoManager->setFrameCount(3u);
+    GpuResource resource(GpuPageOutStrategy::Discard, gVaoManager, "Touched");
+
+    // The first touch must not be min'ed against the default distance,
+    // even if it happens in the frame the resource was created
+    resource._touch(3u, 50.0f);
+    CPPUNIT_ASSERT_EQUAL(50.0f, resource.getLowestDistanceToCamera());
+
+    resource._touch(3u, 20.0f);
+    resource._touch(3u, 30.0f);
+    CPPUNIT_ASSERT_EQUAL(3u, resource.getLastFrameUsed());
+    CPPUNIT_ASSERT_EQUAL(20.0f, resource.getLowestDistanceToCamera());
+
+    // A new frame starts over
+    resource._touch(4u, 40.0f);
+    CPPUNIT_ASSERT_EQUAL(4u, resource.getLastFrameUsed());
+    CPPUNIT_ASSERT_EQUAL(40.0f, resource.getLowestDistanceToCamera());
+    CPPUNIT_ASSERT(resource.hasBeenTouched());
+}
+//--------------------------------------------------------------------------
@@ -0,0 +1,396 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "MeshAsyncLoadTests.h"
+
+#include "OgreArchive.h"
+#include "OgreArchiveFactory.h"
+#include "OgreArchiveManager.h"
+#include "OgreLodStrategyManager.h"
+#include "OgreMesh2.h"
+#include "OgreMesh2Serializer.h"
+#include "OgreMeshManager2.h"
+#include "OgreResourceGroupManager.h"
+#include "OgreStringConverter.h"
+#include "OgreSubMesh2.h"
+#include "Threading/OgreThreads.h"
+#include "Vao/OgreNULLVaoManager.h"
+#include "Vao/OgreIndexBufferPacked.h"
+#include "Vao/OgreVertexArrayObject.h"
+
+#include "UnitTestSuite.h"
+
+#include <atomic>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(MeshAsyncLoadTests);
+
+static const char *c_archiveType = "AsyncTest";
+static const char *c_groupName = "AsyncTest";
+static const size_t c_numMeshes = 8u;
+
+/// In-memory archive serving the same mesh under several names. Opening a file can be
+/// delayed to keep the async worker thread busy with a request for a while.
+class AsyncTestArchive : public Archive
+{
+    DataStreamPtr mMeshData;
+
+public:
+    std::atomic<uint32> numOpens;
+    std::atomic<uint32> openDelayMs;
+
+    AsyncTestArchive(const String &name, const String &archType, const DataStreamPtr &meshData) :
+        Archive(name, archType),
+        mMeshData(meshData),
+        numOpens(0u),
+        openDelayMs(0u)
+    {
+    }
+
+    static String getMeshName(size_t idx) { return "Mesh" + StringConverter::toString(idx) + ".mesh"; }
+
+    bool isCaseSensitive() const override { return true; }
+    void load() override {}
+    void unload() override {}
+
+    DataStreamPtr open(const String &filename, bool readOnly) override
+    {
+        ++numOpens;
+        const uint32 delayMs = openDelayMs.load();
+        if (delayMs)
+            Threads::Sleep(delayMs);
+
+        if (!exists(filename))
+            return DataStreamPtr();
+
+        MemoryDataStream *memStream = OGRE_NEW MemoryDataStream(filename, mMeshData->size());
+        memcpy(memStream->getPtr(), static_cast<MemoryDataStream *>(mMeshData.get())->getPtr(),
+               mMeshData->size());
+        return DataStreamPtr(memStream);
+    }
+
+    StringVectorPtr list(bool recursive, bool dirs) override
+    {
+        StringVectorPtr retVal(OGRE_NEW_T(StringVector, MEMCATEGORY_GENERAL)(),
+                               SPFM_DELETE_T);
+        if (!dirs)
+        {
+            for (size_t i = 0u; i < c_numMeshes; ++i)
+                retVal->push_back(getMeshName(i));
+        }
+        return retVal;
+    }
+
+    FileInfoListPtr listFileInfo(bool recursive, bool dirs) override
+    {
+        return FileInfoListPtr(OGRE_NEW_T(FileInfoList, MEMCATEGORY_GENERAL)(), SPFM_DELETE_T);
+    }
+
+    StringVectorPtr find(const String &pattern, bool recursive, bool dirs) override
+    {
+        return list(recursive, dirs);
+    }
+
+    FileInfoListPtr findFileInfo(const String &pattern, bool recursive, bool dirs) override
+    {
+        return listFileInfo(recursive, dirs);
+    }
+
+    bool exists(const String &filename) override
+    {
+        for (size_t i = 0u; i < c_numMeshes; ++i)
+        {
+            if (filename == getMeshName(i))
+                return true;
+        }
+        return false;
+    }
+
+    time_t getModifiedTime(const String &filename) override { return 0; }
+};
+
+class AsyncTestArchiveFactory : public ArchiveFactory
+{
+public:
+    DataStreamPtr meshData;
+    AsyncTestArchive *archive;
+
+    AsyncTestArchiveFactory() : archive(0) {}
+
+    const String &getType() const override
+    {
+        static const String type(c_archiveType);
+        return type;
+    }
+
+    Archive *createInstance(const String &name, bool readOnly) override
+    {
+        archive = OGRE_NEW AsyncTestArchive(name, getType(), meshData);
+        return archive;
+    }
+
+    void destroyInstance(Archive *ptr) override
+    {
+        if (ptr == archive)
+            archive = 0;
+        OGRE_DELETE ptr;
+    }
+};
+
+/// Serializes a tiny one-triangle mesh, trimmed to what was written
+static DataStreamPtr createMeshData(MeshManager *meshManager, VaoManager *vaoManager)
+{
+    MeshPtr mesh = meshManager->createManual("AsyncTestSource", c_groupName);
+    SubMesh *subMesh = mesh->createSubMesh();
+
+    VertexElement2Vec vertexElements;
+    vertexElements.push_back(VertexElement2(VET_FLOAT3, VES_POSITION));
+    float *vertices =
+        reinterpret_cast<float *>(OGRE_MALLOC_SIMD(sizeof(float) * 9u, MEMCATEGORY_GEOMETRY));
+    for (size_t i = 0u; i < 9u; ++i)
+        vertices[i] = float(i);
+    VertexBufferPackedVec vertexBuffers;
+    vertexBuffers.push_back(
+        vaoManager->createVertexBuffer(vertexElements, 3u, BT_IMMUTABLE, vertices, true));
+
+    uint16 *indices =
+        reinterpret_cast<uint16 *>(OGRE_MALLOC_SIMD(sizeof(uint16) * 3u, MEMCATEGORY_GEOMETRY));
+    for (uint16 i = 0u; i < 3u; ++i)
+        indices[i] = i;
+    IndexBufferPacked *indexBuffer = vaoManager->createIndexBuffer(IndexBufferPacked::IT_16BIT, 3u,
+                                                                   BT_IMMUTABLE, indices, true);
+
+    VertexArrayObject *vao =
+        vaoManager->createVertexArrayObject(vertexBuffers, indexBuffer, OT_TRIANGLE_LIST);
+    subMesh->mVao[VpNormal].push_back(vao);
+    subMesh->mVao[VpShadow].push_back(vao);
+    mesh->_setBounds(Aabb(Vector3::ZERO, Vector3::UNIT_SCALE), false);
+    mesh->_setBoundingSphereRadius(Real(1.8));
+    // Manual meshes have no loader; this only marks it as loaded so the submeshes get freed
+    mesh->load();
+
+    MemoryDataStream *memStream = OGRE_NEW MemoryDataStream("AsyncTestSource", 64u * 1024u);
+    DataStreamPtr stream(memStream);
+    MeshSerializer meshSerializer(vaoManager);
+    meshSerializer.exportMesh(mesh.get(), stream);
+
+    const size_t bytesWritten = stream->tell();
+    MemoryDataStream *trimmed = OGRE_NEW MemoryDataStream("AsyncTestSource", bytesWritten);
+    memcpy(trimmed->getPtr(), memStream->getPtr(), bytesWritten);
+
+    meshManager->remove(mesh);
+    return DataStreamPtr(trimmed);
+}
+
+/// Waits until the worker thread started opening the given number of files
+static bool waitForOpens(AsyncTestArchive *archive, uint32 numOpens)
+{
+    for (size_t i = 0u; i < 5000u && archive->numOpens.load() < numOpens; ++i)
+        Threads::Sleep(1);
+    return archive->numOpens.load() >= numOpens;
+}
+
+//--------------------------------------------------------------------------
+void MeshAsyncLoadTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    mResourceGroupManager = OGRE_NEW ResourceGroupManager();
+    mLodStrategyManager = 0;
+    if (!LodStrategyManager::getSingletonPtr())
+        mLodStrategyManager = OGRE_NEW LodStrategyManager();
+    mArchiveManager = OGRE_NEW ArchiveManager();
+    mArchiveFactory = OGRE_NEW AsyncTestArchiveFactory();
+    mArchiveManager->addArchiveFactory(mArchiveFactory);
+
+    mVaoManager = OGRE_NEW NULLVaoManager();
+    mMeshManager = OGRE_NEW MeshManager();
+    mMeshManager->_setVaoManager(mVaoManager);
+
+    mResourceGroupManager->createResourceGroup(c_groupName);
+    mArchiveFactory->meshData = createMeshData(mMeshManager, mVaoManager);
+    mResourceGroupManager->addResourceLocation("AsyncTestArchive", c_archiveType, c_groupName);
+    CPPUNIT_ASSERT(mArchiveFactory->archive);
+}
+//--------------------------------------------------------------------------
+void MeshAsyncLoadTests::tearDown()
+{
+    OGRE_DELETE mMeshManager;
+    mMeshManager = 0;
+    OGRE_DELETE mVaoManager;
+    OGRE_DELETE mResourceGroupManager;
+    OGRE_DELETE mArchiveManager;
+    OGRE_DELETE mArchiveFactory;
+    OGRE_DELETE mLodStrategyManager;
+}
+//--------------------------------------------------------------------------
+void MeshAsyncLoadTests::testLoadCompletes()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    CPPUNIT_ASSERT(!mMeshManager->isAsyncLoadPending());
+
+    MeshPtr meshes[c_numMeshes];
+    for (size_t i = 0u; i < c_numMeshes; ++i)
+    {
+        meshes[i] = mMeshManager->loadAsync(AsyncTestArchive::getMeshName(i), c_groupName);
+        CPPUNIT_ASSERT(meshes[i]->isBackgroundLoaded());
+    }
+    CPPUNIT_ASSERT(mMeshManager->isAsyncLoadPending());
+
+    // Requesting it again returns the same mesh, without queueing it twice
+    CPPUNIT_ASSERT(meshes[0] ==
+                   mMeshManager->loadAsync(AsyncTestArchive::getMeshName(0u), c_groupName));
+
+    // Mesh::load must not load it behind the async load's back
+    meshes[0]->load();
+    CPPUNIT_ASSERT(!meshes[0]->isLoaded());
+
+    mMeshManager->waitForAsyncLoads();
+    CPPUNIT_ASSERT(!mMeshManager->isAsyncLoadPending());
+    CPPUNIT_ASSERT_EQUAL((uint32)c_numMeshes, mArchiveFactory->archive->numOpens.load());
+
+    for (size_t i = 0u; i < c_numMeshes; ++i)
+    {
+        CPPUNIT_ASSERT(meshes[i]->isLoaded());
+        CPPUNIT_ASSERT(!meshes[i]->isBackgroundLoaded());
+        CPPUNIT_ASSERT_EQUAL((size_t)1u, (size_t)meshes[i]->getNumSubMeshes());
+        VertexArrayObject *vao = meshes[i]->getSubMesh(0)->mVao[VpNormal][0];
+        CPPUNIT_ASSERT_EQUAL((size_t)3u, vao->getBaseVertexBuffer()->getNumElements());
+    }
+
+    // Already loaded: nothing to do
+    CPPUNIT_ASSERT(meshes[0] ==
+                   mMeshManager->loadAsync(AsyncTestArchive::getMeshName(0u), c_groupName));
+    CPPUNIT_ASSERT(!mMeshManager->isAsyncLoadPending());
+}
+//--------------------------------------------------------------------------
+void MeshAsyncLoadTests::testUploadBudget()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    MeshPtr meshes[c_numMeshes];
+    for (size_t i = 0u; i < c_numMeshes; ++i)
+        meshes[i] = mMeshManager->loadAsync(AsyncTestArchive::getMeshName(i), c_groupName);
+
+    // Any budget smaller than a mesh still loads one mesh per call
+    size_t numLoaded = 0u;
+    for (size_t i = 0u; i < 5000u && numLoaded < c_numMeshes; ++i)
+    {
+        mMeshManager->_updateAsyncLoads(1u);
+
+        size_t nowLoaded = 0u;
+        for (size_t j = 0u; j < c_numMeshes; ++j)
+            nowLoaded += meshes[j]->isLoaded() ? 1u : 0u;
+        CPPUNIT_ASSERT(nowLoaded <= numLoaded + 1u);
+        numLoaded = nowLoaded;
+
+        Threads::Sleep(1);
+    }
+
+    CPPUNIT_ASSERT_EQUAL(c_numMeshes, numLoaded);
+    CPPUNIT_ASSERT(!mMeshManager->isAsyncLoadPending());
+}
+//--------------------------------------------------------------------------
+void MeshAsyncLoadTests::testCancelQueued()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    AsyncTestArchive *archive = mArchiveFactory->archive;
+    archive->openDelayMs = 200u;
+
+    // The worker stays busy with the first mesh, thus the second one is still queued
+    MeshPtr first = mMeshManager->loadAsync(AsyncTestArchive::getMeshName(0u), c_groupName);
+    MeshPtr second = mMeshManager->loadAsync(AsyncTestArchive::getMeshName(1u), c_groupName);
+    CPPUNIT_ASSERT(waitForOpens(archive, 1u));
+
+    CPPUNIT_ASSERT(mMeshManager->cancelAsyncLoad(second.get()));
+    CPPUNIT_ASSERT(!second->isBackgroundLoaded());
+    CPPUNIT_ASSERT(!mMeshManager->cancelAsyncLoad(second.get()));
+
+    mMeshManager->waitForAsyncLoads();
+    CPPUNIT_ASSERT(first->isLoaded());
+    CPPUNIT_ASSERT(!second->isLoaded());
+    CPPUNIT_ASSERT_EQUAL(1u, (unsigned)archive->numOpens.load());
+
+    // Nothing pending anymore
+    CPPUNIT_ASSERT(!mMeshManager->cancelAsyncLoad(first.get()));
+
+    // A cancelled mesh can still be loaded normally
+    archive->openDelayMs = 0u;
+    second->load();
+    CPPUNIT_ASSERT(second->isLoaded());
+}
+//--------------------------------------------------------------------------
+void MeshAsyncLoadTests::testCancelInFlight()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    AsyncTestArchive *archive = mArchiveFactory->archive;
+    archive->openDelayMs = 100u;
+
+    MeshPtr mesh = mMeshManager->loadAsync(AsyncTestArchive::getMeshName(0u), c_groupName);
+    CPPUNIT_ASSERT(waitForOpens(archive, 1u));
+
+    // Blocks until the worker is done reading it
+    CPPUNIT_ASSERT(mMeshManager->cancelAsyncLoad(mesh.get()));
+    CPPUNIT_ASSERT(!mMeshManager->isAsyncLoadPending());
+    CPPUNIT_ASSERT(!mesh->isBackgroundLoaded());
+
+    // What the worker read gets discarded
+    mMeshManager->_updateAsyncLoads(0u);
+    CPPUNIT_ASSERT(!mesh->isLoaded());
+
+    // And it can be requested again
+    archive->openDelayMs = 0u;
+    CPPUNIT_ASSERT(mesh == mMeshManager->loadAsync(AsyncTestArchive::getMeshName(0u), c_groupName));
+    CPPUNIT_ASSERT(mMeshManager->isAsyncLoadPending());
+    mMeshManager->waitForAsyncLoads();
+    CPPUNIT_ASSERT(mesh->isLoaded());
+}
+//--------------------------------------------------------------------------
+void MeshAsyncLoadTests::testShutdownWithQueuedWork()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    AsyncTestArchive *archive = mArchiveFactory->archive;
+    archive->openDelayMs = 100u;
+
+    for (size_t i = 0u; i < c_numMeshes; ++i)
+        mMeshManager->loadAsync(AsyncTestArchive::getMeshName(i), c_groupName);
+    CPPUNIT_ASSERT(waitForOpens(archive, 1u));
+
+    // Must not wait for the queued requests, nor leak them
+    OGRE_DELETE mMeshManager;
+    mMeshManager = 0;
+
+    CPPUNIT_ASSERT(archive->numOpens.load() < c_numMeshes);
+}
+//--------------------------------------------------------------------------
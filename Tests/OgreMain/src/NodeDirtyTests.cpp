@@ -0,0 +1,221 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "NodeDirtyTests.h"
+
+#include "Math/Array/OgreNodeMemoryManager.h"
+#include "OgreSceneNode.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(NodeDirtyTests);
+
+/// Standalone SceneNode. There's no SceneManager to hand out the default
+/// NodeMemoryManager when a node gets detached from its parent
+class NodeDirtyTestNode : public SceneNode
+{
+public:
+    NodeDirtyTestNode(IdType id, NodeMemoryManager *nodeMemoryManager) :
+        SceneNode(id, 0, nodeMemoryManager, 0)
+    {
+    }
+
+    NodeMemoryManager *getDefaultNodeMemoryManager(SceneMemoryMgrTypes sceneType) override
+    {
+        return mNodeMemoryManager;
+    }
+};
+
+static bool isDirty(Node *node)
+{
+    const Transform &t = node->_getTransform();
+    return t.mDirty[t.mIndex];
+}
+
+//--------------------------------------------------------------------------
+void NodeDirtyTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    mNodeMemoryManager = new NodeMemoryManager();
+}
+//--------------------------------------------------------------------------
+void NodeDirtyTests::tearDown()
+{
+    delete mNodeMemoryManager;
+    mNodeMemoryManager = 0;
+}
+//--------------------------------------------------------------------------
+SceneNode *NodeDirtyTests::createNode(IdType id, SceneNode *parent)
+{
+    SceneNode *node = new NodeDirtyTestNode(id, mNodeMemoryManager);
+    if (parent)
+        parent->addChild(node);
+    return node;
+}
+//--------------------------------------------------------------------------
+void NodeDirtyTests::updateAllTransforms()
+{
+    const size_t numDepths = mNodeMemoryManager->getNumDepths();
+    for (size_t i = 0; i < numDepths; ++i)
+    {
+        Transform t;
+        const size_t numNodes = mNodeMemoryManager->getFirstNode(t, i);
+        Node::updateAllTransforms(numNodes, t);
+    }
+    mNodeMemoryManager->_clearDirtyFlags(0u);
+}
+//--------------------------------------------------------------------------
+void NodeDirtyTests::testNewNodesStartDirty()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    SceneNode *root = createNode(1u, 0);
+    SceneNode *child = createNode(2u, root);
+    CPPUNIT_ASSERT(isDirty(root));
+    CPPUNIT_ASSERT(isDirty(child));
+
+    updateAllTransforms();
+    CPPUNIT_ASSERT(!isDirty(root));
+    CPPUNIT_ASSERT(!isDirty(child));
+
+    // Every setter flags the node
+    child->setPosition(Vector3(1, 2, 3));
+    CPPUNIT_ASSERT(isDirty(child));
+    CPPUNIT_ASSERT(!isDirty(root));
+    updateAllTransforms();
+    root->setScale(Vector3(2, 2, 2));
+    CPPUNIT_ASSERT(isDirty(root));
+    updateAllTransforms();
+    root->setInheritOrientation(false);
+    CPPUNIT_ASSERT(isDirty(root));
+
+    delete child;
+    delete root;
+}
+//--------------------------------------------------------------------------
+void NodeDirtyTests::testParentChangePropagates()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    SceneNode *root = createNode(1u, 0);
+    SceneNode *child = createNode(2u, root);
+    SceneNode *grandChild = createNode(3u, child);
+    child->setPosition(Vector3(1, 2, 3));
+    grandChild->setPosition(Vector3(0, 0, 1));
+    updateAllTransforms();
+
+    CPPUNIT_ASSERT_EQUAL(Vector3(1, 2, 3), child->_getDerivedPosition());
+    CPPUNIT_ASSERT_EQUAL(Vector3(1, 2, 4), grandChild->_getDerivedPosition());
+
+    // Only the root is flagged; its descendants pick it up while updating
+    root->setPosition(Vector3(10, 0, 0));
+    CPPUNIT_ASSERT(!isDirty(child));
+    CPPUNIT_ASSERT(!isDirty(grandChild));
+
+    updateAllTransforms();
+    CPPUNIT_ASSERT_EQUAL(Vector3(10, 0, 0), root->_getDerivedPosition());
+    CPPUNIT_ASSERT_EQUAL(Vector3(11, 2, 3), child->_getDerivedPosition());
+    CPPUNIT_ASSERT_EQUAL(Vector3(11, 2, 4), grandChild->_getDerivedPosition());
+    CPPUNIT_ASSERT(!isDirty(root));
+    CPPUNIT_ASSERT(!isDirty(child));
+    CPPUNIT_ASSERT(!isDirty(grandChild));
+
+    delete grandChild;
+    delete child;
+    delete root;
+}
+//--------------------------------------------------------------------------
+void NodeDirtyTests::testUntouchedPacksAreSkipped()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Fill two SIMD packs at depth 0
+    const size_t numNodes = ARRAY_PACKED_REALS * 2u;
+    SceneNode *nodes[numNodes];
+    for (size_t i = 0; i < numNodes; ++i)
+        nodes[i] = createNode(i + 1u, 0);
+    updateAllTransforms();
+
+    SceneNode *touched = nodes[0];
+    SceneNode *untouched = nodes[numNodes - 1u];
+    // They must not share a pack, or 'untouched' would be updated along with 'touched'
+    CPPUNIT_ASSERT(touched->_getTransform().mDirty != untouched->_getTransform().mDirty);
+
+    touched->setPosition(Vector3(5, 0, 0));
+
+    // Change the local transform behind the dirty flag's back
+    Transform &t = untouched->_getTransform();
+    t.mPosition->setFromVector3(Vector3(7, 0, 0), t.mIndex);
+
+    updateAllTransforms();
+    CPPUNIT_ASSERT_EQUAL(Vector3(5, 0, 0), touched->_getDerivedPosition());
+    // Its pack was skipped, so the derived position is stale
+    CPPUNIT_ASSERT_EQUAL(Vector3::ZERO, untouched->_getDerivedPosition());
+
+    untouched->_markTransformDirty();
+    updateAllTransforms();
+    CPPUNIT_ASSERT_EQUAL(Vector3(7, 0, 0), untouched->_getDerivedPosition());
+
+    for (size_t i = 0; i < numNodes; ++i)
+        delete nodes[i];
+}
+//--------------------------------------------------------------------------
+void NodeDirtyTests::testReattachedNodeStartsDirty()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    SceneNode *rootA = createNode(1u, 0);
+    SceneNode *rootB = createNode(2u, 0);
+    SceneNode *child = createNode(3u, rootA);
+    rootA->setPosition(Vector3(1, 0, 0));
+    rootB->setPosition(Vector3(0, 1, 0));
+    child->setPosition(Vector3(0, 0, 1));
+    updateAllTransforms();
+    CPPUNIT_ASSERT_EQUAL(Vector3(1, 0, 1), child->_getDerivedPosition());
+
+    // Moving to a different slot (and parent) must flag the node, even though
+    // neither the node nor its new parent were modified
+    rootA->removeChild(child);
+    CPPUNIT_ASSERT(isDirty(child));
+    updateAllTransforms();
+
+    rootB->addChild(child);
+    CPPUNIT_ASSERT(isDirty(child));
+    CPPUNIT_ASSERT(!isDirty(rootB));
+
+    updateAllTransforms();
+    CPPUNIT_ASSERT_EQUAL(Vector3(0, 1, 1), child->_getDerivedPosition());
+
+    delete child;
+    delete rootB;
+    delete rootA;
+}
+//--------------------------------------------------------------------------
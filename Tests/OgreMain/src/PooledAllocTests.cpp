@@ -0,0 +1,286 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "PooledAllocTests.h"
+
+#if OGRE_MEMORY_ALLOCATOR == OGRE_MEMORY_ALLOCATOR_POOLED
+
+#include "Threading/OgreThreads.h"
+#include "ogrestd/vector.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(PooledAllocTests);
+
+namespace
+{
+    /// Nothing else in the tests allocates from this category
+    const MemoryCategory c_testCategory = MEMCATEGORY_SCRIPTING;
+
+    const size_t c_numThreads = 4u;
+    const size_t c_allocationsPerThread = 2048u;
+
+    size_t getTestSize(size_t idx)
+    {
+        // Spans several size classes, plus the occasional allocation too big to be pooled
+        return (idx % 97u == 0u) ? 40000u + idx : 1u + (idx * 37u) % 3000u;
+    }
+
+    struct ThreadData
+    {
+        /// Half of the allocations are kept for the main thread to free them
+        void *keptPtrs[c_allocationsPerThread / 2u];
+        size_t keptBytes[c_allocationsPerThread / 2u];
+        bool corrupted;
+    };
+
+    unsigned long pooledAllocThread(ThreadHandle *threadHandle)
+    {
+        ThreadData *threadData = reinterpret_cast<ThreadData *>(threadHandle->getUserParam());
+        const uint8 pattern = static_cast<uint8>(threadHandle->getThreadIdx() + 1u);
+
+        void *ptrs[c_allocationsPerThread];
+        for (size_t i = 0; i < c_allocationsPerThread; ++i)
+        {
+            ptrs[i] = PooledAllocPolicy::allocateBytes(getTestSize(i), c_testCategory);
+            memset(ptrs[i], pattern, getTestSize(i));
+        }
+
+        threadData->corrupted = false;
+        for (size_t i = 0; i < c_allocationsPerThread; ++i)
+        {
+            const uint8 *data = reinterpret_cast<const uint8 *>(ptrs[i]);
+            for (size_t j = 0; j < getTestSize(i); ++j)
+                threadData->corrupted |= data[j] != pattern;
+
+            if (i & 0x01u)
+            {
+                PooledAllocPolicy::deallocateBytes(ptrs[i]);
+            }
+            else
+            {
+                threadData->keptPtrs[i >> 1u] = ptrs[i];
+                threadData->keptBytes[i >> 1u] = getTestSize(i);
+            }
+        }
+
+        // The thread cache is returned to the shared pool when the thread exits
+        return 0;
+    }
+    THREAD_DECLARE(pooledAllocThread);
+}
+//--------------------------------------------------------------------------
+void PooledAllocTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void PooledAllocTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void PooledAllocTests::testSizeClasses()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Boundaries of the 16 byte steps, the power of two steps,
+    // the biggest pooled size and the ones going to the system
+    const size_t sizes[] = { 0u, 1u, 15u, 16u, 17u, 255u, 256u, 257u, 320u, 321u,
+                             1000u, 4096u, 32767u, 32768u, 32769u, 100000u };
+    const size_t numSizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    void *ptrs[numSizes];
+    for (size_t i = 0; i < numSizes; ++i)
+    {
+        ptrs[i] = PooledAllocPolicy::allocateBytes(sizes[i], c_testCategory);
+        CPPUNIT_ASSERT(ptrs[i] != 0);
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, reinterpret_cast<size_t>(ptrs[i]) & 0x0Fu);
+        memset(ptrs[i], static_cast<int>(i + 1u), sizes[i]);
+    }
+
+    // Writing the whole requested size must not have stomped any other allocation
+    for (size_t i = 0; i < numSizes; ++i)
+    {
+        const uint8 *data = reinterpret_cast<const uint8 *>(ptrs[i]);
+        for (size_t j = 0; j < sizes[i]; ++j)
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint8>(i + 1u), data[j]);
+        PooledAllocPolicy::deallocateBytes(ptrs[i]);
+    }
+
+    CPPUNIT_ASSERT(PooledAllocPolicy::getReservedBytes() > 0u);
+
+    // Must be a no-op
+    PooledAllocPolicy::deallocateBytes(0);
+}
+//--------------------------------------------------------------------------
+void PooledAllocTests::testBlockReuse()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Start from an empty thread cache so freeing can't trigger a batch return
+    PooledAllocPolicy::flushThreadCache();
+
+    void *ptr = PooledAllocPolicy::allocateBytes(48u, c_testCategory);
+    PooledAllocPolicy::deallocateBytes(ptr);
+
+    // 33 to 48 bytes share a size class. The block just freed is reused first
+    void *ptr2 = PooledAllocPolicy::allocateBytes(40u, c_testCategory);
+    CPPUNIT_ASSERT(ptr == ptr2);
+    PooledAllocPolicy::deallocateBytes(ptr2);
+
+    // Allocating from a warm cache doesn't need more memory from the system
+    const size_t reservedBytes = PooledAllocPolicy::getReservedBytes();
+    for (size_t i = 0; i < 100u; ++i)
+    {
+        ptr = PooledAllocPolicy::allocateBytes(48u, c_testCategory);
+        PooledAllocPolicy::deallocateBytes(ptr);
+    }
+    CPPUNIT_ASSERT_EQUAL(reservedBytes, PooledAllocPolicy::getReservedBytes());
+}
+//--------------------------------------------------------------------------
+void PooledAllocTests::testCategoryStats()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const PooledAllocCategoryStats before = PooledAllocPolicy::getCategoryStats(c_testCategory);
+
+    void *small = PooledAllocPolicy::allocateBytes(100u, c_testCategory);
+    void *large = PooledAllocPolicy::allocateBytes(40000u, c_testCategory);
+    // The macros must forward the category too
+    void *fromMacro = OGRE_MALLOC(64u, c_testCategory);
+
+    PooledAllocCategoryStats stats = PooledAllocPolicy::getCategoryStats(c_testCategory);
+    CPPUNIT_ASSERT_EQUAL(before.liveBytes + 40164u, stats.liveBytes);
+    CPPUNIT_ASSERT_EQUAL(before.liveAllocations + 3u, stats.liveAllocations);
+    CPPUNIT_ASSERT_EQUAL(before.totalAllocations + 3u, stats.totalAllocations);
+    CPPUNIT_ASSERT(stats.peakBytes >= stats.liveBytes);
+
+    const size_t peakBytes = stats.peakBytes;
+    PooledAllocPolicy::deallocateBytes(large);
+    stats = PooledAllocPolicy::getCategoryStats(c_testCategory);
+    CPPUNIT_ASSERT_EQUAL(before.liveBytes + 164u, stats.liveBytes);
+    CPPUNIT_ASSERT_EQUAL(before.liveAllocations + 2u, stats.liveAllocations);
+    CPPUNIT_ASSERT_EQUAL(before.totalAllocations + 3u, stats.totalAllocations);
+    CPPUNIT_ASSERT_EQUAL(peakBytes, stats.peakBytes);
+
+    PooledAllocPolicy::resetPeakStats();
+    stats = PooledAllocPolicy::getCategoryStats(c_testCategory);
+    CPPUNIT_ASSERT_EQUAL(stats.liveBytes, stats.peakBytes);
+
+    OGRE_FREE(fromMacro, c_testCategory);
+    PooledAllocPolicy::deallocateBytes(small);
+    stats = PooledAllocPolicy::getCategoryStats(c_testCategory);
+    CPPUNIT_ASSERT_EQUAL(before.liveBytes, stats.liveBytes);
+    CPPUNIT_ASSERT_EQUAL(before.liveAllocations, stats.liveAllocations);
+
+    // Other categories weren't affected
+    const PooledAllocCategoryStats renderSysBefore =
+        PooledAllocPolicy::getCategoryStats(MEMCATEGORY_RENDERSYS);
+    PooledAllocPolicy::deallocateBytes(PooledAllocPolicy::allocateBytes(16u, c_testCategory));
+    CPPUNIT_ASSERT_EQUAL(renderSysBefore.totalAllocations,
+                         PooledAllocPolicy::getCategoryStats(MEMCATEGORY_RENDERSYS).totalAllocations);
+}
+//--------------------------------------------------------------------------
+void PooledAllocTests::testAlignedPolicy()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const PooledAllocCategoryStats before = PooledAllocPolicy::getCategoryStats(c_testCategory);
+
+    void *ptrs[8];
+    for (size_t i = 0; i < 8u; ++i)
+    {
+        ptrs[i] = PooledAlignedAllocPolicy<64>::allocateBytes(1u + i * 100u, c_testCategory);
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, reinterpret_cast<size_t>(ptrs[i]) & 63u);
+        memset(ptrs[i], 0xFF, 1u + i * 100u);
+    }
+
+    void *simd = OGRE_MALLOC_SIMD(100u, c_testCategory);
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, reinterpret_cast<size_t>(simd) & (OGRE_SIMD_ALIGNMENT - 1u));
+
+    CPPUNIT_ASSERT_EQUAL(before.liveAllocations + 9u,
+                         PooledAllocPolicy::getCategoryStats(c_testCategory).liveAllocations);
+
+    OGRE_FREE_SIMD(simd, c_testCategory);
+    for (size_t i = 0; i < 8u; ++i)
+        PooledAlignedAllocPolicy<64>::deallocateBytes(ptrs[i]);
+
+    const PooledAllocCategoryStats after = PooledAllocPolicy::getCategoryStats(c_testCategory);
+    CPPUNIT_ASSERT_EQUAL(before.liveBytes, after.liveBytes);
+    CPPUNIT_ASSERT_EQUAL(before.liveAllocations, after.liveAllocations);
+}
+//--------------------------------------------------------------------------
+void PooledAllocTests::testMultipleThreads()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const PooledAllocCategoryStats before = PooledAllocPolicy::getCategoryStats(c_testCategory);
+
+    ThreadData *threadData = new ThreadData[c_numThreads];
+    ThreadHandleVec threadHandles;
+    for (size_t i = 0; i < c_numThreads; ++i)
+    {
+        threadHandles.push_back(
+            Threads::CreateThread(THREAD_GET(pooledAllocThread), i, &threadData[i]));
+    }
+    Threads::WaitForThreads(threadHandles);
+
+    // Exited threads published what they allocated & freed
+    size_t keptBytes = 0u;
+    for (size_t i = 0; i < c_numThreads; ++i)
+    {
+        CPPUNIT_ASSERT(!threadData[i].corrupted);
+        for (size_t j = 0; j < c_allocationsPerThread / 2u; ++j)
+            keptBytes += threadData[i].keptBytes[j];
+    }
+
+    PooledAllocCategoryStats stats = PooledAllocPolicy::getCategoryStats(c_testCategory);
+    CPPUNIT_ASSERT_EQUAL(before.liveBytes + keptBytes, stats.liveBytes);
+    CPPUNIT_ASSERT_EQUAL(before.liveAllocations + c_numThreads * c_allocationsPerThread / 2u,
+                         stats.liveAllocations);
+    CPPUNIT_ASSERT_EQUAL(before.totalAllocations + c_numThreads * c_allocationsPerThread,
+                         stats.totalAllocations);
+
+    // Blocks allocated by other threads can be freed from this one
+    for (size_t i = 0; i < c_numThreads; ++i)
+    {
+        for (size_t j = 0; j < c_allocationsPerThread / 2u; ++j)
+            PooledAllocPolicy::deallocateBytes(threadData[i].keptPtrs[j]);
+    }
+    delete[] threadData;
+
+    stats = PooledAllocPolicy::getCategoryStats(c_testCategory);
+    CPPUNIT_ASSERT_EQUAL(before.liveBytes, stats.liveBytes);
+    CPPUNIT_ASSERT_EQUAL(before.liveAllocations, stats.liveAllocations);
+}
+
+#endif
@@ -75,6 +75,15 @@ public:
     }
 };
 //--------------------------------------------------------------------------
+class Uint64SortFunctor
+{
+public:
+    uint64 operator()(const uint64& p) const
+    {
+        return p;
+    }
+};
+//--------------------------------------------------------------------------
 void RadixSortTests::testFloatVector()
 {
     UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
@@ -219,5 +228,28 @@ void RadixSortTests::testIntVector()
     }
 }
 //--------------------------------------------------------------------------
+void RadixSortTests::testUint64Vector()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
 
+    std::vector<uint64> container;
+    Uint64SortFunctor func;
+    RadixSort<std::vector<uint64>, uint64, uint64> sorter;
 
+    for (int i = 0; i < 1000; ++i)
+    {
+        // Leave the middle bytes untouched, so the passes that sort them are skipped
+        const uint64 high = (uint64)Math::RangeRandom(0, 255) << 56u;
+        container.push_back(high | (uint64)Math::RangeRandom(0, 1e4));
+    }
+
+    sorter.sort(container, func);
+
+    std::vector<uint64>::iterator v = container.begin();
+    uint64 lastValue = *v++;
+    for (;v != container.end(); ++v)
+    {
+        CPPUNIT_ASSERT(*v >= lastValue);
+        lastValue = *v;
+    }
+}
@@ -0,0 +1,321 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "RenderQueueTests.h"
+
+#include "OgreRenderQueue.h"
+#include "Threading/OgreTaskScheduler.h"
+
+#include "UnitTestSuite.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(RenderQueueTests);
+
+static const size_t c_numThreads = 4u;
+
+typedef std::vector<QueuedRenderable> QueuedRenderableVec;
+
+/// Creates QueuedRenderables with made up (never dereferenced) pointers
+static QueuedRenderableVec createQueuedRenderables(size_t numRenderables)
+{
+    QueuedRenderableVec retVal;
+    retVal.reserve(numRenderables);
+    for (size_t i = 0; i < numRenderables; ++i)
+    {
+        // Several Renderables per MovableObject, and repeated hashes
+        Renderable *renderable = reinterpret_cast<Renderable *>(0x1000u + i * 64u);
+        const MovableObject *movableObject =
+            reinterpret_cast<const MovableObject *>(0x100000u + (i / 3u) * 64u);
+        retVal.push_back(QueuedRenderable((i * 7919u) % 97u, renderable, movableObject));
+    }
+    return retVal;
+}
+
+static QueuedRenderableFingerprint calculateFingerprint(const QueuedRenderableVec &queuedRenderables)
+{
+    QueuedRenderableFingerprint fingerprint;
+    if (!queuedRenderables.empty())
+        fingerprint.add(&queuedRenderables.front(), &queuedRenderables.front() + queuedRenderables.size());
+    return fingerprint;
+}
+
+static QueuedRenderableSet createSet(const QueuedRenderableVec &queuedRenderables)
+{
+    QueuedRenderableSet set;
+    set.reset(queuedRenderables.size());
+    if (!queuedRenderables.empty())
+        set.add(&queuedRenderables.front(), &queuedRenderables.front() + queuedRenderables.size());
+    return set;
+}
+
+/// Same check RenderQueue::reuseLastSort does on a fingerprint hit
+static bool matchesExactly(QueuedRenderableSet &set, const QueuedRenderableVec &queuedRenderables)
+{
+    if (set.size() != queuedRenderables.size())
+        return false;
+    set.resetMatches();
+    if (!queuedRenderables.empty() &&
+        !set.match(&queuedRenderables.front(), &queuedRenderables.front() + queuedRenderables.size()))
+    {
+        return false;
+    }
+    return set.allMatched();
+}
+
+/// Adds the QueuedRenderables to a per-thread array each, like SceneManager's culling
+/// does with RenderQueue::addRenderableV2. Which thread gets what depends on work stealing.
+class AddPerThreadTask : public RangeTask
+{
+public:
+    const QueuedRenderableVec &src;
+    QueuedRenderableVec perThread[c_numThreads];
+
+    AddPerThreadTask(const QueuedRenderableVec &_src) : src(_src) {}
+
+    void execute(size_t begin, size_t end, size_t threadIdx) override
+    {
+        perThread[threadIdx].insert(perThread[threadIdx].end(), src.begin() + (ptrdiff_t)begin,
+                                    src.begin() + (ptrdiff_t)end);
+    }
+
+    QueuedRenderableFingerprint calculateFingerprint() const
+    {
+        // Same as RenderQueue::sortRenderQueue
+        QueuedRenderableFingerprint fingerprint;
+        for (size_t i = 0; i < c_numThreads; ++i)
+        {
+            if (!perThread[i].empty())
+                fingerprint.add(&perThread[i].front(), &perThread[i].front() + perThread[i].size());
+        }
+        return fingerprint;
+    }
+};
+
+//--------------------------------------------------------------------------
+void RenderQueueTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void RenderQueueTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void RenderQueueTests::testFingerprintOrderInsensitive()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    QueuedRenderableVec queuedRenderables = createQueuedRenderables(1000u);
+    const QueuedRenderableFingerprint reference = calculateFingerprint(queuedRenderables);
+    CPPUNIT_ASSERT_EQUAL((size_t)1000u, reference.numRenderables);
+
+    std::reverse(queuedRenderables.begin(), queuedRenderables.end());
+    CPPUNIT_ASSERT(reference == calculateFingerprint(queuedRenderables));
+
+    std::sort(queuedRenderables.begin(), queuedRenderables.end());
+    CPPUNIT_ASSERT(reference == calculateFingerprint(queuedRenderables));
+
+    // Adding in several pieces is the same as adding all at once
+    QueuedRenderableFingerprint pieces;
+    pieces.add(&queuedRenderables[0], &queuedRenderables[0] + 10u);
+    pieces.add(&queuedRenderables[0] + 10u, &queuedRenderables[0] + 600u);
+    pieces.add(&queuedRenderables[0] + 600u, &queuedRenderables[0] + 1000u);
+    CPPUNIT_ASSERT(reference == pieces);
+
+    CPPUNIT_ASSERT(QueuedRenderableFingerprint() == calculateFingerprint(QueuedRenderableVec()));
+}
+//--------------------------------------------------------------------------
+void RenderQueueTests::testFingerprintMultithreaded()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const QueuedRenderableVec queuedRenderables = createQueuedRenderables(20000u);
+    const QueuedRenderableFingerprint reference = calculateFingerprint(queuedRenderables);
+
+    TaskScheduler taskScheduler(c_numThreads);
+
+    // Emulate several frames. The split across threads changes every time,
+    // but the fingerprint must not.
+    for (size_t frame = 0; frame < 8u; ++frame)
+    {
+        AddPerThreadTask task(queuedRenderables);
+        taskScheduler.addTask(&task, queuedRenderables.size(), 4u);
+        taskScheduler.waitForAll();
+
+        size_t numAdded = 0;
+        for (size_t i = 0; i < c_numThreads; ++i)
+            numAdded += task.perThread[i].size();
+        CPPUNIT_ASSERT_EQUAL(queuedRenderables.size(), numAdded);
+
+        CPPUNIT_ASSERT(reference == task.calculateFingerprint());
+    }
+}
+//--------------------------------------------------------------------------
+void RenderQueueTests::testFingerprintDetectsChanges()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const QueuedRenderableVec queuedRenderables = createQueuedRenderables(1000u);
+    const QueuedRenderableFingerprint reference = calculateFingerprint(queuedRenderables);
+
+    // Different hash (e.g. the depth changed)
+    QueuedRenderableVec changed = queuedRenderables;
+    changed[500].hash += 1u;
+    CPPUNIT_ASSERT(reference != calculateFingerprint(changed));
+
+    // Different Renderable
+    changed = queuedRenderables;
+    changed[0].renderable = reinterpret_cast<Renderable *>(0x1u);
+    CPPUNIT_ASSERT(reference != calculateFingerprint(changed));
+
+    // Different MovableObject
+    changed = queuedRenderables;
+    changed[999].movableObject = reinterpret_cast<const MovableObject *>(0x1u);
+    CPPUNIT_ASSERT(reference != calculateFingerprint(changed));
+
+    // Same count, but one Renderable added twice instead of another one
+    changed = queuedRenderables;
+    changed[1] = changed[2];
+    CPPUNIT_ASSERT(reference != calculateFingerprint(changed));
+
+    // Swapping the hashes of two Renderables
+    changed = queuedRenderables;
+    std::swap(changed[3].hash, changed[4].hash);
+    CPPUNIT_ASSERT(changed[3].hash != changed[4].hash);
+    CPPUNIT_ASSERT(reference != calculateFingerprint(changed));
+
+    // Removed
+    changed = queuedRenderables;
+    changed.pop_back();
+    CPPUNIT_ASSERT(reference != calculateFingerprint(changed));
+}
+//--------------------------------------------------------------------------
+void RenderQueueTests::testSetMatchesAnyOrder()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const QueuedRenderableVec queuedRenderables = createQueuedRenderables(20000u);
+    QueuedRenderableSet set = createSet(queuedRenderables);
+    CPPUNIT_ASSERT_EQUAL(queuedRenderables.size(), set.size());
+
+    QueuedRenderableVec reordered = queuedRenderables;
+    std::reverse(reordered.begin(), reordered.end());
+    CPPUNIT_ASSERT(matchesExactly(set, reordered));
+    std::sort(reordered.begin(), reordered.end());
+    CPPUNIT_ASSERT(matchesExactly(set, reordered));
+
+    // The split across threads changes every frame, the set must still match it
+    TaskScheduler taskScheduler(c_numThreads);
+    for (size_t frame = 0; frame < 4u; ++frame)
+    {
+        AddPerThreadTask task(queuedRenderables);
+        taskScheduler.addTask(&task, queuedRenderables.size(), 4u);
+        taskScheduler.waitForAll();
+
+        set.resetMatches();
+        for (size_t i = 0; i < c_numThreads; ++i)
+        {
+            if (!task.perThread[i].empty())
+            {
+                CPPUNIT_ASSERT(set.match(&task.perThread[i].front(),
+                                         &task.perThread[i].front() + task.perThread[i].size()));
+            }
+        }
+        CPPUNIT_ASSERT(set.allMatched());
+    }
+
+    QueuedRenderableSet emptySet = createSet(QueuedRenderableVec());
+    CPPUNIT_ASSERT(matchesExactly(emptySet, QueuedRenderableVec()));
+    CPPUNIT_ASSERT(!matchesExactly(emptySet, createQueuedRenderables(1u)));
+}
+//--------------------------------------------------------------------------
+void RenderQueueTests::testSetRejectsChanges()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const QueuedRenderableVec queuedRenderables = createQueuedRenderables(1000u);
+    QueuedRenderableSet set = createSet(queuedRenderables);
+    CPPUNIT_ASSERT(matchesExactly(set, queuedRenderables));
+
+    // The set doesn't depend on the fingerprint at all: anything that would collide
+    // with it still has to have exactly the same entries
+    QueuedRenderableVec changed = queuedRenderables;
+    changed[500].hash += 1u;
+    CPPUNIT_ASSERT(!matchesExactly(set, changed));
+
+    changed = queuedRenderables;
+    changed[0].renderable = reinterpret_cast<Renderable *>(0x1u);
+    CPPUNIT_ASSERT(!matchesExactly(set, changed));
+
+    changed = queuedRenderables;
+    changed[999].movableObject = reinterpret_cast<const MovableObject *>(0x1u);
+    CPPUNIT_ASSERT(!matchesExactly(set, changed));
+
+    // Renderable and MovableObject swapped between two entries
+    changed = queuedRenderables;
+    std::swap(changed[10].renderable, changed[11].renderable);
+    CPPUNIT_ASSERT(!matchesExactly(set, changed));
+
+    changed = queuedRenderables;
+    changed.pop_back();
+    CPPUNIT_ASSERT(!matchesExactly(set, changed));
+
+    changed = queuedRenderables;
+    changed.push_back(changed.back());
+    CPPUNIT_ASSERT(!matchesExactly(set, changed));
+
+    // The set is still usable after failed matches
+    CPPUNIT_ASSERT(matchesExactly(set, queuedRenderables));
+}
+//--------------------------------------------------------------------------
+void RenderQueueTests::testSetMultiplicity()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Same Renderable queued several times (e.g. one per pass)
+    QueuedRenderableVec queuedRenderables = createQueuedRenderables(4u);
+    queuedRenderables.push_back(queuedRenderables[1]);
+    queuedRenderables.push_back(queuedRenderables[1]);
+    QueuedRenderableSet set = createSet(queuedRenderables);
+    CPPUNIT_ASSERT(matchesExactly(set, queuedRenderables));
+
+    // Same count, but [1] appears twice and [2] three times
+    QueuedRenderableVec changed = queuedRenderables;
+    changed[4] = changed[2];
+    changed[5] = changed[2];
+    CPPUNIT_ASSERT(!matchesExactly(set, changed));
+
+    // Same count, but [1] appears four times
+    changed = queuedRenderables;
+    changed[0] = changed[1];
+    CPPUNIT_ASSERT(!matchesExactly(set, changed));
+}
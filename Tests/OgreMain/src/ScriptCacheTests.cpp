@@ -0,0 +1,204 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+
+#include "ScriptCacheTests.h"
+
+#include "OgreDataStream.h"
+#include "OgreResourceGroupManager.h"
+#include "OgreScriptCompiler.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ScriptCacheTests);
+
+namespace
+{
+    const char *c_materialScript =
+        "material ScriptCacheTest\n"
+        "{\n"
+        "    technique\n"
+        "    {\n"
+        "        pass\n"
+        "        {\n"
+        "            diffuse 1 0.5 0.25 1\n"
+        "        }\n"
+        "    }\n"
+        "}\n";
+
+    DataStreamPtr createScriptStream(const String &name, String &script)
+    {
+        return DataStreamPtr(OGRE_NEW MemoryDataStream(name, &script[0], script.size(), false, true));
+    }
+
+    ConcreteNodeListPtr prepareScript(ScriptCompilerManager *scriptCompilerManager,
+                                      const String &name, String script)
+    {
+        DataStreamPtr stream = createScriptStream(name, script);
+        return any_cast<ConcreteNodeListPtr>(scriptCompilerManager->prepareScript(stream));
+    }
+
+    bool areTreesEqual(const ConcreteNodeList &a, const ConcreteNodeList &b,
+                       const ConcreteNode *parentA, const ConcreteNode *parentB)
+    {
+        if (a.size() != b.size())
+            return false;
+
+        ConcreteNodeList::const_iterator itA = a.begin();
+        ConcreteNodeList::const_iterator itB = b.begin();
+        while (itA != a.end())
+        {
+            const ConcreteNode *nodeA = itA->get();
+            const ConcreteNode *nodeB = itB->get();
+            if (nodeA->token != nodeB->token || nodeA->file != nodeB->file ||
+                nodeA->line != nodeB->line || nodeA->type != nodeB->type ||
+                nodeA->parent != parentA || nodeB->parent != parentB ||
+                !areTreesEqual(nodeA->children, nodeB->children, nodeA, nodeB))
+            {
+                return false;
+            }
+            ++itA;
+            ++itB;
+        }
+
+        return true;
+    }
+
+    /// Saves the cache and returns a stream ready to be read from
+    DataStreamPtr saveCache(ScriptCompilerManager *scriptCompilerManager)
+    {
+        MemoryDataStream *memStream = OGRE_NEW MemoryDataStream("ScriptCache", 64u * 1024u);
+        DataStreamPtr stream(memStream);
+        scriptCompilerManager->saveScriptCache(stream);
+
+        // Trim to what was written, so that reading past it hits eof
+        const size_t bytesWritten = stream->tell();
+        MemoryDataStream *trimmed = OGRE_NEW MemoryDataStream("ScriptCache", bytesWritten);
+        memcpy(trimmed->getPtr(), memStream->getPtr(), bytesWritten);
+        return DataStreamPtr(trimmed);
+    }
+}
+//--------------------------------------------------------------------------
+void ScriptCacheTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    mResourceGroupManager = OGRE_NEW ResourceGroupManager();
+    mScriptCompilerManager = OGRE_NEW ScriptCompilerManager();
+}
+//--------------------------------------------------------------------------
+void ScriptCacheTests::tearDown()
+{
+    OGRE_DELETE mScriptCompilerManager;
+    OGRE_DELETE mResourceGroupManager;
+}
+//--------------------------------------------------------------------------
+void ScriptCacheTests::testRoundTrip()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    mScriptCompilerManager->setSaveScriptsToCache(true);
+    CPPUNIT_ASSERT(!mScriptCompilerManager->isScriptCacheDirty());
+
+    ConcreteNodeListPtr parsed = prepareScript(mScriptCompilerManager, "Test.material",
+                                               c_materialScript);
+    CPPUNIT_ASSERT(!parsed->empty());
+    CPPUNIT_ASSERT(mScriptCompilerManager->isScriptCacheDirty());
+
+    DataStreamPtr cacheStream = saveCache(mScriptCompilerManager);
+    CPPUNIT_ASSERT(cacheStream->size() > 0u);
+
+    mScriptCompilerManager->clearScriptCache();
+    CPPUNIT_ASSERT(!mScriptCompilerManager->isScriptCacheDirty());
+
+    mScriptCompilerManager->loadScriptCache(cacheStream);
+    CPPUNIT_ASSERT(!mScriptCompilerManager->isScriptCacheDirty());
+
+    // A cache hit does not touch the cache, hence it stays clean
+    ConcreteNodeListPtr cached = prepareScript(mScriptCompilerManager, "Test.material",
+                                               c_materialScript);
+    CPPUNIT_ASSERT(!mScriptCompilerManager->isScriptCacheDirty());
+    CPPUNIT_ASSERT(areTreesEqual(*parsed, *cached, 0, 0));
+}
+//--------------------------------------------------------------------------
+void ScriptCacheTests::testModifiedScriptIsParsedAgain()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    mScriptCompilerManager->setSaveScriptsToCache(true);
+    prepareScript(mScriptCompilerManager, "Test.material", c_materialScript);
+
+    mScriptCompilerManager->loadScriptCache(saveCache(mScriptCompilerManager));
+    CPPUNIT_ASSERT(!mScriptCompilerManager->isScriptCacheDirty());
+
+    String modifiedScript(c_materialScript);
+    modifiedScript.replace(modifiedScript.find("0.25"), 4u, "0.75");
+
+    // Same name, different contents: the stale entry must not be used
+    ConcreteNodeListPtr parsed = prepareScript(mScriptCompilerManager, "Test.material",
+                                               modifiedScript);
+    CPPUNIT_ASSERT(mScriptCompilerManager->isScriptCacheDirty());
+
+    mScriptCompilerManager->setSaveScriptsToCache(false);
+    mScriptCompilerManager->clearScriptCache();
+    ConcreteNodeListPtr reference = prepareScript(mScriptCompilerManager, "Test.material",
+                                                  modifiedScript);
+    CPPUNIT_ASSERT(areTreesEqual(*parsed, *reference, 0, 0));
+}
+//--------------------------------------------------------------------------
+void ScriptCacheTests::testSaveWhenClean()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Scripts are not cached unless requested
+    prepareScript(mScriptCompilerManager, "Test.material", c_materialScript);
+    CPPUNIT_ASSERT(!mScriptCompilerManager->isScriptCacheDirty());
+
+    DataStreamPtr stream(OGRE_NEW MemoryDataStream("ScriptCache", 64u));
+    mScriptCompilerManager->saveScriptCache(stream);
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, stream->tell());
+}
+//--------------------------------------------------------------------------
+void ScriptCacheTests::testInvalidCacheIsIgnored()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    mScriptCompilerManager->setSaveScriptsToCache(true);
+    prepareScript(mScriptCompilerManager, "Test.material", c_materialScript);
+
+    String garbage("This is not a script cache");
+    mScriptCompilerManager->loadScriptCache(createScriptStream("ScriptCache", garbage));
+    CPPUNIT_ASSERT(!mScriptCompilerManager->isScriptCacheDirty());
+
+    // The previous entry was discarded, thus the script gets parsed & cached again
+    prepareScript(mScriptCompilerManager, "Test.material", c_materialScript);
+    CPPUNIT_ASSERT(mScriptCompilerManager->isScriptCacheDirty());
+}
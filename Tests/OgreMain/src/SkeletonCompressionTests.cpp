@@ -0,0 +1,260 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "SkeletonCompressionTests.h"
+
+#include "Animation/OgreSkeletonCompressionSettings.h"
+#include "Animation/OgreSkeletonTrack.h"
+#include "Math/Array/OgreKfTransformArrayMemoryManager.h"
+#include "OgreMath.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(SkeletonCompressionTests);
+
+static const size_t c_maxKeyFrames = 16u;
+
+/// Builds a normalized quaternion whose component largestIdx (w, x, y, z) is the largest
+/// in magnitude, with the given sign. 'seed' varies the three smaller components.
+static Quaternion makeQuaternion(size_t largestIdx, Real sign, size_t seed)
+{
+    Real components[4];
+    for (size_t i = 0u; i < 4u; ++i)
+    {
+        const Real fi = Real(i + seed * 4u);
+        components[i] = Real(0.45) * Math::Sin(Radian(fi * Real(1.7) + Real(0.3)));
+    }
+    components[largestIdx] = sign * Real(0.8);
+
+    Quaternion retVal(components[0], components[1], components[2], components[3]);
+    retVal.normalise();
+    return retVal;
+}
+
+/// Quantizes the track into memory allocated with OGRE_MALLOC_SIMD, which must be freed
+/// after the track is no longer used
+static uint8 *compressTrack(SkeletonTrack &track)
+{
+    SkeletonCompressionSettings settings;
+    settings.enabled = true;
+    settings.positionTolerance = 0;
+    settings.orientationTolerance = 0;
+    settings.scaleTolerance = 0;
+
+    track._bakeUnusedSlots();
+    const size_t numKeyFrames = track.getKeyFrames().size();
+    const size_t bytesNeeded = track._reduceKeyFrames(settings);
+    // Zero tolerance must keep every (non linear) keyframe
+    CPPUNIT_ASSERT_EQUAL(numKeyFrames, track.getKeyFrames().size());
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, bytesNeeded % OGRE_SIMD_ALIGNMENT);
+
+    uint8 *data = reinterpret_cast<uint8 *>(OGRE_MALLOC_SIMD(bytesNeeded, MEMCATEGORY_ANIMATION));
+    CPPUNIT_ASSERT_EQUAL(bytesNeeded, track._compress(data));
+    CPPUNIT_ASSERT(track.isCompressed());
+    return data;
+}
+
+//--------------------------------------------------------------------------
+void SkeletonCompressionTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    mMemoryManager = new KfTransformArrayMemoryManager(
+        0, c_maxKeyFrames * ARRAY_PACKED_REALS, std::numeric_limits<size_t>::max(),
+        c_maxKeyFrames * ARRAY_PACKED_REALS);
+    mMemoryManager->initialize();
+}
+//--------------------------------------------------------------------------
+void SkeletonCompressionTests::tearDown()
+{
+    mMemoryManager->destroy();
+    delete mMemoryManager;
+    mMemoryManager = 0;
+}
+//--------------------------------------------------------------------------
+void SkeletonCompressionTests::testOrientationRoundTrip()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // One keyframe per largest component (w, x, y, z) and sign
+    const size_t numKeyFrames = 8u;
+
+    SkeletonTrack track(0u, mMemoryManager);
+    for (size_t i = 0u; i < numKeyFrames; ++i)
+        track.addKeyFrame(Real(i), Real(1.0));
+    track._setMaxUsedSlot(ARRAY_PACKED_REALS - 1u);
+
+    KeyFrameRigVec &keyFrames = track._getKeyFrames();
+    for (size_t i = 0u; i < numKeyFrames; ++i)
+    {
+        const size_t largestIdx = i >> 1u;
+        const Real sign = (i & 0x01u) ? Real(-1.0) : Real(1.0);
+        for (size_t j = 0u; j < ARRAY_PACKED_REALS; ++j)
+        {
+            keyFrames[i].mBoneTransform->mPosition.setFromVector3(Vector3::ZERO, j);
+            keyFrames[i].mBoneTransform->mOrientation.setFromQuaternion(
+                makeQuaternion(largestIdx, sign, i * ARRAY_PACKED_REALS + j), j);
+            keyFrames[i].mBoneTransform->mScale.setFromVector3(Vector3::UNIT_SCALE, j);
+        }
+    }
+
+    uint8 *compressedData = compressTrack(track);
+
+    for (size_t i = 0u; i < numKeyFrames; ++i)
+    {
+        const size_t largestIdx = i >> 1u;
+        const Real sign = (i & 0x01u) ? Real(-1.0) : Real(1.0);
+
+        KfTransform decoded;
+        track.getKeyFrameTransform(i, decoded);
+
+        for (size_t j = 0u; j < ARRAY_PACKED_REALS; ++j)
+        {
+            const Quaternion original = makeQuaternion(largestIdx, sign, i * ARRAY_PACKED_REALS + j);
+            Quaternion result;
+            decoded.mOrientation.getAsQuaternion(result, j);
+
+            // q and -q are the same rotation; the encoding always rebuilds
+            // the largest component as positive, flipping the rest if needed
+            for (size_t k = 0u; k < 4u; ++k)
+                CPPUNIT_ASSERT(Math::Abs(result[k] - original[k] * sign) < Real(1e-4));
+            CPPUNIT_ASSERT(result[largestIdx] > Real(0.0));
+
+            // Error bound documented in SkeletonCompressionSettings. acos( dot ) can't
+            // resolve angles this small in single precision, use the difference rotation
+            const Quaternion diff = original.UnitInverse() * result;
+            const Real sinHalfAngle = Math::Sqrt(diff.x * diff.x + diff.y * diff.y + diff.z * diff.z);
+            CPPUNIT_ASSERT(Real(2.0) * std::atan2(sinHalfAngle, Math::Abs(diff.w)) < Real(1e-4));
+            CPPUNIT_ASSERT(Math::Abs(result.Norm() - Real(1.0)) < Real(1e-4));
+        }
+    }
+
+    OGRE_FREE_SIMD(compressedData, MEMCATEGORY_ANIMATION);
+}
+//--------------------------------------------------------------------------
+void SkeletonCompressionTests::testPositionRoundTrip()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numKeyFrames = 12u;
+
+    SkeletonTrack track(0u, mMemoryManager);
+    for (size_t i = 0u; i < numKeyFrames; ++i)
+        track.addKeyFrame(Real(i), Real(1.0));
+    track._setMaxUsedSlot(ARRAY_PACKED_REALS - 1u);
+
+    KeyFrameRigVec &keyFrames = track._getKeyFrames();
+    Vector3 posMin[ARRAY_PACKED_REALS], posMax[ARRAY_PACKED_REALS];
+    for (size_t i = 0u; i < numKeyFrames; ++i)
+    {
+        for (size_t j = 0u; j < ARRAY_PACKED_REALS; ++j)
+        {
+            const Real t = Real(i) + Real(j) * Real(0.37);
+            const Vector3 pos(Real(10.0) * Math::Sin(Radian(t)), t * t * Real(0.5) - Real(3.0),
+                              Real(2.0) * Math::Cos(Radian(t * Real(1.3))) + Real(j));
+            keyFrames[i].mBoneTransform->mPosition.setFromVector3(pos, j);
+            keyFrames[i].mBoneTransform->mOrientation.setFromQuaternion(Quaternion::IDENTITY, j);
+            keyFrames[i].mBoneTransform->mScale.setFromVector3(Vector3::UNIT_SCALE, j);
+
+            posMin[j] = i == 0u ? pos : posMin[j];
+            posMax[j] = i == 0u ? pos : posMax[j];
+            posMin[j].makeFloor(pos);
+            posMax[j].makeCeil(pos);
+        }
+    }
+
+    uint8 *compressedData = compressTrack(track);
+
+    for (size_t i = 0u; i < numKeyFrames; ++i)
+    {
+        KfTransform decoded;
+        track.getKeyFrameTransform(i, decoded);
+
+        for (size_t j = 0u; j < ARRAY_PACKED_REALS; ++j)
+        {
+            const Real t = Real(i) + Real(j) * Real(0.37);
+            const Vector3 original(Real(10.0) * Math::Sin(Radian(t)), t * t * Real(0.5) - Real(3.0),
+                                   Real(2.0) * Math::Cos(Radian(t * Real(1.3))) + Real(j));
+            Vector3 result;
+            decoded.mPosition.getAsVector3(result, j);
+
+            // 16-bit quantization relative to the track bounds: at most half a step off
+            const Vector3 halfStep = (posMax[j] - posMin[j]) / Real(65535.0 * 2.0);
+            for (size_t k = 0u; k < 3u; ++k)
+                CPPUNIT_ASSERT(Math::Abs(result[k] - original[k]) <= halfStep[k] + Real(1e-5));
+        }
+    }
+
+    OGRE_FREE_SIMD(compressedData, MEMCATEGORY_ANIMATION);
+}
+//--------------------------------------------------------------------------
+void SkeletonCompressionTests::testConstantChannels()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numKeyFrames = 4u;
+    const Quaternion constantRot = makeQuaternion(2u, Real(-1.0), 5u);
+    const Vector3 constantScale(Real(1.5), Real(0.25), Real(3.0));
+
+    // Only the position is animated, and only one slot is used
+    SkeletonTrack track(0u, mMemoryManager);
+    for (size_t i = 0u; i < numKeyFrames; ++i)
+    {
+        track.addKeyFrame(Real(i), Real(1.0));
+        KfTransform *transform = track._getKeyFrames().back().mBoneTransform;
+        transform->mPosition.setFromVector3(Vector3(Real(i * i), Real(0.0), Real(0.0)), 0u);
+        transform->mOrientation.setFromQuaternion(constantRot, 0u);
+        transform->mScale.setFromVector3(constantScale, 0u);
+    }
+    track._setMaxUsedSlot(0u);
+
+    uint8 *compressedData = compressTrack(track);
+
+    for (size_t i = 0u; i < numKeyFrames; ++i)
+    {
+        KfTransform decoded;
+        track.getKeyFrameTransform(i, decoded);
+
+        // Constant channels are stored at full precision; unused slots were baked
+        for (size_t j = 0u; j < ARRAY_PACKED_REALS; ++j)
+        {
+            Quaternion rot;
+            Vector3 scale;
+            decoded.mOrientation.getAsQuaternion(rot, j);
+            decoded.mScale.getAsVector3(scale, j);
+            CPPUNIT_ASSERT(rot == constantRot);
+            CPPUNIT_ASSERT(scale == constantScale);
+        }
+    }
+
+    OGRE_FREE_SIMD(compressedData, MEMCATEGORY_ANIMATION);
+}
+//--------------------------------------------------------------------------
@@ -0,0 +1,282 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "TaskSchedulerTests.h"
+
+#include "Threading/OgreTaskScheduler.h"
+
+#include "UnitTestSuite.h"
+
+#include <atomic>
+#include <limits>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(TaskSchedulerTests);
+
+static const size_t c_numThreads = 4u;
+
+/// Global counter used to know in which order ranges were executed
+static std::atomic<size_t> g_executionStamp(0);
+
+/// Counts how many times each item was executed and records
+/// the first & last execution stamp of any of its ranges
+class CountingTask : public RangeTask
+{
+public:
+    std::vector<std::atomic<uint32> > itemCounts;
+    std::atomic<size_t> firstStamp;
+    std::atomic<size_t> lastStamp;
+    std::atomic<uint32> numBadRanges;
+    size_t granularity;
+    size_t numThreads;
+
+    CountingTask(size_t numItems, size_t _granularity, size_t _numThreads) :
+        itemCounts(numItems),
+        firstStamp(std::numeric_limits<size_t>::max()),
+        lastStamp(0),
+        numBadRanges(0),
+        granularity(_granularity),
+        numThreads(_numThreads)
+    {
+        for (size_t i = 0; i < numItems; ++i)
+            itemCounts[i].store(0);
+    }
+
+    void execute(size_t begin, size_t end, size_t threadIdx) override
+    {
+        const size_t stamp = g_executionStamp.fetch_add(1u);
+
+        if (begin % granularity != 0u || (end % granularity != 0u && end != itemCounts.size()) ||
+            begin >= end || end > itemCounts.size() || threadIdx >= numThreads)
+        {
+            ++numBadRanges;
+        }
+
+        for (size_t i = begin; i < end && i < itemCounts.size(); ++i)
+            ++itemCounts[i];
+
+        size_t prevFirst = firstStamp.load();
+        while (stamp < prevFirst && !firstStamp.compare_exchange_weak(prevFirst, stamp))
+        {
+        }
+        size_t prevLast = lastStamp.load();
+        while (stamp > prevLast && !lastStamp.compare_exchange_weak(prevLast, stamp))
+        {
+        }
+    }
+
+    bool allItemsExecutedOnce() const
+    {
+        for (size_t i = 0; i < itemCounts.size(); ++i)
+        {
+            if (itemCounts[i].load() != 1u)
+                return false;
+        }
+        return true;
+    }
+};
+
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testAllItemsExecutedOnce()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TaskScheduler taskScheduler(c_numThreads);
+    CPPUNIT_ASSERT_EQUAL(c_numThreads, taskScheduler.getNumThreads());
+
+    // Several tasks in flight at the same time, with sizes that don't divide evenly
+    const size_t numItems[] = { 1u, 7u, 100u, 1023u, 10000u };
+    const size_t numTasks = sizeof(numItems) / sizeof(numItems[0]);
+
+    CountingTask *tasks[numTasks];
+    for (size_t i = 0; i < numTasks; ++i)
+    {
+        tasks[i] = new CountingTask(numItems[i], 1u, c_numThreads);
+        taskScheduler.addTask(tasks[i], numItems[i], 1u);
+    }
+
+    taskScheduler.waitForAll();
+
+    for (size_t i = 0; i < numTasks; ++i)
+    {
+        CPPUNIT_ASSERT(tasks[i]->allItemsExecutedOnce());
+        CPPUNIT_ASSERT_EQUAL(0u, (unsigned)tasks[i]->numBadRanges.load());
+        delete tasks[i];
+    }
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testGranularity()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TaskScheduler taskScheduler(c_numThreads);
+
+    const size_t granularities[] = { 1u, 4u, 16u, 64u, 5000u };
+    const size_t numTasks = sizeof(granularities) / sizeof(granularities[0]);
+    const size_t numItems = 4099u;
+
+    for (size_t i = 0; i < numTasks; ++i)
+    {
+        CountingTask task(numItems, granularities[i], c_numThreads);
+        taskScheduler.addTask(&task, numItems, granularities[i]);
+        taskScheduler.waitForAll();
+
+        CPPUNIT_ASSERT(task.allItemsExecutedOnce());
+        CPPUNIT_ASSERT_EQUAL(0u, (unsigned)task.numBadRanges.load());
+    }
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testDependencyOrdering()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TaskScheduler taskScheduler(c_numThreads);
+
+    // Diamond:  A -> (B, C) -> D. Plus an independent task E that may run anytime
+    const size_t numItems = 2048u;
+    CountingTask taskA(numItems, 1u, c_numThreads);
+    CountingTask taskB(numItems, 1u, c_numThreads);
+    CountingTask taskC(numItems, 1u, c_numThreads);
+    CountingTask taskD(numItems, 1u, c_numThreads);
+    CountingTask taskE(numItems, 1u, c_numThreads);
+
+    const TaskScheduler::TaskId idA = taskScheduler.addTask(&taskA, numItems, 1u);
+    const TaskScheduler::TaskId idE = taskScheduler.addTask(&taskE, numItems, 1u);
+    const TaskScheduler::TaskId idB = taskScheduler.addTask(&taskB, numItems, 1u, &idA, 1u);
+    const TaskScheduler::TaskId idC = taskScheduler.addTask(&taskC, numItems, 1u, &idA, 1u);
+    // INVALID_TASK_ID dependencies must be ignored
+    const TaskScheduler::TaskId depsD[3] = { idB, TaskScheduler::INVALID_TASK_ID, idC };
+    taskScheduler.addTask(&taskD, numItems, 1u, depsD, 3u);
+
+    CPPUNIT_ASSERT(idE != TaskScheduler::INVALID_TASK_ID);
+
+    taskScheduler.waitForAll();
+
+    CPPUNIT_ASSERT(taskA.allItemsExecutedOnce());
+    CPPUNIT_ASSERT(taskB.allItemsExecutedOnce());
+    CPPUNIT_ASSERT(taskC.allItemsExecutedOnce());
+    CPPUNIT_ASSERT(taskD.allItemsExecutedOnce());
+    CPPUNIT_ASSERT(taskE.allItemsExecutedOnce());
+
+    // Every range of a dependent task started after every range of its dependencies
+    CPPUNIT_ASSERT(taskA.lastStamp.load() < taskB.firstStamp.load());
+    CPPUNIT_ASSERT(taskA.lastStamp.load() < taskC.firstStamp.load());
+    CPPUNIT_ASSERT(taskB.lastStamp.load() < taskD.firstStamp.load());
+    CPPUNIT_ASSERT(taskC.lastStamp.load() < taskD.firstStamp.load());
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testWaitFor()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TaskScheduler taskScheduler(c_numThreads);
+
+    const size_t numItems = 4096u;
+    CountingTask taskA(numItems, 1u, c_numThreads);
+    CountingTask taskB(numItems, 1u, c_numThreads);
+
+    const TaskScheduler::TaskId idA = taskScheduler.addTask(&taskA, numItems, 1u);
+    const TaskScheduler::TaskId idB = taskScheduler.addTask(&taskB, numItems, 1u, &idA, 1u);
+
+    // Waiting on the dependent task implies its dependency is done too
+    taskScheduler.waitFor(idB);
+    CPPUNIT_ASSERT(taskA.allItemsExecutedOnce());
+    CPPUNIT_ASSERT(taskB.allItemsExecutedOnce());
+
+    // Waiting again on a finished task must return immediately
+    taskScheduler.waitFor(idA);
+    taskScheduler.waitForAll();
+
+    // The scheduler can be reused after waitForAll
+    CountingTask taskC(numItems, 1u, c_numThreads);
+    const TaskScheduler::TaskId idC = taskScheduler.addTask(&taskC, numItems, 1u);
+    taskScheduler.waitFor(idC);
+    CPPUNIT_ASSERT(taskC.allItemsExecutedOnce());
+    taskScheduler.waitForAll();
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testSingleThread()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // With no worker threads the owner must execute everything while waiting
+    TaskScheduler taskScheduler(0u);
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, taskScheduler.getNumThreads());
+
+    const size_t numItems = 1000u;
+    CountingTask taskA(numItems, 8u, 1u);
+    CountingTask taskB(numItems, 8u, 1u);
+
+    const TaskScheduler::TaskId idA = taskScheduler.addTask(&taskA, numItems, 8u);
+    const TaskScheduler::TaskId idB = taskScheduler.addTask(&taskB, numItems, 8u, &idA, 1u);
+    taskScheduler.waitFor(idB);
+
+    CPPUNIT_ASSERT(taskA.allItemsExecutedOnce());
+    CPPUNIT_ASSERT(taskB.allItemsExecutedOnce());
+    CPPUNIT_ASSERT_EQUAL(0u, (unsigned)taskA.numBadRanges.load());
+    CPPUNIT_ASSERT_EQUAL(0u, (unsigned)taskB.numBadRanges.load());
+    CPPUNIT_ASSERT(taskA.lastStamp.load() < taskB.firstStamp.load());
+
+    taskScheduler.waitForAll();
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testEmptyTask()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TaskScheduler taskScheduler(c_numThreads);
+
+    CountingTask emptyTask(0u, 1u, c_numThreads);
+    const TaskScheduler::TaskId emptyId = taskScheduler.addTask(&emptyTask, 0u, 1u);
+    CPPUNIT_ASSERT(emptyId == TaskScheduler::INVALID_TASK_ID);
+
+    // Waiting on it must return immediately
+    taskScheduler.waitFor(emptyId);
+
+    // Tasks depending on an empty task run as if they had no dependency
+    const size_t numItems = 64u;
+    CountingTask task(numItems, 1u, c_numThreads);
+    const TaskScheduler::TaskId taskId = taskScheduler.addTask(&task, numItems, 1u, &emptyId, 1u);
+    taskScheduler.waitFor(taskId);
+    CPPUNIT_ASSERT(task.allItemsExecutedOnce());
+
+    CPPUNIT_ASSERT_EQUAL((unsigned)emptyTask.lastStamp.load(), 0u);
+    taskScheduler.waitForAll();
+}
+//--------------------------------------------------------------------------
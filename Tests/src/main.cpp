@@ -73,8 +73,11 @@ int main(int argc, char *argv[])
     }
 #endif
 
+    const bool wasSuccessful = result.wasSuccessful();
+
     UnitTestSuite::getSingletonPtr()->tearDownSuite();
     delete UnitTestSuite::getSingletonPtr();
 
-    return 0;
+    // Let CI scripts know whether any test failed
+    return wasSuccessful ? 0 : 1;
 }
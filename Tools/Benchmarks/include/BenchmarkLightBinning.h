@@ -0,0 +1,83 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _BenchmarkLightBinning_H_
+#define _BenchmarkLightBinning_H_
+
+#include "OgrePrerequisites.h"
+
+#include "ogrestd/vector.h"
+
+namespace Benchmark
+{
+    namespace LightBinningMethod
+    {
+        enum LightBinningMethod
+        {
+            /// ForwardClustered::setLightCellRangeBinning( false ): every light is tested
+            /// against every cell of every slice
+            BruteForce,
+            /// ForwardClustered::setLightCellRangeBinning( true ): every light is only tested
+            /// against the cells of its projected range
+            CellRange,
+            NumLightBinningMethods
+        };
+
+        /// Name used for the method in the JSON report
+        const char *getName( LightBinningMethod method );
+    }  // namespace LightBinningMethod
+
+    struct LightBinningBenchmarkParams
+    {
+        /// Point & spot lights in front of the camera
+        Ogre::uint32 numLights;
+        /// SceneManager worker threads, which bin the slices
+        Ogre::uint32 numThreads;
+        /// Times each method is measured
+        Ogre::uint32 numIterations;
+
+        LightBinningBenchmarkParams();
+    };
+
+    /** Measures ForwardClustered::collectLights with and without light cell range binning,
+        on the same lights, camera and grid settings as the scene variants, without Items.
+    @remarks
+        The camera turns slightly every iteration so that the grid isn't cached, like in a
+        game. Both methods build the grid in a CPU buffer (see ForwardPlusBase::setCompactGrid)
+        so that it can be compared. Throws if the methods don't produce the same grid.
+    @param root
+        Initialised Root, with a window already created
+    @param outSamples
+        CPU time in microseconds of each iteration, per method
+    */
+    void runLightBinningBenchmark(
+        Ogre::Root *root, const LightBinningBenchmarkParams &params,
+        Ogre::vector<Ogre::uint64>::type outSamples[LightBinningMethod::NumLightBinningMethods] );
+}  // namespace Benchmark
+
+#endif
@@ -0,0 +1,88 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _BenchmarkRenderQueueSort_H_
+#define _BenchmarkRenderQueueSort_H_
+
+#include "OgrePrerequisites.h"
+
+#include "ogrestd/vector.h"
+
+namespace Benchmark
+{
+    namespace RqSortMethod
+    {
+        enum RqSortMethod
+        {
+            /// RenderQueue::NormalSort: concatenates the per-thread arrays, then std::sort
+            NormalSort,
+            /// RenderQueue::StableSort: concatenates the per-thread arrays, then std::stable_sort
+            StableSort,
+            /// RenderQueue::ParallelRadixSort: radix sorts each per-thread array on the
+            /// worker threads, then k-way merges them
+            ParallelRadixSort,
+            /// RenderQueue::setSortTemporalCoherence when the contents didn't change:
+            /// fingerprint, exact comparison against last frame's input and copy of last
+            /// frame's results
+            TemporalCoherenceHit,
+            NumRqSortMethods
+        };
+
+        /// Name used for the method in the JSON report
+        const char *getName( RqSortMethod method );
+    }  // namespace RqSortMethod
+
+    struct RqSortBenchmarkParams
+    {
+        /// Renderables in the RQ, split evenly across the threads
+        Ogre::uint32 numRenderables;
+        /// Threads that add Renderables to the RQ and radix sort them
+        Ogre::uint32 numThreads;
+        /// Times each method is measured
+        Ogre::uint32 numIterations;
+
+        RqSortBenchmarkParams();
+    };
+
+    /** Measures the sort modes of RenderQueue on the same made up QueuedRenderables,
+        without a scene. Complements the scene variants, where sorting is only a part of
+        RenderQueue::render.
+    @remarks
+        RenderQueue keeps its sorting machinery private, so this mirrors what
+        RenderQueue::sortRenderQueues does for each mode using the same building blocks
+        (RadixSort, QueuedRenderableFingerprint and QueuedRenderableSet).
+        Throws if the methods don't produce the same order.
+    @param outSamples
+        CPU time in microseconds of each iteration, per method
+    */
+    void runRenderQueueSortBenchmark(
+        const RqSortBenchmarkParams &params,
+        Ogre::vector<Ogre::uint64>::type outSamples[RqSortMethod::NumRqSortMethods] );
+}  // namespace Benchmark
+
+#endif
@@ -0,0 +1,101 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _BenchmarkScene_H_
+#define _BenchmarkScene_H_
+
+#include "OgrePrerequisites.h"
+
+#include "OgreFastArray.h"
+
+namespace Ogre
+{
+    class SkeletonAnimation;
+}
+
+namespace Benchmark
+{
+    /// Size of the procedurally built scene
+    struct BenchmarkSceneParams
+    {
+        /// Dynamic Items. Each one has its own SceneNode
+        Ogre::uint32 numItems;
+        /// The SceneNodes of the dynamic Items are chained this deep (each node is the parent
+        /// of the next one). 1 means all of them are children of the root node
+        Ogre::uint32 hierarchyDepth;
+        /// Items in SCENE_STATIC nodes
+        Ogre::uint32 numStaticItems;
+        /// Forward+ point lights
+        Ogre::uint32 numLights;
+        /// Items with a skeleton playing an animation
+        Ogre::uint32 numSkeletalItems;
+
+        BenchmarkSceneParams();
+    };
+
+    /** Builds a scene procedurally and animates it every frame.
+    @remarks
+        The scene is laid out on a grid around the camera, which looks towards -Z,
+        so that roughly half of it is outside the frustum.
+        The dynamic node chains are rotated every frame, thus every dynamic node
+        needs its transform updated; while static nodes never change.
+        All Items share the same datablock.
+    */
+    class BenchmarkScene
+    {
+        Ogre::SceneManager *mSceneManager;
+        Ogre::Camera       *mCamera;
+
+        Ogre::FastArray<Ogre::SceneNode *>         mChainRoots;
+        Ogre::FastArray<Ogre::SkeletonAnimation *> mAnimations;
+
+        void createDynamicItems( const BenchmarkSceneParams &params, Ogre::HlmsDatablock *datablock );
+        void createStaticItems( const BenchmarkSceneParams &params, Ogre::HlmsDatablock *datablock );
+        void createSkeletalItems( const BenchmarkSceneParams &params,
+                                  Ogre::HlmsDatablock        *datablock );
+        void createLights( const BenchmarkSceneParams &params );
+
+    public:
+        /// Mesh used by the dynamic & static Items
+        static const char *ItemMeshName;
+        /// Mesh used by the skeletal Items. It is imported from v1. @see importMeshes
+        static const char *SkeletalMeshName;
+
+        BenchmarkScene( Ogre::SceneManager *sceneManager, const BenchmarkSceneParams &params,
+                        Ogre::HlmsDatablock *datablock );
+
+        /// Imports the v1 meshes the scene needs. Must be called once before creating any scene.
+        static void importMeshes();
+
+        Ogre::Camera *getCamera() const { return mCamera; }
+
+        void update( float timeSinceLast );
+    };
+}  // namespace Benchmark
+
+#endif
@@ -0,0 +1,146 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _BenchmarkSceneManager_H_
+#define _BenchmarkSceneManager_H_
+
+#include "OgreProfiler.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneManagerEnumerator.h"
+#include "OgreTimer.h"
+
+namespace Benchmark
+{
+    namespace BenchmarkStage
+    {
+        enum BenchmarkStage
+        {
+            /// SceneManager::updateAllAnimations and updateAllTagPoints
+            UpdateAllAnimations,
+            UpdateAllTransforms,
+            UpdateAllBounds,
+            BuildLightList,
+            /// SceneManager::_cullPhase01 of every pass: Forward+ light collection,
+            /// RenderQueue::renderPassPrepare and cullFrustum
+            CullFrustum,
+            /// SceneManager::_renderPhase02 of every pass: RenderQueue::render,
+            /// which includes sorting and the Hlms fill paths
+            Render,
+            NumBenchmarkStages
+        };
+
+        /// Name used for the stage in the JSON report
+        const char *getName( BenchmarkStage stage );
+
+        /// Returns false for the stages that can't be measured with the current build settings
+        bool isStageMeasured( BenchmarkStage stage );
+    }  // namespace BenchmarkStage
+
+    class BenchmarkSceneManager;
+
+#if OGRE_PROFILING == OGRE_PROFILING_INTERNAL
+    /** Collects the time spent in the profiler scopes of the updateSceneGraph stages
+        (e.g. OgreProfile( "updateAllTransforms" )) once the frame has ended.
+    */
+    class BenchmarkProfileListener final : public Ogre::ProfileSessionListener
+    {
+        BenchmarkSceneManager *mSceneManager;
+
+        void collectStageTimes( const Ogre::ProfileInstance &instance, Ogre::ulong frameNumber );
+
+    public:
+        BenchmarkProfileListener( BenchmarkSceneManager *sceneManager );
+
+        void initializeSession() override {}
+        void finializeSession() override {}
+
+        void displayResults( const Ogre::ProfileInstance &instance,
+                             Ogre::uint64                maxTotalFrameTime ) override;
+    };
+#endif
+
+    /** SceneManager that measures the CPU time each stage of a frame takes.
+    @remarks
+        _cullPhase01 and _renderPhase02 are timed by overriding them. The updateSceneGraph
+        stages are read from the profiler, thus they're only measured when Ogre is built
+        with OGRE_PROFILING_PROVIDER=internal and the Profiler is enabled with an update
+        frequency of 1 (see BenchmarkStage::isStageMeasured).
+        Frames run through Root::renderOneFrame as usual.
+        Timings accumulate until resetStageTimes is called.
+    */
+    class BenchmarkSceneManager final : public Ogre::SceneManager
+    {
+        Ogre::Timer  mTimer;
+        Ogre::uint64 mStageTimes[BenchmarkStage::NumBenchmarkStages];
+#if OGRE_PROFILING == OGRE_PROFILING_INTERNAL
+        BenchmarkProfileListener mProfileListener;
+#endif
+
+    public:
+        BenchmarkSceneManager( const Ogre::String &name, size_t numWorkerThreads );
+        ~BenchmarkSceneManager() override;
+
+        const Ogre::String &getTypeName() const override;
+
+        void _cullPhase01( Ogre::Camera *cullCamera, Ogre::Camera *renderCamera,
+                           const Ogre::Camera *lodCamera, Ogre::uint8 firstRq, Ogre::uint8 lastRq,
+                           bool reuseCullData ) override;
+
+        void _renderPhase02( Ogre::Camera *camera, const Ogre::Camera *lodCamera, Ogre::uint8 firstRq,
+                             Ogre::uint8 lastRq, bool includeOverlays ) override;
+
+        void resetStageTimes();
+
+        void _addStageTime( BenchmarkStage::BenchmarkStage stage, Ogre::uint64 microseconds )
+        {
+            mStageTimes[stage] += microseconds;
+        }
+
+        /// Returns the accumulated time of the stage, in microseconds
+        Ogre::uint64 getStageTime( BenchmarkStage::BenchmarkStage stage ) const
+        {
+            return mStageTimes[stage];
+        }
+    };
+
+    class BenchmarkSceneManagerFactory final : public Ogre::SceneManagerFactory
+    {
+    protected:
+        void initMetaData() const override;
+
+    public:
+        /// Factory type name
+        static const Ogre::String FACTORY_TYPE_NAME;
+
+        Ogre::SceneManager *createInstance( const Ogre::String &instanceName,
+                                            size_t              numWorkerThreads ) override;
+        void destroyInstance( Ogre::SceneManager *instance ) override;
+    };
+}  // namespace Benchmark
+
+#endif
@@ -0,0 +1,192 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "BenchmarkLightBinning.h"
+
+#include "OgreCamera.h"
+#include "OgreException.h"
+#include "OgreForwardClustered.h"
+#include "OgreLight.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreTimer.h"
+#include "OgreViewport.h"
+
+using namespace Ogre;
+
+namespace Benchmark
+{
+    /// Same grid settings as the scene variants
+    static const uint32 c_lightsPerCell = 96u;
+
+    /// Exposes the grid built on the CPU
+    class BenchmarkForwardClustered final : public ForwardClustered
+    {
+    public:
+        BenchmarkForwardClustered( SceneManager *sceneManager, bool lightCellRangeBinning ) :
+            ForwardClustered( 16u, 8u, 24u, c_lightsPerCell, 0u, 0u, 2.0f, 50.0f, sceneManager )
+        {
+            setCompactGrid( true );
+            setLightCellRangeBinning( lightCellRangeBinning );
+        }
+
+        const FastArray<uint16> &getFixedLayoutGrid() const { return mUncompactedGrid; }
+    };
+    //-----------------------------------------------------------------------------------
+    /// Spreads point & spot lights of varying sizes over the area in front of the camera
+    static void createLights( SceneManager *sceneManager, uint32 numLights )
+    {
+        SceneNode *rootNode = sceneManager->getRootSceneNode();
+
+        uint64 seed = 0x9E3779B97F4A7C15ULL;
+        for( uint32 i = 0u; i < numLights; ++i )
+        {
+            Real randomValues[4];
+            for( size_t j = 0u; j < 4u; ++j )
+            {
+                // xorshift64
+                seed ^= seed << 13u;
+                seed ^= seed >> 7u;
+                seed ^= seed << 17u;
+                randomValues[j] = Real( seed & 0xFFFFu ) / Real( 0xFFFFu );
+            }
+
+            Light *light = sceneManager->createLight();
+            SceneNode *lightNode = rootNode->createChildSceneNode( SCENE_DYNAMIC );
+            lightNode->attachObject( light );
+            lightNode->setPosition( ( randomValues[0] - 0.5f ) * 200.0f, 1.0f + randomValues[1] * 4.0f,
+                                    -randomValues[2] * 200.0f );
+
+            light->setAttenuationBasedOnRadius( 2.0f + randomValues[3] * 8.0f, 0.00192f );
+            if( i % 4u == 0u )
+            {
+                light->setType( Light::LT_SPOTLIGHT );
+                light->setDirection( Vector3( randomValues[0] - 0.5f, -1.0f, randomValues[2] - 0.5f ) );
+                light->setSpotlightRange( Degree( 30.0f ), Degree( 60.0f ) );
+            }
+            else
+            {
+                light->setType( Light::LT_POINT );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    LightBinningBenchmarkParams::LightBinningBenchmarkParams() :
+        numLights( 1024u ),
+        numThreads( 1u ),
+        numIterations( 100u )
+    {
+    }
+    //-----------------------------------------------------------------------------------
+    const char *LightBinningMethod::getName( LightBinningMethod method )
+    {
+        switch( method )
+        {
+        case BruteForce:
+            return "brute_force";
+        case CellRange:
+            return "cell_range";
+        case NumLightBinningMethods:
+            break;
+        }
+        return "unknown";
+    }
+    //-----------------------------------------------------------------------------------
+    void runLightBinningBenchmark(
+        Root *root, const LightBinningBenchmarkParams &params,
+        vector<uint64>::type outSamples[LightBinningMethod::NumLightBinningMethods] )
+    {
+        SceneManager *sceneManager = root->createSceneManager(
+            ST_GENERIC, std::max( params.numThreads, 1u ), "BenchmarkLightBinning" );
+
+        createLights( sceneManager, params.numLights );
+
+        // Same as BenchmarkScene
+        Camera *camera = sceneManager->createCamera( "BenchmarkCamera" );
+        camera->setPosition( 0.0f, 15.0f, 0.0f );
+        camera->lookAt( 0.0f, 0.0f, -50.0f );
+        camera->setNearClipDistance( 0.2f );
+        camera->setFarClipDistance( 1000.0f );
+        camera->setAspectRatio( 16.0f / 9.0f );
+
+        // The Viewport constructor leaves the light visibility mask uninitialized
+        Viewport viewport;
+        viewport._setVisibilityMask( 0xFFFFFFFF, 0xFFFFFFFF );
+        camera->_notifyViewport( &viewport );
+
+        RenderSystem *renderSystem = root->getRenderSystem();
+        BenchmarkForwardClustered *forwardClustered[LightBinningMethod::NumLightBinningMethods];
+        for( size_t i = 0u; i < LightBinningMethod::NumLightBinningMethods; ++i )
+        {
+            forwardClustered[i] =
+                OGRE_NEW BenchmarkForwardClustered( sceneManager, i == LightBinningMethod::CellRange );
+            forwardClustered[i]->_changeRenderSystem( renderSystem );
+            outSamples[i].reserve( params.numIterations );
+        }
+
+        Timer timer;
+
+        bool sameGrid = true;
+        for( uint32 iteration = 0u; iteration < params.numIterations && sameGrid; ++iteration )
+        {
+            // Turn the camera a bit so that the grid can't be reused. Not measured
+            camera->yaw( Degree( ( iteration & 0x01u ) ? -0.1f : 0.1f ) );
+            sceneManager->updateSceneGraph();
+
+            for( size_t method = 0u; method < LightBinningMethod::NumLightBinningMethods; ++method )
+            {
+                const uint64 startTime = timer.getMicroseconds();
+                forwardClustered[method]->collectLights( camera );
+                outSamples[method].push_back( timer.getMicroseconds() - startTime );
+            }
+
+            // The counts & lights of each cell must match. Unused slots are left as they were
+            const FastArray<uint16> &expected =
+                forwardClustered[LightBinningMethod::BruteForce]->getFixedLayoutGrid();
+            const FastArray<uint16> &actual =
+                forwardClustered[LightBinningMethod::CellRange]->getFixedLayoutGrid();
+            const size_t objsPerCell = 3u + c_lightsPerCell;
+            for( size_t i = 0u; i < expected.size() && sameGrid; i += objsPerCell )
+            {
+                const size_t numSlots = 3u + expected[i + 2u];
+                sameGrid = memcmp( &expected[i], &actual[i], numSlots * sizeof( uint16 ) ) == 0;
+            }
+        }
+
+        for( size_t i = 0u; i < LightBinningMethod::NumLightBinningMethods; ++i )
+            OGRE_DELETE forwardClustered[i];
+        root->destroySceneManager( sceneManager );
+
+        if( !sameGrid )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALID_STATE,
+                         "Light cell range binning produced a different grid than testing every cell",
+                         "runLightBinningBenchmark" );
+        }
+    }
+}  // namespace Benchmark
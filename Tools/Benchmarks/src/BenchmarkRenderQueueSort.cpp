@@ -0,0 +1,282 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "BenchmarkRenderQueueSort.h"
+
+#include "OgreException.h"
+#include "OgreRadixSort.h"
+#include "OgreRenderQueue.h"
+#include "OgreTimer.h"
+#include "Threading/OgreTaskScheduler.h"
+
+#include <algorithm>
+
+using namespace Ogre;
+
+namespace Benchmark
+{
+    typedef FastArray<QueuedRenderable> QueuedRenderableArray;
+    typedef RadixSort<QueuedRenderableArray, QueuedRenderable, uint64> QueuedRenderableRadixSort;
+
+    struct QueuedRenderableHash
+    {
+        uint64 operator()( const QueuedRenderable &qr ) const { return qr.hash; }
+    };
+
+    /// Same as RenderQueueRadixSortTask: one per-thread array per item
+    class RqRadixSortTask final : public RangeTask
+    {
+        QueuedRenderableArray     *mPerThread;
+        QueuedRenderableRadixSort *mRadixSorters;
+
+    public:
+        RqRadixSortTask( QueuedRenderableArray *perThread, QueuedRenderableRadixSort *radixSorters ) :
+            mPerThread( perThread ),
+            mRadixSorters( radixSorters )
+        {
+        }
+
+        void execute( size_t begin, size_t end, size_t threadIdx ) override
+        {
+            for( size_t i = begin; i < end; ++i )
+                mRadixSorters[threadIdx].sort( mPerThread[i], QueuedRenderableHash() );
+        }
+    };
+
+    /// Same as RenderQueue::mergeSortedPerThread
+    static void mergeSortedPerThread( const QueuedRenderableArray *perThread, size_t numThreads,
+                                      QueuedRenderableArray &outMerged )
+    {
+        FastArray<const QueuedRenderable *> cursors;
+        FastArray<const QueuedRenderable *> cursorsEnd;
+        cursors.reserve( numThreads );
+        cursorsEnd.reserve( numThreads );
+
+        for( size_t i = 0u; i < numThreads; ++i )
+        {
+            if( !perThread[i].empty() )
+            {
+                cursors.push_back( perThread[i].begin() );
+                cursorsEnd.push_back( perThread[i].end() );
+            }
+        }
+
+        while( cursors.size() > 1u )
+        {
+            size_t smallest = 0;
+            for( size_t i = 1u; i < cursors.size(); ++i )
+            {
+                if( cursors[i]->hash < cursors[smallest]->hash )
+                    smallest = i;
+            }
+
+            outMerged.push_back( *cursors[smallest]++ );
+
+            if( cursors[smallest] == cursorsEnd[smallest] )
+            {
+                cursors.erase( cursors.begin() + smallest );
+                cursorsEnd.erase( cursorsEnd.begin() + smallest );
+            }
+        }
+
+        if( !cursors.empty() )
+            outMerged.appendPOD( cursors[0], cursorsEnd[0] );
+    }
+    //-----------------------------------------------------------------------------------
+    /// Fills the per-thread arrays the way culling would: hashes group by shader & material
+    /// in the high bits, with the depth in the low bits.
+    static void createQueuedRenderables( const RqSortBenchmarkParams &params,
+                                         QueuedRenderableArray *outPerThread )
+    {
+        uint64 seed = 0x2545F4914F6CDD1DULL;
+        for( uint32 i = 0u; i < params.numRenderables; ++i )
+        {
+            // xorshift64
+            seed ^= seed << 13u;
+            seed ^= seed >> 7u;
+            seed ^= seed << 17u;
+
+            const uint64 materialBits = ( seed >> 32u ) % 64u;
+            const uint64 depthBits = seed & 0xFFFFu;
+            const uint64 hash = ( materialBits << 48u ) | depthBits;
+
+            Renderable *renderable = reinterpret_cast<Renderable *>( 0x1000u + i * 64u );
+            const MovableObject *movableObject =
+                reinterpret_cast<const MovableObject *>( 0x100000u + i * 64u );
+
+            outPerThread[i % params.numThreads].push_back(
+                QueuedRenderable( hash, renderable, movableObject ) );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    static bool haveSameOrder( const QueuedRenderableArray &a, const QueuedRenderableArray &b )
+    {
+        if( a.size() != b.size() )
+            return false;
+
+        for( size_t i = 0u; i < a.size(); ++i )
+        {
+            if( a[i].hash != b[i].hash || a[i].renderable != b[i].renderable ||
+                a[i].movableObject != b[i].movableObject )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    RqSortBenchmarkParams::RqSortBenchmarkParams() :
+        numRenderables( 100000u ),
+        numThreads( 4u ),
+        numIterations( 100u )
+    {
+    }
+    //-----------------------------------------------------------------------------------
+    const char *RqSortMethod::getName( RqSortMethod method )
+    {
+        switch( method )
+        {
+        case NormalSort:
+            return "normal_sort";
+        case StableSort:
+            return "stable_sort";
+        case ParallelRadixSort:
+            return "parallel_radix_sort";
+        case TemporalCoherenceHit:
+            return "temporal_coherence_hit";
+        case NumRqSortMethods:
+            break;
+        }
+        return "unknown";
+    }
+    //-----------------------------------------------------------------------------------
+    void runRenderQueueSortBenchmark(
+        const RqSortBenchmarkParams &params,
+        vector<uint64>::type outSamples[RqSortMethod::NumRqSortMethods] )
+    {
+        const size_t numThreads = std::max( params.numThreads, 1u );
+
+        vector<QueuedRenderableArray>::type input( numThreads );
+        vector<QueuedRenderableArray>::type perThread( numThreads );
+        vector<QueuedRenderableRadixSort>::type radixSorters( numThreads );
+        createQueuedRenderables( params, &input[0] );
+
+        QueuedRenderableArray merged;
+        merged.reserve( params.numRenderables );
+
+        // Last frame's input & results, as RenderQueue::SortCache keeps them
+        QueuedRenderableFingerprint lastInput;
+        QueuedRenderableSet lastInputSet;
+        lastInputSet.reset( params.numRenderables );
+        for( size_t i = 0u; i < numThreads; ++i )
+        {
+            lastInput.add( input[i].begin(), input[i].end() );
+            lastInputSet.add( input[i].begin(), input[i].end() );
+        }
+
+        QueuedRenderableArray reference;
+        for( size_t i = 0u; i < numThreads; ++i )
+            reference.appendPOD( input[i].begin(), input[i].end() );
+        std::stable_sort( reference.begin(), reference.end() );
+
+        TaskScheduler taskScheduler( numThreads );
+        RqRadixSortTask radixSortTask( &perThread[0], &radixSorters[0] );
+
+        for( size_t i = 0u; i < RqSortMethod::NumRqSortMethods; ++i )
+            outSamples[i].reserve( params.numIterations );
+
+        Timer timer;
+
+        for( uint32 iteration = 0u; iteration < params.numIterations; ++iteration )
+        {
+            for( size_t method = 0u; method < RqSortMethod::NumRqSortMethods; ++method )
+            {
+                // Every method starts from the unsorted per-thread arrays. Not measured
+                perThread = input;
+                merged.clear();
+
+                const uint64 startTime = timer.getMicroseconds();
+
+                switch( method )
+                {
+                case RqSortMethod::NormalSort:
+                case RqSortMethod::StableSort:
+                    for( size_t i = 0u; i < numThreads; ++i )
+                        merged.appendPOD( perThread[i].begin(), perThread[i].end() );
+                    if( method == RqSortMethod::NormalSort )
+                        std::sort( merged.begin(), merged.end() );
+                    else
+                        std::stable_sort( merged.begin(), merged.end() );
+                    break;
+                case RqSortMethod::ParallelRadixSort:
+                {
+                    const TaskScheduler::TaskId taskId =
+                        taskScheduler.addTask( &radixSortTask, numThreads, 1u );
+                    taskScheduler.waitFor( taskId );
+                    mergeSortedPerThread( &perThread[0], numThreads, merged );
+                    break;
+                }
+                case RqSortMethod::TemporalCoherenceHit:
+                {
+                    QueuedRenderableFingerprint fingerprint;
+                    for( size_t i = 0u; i < numThreads; ++i )
+                        fingerprint.add( perThread[i].begin(), perThread[i].end() );
+
+                    bool hit = fingerprint == lastInput;
+                    lastInputSet.resetMatches();
+                    for( size_t i = 0u; i < numThreads && hit; ++i )
+                        hit = lastInputSet.match( perThread[i].begin(), perThread[i].end() );
+                    hit = hit && lastInputSet.allMatched();
+
+                    if( !hit )
+                    {
+                        OGRE_EXCEPT( Exception::ERR_INVALID_STATE,
+                                     "Temporal coherence missed with the same contents",
+                                     "runRenderQueueSortBenchmark" );
+                    }
+                    merged.appendPOD( reference.begin(), reference.end() );
+                    break;
+                }
+                }
+
+                outSamples[method].push_back( timer.getMicroseconds() - startTime );
+
+                // std::sort isn't stable, thus it may order equal hashes differently
+                if( iteration == 0u && method != RqSortMethod::NormalSort &&
+                    !haveSameOrder( merged, reference ) )
+                {
+                    OGRE_EXCEPT( Exception::ERR_INVALID_STATE,
+                                 String( RqSortMethod::getName(
+                                     static_cast<RqSortMethod::RqSortMethod>( method ) ) ) +
+                                     " sorted differently than std::stable_sort",
+                                 "runRenderQueueSortBenchmark" );
+                }
+            }
+        }
+    }
+}  // namespace Benchmark
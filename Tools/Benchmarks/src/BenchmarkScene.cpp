@@ -0,0 +1,250 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "BenchmarkScene.h"
+
+#include "Animation/OgreSkeletonInstance.h"
+#include "OgreCamera.h"
+#include "OgreItem.h"
+#include "OgreMesh.h"
+#include "OgreMesh2.h"
+#include "OgreMeshManager.h"
+#include "OgreMeshManager2.h"
+#include "OgreSceneManager.h"
+
+using namespace Ogre;
+
+namespace Benchmark
+{
+    static const float c_gridSpacing = 4.0f;
+
+    /// Returns the position of the idx-th cell of a gridSize x gridSize grid centered at the origin
+    static Vector3 getGridPosition( uint32 idx, uint32 gridSize, float spacing, float height )
+    {
+        const float halfSize = static_cast<float>( gridSize ) * 0.5f;
+        return Vector3( ( static_cast<float>( idx % gridSize ) - halfSize ) * spacing, height,
+                        ( static_cast<float>( idx / gridSize ) - halfSize ) * spacing );
+    }
+    //-----------------------------------------------------------------------------------
+    static uint32 getGridSize( uint32 numCells )
+    {
+        return std::max( static_cast<uint32>( ceilf( sqrtf( static_cast<float>( numCells ) ) ) ), 1u );
+    }
+    //-----------------------------------------------------------------------------------
+    BenchmarkSceneParams::BenchmarkSceneParams() :
+        numItems( 10000u ),
+        hierarchyDepth( 8u ),
+        numStaticItems( 10000u ),
+        numLights( 256u ),
+        numSkeletalItems( 100u )
+    {
+    }
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    const char *BenchmarkScene::ItemMeshName = "Cube_d.mesh";
+    const char *BenchmarkScene::SkeletalMeshName = "Stickman.mesh";
+    //-----------------------------------------------------------------------------------
+    BenchmarkScene::BenchmarkScene( SceneManager *sceneManager, const BenchmarkSceneParams &params,
+                                    HlmsDatablock *datablock ) :
+        mSceneManager( sceneManager ),
+        mCamera( 0 )
+    {
+        createDynamicItems( params, datablock );
+        createStaticItems( params, datablock );
+        createSkeletalItems( params, datablock );
+        createLights( params );
+
+        mCamera = mSceneManager->createCamera( "BenchmarkCamera" );
+        mCamera->setPosition( 0.0f, 15.0f, 0.0f );
+        mCamera->lookAt( 0.0f, 0.0f, -50.0f );
+        mCamera->setNearClipDistance( 0.2f );
+        mCamera->setFarClipDistance( 1000.0f );
+        mCamera->setAutoAspectRatio( true );
+    }
+    //-----------------------------------------------------------------------------------
+    void BenchmarkScene::createDynamicItems( const BenchmarkSceneParams &params,
+                                             HlmsDatablock              *datablock )
+    {
+        const uint32 depth = std::max( params.hierarchyDepth, 1u );
+        const uint32 numChains = ( params.numItems + depth - 1u ) / depth;
+        const uint32 gridSize = getGridSize( numChains );
+
+        // Each link of a chain is offset & rotated from its parent, forming a spiral
+        const Quaternion linkOrientation( Degree( 20.0f ), Vector3::UNIT_Y );
+
+        SceneNode *rootNode = mSceneManager->getRootSceneNode( SCENE_DYNAMIC );
+
+        uint32 itemsLeft = params.numItems;
+
+        for( uint32 i = 0u; i < numChains; ++i )
+        {
+            SceneNode *parentNode = rootNode;
+            const uint32 chainLength = std::min( depth, itemsLeft );
+
+            for( uint32 j = 0u; j < chainLength; ++j )
+            {
+                SceneNode *sceneNode = parentNode->createChildSceneNode( SCENE_DYNAMIC );
+                if( j == 0u )
+                {
+                    sceneNode->setPosition( getGridPosition( i, gridSize, c_gridSpacing, 0.0f ) );
+                    mChainRoots.push_back( sceneNode );
+                }
+                else
+                {
+                    sceneNode->setPosition( 0.6f, 0.25f, 0.0f );
+                    sceneNode->setOrientation( linkOrientation );
+                }
+
+                Item *item = mSceneManager->createItem(
+                    ItemMeshName, ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME, SCENE_DYNAMIC,
+                    false );
+                item->setDatablock( datablock );
+                sceneNode->attachObject( item );
+
+                parentNode = sceneNode;
+            }
+
+            itemsLeft -= chainLength;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void BenchmarkScene::createStaticItems( const BenchmarkSceneParams &params,
+                                            HlmsDatablock              *datablock )
+    {
+        const uint32 gridSize = getGridSize( params.numStaticItems );
+
+        SceneNode *rootNode = mSceneManager->getRootSceneNode( SCENE_STATIC );
+
+        for( uint32 i = 0u; i < params.numStaticItems; ++i )
+        {
+            SceneNode *sceneNode = rootNode->createChildSceneNode( SCENE_STATIC );
+            sceneNode->setPosition( getGridPosition( i, gridSize, c_gridSpacing * 0.5f, -1.5f ) );
+            sceneNode->setScale( 0.5f, 0.5f, 0.5f );
+
+            Item *item = mSceneManager->createItem(
+                ItemMeshName, ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME, SCENE_STATIC,
+                false );
+            item->setDatablock( datablock );
+            sceneNode->attachObject( item );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void BenchmarkScene::createSkeletalItems( const BenchmarkSceneParams &params,
+                                              HlmsDatablock              *datablock )
+    {
+        const uint32 gridSize = getGridSize( params.numSkeletalItems );
+
+        SceneNode *rootNode = mSceneManager->getRootSceneNode( SCENE_DYNAMIC );
+
+        for( uint32 i = 0u; i < params.numSkeletalItems; ++i )
+        {
+            SceneNode *sceneNode = rootNode->createChildSceneNode( SCENE_DYNAMIC );
+            sceneNode->setPosition( getGridPosition( i, gridSize, c_gridSpacing * 2.0f, 0.0f ) +
+                                    Vector3( c_gridSpacing * 0.5f, 0.0f, c_gridSpacing * 0.5f ) );
+
+            Item *item = mSceneManager->createItem(
+                SkeletalMeshName, ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME, SCENE_DYNAMIC,
+                false );
+            item->setDatablock( datablock );
+            sceneNode->attachObject( item );
+
+            SkeletonInstance *skeletonInstance = item->getSkeletonInstance();
+            if( skeletonInstance && !skeletonInstance->getAnimations().empty() )
+            {
+                SkeletonAnimation *animation = &skeletonInstance->getAnimationsNonConst().front();
+                animation->setEnabled( true );
+                animation->setLoop( true );
+                // Desynchronize the instances
+                animation->setTime( static_cast<float>( i ) * 0.1f );
+                mAnimations.push_back( animation );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void BenchmarkScene::createLights( const BenchmarkSceneParams &params )
+    {
+        // Spread the lights over the area covered by the dynamic Items
+        const uint32 depth = std::max( params.hierarchyDepth, 1u );
+        const float sceneSize =
+            static_cast<float>( getGridSize( ( params.numItems + depth - 1u ) / depth ) ) *
+            c_gridSpacing;
+
+        const uint32 gridSize = getGridSize( params.numLights );
+        const float lightSpacing = sceneSize / static_cast<float>( gridSize );
+
+        SceneNode *rootNode = mSceneManager->getRootSceneNode( SCENE_DYNAMIC );
+
+        for( uint32 i = 0u; i < params.numLights; ++i )
+        {
+            Light *light = mSceneManager->createLight();
+            SceneNode *lightNode = rootNode->createChildSceneNode( SCENE_DYNAMIC );
+            lightNode->attachObject( light );
+            lightNode->setPosition( getGridPosition( i, gridSize, lightSpacing, 2.0f ) );
+
+            light->setType( Light::LT_POINT );
+            light->setDiffuseColour( 0.8f, 0.4f, 0.2f );
+            light->setSpecularColour( 0.8f, 0.4f, 0.2f );
+            light->setAttenuationBasedOnRadius( lightSpacing * 1.5f, 0.00192f );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void BenchmarkScene::importMeshes()
+    {
+        v1::MeshPtr v1Mesh = v1::MeshManager::getSingleton().load(
+            SkeletalMeshName, ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME,
+            v1::HardwareBuffer::HBU_STATIC, v1::HardwareBuffer::HBU_STATIC );
+
+        MeshManager::getSingleton().createByImportingV1(
+            SkeletalMeshName, ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, v1Mesh.get(), true,
+            true, false );
+        v1Mesh->unload();
+    }
+    //-----------------------------------------------------------------------------------
+    void BenchmarkScene::update( float timeSinceLast )
+    {
+        const Radian rotation( timeSinceLast * 0.5f );
+
+        FastArray<SceneNode *>::const_iterator itor = mChainRoots.begin();
+        FastArray<SceneNode *>::const_iterator endt = mChainRoots.end();
+
+        while( itor != endt )
+        {
+            ( *itor )->yaw( rotation );
+            ++itor;
+        }
+
+        FastArray<SkeletonAnimation *>::const_iterator itAnim = mAnimations.begin();
+        FastArray<SkeletonAnimation *>::const_iterator enAnim = mAnimations.end();
+
+        while( itAnim != enAnim )
+        {
+            ( *itAnim )->addTime( timeSinceLast );
+            ++itAnim;
+        }
+    }
+}  // namespace Benchmark
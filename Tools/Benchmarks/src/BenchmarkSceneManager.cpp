@@ -0,0 +1,210 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "BenchmarkSceneManager.h"
+
+#include <algorithm>
+
+using namespace Ogre;
+
+namespace Benchmark
+{
+    const char *BenchmarkStage::getName( BenchmarkStage stage )
+    {
+        switch( stage )
+        {
+        case UpdateAllAnimations:
+            return "updateAllAnimations";
+        case UpdateAllTransforms:
+            return "updateAllTransforms";
+        case UpdateAllBounds:
+            return "updateAllBounds";
+        case BuildLightList:
+            return "buildLightList";
+        case CullFrustum:
+            return "cullFrustum";
+        case Render:
+            return "render";
+        case NumBenchmarkStages:
+            break;
+        }
+
+        return "unknown";
+    }
+    //-----------------------------------------------------------------------------------
+    bool BenchmarkStage::isStageMeasured( BenchmarkStage stage )
+    {
+#if OGRE_PROFILING == OGRE_PROFILING_INTERNAL
+        return stage < NumBenchmarkStages;
+#else
+        // The updateSceneGraph stages come from the profiler
+        return stage == CullFrustum || stage == Render;
+#endif
+    }
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+#if OGRE_PROFILING == OGRE_PROFILING_INTERNAL
+    BenchmarkProfileListener::BenchmarkProfileListener( BenchmarkSceneManager *sceneManager ) :
+        mSceneManager( sceneManager )
+    {
+    }
+    //-----------------------------------------------------------------------------------
+    void BenchmarkProfileListener::collectStageTimes( const ProfileInstance &instance,
+                                                      ulong                  frameNumber )
+    {
+        // Must match the OgreProfile scopes in SceneManager
+        struct StageScope
+        {
+            const char                    *name;
+            BenchmarkStage::BenchmarkStage stage;
+        };
+        static const StageScope c_stageScopes[] = {
+            { "updateAllAnimations", BenchmarkStage::UpdateAllAnimations },
+            { "updateAllTagPoints", BenchmarkStage::UpdateAllAnimations },
+            { "updateAllTransforms", BenchmarkStage::UpdateAllTransforms },
+            { "updateAllBounds", BenchmarkStage::UpdateAllBounds },
+            { "buildLightList", BenchmarkStage::BuildLightList },
+        };
+
+        ProfileInstance::ProfileChildrenVec::const_iterator itor = instance.children.begin();
+        ProfileInstance::ProfileChildrenVec::const_iterator endt = instance.children.end();
+
+        while( itor != endt )
+        {
+            const ProfileInstance *child = *itor;
+
+            // Profiles that weren't called this frame keep the data of the last frame they were
+            if( child->frameNumber == frameNumber )
+            {
+                bool isStage = false;
+                for( size_t i = 0u; i < sizeof( c_stageScopes ) / sizeof( c_stageScopes[0] ); ++i )
+                {
+                    if( child->name == c_stageScopes[i].name )
+                    {
+                        // frameTime includes the children, and the calls made this frame
+                        mSceneManager->_addStageTime( c_stageScopes[i].stage, child->frame.frameTime );
+                        isStage = true;
+                    }
+                }
+
+                if( !isStage )
+                    collectStageTimes( *child, frameNumber );
+            }
+
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void BenchmarkProfileListener::displayResults( const ProfileInstance &instance, uint64 )
+    {
+        // The most recent frame is the one that just ended
+        ulong frameNumber = 0u;
+        ProfileInstance::ProfileChildrenVec::const_iterator itor = instance.children.begin();
+        ProfileInstance::ProfileChildrenVec::const_iterator endt = instance.children.end();
+        while( itor != endt )
+        {
+            frameNumber = std::max( frameNumber, ( *itor )->frameNumber );
+            ++itor;
+        }
+
+        collectStageTimes( instance, frameNumber );
+    }
+#endif
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    BenchmarkSceneManager::BenchmarkSceneManager( const String &name, size_t numWorkerThreads ) :
+        SceneManager( name, numWorkerThreads )
+#if OGRE_PROFILING == OGRE_PROFILING_INTERNAL
+        ,
+        mProfileListener( this )
+#endif
+    {
+        resetStageTimes();
+#if OGRE_PROFILING == OGRE_PROFILING_INTERNAL
+        Profiler::getSingleton().addListener( &mProfileListener );
+#endif
+    }
+    //-----------------------------------------------------------------------------------
+    BenchmarkSceneManager::~BenchmarkSceneManager()
+    {
+#if OGRE_PROFILING == OGRE_PROFILING_INTERNAL
+        Profiler::getSingleton().removeListener( &mProfileListener );
+#endif
+    }
+    //-----------------------------------------------------------------------------------
+    const String &BenchmarkSceneManager::getTypeName() const
+    {
+        return BenchmarkSceneManagerFactory::FACTORY_TYPE_NAME;
+    }
+    //-----------------------------------------------------------------------------------
+    void BenchmarkSceneManager::_cullPhase01( Camera *cullCamera, Camera *renderCamera,
+                                              const Camera *lodCamera, uint8 firstRq, uint8 lastRq,
+                                              bool reuseCullData )
+    {
+        const uint64 startTime = mTimer.getMicroseconds();
+        SceneManager::_cullPhase01( cullCamera, renderCamera, lodCamera, firstRq, lastRq,
+                                    reuseCullData );
+        mStageTimes[BenchmarkStage::CullFrustum] += mTimer.getMicroseconds() - startTime;
+    }
+    //-----------------------------------------------------------------------------------
+    void BenchmarkSceneManager::_renderPhase02( Camera *camera, const Camera *lodCamera, uint8 firstRq,
+                                                uint8 lastRq, bool includeOverlays )
+    {
+        const uint64 startTime = mTimer.getMicroseconds();
+        SceneManager::_renderPhase02( camera, lodCamera, firstRq, lastRq, includeOverlays );
+        mStageTimes[BenchmarkStage::Render] += mTimer.getMicroseconds() - startTime;
+    }
+    //-----------------------------------------------------------------------------------
+    void BenchmarkSceneManager::resetStageTimes()
+    {
+        for( size_t i = 0; i < BenchmarkStage::NumBenchmarkStages; ++i )
+            mStageTimes[i] = 0;
+    }
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    const String BenchmarkSceneManagerFactory::FACTORY_TYPE_NAME = "BenchmarkSceneManager";
+    //-----------------------------------------------------------------------------------
+    void BenchmarkSceneManagerFactory::initMetaData() const
+    {
+        mMetaData.typeName = FACTORY_TYPE_NAME;
+        mMetaData.description = "Scene manager that times each stage of the frame";
+        mMetaData.sceneTypeMask = 0;
+        mMetaData.worldGeometrySupported = false;
+    }
+    //-----------------------------------------------------------------------------------
+    SceneManager *BenchmarkSceneManagerFactory::createInstance( const String &instanceName,
+                                                                size_t        numWorkerThreads )
+    {
+        return OGRE_NEW BenchmarkSceneManager( instanceName, numWorkerThreads );
+    }
+    //-----------------------------------------------------------------------------------
+    void BenchmarkSceneManagerFactory::destroyInstance( SceneManager *instance )
+    {
+        OGRE_DELETE instance;
+    }
+}  // namespace Benchmark
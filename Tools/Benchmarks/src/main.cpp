@@ -0,0 +1,690 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "BenchmarkLightBinning.h"
+#include "BenchmarkRenderQueueSort.h"
+#include "BenchmarkScene.h"
+#include "BenchmarkSceneManager.h"
+
+#include "Compositor/OgreCompositorManager2.h"
+#include "OgreArchiveManager.h"
+#include "OgreConfigFile.h"
+#include "OgreForwardClustered.h"
+#include "OgreHlmsManager.h"
+#include "OgreHlmsPbs.h"
+#include "OgreHlmsUnlit.h"
+#include "OgreLogManager.h"
+#include "OgreProfiler.h"
+#include "OgreRenderQueue.h"
+#include "OgreRoot.h"
+#include "OgreWindow.h"
+
+#ifdef OGRE_STATIC_LIB
+#    include "OgreNULLRenderSystem.h"
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <locale>
+
+using namespace Ogre;
+using namespace Benchmark;
+
+namespace
+{
+    /// RQ used by Items by default
+    const uint8 c_itemsRenderQueue = 10u;
+
+    /// Engine settings compared by the benchmark. Each variant renders the same scene
+    struct BenchmarkVariant
+    {
+        const char             *name;
+        RenderQueue::RqSortMode sortMode;
+        bool                    sortTemporalCoherence;
+        bool                    cullingHierarchy;
+        bool                    lightCellRangeBinning;
+        bool                    compactGrid;
+        bool                    staticInstanceCache;
+    };
+
+    const BenchmarkVariant c_variants[] = {
+        { "baseline", RenderQueue::NormalSort, false, false, false, false, false },
+        { "sort_stable", RenderQueue::StableSort, false, false, false, false, false },
+        { "sort_radix", RenderQueue::ParallelRadixSort, false, false, false, false, false },
+        { "sort_radix_temporal", RenderQueue::ParallelRadixSort, true, false, false, false, false },
+        { "culling_hierarchy", RenderQueue::NormalSort, false, true, false, false, false },
+        { "forward_clustered_binning", RenderQueue::NormalSort, false, false, true, false, false },
+        { "forward_clustered_compact_grid", RenderQueue::NormalSort, false, false, false, true, false },
+        { "hlms_static_instance_cache", RenderQueue::NormalSort, false, false, false, false, true },
+    };
+
+    const size_t c_numVariants = sizeof( c_variants ) / sizeof( c_variants[0] );
+
+    struct BenchmarkOptions
+    {
+        BenchmarkSceneParams sceneParams;
+        uint32               numFrames;
+        uint32               numWarmupFrames;
+        uint32               numWorkerThreads;
+        String               resourcesCfg;
+        String               outputFilename;
+        StringVector         variantNames;
+        /// When not 0, only RenderQueue sorting is measured, with this many Renderables
+        uint32               numRqSortRenderables;
+        /// When not 0, only Forward Clustered light binning is measured, with this many lights
+        uint32               numBinningLights;
+
+        BenchmarkOptions() :
+            numFrames( 300u ),
+            numWarmupFrames( 30u ),
+            numWorkerThreads( 1u ),
+            resourcesCfg( "resources2.cfg" ),
+            numRqSortRenderables( 0u ),
+            numBinningLights( 0u )
+        {
+        }
+    };
+
+    /// Per frame CPU time in microseconds of each stage, plus the whole frame
+    struct VariantResults
+    {
+        const BenchmarkVariant *variant;
+        vector<uint64>::type    samples[BenchmarkStage::NumBenchmarkStages + 1u];
+    };
+
+    typedef vector<VariantResults>::type VariantResultsVec;
+}  // namespace
+
+static void help()
+{
+    // clang-format off
+    std::cout << "Headless benchmark running on the NULL RenderSystem." << std::endl;
+    std::cout << "Measures the CPU time of each stage of the frame and outputs JSON." << std::endl;
+    std::cout << "The updateSceneGraph stages (updateAllTransforms, etc) are only reported" << std::endl;
+    std::cout << "when built with OGRE_PROFILING_PROVIDER=internal." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Usage: OgreBenchmarks [options]" << std::endl;
+    std::cout << "-items N          = Dynamic Items (default: 10000)" << std::endl;
+    std::cout << "-depth N          = Depth of the dynamic Items' node chains (default: 8)" << std::endl;
+    std::cout << "-static N         = Static Items (default: 10000)" << std::endl;
+    std::cout << "-lights N         = Forward+ point lights (default: 256)" << std::endl;
+    std::cout << "-skeletal N       = Skeletally animated Items (default: 100)" << std::endl;
+    std::cout << "-frames N         = Frames measured per variant (default: 300)" << std::endl;
+    std::cout << "-warmup N         = Frames rendered before measuring (default: 30)" << std::endl;
+    std::cout << "-threads N        = SceneManager worker threads (default: 1)" << std::endl;
+    std::cout << "-variant name     = Only run this variant. Can be repeated" << std::endl;
+    std::cout << "-resources file   = resources2.cfg to load the media from" << std::endl;
+    std::cout << "-o file           = Write the JSON report to file instead of stdout" << std::endl;
+    std::cout << "-rqsort N         = Only compare the RenderQueue sort modes, sorting N" << std::endl;
+    std::cout << "                    Renderables added by -threads threads. No scene" << std::endl;
+    std::cout << "-binning N        = Only compare Forward Clustered light binning with and" << std::endl;
+    std::cout << "                    without cell ranges, with N lights. No Items" << std::endl;
+    std::cout << "-list             = List the variants and exit" << std::endl << std::endl;
+    // clang-format on
+}
+//-----------------------------------------------------------------------------------
+static bool parseArgs( int numargs, char **args, BenchmarkOptions &outOptions, bool &outListOnly )
+{
+    outListOnly = false;
+
+    for( int i = 1; i < numargs; ++i )
+    {
+        const String arg( args[i] );
+
+        if( arg == "-list" )
+        {
+            outListOnly = true;
+            continue;
+        }
+
+        if( i + 1 >= numargs )
+        {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+
+        const String value( args[++i] );
+
+        if( arg == "-items" )
+            outOptions.sceneParams.numItems = StringConverter::parseUnsignedInt( value );
+        else if( arg == "-depth" )
+            outOptions.sceneParams.hierarchyDepth = StringConverter::parseUnsignedInt( value );
+        else if( arg == "-static" )
+            outOptions.sceneParams.numStaticItems = StringConverter::parseUnsignedInt( value );
+        else if( arg == "-lights" )
+            outOptions.sceneParams.numLights = StringConverter::parseUnsignedInt( value );
+        else if( arg == "-skeletal" )
+            outOptions.sceneParams.numSkeletalItems = StringConverter::parseUnsignedInt( value );
+        else if( arg == "-frames" )
+            outOptions.numFrames = std::max( StringConverter::parseUnsignedInt( value ), 1u );
+        else if( arg == "-warmup" )
+            outOptions.numWarmupFrames = StringConverter::parseUnsignedInt( value );
+        else if( arg == "-threads" )
+            outOptions.numWorkerThreads = std::max( StringConverter::parseUnsignedInt( value ), 1u );
+        else if( arg == "-variant" )
+            outOptions.variantNames.push_back( value );
+        else if( arg == "-resources" )
+            outOptions.resourcesCfg = value;
+        else if( arg == "-o" )
+            outOptions.outputFilename = value;
+        else if( arg == "-rqsort" )
+            outOptions.numRqSortRenderables = StringConverter::parseUnsignedInt( value );
+        else if( arg == "-binning" )
+            outOptions.numBinningLights = StringConverter::parseUnsignedInt( value );
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+//-----------------------------------------------------------------------------------
+static void setupResources( ConfigFile &cf )
+{
+    ConfigFile::SectionIterator seci = cf.getSectionIterator();
+
+    String secName, typeName, archName;
+    while( seci.hasMoreElements() )
+    {
+        secName = seci.peekNextKey();
+        ConfigFile::SettingsMultiMap *settings = seci.getNext();
+
+        if( secName != "Hlms" )
+        {
+            ConfigFile::SettingsMultiMap::iterator i;
+            for( i = settings->begin(); i != settings->end(); ++i )
+            {
+                typeName = i->first;
+                archName = i->second;
+                ResourceGroupManager::getSingleton().addResourceLocation( archName, typeName,
+                                                                          secName );
+            }
+        }
+    }
+}
+//-----------------------------------------------------------------------------------
+static ArchiveVec loadLibraryArchives( const String &rootHlmsFolder, const StringVector &paths )
+{
+    ArchiveVec archives;
+    StringVector::const_iterator itor = paths.begin();
+    StringVector::const_iterator endt = paths.end();
+    while( itor != endt )
+    {
+        archives.push_back(
+            ArchiveManager::getSingleton().load( rootHlmsFolder + *itor, "FileSystem", true ) );
+        ++itor;
+    }
+    return archives;
+}
+//-----------------------------------------------------------------------------------
+static HlmsPbs *registerHlms( ConfigFile &cf )
+{
+    String rootHlmsFolder = cf.getSetting( "DoNotUseAsResource", "Hlms", "" );
+
+    if( rootHlmsFolder.empty() )
+        rootHlmsFolder = "./";
+    else if( *( rootHlmsFolder.end() - 1 ) != '/' )
+        rootHlmsFolder += "/";
+
+    ArchiveManager &archiveManager = ArchiveManager::getSingleton();
+    HlmsManager *hlmsManager = Root::getSingleton().getHlmsManager();
+
+    String mainFolderPath;
+    StringVector libraryFoldersPaths;
+
+    HlmsUnlit::getDefaultPaths( mainFolderPath, libraryFoldersPaths );
+    {
+        Archive *archiveUnlit =
+            archiveManager.load( rootHlmsFolder + mainFolderPath, "FileSystem", true );
+        ArchiveVec archiveUnlitLibraryFolders =
+            loadLibraryArchives( rootHlmsFolder, libraryFoldersPaths );
+        hlmsManager->registerHlms( OGRE_NEW HlmsUnlit( archiveUnlit, &archiveUnlitLibraryFolders ) );
+    }
+
+    HlmsPbs *hlmsPbs = 0;
+    HlmsPbs::getDefaultPaths( mainFolderPath, libraryFoldersPaths );
+    {
+        Archive *archivePbs =
+            archiveManager.load( rootHlmsFolder + mainFolderPath, "FileSystem", true );
+        ArchiveVec archivePbsLibraryFolders =
+            loadLibraryArchives( rootHlmsFolder, libraryFoldersPaths );
+        hlmsPbs = OGRE_NEW HlmsPbs( archivePbs, &archivePbsLibraryFolders );
+        hlmsManager->registerHlms( hlmsPbs );
+    }
+
+    return hlmsPbs;
+}
+//-----------------------------------------------------------------------------------
+static void runVariant( Root *root, Window *window, HlmsPbs *hlmsPbs, HlmsDatablock *datablock,
+                        const BenchmarkOptions &options, VariantResults &outResults )
+{
+    const BenchmarkVariant &variant = *outResults.variant;
+
+    LogManager::getSingleton().logMessage( "Running benchmark variant " + String( variant.name ) );
+
+    BenchmarkSceneManager *sceneManager = static_cast<BenchmarkSceneManager *>(
+        root->createSceneManager( BenchmarkSceneManagerFactory::FACTORY_TYPE_NAME,
+                                  options.numWorkerThreads, "Benchmark" ) );
+
+    sceneManager->setForwardClustered( true, 16, 8, 24, 96, 0, 0, 2, 50 );
+    ForwardPlusBase *forwardPlus = sceneManager->getForwardPlus();
+    forwardPlus->setCompactGrid( variant.compactGrid );
+    if( forwardPlus->getForwardPlusMethod() == ForwardPlusBase::MethodForwardClustered )
+    {
+        static_cast<ForwardClustered *>( forwardPlus )
+            ->setLightCellRangeBinning( variant.lightCellRangeBinning );
+    }
+
+    sceneManager->setCullingHierarchyEnabled( variant.cullingHierarchy );
+
+    RenderQueue *renderQueue = sceneManager->getRenderQueue();
+    renderQueue->setSortRenderQueue( c_itemsRenderQueue, variant.sortMode );
+    renderQueue->setSortTemporalCoherence( c_itemsRenderQueue, variant.sortTemporalCoherence );
+
+    hlmsPbs->setStaticInstanceCache( variant.staticInstanceCache );
+
+    BenchmarkScene scene( sceneManager, options.sceneParams, datablock );
+
+    CompositorManager2 *compositorManager = root->getCompositorManager2();
+    CompositorWorkspace *workspace = compositorManager->addWorkspace(
+        sceneManager, window->getTexture(), scene.getCamera(), "BenchmarkWorkspace", true );
+
+    const float timeSinceLast = 1.0f / 60.0f;
+
+    // Warm up: compiles the shaders, grows the buffers, fills the caches
+    for( uint32 i = 0u; i < options.numWarmupFrames; ++i )
+    {
+        scene.update( timeSinceLast );
+        root->renderOneFrame();
+    }
+
+    for( size_t i = 0u; i < BenchmarkStage::NumBenchmarkStages + 1u; ++i )
+        outResults.samples[i].reserve( options.numFrames );
+
+    Timer timer;
+
+    for( uint32 i = 0u; i < options.numFrames; ++i )
+    {
+        sceneManager->resetStageTimes();
+
+        const uint64 startTime = timer.getMicroseconds();
+        scene.update( timeSinceLast );
+        root->renderOneFrame();
+        const uint64 frameTime = timer.getMicroseconds() - startTime;
+
+        for( size_t j = 0u; j < BenchmarkStage::NumBenchmarkStages; ++j )
+        {
+            outResults.samples[j].push_back(
+                sceneManager->getStageTime( static_cast<BenchmarkStage::BenchmarkStage>( j ) ) );
+        }
+        outResults.samples[BenchmarkStage::NumBenchmarkStages].push_back( frameTime );
+    }
+
+    compositorManager->removeWorkspace( workspace );
+    hlmsPbs->setStaticInstanceCache( false );
+    root->destroySceneManager( sceneManager );
+}
+//-----------------------------------------------------------------------------------
+static void writeStageStats( std::ostream &os, const char *stageName, vector<uint64>::type samples,
+                             bool lastStage )
+{
+    std::sort( samples.begin(), samples.end() );
+
+    uint64 total = 0u;
+    vector<uint64>::type::const_iterator itor = samples.begin();
+    vector<uint64>::type::const_iterator endt = samples.end();
+    while( itor != endt )
+        total += *itor++;
+
+    const size_t numSamples = samples.size();
+    const double mean = static_cast<double>( total ) / static_cast<double>( numSamples );
+    const size_t p95Idx = std::min( ( numSamples * 95u ) / 100u, numSamples - 1u );
+
+    os << "        \"" << stageName << "\": { ";
+    os << "\"mean_us\": " << mean << ", ";
+    os << "\"median_us\": " << samples[numSamples / 2u] << ", ";
+    os << "\"p95_us\": " << samples[p95Idx] << ", ";
+    os << "\"min_us\": " << samples.front() << ", ";
+    os << "\"max_us\": " << samples.back() << " }";
+    os << ( lastStage ? "\n" : ",\n" );
+}
+//-----------------------------------------------------------------------------------
+static void writeReport( std::ostream &os, const BenchmarkOptions &options,
+                         const VariantResultsVec &results )
+{
+    const BenchmarkSceneParams &sceneParams = options.sceneParams;
+
+    os.imbue( std::locale::classic() );
+    os << std::fixed << std::setprecision( 2 );
+
+    os << "{\n";
+    os << "  \"ogre_version\": \"" << OGRE_VERSION_MAJOR << "." << OGRE_VERSION_MINOR << "."
+       << OGRE_VERSION_PATCH << OGRE_VERSION_SUFFIX << "\",\n";
+    os << "  \"debug_mode\": " << OGRE_DEBUG_MODE << ",\n";
+    os << "  \"double_precision\": " << ( OGRE_DOUBLE_PRECISION ? "true" : "false" ) << ",\n";
+    os << "  \"worker_threads\": " << options.numWorkerThreads << ",\n";
+    os << "  \"frames\": " << options.numFrames << ",\n";
+    os << "  \"warmup_frames\": " << options.numWarmupFrames << ",\n";
+    os << "  \"scene\": { ";
+    os << "\"items\": " << sceneParams.numItems << ", ";
+    os << "\"hierarchy_depth\": " << sceneParams.hierarchyDepth << ", ";
+    os << "\"static_items\": " << sceneParams.numStaticItems << ", ";
+    os << "\"lights\": " << sceneParams.numLights << ", ";
+    os << "\"skeletal_items\": " << sceneParams.numSkeletalItems << " },\n";
+    os << "  \"variants\": [\n";
+
+    VariantResultsVec::const_iterator itor = results.begin();
+    VariantResultsVec::const_iterator endt = results.end();
+
+    while( itor != endt )
+    {
+        const BenchmarkVariant &variant = *itor->variant;
+
+        os << "    {\n";
+        os << "      \"name\": \"" << variant.name << "\",\n";
+        os << "      \"stages\": {\n";
+        for( size_t i = 0u; i < BenchmarkStage::NumBenchmarkStages; ++i )
+        {
+            const BenchmarkStage::BenchmarkStage stage = static_cast<BenchmarkStage::BenchmarkStage>( i );
+            if( BenchmarkStage::isStageMeasured( stage ) )
+                writeStageStats( os, BenchmarkStage::getName( stage ), itor->samples[i], false );
+        }
+        writeStageStats( os, "frame", itor->samples[BenchmarkStage::NumBenchmarkStages], true );
+        os << "      }\n";
+
+        ++itor;
+        os << ( itor != endt ? "    },\n" : "    }\n" );
+    }
+
+    os << "  ]\n";
+    os << "}\n";
+}
+//-----------------------------------------------------------------------------------
+static void writeRqSortReport( std::ostream &os, const RqSortBenchmarkParams &params,
+                               const vector<uint64>::type samples[RqSortMethod::NumRqSortMethods] )
+{
+    os.imbue( std::locale::classic() );
+    os << std::fixed << std::setprecision( 2 );
+
+    os << "{\n";
+    os << "  \"ogre_version\": \"" << OGRE_VERSION_MAJOR << "." << OGRE_VERSION_MINOR << "."
+       << OGRE_VERSION_PATCH << OGRE_VERSION_SUFFIX << "\",\n";
+    os << "  \"debug_mode\": " << OGRE_DEBUG_MODE << ",\n";
+    os << "  \"worker_threads\": " << params.numThreads << ",\n";
+    os << "  \"iterations\": " << params.numIterations << ",\n";
+    os << "  \"renderables\": " << params.numRenderables << ",\n";
+    os << "  \"rq_sort\": {\n";
+    for( size_t i = 0u; i < RqSortMethod::NumRqSortMethods; ++i )
+    {
+        writeStageStats( os, RqSortMethod::getName( static_cast<RqSortMethod::RqSortMethod>( i ) ),
+                         samples[i], i + 1u == RqSortMethod::NumRqSortMethods );
+    }
+    os << "  }\n";
+    os << "}\n";
+}
+//-----------------------------------------------------------------------------------
+static int runRqSortBenchmark( const BenchmarkOptions &options )
+{
+    RqSortBenchmarkParams params;
+    params.numRenderables = options.numRqSortRenderables;
+    params.numThreads = options.numWorkerThreads;
+    params.numIterations = options.numFrames;
+
+    vector<uint64>::type samples[RqSortMethod::NumRqSortMethods];
+
+    try
+    {
+        runRenderQueueSortBenchmark( params, samples );
+
+        if( options.outputFilename.empty() )
+        {
+            writeRqSortReport( std::cout, params, samples );
+        }
+        else
+        {
+            std::ofstream outFile( options.outputFilename.c_str(), std::ios::out | std::ios::trunc );
+            if( !outFile.is_open() )
+            {
+                OGRE_EXCEPT( Exception::ERR_CANNOT_WRITE_TO_FILE,
+                             "Could not open '" + options.outputFilename + "' for writing",
+                             "runRqSortBenchmark" );
+            }
+            writeRqSortReport( outFile, params, samples );
+        }
+    }
+    catch( Exception &e )
+    {
+        std::cerr << "Exception caught: " << e.getFullDescription() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+//-----------------------------------------------------------------------------------
+static void runSceneVariants( Root *root, Window *window, const BenchmarkOptions &options,
+                              VariantResultsVec &results )
+{
+    ConfigFile cf;
+    cf.load( options.resourcesCfg );
+    setupResources( cf );
+    HlmsPbs *hlmsPbs = registerHlms( cf );
+    ResourceGroupManager::getSingleton().initialiseAllResourceGroups( true );
+
+    BenchmarkScene::importMeshes();
+
+    HlmsDatablock *datablock =
+        hlmsPbs->createDatablock( "Benchmark/Pbs", "Benchmark/Pbs", HlmsMacroblock(),
+                                  HlmsBlendblock(), HlmsParamVec() );
+
+    root->getCompositorManager2()->createBasicWorkspaceDef(
+        "BenchmarkWorkspace", ColourValue( 0.2f, 0.4f, 0.6f ) );
+
+    VariantResultsVec::iterator itor = results.begin();
+    VariantResultsVec::iterator endt = results.end();
+    while( itor != endt )
+    {
+        runVariant( root, window, hlmsPbs, datablock, options, *itor );
+        ++itor;
+    }
+
+    if( options.outputFilename.empty() )
+    {
+        writeReport( std::cout, options, results );
+    }
+    else
+    {
+        std::ofstream outFile( options.outputFilename.c_str(), std::ios::out | std::ios::trunc );
+        if( !outFile.is_open() )
+        {
+            OGRE_EXCEPT( Exception::ERR_CANNOT_WRITE_TO_FILE,
+                         "Could not open '" + options.outputFilename + "' for writing",
+                         "runSceneVariants" );
+        }
+        writeReport( outFile, options, results );
+    }
+}
+//-----------------------------------------------------------------------------------
+static void writeLightBinningReport(
+    std::ostream &os, const LightBinningBenchmarkParams &params,
+    const vector<uint64>::type samples[LightBinningMethod::NumLightBinningMethods] )
+{
+    os.imbue( std::locale::classic() );
+    os << std::fixed << std::setprecision( 2 );
+
+    os << "{\n";
+    os << "  \"ogre_version\": \"" << OGRE_VERSION_MAJOR << "." << OGRE_VERSION_MINOR << "."
+       << OGRE_VERSION_PATCH << OGRE_VERSION_SUFFIX << "\",\n";
+    os << "  \"debug_mode\": " << OGRE_DEBUG_MODE << ",\n";
+    os << "  \"worker_threads\": " << params.numThreads << ",\n";
+    os << "  \"iterations\": " << params.numIterations << ",\n";
+    os << "  \"lights\": " << params.numLights << ",\n";
+    os << "  \"light_binning\": {\n";
+    for( size_t i = 0u; i < LightBinningMethod::NumLightBinningMethods; ++i )
+    {
+        writeStageStats(
+            os, LightBinningMethod::getName( static_cast<LightBinningMethod::LightBinningMethod>( i ) ),
+            samples[i], i + 1u == LightBinningMethod::NumLightBinningMethods );
+    }
+    os << "  }\n";
+    os << "}\n";
+}
+//-----------------------------------------------------------------------------------
+static void runLightBinning( Root *root, const BenchmarkOptions &options )
+{
+    LightBinningBenchmarkParams params;
+    params.numLights = options.numBinningLights;
+    params.numThreads = options.numWorkerThreads;
+    params.numIterations = options.numFrames;
+
+    vector<uint64>::type samples[LightBinningMethod::NumLightBinningMethods];
+    runLightBinningBenchmark( root, params, samples );
+
+    if( options.outputFilename.empty() )
+    {
+        writeLightBinningReport( std::cout, params, samples );
+    }
+    else
+    {
+        std::ofstream outFile( options.outputFilename.c_str(), std::ios::out | std::ios::trunc );
+        if( !outFile.is_open() )
+        {
+            OGRE_EXCEPT( Exception::ERR_CANNOT_WRITE_TO_FILE,
+                         "Could not open '" + options.outputFilename + "' for writing",
+                         "runLightBinning" );
+        }
+        writeLightBinningReport( outFile, params, samples );
+    }
+}
+//-----------------------------------------------------------------------------------
+int main( int numargs, char **args )
+{
+    BenchmarkOptions options;
+    bool listOnly;
+
+    if( !parseArgs( numargs, args, options, listOnly ) )
+    {
+        help();
+        return -1;
+    }
+
+    if( options.numRqSortRenderables )
+        return runRqSortBenchmark( options );
+
+    if( listOnly )
+    {
+        for( size_t i = 0u; i < c_numVariants; ++i )
+            std::cout << c_variants[i].name << std::endl;
+        return 0;
+    }
+
+    VariantResultsVec results;
+    for( size_t i = 0u; i < c_numVariants; ++i )
+    {
+        if( options.variantNames.empty() ||
+            std::find( options.variantNames.begin(), options.variantNames.end(),
+                       c_variants[i].name ) != options.variantNames.end() )
+        {
+            VariantResults variantResults;
+            variantResults.variant = &c_variants[i];
+            results.push_back( variantResults );
+        }
+    }
+
+    if( results.empty() && !options.numBinningLights )
+    {
+        std::cerr << "No variant matches. Use -list to see the available ones." << std::endl;
+        return -1;
+    }
+
+    // Most Ogre scripts assume floating point to use radix point, not comma
+    setlocale( LC_NUMERIC, "C" );
+
+    Root *root = 0;
+    LogManager *logManager = 0;
+    BenchmarkSceneManagerFactory sceneManagerFactory;
+
+    int retCode = 0;
+    try
+    {
+        String pluginsPath;
+        // only use plugins.cfg if not static
+#ifndef OGRE_STATIC_LIB
+#    if OGRE_DEBUG_MODE
+        pluginsPath = "plugins_tools_d.cfg";
+#    else
+        pluginsPath = "plugins_tools.cfg";
+#    endif
+#endif
+        // Keep the log out of stdout, which may be receiving the report
+        logManager = OGRE_NEW LogManager();
+        logManager->createLog( "OgreBenchmarks.log", true, false );
+
+        root = OGRE_NEW Root( nullptr, pluginsPath, "", "OgreBenchmarks.log" );
+
+#ifdef OGRE_STATIC_LIB
+        root->addRenderSystem( new NULLRenderSystem() );
+#endif
+
+        root->setRenderSystem( root->getRenderSystemByName( "NULL Rendering Subsystem" ) );
+        root->initialise( false );
+        root->addSceneManagerFactory( &sceneManagerFactory );
+
+#if OGRE_PROFILING == OGRE_PROFILING_INTERNAL
+        // BenchmarkSceneManager reads the updateSceneGraph stages from the profiler every frame
+        Profiler::getSingleton().setEnabled( true );
+        Profiler::getSingleton().setUpdateDisplayFrequency( 1u );
+#else
+        LogManager::getSingleton().logMessage(
+            "OGRE_PROFILING_PROVIDER is not 'internal'. The updateSceneGraph stages won't be "
+            "reported, only cullFrustum, render and the whole frame." );
+#endif
+
+        Window *window = root->createRenderWindow( "OgreBenchmarks", 1920u, 1080u, false );
+
+        if( options.numBinningLights )
+            runLightBinning( root, options );
+        else
+            runSceneVariants( root, window, options, results );
+    }
+    catch( Exception &e )
+    {
+        std::cerr << "Exception caught: " << e.getFullDescription() << std::endl;
+        retCode = 1;
+    }
+
+    if( root )
+        root->removeSceneManagerFactory( &sceneManagerFactory );
+    OGRE_DELETE root;
+    OGRE_DELETE logManager;
+
+    return retCode;
+}